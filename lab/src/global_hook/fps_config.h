@@ -1,73 +1,7 @@
 #pragma once
-#include <Windows.h>
-
-// Shared config structure between monitor and hook DLL
-#pragma pack(push, 1)
-struct FpsConfig {
-    // Display
-    int position;           // 0=TopLeft, 1=TopRight, 2=BottomLeft, 3=BottomRight, 4=Custom
-    int offsetX;
-    int offsetY;
-    int fontSize;           // 12, 14, 18
-    bool showBackground;
-    
-    // Custom position (absolute coordinates, used when position=4)
-    int customX;
-    int customY;
-    bool positionDirty;     // Set by hook when position changed, cleared by monitor after save
-    
-    // Colors (RGB)
-    DWORD colorHigh;        // >= 60 FPS
-    DWORD colorMedium;      // 30-59 FPS
-    DWORD colorLow;         // < 30 FPS
-    DWORD colorBackground;  // ARGB
-    
-    // Hotkey
-    int toggleKey;          // VK code
-    bool useCtrl;
-    bool useAlt;
-    bool useShift;
-    
-    // Filter
-    int filterMode;         // 0=All, 1=Whitelist, 2=Blacklist
-    char gameList[4096];    // Semicolon-separated list
-    
-    // State
-    bool visible;
-    bool enabled;
-};
-#pragma pack(pop)
-
-#define CONFIG_SHARED_NAME L"FpsOverlayConfig"
-#define CONFIG_FILE_NAME L"fps_config.ini"
-
-// Default config
-inline void InitDefaultConfig(FpsConfig* cfg) {
-    cfg->position = 0;          // TopLeft (changed from TopRight)
-    cfg->offsetX = 10;
-    cfg->offsetY = 10;
-    cfg->fontSize = 14;
-    cfg->showBackground = true;
-    cfg->customX = 10;
-    cfg->customY = 10;
-    cfg->positionDirty = false;
-    
-    cfg->colorHigh = 0xFF00E070;     // Green
-    cfg->colorMedium = 0xFFFFCC00;   // Yellow
-    cfg->colorLow = 0xFFFF4040;      // Red
-    cfg->colorBackground = 0xB0202020;
-    
-    cfg->toggleKey = VK_F1;
-    cfg->useCtrl = false;
-    cfg->useAlt = false;
-    cfg->useShift = false;
-    
-    cfg->filterMode = 0;        // All games
-    cfg->gameList[0] = '\0';
-    
-    cfg->visible = true;
-    cfg->enabled = true;
-}
+#include <cstddef>
+#include <type_traits>
+#include "config_schema.h"
 
 // Position enum
 enum FpsPosition {
@@ -84,3 +18,97 @@ enum FilterMode {
     FILTER_WHITELIST = 1,
     FILTER_BLACKLIST = 2
 };
+
+inline constexpr ConfigSchema::EnumName kFpsPositionNames[] = {
+    { "TopLeft", POS_TOP_LEFT },
+    { "TopRight", POS_TOP_RIGHT },
+    { "BottomLeft", POS_BOTTOM_LEFT },
+    { "BottomRight", POS_BOTTOM_RIGHT },
+    { "Custom", POS_CUSTOM },
+    { nullptr, 0 },
+};
+
+inline constexpr ConfigSchema::EnumName kFilterModeNames[] = {
+    { "All", FILTER_ALL },
+    { "Whitelist", FILTER_WHITELIST },
+    { "Blacklist", FILTER_BLACKLIST },
+    { nullptr, 0 },
+};
+
+// One list for FpsConfig and fps_config.ini, split by access pattern: the hot
+// fields are read by every hooked game on every frame and fit in one cache
+// line; the cold ones start on the next line. Members with a nullptr key are
+// runtime state, not stored in the file. The shared block layout is in
+// shared_config.h.
+//
+// X(kind, member, section, key, def, min, max, clamp, names, comment)
+#define FPS_CONFIG_HOT_FIELDS(X) \
+    X(Enum,   position,        "Display", "Position",       POS_TOP_LEFT, 0.0, 0.0,   ConfigSchema::kReject, kFpsPositionNames, "TopLeft, TopRight, BottomLeft, BottomRight, Custom") \
+    X(Int,    offsetX,         "Display", "OffsetX",        10,    0.0, 0.0,          ConfigSchema::kClamp,  nullptr, nullptr) \
+    X(Int,    offsetY,         "Display", "OffsetY",        10,    0.0, 0.0,          ConfigSchema::kClamp,  nullptr, nullptr) \
+    X(Int,    fontSize,        "Display", "FontSize",       14,    8.0, 72.0,         ConfigSchema::kClamp,  nullptr, "12, 14, 18") \
+    /* Custom position (absolute coordinates, used when position=4) */ \
+    X(Int,    customX,         nullptr,   nullptr,          10,    0.0, 0.0,          ConfigSchema::kClamp,  nullptr, nullptr) \
+    X(Int,    customY,         nullptr,   nullptr,          10,    0.0, 0.0,          ConfigSchema::kClamp,  nullptr, nullptr) \
+    X(Color,  colorHigh,       "Colors",  "HighFPS",        0xFF00E070u, 0.0, 0.0,    ConfigSchema::kClamp,  nullptr, "AARRGGBB: >= 60 FPS, 30-59 FPS, < 30 FPS, background") \
+    X(Color,  colorMedium,     "Colors",  "MediumFPS",      0xFFFFCC00u, 0.0, 0.0,    ConfigSchema::kClamp,  nullptr, nullptr) \
+    X(Color,  colorLow,        "Colors",  "LowFPS",         0xFFFF4040u, 0.0, 0.0,    ConfigSchema::kClamp,  nullptr, nullptr) \
+    X(Color,  colorBackground, "Colors",  "Background",     0xB0202020u, 0.0, 0.0,    ConfigSchema::kClamp,  nullptr, nullptr) \
+    X(Key,    toggleKey,       "Hotkey",  "Toggle",         ConfigSchema::kVkF1, 1.0, 254.0, ConfigSchema::kReject, nullptr, "F1-F12 (or a VK code number)") \
+    X(Enum,   filterMode,      "Filter",  "Mode",           FILTER_ALL, 0.0, 0.0,     ConfigSchema::kReject, kFilterModeNames, "All, Whitelist, Blacklist") \
+    X(Bool,   showBackground,  "Display", "ShowBackground", true,  0.0, 0.0,          ConfigSchema::kClamp,  nullptr, nullptr) \
+    /* Frame-time graph under the FPS box */ \
+    X(Bool,   showGraph,       "Display", "ShowGraph",      false, 0.0, 0.0,          ConfigSchema::kClamp,  nullptr, nullptr) \
+    /* Set by hook when position changed, cleared by monitor after save */ \
+    X(Bool,   positionDirty,   nullptr,   nullptr,          false, 0.0, 0.0,          ConfigSchema::kClamp,  nullptr, nullptr) \
+    X(Bool,   useCtrl,         nullptr,   nullptr,          false, 0.0, 0.0,          ConfigSchema::kClamp,  nullptr, nullptr) \
+    X(Bool,   useAlt,          nullptr,   nullptr,          false, 0.0, 0.0,          ConfigSchema::kClamp,  nullptr, nullptr) \
+    X(Bool,   useShift,        nullptr,   nullptr,          false, 0.0, 0.0,          ConfigSchema::kClamp,  nullptr, nullptr) \
+    X(Bool,   visible,         nullptr,   nullptr,          true,  0.0, 0.0,          ConfigSchema::kClamp,  nullptr, nullptr) \
+    X(Bool,   enabled,         nullptr,   nullptr,          true,  0.0, 0.0,          ConfigSchema::kClamp,  nullptr, nullptr)
+
+#define FPS_CONFIG_COLD_FIELDS(X) \
+    X(String, gameList,        "Filter",  "Games",          "",    0.0, 4096.0,       ConfigSchema::kClamp,  nullptr, "Semicolon-separated exe names or path fragments containing \\ (UTF-8)")
+
+// Naturally aligned (no packing): identical in the 32-bit and 64-bit hooks
+struct FpsConfig {
+    FPS_CONFIG_HOT_FIELDS(CONFIG_SCHEMA_MEMBER)
+    alignas(64) FPS_CONFIG_COLD_FIELDS(CONFIG_SCHEMA_MEMBER)
+};
+
+// The hot fields alone, laid out like the start of FpsConfig (a common
+// initial sequence): what the hook copies out of the shared block
+struct FpsConfigHot {
+    FPS_CONFIG_HOT_FIELDS(CONFIG_SCHEMA_MEMBER)
+};
+static_assert(std::is_trivially_copyable<FpsConfigHot>::value, "FpsConfigHot is copied as bytes");
+
+// Bytes the hook copies when the config changes
+constexpr size_t kFpsConfigHotSize = sizeof(FpsConfigHot);
+static_assert(kFpsConfigHotSize <= offsetof(FpsConfig, gameList), "hot fields must precede the cold ones");
+static_assert(kFpsConfigHotSize <= 64, "hot FpsConfig fields must fit in one cache line");
+
+#define FPS_CONFIG_HOT_ASSIGN(kind, member, section, key, def, min, max, clamp, names, comment) \
+    config.member = hot.member;
+inline void ApplyHotFields(const FpsConfigHot& hot, FpsConfig& config) {
+    FPS_CONFIG_HOT_FIELDS(FPS_CONFIG_HOT_ASSIGN)
+}
+#undef FPS_CONFIG_HOT_ASSIGN
+
+#define FPS_CONFIG_FIELD(kind, member, section, key, def, min, max, clamp, names, comment) \
+    CONFIG_SCHEMA_FIELD(FpsConfig, kind, member, section, key, def, min, max, clamp, names, comment)
+inline constexpr ConfigSchema::Field kFpsConfigFields[] = {
+    FPS_CONFIG_HOT_FIELDS(FPS_CONFIG_FIELD)
+    FPS_CONFIG_COLD_FIELDS(FPS_CONFIG_FIELD)
+};
+#undef FPS_CONFIG_FIELD
+
+inline constexpr ConfigSchema::Schema kFpsConfigSchema = ConfigSchema::MakeSchema(
+    kFpsConfigFields, "FPS Overlay - Global Hook Settings", true);
+
+#define CONFIG_FILE_NAME L"fps_config.ini"
+
+// Default config (the member initializers above)
+inline void InitDefaultConfig(FpsConfig* cfg) {
+    *cfg = FpsConfig();
+}
@@ -19,68 +19,21 @@
 
 #include "MinHook.h"
 #include "fps_config.h"
+#include "frame_graph.h"
+#include "logger.h"
+#include "process_filter.h"
+#include "verdict_cache.h"
+#include "shared_config.h"
+#include "telemetry.h"
+#include "vtable_hook.h"
+#include "entry_point_cache.h"
+#include "render_state_cache.h"
 
-// Heartbeat detection
-#define HEARTBEAT_SHARED_NAME L"FpsOverlayHeartbeat"
-static HANDLE g_hHeartbeatThread = NULL;
-static bool g_shouldExit = false;
+// Set once the monitor's lease is gone (see PollSharedConfig)
 static bool g_renderDisabled = false;
 
 // Forward declarations
 static void RemoveHook();
-static void Log(const char* fmt, ...);
-
-// Shared config
-static HANDLE g_hConfigMap = NULL;
-static FpsConfig* g_pConfig = NULL;
-
-static bool OpenSharedConfig() {
-    g_hConfigMap = OpenFileMappingW(FILE_MAP_READ, FALSE, CONFIG_SHARED_NAME);
-    if (!g_hConfigMap) return false;
-    
-    g_pConfig = (FpsConfig*)MapViewOfFile(g_hConfigMap, FILE_MAP_READ, 0, 0, sizeof(FpsConfig));
-    return g_pConfig != nullptr;
-}
-
-static void CloseSharedConfig() {
-    if (g_pConfig) { UnmapViewOfFile(g_pConfig); g_pConfig = nullptr; }
-    if (g_hConfigMap) { CloseHandle(g_hConfigMap); g_hConfigMap = nullptr; }
-}
-
-// Heartbeat thread - monitors if main process is still running
-static DWORD WINAPI HeartbeatThread(LPVOID) {
-    while (!g_shouldExit) {
-        Sleep(3000);
-        
-        HANDLE hEvent = OpenEventW(SYNCHRONIZE, FALSE, HEARTBEAT_SHARED_NAME);
-        if (!hEvent) {
-            // Main process exited - just disable rendering, don't unload hooks
-            Log("Heartbeat: Monitor exited, disabling render");
-            g_shouldExit = true;
-            g_renderDisabled = true;
-            CloseSharedConfig();
-            break;
-        }
-        CloseHandle(hEvent);
-    }
-    return 0;
-}
-
-// Debug log (definition)
-static void Log(const char* fmt, ...) {
-    char buf[512];
-    va_list args;
-    va_start(args, fmt);
-    vsprintf_s(buf, fmt, args);
-    va_end(args);
-    
-    FILE* f = nullptr;
-    fopen_s(&f, "C:\\fps_hook_log.txt", "a");
-    if (f) {
-        fprintf(f, "[%d] %s\n", GetCurrentProcessId(), buf);
-        fclose(f);
-    }
-}
 
 #pragma data_seg(".shared")
 HHOOK g_hHook = NULL;
@@ -99,6 +52,11 @@ static std::atomic<int> g_gpuFps{0};  // Renamed from g_displayFps
 static LARGE_INTEGER g_lastDisplayUpdate;
 static bool g_visible = true;
 
+// Frame-time graph (drawn under the FPS box when enabled in config)
+static FrameTimeGraph g_frameGraph;
+static LARGE_INTEGER g_lastFrameQpc = {0};
+static bool g_showGraph = false;
+
 // Display FPS calculation
 static std::atomic<int> g_dispFps{0};          // Actual display FPS
 static std::atomic<bool> g_dispFpsActual{false}; // true = measured, false = inferred
@@ -117,35 +75,115 @@ static int g_currentPosY = 10;
 static int g_fpsBoxWidth = 0;        // FPS display box dimensions
 static int g_fpsBoxHeight = 20;
 
+// Shared config: render threads poll the block and keep a private copy of
+// the hot fields, so nothing reads shared memory while it is being written.
+// Polled from the Present / EndScene thread only
+static SharedConfigReader g_sharedConfig;
+static FpsConfig g_config;
+
+static void ApplyConfigPosition() {
+    if (g_config.position == POS_CUSTOM) {
+        g_currentPosX = g_config.customX;
+        g_currentPosY = g_config.customY;
+    } else {
+        g_currentPosX = g_config.offsetX;
+        g_currentPosY = g_config.offsetY;
+    }
+}
+
+static void PollSharedConfig() {
+    // Monitor liveness: the frame time was just taken by UpdateGpuFps
+    if (g_lastFrameQpc.QuadPart != 0 &&
+        !g_sharedConfig.HoldsLease(g_lastFrameQpc.QuadPart,
+                                   g_frequency.QuadPart * SharedConfigBlock::kLeaseTimeoutMs / 1000)) {
+        // Monitor exited - just disable rendering, don't unload hooks.
+        // The config mapping stays until detach: a render thread may be polling it
+        LOG("Lease: Monitor exited, disabling render");
+        g_renderDisabled = true;
+        return;
+    }
+    
+    if (!g_sharedConfig.Poll(g_config)) return;
+    g_visible = g_config.visible;
+    g_showGraph = g_config.showGraph;
+    ApplyConfigPosition();
+}
+
+// Per-frame summaries for fps_monitor; pushed from the Present / EndScene thread
+static Telemetry::Producer g_telemetry;
+
+static void OpenTelemetry() {
+    wchar_t path[MAX_PATH];
+    char exeName[64] = {0};
+    DWORD len = GetModuleFileNameW(NULL, path, MAX_PATH);
+    if (len > 0 && len < MAX_PATH) {
+        const wchar_t* name = wcsrchr(path, L'\\');
+        name = name ? name + 1 : path;
+        WideCharToMultiByte(CP_UTF8, 0, name, -1, exeName, sizeof(exeName) - 1, NULL, NULL);
+    }
+    
+    // Start time tells a restarted process apart from an old one with the same pid
+    LARGE_INTEGER now;
+    QueryPerformanceCounter(&now);
+    if (g_telemetry.Open(GetCurrentProcessId(), exeName, g_frequency.QuadPart, now.QuadPart)) {
+        LOG("InstallHook: Telemetry opened (%s)", exeName);
+    }
+}
+
 // Frame Statistics for Display FPS
 static UINT g_lastPresentCount = 0;
 static LARGE_INTEGER g_lastStatsTime = {0};
 static bool g_statsInitialized = false;
 
-// D3D11 resources (cached)
-static ID3D11Device* g_pd3dDevice = nullptr;
-static ID3D11DeviceContext* g_pd3dContext = nullptr;
-static ID3D11RenderTargetView* g_pRTV = nullptr;
-static ID3D11VertexShader* g_pVS = nullptr;
-static ID3D11PixelShader* g_pPS = nullptr;
-static ID3D11InputLayout* g_pInputLayout = nullptr;
-static ID3D11Buffer* g_pVertexBuffer = nullptr;
-static ID3D11BlendState* g_pBlendState = nullptr;
-static ID3D11Texture2D* g_pFontTexture = nullptr;
-static ID3D11ShaderResourceView* g_pFontSRV = nullptr;
-static ID3D11SamplerState* g_pSampler = nullptr;
-static IDXGISwapChain* g_pCurrentSwapChain = nullptr;
+// D3D11 resources, cached per device and per swap chain (render_state_cache.h)
+struct D3D11Shared {
+    ID3D11Device* device;
+    ID3D11DeviceContext* context;
+    ID3D11VertexShader* vs;
+    ID3D11PixelShader* ps;
+    ID3D11InputLayout* inputLayout;
+    ID3D11Buffer* vertexBuffer;
+    ID3D11BlendState* blendState;
+    ID3D11Texture2D* fontTexture;
+    ID3D11ShaderResourceView* fontSRV;
+    ID3D11SamplerState* sampler;
+};
+
+struct D3D11View {
+    ID3D11RenderTargetView* rtv;
+    UINT width, height;
+    DXGI_FORMAT format;
+};
+
+struct D3D11Traits {
+    using TargetKey = IDXGISwapChain*;
+    using DeviceKey = ID3D11Device*;
+    using Shared = D3D11Shared;
+    using View = D3D11View;
+    bool CreateShared(ID3D11Device* device, D3D11Shared& shared);
+    void ReleaseShared(D3D11Shared& shared);
+    bool CreateView(IDXGISwapChain* swapChain, D3D11Shared& shared, D3D11View& view);
+    void ReleaseView(D3D11View& view);
+};
+
+static RenderStateCache<D3D11Traits> g_renderCache;
+static D3D11Shared* g_pShared = nullptr;    // State of the swap chain being drawn,
+static D3D11View* g_pView = nullptr;        // owned by g_renderCache
 static UINT g_width = 0, g_height = 0;
-static bool g_resourcesCreated = false;
 
 // Hook - DX11
 typedef HRESULT(WINAPI* PFN_Present)(IDXGISwapChain*, UINT, UINT);
 static PFN_Present g_originalPresent = nullptr;
+typedef HRESULT(WINAPI* PFN_ResizeBuffers)(IDXGISwapChain*, UINT, UINT, UINT, DXGI_FORMAT, UINT);
+static PFN_ResizeBuffers g_originalResizeBuffers = nullptr;
 
 // Hook - DX9
 typedef HRESULT(WINAPI* PFN_EndScene9)(IDirect3DDevice9*);
 static PFN_EndScene9 g_originalEndScene9 = nullptr;
 static bool g_d3d9Hooked = false;
+static VtableSlotHook g_presentSlot;
+static VtableSlotHook g_resizeBuffersSlot;
+static VtableSlotHook g_endScene9Slot;
 
 // DX12 detection
 static bool g_isDX12 = false;
@@ -288,76 +326,64 @@ struct Vertex {
     float r, g, b, a;
 };
 
-bool IsGraphicsProcess() {
-    char exeName[MAX_PATH];
-    GetModuleFileNameA(NULL, exeName, MAX_PATH);
-    char* fileName = strrchr(exeName, '\\');
-    fileName = fileName ? fileName + 1 : exeName;
-    
-    // Exclude system processes
-    const char* excludeList[] = {
-        "fps_monitor.exe",
-        "conhost.exe",
-        "explorer.exe",
-        "dwm.exe",
-        "csrss.exe",
-        "svchost.exe",
-        "SearchHost.exe",
-        "ShellExperienceHost.exe",
-        "StartMenuExperienceHost.exe",
-        "RuntimeBroker.exe",
-        "TextInputHost.exe",
-        "taskhostw.exe",
-        "ctfmon.exe",
-        "cleanmgr.exe",
-        "taskmgr.exe",
-        "cmd.exe",
-        "powershell.exe",
-        "WindowsTerminal.exe",
-        "OneDrive.exe",
-        "OneDriveStandaloneUpdater.exe",
-        "browser.exe",
-        "BackgroundDownload.exe",
-        "ApplicationFrameHost.exe",
-        "SystemSettings.exe",
-        "SettingsHelper.exe",
-        "sihost.exe",
-        "fontdrvhost.exe",
-        "WmiPrvSE.exe",
-        "dllhost.exe",
-        "CompPkgSrv.exe",
-        "SearchIndexer.exe",
-        "SecurityHealthService.exe",
-        "MsMpEng.exe",
-        "NisSrv.exe",
-        "smartscreen.exe",
-        "spoolsv.exe",
-        "services.exe",
-        "lsass.exe",
-        "wininit.exe",
-        "winlogon.exe",
-        NULL
+// Vertex budget: ~100 characters plus one quad per graph column and its frame
+static const int MAX_VERTICES = 6 * (100 + (int)FrameTimeGraph::kMaxColumns + 8);
+
+// The DEL glyph cell (index 95) is filled solid in the font atlas; sampling
+// its centre gives alpha 1 for untextured quads such as graph bars
+static const float SOLID_U = (15 * 8 + 4) / 128.0f;
+static const float SOLID_V = (5 * 8 + 4) / 48.0f;
+
+// Image path of this process, filled once by CBTProc
+static wchar_t g_exeWidePath[MAX_PATH];
+static char g_exePath[MAX_PATH * 3];        // UTF-8
+static size_t g_exePathLength = 0;
+
+static bool LoadExePath() {
+    DWORD len = GetModuleFileNameW(NULL, g_exeWidePath, MAX_PATH);
+    if (len == 0 || len >= MAX_PATH) return false;
+    int bytes = WideCharToMultiByte(CP_UTF8, 0, g_exeWidePath, (int)len, g_exePath, sizeof(g_exePath) - 1, NULL, NULL);
+    if (bytes <= 0) return false;
+    g_exePath[bytes] = '\0';
+    g_exePathLength = (size_t)bytes;
+    return true;
+}
+
+// Path and exe-name rules compiled by the monitor (process_filter.h).
+// Decided once per process. No filter segment means no monitor: Invalid,
+// like a blob that stayed torn through the reader's retries.
+static ProcessFilter::Verdict DecideProcessFilter() {
+    ProcessFilter::Reader filter;
+    if (!filter.Open()) return ProcessFilter::Verdict::Invalid;
+    return filter.Decide(g_exePath, g_exePathLength);
+}
+
+// Outcome of earlier launches of this exe (verdict_cache.h). The key covers
+// the file identity, so an updated exe is detected from scratch.
+static VerdictCache::Table g_verdicts;
+static uint64_t g_verdictKey = 0;
+
+static VerdictCache::Verdict LookupVerdict() {
+    HANDLE file = CreateFileW(g_exeWidePath, FILE_READ_ATTRIBUTES,
+                              FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                              NULL, OPEN_EXISTING, 0, NULL);
+    if (file == INVALID_HANDLE_VALUE) return VerdictCache::kUnknown;
+    BY_HANDLE_FILE_INFORMATION info;
+    BOOL ok = GetFileInformationByHandle(file, &info);
+    CloseHandle(file);
+    if (!ok || !g_verdicts.Open()) return VerdictCache::kUnknown;
+    
+    VerdictCache::FileIdentity identity = {
+        info.dwVolumeSerialNumber,
+        ((uint64_t)info.nFileIndexHigh << 32) | info.nFileIndexLow,
+        ((uint64_t)info.nFileSizeHigh << 32) | info.nFileSizeLow,
+        ((uint64_t)info.ftLastWriteTime.dwHighDateTime << 32) | info.ftLastWriteTime.dwLowDateTime,
     };
-    
-    for (int i = 0; excludeList[i] != NULL; i++) {
-        if (_stricmp(fileName, excludeList[i]) == 0) return false;
-    }
-    
-    // Convert path to lowercase for case-insensitive comparison
-    char lowerPath[MAX_PATH];
-    strcpy_s(lowerPath, exeName);
-    _strlwr_s(lowerPath);
-    
-    // Exclude paths containing certain keywords (case-insensitive)
-    if (strstr(lowerPath, "\\windows\\") != NULL) return false;
-    if (strstr(lowerPath, "\\microsoft\\") != NULL) return false;
-    if (strstr(lowerPath, "\\onedrive\\") != NULL) return false;
-    if (strstr(lowerPath, "\\system32\\") != NULL) return false;
-    if (strstr(lowerPath, "\\syswow64\\") != NULL) return false;
-    if (strstr(lowerPath, "program files") != NULL) return false;
-    if (strstr(lowerPath, "visual studio") != NULL) return false;
-    if (strstr(lowerPath, "\\appdata\\") != NULL) return false;
-    
+    g_verdictKey = VerdictCache::MakeKey(g_exePath, g_exePathLength, identity);
+    return g_verdicts.Lookup(g_verdictKey);
+}
+
+bool IsGraphicsProcess() {
     // Must have D3D loaded
     return GetModuleHandleW(L"d3d11.dll") != NULL || 
            GetModuleHandleW(L"dxgi.dll") != NULL ||
@@ -374,7 +400,7 @@ void InitMonitorRefreshRate() {
             g_monitorRefreshRate = 60;
         }
     }
-    Log("Monitor refresh rate: %d Hz", g_monitorRefreshRate);
+    LOG("Monitor refresh rate: %d Hz", g_monitorRefreshRate);
 }
 
 // Update GPU FPS (from Present calls)
@@ -382,6 +408,13 @@ void UpdateGpuFps() {
     LARGE_INTEGER now;
     QueryPerformanceCounter(&now);
     
+    if (g_lastFrameQpc.QuadPart != 0) {
+        float frameMs = (float)((double)(now.QuadPart - g_lastFrameQpc.QuadPart) * 1000.0 / g_frequency.QuadPart);
+        g_frameGraph.AddFrame((double)now.QuadPart / g_frequency.QuadPart, frameMs);
+        g_telemetry.Push(now.QuadPart, frameMs, g_lastSyncInterval);
+    }
+    g_lastFrameQpc = now;
+    
     std::lock_guard<std::mutex> lock(g_mutex);
     g_frameTimes.push_back(now);
     
@@ -462,69 +495,17 @@ void UpdateDisplayFps(IDXGISwapChain* pSwapChain) {
     }
 }
 
-void CleanupResources() {
-    if (g_pRTV) { g_pRTV->Release(); g_pRTV = nullptr; }
-    if (g_pVS) { g_pVS->Release(); g_pVS = nullptr; }
-    if (g_pPS) { g_pPS->Release(); g_pPS = nullptr; }
-    if (g_pInputLayout) { g_pInputLayout->Release(); g_pInputLayout = nullptr; }
-    if (g_pVertexBuffer) { g_pVertexBuffer->Release(); g_pVertexBuffer = nullptr; }
-    if (g_pBlendState) { g_pBlendState->Release(); g_pBlendState = nullptr; }
-    if (g_pFontTexture) { g_pFontTexture->Release(); g_pFontTexture = nullptr; }
-    if (g_pFontSRV) { g_pFontSRV->Release(); g_pFontSRV = nullptr; }
-    if (g_pSampler) { g_pSampler->Release(); g_pSampler = nullptr; }
-    g_resourcesCreated = false;
+template <typename T>
+static void SafeRelease(T*& p) {
+    if (p) { p->Release(); p = nullptr; }
 }
 
-bool CreateResources(IDXGISwapChain* pSwapChain) {
-    if (g_resourcesCreated && g_pCurrentSwapChain == pSwapChain) return true;
-    
-    static bool loggedStart = false;
-    if (!loggedStart) {
-        Log("CreateResources: starting");
-        loggedStart = true;
-    }
-    
-    CleanupResources();
-    g_pCurrentSwapChain = pSwapChain;
-    
-    // Check if DX12
-    ID3D12Device* pD3D12Device = nullptr;
-    if (SUCCEEDED(pSwapChain->GetDevice(__uuidof(ID3D12Device), (void**)&pD3D12Device))) {
-        g_isDX12 = true;
-        pD3D12Device->Release();
-        Log("CreateResources: DX12 detected, using fallback rendering");
-        return false; // Use fallback rendering
-    }
-    
-    // Get DX11 device
-    if (!g_pd3dDevice) {
-        HRESULT hr = pSwapChain->GetDevice(__uuidof(ID3D11Device), (void**)&g_pd3dDevice);
-        if (FAILED(hr)) {
-            Log("CreateResources: GetDevice failed hr=0x%08X", hr);
-            return false;
-        }
-        if (g_pd3dDevice) g_pd3dDevice->GetImmediateContext(&g_pd3dContext);
-    }
-    if (!g_pd3dDevice || !g_pd3dContext) {
-        Log("CreateResources: No device/context");
-        return false;
-    }
-    
-    // Get backbuffer size
-    ID3D11Texture2D* pBackBuffer = nullptr;
-    if (FAILED(pSwapChain->GetBuffer(0, __uuidof(ID3D11Texture2D), (void**)&pBackBuffer))) return false;
-    
-    D3D11_TEXTURE2D_DESC bbDesc;
-    pBackBuffer->GetDesc(&bbDesc);
-    g_width = bbDesc.Width;
-    g_height = bbDesc.Height;
-    
-    // Create RTV
-    if (FAILED(g_pd3dDevice->CreateRenderTargetView(pBackBuffer, nullptr, &g_pRTV))) {
-        pBackBuffer->Release();
-        return false;
-    }
-    pBackBuffer->Release();
+// Shaders, input layout, vertex buffer, blend state, font atlas and sampler:
+// everything that depends on the device only
+bool D3D11Traits::CreateShared(ID3D11Device* device, D3D11Shared& shared) {
+    shared.device = device;
+    device->AddRef();
+    device->GetImmediateContext(&shared.context);
     
     // Compile shaders
     ID3DBlob* vsBlob = nullptr;
@@ -534,17 +515,19 @@ bool CreateResources(IDXGISwapChain* pSwapChain) {
     if (FAILED(D3DCompile(g_shaderCode, strlen(g_shaderCode), nullptr, nullptr, nullptr, 
                           "VS", "vs_4_0", 0, 0, &vsBlob, &errorBlob))) {
         if (errorBlob) errorBlob->Release();
+        ReleaseShared(shared);
         return false;
     }
     if (FAILED(D3DCompile(g_shaderCode, strlen(g_shaderCode), nullptr, nullptr, nullptr,
                           "PS", "ps_4_0", 0, 0, &psBlob, &errorBlob))) {
         vsBlob->Release();
         if (errorBlob) errorBlob->Release();
+        ReleaseShared(shared);
         return false;
     }
     
-    g_pd3dDevice->CreateVertexShader(vsBlob->GetBufferPointer(), vsBlob->GetBufferSize(), nullptr, &g_pVS);
-    g_pd3dDevice->CreatePixelShader(psBlob->GetBufferPointer(), psBlob->GetBufferSize(), nullptr, &g_pPS);
+    device->CreateVertexShader(vsBlob->GetBufferPointer(), vsBlob->GetBufferSize(), nullptr, &shared.vs);
+    device->CreatePixelShader(psBlob->GetBufferPointer(), psBlob->GetBufferSize(), nullptr, &shared.ps);
     
     // Input layout
     D3D11_INPUT_ELEMENT_DESC layout[] = {
@@ -552,18 +535,18 @@ bool CreateResources(IDXGISwapChain* pSwapChain) {
         {"TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT, 0, 8, D3D11_INPUT_PER_VERTEX_DATA, 0},
         {"COLOR", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, 0, 16, D3D11_INPUT_PER_VERTEX_DATA, 0},
     };
-    g_pd3dDevice->CreateInputLayout(layout, 3, vsBlob->GetBufferPointer(), vsBlob->GetBufferSize(), &g_pInputLayout);
+    device->CreateInputLayout(layout, 3, vsBlob->GetBufferPointer(), vsBlob->GetBufferSize(), &shared.inputLayout);
     
     vsBlob->Release();
     psBlob->Release();
     
-    // Vertex buffer (enough for ~100 characters)
+    // Vertex buffer (text + frame graph)
     D3D11_BUFFER_DESC vbDesc = {};
-    vbDesc.ByteWidth = sizeof(Vertex) * 6 * 100;
+    vbDesc.ByteWidth = sizeof(Vertex) * MAX_VERTICES;
     vbDesc.Usage = D3D11_USAGE_DYNAMIC;
     vbDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
     vbDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
-    g_pd3dDevice->CreateBuffer(&vbDesc, nullptr, &g_pVertexBuffer);
+    device->CreateBuffer(&vbDesc, nullptr, &shared.vertexBuffer);
     
     // Blend state
     D3D11_BLEND_DESC blendDesc = {};
@@ -575,7 +558,7 @@ bool CreateResources(IDXGISwapChain* pSwapChain) {
     blendDesc.RenderTarget[0].DestBlendAlpha = D3D11_BLEND_INV_SRC_ALPHA;
     blendDesc.RenderTarget[0].BlendOpAlpha = D3D11_BLEND_OP_ADD;
     blendDesc.RenderTarget[0].RenderTargetWriteMask = D3D11_COLOR_WRITE_ENABLE_ALL;
-    g_pd3dDevice->CreateBlendState(&blendDesc, &g_pBlendState);
+    device->CreateBlendState(&blendDesc, &shared.blendState);
     
     // Font texture (16x6 characters, 8x8 each = 128x48)
     D3D11_TEXTURE2D_DESC texDesc = {};
@@ -594,7 +577,7 @@ bool CreateResources(IDXGISwapChain* pSwapChain) {
         int ty = (i / 16) * 8;
         for (int y = 0; y < 8; y++) {
             for (int x = 0; x < 8; x++) {
-                if (g_fontData[i][y] & (0x80 >> x)) {
+                if (i == 95 || (g_fontData[i][y] & (0x80 >> x))) {
                     texData[(ty + y) * 128 + tx + x] = 255;
                 }
             }
@@ -604,8 +587,8 @@ bool CreateResources(IDXGISwapChain* pSwapChain) {
     D3D11_SUBRESOURCE_DATA initData = {};
     initData.pSysMem = texData;
     initData.SysMemPitch = 128;
-    g_pd3dDevice->CreateTexture2D(&texDesc, &initData, &g_pFontTexture);
-    g_pd3dDevice->CreateShaderResourceView(g_pFontTexture, nullptr, &g_pFontSRV);
+    device->CreateTexture2D(&texDesc, &initData, &shared.fontTexture);
+    device->CreateShaderResourceView(shared.fontTexture, nullptr, &shared.fontSRV);
     
     // Sampler
     D3D11_SAMPLER_DESC sampDesc = {};
@@ -613,9 +596,107 @@ bool CreateResources(IDXGISwapChain* pSwapChain) {
     sampDesc.AddressU = D3D11_TEXTURE_ADDRESS_CLAMP;
     sampDesc.AddressV = D3D11_TEXTURE_ADDRESS_CLAMP;
     sampDesc.AddressW = D3D11_TEXTURE_ADDRESS_CLAMP;
-    g_pd3dDevice->CreateSamplerState(&sampDesc, &g_pSampler);
+    device->CreateSamplerState(&sampDesc, &shared.sampler);
     
-    g_resourcesCreated = true;
+    if (!shared.context || !shared.vertexBuffer) {
+        ReleaseShared(shared);
+        return false;
+    }
+    return true;
+}
+
+void D3D11Traits::ReleaseShared(D3D11Shared& shared) {
+    SafeRelease(shared.sampler);
+    SafeRelease(shared.fontSRV);
+    SafeRelease(shared.fontTexture);
+    SafeRelease(shared.blendState);
+    SafeRelease(shared.vertexBuffer);
+    SafeRelease(shared.inputLayout);
+    SafeRelease(shared.ps);
+    SafeRelease(shared.vs);
+    SafeRelease(shared.context);
+    SafeRelease(shared.device);
+}
+
+// Back buffer RTV and size of one swap chain
+bool D3D11Traits::CreateView(IDXGISwapChain* swapChain, D3D11Shared& shared, D3D11View& view) {
+    ID3D11Texture2D* pBackBuffer = nullptr;
+    if (FAILED(swapChain->GetBuffer(0, __uuidof(ID3D11Texture2D), (void**)&pBackBuffer))) return false;
+    
+    D3D11_TEXTURE2D_DESC bbDesc;
+    pBackBuffer->GetDesc(&bbDesc);
+    view.width = bbDesc.Width;
+    view.height = bbDesc.Height;
+    view.format = bbDesc.Format;
+    
+    HRESULT hr = shared.device->CreateRenderTargetView(pBackBuffer, nullptr, &view.rtv);
+    pBackBuffer->Release();
+    return SUCCEEDED(hr);
+}
+
+void D3D11Traits::ReleaseView(D3D11View& view) {
+    SafeRelease(view.rtv);
+}
+
+void CleanupResources() {
+    g_renderCache.Clear();
+    g_pShared = nullptr;
+    g_pView = nullptr;
+}
+
+// Binds the cached state of pSwapChain, creating it on first use. Switching
+// between swap chains only recreates an RTV; shaders and the font atlas are
+// created once per device.
+bool CreateResources(IDXGISwapChain* pSwapChain) {
+    RenderStateCache<D3D11Traits>::Binding binding = g_renderCache.Find(pSwapChain);
+    if (binding) {
+        // Resized without going through HookedResizeBuffers (e.g. its hook
+        // failed): the cached view no longer matches the back buffer
+        DXGI_SWAP_CHAIN_DESC desc;
+        if (FAILED(pSwapChain->GetDesc(&desc)) || desc.BufferDesc.Width != binding.view->width ||
+            desc.BufferDesc.Height != binding.view->height || desc.BufferDesc.Format != binding.view->format) {
+            g_renderCache.Erase(pSwapChain);
+            binding = RenderStateCache<D3D11Traits>::Binding();
+        }
+    }
+    if (!binding) {
+        static bool loggedStart = false;
+        if (!loggedStart) {
+            LOG("CreateResources: starting");
+            loggedStart = true;
+        }
+        
+        // Check if DX12
+        ID3D12Device* pD3D12Device = nullptr;
+        if (SUCCEEDED(pSwapChain->GetDevice(__uuidof(ID3D12Device), (void**)&pD3D12Device))) {
+            g_isDX12 = true;
+            pD3D12Device->Release();
+            LOG("CreateResources: DX12 detected, using fallback rendering");
+            return false; // Use fallback rendering
+        }
+        
+        // Get DX11 device
+        ID3D11Device* pDevice = nullptr;
+        HRESULT hr = pSwapChain->GetDevice(__uuidof(ID3D11Device), (void**)&pDevice);
+        if (FAILED(hr) || !pDevice) {
+            LOG("CreateResources: GetDevice failed hr=0x%08X", hr);
+            return false;
+        }
+        binding = g_renderCache.Insert(pSwapChain, pDevice);
+        pDevice->Release();     // The cache keeps its own reference
+        if (!binding) {
+            LOG("CreateResources: creating resources failed");
+            return false;
+        }
+    }
+    
+    g_pShared = binding.shared;
+    g_pView = binding.view;
+    if (binding.switched) {
+        g_width = g_pView->width;
+        g_height = g_pView->height;
+        g_telemetry.SetSwapchain({ Telemetry::Api::D3D11, g_width, g_height, (uint32_t)g_pView->format });
+    }
     return true;
 }
 
@@ -691,7 +772,7 @@ void RenderFpsGDI(IDXGISwapChain* pSwapChain) {
 void RenderFpsOverlay(IDXGISwapChain* pSwapChain) {
     static bool loggedOnce = false;
     if (!loggedOnce) {
-        Log("RenderFpsOverlay: called, visible=%d", g_visible ? 1 : 0);
+        LOG("RenderFpsOverlay: called, visible=%d", g_visible ? 1 : 0);
         loggedOnce = true;
     }
     
@@ -701,7 +782,7 @@ void RenderFpsOverlay(IDXGISwapChain* pSwapChain) {
     if (!CreateResources(pSwapChain)) {
         static bool loggedFail = false;
         if (!loggedFail) {
-            Log("RenderFpsOverlay: CreateResources failed, isDX12=%d", g_isDX12 ? 1 : 0);
+            LOG("RenderFpsOverlay: CreateResources failed, isDX12=%d", g_isDX12 ? 1 : 0);
             loggedFail = true;
         }
         if (g_isDX12) {
@@ -752,7 +833,7 @@ void RenderFpsOverlay(IDXGISwapChain* pSwapChain) {
     g_fpsBoxWidth = (int)(textWidth + 12);  // with padding
     g_fpsBoxHeight = (int)(charH + 6);
     
-    Vertex vertices[600];
+    static Vertex vertices[MAX_VERTICES];
     int vertCount = 0;
     
     // Background quad with padding
@@ -852,41 +933,87 @@ void RenderFpsOverlay(IDXGISwapChain* pSwapChain) {
         vertices[vertCount++] = {l, bb, u0, v1, r, g, b, 1.0f};
     }
     
+    // Frame-time graph below the box: one bar per column spanning that column's min..max
+    if (g_showGraph) {
+        static FrameTimeGraph::Column columns[FrameTimeGraph::kMaxColumns];
+        int count = (int)g_frameGraph.GetColumns(columns, FrameTimeGraph::kMaxColumns);
+        
+        float graphW = (float)g_frameGraph.Columns();
+        float graphH = 40.0f;
+        float gx = startX - pad;
+        float gy = startY + charH + pad;
+        
+        float topMs = 50.0f;
+        for (int i = 0; i < count; i++) {
+            if (columns[i].maxMs > topMs) topMs = columns[i].maxMs;
+        }
+        
+        auto addQuad = [&](float x0, float y0, float x1, float y1, float cr, float cg, float cb, float ca) {
+            float l = x0 / g_width * 2.0f - 1.0f;
+            float rr = x1 / g_width * 2.0f - 1.0f;
+            float t = 1.0f - y0 / g_height * 2.0f;
+            float bb = 1.0f - y1 / g_height * 2.0f;
+            vertices[vertCount++] = {l, t, SOLID_U, SOLID_V, cr, cg, cb, ca};
+            vertices[vertCount++] = {rr, t, SOLID_U, SOLID_V, cr, cg, cb, ca};
+            vertices[vertCount++] = {l, bb, SOLID_U, SOLID_V, cr, cg, cb, ca};
+            vertices[vertCount++] = {rr, t, SOLID_U, SOLID_V, cr, cg, cb, ca};
+            vertices[vertCount++] = {rr, bb, SOLID_U, SOLID_V, cr, cg, cb, ca};
+            vertices[vertCount++] = {l, bb, SOLID_U, SOLID_V, cr, cg, cb, ca};
+        };
+        
+        addQuad(gx, gy, gx + graphW, gy + graphH, 0.05f, 0.05f, 0.08f, 0.6f);
+        
+        float colW = count > 0 ? graphW / count : 0.0f;
+        for (int i = 0; i < count; i++) {
+            if (columns[i].maxMs != columns[i].maxMs) continue;  // NaN: no frames in column
+            
+            float y0 = gy + graphH * (1.0f - columns[i].maxMs / topMs);
+            float y1 = gy + graphH * (1.0f - columns[i].minMs / topMs);
+            if (y1 - y0 < 1.0f) y1 = y0 + 1.0f;
+            
+            float cr, cg, cb;
+            if (columns[i].maxMs <= 1000.0f / 60.0f) { cr = 0.0f; cg = 0.9f; cb = 0.4f; }
+            else if (columns[i].maxMs <= 1000.0f / 30.0f) { cr = 1.0f; cg = 0.8f; cb = 0.0f; }
+            else { cr = 1.0f; cg = 0.25f; cb = 0.25f; }
+            addQuad(gx + i * colW, y0, gx + (i + 1) * colW, y1, cr, cg, cb, 0.9f);
+        }
+    }
+    
     // Update vertex buffer
     D3D11_MAPPED_SUBRESOURCE mapped;
-    if (SUCCEEDED(g_pd3dContext->Map(g_pVertexBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped))) {
+    if (SUCCEEDED(g_pShared->context->Map(g_pShared->vertexBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped))) {
         memcpy(mapped.pData, vertices, vertCount * sizeof(Vertex));
-        g_pd3dContext->Unmap(g_pVertexBuffer, 0);
+        g_pShared->context->Unmap(g_pShared->vertexBuffer, 0);
     }
     
     // Save state
     ID3D11RenderTargetView* oldRTV = nullptr;
     ID3D11DepthStencilView* oldDSV = nullptr;
-    g_pd3dContext->OMGetRenderTargets(1, &oldRTV, &oldDSV);
+    g_pShared->context->OMGetRenderTargets(1, &oldRTV, &oldDSV);
     
     // Set state
-    g_pd3dContext->OMSetRenderTargets(1, &g_pRTV, nullptr);
-    g_pd3dContext->OMSetBlendState(g_pBlendState, nullptr, 0xFFFFFFFF);
+    g_pShared->context->OMSetRenderTargets(1, &g_pView->rtv, nullptr);
+    g_pShared->context->OMSetBlendState(g_pShared->blendState, nullptr, 0xFFFFFFFF);
     
     UINT stride = sizeof(Vertex);
     UINT offset = 0;
-    g_pd3dContext->IASetVertexBuffers(0, 1, &g_pVertexBuffer, &stride, &offset);
-    g_pd3dContext->IASetInputLayout(g_pInputLayout);
-    g_pd3dContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+    g_pShared->context->IASetVertexBuffers(0, 1, &g_pShared->vertexBuffer, &stride, &offset);
+    g_pShared->context->IASetInputLayout(g_pShared->inputLayout);
+    g_pShared->context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
     
-    g_pd3dContext->VSSetShader(g_pVS, nullptr, 0);
-    g_pd3dContext->PSSetShader(g_pPS, nullptr, 0);
-    g_pd3dContext->PSSetShaderResources(0, 1, &g_pFontSRV);
-    g_pd3dContext->PSSetSamplers(0, 1, &g_pSampler);
+    g_pShared->context->VSSetShader(g_pShared->vs, nullptr, 0);
+    g_pShared->context->PSSetShader(g_pShared->ps, nullptr, 0);
+    g_pShared->context->PSSetShaderResources(0, 1, &g_pShared->fontSRV);
+    g_pShared->context->PSSetSamplers(0, 1, &g_pShared->sampler);
     
     D3D11_VIEWPORT vp = {0, 0, (float)g_width, (float)g_height, 0, 1};
-    g_pd3dContext->RSSetViewports(1, &vp);
+    g_pShared->context->RSSetViewports(1, &vp);
     
     // Draw
-    g_pd3dContext->Draw(vertCount, 0);
+    g_pShared->context->Draw(vertCount, 0);
     
     // Restore state
-    g_pd3dContext->OMSetRenderTargets(1, &oldRTV, oldDSV);
+    g_pShared->context->OMSetRenderTargets(1, &oldRTV, oldDSV);
     if (oldRTV) oldRTV->Release();
     if (oldDSV) oldDSV->Release();
 }
@@ -912,23 +1039,12 @@ HRESULT WINAPI HookedPresent(IDXGISwapChain* pSwapChain, UINT SyncInterval, UINT
             
             // Read visibility and position from shared config (controlled by monitor)
             // No hotkey processing in hook - safer and more stable
-            if (g_pConfig) {
-                g_visible = g_pConfig->visible;
-                
-                // Update position from config if changed
-                if (g_pConfig->position == POS_CUSTOM) {
-                    g_currentPosX = g_pConfig->customX;
-                    g_currentPosY = g_pConfig->customY;
-                } else {
-                    g_currentPosX = g_pConfig->offsetX;
-                    g_currentPosY = g_pConfig->offsetY;
-                }
-            }
+            PollSharedConfig();
             
             RenderFpsOverlay(pSwapChain);
         }
         __except(EXCEPTION_EXECUTE_HANDLER) {
-            Log("Exception in HookedPresent, disabling render");
+            LOG("Exception in HookedPresent, disabling render");
             g_renderDisabled = true;
         }
     }
@@ -936,6 +1052,16 @@ HRESULT WINAPI HookedPresent(IDXGISwapChain* pSwapChain, UINT SyncInterval, UINT
     return g_originalPresent(pSwapChain, SyncInterval, Flags);
 }
 
+// ResizeBuffers fails while any reference to a back buffer is alive, so the
+// cached RTV of this swap chain goes first (the device state stays cached)
+HRESULT WINAPI HookedResizeBuffers(IDXGISwapChain* pSwapChain, UINT BufferCount, UINT Width, UINT Height,
+                                   DXGI_FORMAT NewFormat, UINT SwapChainFlags) {
+    g_renderCache.Erase(pSwapChain);
+    g_pShared = nullptr;
+    g_pView = nullptr;
+    return g_originalResizeBuffers(pSwapChain, BufferCount, Width, Height, NewFormat, SwapChainFlags);
+}
+
 // D3D9 rendering using GDI
 void RenderFpsOverlay9(IDirect3DDevice9* pDevice) {
     if (!g_visible) return;
@@ -962,6 +1088,14 @@ void RenderFpsOverlay9(IDirect3DDevice9* pDevice) {
         D3DSURFACE_DESC desc;
         pBackBuffer->GetDesc(&desc);
         
+        // No resource recreation on D3D9 resize: report size changes here
+        static UINT reportedWidth = 0, reportedHeight = 0;
+        if (desc.Width != reportedWidth || desc.Height != reportedHeight) {
+            reportedWidth = desc.Width;
+            reportedHeight = desc.Height;
+            g_telemetry.SetSwapchain({ Telemetry::Api::D3D9, desc.Width, desc.Height, (uint32_t)desc.Format });
+        }
+        
         // Use dragged position
         int textLen = (int)strlen(text);
         int textWidth = textLen * 10;
@@ -1014,16 +1148,15 @@ HRESULT WINAPI HookedEndScene9(IDirect3DDevice9* pDevice) {
     g_dispFpsActual = false;
     
     // Read visibility from shared config (no hotkey processing)
-    if (g_pConfig) {
-        g_visible = g_pConfig->visible;
-    }
+    PollSharedConfig();
     
     RenderFpsOverlay9(pDevice);
     
     return g_originalEndScene9(pDevice);
 }
 
-void* GetEndScene9Address() {
+// Slot in the device vtable (inside d3d9.dll, valid after the dummy device is released)
+static void** DummyEndScene9Slot() {
     WNDCLASSEXW wc = { sizeof(WNDCLASSEXW), CS_CLASSDC, DefWindowProcW, 0, 0, 
                        GetModuleHandle(NULL), NULL, NULL, NULL, NULL, L"D3D9Dummy", NULL };
     RegisterClassExW(&wc);
@@ -1045,22 +1178,22 @@ void* GetEndScene9Address() {
     pp.BackBufferFormat = D3DFMT_UNKNOWN;
     
     IDirect3DDevice9* pDevice = nullptr;
-    void* endSceneAddr = nullptr;
+    void** endSceneSlot = nullptr;
     
     if (SUCCEEDED(pD3D->CreateDevice(D3DADAPTER_DEFAULT, D3DDEVTYPE_HAL, hWnd,
             D3DCREATE_SOFTWARE_VERTEXPROCESSING, &pp, &pDevice))) {
-        void** vtable = *(void***)pDevice;
-        endSceneAddr = vtable[42]; // EndScene is at index 42
+        endSceneSlot = VtableSlotHook::SlotOf(pDevice, 42); // EndScene is at index 42
         pDevice->Release();
     }
     
     pD3D->Release();
     DestroyWindow(hWnd);
     UnregisterClassW(wc.lpszClassName, wc.hInstance);
-    return endSceneAddr;
+    return endSceneSlot;
 }
 
-void* GetPresentAddress() {
+// Slot in the swap chain vtable (inside dxgi.dll)
+static void** DummyPresentSlot() {
     WNDCLASSEXW wc = { sizeof(WNDCLASSEXW), CS_CLASSDC, DefWindowProcW, 0, 0, 
                        GetModuleHandle(NULL), NULL, NULL, NULL, NULL, L"DX11Dummy", NULL };
     RegisterClassExW(&wc);
@@ -1081,12 +1214,11 @@ void* GetPresentAddress() {
     IDXGISwapChain* pSwapChain = nullptr;
     ID3D11Device* pDevice = nullptr;
     ID3D11DeviceContext* pContext = nullptr;
-    void* presentAddr = nullptr;
+    void** presentSlot = nullptr;
     
     if (SUCCEEDED(D3D11CreateDeviceAndSwapChain(NULL, D3D_DRIVER_TYPE_HARDWARE, NULL, 0, NULL, 0,
             D3D11_SDK_VERSION, &sd, &pSwapChain, &pDevice, NULL, &pContext))) {
-        void** vtable = *(void***)pSwapChain;
-        presentAddr = vtable[8];
+        presentSlot = VtableSlotHook::SlotOf(pSwapChain, 8);   // Present is at index 8
         pContext->Release();
         pDevice->Release();
         pSwapChain->Release();
@@ -1094,44 +1226,104 @@ void* GetPresentAddress() {
     
     DestroyWindow(hWnd);
     UnregisterClassW(wc.lpszClassName, wc.hInstance);
-    return presentAddr;
+    return presentSlot;
+}
+
+// Slots found by earlier injections (entry_point_cache.h), in
+// <dll dir>\entry_points.bin. Used while the module file is unchanged, so
+// most injections skip the dummy window and device.
+static bool GetEntryPointCachePath(char* path, size_t pathSize) {
+    DWORD len = GetModuleFileNameA(g_hModule, path, (DWORD)pathSize);
+    if (len == 0 || len >= pathSize) return false;
+    char* lastSlash = strrchr(path, '\\');
+    if (!lastSlash) return false;
+    *(lastSlash + 1) = '\0';
+    return strcat_s(path, pathSize, "entry_points.bin") == 0;
+}
+
+static void** ResolveSlot(const wchar_t* moduleName, uint32_t id, void** (*dummySlot)()) {
+    char path[MAX_PATH] = {0};
+    bool havePath = GetEntryPointCachePath(path, sizeof(path));
+    EntryPointCache::Table table;
+    EntryPointCache::Module module;
+    bool identified = havePath && EntryPointCache::IdentifyModule(moduleName, &module);
+    if (identified) {
+        table.Load(path);
+        void** slot = EntryPointCache::FindSlot(table, module, id);
+        if (slot) {
+            LOG("ResolveSlot: entry point %u from cache", id);
+            return slot;
+        }
+    }
+    
+    void** slot = dummySlot();
+    if (!slot) return nullptr;
+    
+    // The dummy device loads the module if it was not loaded before
+    if (havePath && !identified && EntryPointCache::IdentifyModule(moduleName, &module)) {
+        table.Load(path);
+        identified = true;
+    }
+    if (identified && EntryPointCache::RememberSlot(table, module, id, slot) && !table.Save(path)) {
+        LOG("ResolveSlot: failed to save %s", path);
+    }
+    return slot;
+}
+
+void** GetPresentSlot() {
+    return ResolveSlot(L"dxgi.dll", EntryPointCache::kDxgiPresentSlot, DummyPresentSlot);
+}
+
+void** GetEndScene9Slot() {
+    return ResolveSlot(L"d3d9.dll", EntryPointCache::kD3D9EndSceneSlot, DummyEndScene9Slot);
+}
+
+// Vtable slot first: one pointer write, no thread suspension. MinHook
+// detour on the function itself if the slot cannot be written.
+static bool HookSlot(VtableSlotHook& hook, void** slot, void* detour, void** original) {
+    if (hook.Install(slot, detour, original)) {
+        LOG("InstallHook: vtable slot %p hooked", slot);
+        return true;
+    }
+    void* target = *slot;
+    if (MH_CreateHook(target, detour, original) != MH_OK) return false;
+    if (MH_EnableHook(target) != MH_OK) {
+        MH_RemoveHook(target);
+        return false;
+    }
+    LOG("InstallHook: inline hook at %p", target);
+    return true;
 }
 
 bool InstallHook() {
     if (g_hooked) return true;
     
-    Log("InstallHook: starting");
+    LOG("InstallHook: starting");
     
     // Try to open shared config
-    if (OpenSharedConfig()) {
-        Log("InstallHook: Shared config opened");
-        
-        // Initialize position from config
-        if (g_pConfig) {
-            if (g_pConfig->position == POS_CUSTOM) {
-                g_currentPosX = g_pConfig->customX;
-                g_currentPosY = g_pConfig->customY;
-            } else {
-                // Use offset from config for default position
-                g_currentPosX = g_pConfig->offsetX;
-                g_currentPosY = g_pConfig->offsetY;
-            }
-        }
+    if (g_sharedConfig.Open()) {
+        LOG("InstallHook: Shared config opened");
+        PollSharedConfig();
     }
     
-    if (MH_Initialize() != MH_OK) { Log("InstallHook: MH_Initialize failed"); return false; }
+    if (MH_Initialize() != MH_OK) { LOG("InstallHook: MH_Initialize failed"); return false; }
     
     bool hooked = false;
     
     // Try DX11 first
     if (GetModuleHandleW(L"d3d11.dll") || GetModuleHandleW(L"dxgi.dll")) {
-        void* presentAddr = GetPresentAddress();
-        if (presentAddr) {
-            Log("InstallHook: DX11 Present at %p", presentAddr);
-            if (MH_CreateHook(presentAddr, &HookedPresent, (void**)&g_originalPresent) == MH_OK) {
-                if (MH_EnableHook(presentAddr) == MH_OK) {
-                    Log("InstallHook: DX11 hook SUCCESS");
-                    hooked = true;
+        void** presentSlot = GetPresentSlot();
+        if (presentSlot) {
+            LOG("InstallHook: DX11 Present at %p", *presentSlot);
+            if (HookSlot(g_presentSlot, presentSlot, (void*)&HookedPresent, (void**)&g_originalPresent)) {
+                LOG("InstallHook: DX11 hook SUCCESS");
+                hooked = true;
+
+                // ResizeBuffers is index 13 of the same vtable (Present is 8)
+                void** resizeBuffersSlot = presentSlot + (13 - 8);
+                if (!HookSlot(g_resizeBuffersSlot, resizeBuffersSlot, (void*)&HookedResizeBuffers,
+                              (void**)&g_originalResizeBuffers)) {
+                    LOG("InstallHook: ResizeBuffers hook failed, relying on back buffer checks");
                 }
             }
         }
@@ -1139,27 +1331,24 @@ bool InstallHook() {
     
     // Try DX9
     if (!hooked && GetModuleHandleW(L"d3d9.dll")) {
-        void* endSceneAddr = GetEndScene9Address();
-        if (endSceneAddr) {
-            Log("InstallHook: DX9 EndScene at %p", endSceneAddr);
-            if (MH_CreateHook(endSceneAddr, &HookedEndScene9, (void**)&g_originalEndScene9) == MH_OK) {
-                if (MH_EnableHook(endSceneAddr) == MH_OK) {
-                    Log("InstallHook: DX9 hook SUCCESS");
-                    g_d3d9Hooked = true;
-                    hooked = true;
-                }
+        void** endSceneSlot = GetEndScene9Slot();
+        if (endSceneSlot) {
+            LOG("InstallHook: DX9 EndScene at %p", *endSceneSlot);
+            if (HookSlot(g_endScene9Slot, endSceneSlot, (void*)&HookedEndScene9, (void**)&g_originalEndScene9)) {
+                LOG("InstallHook: DX9 hook SUCCESS");
+                g_d3d9Hooked = true;
+                hooked = true;
             }
         }
     }
     
     if (!hooked) {
-        Log("InstallHook: No hooks installed");
+        LOG("InstallHook: No hooks installed");
         MH_Uninitialize();
         return false;
     }
     
-    // Start heartbeat thread to detect when monitor exits
-    g_hHeartbeatThread = CreateThread(NULL, 0, HeartbeatThread, NULL, 0, NULL);
+    OpenTelemetry();
     
     g_hooked = true;
     return true;
@@ -1167,7 +1356,6 @@ bool InstallHook() {
 
 static void RemoveHook() {
     if (!g_hooked) return;
-    g_shouldExit = true;
     
     // Just disable rendering - don't unload hooks to avoid crashes
     // The DLL will be unloaded naturally when the process exits
@@ -1175,15 +1363,65 @@ static void RemoveHook() {
     
     // Cleanup GPU resources safely
     CleanupResources();
-    CloseSharedConfig();
-    
-    if (g_pd3dContext) { g_pd3dContext->Release(); g_pd3dContext = nullptr; }
-    if (g_pd3dDevice) { g_pd3dDevice->Release(); g_pd3dDevice = nullptr; }
+    g_sharedConfig.Close();
+    g_telemetry.Close();
     
     // Don't call MH_DisableHook or MH_Uninitialize - causes crashes
     // g_hooked = false;  // Keep as true so we don't try to reinstall
 }
 
+// Binary log per game process: <dll dir>\logs\fps_hook_<pid>.blog (read with log_decoder).
+// Only started once a game is detected, so other GUI processes never touch the disk.
+static void StartLogger() {
+    char path[MAX_PATH] = {0};
+    GetModuleFileNameA(g_hModule, path, MAX_PATH);
+    char* lastSlash = strrchr(path, '\\');
+    if (lastSlash) *(lastSlash + 1) = '\0';
+
+    char logPath[MAX_PATH];
+    sprintf_s(logPath, "%slogs\\fps_hook_%lu.blog", path, GetCurrentProcessId());
+    Logger::InitializePath(logPath, Logger::Mode::Binary);
+}
+
+// Waits for D3D: a known game is checked at once and then every 100 ms for
+// 30 s, anything else once a second for 10 s. The outcome is recorded for
+// the next launch of the same exe.
+static DWORD WINAPI DetectGameThread(LPVOID param) {
+    bool knownGame = (VerdictCache::Verdict)(uintptr_t)param == VerdictCache::kGame;
+    
+    // Excluded processes stop here instead of waiting for D3D. Only a real
+    // Skip is remembered for the next launch; with no monitor or a torn
+    // filter this launch is not hooked, but nothing is learned about the exe
+    ProcessFilter::Verdict filter = DecideProcessFilter();
+    if (filter != ProcessFilter::Verdict::Hook) {
+        if (filter == ProcessFilter::Verdict::Skip) g_verdicts.RecordNeverGame(g_verdictKey);
+        g_verdicts.Close();
+        return 0;
+    }
+    
+    int attempts = knownGame ? 300 : 10;
+    DWORD interval = knownGame ? 100 : 1000;
+    bool detected = false;
+    for (int i = 0; i < attempts; i++) {
+        if (i > 0 || !knownGame) Sleep(interval);
+        if (!g_hooked && IsGraphicsProcess()) {
+            detected = true;
+            StartLogger();
+            LOG("Game detected: %s%s", g_exePath, knownGame ? " (known)" : "");
+            InstallHook();
+            break;
+        }
+    }
+    
+    if (detected) {
+        g_verdicts.RecordGame(g_verdictKey);
+    } else {
+        g_verdicts.RecordMiss(g_verdictKey);
+    }
+    g_verdicts.Close();
+    return 0;
+}
+
 LRESULT CALLBACK CBTProc(int nCode, WPARAM wParam, LPARAM lParam) {
     if (nCode >= 0 && !g_initialized) {
         g_initialized = true;
@@ -1191,20 +1429,16 @@ LRESULT CALLBACK CBTProc(int nCode, WPARAM wParam, LPARAM lParam) {
         QueryPerformanceFrequency(&g_frequency);
         QueryPerformanceCounter(&g_lastDisplayUpdate);
         
-        // Only start monitoring thread for potential game processes
-        CreateThread(NULL, 0, [](LPVOID) -> DWORD {
-            for (int i = 0; i < 10; i++) {
-                Sleep(1000);
-                if (!g_hooked && IsGraphicsProcess()) {
-                    char exeName[MAX_PATH];
-                    GetModuleFileNameA(NULL, exeName, MAX_PATH);
-                    Log("Game detected: %s", exeName);
-                    InstallHook();
-                    break;
-                }
+        // Only start monitoring thread for potential game processes;
+        // known non-games get no thread at all
+        if (LoadExePath()) {
+            VerdictCache::Verdict verdict = LookupVerdict();
+            if (verdict == VerdictCache::kNeverGame) {
+                g_verdicts.Close();
+            } else {
+                CreateThread(NULL, 0, DetectGameThread, (LPVOID)(uintptr_t)verdict, 0, NULL);
             }
-            return 0;
-        }, NULL, 0, NULL);
+        }
     }
     return CallNextHookEx(g_hHook, nCode, wParam, lParam);
 }
@@ -1227,6 +1461,7 @@ BOOL APIENTRY DllMain(HMODULE hModule, DWORD reason, LPVOID lpReserved) {
         break;
     case DLL_PROCESS_DETACH:
         RemoveHook();
+        Logger::Shutdown();
         break;
     }
     return TRUE;
@@ -1,21 +1,25 @@
 #include <Windows.h>
 #include <shellapi.h>
+#include <cstdio>
 #include <string>
 #include <shlobj.h>
 #include "fps_config.h"
+#include "ini_file.h"
+#include "process_filter.h"
+#include "shared_config.h"
+#include "telemetry.h"
+#include "verdict_cache.h"
 
 #pragma comment(lib, "shell32.lib")
 
 typedef HHOOK (*PFN_InstallGlobalHook)();
 typedef void (*PFN_RemoveGlobalHook)();
 
-// Heartbeat for hook cleanup
-#define HEARTBEAT_SHARED_NAME L"FpsOverlayHeartbeat"
-static HANDLE g_hHeartbeat = NULL;
 
 // Menu IDs
 #define WM_TRAYICON (WM_USER + 1)
 #define ID_TRAY_TOGGLE 1001
+#define ID_TRAY_GRAPH 1002
 #define ID_TRAY_POS_TL 1010
 #define ID_TRAY_POS_TR 1011
 #define ID_TRAY_POS_BL 1012
@@ -28,6 +32,9 @@ static HANDLE g_hHeartbeat = NULL;
 #define ID_TRAY_AUTOSTART 1040
 #define ID_TRAY_ABOUT 1050
 #define ID_TRAY_EXIT 1099
+#define ID_TIMER_TELEMETRY 1
+#define ID_TIMER_LEASE 2
+#define TELEMETRY_POLL_MS 500
 
 static HMODULE g_hHookDll64 = NULL;
 static HMODULE g_hHookDll32 = NULL;
@@ -37,9 +44,18 @@ static HWND g_hWnd = NULL;
 static NOTIFYICONDATAW g_nid = {0};
 static bool g_running = true;
 
-// Shared memory for config
-static HANDLE g_hConfigMap = NULL;
-static FpsConfig* g_pConfig = NULL;
+// Monitor's copy of the config; hooks see it through the shared block
+static FpsConfig g_config;
+static SharedConfigWriter g_sharedConfig;
+
+// Which processes the hook attaches to, compiled from [Filter]
+static ProcessFilter::Writer g_processFilter;
+
+// Game / non-game verdicts remembered by the hooks across launches
+static VerdictCache::Table g_verdictCache;
+
+// Frame summaries reported by every hooked game
+static Telemetry::Collector g_telemetry;
 
 // Config file path
 static std::wstring g_configPath;
@@ -52,146 +68,65 @@ std::wstring GetExeDir() {
     return (pos != std::wstring::npos) ? dir.substr(0, pos + 1) : L"";
 }
 
-bool InitSharedConfig() {
-    g_hConfigMap = CreateFileMappingW(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE,
-                                       0, sizeof(FpsConfig), CONFIG_SHARED_NAME);
-    if (!g_hConfigMap) return false;
-    
-    bool isNew = (GetLastError() != ERROR_ALREADY_EXISTS);
-    
-    g_pConfig = (FpsConfig*)MapViewOfFile(g_hConfigMap, FILE_MAP_ALL_ACCESS, 0, 0, sizeof(FpsConfig));
-    if (!g_pConfig) {
-        CloseHandle(g_hConfigMap);
-        return false;
-    }
-    
-    if (isNew) {
-        InitDefaultConfig(g_pConfig);
-    }
+void PublishProcessFilter() {
+    g_processFilter.Publish(g_config.filterMode, g_config.gameList);
     
+    // Verdicts made under other rules are stale (e.g. a newly whitelisted game)
+    uint64_t stamp = 14695981039346656037ull ^ (uint64_t)g_config.filterMode;
+    for (const char* p = g_config.gameList; *p; p++) stamp = (stamp ^ (unsigned char)*p) * 1099511628211ull;
+    g_verdictCache.SetRules(stamp);
+}
+
+bool InitSharedConfig() {
+    if (!g_sharedConfig.Create(g_config)) return false;
+    g_verdictCache.Create();
+    if (g_processFilter.Create()) PublishProcessFilter();
     return true;
 }
 
 void CleanupSharedConfig() {
-    if (g_pConfig) UnmapViewOfFile(g_pConfig);
-    if (g_hConfigMap) CloseHandle(g_hConfigMap);
+    g_processFilter.Close();
+    g_verdictCache.Close();
+    g_sharedConfig.Close();
 }
 
-int GetPrivateProfileIntDefault(const wchar_t* section, const wchar_t* key, int def, const wchar_t* file) {
-    return GetPrivateProfileIntW(section, key, def, file);
-}
+// Whole file from the schema: every stored key, current values
+void WriteConfigFile() {
+    std::string text;
+    ConfigSchema::Write(kFpsConfigSchema, &g_config, text);
 
-DWORD ParseColor(const wchar_t* str) {
-    if (!str || !*str) return 0;
-    return wcstoul(str, NULL, 16);
+    FILE* file = NULL;
+    if (_wfopen_s(&file, g_configPath.c_str(), L"w") != 0 || !file) return;
+    fwrite(text.data(), 1, text.size(), file);
+    fclose(file);
 }
 
 void LoadConfig() {
-    if (!g_pConfig) return;
-    
     g_configPath = GetExeDir() + CONFIG_FILE_NAME;
     
     // Check if file exists
     if (GetFileAttributesW(g_configPath.c_str()) == INVALID_FILE_ATTRIBUTES) {
-        // Create default config file
-        WritePrivateProfileStringW(L"Display", L"Position", L"TopRight", g_configPath.c_str());
-        WritePrivateProfileStringW(L"Display", L"OffsetX", L"10", g_configPath.c_str());
-        WritePrivateProfileStringW(L"Display", L"OffsetY", L"10", g_configPath.c_str());
-        WritePrivateProfileStringW(L"Display", L"FontSize", L"14", g_configPath.c_str());
-        WritePrivateProfileStringW(L"Display", L"ShowBackground", L"true", g_configPath.c_str());
-        
-        WritePrivateProfileStringW(L"Colors", L"HighFPS", L"FF00E070", g_configPath.c_str());
-        WritePrivateProfileStringW(L"Colors", L"MediumFPS", L"FFFFCC00", g_configPath.c_str());
-        WritePrivateProfileStringW(L"Colors", L"LowFPS", L"FFFF4040", g_configPath.c_str());
-        WritePrivateProfileStringW(L"Colors", L"Background", L"B0202020", g_configPath.c_str());
-        
-        WritePrivateProfileStringW(L"Hotkey", L"Toggle", L"F1", g_configPath.c_str());
-        
-        WritePrivateProfileStringW(L"Filter", L"Mode", L"All", g_configPath.c_str());
-        WritePrivateProfileStringW(L"Filter", L"Games", L"", g_configPath.c_str());
-        
+        WriteConfigFile();
         return;
     }
     
-    // Load config
-    wchar_t buf[256];
-    
-    // Position
-    GetPrivateProfileStringW(L"Display", L"Position", L"TopRight", buf, 256, g_configPath.c_str());
-    if (_wcsicmp(buf, L"TopLeft") == 0) g_pConfig->position = POS_TOP_LEFT;
-    else if (_wcsicmp(buf, L"TopRight") == 0) g_pConfig->position = POS_TOP_RIGHT;
-    else if (_wcsicmp(buf, L"BottomLeft") == 0) g_pConfig->position = POS_BOTTOM_LEFT;
-    else if (_wcsicmp(buf, L"BottomRight") == 0) g_pConfig->position = POS_BOTTOM_RIGHT;
-    
-    g_pConfig->offsetX = GetPrivateProfileIntW(L"Display", L"OffsetX", 10, g_configPath.c_str());
-    g_pConfig->offsetY = GetPrivateProfileIntW(L"Display", L"OffsetY", 10, g_configPath.c_str());
-    g_pConfig->fontSize = GetPrivateProfileIntW(L"Display", L"FontSize", 14, g_configPath.c_str());
-    
-    GetPrivateProfileStringW(L"Display", L"ShowBackground", L"true", buf, 256, g_configPath.c_str());
-    g_pConfig->showBackground = (_wcsicmp(buf, L"true") == 0 || _wcsicmp(buf, L"1") == 0);
-    
-    // Colors
-    GetPrivateProfileStringW(L"Colors", L"HighFPS", L"FF00E070", buf, 256, g_configPath.c_str());
-    g_pConfig->colorHigh = ParseColor(buf);
-    GetPrivateProfileStringW(L"Colors", L"MediumFPS", L"FFFFCC00", buf, 256, g_configPath.c_str());
-    g_pConfig->colorMedium = ParseColor(buf);
-    GetPrivateProfileStringW(L"Colors", L"LowFPS", L"FFFF4040", buf, 256, g_configPath.c_str());
-    g_pConfig->colorLow = ParseColor(buf);
-    GetPrivateProfileStringW(L"Colors", L"Background", L"B0202020", buf, 256, g_configPath.c_str());
-    g_pConfig->colorBackground = ParseColor(buf);
-    
-    // Hotkey
-    GetPrivateProfileStringW(L"Hotkey", L"Toggle", L"F1", buf, 256, g_configPath.c_str());
-    if (_wcsicmp(buf, L"F1") == 0) g_pConfig->toggleKey = VK_F1;
-    else if (_wcsicmp(buf, L"F2") == 0) g_pConfig->toggleKey = VK_F2;
-    else if (_wcsicmp(buf, L"F3") == 0) g_pConfig->toggleKey = VK_F3;
-    else if (_wcsicmp(buf, L"F4") == 0) g_pConfig->toggleKey = VK_F4;
-    else if (_wcsicmp(buf, L"F5") == 0) g_pConfig->toggleKey = VK_F5;
-    else if (_wcsicmp(buf, L"F6") == 0) g_pConfig->toggleKey = VK_F6;
-    else if (_wcsicmp(buf, L"F7") == 0) g_pConfig->toggleKey = VK_F7;
-    else if (_wcsicmp(buf, L"F8") == 0) g_pConfig->toggleKey = VK_F8;
-    else if (_wcsicmp(buf, L"F9") == 0) g_pConfig->toggleKey = VK_F9;
-    else if (_wcsicmp(buf, L"F10") == 0) g_pConfig->toggleKey = VK_F10;
-    else if (_wcsicmp(buf, L"F11") == 0) g_pConfig->toggleKey = VK_F11;
-    else if (_wcsicmp(buf, L"F12") == 0) g_pConfig->toggleKey = VK_F12;
-    else g_pConfig->toggleKey = VK_F1;
-    
-    // Filter
-    GetPrivateProfileStringW(L"Filter", L"Mode", L"All", buf, 256, g_configPath.c_str());
-    if (_wcsicmp(buf, L"Whitelist") == 0) g_pConfig->filterMode = FILTER_WHITELIST;
-    else if (_wcsicmp(buf, L"Blacklist") == 0) g_pConfig->filterMode = FILTER_BLACKLIST;
-    else g_pConfig->filterMode = FILTER_ALL;
-    
-    char gameListA[4096];
-    char configPathA[MAX_PATH];
-    WideCharToMultiByte(CP_ACP, 0, g_configPath.c_str(), -1, configPathA, MAX_PATH, NULL, NULL);
-    GetPrivateProfileStringA("Filter", "Games", "", gameListA, 4096, configPathA);
-    strcpy_s(g_pConfig->gameList, gameListA);
+    // Load config: one file read, then one table-driven pass
+    IniFile ini;
+    if (!ini.LoadFile(g_configPath.c_str())) return;
+    ConfigSchema::Apply(kFpsConfigSchema, ini, &g_config);
+    g_sharedConfig.Publish(g_config);
+    PublishProcessFilter();
 }
 
 void SaveConfig() {
-    if (!g_pConfig) return;
-    
-    // Position
-    const wchar_t* posStr[] = {L"TopLeft", L"TopRight", L"BottomLeft", L"BottomRight"};
-    WritePrivateProfileStringW(L"Display", L"Position", posStr[g_pConfig->position], g_configPath.c_str());
-    
-    wchar_t buf[64];
-    swprintf_s(buf, L"%d", g_pConfig->offsetX);
-    WritePrivateProfileStringW(L"Display", L"OffsetX", buf, g_configPath.c_str());
-    swprintf_s(buf, L"%d", g_pConfig->offsetY);
-    WritePrivateProfileStringW(L"Display", L"OffsetY", buf, g_configPath.c_str());
-    swprintf_s(buf, L"%d", g_pConfig->fontSize);
-    WritePrivateProfileStringW(L"Display", L"FontSize", buf, g_configPath.c_str());
+    g_sharedConfig.Publish(g_config);
+    WriteConfigFile();
 }
 
 bool LoadHookDll() {
     std::wstring exeDir = GetExeDir();
     bool anyLoaded = false;
     
-    // Create heartbeat event
-    g_hHeartbeat = CreateEventW(NULL, TRUE, TRUE, HEARTBEAT_SHARED_NAME);
-    
     // Try to load 64-bit DLL
     std::wstring dll64Path = exeDir + L"fps_hook64.dll";
     if (GetFileAttributesW(dll64Path.c_str()) != INVALID_FILE_ATTRIBUTES) {
@@ -240,16 +175,13 @@ bool LoadHookDll() {
 }
 
 void UnloadHookDll() {
-    // Just close heartbeat - DLLs will detect this and stop rendering
+    // Just release the lease - DLLs will detect this on their next frame and stop rendering
     // DO NOT call UnhookWindowsHookEx - it causes DLL unload from all processes = crash!
     // DO NOT call FreeLibrary - same reason
     // The hooks and DLLs will remain active but rendering stops
     // Everything cleans up naturally when game exits
     
-    if (g_hHeartbeat) {
-        CloseHandle(g_hHeartbeat);
-        g_hHeartbeat = NULL;
-    }
+    g_sharedConfig.ReleaseLease();
     
     // Keep hooks installed - don't touch them!
     // g_hHook64 and g_hHook32 stay as-is
@@ -282,6 +214,35 @@ void SetAutoStart(bool enable) {
     RegCloseKey(hKey);
 }
 
+// "Game.exe  144 FPS  p99 9.1 ms  1920x1080"
+static void FormatGameLine(const Telemetry::Collector::Game& game, wchar_t* out, size_t size) {
+    wchar_t exeName[64];
+    if (!MultiByteToWideChar(CP_UTF8, 0, game.exeName, -1, exeName, 64)) exeName[0] = L'\0';
+    swprintf_s(out, size, L"%s  %.0f FPS  p99 %.1f ms  %ux%u", exeName,
+               game.intervalFps, game.p99Ms, game.info.width, game.info.height);
+}
+
+static void UpdateTrayTip() {
+    const auto& games = g_telemetry.Games();
+    if (games.empty()) {
+        wcscpy_s(g_nid.szTip, L"FPS Overlay - Right click for options");
+    } else {
+        // Tooltips are short (128 chars): count plus as many games as fit
+        wchar_t tip[ARRAYSIZE(g_nid.szTip)];
+        swprintf_s(tip, L"FPS Overlay - %zu game(s)", games.size());
+        for (const auto& game : games) {
+            wchar_t line[128];
+            FormatGameLine(*game, line, ARRAYSIZE(line));
+            if (wcslen(tip) + 1 + wcslen(line) >= ARRAYSIZE(tip)) break;
+            wcscat_s(tip, L"\n");
+            wcscat_s(tip, line);
+        }
+        wcscpy_s(g_nid.szTip, tip);
+    }
+    g_nid.uFlags = NIF_TIP;
+    Shell_NotifyIconW(NIM_MODIFY, &g_nid);
+}
+
 void ShowContextMenu(HWND hWnd) {
     POINT pt;
     GetCursorPos(&pt);
@@ -290,21 +251,30 @@ void ShowContextMenu(HWND hWnd) {
     HMENU hPosMenu = CreatePopupMenu();
     HMENU hSizeMenu = CreatePopupMenu();
     
+    // Running games (read-only)
+    for (const auto& game : g_telemetry.Games()) {
+        wchar_t line[128];
+        FormatGameLine(*game, line, ARRAYSIZE(line));
+        AppendMenuW(hMenu, MF_STRING | MF_GRAYED, 0, line);
+    }
+    if (!g_telemetry.Games().empty()) AppendMenuW(hMenu, MF_SEPARATOR, 0, NULL);
+    
     // Toggle
-    AppendMenuW(hMenu, g_pConfig->visible ? MF_CHECKED : MF_UNCHECKED, ID_TRAY_TOGGLE, L"Show FPS");
+    AppendMenuW(hMenu, g_config.visible ? MF_CHECKED : MF_UNCHECKED, ID_TRAY_TOGGLE, L"Show FPS");
+    AppendMenuW(hMenu, g_config.showGraph ? MF_CHECKED : MF_UNCHECKED, ID_TRAY_GRAPH, L"Show Frame Graph");
     AppendMenuW(hMenu, MF_SEPARATOR, 0, NULL);
     
     // Position submenu
-    AppendMenuW(hPosMenu, g_pConfig->position == 0 ? MF_CHECKED : MF_UNCHECKED, ID_TRAY_POS_TL, L"Top Left");
-    AppendMenuW(hPosMenu, g_pConfig->position == 1 ? MF_CHECKED : MF_UNCHECKED, ID_TRAY_POS_TR, L"Top Right");
-    AppendMenuW(hPosMenu, g_pConfig->position == 2 ? MF_CHECKED : MF_UNCHECKED, ID_TRAY_POS_BL, L"Bottom Left");
-    AppendMenuW(hPosMenu, g_pConfig->position == 3 ? MF_CHECKED : MF_UNCHECKED, ID_TRAY_POS_BR, L"Bottom Right");
+    AppendMenuW(hPosMenu, g_config.position == 0 ? MF_CHECKED : MF_UNCHECKED, ID_TRAY_POS_TL, L"Top Left");
+    AppendMenuW(hPosMenu, g_config.position == 1 ? MF_CHECKED : MF_UNCHECKED, ID_TRAY_POS_TR, L"Top Right");
+    AppendMenuW(hPosMenu, g_config.position == 2 ? MF_CHECKED : MF_UNCHECKED, ID_TRAY_POS_BL, L"Bottom Left");
+    AppendMenuW(hPosMenu, g_config.position == 3 ? MF_CHECKED : MF_UNCHECKED, ID_TRAY_POS_BR, L"Bottom Right");
     AppendMenuW(hMenu, MF_POPUP, (UINT_PTR)hPosMenu, L"Position");
     
     // Size submenu
-    AppendMenuW(hSizeMenu, g_pConfig->fontSize == 12 ? MF_CHECKED : MF_UNCHECKED, ID_TRAY_SIZE_S, L"Small");
-    AppendMenuW(hSizeMenu, g_pConfig->fontSize == 14 ? MF_CHECKED : MF_UNCHECKED, ID_TRAY_SIZE_M, L"Medium");
-    AppendMenuW(hSizeMenu, g_pConfig->fontSize == 18 ? MF_CHECKED : MF_UNCHECKED, ID_TRAY_SIZE_L, L"Large");
+    AppendMenuW(hSizeMenu, g_config.fontSize == 12 ? MF_CHECKED : MF_UNCHECKED, ID_TRAY_SIZE_S, L"Small");
+    AppendMenuW(hSizeMenu, g_config.fontSize == 14 ? MF_CHECKED : MF_UNCHECKED, ID_TRAY_SIZE_M, L"Medium");
+    AppendMenuW(hSizeMenu, g_config.fontSize == 18 ? MF_CHECKED : MF_UNCHECKED, ID_TRAY_SIZE_L, L"Large");
     AppendMenuW(hMenu, MF_POPUP, (UINT_PTR)hSizeMenu, L"Size");
     
     AppendMenuW(hMenu, MF_SEPARATOR, 0, NULL);
@@ -332,15 +302,20 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam) {
     case WM_COMMAND:
         switch (LOWORD(wParam)) {
         case ID_TRAY_TOGGLE:
-            g_pConfig->visible = !g_pConfig->visible;
+            g_config.visible = !g_config.visible;
+            g_sharedConfig.Publish(g_config);
+            break;
+        case ID_TRAY_GRAPH:
+            g_config.showGraph = !g_config.showGraph;
+            SaveConfig();
             break;
-        case ID_TRAY_POS_TL: g_pConfig->position = 0; SaveConfig(); break;
-        case ID_TRAY_POS_TR: g_pConfig->position = 1; SaveConfig(); break;
-        case ID_TRAY_POS_BL: g_pConfig->position = 2; SaveConfig(); break;
-        case ID_TRAY_POS_BR: g_pConfig->position = 3; SaveConfig(); break;
-        case ID_TRAY_SIZE_S: g_pConfig->fontSize = 12; SaveConfig(); break;
-        case ID_TRAY_SIZE_M: g_pConfig->fontSize = 14; SaveConfig(); break;
-        case ID_TRAY_SIZE_L: g_pConfig->fontSize = 18; SaveConfig(); break;
+        case ID_TRAY_POS_TL: g_config.position = 0; SaveConfig(); break;
+        case ID_TRAY_POS_TR: g_config.position = 1; SaveConfig(); break;
+        case ID_TRAY_POS_BL: g_config.position = 2; SaveConfig(); break;
+        case ID_TRAY_POS_BR: g_config.position = 3; SaveConfig(); break;
+        case ID_TRAY_SIZE_S: g_config.fontSize = 12; SaveConfig(); break;
+        case ID_TRAY_SIZE_M: g_config.fontSize = 14; SaveConfig(); break;
+        case ID_TRAY_SIZE_L: g_config.fontSize = 18; SaveConfig(); break;
         case ID_TRAY_EDIT_CONFIG:
             ShellExecuteW(NULL, L"open", g_configPath.c_str(), NULL, NULL, SW_SHOW);
             break;
@@ -362,6 +337,15 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam) {
         }
         return 0;
         
+    case WM_TIMER:
+        if (wParam == ID_TIMER_TELEMETRY) {
+            g_telemetry.Poll();
+            UpdateTrayTip();
+        } else if (wParam == ID_TIMER_LEASE) {
+            g_sharedConfig.RenewLease();
+        }
+        return 0;
+        
     case WM_DESTROY:
         g_running = false;
         Shell_NotifyIconW(NIM_DELETE, &g_nid);
@@ -389,6 +373,9 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE, LPSTR, int) {
     // Load config
     LoadConfig();
     
+    // Registry must exist before games start reporting
+    g_telemetry.Create();
+    
     // Load hook
     if (!LoadHookDll()) {
         CleanupSharedConfig();
@@ -416,6 +403,9 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE, LPSTR, int) {
     wcscpy_s(g_nid.szTip, L"FPS Overlay - Right click for options");
     Shell_NotifyIconW(NIM_ADD, &g_nid);
     
+    SetTimer(g_hWnd, ID_TIMER_LEASE, SharedConfigBlock::kLeaseRenewMs, NULL);
+    SetTimer(g_hWnd, ID_TIMER_TELEMETRY, TELEMETRY_POLL_MS, NULL);
+    
     // Message loop
     MSG msg;
     while (GetMessage(&msg, NULL, 0, 0)) {
@@ -425,6 +415,7 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE, LPSTR, int) {
     
     // Cleanup
     UnloadHookDll();
+    g_telemetry.Close();
     CleanupSharedConfig();
     CloseHandle(hMutex);
     
@@ -0,0 +1,486 @@
+#include "process_filter.h"
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "fps_config.h"
+
+namespace ProcessFilter {
+    namespace {
+        // Shell, services and our own tools: never hooked
+        const char* const kSystemNames[] = {
+            "fps_monitor.exe",
+            "conhost.exe",
+            "explorer.exe",
+            "dwm.exe",
+            "csrss.exe",
+            "svchost.exe",
+            "SearchHost.exe",
+            "ShellExperienceHost.exe",
+            "StartMenuExperienceHost.exe",
+            "RuntimeBroker.exe",
+            "TextInputHost.exe",
+            "taskhostw.exe",
+            "ctfmon.exe",
+            "cleanmgr.exe",
+            "taskmgr.exe",
+            "cmd.exe",
+            "powershell.exe",
+            "WindowsTerminal.exe",
+            "OneDrive.exe",
+            "OneDriveStandaloneUpdater.exe",
+            "browser.exe",
+            "BackgroundDownload.exe",
+            "ApplicationFrameHost.exe",
+            "SystemSettings.exe",
+            "SettingsHelper.exe",
+            "sihost.exe",
+            "fontdrvhost.exe",
+            "WmiPrvSE.exe",
+            "dllhost.exe",
+            "CompPkgSrv.exe",
+            "SearchIndexer.exe",
+            "SecurityHealthService.exe",
+            "MsMpEng.exe",
+            "NisSrv.exe",
+            "smartscreen.exe",
+            "spoolsv.exe",
+            "services.exe",
+            "lsass.exe",
+            "wininit.exe",
+            "winlogon.exe",
+        };
+
+        const char* const kSystemPaths[] = {
+            "\\windows\\",
+            "\\microsoft\\",
+            "\\onedrive\\",
+            "\\system32\\",
+            "\\syswow64\\",
+            "program files",
+            "visual studio",
+            "\\appdata\\",
+        };
+
+        struct Header {
+            uint32_t magic;
+            uint32_t version;
+            uint32_t size;
+            uint32_t mode;
+            uint64_t seed;
+            uint32_t bucketCount;
+            uint32_t tableSize;             // Power of two
+            uint32_t displacementOffset;    // uint16_t[bucketCount]
+            uint32_t entryOffset;           // Entry[tableSize]
+            uint32_t nameOffset;            // Folded names, not terminated
+            uint32_t nameBytes;
+            uint32_t classCount;
+            uint32_t stateCount;
+            uint32_t classOffset;           // uint8_t[256]
+            uint32_t transitionOffset;      // uint32_t[stateCount * classCount]: flags << 24 | target row
+            uint32_t reserved[2];
+        };
+
+        struct Entry {
+            uint32_t nameOffset;
+            uint16_t nameLength;            // 0 = empty slot
+            uint8_t flags;
+            uint8_t reserved;
+        };
+
+        struct Rule {
+            std::string text;               // Folded
+            uint8_t flags;
+        };
+
+        constexpr uint64_t kFnvBasis = 14695981039346656037ull;
+        constexpr uint64_t kFnvPrime = 1099511628211ull;
+        constexpr uint64_t kGolden = 0x9E3779B97F4A7C15ull;
+        constexpr uint32_t kMaxDisplacement = 0xFFFF;
+        constexpr uint32_t kMaxStates = 0xFFFF;
+        constexpr uint32_t kRowMask = 0x00FFFFFF;     // 0xFFFF states * 256 classes fits
+        constexpr int kSeedAttempts = 16;
+
+        inline unsigned char Fold(unsigned char c) {
+            if (c >= 'A' && c <= 'Z') return static_cast<unsigned char>(c + ('a' - 'A'));
+            if (c == '/') return '\\';
+            return c;
+        }
+
+        inline uint64_t HashStep(uint64_t h, unsigned char c) { return (h ^ c) * kFnvPrime; }
+
+        inline uint32_t BucketOf(uint64_t h, uint32_t bucketCount) {
+            return static_cast<uint32_t>(((h >> 32) * bucketCount) >> 32);
+        }
+
+        inline uint32_t SlotOf(uint64_t h, uint32_t displacement, uint32_t tableSize) {
+            uint64_t x = h ^ (displacement * kGolden);
+            x ^= x >> 33;
+            x *= 0xFF51AFD7ED558CCDull;
+            x ^= x >> 33;
+            return static_cast<uint32_t>(x) & (tableSize - 1);
+        }
+
+        uint64_t HashName(const std::string& name, uint64_t seed) {
+            uint64_t h = kFnvBasis ^ seed;
+            for (unsigned char c : name) h = HashStep(h, c);
+            return h;
+        }
+
+        std::string FoldString(const char* begin, const char* end) {
+            std::string folded;
+            for (const char* p = begin; p < end; p++) folded.push_back(static_cast<char>(Fold(static_cast<unsigned char>(*p))));
+            return folded;
+        }
+
+        void AddRule(std::vector<Rule>& rules, std::string text, uint8_t flags) {
+            for (Rule& rule : rules) {
+                if (rule.text == text) {
+                    rule.flags |= flags;
+                    return;
+                }
+            }
+            rules.push_back({ std::move(text), flags });
+        }
+
+        // One list entry: a path fragment if it has a separator, else an exe name
+        void AddEntry(std::vector<Rule>& names, std::vector<Rule>& paths, const char* begin, const char* end, uint8_t flags) {
+            while (begin < end && (*begin == ' ' || *begin == '\t')) begin++;
+            while (end > begin && (end[-1] == ' ' || end[-1] == '\t' || end[-1] == '\r' || end[-1] == '\n')) end--;
+            if (begin == end) return;
+            std::string folded = FoldString(begin, end);
+            bool isPath = folded.find('\\') != std::string::npos;
+            AddRule(isPath ? paths : names, std::move(folded), flags);
+        }
+
+        // Semicolons per the config comment; commas accepted as well
+        void AddList(std::vector<Rule>& names, std::vector<Rule>& paths, const char* list, uint8_t flags) {
+            if (!list) return;
+            const char* begin = list;
+            for (const char* p = list;; p++) {
+                if (*p == ';' || *p == ',' || *p == '\0') {
+                    AddEntry(names, paths, begin, p, flags);
+                    if (*p == '\0') break;
+                    begin = p + 1;
+                }
+            }
+        }
+
+        // Hash-and-displace: buckets by the top hash bits, largest first; each
+        // bucket searches a displacement that puts all its names in free slots
+        bool BuildPerfectHash(const std::vector<Rule>& names, uint64_t seed, uint32_t bucketCount, uint32_t tableSize,
+                              std::vector<uint16_t>& displacements, std::vector<int>& slots) {
+            std::vector<uint64_t> hashes(names.size());
+            std::vector<std::vector<int>> buckets(bucketCount);
+            for (size_t i = 0; i < names.size(); i++) {
+                hashes[i] = HashName(names[i].text, seed);
+                buckets[BucketOf(hashes[i], bucketCount)].push_back(static_cast<int>(i));
+            }
+
+            std::vector<uint32_t> order(bucketCount);
+            for (uint32_t i = 0; i < bucketCount; i++) order[i] = i;
+            std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+                return buckets[a].size() > buckets[b].size();
+            });
+
+            displacements.assign(bucketCount, 0);
+            slots.assign(tableSize, -1);
+            std::vector<uint32_t> candidate;
+            for (uint32_t bucket : order) {
+                const std::vector<int>& members = buckets[bucket];
+                if (members.empty()) break;
+                bool placed = false;
+                for (uint32_t d = 0; d <= kMaxDisplacement && !placed; d++) {
+                    candidate.clear();
+                    placed = true;
+                    for (int member : members) {
+                        uint32_t slot = SlotOf(hashes[member], d, tableSize);
+                        if (slots[slot] >= 0 || std::find(candidate.begin(), candidate.end(), slot) != candidate.end()) {
+                            placed = false;
+                            break;
+                        }
+                        candidate.push_back(slot);
+                    }
+                    if (placed) {
+                        for (size_t i = 0; i < members.size(); i++) slots[candidate[i]] = members[i];
+                        displacements[bucket] = static_cast<uint16_t>(d);
+                    }
+                }
+                if (!placed) return false;
+            }
+            return true;
+        }
+
+        // Aho-Corasick goto/fail links resolved into a full DFA; a state's
+        // flags include those of every pattern that ends there via fail links.
+        // Transitions hold the target's row offset (no multiply while
+        // matching) and the target's flags in the top byte.
+        bool BuildAutomaton(const std::vector<Rule>& paths, uint8_t (&classes)[256], uint32_t& classCount,
+                            uint32_t& stateCount, std::vector<uint32_t>& transitions) {
+            std::vector<uint8_t> stateFlags;
+            std::memset(classes, 0, sizeof(classes));
+            classCount = 1;
+            for (const Rule& rule : paths) {
+                for (unsigned char c : rule.text) {
+                    if (!classes[c]) classes[c] = static_cast<uint8_t>(classCount++);
+                }
+            }
+
+            std::vector<int> next(classCount, -1);
+            stateFlags.assign(1, 0);
+            for (const Rule& rule : paths) {
+                size_t state = 0;
+                for (unsigned char c : rule.text) {
+                    int& target = next[state * classCount + classes[c]];
+                    if (target < 0) {
+                        if (stateFlags.size() >= kMaxStates) return false;
+                        target = static_cast<int>(stateFlags.size());
+                        stateFlags.push_back(0);
+                        next.resize(stateFlags.size() * classCount, -1);
+                    }
+                    state = static_cast<size_t>(next[state * classCount + classes[c]]);
+                }
+                stateFlags[state] |= rule.flags;
+            }
+
+            stateCount = static_cast<uint32_t>(stateFlags.size());
+            std::vector<uint32_t> fail(stateCount, 0);
+            std::vector<uint32_t> queue;
+            queue.reserve(stateCount);
+            for (uint32_t c = 0; c < classCount; c++) {
+                int& target = next[c];
+                if (target < 0) {
+                    target = 0;
+                } else {
+                    queue.push_back(static_cast<uint32_t>(target));
+                }
+            }
+            // BFS order: a state's fail target is always finished before it
+            for (size_t head = 0; head < queue.size(); head++) {
+                uint32_t state = queue[head];
+                stateFlags[state] |= stateFlags[fail[state]];
+                for (uint32_t c = 0; c < classCount; c++) {
+                    int& target = next[state * classCount + c];
+                    int fallback = next[fail[state] * classCount + c];
+                    if (target < 0) {
+                        target = fallback;
+                    } else {
+                        fail[target] = static_cast<uint32_t>(fallback);
+                        queue.push_back(static_cast<uint32_t>(target));
+                    }
+                }
+            }
+
+            transitions.resize(next.size());
+            for (size_t i = 0; i < next.size(); i++) {
+                uint32_t target = static_cast<uint32_t>(next[i]);
+                transitions[i] = static_cast<uint32_t>(stateFlags[target]) << 24 | target * classCount;
+            }
+            return true;
+        }
+
+        size_t Append(std::vector<unsigned char>& blob, const void* data, size_t bytes) {
+            size_t offset = (blob.size() + 7) & ~static_cast<size_t>(7);
+            blob.resize(offset + bytes);
+            if (bytes) std::memcpy(blob.data() + offset, data, bytes);
+            return offset;
+        }
+
+        inline bool Fits(uint32_t offset, uint64_t bytes, uint32_t alignment, uint32_t size) {
+            return offset % alignment == 0 && offset <= size && bytes <= size - offset;
+        }
+    }
+
+    bool Build(int filterMode, const char* gameList, unsigned char* out, size_t capacity, size_t* size) {
+        std::vector<Rule> names, paths;
+        for (const char* name : kSystemNames) AddEntry(names, paths, name, name + std::strlen(name), kRuleSystem);
+        for (const char* path : kSystemPaths) AddRule(paths, FoldString(path, path + std::strlen(path)), kRuleSystem);
+        AddList(names, paths, gameList, kRuleListed);
+
+        // Load factor 1/3 to 2/3; ~2 names per bucket
+        uint32_t tableSize = 2;
+        while (tableSize < names.size() + names.size() / 2) tableSize <<= 1;
+        uint32_t bucketCount = static_cast<uint32_t>(names.size() / 2) + 1;
+
+        uint64_t seed = 0;
+        std::vector<uint16_t> displacements;
+        std::vector<int> slots;
+        for (int attempt = 0;; attempt++) {
+            seed = attempt * kGolden;
+            if (BuildPerfectHash(names, seed, bucketCount, tableSize, displacements, slots)) break;
+            if (attempt + 1 == kSeedAttempts) {
+                // Unlucky (or 64-bit collision): more room and start over
+                if (tableSize >= (1u << 20)) return false;
+                tableSize <<= 1;
+                attempt = -1;
+            }
+        }
+
+        std::string nameBytes;
+        std::vector<Entry> entries(tableSize, Entry{ 0, 0, 0, 0 });
+        for (uint32_t slot = 0; slot < tableSize; slot++) {
+            if (slots[slot] < 0) continue;
+            const Rule& rule = names[slots[slot]];
+            entries[slot].nameOffset = static_cast<uint32_t>(nameBytes.size());
+            entries[slot].nameLength = static_cast<uint16_t>(std::min<size_t>(rule.text.size(), 0xFFFF));
+            entries[slot].flags = rule.flags;
+            nameBytes += rule.text;
+        }
+
+        uint8_t classes[256];
+        uint32_t classCount = 0, stateCount = 0;
+        std::vector<uint32_t> transitions;
+        if (!BuildAutomaton(paths, classes, classCount, stateCount, transitions)) return false;
+
+        Header header = {};
+        std::vector<unsigned char> blob;
+        Append(blob, &header, sizeof(header));
+        header.magic = kMagic;
+        header.version = kVersion;
+        header.mode = static_cast<uint32_t>(filterMode);
+        header.seed = seed;
+        header.bucketCount = bucketCount;
+        header.tableSize = tableSize;
+        header.displacementOffset = static_cast<uint32_t>(Append(blob, displacements.data(), displacements.size() * sizeof(uint16_t)));
+        header.entryOffset = static_cast<uint32_t>(Append(blob, entries.data(), entries.size() * sizeof(Entry)));
+        header.nameOffset = static_cast<uint32_t>(Append(blob, nameBytes.data(), nameBytes.size()));
+        header.nameBytes = static_cast<uint32_t>(nameBytes.size());
+        header.classCount = classCount;
+        header.stateCount = stateCount;
+        header.classOffset = static_cast<uint32_t>(Append(blob, classes, sizeof(classes)));
+        header.transitionOffset = static_cast<uint32_t>(Append(blob, transitions.data(), transitions.size() * sizeof(uint32_t)));
+        header.size = static_cast<uint32_t>(blob.size());
+
+        if (blob.size() > capacity) return false;
+        std::memcpy(blob.data(), &header, sizeof(header));
+        std::memcpy(out, blob.data(), blob.size());
+        if (size) *size = blob.size();
+        return true;
+    }
+
+    Verdict Match(const unsigned char* blob, size_t size, const char* path, size_t length) {
+        if (size < sizeof(Header)) return Verdict::Invalid;
+        Header header;
+        std::memcpy(&header, blob, sizeof(header));
+        if (header.magic != kMagic || header.version != kVersion || header.size > size) return Verdict::Invalid;
+        if (header.tableSize == 0 || (header.tableSize & (header.tableSize - 1)) || header.bucketCount == 0 ||
+            header.classCount == 0 || header.classCount > 256 || header.stateCount == 0) {
+            return Verdict::Invalid;
+        }
+        if (!Fits(header.displacementOffset, uint64_t(header.bucketCount) * sizeof(uint16_t), alignof(uint16_t), header.size) ||
+            !Fits(header.entryOffset, uint64_t(header.tableSize) * sizeof(Entry), alignof(Entry), header.size) ||
+            !Fits(header.nameOffset, header.nameBytes, 1, header.size) ||
+            !Fits(header.classOffset, 256, 1, header.size) ||
+            !Fits(header.transitionOffset, uint64_t(header.stateCount) * header.classCount * sizeof(uint32_t), alignof(uint32_t), header.size)) {
+            return Verdict::Invalid;
+        }
+
+        const uint16_t* displacements = reinterpret_cast<const uint16_t*>(blob + header.displacementOffset);
+        const Entry* entries = reinterpret_cast<const Entry*>(blob + header.entryOffset);
+        const unsigned char* names = blob + header.nameOffset;
+        const uint8_t* classes = blob + header.classOffset;
+        const uint32_t* transitions = reinterpret_cast<const uint32_t*>(blob + header.transitionOffset);
+        const uint32_t rowLimit = header.stateCount * header.classCount;
+
+        // One pass: DFA over the whole path, hash restarted at every separator
+        const uint64_t basis = kFnvBasis ^ header.seed;
+        uint64_t hash = basis;
+        size_t nameStart = 0;
+        uint32_t row = 0;
+        uint32_t flagBits = 0;
+        for (size_t i = 0; i < length; i++) {
+            unsigned char c = Fold(static_cast<unsigned char>(path[i]));
+            uint8_t cls = classes[c];
+            uint32_t index = row + cls;
+            if (cls >= header.classCount || index >= rowLimit) return Verdict::Invalid;
+            uint32_t transition = transitions[index];
+            row = transition & kRowMask;
+            flagBits |= transition;
+            if (c == '\\') {
+                hash = basis;
+                nameStart = i + 1;
+            } else {
+                hash = HashStep(hash, c);
+            }
+        }
+
+        uint8_t flags = static_cast<uint8_t>(flagBits >> 24);
+        size_t nameLength = length - nameStart;
+        if (nameLength > 0) {
+            uint32_t displacement = displacements[BucketOf(hash, header.bucketCount)];
+            const Entry& entry = entries[SlotOf(hash, displacement, header.tableSize)];
+            if (entry.nameLength == nameLength && uint64_t(entry.nameOffset) + nameLength <= header.nameBytes) {
+                const unsigned char* name = names + entry.nameOffset;
+                size_t i = 0;
+                while (i < nameLength && name[i] == Fold(static_cast<unsigned char>(path[nameStart + i]))) i++;
+                if (i == nameLength) flags |= entry.flags;
+            }
+        }
+
+        switch (header.mode) {
+        case FILTER_WHITELIST: return (flags & kRuleListed) ? Verdict::Hook : Verdict::Skip;
+        case FILTER_BLACKLIST: return flags ? Verdict::Skip : Verdict::Hook;
+        default:               return (flags & kRuleSystem) ? Verdict::Skip : Verdict::Hook;
+        }
+    }
+
+    // ---- Writer ----
+
+    bool Writer::Create() {
+        bool created = false;
+        if (!m_memory.Create(PROCESS_FILTER_SHARED_NAME, sizeof(Block), &created)) return false;
+        m_block = static_cast<Block*>(m_memory.Data());
+
+        if (created || m_block->magic != kMagic || m_block->version != kVersion || m_block->size != sizeof(Block)) {
+            m_block->sequence.store(0, std::memory_order_relaxed);
+            m_block->active.store(0, std::memory_order_relaxed);
+            m_block->magic = kMagic;
+            m_block->version = kVersion;
+            m_block->size = sizeof(Block);
+            Publish(FILTER_ALL, "");
+        }
+        return true;
+    }
+
+    bool Writer::Publish(int filterMode, const char* gameList) {
+        if (!m_block) return false;
+        uint32_t idle = 1 - (m_block->active.load(std::memory_order_relaxed) & 1);
+        uint32_t seq = m_block->sequence.load(std::memory_order_relaxed);
+        m_block->sequence.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        unsigned char* slot = m_block->slots[idle];
+        bool fits = Build(filterMode, gameList, slot, kCapacity, nullptr);
+        if (!fits) Build(filterMode, "", slot, kCapacity, nullptr);
+
+        m_block->active.store(idle, std::memory_order_release);
+        m_block->sequence.store(seq + 2, std::memory_order_release);
+        return fits;
+    }
+
+    // ---- Reader ----
+
+    bool Reader::Open() {
+        if (!m_memory.Open(PROCESS_FILTER_SHARED_NAME, sizeof(Block), false)) return false;
+        m_block = static_cast<const Block*>(m_memory.Data());
+        if (m_block->magic != kMagic || m_block->version != kVersion || m_block->size != sizeof(Block)) {
+            Close();
+            return false;
+        }
+        return true;
+    }
+
+    Verdict Reader::Decide(const char* path, size_t length) const {
+        if (!m_block) return Verdict::Invalid;
+        for (int attempt = 0; attempt < 4; attempt++) {
+            uint32_t seq = m_block->sequence.load(std::memory_order_acquire);
+            uint32_t active = m_block->active.load(std::memory_order_acquire) & 1;
+            Verdict verdict = Match(m_block->slots[active], kCapacity, path, length);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            uint32_t now = m_block->sequence.load(std::memory_order_relaxed);
+            // A write that only started meanwhile went to the other slot
+            if (now == seq || (!(seq & 1) && now == seq + 1)) return verdict;
+        }
+        return Verdict::Invalid;
+    }
+}
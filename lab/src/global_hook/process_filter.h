@@ -0,0 +1,89 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include "shared_memory.h"
+
+// Which processes the global hook attaches to.
+//
+// fps_monitor compiles the built-in system exclusions and the [Filter] list
+// of fps_config.ini into a compact blob that uses offsets only, so it works
+// at any mapping address:
+//   - exe names (case-folded) in a perfect-hash table: hash-and-displace, one
+//     probe and one compare per lookup;
+//   - path fragments in an Aho-Corasick automaton, stored as a full DFA over
+//     byte classes (bytes that appear in no pattern share class 0).
+// The hook folds its own path once and walks it through the DFA while
+// hashing the last component, so the whole decision is one pass over the
+// path with no allocation.
+//
+// List entries containing '\' or '/' are path fragments, the others exe file
+// names. Matching is ASCII case-insensitive and treats '/' as '\'.
+//
+// The segment holds two blob slots: the monitor writes the idle one and then
+// flips, so a hook only retries if two rebuilds overlap its match.
+#define PROCESS_FILTER_SHARED_NAME "FpsOverlayFilter.v1"
+
+namespace ProcessFilter {
+    constexpr uint32_t kMagic = 0x544C4946;     // "FILT"
+    constexpr uint32_t kVersion = 1;
+    constexpr size_t kCapacity = 32 * 1024;     // Per blob slot
+
+    enum RuleFlags : uint8_t {
+        kRuleSystem = 1,        // Built-in exclusion
+        kRuleListed = 2,        // From the user's game list
+    };
+
+    enum class Verdict {
+        Hook,
+        Skip,
+        Invalid,                // Blob failed validation (torn or corrupt)
+    };
+
+    // Builds a blob for filterMode (FilterMode in fps_config.h) and the
+    // semicolon-separated game list. Fails if the result exceeds capacity.
+    bool Build(int filterMode, const char* gameList, unsigned char* out, size_t capacity, size_t* size);
+
+    // Every offset and state index is checked, so a torn blob yields Invalid
+    // rather than an out-of-bounds read
+    Verdict Match(const unsigned char* blob, size_t size, const char* path, size_t length);
+
+    struct Block {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t size;
+        std::atomic<uint32_t> sequence;     // Odd while the monitor writes the idle slot
+        std::atomic<uint32_t> active;       // Slot hooks read
+        alignas(64) unsigned char slots[2][kCapacity];
+    };
+
+    // Monitor side
+    class Writer {
+    public:
+        bool Create();
+        void Close() { m_memory.Close(); m_block = nullptr; }
+
+        // Rebuilds from the config; if the list does not fit, publishes the
+        // built-in rules only and returns false
+        bool Publish(int filterMode, const char* gameList);
+
+    private:
+        SharedMemory m_memory;
+        Block* m_block = nullptr;
+    };
+
+    // Hook side
+    class Reader {
+    public:
+        bool Open();
+        void Close() { m_memory.Close(); m_block = nullptr; }
+
+        // path: UTF-8 full path of the process image
+        Verdict Decide(const char* path, size_t length) const;
+
+    private:
+        SharedMemory m_memory;
+        const Block* m_block = nullptr;
+    };
+}
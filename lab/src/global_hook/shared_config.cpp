@@ -0,0 +1,93 @@
+#include "shared_config.h"
+#include <cstring>
+
+namespace {
+    bool IsValid(const SharedConfigBlock* block) {
+        return block->magic == SharedConfigBlock::kMagic &&
+               block->version == SharedConfigBlock::kVersion &&
+               block->size == sizeof(SharedConfigBlock);
+    }
+}
+
+bool SharedConfigWriter::Create(FpsConfig& config) {
+    bool created = false;
+    if (!m_memory.Create(CONFIG_SHARED_NAME, sizeof(SharedConfigBlock), &created)) return false;
+    m_block = static_cast<SharedConfigBlock*>(m_memory.Data());
+
+    if (!created && IsValid(m_block)) {
+        // Single writer: a leftover block is quiescent, no retry loop needed
+        std::memcpy(&config, &m_block->config, sizeof(FpsConfig));
+        RenewLease();
+        return true;
+    }
+
+    std::memcpy(&m_block->config, &config, sizeof(FpsConfig));
+    m_block->magic = SharedConfigBlock::kMagic;
+    m_block->version = SharedConfigBlock::kVersion;
+    m_block->size = sizeof(SharedConfigBlock);
+    m_block->leaseEpoch.store(1, std::memory_order_relaxed);
+    // Even and non-zero: readers start at 0 and pick this up on the first poll
+    m_block->sequence.store(2, std::memory_order_release);
+    return true;
+}
+
+void SharedConfigWriter::Publish(const FpsConfig& config) {
+    if (!m_block) return;
+    uint32_t seq = m_block->sequence.load(std::memory_order_relaxed);
+    m_block->sequence.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    std::memcpy(&m_block->config, &config, sizeof(FpsConfig));
+    m_block->sequence.store(seq + 2, std::memory_order_release);
+}
+
+void SharedConfigWriter::RenewLease() {
+    if (!m_block) return;
+    uint32_t epoch = m_block->leaseEpoch.load(std::memory_order_relaxed) + 1;
+    if (epoch == SharedConfigBlock::kLeaseReleased) epoch++;
+    m_block->leaseEpoch.store(epoch, std::memory_order_relaxed);
+}
+
+void SharedConfigWriter::ReleaseLease() {
+    if (!m_block) return;
+    m_block->leaseEpoch.store(SharedConfigBlock::kLeaseReleased, std::memory_order_relaxed);
+}
+
+bool SharedConfigReader::Open() {
+    if (!m_memory.Open(CONFIG_SHARED_NAME, sizeof(SharedConfigBlock), false)) return false;
+    m_block = static_cast<const SharedConfigBlock*>(m_memory.Data());
+    if (!IsValid(m_block)) {
+        Close();
+        return false;
+    }
+    m_seen = 0;
+    m_leaseEpoch = SharedConfigBlock::kLeaseReleased;
+    return true;
+}
+
+bool SharedConfigReader::Poll(FpsConfig& config) {
+    if (!m_block) return false;
+    uint32_t seq = m_block->sequence.load(std::memory_order_acquire);
+    if (seq == m_seen || (seq & 1)) return false;
+
+    FpsConfigHot copy;
+    std::memcpy(&copy, reinterpret_cast<const unsigned char*>(&m_block->config), kFpsConfigHotSize);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (m_block->sequence.load(std::memory_order_relaxed) != seq) return false;
+
+    ApplyHotFields(copy, config);
+    m_seen = seq;
+    return true;
+}
+
+bool SharedConfigReader::HoldsLease(uint64_t now, uint64_t timeout) {
+    if (!m_block) return false;
+    uint32_t epoch = m_block->leaseEpoch.load(std::memory_order_relaxed);
+    if (epoch == SharedConfigBlock::kLeaseReleased) return false;
+    if (epoch != m_leaseEpoch) {
+        // Renewed since the last check (or first check): restart the timeout
+        m_leaseEpoch = epoch;
+        m_leaseSeenAt = now;
+        return true;
+    }
+    return now - m_leaseSeenAt < timeout;
+}
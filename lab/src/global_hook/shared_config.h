@@ -0,0 +1,84 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include "fps_config.h"
+#include "shared_memory.h"
+
+// The FpsConfig block shared by fps_monitor (only writer) and every hooked
+// game (readers, one per process).
+//
+// Line 0 is a header: magic, layout version, block size, a seqlock
+// sequence number (odd while the monitor is writing) and the monitor's lease
+// epoch. The config follows on
+// its own cache lines, hot fields first. Readers check the sequence once per
+// frame and copy the hot line only when it moved; a copy that overlapped a
+// write is discarded and retried on the next frame, so a reader never spins.
+//
+// Liveness: the monitor bumps the lease epoch every kLeaseRenewMs and sets it
+// to kLeaseReleased on exit. Hooks check it on the Present path with one
+// relaxed load: a released lease is noticed on the next frame, a monitor that
+// died without releasing it once the epoch has not moved for kLeaseTimeoutMs.
+//
+// The segment name carries the layout version: hooks built against an older
+// layout simply do not find it.
+#define CONFIG_SHARED_NAME "FpsOverlayConfig.v3"
+
+struct SharedConfigBlock {
+    static constexpr uint32_t kMagic = 0x43535046;     // "FPSC"
+    static constexpr uint32_t kVersion = 3;
+    static constexpr uint32_t kLeaseReleased = 0;
+    static constexpr uint32_t kLeaseRenewMs = 500;
+    static constexpr uint32_t kLeaseTimeoutMs = 2000;
+
+    uint32_t magic;
+    uint32_t version;
+    uint32_t size;
+    std::atomic<uint32_t> sequence;
+    std::atomic<uint32_t> leaseEpoch;
+    alignas(64) FpsConfig config;
+};
+
+static_assert(std::atomic<uint32_t>::is_always_lock_free, "sequence must be usable across processes");
+static_assert(offsetof(SharedConfigBlock, config) == 64, "config must start on its own cache line");
+
+// Monitor side
+class SharedConfigWriter {
+public:
+    // Creates the block, or attaches to one left alive by running hooks; in
+    // that case config receives the values the hooks are currently using
+    bool Create(FpsConfig& config);
+    void Publish(const FpsConfig& config);
+
+    // Call every kLeaseRenewMs; Release tells hooks the monitor is gone
+    void RenewLease();
+    void ReleaseLease();
+    void Close() { m_memory.Close(); m_block = nullptr; }
+
+private:
+    SharedMemory m_memory;
+    SharedConfigBlock* m_block = nullptr;
+};
+
+// Hook side
+class SharedConfigReader {
+public:
+    bool Open();
+    void Close() { m_memory.Close(); m_block = nullptr; m_seen = 0; m_leaseEpoch = SharedConfigBlock::kLeaseReleased; }
+    bool IsOpen() const { return m_block != nullptr; }
+
+    // Copies the hot fields into config if the monitor published since the
+    // last successful poll. One acquire load when nothing changed.
+    bool Poll(FpsConfig& config);
+
+    // False once the monitor released its lease or stopped renewing it for
+    // timeout. now/timeout are in any monotonic unit (QPC ticks in the hook).
+    bool HoldsLease(uint64_t now, uint64_t timeout);
+
+private:
+    SharedMemory m_memory;
+    const SharedConfigBlock* m_block = nullptr;
+    uint32_t m_seen = 0;
+    uint32_t m_leaseEpoch = SharedConfigBlock::kLeaseReleased;
+    uint64_t m_leaseSeenAt = 0;
+};
@@ -0,0 +1,136 @@
+#include "shared_memory.h"
+#include <cstdio>
+#include <cstring>
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+
+namespace {
+    void WideName(const char* name, wchar_t (&out)[64]) {
+        size_t i = 0;
+        for (; name[i] && i < 63; i++) out[i] = static_cast<wchar_t>(static_cast<unsigned char>(name[i]));
+        out[i] = L'\0';
+    }
+}
+
+bool SharedMemory::Create(const char* name, size_t size, bool* created) {
+    Close();
+    wchar_t wideName[64];
+    WideName(name, wideName);
+
+    HANDLE handle = CreateFileMappingW(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE,
+                                       0, static_cast<DWORD>(size), wideName);
+    if (!handle) return false;
+    bool isNew = GetLastError() != ERROR_ALREADY_EXISTS;
+
+    void* data = MapViewOfFile(handle, FILE_MAP_ALL_ACCESS, 0, 0, size);
+    if (!data) {
+        CloseHandle(handle);
+        return false;
+    }
+    m_handle = handle;
+    m_data = data;
+    m_size = size;
+    if (created) *created = isNew;
+    return true;
+}
+
+bool SharedMemory::Open(const char* name, size_t size, bool writable) {
+    Close();
+    wchar_t wideName[64];
+    WideName(name, wideName);
+
+    DWORD access = writable ? FILE_MAP_READ | FILE_MAP_WRITE : FILE_MAP_READ;
+    HANDLE handle = OpenFileMappingW(access, FALSE, wideName);
+    if (!handle) return false;
+
+    void* data = MapViewOfFile(handle, access, 0, 0, size);
+    if (!data) {
+        CloseHandle(handle);
+        return false;
+    }
+    m_handle = handle;
+    m_data = data;
+    m_size = size;
+    return true;
+}
+
+void SharedMemory::Close() {
+    if (m_data) UnmapViewOfFile(m_data);
+    if (m_handle) CloseHandle(m_handle);
+    m_data = nullptr;
+    m_handle = nullptr;
+    m_size = 0;
+}
+
+#else
+
+namespace {
+    void PosixName(const char* name, char (&out)[64]) {
+        std::snprintf(out, sizeof(out), "/%s", name);
+    }
+}
+
+bool SharedMemory::Create(const char* name, size_t size, bool* created) {
+    Close();
+    char posixName[64];
+    PosixName(name, posixName);
+
+    bool isNew = true;
+    int fd = shm_open(posixName, O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (fd < 0 && errno == EEXIST) {
+        isNew = false;
+        fd = shm_open(posixName, O_RDWR, 0600);
+    }
+    if (fd < 0) return false;
+    if (isNew && ftruncate(fd, static_cast<off_t>(size)) != 0) {
+        close(fd);
+        shm_unlink(posixName);
+        return false;
+    }
+
+    void* data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        if (isNew) shm_unlink(posixName);
+        return false;
+    }
+    m_data = data;
+    m_size = size;
+    if (isNew) std::memcpy(m_name, posixName, sizeof(m_name));
+    if (created) *created = isNew;
+    return true;
+}
+
+bool SharedMemory::Open(const char* name, size_t size, bool writable) {
+    Close();
+    char posixName[64];
+    PosixName(name, posixName);
+
+    int fd = shm_open(posixName, writable ? O_RDWR : O_RDONLY, 0);
+    if (fd < 0) return false;
+    void* data = mmap(nullptr, size, writable ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) return false;
+    m_data = data;
+    m_size = size;
+    return true;
+}
+
+void SharedMemory::Close() {
+    if (m_data) munmap(m_data, m_size);
+    if (m_name[0]) shm_unlink(m_name);
+    m_data = nullptr;
+    m_size = 0;
+    m_name[0] = '\0';
+}
+
+#endif
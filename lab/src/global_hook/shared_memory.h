@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstddef>
+
+// Named shared memory segment: CreateFileMapping on Windows, shm_open + mmap
+// elsewhere (Linux builds exist only to stress-test the shared layouts).
+//
+// Names are ASCII without slashes. On POSIX the creator unlinks the name on
+// Close; on Windows the segment lives until the last handle is closed.
+class SharedMemory {
+public:
+    SharedMemory() = default;
+    ~SharedMemory() { Close(); }
+    SharedMemory(const SharedMemory&) = delete;
+    SharedMemory& operator=(const SharedMemory&) = delete;
+
+    // Creates the segment, or opens it if it already exists (*created = false).
+    // New segments are zero-filled.
+    bool Create(const char* name, size_t size, bool* created = nullptr);
+    bool Open(const char* name, size_t size, bool writable);
+    void Close();
+
+    void* Data() const { return m_data; }
+    size_t Size() const { return m_size; }
+    bool IsOpen() const { return m_data != nullptr; }
+
+private:
+    void* m_data = nullptr;
+    size_t m_size = 0;
+#ifdef _WIN32
+    void* m_handle = nullptr;
+#else
+    char m_name[64] = {0};     // Set when this object created (and will unlink) the segment
+#endif
+};
@@ -0,0 +1,259 @@
+#include "telemetry.h"
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <cerrno>
+#include <signal.h>
+#endif
+
+namespace Telemetry {
+    namespace {
+        void SegmentName(uint32_t pid, char (&out)[64]) {
+            std::snprintf(out, sizeof(out), "%s%u", TELEMETRY_SEGMENT_PREFIX, pid);
+        }
+
+        bool IsValid(const Registry* registry) {
+            return registry->magic == kMagic && registry->version == kVersion;
+        }
+    }
+
+    bool IsProcessAlive(uint32_t pid) {
+#ifdef _WIN32
+        HANDLE process = OpenProcess(SYNCHRONIZE, FALSE, pid);
+        if (!process) return GetLastError() == ERROR_ACCESS_DENIED;
+        bool alive = WaitForSingleObject(process, 0) == WAIT_TIMEOUT;
+        CloseHandle(process);
+        return alive;
+#else
+        return kill(static_cast<pid_t>(pid), 0) == 0 || errno == EPERM;
+#endif
+    }
+
+    // ---- Producer ----
+
+    bool Producer::Open(uint32_t pid, const char* exeName, uint64_t ticksPerSecond, uint64_t sessionId) {
+        Close();
+        if (!m_registryMemory.Open(TELEMETRY_REGISTRY_NAME, sizeof(Registry), true)) return false;
+        m_registry = static_cast<Registry*>(m_registryMemory.Data());
+        if (!IsValid(m_registry)) {
+            Close();
+            return false;
+        }
+
+        char name[64];
+        SegmentName(pid, name);
+        if (!m_segmentMemory.Create(name, sizeof(Segment))) {
+            Close();
+            return false;
+        }
+        m_segment = static_cast<Segment*>(m_segmentMemory.Data());
+
+        // A slot already holding this pid was left by an earlier process with
+        // the same pid that crashed before the collector reclaimed it (the
+        // pid is alive again, so it never will). Release it: the segment is
+        // ours from here on, and a second slot would list the game twice
+        for (uint32_t i = 0; i < kMaxGames; i++) {
+            uint32_t expected = pid;
+            if (m_registry->pids[i].compare_exchange_strong(expected, 0, std::memory_order_acq_rel)) {
+                m_registry->generation.fetch_add(1, std::memory_order_release);
+            }
+        }
+
+        // A leftover segment for this pid (crashed process) is reset as a whole
+        m_segment->magic = kMagic;
+        m_segment->version = kVersion;
+        m_segment->pid = pid;
+        m_segment->ringSize = kRingSize;
+        m_segment->ticksPerSecond = ticksPerSecond;
+        m_segment->sessionId = sessionId;
+        std::snprintf(m_segment->exeName, sizeof(m_segment->exeName), "%s", exeName ? exeName : "");
+        m_segment->infoSequence.store(0, std::memory_order_relaxed);
+        m_segment->info = SwapchainInfo{};
+        m_segment->writeIndex.store(0, std::memory_order_relaxed);
+        m_segment->dropped.store(0, std::memory_order_relaxed);
+        m_segment->readIndex.store(0, std::memory_order_relaxed);
+        m_write = 0;
+
+        // The claim publishes everything above to the collector
+        for (uint32_t i = 0; i < kMaxGames; i++) {
+            uint32_t expected = 0;
+            if (m_registry->pids[i].compare_exchange_strong(expected, pid, std::memory_order_acq_rel)) {
+                m_slot = static_cast<int>(i);
+                break;
+            }
+        }
+        if (m_slot < 0) {
+            Close();
+            return false;
+        }
+        m_registry->generation.fetch_add(1, std::memory_order_release);
+        return true;
+    }
+
+    void Producer::Close() {
+        if (m_registry && m_slot >= 0) {
+            m_registry->pids[m_slot].store(0, std::memory_order_release);
+            m_registry->generation.fetch_add(1, std::memory_order_release);
+        }
+        m_slot = -1;
+        m_segment = nullptr;
+        m_registry = nullptr;
+        m_segmentMemory.Close();
+        m_registryMemory.Close();
+    }
+
+    void Producer::SetSwapchain(const SwapchainInfo& info) {
+        if (!m_segment) return;
+        uint32_t seq = m_segment->infoSequence.load(std::memory_order_relaxed);
+        m_segment->infoSequence.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        m_segment->info = info;
+        m_segment->infoSequence.store(seq + 2, std::memory_order_release);
+    }
+
+    void Producer::Push(uint64_t ticks, float frameMs, uint32_t syncInterval) {
+        if (!m_segment) return;
+        uint64_t read = m_segment->readIndex.load(std::memory_order_acquire);
+        if (m_write - read >= kRingSize) {
+            // Only this thread writes the counter
+            m_segment->dropped.store(m_segment->dropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            return;
+        }
+        m_segment->ring[m_write & (kRingSize - 1)] = FrameSummary{ ticks, frameMs, syncInterval };
+        m_write++;
+        m_segment->writeIndex.store(m_write, std::memory_order_release);
+    }
+
+    // ---- Collector ----
+
+    bool Collector::Create() {
+        Close();
+        bool created = false;
+        if (!m_registryMemory.Create(TELEMETRY_REGISTRY_NAME, sizeof(Registry), &created)) return false;
+        m_registry = static_cast<Registry*>(m_registryMemory.Data());
+
+        // Reuse a registry kept alive by running games (monitor restart)
+        if (created || !IsValid(m_registry)) {
+            for (uint32_t i = 0; i < kMaxGames; i++) m_registry->pids[i].store(0, std::memory_order_relaxed);
+            m_registry->generation.store(0, std::memory_order_relaxed);
+            m_registry->version = kVersion;
+            m_registry->magic = kMagic;
+            std::atomic_thread_fence(std::memory_order_release);
+        }
+        m_generation = m_registry->generation.load(std::memory_order_acquire) - 1;     // Force the first scan
+        return true;
+    }
+
+    void Collector::Close() {
+        m_games.clear();
+        m_registry = nullptr;
+        m_registryMemory.Close();
+    }
+
+    void Collector::SyncRegistry() {
+        // Reclaim slots of games that exited without releasing them
+        for (size_t i = 0; i < m_games.size();) {
+            Game& game = *m_games[i];
+            if (IsProcessAlive(game.pid)) {
+                i++;
+                continue;
+            }
+            uint32_t expected = game.pid;
+            if (m_registry->pids[game.slot].compare_exchange_strong(expected, 0, std::memory_order_acq_rel)) {
+                m_registry->generation.fetch_add(1, std::memory_order_release);
+            }
+            m_games.erase(m_games.begin() + static_cast<ptrdiff_t>(i));
+        }
+
+        uint32_t generation = m_registry->generation.load(std::memory_order_acquire);
+        if (generation == m_generation) return;
+        m_generation = generation;
+
+        std::unique_ptr<Game> bySlot[kMaxGames];
+        for (auto& game : m_games) bySlot[game->slot] = std::move(game);
+        m_games.clear();
+
+        for (uint32_t slot = 0; slot < kMaxGames; slot++) {
+            uint32_t pid = m_registry->pids[slot].load(std::memory_order_acquire);
+            std::unique_ptr<Game>& game = bySlot[slot];
+            if (pid == 0) continue;
+
+            if (game && game->pid == pid && game->segment->sessionId == game->sessionId) {
+                m_games.push_back(std::move(game));
+                continue;
+            }
+
+            auto fresh = std::make_unique<Game>();
+            char name[64];
+            SegmentName(pid, name);
+            if (!fresh->memory.Open(name, sizeof(Segment), true)) {
+                if (!IsProcessAlive(pid)) {
+                    uint32_t expected = pid;
+                    if (m_registry->pids[slot].compare_exchange_strong(expected, 0, std::memory_order_acq_rel)) {
+                        m_generation = m_registry->generation.fetch_add(1, std::memory_order_release) + 1;
+                    }
+                }
+                continue;
+            }
+            Segment* segment = static_cast<Segment*>(fresh->memory.Data());
+            if (segment->magic != kMagic || segment->version != kVersion || segment->pid != pid) continue;
+
+            fresh->pid = pid;
+            fresh->sessionId = segment->sessionId;
+            std::memcpy(fresh->exeName, segment->exeName, sizeof(fresh->exeName));
+            fresh->exeName[sizeof(fresh->exeName) - 1] = '\0';
+            fresh->segment = segment;
+            fresh->slot = static_cast<int>(slot);
+            m_games.push_back(std::move(fresh));
+        }
+    }
+
+    void Collector::Drain(Game& game) {
+        Segment* segment = game.segment;
+
+        // Swapchain info: a few tries, keep the old value if the game keeps resizing
+        for (int attempt = 0; attempt < 4; attempt++) {
+            uint32_t seq = segment->infoSequence.load(std::memory_order_acquire);
+            if (seq & 1) continue;
+            SwapchainInfo info = segment->info;
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (segment->infoSequence.load(std::memory_order_relaxed) == seq) {
+                game.info = info;
+                break;
+            }
+        }
+
+        uint64_t read = segment->readIndex.load(std::memory_order_relaxed);
+        uint64_t write = segment->writeIndex.load(std::memory_order_acquire);
+        if (write - read > kRingSize) read = write - kRingSize;     // Corrupt indices: keep the newest
+
+        m_interval.Clear();
+        double sumMs = 0.0;
+        for (uint64_t i = read; i < write; i++) {
+            const FrameSummary& frame = segment->ring[i & (kRingSize - 1)];
+            m_interval.Add(frame.frameMs);
+            game.session.Add(frame.frameMs);
+            sumMs += frame.frameMs;
+        }
+        segment->readIndex.store(write, std::memory_order_release);
+
+        uint32_t count = static_cast<uint32_t>(write - read);
+        game.frames += count;
+        game.dropped = segment->dropped.load(std::memory_order_relaxed);
+        game.intervalFrames = count;
+        game.intervalFps = sumMs > 0.0 ? count * 1000.0 / sumMs : 0.0;
+        game.p50Ms = count ? m_interval.Quantile(0.5) : 0.0;
+        game.p99Ms = count ? m_interval.Quantile(0.99) : 0.0;
+        game.maxMs = count ? m_interval.Max() : 0.0;
+    }
+
+    void Collector::Poll() {
+        if (!m_registry) return;
+        SyncRegistry();
+        for (auto& game : m_games) Drain(*game);
+    }
+}
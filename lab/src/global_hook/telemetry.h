@@ -0,0 +1,154 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "quantile_sketch.h"
+#include "shared_memory.h"
+
+// Telemetry from every hooked game back to fps_monitor.
+//
+// Each game owns one segment (TELEMETRY_SEGMENT_PREFIX + pid): identity
+// (pid, exe name, clock rate), swapchain info behind a small seqlock, and a
+// single-producer/single-consumer ring of per-frame summaries. The producer
+// (the game's render thread) never blocks or spins: when the ring is full
+// the frame is counted as dropped. Producer and consumer indices live on
+// separate cache lines.
+//
+// The monitor creates a registry segment with one slot per live game; a game
+// claims a slot with a CAS of its pid and bumps the registry generation, so
+// the monitor rescans only when something changed. Slots of processes that
+// died without releasing them are reclaimed by the monitor, or by the next
+// game that opens with the same pid if that comes first.
+#define TELEMETRY_REGISTRY_NAME "FpsOverlayTelemetry.v1"
+#define TELEMETRY_SEGMENT_PREFIX "FpsOverlayTelemetry.v1."
+
+namespace Telemetry {
+    constexpr uint32_t kMagic = 0x4D4C5446;     // "FTLM"
+    constexpr uint32_t kVersion = 1;
+    constexpr uint32_t kRingSize = 1024;        // Frames; ~250 ms at 4000 FPS
+    constexpr uint32_t kMaxGames = 128;
+
+    enum class Api : uint32_t {
+        Unknown = 0,
+        D3D9 = 1,
+        D3D11 = 2,
+        D3D12 = 3,
+    };
+
+    struct FrameSummary {
+        uint64_t ticks;             // Present time, producer clock (Segment::ticksPerSecond)
+        float frameMs;
+        uint32_t syncInterval;
+    };
+
+    struct SwapchainInfo {
+        Api api;
+        uint32_t width;
+        uint32_t height;
+        uint32_t format;            // DXGI_FORMAT / D3DFORMAT
+    };
+
+    struct Segment {
+        // Written once before the registry slot is claimed
+        uint32_t magic;
+        uint32_t version;
+        uint32_t pid;
+        uint32_t ringSize;
+        uint64_t ticksPerSecond;
+        uint64_t sessionId;         // Distinguishes a reused pid
+        char exeName[64];           // UTF-8, file name only
+
+        alignas(64) std::atomic<uint32_t> infoSequence;    // Odd while the producer writes info
+        SwapchainInfo info;
+
+        alignas(64) std::atomic<uint64_t> writeIndex;      // Producer line
+        std::atomic<uint64_t> dropped;
+
+        alignas(64) std::atomic<uint64_t> readIndex;       // Consumer line
+
+        alignas(64) FrameSummary ring[kRingSize];
+    };
+
+    struct Registry {
+        uint32_t magic;
+        uint32_t version;
+        std::atomic<uint32_t> generation;                  // Bumped on every claim/release
+        alignas(64) std::atomic<uint32_t> pids[kMaxGames]; // 0 = free
+    };
+
+    static_assert(std::atomic<uint64_t>::is_always_lock_free, "ring indices must be usable across processes");
+    static_assert((kRingSize & (kRingSize - 1)) == 0, "kRingSize must be a power of two");
+
+    bool IsProcessAlive(uint32_t pid);
+
+    // Game side; all calls from the render thread except Close
+    class Producer {
+    public:
+        ~Producer() { Close(); }
+
+        // Needs the monitor's registry; false (and inactive) without it
+        bool Open(uint32_t pid, const char* exeName, uint64_t ticksPerSecond, uint64_t sessionId);
+        void Close();
+        bool IsOpen() const { return m_segment != nullptr; }
+
+        void SetSwapchain(const SwapchainInfo& info);
+
+        // Wait-free; drops the frame if the monitor fell behind
+        void Push(uint64_t ticks, float frameMs, uint32_t syncInterval);
+
+    private:
+        SharedMemory m_segmentMemory;
+        SharedMemory m_registryMemory;
+        Segment* m_segment = nullptr;
+        Registry* m_registry = nullptr;
+        int m_slot = -1;
+        uint64_t m_write = 0;
+    };
+
+    // Monitor side
+    class Collector {
+    public:
+        struct Game {
+            uint32_t pid = 0;
+            uint64_t sessionId = 0;
+            char exeName[64] = {0};
+            SwapchainInfo info = {};
+            uint64_t frames = 0;        // Since the game registered
+            uint64_t dropped = 0;
+            // Last Poll interval
+            uint32_t intervalFrames = 0;
+            double intervalFps = 0.0;
+            double p50Ms = 0.0;
+            double p99Ms = 0.0;
+            double maxMs = 0.0;
+            QuantileSketch session;     // All frame times since the game registered
+
+            SharedMemory memory;
+            Segment* segment = nullptr;
+            int slot = -1;
+        };
+
+        ~Collector() { Close(); }
+
+        bool Create();
+        void Close();
+
+        // Syncs with the registry (cheap when its generation did not move),
+        // reclaims dead games and drains every ring
+        void Poll();
+
+        const std::vector<std::unique_ptr<Game>>& Games() const { return m_games; }
+
+    private:
+        void SyncRegistry();
+        void Drain(Game& game);
+
+        SharedMemory m_registryMemory;
+        Registry* m_registry = nullptr;
+        uint32_t m_generation = 0;
+        std::vector<std::unique_ptr<Game>> m_games;
+        QuantileSketch m_interval;
+    };
+}
@@ -0,0 +1,137 @@
+#include "verdict_cache.h"
+
+namespace VerdictCache {
+    namespace {
+        // Word: key (bits 4-63) | misses (bits 2-3) | verdict (bits 0-1)
+        constexpr uint64_t kKeyMask = ~uint64_t(0xF);
+        constexpr int kMissShift = 2;
+        constexpr uint64_t kMissMask = uint64_t(3) << kMissShift;
+        constexpr uint64_t kVerdictMask = 3;
+
+        inline Verdict VerdictOf(uint64_t word) { return static_cast<Verdict>(word & kVerdictMask); }
+        inline uint32_t MissesOf(uint64_t word) { return static_cast<uint32_t>((word & kMissMask) >> kMissShift); }
+
+        inline uint64_t MakeWord(uint64_t key, uint32_t misses, Verdict verdict) {
+            return (key & kKeyMask) | (uint64_t(misses) << kMissShift) | verdict;
+        }
+
+        inline uint64_t Mix(uint64_t x) {
+            x ^= x >> 33;
+            x *= 0xFF51AFD7ED558CCDull;
+            x ^= x >> 33;
+            x *= 0xC4CEB9FE1A85EC53ull;
+            x ^= x >> 33;
+            return x;
+        }
+
+        inline uint32_t HomeSlot(uint64_t key) {
+            return static_cast<uint32_t>(key >> 4) & (kSlots - 1);
+        }
+
+        bool IsValid(const Block* block) {
+            return block->magic == kMagic && block->version == kVersion &&
+                   block->size == sizeof(Block) && block->slotCount == kSlots;
+        }
+    }
+
+    uint64_t MakeKey(const char* path, size_t length, const FileIdentity& identity) {
+        uint64_t h = 14695981039346656037ull;
+        for (size_t i = 0; i < length; i++) {
+            unsigned char c = static_cast<unsigned char>(path[i]);
+            if (c >= 'A' && c <= 'Z') c = static_cast<unsigned char>(c + ('a' - 'A'));
+            else if (c == '/') c = '\\';
+            h = (h ^ c) * 1099511628211ull;
+        }
+        h = Mix(h ^ identity.volume);
+        h = Mix(h ^ identity.fileIndex);
+        h = Mix(h ^ identity.size);
+        h = Mix(h ^ identity.lastWrite);
+        return h | (uint64_t(1) << 63);
+    }
+
+    bool Table::Create() {
+        bool created = false;
+        if (!m_memory.Create(VERDICT_CACHE_SHARED_NAME, sizeof(Block), &created)) return false;
+        m_block = static_cast<Block*>(m_memory.Data());
+        if (!created && !IsValid(m_block)) {
+            Clear();
+        }
+        m_block->size = sizeof(Block);
+        m_block->slotCount = kSlots;
+        m_block->version = kVersion;
+        m_block->magic = kMagic;
+        return true;
+    }
+
+    bool Table::Open() {
+        if (!m_memory.Open(VERDICT_CACHE_SHARED_NAME, sizeof(Block), true)) return false;
+        m_block = static_cast<Block*>(m_memory.Data());
+        if (!IsValid(m_block)) {
+            Close();
+            return false;
+        }
+        return true;
+    }
+
+    void Table::SetRules(uint64_t rulesStamp) {
+        if (!m_block || m_block->rulesStamp == rulesStamp) return;
+        Clear();
+        m_block->rulesStamp = rulesStamp;
+    }
+
+    void Table::Clear() {
+        if (!m_block) return;
+        for (uint32_t i = 0; i < kSlots; i++) m_block->slots[i].store(0, std::memory_order_relaxed);
+    }
+
+    Verdict Table::Lookup(uint64_t key) const {
+        if (!m_block) return kUnknown;
+        uint32_t slot = HomeSlot(key);
+        for (uint32_t probe = 0; probe < kMaxProbe; probe++, slot = (slot + 1) & (kSlots - 1)) {
+            uint64_t word = m_block->slots[slot].load(std::memory_order_acquire);
+            if (word == 0) return kUnknown;
+            if ((word & kKeyMask) == (key & kKeyMask)) return VerdictOf(word);
+        }
+        return kUnknown;
+    }
+
+    // Claims the key's slot (CAS on an empty word) or CAS-updates the word
+    // already holding it; the first empty slot in the probe run is the only
+    // place a key can be inserted, so a key never occupies two slots
+    template <typename Update>
+    Verdict Table::Record(uint64_t key, Update update) {
+        if (!m_block) return kUnknown;
+        uint32_t slot = HomeSlot(key);
+        for (uint32_t probe = 0; probe < kMaxProbe; probe++, slot = (slot + 1) & (kSlots - 1)) {
+            std::atomic<uint64_t>& cell = m_block->slots[slot];
+            uint64_t word = cell.load(std::memory_order_acquire);
+            for (;;) {
+                if (word != 0 && (word & kKeyMask) != (key & kKeyMask)) break;      // Other key: next slot
+                uint64_t desired = update(word == 0 ? MakeWord(key, 0, kUndecided) : word);
+                if (desired == word) return VerdictOf(word);
+                if (cell.compare_exchange_weak(word, desired, std::memory_order_acq_rel, std::memory_order_acquire)) {
+                    return VerdictOf(desired);
+                }
+                // word reloaded: retry unless another key took the slot
+            }
+        }
+        return kUnknown;
+    }
+
+    Verdict Table::RecordGame(uint64_t key) {
+        return Record(key, [key](uint64_t) { return MakeWord(key, 0, kGame); });
+    }
+
+    Verdict Table::RecordMiss(uint64_t key) {
+        return Record(key, [key](uint64_t word) {
+            Verdict verdict = VerdictOf(word);
+            if (verdict == kGame || verdict == kNeverGame) return word;
+            uint32_t misses = MissesOf(word) + 1;
+            return misses >= kMaxMisses ? MakeWord(key, 0, kNeverGame) : MakeWord(key, misses, kUndecided);
+        });
+    }
+
+    Verdict Table::RecordNeverGame(uint64_t key) {
+        return Record(key, [key](uint64_t) { return MakeWord(key, 0, kNeverGame); });
+    }
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include "shared_memory.h"
+
+// Game detection results shared by every process the global hook reaches.
+//
+// Keyed by a hash of the (case-folded) exe path and the file's identity
+// (volume, file index, size, last write), so a patched exe starts over. Each
+// slot is one 64-bit word: key bits, a miss counter and the verdict, updated
+// with CAS only; open addressing with linear probing, no deletion. fps_monitor
+// creates the table and clears it when the filter rules change (a stamp of the
+// rules is kept in the header, so a plain config reload keeps the verdicts).
+//
+// A known game skips the slow detection loop; a never-game skips the
+// detection thread entirely. An exe becomes a never-game after kMaxMisses
+// launches without D3D, or at once when the filter rejects it. A game is
+// never demoted by misses (launchers, crash handlers sharing the exe).
+#define VERDICT_CACHE_SHARED_NAME "FpsOverlayVerdicts.v1"
+
+namespace VerdictCache {
+    constexpr uint32_t kMagic = 0x54434456;     // "VDCT"
+    constexpr uint32_t kVersion = 1;
+    constexpr uint32_t kSlots = 8192;           // 64 KB
+    constexpr uint32_t kMaxProbe = 32;
+    constexpr uint32_t kMaxMisses = 3;
+
+    enum Verdict : uint32_t {
+        kUnknown = 0,           // Not in the table (or table unavailable)
+        kUndecided = 1,
+        kGame = 2,
+        kNeverGame = 3,
+    };
+
+    struct FileIdentity {
+        uint64_t volume;
+        uint64_t fileIndex;
+        uint64_t size;
+        uint64_t lastWrite;
+    };
+
+    struct Block {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t size;
+        uint32_t slotCount;
+        uint64_t rulesStamp;                                    // Written by the monitor only
+        alignas(64) std::atomic<uint64_t> slots[kSlots];      // 0 = empty
+    };
+
+    static_assert(std::atomic<uint64_t>::is_always_lock_free, "slots must be usable across processes");
+    static_assert((kSlots & (kSlots - 1)) == 0, "kSlots must be a power of two");
+
+    // Never 0; path bytes are folded like ProcessFilter (ASCII case, '/' = '\')
+    uint64_t MakeKey(const char* path, size_t length, const FileIdentity& identity);
+
+    class Table {
+    public:
+        bool Create();      // Monitor; clears a table left by an older layout
+        bool Open();        // Hook; writable
+        void Close() { m_memory.Close(); m_block = nullptr; }
+        bool IsOpen() const { return m_block != nullptr; }
+
+        Verdict Lookup(uint64_t key) const;
+
+        // Each returns the verdict now stored (kUnknown if the table is full)
+        Verdict RecordGame(uint64_t key);
+        Verdict RecordMiss(uint64_t key);
+        Verdict RecordNeverGame(uint64_t key);
+
+        // Monitor only: clears the table if it was filled under other
+        // rules. Racing records may be lost, never corrupted.
+        void SetRules(uint64_t rulesStamp);
+        void Clear();
+
+    private:
+        template <typename Update>
+        Verdict Record(uint64_t key, Update update);
+
+        SharedMemory m_memory;
+        Block* m_block = nullptr;
+    };
+}
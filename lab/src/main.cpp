@@ -7,6 +7,8 @@
 #include <vector>
 #include <set>
 #include "overlay_window.h"
+#include "process_enum.h"
+#include "process_events.h"
 
 #pragma comment(lib, "psapi.lib")
 
@@ -15,28 +17,34 @@
 #define ID_TRAY_CONFIG 1002
 #define ID_TRAY_TOGGLE 1003
 
-// Log file for debugging
-static std::wstring g_logPath;
+// Log file for debugging (opened once, flushed per line)
+static FILE* g_logFile = nullptr;
+static CRITICAL_SECTION g_logLock;
+static INIT_ONCE g_logInit = INIT_ONCE_STATIC_INIT;
+
+static BOOL CALLBACK InitLog(PINIT_ONCE, PVOID, PVOID*) {
+    InitializeCriticalSection(&g_logLock);
+    
+    wchar_t path[MAX_PATH];
+    GetModuleFileNameW(nullptr, path, MAX_PATH);
+    std::wstring logPath = path;
+    logPath = logPath.substr(0, logPath.rfind(L'\\') + 1) + L"fps_monitor.log";
+    _wfopen_s(&g_logFile, logPath.c_str(), L"w");
+    return TRUE;
+}
 
 void Log(const wchar_t* fmt, ...) {
-    if (g_logPath.empty()) {
-        wchar_t path[MAX_PATH];
-        GetModuleFileNameW(nullptr, path, MAX_PATH);
-        g_logPath = path;
-        g_logPath = g_logPath.substr(0, g_logPath.rfind(L'\\') + 1) + L"fps_monitor.log";
-        DeleteFileW(g_logPath.c_str());
-    }
+    InitOnceExecuteOnce(&g_logInit, InitLog, nullptr, nullptr);
+    if (!g_logFile) return;
     
-    FILE* f = nullptr;
-    _wfopen_s(&f, g_logPath.c_str(), L"a");
-    if (f) {
-        va_list args;
-        va_start(args, fmt);
-        vfwprintf(f, fmt, args);
-        fwprintf(f, L"\n");
-        fclose(f);
-        va_end(args);
-    }
+    EnterCriticalSection(&g_logLock);
+    va_list args;
+    va_start(args, fmt);
+    vfwprintf(g_logFile, fmt, args);
+    va_end(args);
+    fwprintf(g_logFile, L"\n");
+    fflush(g_logFile);
+    LeaveCriticalSection(&g_logLock);
 }
 
 struct AppState {
@@ -53,6 +61,8 @@ struct AppState {
     DWORD targetPid = 0;
     bool overlayVisible = true;
     std::wstring currentGame;
+    
+    ProcessEvents processEvents;
 };
 
 static AppState g_app;
@@ -131,6 +141,19 @@ DWORD FindProcessByName(const wchar_t* processName) {
     return pid;
 }
 
+// Exe name of a just-started process is one of the configured games
+bool IsConfiguredGame(DWORD pid) {
+    std::string name;
+    if (!ProcessSnapshot::NameOf(pid, name)) return false;
+    wchar_t wideName[MAX_PATH];
+    int chars = MultiByteToWideChar(CP_UTF8, 0, name.c_str(), -1, wideName, MAX_PATH);
+    if (chars <= 0) return false;
+    for (const auto& game : g_app.games) {
+        if (_wcsicmp(game.c_str(), wideName) == 0) return true;
+    }
+    return false;
+}
+
 struct EnumWindowData {
     DWORD pid;
     HWND hWnd;
@@ -236,9 +259,20 @@ DWORD WINAPI MonitorThread(LPVOID param) {
     Log(L"MonitorThread started");
     std::set<DWORD> monitoredPids;
     
+    // Game starts and exits arrive as events; without start events (not
+    // elevated) fall back to scanning every 500 ms
+    ProcessEvents& events = g_app.processEvents;
+    events.Start();
+    bool eventDriven = events.HasStartEvents();
+    Log(L"Process start events: %s", eventDriven ? L"on" : L"off, polling");
+    std::vector<ProcessEvents::Event> pending;
+    bool rescan = true;
+    
     while (g_app.running) {
         // Check for games
-        for (const auto& game : g_app.games) {
+        bool retry = false;
+        for (size_t g = 0; rescan && g < g_app.games.size(); g++) {
+            const std::wstring& game = g_app.games[g];
             DWORD pid = FindProcessByName(game.c_str());
             
             if (pid != 0 && monitoredPids.find(pid) == monitoredPids.end()) {
@@ -253,51 +287,47 @@ DWORD WINAPI MonitorThread(LPVOID param) {
                     if (gameWindow) {
                         StartMonitoring(pid, gameWindow, game);
                         monitoredPids.insert(pid);
+                        if (!events.Watch(pid)) Log(L"Could not watch PID %d for exit", pid);
                         ShowNotification(L"FPS Monitor", 
                             (game + L" - Monitoring started").c_str());
                     } else {
                         Log(L"Could not find game window for PID %d", pid);
+                        retry = true;
                     }
                 }
             }
         }
         
+        rescan = retry || !eventDriven;
+        
         // Update overlay position
         if (g_app.overlay && g_app.targetGameWindow) {
             if (!IsWindow(g_app.targetGameWindow)) {
                 Log(L"Game window closed");
                 StopMonitoring();
                 monitoredPids.clear();
+                rescan = true;
             } else {
                 g_app.overlay->UpdatePosition();
             }
         }
         
-        // Clean up closed processes
-        std::set<DWORD> activePids;
-        for (DWORD pid : monitoredPids) {
-            HANDLE h = OpenProcess(PROCESS_QUERY_LIMITED_INFORMATION, FALSE, pid);
-            if (h) {
-                DWORD exitCode;
-                if (GetExitCodeProcess(h, &exitCode) && exitCode == STILL_ACTIVE) {
-                    activePids.insert(pid);
-                }
-                CloseHandle(h);
+        // Wake for events; only the overlay, a game without a window yet
+        // or polling needs a period
+        bool periodic = g_app.overlay || rescan;
+        events.Wait(periodic ? 500 : INFINITE, pending);
+        for (const auto& event : pending) {
+            if (event.kind == ProcessEvents::Kind::Exited) {
+                // Clean up closed processes
+                if (monitoredPids.erase(event.pid)) Log(L"Process closed: PID %d", event.pid);
+                if (g_app.targetPid == event.pid) StopMonitoring();
+            } else if (event.pid == 0 || IsConfiguredGame(event.pid)) {
+                rescan = true;
             }
         }
-        
-        if (monitoredPids.size() != activePids.size()) {
-            Log(L"Some processes closed");
-        }
-        monitoredPids = activePids;
-        
-        if (g_app.targetPid != 0 && activePids.find(g_app.targetPid) == activePids.end()) {
-            StopMonitoring();
-        }
-        
-        Sleep(500);
     }
     
+    events.Stop();
     StopMonitoring();
     Log(L"MonitorThread ended");
     return 0;
@@ -418,6 +448,7 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE, LPSTR, int) {
     }
     
     g_app.running = false;
+    g_app.processEvents.Wake();
     WaitForSingleObject(hThread, 3000);
     CloseHandle(hThread);
     CloseHandle(hMutex);
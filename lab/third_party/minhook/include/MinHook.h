@@ -87,6 +87,16 @@ MH_STATUS;
 // MH_QueueEnableHook or MH_QueueDisableHook.
 #define MH_ALL_HOOKS NULL
 
+// One hook for MH_CreateHooks.
+typedef struct _MH_HOOK_DESC
+{
+    LPVOID    pTarget;      // [in]  Target function.
+    LPVOID    pDetour;      // [in]  Detour function.
+    LPVOID   *ppOriginal;   // [out] Trampoline function. Can be NULL.
+    MH_STATUS status;       // [out] Result of creating this hook.
+}
+MH_HOOK_DESC;
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -141,6 +151,16 @@ extern "C" {
     MH_STATUS WINAPI MH_CreateHookApiEx(
         LPCWSTR pszModule, LPCSTR pszProcName, LPVOID pDetour, LPVOID *ppOriginal, LPVOID *ppTarget);
 
+    // Creates several hooks under one lock and, if enable is TRUE, enables
+    // the created ones with a single thread suspension.
+    // Parameters:
+    //   pHooks      [in/out] Hooks to create. Each status receives the result
+    //                        of its own hook; failed ones do not stop the rest.
+    //   count       [in]     Number of elements in pHooks.
+    //   enable      [in]     Enables the created hooks in one go.
+    // Returns MH_OK, or the first error met.
+    MH_STATUS WINAPI MH_CreateHooks(MH_HOOK_DESC *pHooks, UINT count, BOOL enable);
+
     // Removes an already created hook.
     // Parameters:
     //   pTarget [in] A pointer to the target function.
@@ -160,6 +180,24 @@ extern "C" {
     //                disabled in one go.
     MH_STATUS WINAPI MH_DisableHook(LPVOID pTarget);
 
+    // Enables several already created hooks with a single thread suspension.
+    // Hooks that are already enabled are skipped.
+    // Parameters:
+    //   ppTargets [in] Pointers to the target functions.
+    //   count     [in] Number of elements in ppTargets.
+    // Returns MH_ERROR_NOT_CREATED without changing anything if one of the
+    // targets has no hook.
+    MH_STATUS WINAPI MH_EnableHooks(LPVOID *ppTargets, UINT count);
+
+    // Disables several already created hooks with a single thread suspension.
+    // Hooks that are already disabled are skipped.
+    // Parameters:
+    //   ppTargets [in] Pointers to the target functions.
+    //   count     [in] Number of elements in ppTargets.
+    // Returns MH_ERROR_NOT_CREATED without changing anything if one of the
+    // targets has no hook.
+    MH_STATUS WINAPI MH_DisableHooks(LPVOID *ppTargets, UINT count);
+
     // Queues to enable an already created hook.
     // Parameters:
     //   pTarget [in] A pointer to the target function.
@@ -26,18 +26,25 @@
  *  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
-#include <windows.h>
+#include <string.h>
+#include "buffer_os.h"
 #include "buffer.h"
 
-// Size of each memory block. (= page size of VirtualAlloc)
-#define MEMORY_BLOCK_SIZE 0x1000
+// Size of each memory block. (= allocation granularity of VirtualAlloc)
+// A block is reserved whole and committed one page at a time.
+#define MEMORY_BLOCK_SIZE 0x10000
+
+// Commit unit inside a block.
+#define MEMORY_PAGE_SIZE 0x1000
 
 // Max range for seeking a memory block. (= 1024MB)
 #define MAX_MEMORY_RANGE 0x40000000
 
-// Memory protection flags to check the executable address.
-#define PAGE_EXECUTE_FLAGS \
-    (PAGE_EXECUTE | PAGE_EXECUTE_READ | PAGE_EXECUTE_READWRITE | PAGE_EXECUTE_WRITECOPY)
+// Number of remembered free regions.
+#define FREE_HINT_COUNT 16
+
+// Initial capacity of the block index.
+#define INITIAL_BLOCK_CAPACITY 16
 
 // Memory slot.
 typedef struct _MEMORY_SLOT
@@ -49,39 +56,203 @@ typedef struct _MEMORY_SLOT
     };
 } MEMORY_SLOT, *PMEMORY_SLOT;
 
-// Memory block info. Placed at the head of each block.
+// Memory block info. Placed in the first slot of each block.
 typedef struct _MEMORY_BLOCK
 {
-    struct _MEMORY_BLOCK *pNext;
     PMEMORY_SLOT pFree;         // First element of the free slot list.
     UINT usedCount;
+    UINT committedSize;         // Bytes committed from the head of the block.
 } MEMORY_BLOCK, *PMEMORY_BLOCK;
 
+// Blocks sorted by address.
+typedef struct _MEMORY_BLOCK_INDEX
+{
+    PMEMORY_BLOCK *pItems;
+    UINT capacity;
+    UINT size;
+} MEMORY_BLOCK_INDEX;
+
 //-------------------------------------------------------------------------
 // Global Variables:
 //-------------------------------------------------------------------------
 
-// First element of the memory block list.
-static PMEMORY_BLOCK g_pMemoryBlocks;
+static MEMORY_BLOCK_INDEX g_blocks;
+
+// Block that served the last allocation. Hooks are usually created for
+// neighbouring targets, so it is tried before the index.
+static PMEMORY_BLOCK g_pLastBlock;
+
+// Addresses of blocks believed to be free (released blocks and neighbours
+// of new ones), tried before scanning the address space.
+static ULONG_PTR g_freeHints[FREE_HINT_COUNT];
+static UINT      g_freeHintPos;
+
+static OS_INFO g_osInfo;
 
 //-------------------------------------------------------------------------
 VOID InitializeBuffer(VOID)
 {
-    // Nothing to do for now.
+    OsGetInfo(&g_osInfo);
 }
 
 //-------------------------------------------------------------------------
 VOID UninitializeBuffer(VOID)
 {
-    PMEMORY_BLOCK pBlock = g_pMemoryBlocks;
-    g_pMemoryBlocks = NULL;
+    UINT i;
+    for (i = 0; i < g_blocks.size; ++i)
+        OsRelease(g_blocks.pItems[i], MEMORY_BLOCK_SIZE);
+
+    if (g_blocks.pItems != NULL)
+        OsHeapFree(g_blocks.pItems);
+
+    g_blocks.pItems   = NULL;
+    g_blocks.capacity = 0;
+    g_blocks.size     = 0;
+    g_pLastBlock      = NULL;
+
+    memset(g_freeHints, 0, sizeof(g_freeHints));
+    g_freeHintPos = 0;
+}
+
+//-------------------------------------------------------------------------
+// Position of the first block at or above address.
+static UINT LowerBoundBlock(ULONG_PTR address)
+{
+    UINT lo = 0;
+    UINT hi = g_blocks.size;
+    while (lo < hi)
+    {
+        UINT mid = lo + (hi - lo) / 2;
+        if ((ULONG_PTR)g_blocks.pItems[mid] < address)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+//-------------------------------------------------------------------------
+static BOOL InsertBlock(PMEMORY_BLOCK pBlock)
+{
+    UINT pos;
+
+    if (g_blocks.size >= g_blocks.capacity)
+    {
+        UINT capacity = (g_blocks.capacity == 0) ? INITIAL_BLOCK_CAPACITY : g_blocks.capacity * 2;
+        PMEMORY_BLOCK *p;
+        if (g_blocks.pItems == NULL)
+            p = (PMEMORY_BLOCK *)OsHeapAlloc(capacity * sizeof(PMEMORY_BLOCK));
+        else
+            p = (PMEMORY_BLOCK *)OsHeapReAlloc(g_blocks.pItems, capacity * sizeof(PMEMORY_BLOCK));
+        if (p == NULL)
+            return FALSE;
+
+        g_blocks.pItems   = p;
+        g_blocks.capacity = capacity;
+    }
+
+    pos = LowerBoundBlock((ULONG_PTR)pBlock);
+    memmove(&g_blocks.pItems[pos + 1], &g_blocks.pItems[pos],
+        (g_blocks.size - pos) * sizeof(PMEMORY_BLOCK));
+    g_blocks.pItems[pos] = pBlock;
+    g_blocks.size++;
+    return TRUE;
+}
+
+//-------------------------------------------------------------------------
+// Position of the block holding pBuffer, or g_blocks.size if none.
+static UINT FindBlockPos(LPVOID pBuffer)
+{
+    UINT pos = LowerBoundBlock((ULONG_PTR)pBuffer + 1);
+    if (pos == 0)
+        return g_blocks.size;
+
+    pos--;
+    if ((ULONG_PTR)pBuffer - (ULONG_PTR)g_blocks.pItems[pos] >= MEMORY_BLOCK_SIZE)
+        return g_blocks.size;
+
+    return pos;
+}
+
+//-------------------------------------------------------------------------
+static BOOL HasFreeSlot(PMEMORY_BLOCK pBlock)
+{
+    return pBlock->pFree != NULL || pBlock->committedSize < MEMORY_BLOCK_SIZE;
+}
+
+//-------------------------------------------------------------------------
+static VOID AddFreeHint(ULONG_PTR address)
+{
+    UINT i;
+    if (address < g_osInfo.minAddress || address > g_osInfo.maxAddress - (MEMORY_BLOCK_SIZE - 1))
+        return;
+
+    for (i = 0; i < FREE_HINT_COUNT; ++i)
+    {
+        if (g_freeHints[i] == address)
+            return;
+    }
+
+    g_freeHints[g_freeHintPos] = address;
+    g_freeHintPos = (g_freeHintPos + 1) % FREE_HINT_COUNT;
+}
+
+//-------------------------------------------------------------------------
+// Commits the next page of the block and adds its slots to the free list.
+static BOOL CommitNextPage(PMEMORY_BLOCK pBlock)
+{
+    ULONG_PTR    pPage = (ULONG_PTR)pBlock + pBlock->committedSize;
+    PMEMORY_SLOT pSlot;
+    PMEMORY_SLOT pEnd;
+
+    if (pBlock->committedSize >= MEMORY_BLOCK_SIZE)
+        return FALSE;
+
+    // The first page is committed by NewMemoryBlock and holds the header.
+    if (pBlock->committedSize != 0 && !OsCommit((LPVOID)pPage, MEMORY_PAGE_SIZE))
+        return FALSE;
+
+    pSlot = (PMEMORY_SLOT)pPage;
+    pEnd  = (PMEMORY_SLOT)(pPage + MEMORY_PAGE_SIZE);
+    if (pBlock->committedSize == 0)
+        pSlot++;
+
+    pBlock->committedSize += MEMORY_PAGE_SIZE;
+
+    // Push in reverse so that slots are handed out in address order.
+    while (pEnd > pSlot)
+    {
+        pEnd--;
+        pEnd->pNext = pBlock->pFree;
+        pBlock->pFree = pEnd;
+    }
+    return TRUE;
+}
+
+//-------------------------------------------------------------------------
+static PMEMORY_BLOCK NewMemoryBlock(LPVOID pAddress)
+{
+    PMEMORY_BLOCK pBlock = (PMEMORY_BLOCK)OsReserve(pAddress, MEMORY_BLOCK_SIZE);
+    if (pBlock == NULL)
+        return NULL;
 
-    while (pBlock)
+    if (!OsCommit(pBlock, MEMORY_PAGE_SIZE) || !InsertBlock(pBlock))
     {
-        PMEMORY_BLOCK pNext = pBlock->pNext;
-        VirtualFree(pBlock, 0, MEM_RELEASE);
-        pBlock = pNext;
+        OsRelease(pBlock, MEMORY_BLOCK_SIZE);
+        return NULL;
     }
+
+    pBlock->pFree = NULL;
+    pBlock->usedCount = 0;
+    pBlock->committedSize = 0;
+    CommitNextPage(pBlock);
+
+#if defined(_M_X64) || defined(__x86_64__)
+    // The regions around a new block are likely free as well.
+    AddFreeHint((ULONG_PTR)pBlock - MEMORY_BLOCK_SIZE);
+    AddFreeHint((ULONG_PTR)pBlock + MEMORY_BLOCK_SIZE);
+#endif
+    return pBlock;
 }
 
 //-------------------------------------------------------------------------
@@ -98,17 +269,20 @@ static LPVOID FindPrevFreeRegion(LPVOID pAddress, LPVOID pMinAddr, DWORD dwAlloc
 
     while (tryAddr >= (ULONG_PTR)pMinAddr)
     {
-        MEMORY_BASIC_INFORMATION mbi;
-        if (VirtualQuery((LPVOID)tryAddr, &mbi, sizeof(mbi)) == 0)
+        OS_REGION region;
+        if (!OsQueryRegion(tryAddr, &region))
             break;
 
-        if (mbi.State == MEM_FREE)
+        if (region.isFree)
             return (LPVOID)tryAddr;
 
-        if ((ULONG_PTR)mbi.AllocationBase < dwAllocationGranularity)
+        if (region.allocationBase < dwAllocationGranularity)
             break;
 
-        tryAddr = (ULONG_PTR)mbi.AllocationBase - dwAllocationGranularity;
+        tryAddr = region.allocationBase - dwAllocationGranularity;
+
+        // Round down to the allocation granularity.
+        tryAddr -= tryAddr % dwAllocationGranularity;
     }
 
     return NULL;
@@ -129,14 +303,14 @@ static LPVOID FindNextFreeRegion(LPVOID pAddress, LPVOID pMaxAddr, DWORD dwAlloc
 
     while (tryAddr <= (ULONG_PTR)pMaxAddr)
     {
-        MEMORY_BASIC_INFORMATION mbi;
-        if (VirtualQuery((LPVOID)tryAddr, &mbi, sizeof(mbi)) == 0)
+        OS_REGION region;
+        if (!OsQueryRegion(tryAddr, &region))
             break;
 
-        if (mbi.State == MEM_FREE)
+        if (region.isFree)
             return (LPVOID)tryAddr;
 
-        tryAddr = (ULONG_PTR)mbi.BaseAddress + mbi.RegionSize;
+        tryAddr = region.base + region.size;
 
         // Round up to the next allocation granularity.
         tryAddr += dwAllocationGranularity - 1;
@@ -150,17 +324,21 @@ static LPVOID FindNextFreeRegion(LPVOID pAddress, LPVOID pMaxAddr, DWORD dwAlloc
 //-------------------------------------------------------------------------
 static PMEMORY_BLOCK GetMemoryBlock(LPVOID pOrigin)
 {
-    PMEMORY_BLOCK pBlock;
+    PMEMORY_BLOCK pBlock = NULL;
+    UINT i;
 #if defined(_M_X64) || defined(__x86_64__)
     ULONG_PTR minAddr;
     ULONG_PTR maxAddr;
+#endif
 
-    SYSTEM_INFO si;
-    GetSystemInfo(&si);
-    minAddr = (ULONG_PTR)si.lpMinimumApplicationAddress;
-    maxAddr = (ULONG_PTR)si.lpMaximumApplicationAddress;
+    if (g_osInfo.granularity == 0)
+        OsGetInfo(&g_osInfo);
 
-    // pOrigin ± 512MB
+#if defined(_M_X64) || defined(__x86_64__)
+    minAddr = g_osInfo.minAddress;
+    maxAddr = g_osInfo.maxAddress;
+
+    // pOrigin ± 1024MB
     if ((ULONG_PTR)pOrigin > MAX_MEMORY_RANGE && minAddr < (ULONG_PTR)pOrigin - MAX_MEMORY_RANGE)
         minAddr = (ULONG_PTR)pOrigin - MAX_MEMORY_RANGE;
 
@@ -169,33 +347,45 @@ static PMEMORY_BLOCK GetMemoryBlock(LPVOID pOrigin)
 
     // Make room for MEMORY_BLOCK_SIZE bytes.
     maxAddr -= MEMORY_BLOCK_SIZE - 1;
-#endif
 
-    // Look the registered blocks for a reachable one.
-    for (pBlock = g_pMemoryBlocks; pBlock != NULL; pBlock = pBlock->pNext)
+    // The block of the last allocation.
+    if (g_pLastBlock != NULL && HasFreeSlot(g_pLastBlock)
+        && (ULONG_PTR)g_pLastBlock >= minAddr && (ULONG_PTR)g_pLastBlock < maxAddr)
+        return g_pLastBlock;
+
+    // Look the registered blocks in range for one with room.
+    for (i = LowerBoundBlock(minAddr); i < g_blocks.size; ++i)
     {
-#if defined(_M_X64) || defined(__x86_64__)
-        // Ignore the blocks too far.
-        if ((ULONG_PTR)pBlock < minAddr || (ULONG_PTR)pBlock >= maxAddr)
+        if ((ULONG_PTR)g_blocks.pItems[i] >= maxAddr)
+            break;
+
+        if (HasFreeSlot(g_blocks.pItems[i]))
+            return g_blocks.pItems[i];
+    }
+
+    // Try the remembered free regions in range.
+    for (i = 0; i < FREE_HINT_COUNT; ++i)
+    {
+        ULONG_PTR hint = g_freeHints[i];
+        if (hint == 0 || hint < minAddr || hint >= maxAddr)
             continue;
-#endif
-        // The block has at least one unused slot.
-        if (pBlock->pFree != NULL)
+
+        g_freeHints[i] = 0;
+        pBlock = NewMemoryBlock((LPVOID)hint);
+        if (pBlock != NULL)
             return pBlock;
     }
 
-#if defined(_M_X64) || defined(__x86_64__)
     // Alloc a new block above if not found.
     {
         LPVOID pAlloc = pOrigin;
         while ((ULONG_PTR)pAlloc >= minAddr)
         {
-            pAlloc = FindPrevFreeRegion(pAlloc, (LPVOID)minAddr, si.dwAllocationGranularity);
+            pAlloc = FindPrevFreeRegion(pAlloc, (LPVOID)minAddr, g_osInfo.granularity);
             if (pAlloc == NULL)
                 break;
 
-            pBlock = (PMEMORY_BLOCK)VirtualAlloc(
-                pAlloc, MEMORY_BLOCK_SIZE, MEM_COMMIT | MEM_RESERVE, PAGE_EXECUTE_READWRITE);
+            pBlock = NewMemoryBlock(pAlloc);
             if (pBlock != NULL)
                 break;
         }
@@ -207,39 +397,29 @@ static PMEMORY_BLOCK GetMemoryBlock(LPVOID pOrigin)
         LPVOID pAlloc = pOrigin;
         while ((ULONG_PTR)pAlloc <= maxAddr)
         {
-            pAlloc = FindNextFreeRegion(pAlloc, (LPVOID)maxAddr, si.dwAllocationGranularity);
+            pAlloc = FindNextFreeRegion(pAlloc, (LPVOID)maxAddr, g_osInfo.granularity);
             if (pAlloc == NULL)
                 break;
 
-            pBlock = (PMEMORY_BLOCK)VirtualAlloc(
-                pAlloc, MEMORY_BLOCK_SIZE, MEM_COMMIT | MEM_RESERVE, PAGE_EXECUTE_READWRITE);
+            pBlock = NewMemoryBlock(pAlloc);
             if (pBlock != NULL)
                 break;
         }
     }
 #else
-    // In x86 mode, a memory block can be placed anywhere.
-    pBlock = (PMEMORY_BLOCK)VirtualAlloc(
-        NULL, MEMORY_BLOCK_SIZE, MEM_COMMIT | MEM_RESERVE, PAGE_EXECUTE_READWRITE);
-#endif
+    if (g_pLastBlock != NULL && HasFreeSlot(g_pLastBlock))
+        return g_pLastBlock;
 
-    if (pBlock != NULL)
+    for (i = 0; i < g_blocks.size; ++i)
     {
-        // Build a linked list of all the slots.
-        PMEMORY_SLOT pSlot = (PMEMORY_SLOT)pBlock + 1;
-        pBlock->pFree = NULL;
-        pBlock->usedCount = 0;
-        do
-        {
-            pSlot->pNext = pBlock->pFree;
-            pBlock->pFree = pSlot;
-            pSlot++;
-        } while ((ULONG_PTR)pSlot - (ULONG_PTR)pBlock <= MEMORY_BLOCK_SIZE - MEMORY_SLOT_SIZE);
-
-        pBlock->pNext = g_pMemoryBlocks;
-        g_pMemoryBlocks = pBlock;
+        if (HasFreeSlot(g_blocks.pItems[i]))
+            return g_blocks.pItems[i];
     }
 
+    // In x86 mode, a memory block can be placed anywhere.
+    pBlock = NewMemoryBlock(NULL);
+#endif
+
     return pBlock;
 }
 
@@ -251,10 +431,14 @@ LPVOID AllocateBuffer(LPVOID pOrigin)
     if (pBlock == NULL)
         return NULL;
 
+    if (pBlock->pFree == NULL && !CommitNextPage(pBlock))
+        return NULL;
+
     // Remove an unused slot from the list.
     pSlot = pBlock->pFree;
     pBlock->pFree = pSlot->pNext;
     pBlock->usedCount++;
+    g_pLastBlock = pBlock;
 #ifdef _DEBUG
     // Fill the slot with INT3 for debugging.
     memset(pSlot, 0xCC, sizeof(MEMORY_SLOT));
@@ -263,50 +447,63 @@ LPVOID AllocateBuffer(LPVOID pOrigin)
 }
 
 //-------------------------------------------------------------------------
-VOID FreeBuffer(LPVOID pBuffer)
+UINT AllocateBuffers(LPVOID *ppOrigins, LPVOID *ppBuffers, UINT count)
 {
-    PMEMORY_BLOCK pBlock = g_pMemoryBlocks;
-    PMEMORY_BLOCK pPrev = NULL;
-    ULONG_PTR pTargetBlock = ((ULONG_PTR)pBuffer / MEMORY_BLOCK_SIZE) * MEMORY_BLOCK_SIZE;
+    UINT allocated = 0;
+    UINT i;
 
-    while (pBlock != NULL)
+    // Batches usually target one module, so after the first allocation most
+    // origins are served by the last block without touching the index.
+    for (i = 0; i < count; ++i)
     {
-        if ((ULONG_PTR)pBlock == pTargetBlock)
-        {
-            PMEMORY_SLOT pSlot = (PMEMORY_SLOT)pBuffer;
+        ppBuffers[i] = AllocateBuffer(ppOrigins[i]);
+        if (ppBuffers[i] != NULL)
+            allocated++;
+    }
+
+    return allocated;
+}
+
+//-------------------------------------------------------------------------
+VOID FreeBuffer(LPVOID pBuffer)
+{
+    UINT pos = FindBlockPos(pBuffer);
+    PMEMORY_BLOCK pBlock;
+    PMEMORY_SLOT pSlot = (PMEMORY_SLOT)pBuffer;
+
+    if (pos >= g_blocks.size)
+        return;
+
+    pBlock = g_blocks.pItems[pos];
 #ifdef _DEBUG
-            // Clear the released slot for debugging.
-            memset(pSlot, 0x00, sizeof(MEMORY_SLOT));
+    // Clear the released slot for debugging.
+    memset(pSlot, 0x00, sizeof(MEMORY_SLOT));
 #endif
-            // Restore the released slot to the list.
-            pSlot->pNext = pBlock->pFree;
-            pBlock->pFree = pSlot;
-            pBlock->usedCount--;
-
-            // Free if unused.
-            if (pBlock->usedCount == 0)
-            {
-                if (pPrev)
-                    pPrev->pNext = pBlock->pNext;
-                else
-                    g_pMemoryBlocks = pBlock->pNext;
-
-                VirtualFree(pBlock, 0, MEM_RELEASE);
-            }
+    // Restore the released slot to the list.
+    pSlot->pNext = pBlock->pFree;
+    pBlock->pFree = pSlot;
+    pBlock->usedCount--;
 
-            break;
-        }
+    // Free if unused.
+    if (pBlock->usedCount == 0)
+    {
+        g_blocks.size--;
+        memmove(&g_blocks.pItems[pos], &g_blocks.pItems[pos + 1],
+            (g_blocks.size - pos) * sizeof(PMEMORY_BLOCK));
+
+        if (g_pLastBlock == pBlock)
+            g_pLastBlock = NULL;
 
-        pPrev = pBlock;
-        pBlock = pBlock->pNext;
+        OsRelease(pBlock, MEMORY_BLOCK_SIZE);
+#if defined(_M_X64) || defined(__x86_64__)
+        AddFreeHint((ULONG_PTR)pBlock);
+#endif
     }
 }
 
 //-------------------------------------------------------------------------
 BOOL IsExecutableAddress(LPVOID pAddress)
 {
-    MEMORY_BASIC_INFORMATION mi;
-    VirtualQuery(pAddress, &mi, sizeof(mi));
-
-    return (mi.State == MEM_COMMIT && (mi.Protect & PAGE_EXECUTE_FLAGS));
+    OS_REGION region;
+    return OsQueryRegion((ULONG_PTR)pAddress, &region) && region.isExecutable;
 }
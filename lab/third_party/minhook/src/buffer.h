@@ -38,5 +38,10 @@
 VOID   InitializeBuffer(VOID);
 VOID   UninitializeBuffer(VOID);
 LPVOID AllocateBuffer(LPVOID pOrigin);
+
+// Allocates one buffer near each origin. Failed entries are set to NULL.
+// Returns the number of buffers allocated.
+UINT   AllocateBuffers(LPVOID *ppOrigins, LPVOID *ppBuffers, UINT count);
+
 VOID   FreeBuffer(LPVOID pBuffer);
 BOOL   IsExecutableAddress(LPVOID pAddress);
@@ -0,0 +1,236 @@
+﻿/*
+ *  MinHook - The Minimalistic API Hooking Library for x64/x86
+ *  Copyright (C) 2009-2017 Tsuda Kageyu.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ *  TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ *  PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER
+ *  OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ *  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ *  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ *  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ *  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ *  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ *  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef _WIN32
+    #define _GNU_SOURCE     // MAP_ANONYMOUS, MAP_FIXED_NOREPLACE
+#endif
+
+#include "buffer_os.h"
+
+#ifdef _WIN32
+
+// Memory protection flags to check the executable address.
+#define PAGE_EXECUTE_FLAGS \
+    (PAGE_EXECUTE | PAGE_EXECUTE_READ | PAGE_EXECUTE_READWRITE | PAGE_EXECUTE_WRITECOPY)
+
+//-------------------------------------------------------------------------
+VOID OsGetInfo(OS_INFO *pInfo)
+{
+    SYSTEM_INFO si;
+    GetSystemInfo(&si);
+    pInfo->minAddress  = (ULONG_PTR)si.lpMinimumApplicationAddress;
+    pInfo->maxAddress  = (ULONG_PTR)si.lpMaximumApplicationAddress;
+    pInfo->granularity = si.dwAllocationGranularity;
+    pInfo->pageSize    = si.dwPageSize;
+}
+
+//-------------------------------------------------------------------------
+BOOL OsQueryRegion(ULONG_PTR address, OS_REGION *pRegion)
+{
+    MEMORY_BASIC_INFORMATION mbi;
+    if (VirtualQuery((LPVOID)address, &mbi, sizeof(mbi)) == 0)
+        return FALSE;
+
+    pRegion->isFree         = (mbi.State == MEM_FREE);
+    pRegion->allocationBase = pRegion->isFree ? (ULONG_PTR)mbi.BaseAddress : (ULONG_PTR)mbi.AllocationBase;
+    pRegion->base           = (ULONG_PTR)mbi.BaseAddress;
+    pRegion->size           = mbi.RegionSize;
+    pRegion->isExecutable   = (mbi.State == MEM_COMMIT && (mbi.Protect & PAGE_EXECUTE_FLAGS));
+    return TRUE;
+}
+
+//-------------------------------------------------------------------------
+LPVOID OsReserve(LPVOID pAddress, SIZE_T size)
+{
+    return VirtualAlloc(pAddress, size, MEM_RESERVE, PAGE_NOACCESS);
+}
+
+//-------------------------------------------------------------------------
+BOOL OsCommit(LPVOID pAddress, SIZE_T size)
+{
+    return VirtualAlloc(pAddress, size, MEM_COMMIT, PAGE_EXECUTE_READWRITE) != NULL;
+}
+
+//-------------------------------------------------------------------------
+VOID OsRelease(LPVOID pAddress, SIZE_T size)
+{
+    UNREFERENCED_PARAMETER(size);
+    VirtualFree(pAddress, 0, MEM_RELEASE);
+}
+
+//-------------------------------------------------------------------------
+LPVOID OsHeapAlloc(SIZE_T size)
+{
+    return HeapAlloc(GetProcessHeap(), 0, size);
+}
+
+//-------------------------------------------------------------------------
+LPVOID OsHeapReAlloc(LPVOID p, SIZE_T size)
+{
+    return HeapReAlloc(GetProcessHeap(), 0, p, size);
+}
+
+//-------------------------------------------------------------------------
+VOID OsHeapFree(LPVOID p)
+{
+    HeapFree(GetProcessHeap(), 0, p);
+}
+
+#else
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#ifndef MAP_FIXED_NOREPLACE
+    #define MAP_FIXED_NOREPLACE 0x100000
+#endif
+
+// Same reservation size as Windows, so both behave alike.
+#define OS_GRANULARITY 0x10000
+
+//-------------------------------------------------------------------------
+VOID OsGetInfo(OS_INFO *pInfo)
+{
+    pInfo->minAddress  = OS_GRANULARITY;
+#if defined(__x86_64__)
+    pInfo->maxAddress  = 0x7FFFFFFEFFFFULL;
+#else
+    pInfo->maxAddress  = 0xBFFEFFFFUL;
+#endif
+    pInfo->granularity = OS_GRANULARITY;
+    pInfo->pageSize    = (DWORD)sysconf(_SC_PAGESIZE);
+}
+
+//-------------------------------------------------------------------------
+BOOL OsQueryRegion(ULONG_PTR address, OS_REGION *pRegion)
+{
+    // Mappings are listed in address order: find the one holding address,
+    // or the gap between the previous one's end and the next one's start.
+    char line[512];
+    ULONG_PTR gapStart = 0;
+    BOOL found = FALSE;
+    FILE *maps = fopen("/proc/self/maps", "r");
+    if (maps == NULL)
+        return FALSE;
+
+    while (fgets(line, sizeof(line), maps))
+    {
+        char *end;
+        ULONG_PTR start = (ULONG_PTR)strtoull(line, &end, 16);
+        ULONG_PTR stop;
+        if (*end != '-')
+            continue;
+
+        stop = (ULONG_PTR)strtoull(end + 1, &end, 16);
+        if (address < start)
+        {
+            pRegion->isFree       = TRUE;
+            pRegion->isExecutable = FALSE;
+            pRegion->allocationBase = pRegion->base = gapStart;
+            pRegion->size         = start - gapStart;
+            found = TRUE;
+            break;
+        }
+        if (address < stop)
+        {
+            pRegion->isFree       = FALSE;
+            pRegion->isExecutable = (end[3] == 'x');
+            pRegion->allocationBase = pRegion->base = start;
+            pRegion->size         = stop - start;
+            found = TRUE;
+            break;
+        }
+        gapStart = stop;
+    }
+    fclose(maps);
+
+    if (!found)
+    {
+        pRegion->isFree       = TRUE;
+        pRegion->isExecutable = FALSE;
+        pRegion->allocationBase = pRegion->base = gapStart;
+        pRegion->size         = (SIZE_T)0 - gapStart;
+    }
+    return TRUE;
+}
+
+//-------------------------------------------------------------------------
+LPVOID OsReserve(LPVOID pAddress, SIZE_T size)
+{
+    int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+    LPVOID p;
+
+    if (pAddress != NULL)
+        flags |= MAP_FIXED_NOREPLACE;
+
+    p = mmap(pAddress, size, PROT_NONE, flags, -1, 0);
+    if (p == MAP_FAILED)
+        return NULL;
+
+    // Kernels before 4.17 take MAP_FIXED_NOREPLACE as a mere hint.
+    if (pAddress != NULL && p != pAddress)
+    {
+        munmap(p, size);
+        return NULL;
+    }
+    return p;
+}
+
+//-------------------------------------------------------------------------
+BOOL OsCommit(LPVOID pAddress, SIZE_T size)
+{
+    return mprotect(pAddress, size, PROT_READ | PROT_WRITE | PROT_EXEC) == 0;
+}
+
+//-------------------------------------------------------------------------
+VOID OsRelease(LPVOID pAddress, SIZE_T size)
+{
+    munmap(pAddress, size);
+}
+
+//-------------------------------------------------------------------------
+LPVOID OsHeapAlloc(SIZE_T size)
+{
+    return malloc(size);
+}
+
+//-------------------------------------------------------------------------
+LPVOID OsHeapReAlloc(LPVOID p, SIZE_T size)
+{
+    return realloc(p, size);
+}
+
+//-------------------------------------------------------------------------
+VOID OsHeapFree(LPVOID p)
+{
+    free(p);
+}
+
+#endif
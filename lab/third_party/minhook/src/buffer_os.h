@@ -0,0 +1,88 @@
+﻿/*
+ *  MinHook - The Minimalistic API Hooking Library for x64/x86
+ *  Copyright (C) 2009-2017 Tsuda Kageyu.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ *  TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ *  PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER
+ *  OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ *  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ *  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ *  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ *  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ *  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ *  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+// Virtual memory primitives used by buffer.c. Win32 on Windows; mmap and
+// /proc/self/maps elsewhere, so the slot allocator can be tested and
+// benchmarked on Linux.
+
+#ifdef _WIN32
+    #include <windows.h>
+#else
+    #include <stddef.h>
+    #include <stdint.h>
+
+    typedef void          VOID;
+    typedef void         *LPVOID;
+    typedef int           BOOL;
+    typedef uint8_t       UINT8;
+    typedef unsigned int  UINT;
+    typedef uint32_t      DWORD;
+    typedef size_t        SIZE_T;
+    typedef uintptr_t     ULONG_PTR;
+
+    #ifndef TRUE
+        #define TRUE  1
+        #define FALSE 0
+    #endif
+#endif
+
+// Region containing (or following) an address.
+typedef struct _OS_REGION
+{
+    ULONG_PTR allocationBase;   // Start of the whole allocation (free: start of the gap).
+    ULONG_PTR base;             // Start of the region with uniform state.
+    SIZE_T    size;
+    BOOL      isFree;
+    BOOL      isExecutable;     // Committed and executable.
+} OS_REGION;
+
+typedef struct _OS_INFO
+{
+    ULONG_PTR minAddress;       // Lowest and highest addresses usable for blocks.
+    ULONG_PTR maxAddress;
+    DWORD     granularity;      // Alignment and size of a reservation.
+    DWORD     pageSize;
+} OS_INFO;
+
+VOID   OsGetInfo(OS_INFO *pInfo);
+BOOL   OsQueryRegion(ULONG_PTR address, OS_REGION *pRegion);
+
+// Reserves size bytes at exactly pAddress (anywhere if NULL). Returns NULL
+// if the range is not free.
+LPVOID OsReserve(LPVOID pAddress, SIZE_T size);
+
+// Commits pages of a reservation as read/write/execute.
+BOOL   OsCommit(LPVOID pAddress, SIZE_T size);
+VOID   OsRelease(LPVOID pAddress, SIZE_T size);
+
+// Small bookkeeping allocations (the block index).
+LPVOID OsHeapAlloc(SIZE_T size);
+LPVOID OsHeapReAlloc(LPVOID p, SIZE_T size);
+VOID   OsHeapFree(LPVOID p);
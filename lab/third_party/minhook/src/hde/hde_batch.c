@@ -0,0 +1,280 @@
+﻿/*
+ * Hacker Disassembler Engine: batch length decoding
+ *
+ */
+
+#include <string.h>
+#include "hde_batch.h"
+
+#if defined(_M_X64) || defined(__x86_64__)
+    #include "hde64.h"
+    typedef hde64s hde_state;
+    #define HDE_DISASM(code, hs) hde64_disasm(code, hs)
+    #define HDE_MODE64 1
+#else
+    #include "hde32.h"
+    typedef hde32s hde_state;
+    #define HDE_DISASM(code, hs) hde32_disasm(code, hs)
+    #define HDE_MODE64 0
+#endif
+
+/* fast_table entries */
+#define B_IMM    0x07   /* immediate bytes */
+#define B_MODRM  0x08
+#define B_REL    0x10
+#define B_RET    0x20
+#define B_GROUP  0x40   /* ModR/M reg selects the form, see fast_decode() */
+#define B_SLOW   0x80   /* other prefixes, FPU, moffs, groups, invalid... */
+
+#define N  0x00
+#define M  B_MODRM
+#define I1 1
+#define I2 2
+#define I3 3
+#define I4 4
+#define MI1 (B_MODRM | 1)
+#define MI4 (B_MODRM | 4)
+#define R1 (B_REL | 1)
+#define R4 (B_REL | 4)
+#define RT B_RET
+#define RT2 (B_RET | 2)
+#define G  (B_MODRM | B_GROUP)
+#define S  B_SLOW
+
+/* One-byte opcodes, optionally after 66 (which turns the 4-byte immediates
+ * into 2-byte ones). 40-4F are INC/DEC in 32-bit mode; in 64-bit mode they
+ * are REX and consumed before the lookup. */
+static const uint8_t fast_table[256] = {
+  /*        0    1    2    3    4    5    6    7    8    9    A    B    C    D    E    F */
+  /* 0 */   M,   M,   M,   M,   I1,  I4,  S,   S,   M,   M,   M,   M,   I1,  I4,  S,   S,
+  /* 1 */   M,   M,   M,   M,   I1,  I4,  S,   S,   M,   M,   M,   M,   I1,  I4,  S,   S,
+  /* 2 */   M,   M,   M,   M,   I1,  I4,  S,   S,   M,   M,   M,   M,   I1,  I4,  S,   S,
+  /* 3 */   M,   M,   M,   M,   I1,  I4,  S,   S,   M,   M,   M,   M,   I1,  I4,  S,   S,
+  /* 4 */   N,   N,   N,   N,   N,   N,   N,   N,   N,   N,   N,   N,   N,   N,   N,   N,
+  /* 5 */   N,   N,   N,   N,   N,   N,   N,   N,   N,   N,   N,   N,   N,   N,   N,   N,
+  /* 6 */   S,   S,   S,   M,   S,   S,   S,   S,   I4,  MI4, I1,  MI1, N,   N,   N,   N,
+  /* 7 */   R1,  R1,  R1,  R1,  R1,  R1,  R1,  R1,  R1,  R1,  R1,  R1,  R1,  R1,  R1,  R1,
+  /* 8 */   MI1, MI4, S,   MI1, M,   M,   M,   M,   M,   M,   M,   M,   S,   S,   S,   S,
+  /* 9 */   N,   N,   N,   N,   N,   N,   N,   N,   N,   N,   S,   N,   N,   N,   S,   S,
+  /* A */   S,   S,   S,   S,   N,   N,   N,   N,   I1,  I4,  N,   N,   N,   N,   N,   N,
+  /* B */   I1,  I1,  I1,  I1,  I1,  I1,  I1,  I1,  I4,  I4,  I4,  I4,  I4,  I4,  I4,  I4,
+  /* C */   MI1, MI1, RT2, RT,  S,   S,   G,   G,   I3,  N,   I2,  N,   N,   I1,  S,   N,
+  /* D */   M,   M,   M,   M,   S,   S,   S,   N,   S,   S,   S,   S,   S,   S,   S,   S,
+  /* E */   R1,  R1,  R1,  R1,  I1,  I1,  I1,  I1,  R4,  R4,  S,   R1,  N,   N,   N,   N,
+  /* F */   S,   S,   S,   S,   N,   N,   G,   G,   N,   N,   N,   N,   N,   N,   G,   G
+};
+
+/* 0F xx: NOP r/m, CMOVcc, Jcc rel32, SETcc, MOVZX/MOVSX, BSWAP and the
+ * common SSE moves and logic ops. Anything with an opcode group, a
+ * register-only restriction or a mandatory F2/F3 prefix stays slow. */
+static const uint8_t fast_table_0f[256] = {
+  /*        0    1    2    3    4    5    6    7    8    9    A    B    C    D    E    F */
+  /* 0 */   S,   S,   S,   S,   S,   S,   S,   S,   S,   S,   S,   S,   S,   S,   S,   S,
+  /* 1 */   M,   M,   S,   S,   M,   M,   S,   S,   S,   S,   S,   S,   S,   S,   S,   M,
+  /* 2 */   S,   S,   S,   S,   S,   S,   S,   S,   M,   M,   S,   S,   S,   S,   M,   M,
+  /* 3 */   S,   S,   S,   S,   S,   S,   S,   S,   S,   S,   S,   S,   S,   S,   S,   S,
+  /* 4 */   M,   M,   M,   M,   M,   M,   M,   M,   M,   M,   M,   M,   M,   M,   M,   M,
+  /* 5 */   S,   S,   S,   S,   M,   M,   M,   M,   M,   M,   S,   S,   M,   M,   M,   M,
+  /* 6 */   S,   S,   S,   S,   S,   S,   S,   S,   S,   S,   S,   S,   S,   S,   M,   M,
+  /* 7 */   S,   S,   S,   S,   S,   S,   S,   S,   S,   S,   S,   S,   S,   S,   M,   M,
+  /* 8 */   R4,  R4,  R4,  R4,  R4,  R4,  R4,  R4,  R4,  R4,  R4,  R4,  R4,  R4,  R4,  R4,
+  /* 9 */   M,   M,   M,   M,   M,   M,   M,   M,   M,   M,   M,   M,   M,   M,   M,   M,
+  /* A */   S,   S,   N,   M,   S,   S,   S,   S,   S,   S,   S,   M,   S,   S,   S,   M,
+  /* B */   S,   S,   S,   S,   S,   S,   M,   M,   S,   S,   S,   S,   S,   S,   M,   M,
+  /* C */   S,   S,   S,   S,   S,   S,   MI1, S,   N,   N,   N,   N,   N,   N,   N,   N,
+  /* D */   S,   S,   S,   S,   S,   S,   S,   S,   S,   S,   S,   S,   S,   S,   S,   S,
+  /* E */   S,   S,   S,   S,   S,   S,   S,   S,   S,   S,   S,   S,   S,   S,   S,   M,
+  /* F */   S,   S,   S,   S,   S,   S,   S,   S,   S,   S,   S,   S,   S,   S,   S,   S
+};
+
+#undef N
+#undef M
+#undef I1
+#undef I2
+#undef I3
+#undef I4
+#undef MI1
+#undef MI4
+#undef R1
+#undef R4
+#undef RT
+#undef RT2
+#undef G
+#undef S
+
+/* Table path; returns 0 if the instruction needs the full decoder */
+static unsigned int fast_decode(const uint8_t *p, hde_insn *insn)
+{
+    const uint8_t *start = p;
+    uint8_t op, entry, flags = 0, p66 = 0;
+    unsigned int imm;
+#if HDE_MODE64
+    uint8_t rex_w = 0;
+#endif
+
+    /* ENDBR64/ENDBR32 open every CET-enabled function */
+    if (p[0] == 0xf3 && p[1] == 0x0f && p[2] == 0x1e && (p[3] & 0xfe) == 0xfa) {
+        insn->len = 4;
+        insn->flags = 0;
+        return 4;
+    }
+
+    if (*p == 0x66) {
+        p66 = 1;
+        p++;
+    }
+
+#if HDE_MODE64
+    if ((*p & 0xf0) == 0x40) {
+        rex_w = *p & 8;
+        p++;
+        if ((*p & 0xf0) == 0x40)
+            return 0;
+    }
+#endif
+
+    op = *p++;
+    if (op == 0x0f) {
+        op = *p++;
+        entry = fast_table_0f[op];
+    } else {
+        entry = fast_table[op];
+    }
+    if (entry & B_SLOW)
+        return 0;
+
+    imm = entry & B_IMM;
+#if HDE_MODE64
+    /* MOV r64, imm64 */
+    if (rex_w && op >= 0xb8 && op <= 0xbf && p[-2] != 0x0f)
+        imm = 8;
+#endif
+    if (entry & B_REL)
+        flags |= HDE_INSN_RELATIVE;
+    if (entry & B_RET)
+        flags |= HDE_INSN_RET;
+
+    if (entry & B_MODRM) {
+        uint8_t modrm = *p++;
+        uint8_t mod = modrm >> 6, reg = (modrm >> 3) & 7, rm = modrm & 7;
+
+        if (entry & B_GROUP) {
+            switch (op) {
+                case 0xc6: case 0xc7:   /* MOV r/m, imm */
+                    if (reg != 0)
+                        return 0;
+                    imm = op == 0xc6 ? 1 : 4;
+                    break;
+                case 0xf6: case 0xf7:   /* TEST/NOT/NEG/MUL/DIV */
+                    if (reg <= 1)
+                        imm = op == 0xf6 ? 1 : 4;
+                    break;
+                case 0xfe:              /* INC/DEC r/m8 */
+                    if (reg > 1)
+                        return 0;
+                    break;
+                default:                /* FF: INC/DEC/CALL/JMP/PUSH */
+                    if (reg == 7 || (mod == 3 && (reg == 3 || reg == 5)))
+                        return 0;
+                    break;
+            }
+        }
+
+        if (mod != 3) {
+            if (rm == 4) {
+                uint8_t sib = *p++;
+                if ((sib & 7) == 5 && mod == 0)
+                    p += 4;
+            } else if (rm == 5 && mod == 0) {
+#if HDE_MODE64
+                flags |= HDE_INSN_RIPREL;
+#endif
+                p += 4;
+            }
+            if (mod == 1)
+                p += 1;
+            else if (mod == 2)
+                p += 4;
+        }
+    }
+
+    /* 66 shrinks the 4-byte (operand-sized) immediates and rel32 */
+    if (p66 && imm == 4)
+        imm = 2;
+
+    insn->len = (uint8_t)(p - start + imm);
+    insn->flags = flags;
+    return insn->len;
+}
+
+/* Full decoder path */
+static unsigned int slow_decode(const uint8_t *p, hde_insn *insn)
+{
+    hde_state hs;
+
+    HDE_DISASM(p, &hs);
+    if (hs.flags & F_ERROR)
+        return 0;
+
+    insn->len = hs.len;
+    insn->flags = 0;
+    if (hs.flags & F_RELATIVE)
+        insn->flags |= HDE_INSN_RELATIVE;
+#if HDE_MODE64
+    if ((hs.flags & F_MODRM) && (hs.modrm & 0xc7) == 0x05)
+        insn->flags |= HDE_INSN_RIPREL;
+#endif
+    if ((hs.opcode & 0xfe) == 0xc2)
+        insn->flags |= HDE_INSN_RET;
+    return insn->len;
+}
+
+unsigned int hde_insn_decode(const void *code, hde_insn *insn, hde_cache *cache)
+{
+    const uint8_t *p = (const uint8_t *)code;
+    hde_cache_entry *e;
+
+    if (fast_decode(p, insn))
+        return insn->len;
+
+    if (!cache)
+        return slow_decode(p, insn);
+
+    /* Code addresses are byte-aligned; fold in the higher bits too */
+    e = &cache->entries[((size_t)p ^ ((size_t)p >> 8)) & (HDE_CACHE_SIZE - 1)];
+    if (e->code == p && memcmp(e->bytes, p, e->len) == 0) {
+        cache->hits++;
+        insn->len = e->len;
+        insn->flags = e->flags;
+        return insn->len;
+    }
+
+    cache->misses++;
+    if (!slow_decode(p, insn))
+        return 0;
+
+    e->code = p;
+    e->len = insn->len;
+    e->flags = insn->flags;
+    memcpy(e->bytes, p, insn->len);
+    return insn->len;
+}
+
+unsigned int hde_decode_range(const void *code, size_t size, hde_insn *insns,
+                              unsigned int max_insns, size_t *decoded,
+                              hde_cache *cache)
+{
+    const uint8_t *p = (const uint8_t *)code;
+    size_t pos = 0;
+    unsigned int count = 0;
+
+    while (pos < size && count < max_insns) {
+        if (!hde_insn_decode(p + pos, &insns[count], cache))
+            break;
+        pos += insns[count++].len;
+    }
+
+    if (decoded)
+        *decoded = pos;
+    return count;
+}
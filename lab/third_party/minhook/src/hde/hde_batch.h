@@ -0,0 +1,68 @@
+﻿/*
+ * Hacker Disassembler Engine: batch length decoding
+ *
+ * hde_batch.h: C/C++ header file
+ *
+ * Instruction lengths plus the few facts a hooking engine needs before it
+ * can copy an instruction elsewhere, without filling a whole hde32s/hde64s.
+ * Common one-byte opcodes are decoded from a table; everything else goes
+ * through hde32_disasm/hde64_disasm (whichever matches the build) and can
+ * be remembered in a small cache keyed by code address.
+ *
+ */
+
+#ifndef _HDE_BATCH_H_
+#define _HDE_BATCH_H_
+
+#include <stddef.h>
+#include "pstdint.h"
+
+/* hde_insn.flags: the instruction cannot be copied byte for byte */
+#define HDE_INSN_RELATIVE 0x01  /* rel8/rel16/rel32 branch or call */
+#define HDE_INSN_RIPREL   0x02  /* RIP-relative memory operand (64-bit) */
+#define HDE_INSN_RET      0x04  /* RET or RET imm16 */
+
+typedef struct {
+    uint8_t len;
+    uint8_t flags;
+} hde_insn;
+
+#define HDE_CACHE_SIZE 256      /* power of two */
+
+/* An entry is valid while the code still holds the same bytes, so patched
+ * code is decoded again instead of returning a stale length. */
+typedef struct {
+    const uint8_t *code;
+    uint8_t len;
+    uint8_t flags;
+    uint8_t bytes[15];
+} hde_cache_entry;
+
+/* Zero-initialize before use. Not thread-safe: one cache per thread or
+ * behind a lock. */
+typedef struct {
+    hde_cache_entry entries[HDE_CACHE_SIZE];
+    uint32_t hits;
+    uint32_t misses;
+} hde_cache;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Length of the instruction at code, 0 if it is invalid. cache can be NULL. */
+unsigned int hde_insn_decode(const void *code, hde_insn *insn, hde_cache *cache);
+
+/* Decodes consecutive instructions from code until size bytes are covered
+ * (the last one may extend past size), max_insns are stored or an invalid
+ * instruction is met. Returns the number stored; *decoded receives the
+ * bytes they cover. cache can be NULL. */
+unsigned int hde_decode_range(const void *code, size_t size, hde_insn *insns,
+                              unsigned int max_insns, size_t *decoded,
+                              hde_cache *cache);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _HDE_BATCH_H_ */
@@ -32,6 +32,7 @@
 
 #include "../include/MinHook.h"
 #include "buffer.h"
+#include "hook_index.h"
 #include "trampoline.h"
 
 #ifndef ARRAYSIZE
@@ -47,6 +48,11 @@
 // Special hook position values.
 #define INVALID_HOOK_POS UINT_MAX
 #define ALL_HOOKS_POS    UINT_MAX
+#define BATCH_HOOKS_POS  (UINT_MAX - 1)     // Entries with inBatch set.
+
+// Bounds of the adaptive spin count in EnterSpinLock().
+#define MIN_SPIN_COUNT  16
+#define MAX_SPIN_COUNT  4096
 
 // Freeze() action argument defines.
 #define ACTION_DISABLE      0
@@ -68,6 +74,7 @@ typedef struct _HOOK_ENTRY
     UINT8  patchAbove  : 1;     // Uses the hot patch area.
     UINT8  isEnabled   : 1;     // Enabled.
     UINT8  queueEnable : 1;     // Queued for enabling/disabling when != isEnabled.
+    UINT8  inBatch     : 1;     // Selected by a batch call, see EnableBatchLL().
 
     UINT   nIP : 4;             // Count of the instruction boundaries.
     UINT8  oldIPs[8];           // Instruction boundaries of the target function.
@@ -89,6 +96,15 @@ typedef struct _FROZEN_THREADS
 // Spin lock flag for EnterSpinLock()/LeaveSpinLock().
 static volatile LONG g_isLocked = FALSE;
 
+// Threads blocked in EnterSpinLock(), woken by LeaveSpinLock() through an
+// auto-reset event created on first contention. It lives until process exit:
+// a thread may still be waiting on it while another one uninitializes.
+static volatile LONG g_lockWaiters = 0;
+static HANDLE volatile g_hLockEvent = NULL;
+
+// Spins before blocking; adapts to how long the lock is usually held.
+static volatile LONG g_spinCount = MIN_SPIN_COUNT;
+
 // Private heap handle. If not NULL, this library is initialized.
 static HANDLE g_hHeap = NULL;
 
@@ -98,25 +114,45 @@ static struct
     PHOOK_ENTRY pItems;     // Data heap
     UINT        capacity;   // Size of allocated data heap, items
     UINT        size;       // Actual number of data items
+    HOOK_INDEX  index;      // pTarget -> position in pItems
 } g_hooks;
 
 //-------------------------------------------------------------------------
 // Returns INVALID_HOOK_POS if not found.
 static UINT FindHookEntry(LPVOID pTarget)
 {
-    UINT i;
-    for (i = 0; i < g_hooks.size; ++i)
-    {
-        if ((ULONG_PTR)pTarget == (ULONG_PTR)g_hooks.pItems[i].pTarget)
-            return i;
-    }
+    return HookIndexFind(&g_hooks.index, pTarget);
+}
+
+//-------------------------------------------------------------------------
+static BOOL ReserveHookIndex(UINT count)
+{
+    UINT capacity = HookIndexCapacityFor(count);
+    HOOK_INDEX_SLOT *pSlots;
+
+    if (capacity <= g_hooks.index.capacity)
+        return TRUE;
 
-    return INVALID_HOOK_POS;
+    pSlots = (HOOK_INDEX_SLOT *)HeapAlloc(
+        g_hHeap, HEAP_ZERO_MEMORY, capacity * sizeof(HOOK_INDEX_SLOT));
+    if (pSlots == NULL)
+        return FALSE;
+
+    pSlots = HookIndexRehash(&g_hooks.index, pSlots, capacity);
+    if (pSlots != NULL)
+        HeapFree(g_hHeap, 0, pSlots);
+
+    return TRUE;
 }
 
 //-------------------------------------------------------------------------
-static PHOOK_ENTRY AddHookEntry()
+static PHOOK_ENTRY AddHookEntry(LPVOID pTarget)
 {
+    PHOOK_ENTRY pHook;
+
+    if (!ReserveHookIndex(g_hooks.size + 1))
+        return NULL;
+
     if (g_hooks.pItems == NULL)
     {
         g_hooks.capacity = INITIAL_HOOK_CAPACITY;
@@ -136,14 +172,24 @@ static PHOOK_ENTRY AddHookEntry()
         g_hooks.pItems = p;
     }
 
-    return &g_hooks.pItems[g_hooks.size++];
+    HookIndexInsert(&g_hooks.index, pTarget, g_hooks.size);
+
+    pHook = &g_hooks.pItems[g_hooks.size++];
+    pHook->pTarget = pTarget;
+    pHook->inBatch = FALSE;
+    return pHook;
 }
 
 //-------------------------------------------------------------------------
 static VOID DeleteHookEntry(UINT pos)
 {
+    HookIndexErase(&g_hooks.index, g_hooks.pItems[pos].pTarget);
+
     if (pos < g_hooks.size - 1)
+    {
         g_hooks.pItems[pos] = g_hooks.pItems[g_hooks.size - 1];
+        HookIndexUpdate(&g_hooks.index, g_hooks.pItems[pos].pTarget, pos);
+    }
 
     g_hooks.size--;
 
@@ -208,12 +254,13 @@ static VOID ProcessThreadIPs(HANDLE hThread, UINT pos, UINT action)
     DWORD   *pIP = &c.Eip;
 #endif
     UINT count;
+    BOOL batch = (pos == BATCH_HOOKS_POS);
 
     c.ContextFlags = CONTEXT_CONTROL;
     if (!GetThreadContext(hThread, &c))
         return;
 
-    if (pos == ALL_HOOKS_POS)
+    if (pos == ALL_HOOKS_POS || batch)
     {
         pos = 0;
         count = g_hooks.size;
@@ -229,6 +276,9 @@ static VOID ProcessThreadIPs(HANDLE hThread, UINT pos, UINT action)
         BOOL        enable;
         DWORD_PTR   ip;
 
+        if (batch && !pHook->inBatch)
+            continue;
+
         switch (action)
         {
         case ACTION_DISABLE:
@@ -476,25 +526,101 @@ static MH_STATUS EnableAllHooksLL(BOOL enable)
     return status;
 }
 
+//-------------------------------------------------------------------------
+// Enables or disables every entry with inBatch set under a single
+// Freeze()/Unfreeze(), then clears the flags.
+static MH_STATUS EnableBatchLL(BOOL enable)
+{
+    MH_STATUS status = MH_OK;
+    FROZEN_THREADS threads;
+    UINT i;
+
+    status = Freeze(&threads, BATCH_HOOKS_POS, enable ? ACTION_ENABLE : ACTION_DISABLE);
+    if (status == MH_OK)
+    {
+        for (i = 0; i < g_hooks.size; ++i)
+        {
+            if (g_hooks.pItems[i].inBatch && g_hooks.pItems[i].isEnabled != enable)
+            {
+                status = EnableHookLL(i, enable);
+                if (status != MH_OK)
+                    break;
+            }
+        }
+
+        Unfreeze(&threads);
+    }
+
+    for (i = 0; i < g_hooks.size; ++i)
+        g_hooks.pItems[i].inBatch = FALSE;
+
+    return status;
+}
+
+//-------------------------------------------------------------------------
+static HANDLE GetLockEvent(VOID)
+{
+    HANDLE hEvent = g_hLockEvent;
+    if (hEvent == NULL)
+    {
+        HANDLE hPrev;
+
+        hEvent = CreateEventW(NULL, FALSE, FALSE, NULL);
+        if (hEvent == NULL)
+            return NULL;
+
+        hPrev = InterlockedCompareExchangePointer((PVOID volatile *)&g_hLockEvent, hEvent, NULL);
+        if (hPrev != NULL)
+        {
+            CloseHandle(hEvent);
+            hEvent = hPrev;
+        }
+    }
+
+    return hEvent;
+}
+
 //-------------------------------------------------------------------------
 static VOID EnterSpinLock(VOID)
 {
-    SIZE_T spinCount = 0;
+    LONG limit = g_spinCount;
+    LONG spin;
+    HANDLE hEvent;
 
-    // Wait until the flag is FALSE.
-    while (InterlockedCompareExchange(&g_isLocked, TRUE, FALSE) != FALSE)
+    // No need to generate a memory barrier here, since InterlockedCompareExchange()
+    // generates a full memory barrier itself.
+
+    // Short critical sections (create/find) are usually over within a few
+    // hundred pauses; spin that long before paying for a kernel wait.
+    for (spin = 0; spin < limit; ++spin)
     {
-        // No need to generate a memory barrier here, since InterlockedCompareExchange()
-        // generates a full memory barrier itself.
+        if (g_isLocked == FALSE && InterlockedCompareExchange(&g_isLocked, TRUE, FALSE) == FALSE)
+        {
+            if (spin > 0 && limit < MAX_SPIN_COUNT)
+                g_spinCount = limit * 2;
+            return;
+        }
+
+        YieldProcessor();
+    }
 
-        // Prevent the loop from being too busy.
-        if (spinCount < 32)
-            Sleep(0);
+    // The holder is probably freezing threads: spin less next time and block.
+    if (limit > MIN_SPIN_COUNT)
+        g_spinCount = limit / 2;
+
+    hEvent = GetLockEvent();
+
+    // Registered before the retry, so a LeaveSpinLock() after our failed
+    // attempt sees the waiter and signals the event.
+    InterlockedIncrement(&g_lockWaiters);
+    while (InterlockedCompareExchange(&g_isLocked, TRUE, FALSE) != FALSE)
+    {
+        if (hEvent != NULL)
+            WaitForSingleObject(hEvent, INFINITE);
         else
             Sleep(1);
-
-        spinCount++;
     }
+    InterlockedDecrement(&g_lockWaiters);
 }
 
 //-------------------------------------------------------------------------
@@ -504,6 +630,9 @@ static VOID LeaveSpinLock(VOID)
     // generates a full memory barrier itself.
 
     InterlockedExchange(&g_isLocked, FALSE);
+
+    if (g_lockWaiters > 0 && g_hLockEvent != NULL)
+        SetEvent(g_hLockEvent);
 }
 
 //-------------------------------------------------------------------------
@@ -556,6 +685,7 @@ MH_STATUS WINAPI MH_Uninitialize(VOID)
             UninitializeBuffer();
 
             HeapFree(g_hHeap, 0, g_hooks.pItems);
+            HeapFree(g_hHeap, 0, g_hooks.index.pSlots);
             HeapDestroy(g_hHeap);
 
             g_hHeap = NULL;
@@ -563,6 +693,10 @@ MH_STATUS WINAPI MH_Uninitialize(VOID)
             g_hooks.pItems   = NULL;
             g_hooks.capacity = 0;
             g_hooks.size     = 0;
+
+            g_hooks.index.pSlots   = NULL;
+            g_hooks.index.capacity = 0;
+            g_hooks.index.size     = 0;
         }
     }
     else
@@ -576,91 +710,159 @@ MH_STATUS WINAPI MH_Uninitialize(VOID)
 }
 
 //-------------------------------------------------------------------------
-MH_STATUS WINAPI MH_CreateHook(LPVOID pTarget, LPVOID pDetour, LPVOID *ppOriginal)
+// pBuffer is a trampoline buffer allocated by the caller, or NULL to allocate
+// one here. It is freed if the hook is not created.
+static MH_STATUS CreateHookLL(LPVOID pTarget, LPVOID pDetour, LPVOID *ppOriginal, LPVOID pBuffer)
 {
     MH_STATUS status = MH_OK;
 
-    EnterSpinLock();
-
-    if (g_hHeap != NULL)
+    if (IsExecutableAddress(pTarget) && IsExecutableAddress(pDetour))
     {
-        if (IsExecutableAddress(pTarget) && IsExecutableAddress(pDetour))
+        UINT pos = FindHookEntry(pTarget);
+        if (pos == INVALID_HOOK_POS)
         {
-            UINT pos = FindHookEntry(pTarget);
-            if (pos == INVALID_HOOK_POS)
+            if (pBuffer == NULL)
+                pBuffer = AllocateBuffer(pTarget);
+
+            if (pBuffer != NULL)
             {
-                LPVOID pBuffer = AllocateBuffer(pTarget);
-                if (pBuffer != NULL)
-                {
-                    TRAMPOLINE ct;
+                TRAMPOLINE ct;
 
-                    ct.pTarget     = pTarget;
-                    ct.pDetour     = pDetour;
-                    ct.pTrampoline = pBuffer;
-                    if (CreateTrampolineFunction(&ct))
+                ct.pTarget     = pTarget;
+                ct.pDetour     = pDetour;
+                ct.pTrampoline = pBuffer;
+                if (CreateTrampolineFunction(&ct))
+                {
+                    PHOOK_ENTRY pHook = AddHookEntry(pTarget);
+                    if (pHook != NULL)
                     {
-                        PHOOK_ENTRY pHook = AddHookEntry();
-                        if (pHook != NULL)
-                        {
-                            pHook->pTarget     = ct.pTarget;
 #if defined(_M_X64) || defined(__x86_64__)
-                            pHook->pDetour     = ct.pRelay;
+                        pHook->pDetour     = ct.pRelay;
 #else
-                            pHook->pDetour     = ct.pDetour;
+                        pHook->pDetour     = ct.pDetour;
 #endif
-                            pHook->pTrampoline = ct.pTrampoline;
-                            pHook->patchAbove  = ct.patchAbove;
-                            pHook->isEnabled   = FALSE;
-                            pHook->queueEnable = FALSE;
-                            pHook->nIP         = ct.nIP;
-                            memcpy(pHook->oldIPs, ct.oldIPs, ARRAYSIZE(ct.oldIPs));
-                            memcpy(pHook->newIPs, ct.newIPs, ARRAYSIZE(ct.newIPs));
-
-                            // Back up the target function.
-
-                            if (ct.patchAbove)
-                            {
-                                memcpy(
-                                    pHook->backup,
-                                    (LPBYTE)pTarget - sizeof(JMP_REL),
-                                    sizeof(JMP_REL) + sizeof(JMP_REL_SHORT));
-                            }
-                            else
-                            {
-                                memcpy(pHook->backup, pTarget, sizeof(JMP_REL));
-                            }
-
-                            if (ppOriginal != NULL)
-                                *ppOriginal = pHook->pTrampoline;
+                        pHook->pTrampoline = ct.pTrampoline;
+                        pHook->patchAbove  = ct.patchAbove;
+                        pHook->isEnabled   = FALSE;
+                        pHook->queueEnable = FALSE;
+                        pHook->nIP         = ct.nIP;
+                        memcpy(pHook->oldIPs, ct.oldIPs, ARRAYSIZE(ct.oldIPs));
+                        memcpy(pHook->newIPs, ct.newIPs, ARRAYSIZE(ct.newIPs));
+
+                        // Back up the target function.
+
+                        if (ct.patchAbove)
+                        {
+                            memcpy(
+                                pHook->backup,
+                                (LPBYTE)pTarget - sizeof(JMP_REL),
+                                sizeof(JMP_REL) + sizeof(JMP_REL_SHORT));
                         }
                         else
                         {
-                            status = MH_ERROR_MEMORY_ALLOC;
+                            memcpy(pHook->backup, pTarget, sizeof(JMP_REL));
                         }
+
+                        if (ppOriginal != NULL)
+                            *ppOriginal = pHook->pTrampoline;
                     }
                     else
                     {
-                        status = MH_ERROR_UNSUPPORTED_FUNCTION;
-                    }
-
-                    if (status != MH_OK)
-                    {
-                        FreeBuffer(pBuffer);
+                        status = MH_ERROR_MEMORY_ALLOC;
                     }
                 }
                 else
                 {
-                    status = MH_ERROR_MEMORY_ALLOC;
+                    status = MH_ERROR_UNSUPPORTED_FUNCTION;
                 }
             }
             else
             {
-                status = MH_ERROR_ALREADY_CREATED;
+                status = MH_ERROR_MEMORY_ALLOC;
             }
         }
         else
         {
-            status = MH_ERROR_NOT_EXECUTABLE;
+            status = MH_ERROR_ALREADY_CREATED;
+        }
+    }
+    else
+    {
+        status = MH_ERROR_NOT_EXECUTABLE;
+    }
+
+    if (status != MH_OK && pBuffer != NULL)
+        FreeBuffer(pBuffer);
+
+    return status;
+}
+
+//-------------------------------------------------------------------------
+MH_STATUS WINAPI MH_CreateHook(LPVOID pTarget, LPVOID pDetour, LPVOID *ppOriginal)
+{
+    MH_STATUS status = MH_OK;
+
+    EnterSpinLock();
+
+    if (g_hHeap != NULL)
+        status = CreateHookLL(pTarget, pDetour, ppOriginal, NULL);
+    else
+        status = MH_ERROR_NOT_INITIALIZED;
+
+    LeaveSpinLock();
+
+    return status;
+}
+
+//-------------------------------------------------------------------------
+MH_STATUS WINAPI MH_CreateHooks(MH_HOOK_DESC *pHooks, UINT count, BOOL enable)
+{
+    MH_STATUS status = MH_OK;
+    UINT i;
+
+    EnterSpinLock();
+
+    if (g_hHeap != NULL)
+    {
+        // Allocate all the trampoline buffers up front. Without the scratch
+        // arrays, each hook allocates its own.
+        LPVOID *ppBuffers = NULL;
+        if (count > 1)
+            ppBuffers = (LPVOID *)HeapAlloc(g_hHeap, 0, count * 2 * sizeof(LPVOID));
+
+        if (ppBuffers != NULL)
+        {
+            LPVOID *ppOrigins = ppBuffers + count;
+            for (i = 0; i < count; ++i)
+                ppOrigins[i] = pHooks[i].pTarget;
+
+            AllocateBuffers(ppOrigins, ppBuffers, count);
+        }
+
+        for (i = 0; i < count; ++i)
+        {
+            pHooks[i].status = CreateHookLL(
+                pHooks[i].pTarget, pHooks[i].pDetour, pHooks[i].ppOriginal,
+                (ppBuffers != NULL) ? ppBuffers[i] : NULL);
+            if (pHooks[i].status != MH_OK)
+            {
+                if (status == MH_OK)
+                    status = pHooks[i].status;
+            }
+            else if (enable)
+            {
+                g_hooks.pItems[FindHookEntry(pHooks[i].pTarget)].inBatch = TRUE;
+            }
+        }
+
+        if (ppBuffers != NULL)
+            HeapFree(g_hHeap, 0, ppBuffers);
+
+        if (enable)
+        {
+            MH_STATUS enableStatus = EnableBatchLL(TRUE);
+            if (status == MH_OK)
+                status = enableStatus;
         }
     }
     else
@@ -739,7 +941,7 @@ static MH_STATUS EnableHook(LPVOID pTarget, BOOL enable)
                 if (g_hooks.pItems[pos].isEnabled != enable)
                 {
                     FROZEN_THREADS threads;
-                    status = Freeze(&threads, pos, ACTION_ENABLE);
+                    status = Freeze(&threads, pos, enable ? ACTION_ENABLE : ACTION_DISABLE);
                     if (status == MH_OK)
                     {
                         status = EnableHookLL(pos, enable);
@@ -780,6 +982,65 @@ MH_STATUS WINAPI MH_DisableHook(LPVOID pTarget)
     return EnableHook(pTarget, FALSE);
 }
 
+//-------------------------------------------------------------------------
+static MH_STATUS EnableHooks(LPVOID *ppTargets, UINT count, BOOL enable)
+{
+    MH_STATUS status = MH_OK;
+    UINT i;
+
+    EnterSpinLock();
+
+    if (g_hHeap != NULL)
+    {
+        // Check every target first, so a bad one changes nothing.
+        for (i = 0; i < count; ++i)
+        {
+            if (FindHookEntry(ppTargets[i]) == INVALID_HOOK_POS)
+            {
+                status = MH_ERROR_NOT_CREATED;
+                break;
+            }
+        }
+
+        if (status == MH_OK)
+        {
+            BOOL any = FALSE;
+            for (i = 0; i < count; ++i)
+            {
+                PHOOK_ENTRY pHook = &g_hooks.pItems[FindHookEntry(ppTargets[i])];
+                if (pHook->isEnabled != enable)
+                {
+                    pHook->inBatch = TRUE;
+                    any = TRUE;
+                }
+            }
+
+            if (any)
+                status = EnableBatchLL(enable);
+        }
+    }
+    else
+    {
+        status = MH_ERROR_NOT_INITIALIZED;
+    }
+
+    LeaveSpinLock();
+
+    return status;
+}
+
+//-------------------------------------------------------------------------
+MH_STATUS WINAPI MH_EnableHooks(LPVOID *ppTargets, UINT count)
+{
+    return EnableHooks(ppTargets, count, TRUE);
+}
+
+//-------------------------------------------------------------------------
+MH_STATUS WINAPI MH_DisableHooks(LPVOID *ppTargets, UINT count)
+{
+    return EnableHooks(ppTargets, count, FALSE);
+}
+
 //-------------------------------------------------------------------------
 static MH_STATUS QueueHook(LPVOID pTarget, BOOL queueEnable)
 {
@@ -0,0 +1,155 @@
+﻿/*
+ *  MinHook - The Minimalistic API Hooking Library for x64/x86
+ *  Copyright (C) 2009-2017 Tsuda Kageyu.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ *  TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ *  PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER
+ *  OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ *  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ *  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ *  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ *  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ *  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ *  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "hook_index.h"
+
+//-------------------------------------------------------------------------
+static uint32_t HashTarget(const void *pTarget, uint32_t mask)
+{
+    // Fibonacci hashing: function addresses share their low (alignment) bits.
+    uint64_t h = (uint64_t)(uintptr_t)pTarget * 0x9E3779B97F4A7C15ull;
+    return (uint32_t)(h >> 32) & mask;
+}
+
+//-------------------------------------------------------------------------
+static uint32_t FindSlot(const HOOK_INDEX *pIndex, const void *pTarget)
+{
+    uint32_t mask = pIndex->capacity - 1;
+    uint32_t i    = HashTarget(pTarget, mask);
+
+    while (pIndex->pSlots[i].pTarget != NULL)
+    {
+        if (pIndex->pSlots[i].pTarget == pTarget)
+            return i;
+
+        i = (i + 1) & mask;
+    }
+
+    return HOOK_INDEX_NONE;
+}
+
+//-------------------------------------------------------------------------
+uint32_t HookIndexCapacityFor(uint32_t count)
+{
+    uint32_t capacity = 16;
+    while (capacity < count * 2)
+        capacity *= 2;
+
+    return capacity;
+}
+
+//-------------------------------------------------------------------------
+HOOK_INDEX_SLOT *HookIndexRehash(HOOK_INDEX *pIndex, HOOK_INDEX_SLOT *pSlots, uint32_t capacity)
+{
+    HOOK_INDEX_SLOT *pOld     = pIndex->pSlots;
+    uint32_t         oldCount = pIndex->capacity;
+    uint32_t         i;
+
+    pIndex->pSlots   = pSlots;
+    pIndex->capacity = capacity;
+    pIndex->size     = 0;
+
+    for (i = 0; i < oldCount; ++i)
+    {
+        if (pOld[i].pTarget != NULL)
+            HookIndexInsert(pIndex, pOld[i].pTarget, pOld[i].pos);
+    }
+
+    return pOld;
+}
+
+//-------------------------------------------------------------------------
+uint32_t HookIndexFind(const HOOK_INDEX *pIndex, const void *pTarget)
+{
+    uint32_t slot;
+
+    if (pIndex->capacity == 0 || pTarget == NULL)
+        return HOOK_INDEX_NONE;
+
+    slot = FindSlot(pIndex, pTarget);
+    return slot == HOOK_INDEX_NONE ? HOOK_INDEX_NONE : pIndex->pSlots[slot].pos;
+}
+
+//-------------------------------------------------------------------------
+void HookIndexInsert(HOOK_INDEX *pIndex, void *pTarget, uint32_t pos)
+{
+    uint32_t mask = pIndex->capacity - 1;
+    uint32_t i    = HashTarget(pTarget, mask);
+
+    while (pIndex->pSlots[i].pTarget != NULL)
+        i = (i + 1) & mask;
+
+    pIndex->pSlots[i].pTarget = pTarget;
+    pIndex->pSlots[i].pos     = pos;
+    pIndex->size++;
+}
+
+//-------------------------------------------------------------------------
+void HookIndexUpdate(HOOK_INDEX *pIndex, const void *pTarget, uint32_t pos)
+{
+    uint32_t slot = FindSlot(pIndex, pTarget);
+    if (slot != HOOK_INDEX_NONE)
+        pIndex->pSlots[slot].pos = pos;
+}
+
+//-------------------------------------------------------------------------
+void HookIndexErase(HOOK_INDEX *pIndex, const void *pTarget)
+{
+    uint32_t mask = pIndex->capacity - 1;
+    uint32_t hole, i;
+
+    if (pIndex->capacity == 0)
+        return;
+
+    hole = FindSlot(pIndex, pTarget);
+    if (hole == HOOK_INDEX_NONE)
+        return;
+
+    // Backward-shift deletion: pull later entries of the probe run into the
+    // hole unless that would move them before their home slot.
+    i = hole;
+    for (;;)
+    {
+        uint32_t home;
+
+        i = (i + 1) & mask;
+        if (pIndex->pSlots[i].pTarget == NULL)
+            break;
+
+        home = HashTarget(pIndex->pSlots[i].pTarget, mask);
+        if (((i - home) & mask) >= ((i - hole) & mask))
+        {
+            pIndex->pSlots[hole] = pIndex->pSlots[i];
+            hole = i;
+        }
+    }
+
+    pIndex->pSlots[hole].pTarget = NULL;
+    pIndex->pSlots[hole].pos     = 0;
+    pIndex->size--;
+}
@@ -0,0 +1,70 @@
+﻿/*
+ *  MinHook - The Minimalistic API Hooking Library for x64/x86
+ *  Copyright (C) 2009-2017 Tsuda Kageyu.
+ *  All rights reserved.
+ *
+ *  Redistribution and use in source and binary forms, with or without
+ *  modification, are permitted provided that the following conditions
+ *  are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright
+ *      notice, this list of conditions and the following disclaimer.
+ *   2. Redistributions in binary form must reproduce the above copyright
+ *      notice, this list of conditions and the following disclaimer in the
+ *      documentation and/or other materials provided with the distribution.
+ *
+ *  THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *  "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ *  TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A
+ *  PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER
+ *  OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ *  EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ *  PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ *  PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ *  LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ *  NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ *  SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#pragma once
+
+// Hash index from target address to position in the hook entry array, so
+// create/enable/disable/remove do not scan every hook. Open addressing with
+// linear probing, load factor <= 1/2. Portable C: the caller owns the slot
+// memory (the MinHook private heap here, malloc in the Linux benchmark).
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define HOOK_INDEX_NONE UINT32_MAX
+
+typedef struct _HOOK_INDEX_SLOT
+{
+    void    *pTarget;       // NULL if empty.
+    uint32_t pos;
+} HOOK_INDEX_SLOT;
+
+typedef struct _HOOK_INDEX
+{
+    HOOK_INDEX_SLOT *pSlots;
+    uint32_t         capacity;  // Power of two, or 0.
+    uint32_t         size;
+} HOOK_INDEX;
+
+// Slot count needed to hold count entries.
+uint32_t HookIndexCapacityFor(uint32_t count);
+
+// Moves every entry of pIndex into pSlots (capacity zeroed slots) and makes
+// it the index's table. The old table is returned for the caller to free.
+HOOK_INDEX_SLOT *HookIndexRehash(HOOK_INDEX *pIndex, HOOK_INDEX_SLOT *pSlots, uint32_t capacity);
+
+// Returns HOOK_INDEX_NONE if not found.
+uint32_t HookIndexFind(const HOOK_INDEX *pIndex, const void *pTarget);
+
+// The caller checks the capacity first (HookIndexCapacityFor(size + 1)).
+void HookIndexInsert(HOOK_INDEX *pIndex, void *pTarget, uint32_t pos);
+
+// Sets the position of an existing entry (after the entry array moved it).
+void HookIndexUpdate(HOOK_INDEX *pIndex, const void *pTarget, uint32_t pos);
+
+void HookIndexErase(HOOK_INDEX *pIndex, const void *pTarget);
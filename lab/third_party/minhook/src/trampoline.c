@@ -47,6 +47,7 @@
     #define HDE_DISASM(code, hs) hde32_disasm(code, hs)
 #endif
 
+#include "./hde/hde_batch.h"
 #include "trampoline.h"
 #include "buffer.h"
 
@@ -57,6 +58,10 @@
     #define TRAMPOLINE_MAX_SIZE MEMORY_SLOT_SIZE
 #endif
 
+// Lengths of prologue instructions that needed the full decoder, so that
+// hooking the same function again skips it. Used under the MinHook lock.
+static hde_cache g_decodeCache;
+
 //-------------------------------------------------------------------------
 static BOOL IsCodePadding(LPBYTE pInst, UINT size)
 {
@@ -120,15 +125,21 @@ BOOL CreateTrampolineFunction(PTRAMPOLINE ct)
     do
     {
         HDE       hs;
+        hde_insn  insn;
         UINT      copySize;
         LPVOID    pCopySrc;
         ULONG_PTR pOldInst = (ULONG_PTR)ct->pTarget     + oldPos;
         ULONG_PTR pNewInst = (ULONG_PTR)ct->pTrampoline + newPos;
 
-        copySize = HDE_DISASM((LPVOID)pOldInst, &hs);
-        if (hs.flags & F_ERROR)
+        // Most prologue instructions are copied as they are; only the ones
+        // with relative operands or RET need the full decoder.
+        copySize = hde_insn_decode((LPVOID)pOldInst, &insn, &g_decodeCache);
+        if (copySize == 0)
             return FALSE;
 
+        if (insn.flags != 0)
+            HDE_DISASM((LPVOID)pOldInst, &hs);
+
         pCopySrc = (LPVOID)pOldInst;
         if (oldPos >= sizeof(JMP_REL))
         {
@@ -144,6 +155,10 @@ BOOL CreateTrampolineFunction(PTRAMPOLINE ct)
 
             finished = TRUE;
         }
+        else if (insn.flags == 0)
+        {
+            // Copy the instruction as it is.
+        }
 #if defined(_M_X64) || defined(__x86_64__)
         else if ((hs.modrm & 0xC7) == 0x05)
         {
@@ -262,7 +277,7 @@ BOOL CreateTrampolineFunction(PTRAMPOLINE ct)
         }
 
         // Can't alter the instruction length in a branch.
-        if (pOldInst < jmpDest && copySize != hs.len)
+        if (pOldInst < jmpDest && copySize != insn.len)
             return FALSE;
 
         // Trampoline function is too large.
@@ -284,7 +299,7 @@ BOOL CreateTrampolineFunction(PTRAMPOLINE ct)
         __movsb((LPBYTE)ct->pTrampoline + newPos, (LPBYTE)pCopySrc, copySize);
 #endif
         newPos += copySize;
-        oldPos += hs.len;
+        oldPos += insn.len;
     } while (!finished);
 
     // Is there enough place for a long jump?
@@ -0,0 +1,23 @@
+#pragma once
+
+// Flags frames that stand out from the recent frame rate: longer than ratio x
+// the running average and at least minMs above it. The average follows the
+// frame time slowly, so a sustained drop in FPS is not reported frame after
+// frame, only its first frames.
+class HitchDetector {
+public:
+    HitchDetector(float ratio = 2.0f, float minMs = 4.0f) : m_ratio(ratio), m_minMs(minMs) {}
+
+    bool Add(double frameMs) {
+        bool hitch = m_averageMs > 0.0 && frameMs > m_averageMs * m_ratio && frameMs - m_averageMs > m_minMs;
+        m_averageMs = m_averageMs > 0.0 ? m_averageMs * 0.95 + frameMs * 0.05 : frameMs;
+        return hitch;
+    }
+
+    double AverageMs() const { return m_averageMs; }
+
+private:
+    double m_ratio;
+    double m_minMs;
+    double m_averageMs = 0.0;
+};
@@ -0,0 +1,413 @@
+#include "html_report.h"
+#include "frame_heatmap.h"
+#include "hitch.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <string>
+
+namespace HtmlReport {
+    static const size_t kLevelColumns[] = { 1024, 8192, 65536 };
+    static const double kPercentiles[] = { 0.50, 0.90, 0.95, 0.99, 0.999 };
+
+    struct Level {
+        size_t columns;
+        std::vector<float> minMs;
+        std::vector<float> maxMs;
+    };
+
+    struct Hitch {
+        double seconds;
+        float ms;
+    };
+
+    struct Segment {
+        double startSeconds;
+        size_t first;       // Index range into frameMs
+        size_t count;
+        double sumMs;
+        float maxMs;
+        size_t hitches;
+        float p99Ms;
+    };
+
+    struct Summary {
+        std::string name;
+        std::string exeName;
+        uint32_t pid = 0;
+        double durationSeconds = 0.0;
+        size_t frames = 0;
+        double averageFps = 0.0;
+        double lowFps = 0.0;            // Average FPS of the slowest 1% of frames
+        float percentileMs[sizeof(kPercentiles) / sizeof(kPercentiles[0])] = {};
+        float maxMs = 0.0f;
+        size_t hitchCount = 0;
+        std::vector<Level> levels;
+        uint64_t histogram[FrameHeatmap::kBuckets] = {};
+        std::vector<Segment> segments;
+        std::vector<Hitch> hitches;     // Longest ones, in time order
+    };
+
+    // One pass over the mapped frames of the primary swapchain; frame times
+    // are kept as floats (4 bytes per frame) for the exact percentiles
+    static bool Analyze(const Input& input, const Options& options, Summary& s) {
+        const Capture::Reader& reader = *input.reader;
+        const Capture::FileHeader& header = reader.Header();
+
+        uint32_t primary = 0;
+        size_t frames = 0;
+        if (!reader.FindPrimarySwapChain(&primary, &frames) || frames < 2) return false;
+
+        uint64_t firstQpc = 0;
+        uint64_t lastQpc = 0;
+        reader.ForEachFrame([&](const Capture::FrameRecord& f) {
+            if (f.swapChainId != primary) return;
+            if (firstQpc == 0) firstQpc = f.presentQpc;
+            lastQpc = f.presentQpc;
+        });
+        if (lastQpc <= firstQpc) return false;
+
+        const char* name = std::strrchr(input.path, '/');
+        const char* name2 = std::strrchr(input.path, '\\');
+        if (name2 > name) name = name2;
+        s.name = name ? name + 1 : input.path;
+        s.exeName.assign(header.exeName, strnlen(header.exeName, sizeof(header.exeName)));
+        s.pid = header.pid;
+
+        const double secondsPerTick = 1.0 / static_cast<double>(header.qpcFrequency);
+        const double duration = (lastQpc - firstQpc) * secondsPerTick;
+        s.durationSeconds = duration;
+
+        for (size_t columns : kLevelColumns) {
+            if (columns > 1024 && frames < columns * 2) break;
+            Level level;
+            level.columns = columns;
+            level.minMs.assign(columns, NAN);
+            level.maxMs.assign(columns, NAN);
+            s.levels.push_back(std::move(level));
+        }
+
+        std::vector<float> frameMs;
+        frameMs.reserve(frames);
+        std::vector<Hitch> hitches;
+        HitchDetector detector;
+        Segment* segment = nullptr;
+        uint64_t last = 0;
+        double sumMs = 0.0;
+
+        reader.ForEachFrame([&](const Capture::FrameRecord& f) {
+            if (f.swapChainId != primary) return;
+            if (last == 0 || f.presentQpc <= last) {
+                last = f.presentQpc;
+                return;
+            }
+
+            // Frame i is the interval ending at this Present
+            float ms = static_cast<float>((f.presentQpc - last) * secondsPerTick * 1000.0);
+            double t = (last - firstQpc) * secondsPerTick;
+            last = f.presentQpc;
+
+            for (Level& level : s.levels) {
+                size_t column = static_cast<size_t>(t / duration * level.columns);
+                if (column >= level.columns) column = level.columns - 1;
+                float& lo = level.minMs[column];
+                float& hi = level.maxMs[column];
+                if (std::isnan(lo) || ms < lo) lo = ms;
+                if (std::isnan(hi) || ms > hi) hi = ms;
+            }
+
+            s.histogram[FrameHeatmap::BucketOf(ms)]++;
+            if (ms > s.maxMs) s.maxMs = ms;
+            sumMs += ms;
+
+            size_t segmentIndex = static_cast<size_t>(t / options.segmentSeconds);
+            while (s.segments.size() <= segmentIndex) {
+                Segment next = {};
+                next.startSeconds = s.segments.size() * options.segmentSeconds;
+                next.first = frameMs.size();
+                s.segments.push_back(next);
+            }
+            segment = &s.segments[segmentIndex];
+            segment->count++;
+            segment->sumMs += ms;
+            if (ms > segment->maxMs) segment->maxMs = ms;
+
+            if (detector.Add(ms)) {
+                hitches.push_back(Hitch{ t, ms });
+                segment->hitches++;
+            }
+            frameMs.push_back(ms);
+        });
+
+        s.frames = frameMs.size();
+        if (s.frames == 0) return false;
+        s.averageFps = s.frames * 1000.0 / sumMs;
+        s.hitchCount = hitches.size();
+
+        // Segment p99 before the full array is reordered below
+        std::vector<float> scratch;
+        for (Segment& seg : s.segments) {
+            if (seg.count == 0) continue;
+            scratch.assign(frameMs.begin() + seg.first, frameMs.begin() + seg.first + seg.count);
+            size_t k = static_cast<size_t>(0.99 * (scratch.size() - 1));
+            std::nth_element(scratch.begin(), scratch.begin() + k, scratch.end());
+            seg.p99Ms = scratch[k];
+        }
+
+        // Each nth_element narrows the range for the next (percentiles ascend)
+        size_t from = 0;
+        for (size_t i = 0; i < sizeof(kPercentiles) / sizeof(kPercentiles[0]); i++) {
+            size_t k = static_cast<size_t>(kPercentiles[i] * (frameMs.size() - 1));
+            std::nth_element(frameMs.begin() + from, frameMs.begin() + k, frameMs.end());
+            s.percentileMs[i] = frameMs[k];
+            from = k;
+        }
+
+        // 1% low: average over the slowest 1% of frames
+        size_t lowCount = frameMs.size() / 100 > 0 ? frameMs.size() / 100 : 1;
+        std::nth_element(frameMs.begin(), frameMs.end() - lowCount, frameMs.end());
+        double lowSum = 0.0;
+        for (size_t i = frameMs.size() - lowCount; i < frameMs.size(); i++) lowSum += frameMs[i];
+        s.lowFps = lowCount * 1000.0 / lowSum;
+
+        if (hitches.size() > options.maxHitches) {
+            std::nth_element(hitches.begin(), hitches.begin() + options.maxHitches, hitches.end(),
+                             [](const Hitch& a, const Hitch& b) { return a.ms > b.ms; });
+            hitches.resize(options.maxHitches);
+            std::sort(hitches.begin(), hitches.end(),
+                      [](const Hitch& a, const Hitch& b) { return a.seconds < b.seconds; });
+        }
+        s.hitches = std::move(hitches);
+        return true;
+    }
+
+    static void WriteEscaped(std::FILE* out, const std::string& text) {
+        for (char c : text) {
+            switch (c) {
+            case '<': std::fputs("&lt;", out); break;
+            case '>': std::fputs("&gt;", out); break;
+            case '&': std::fputs("&amp;", out); break;
+            case '"': std::fputs("&quot;", out); break;
+            case '\\': std::fputs("&#92;", out); break;
+            default: std::fputc(c, out); break;
+            }
+        }
+    }
+
+    static void WriteFloatArray(std::FILE* out, const std::vector<float>& values) {
+        std::fputc('[', out);
+        for (size_t i = 0; i < values.size(); i++) {
+            if (i) std::fputc(',', out);
+            if (std::isnan(values[i])) {
+                std::fputs("null", out);
+            } else {
+                std::fprintf(out, "%.2f", values[i]);
+            }
+        }
+        std::fputc(']', out);
+    }
+
+    static void WriteStyle(std::FILE* out) {
+        std::fputs(
+            "<style>\n"
+            "body { margin: 0; padding: 20px 32px; background: #1a1a2e; color: #eee; font-family: 'Segoe UI', Arial, sans-serif; }\n"
+            "h1 { margin-bottom: 4px; } h2 { color: #ccc; margin-top: 40px; border-bottom: 1px solid #333; padding-bottom: 6px; }\n"
+            "h3 { color: #aaa; font-size: 15px; margin: 20px 0 8px; }\n"
+            ".sub { color: #888; font-size: 13px; }\n"
+            "table { border-collapse: collapse; font-size: 13px; margin: 6px 0; }\n"
+            "th, td { padding: 4px 10px; text-align: right; border-bottom: 1px solid #2d3436; }\n"
+            "th { color: #aaa; font-weight: normal; } td.l, th.l { text-align: left; }\n"
+            ".scroll { max-height: 320px; overflow-y: auto; display: inline-block; }\n"
+            "canvas { width: 100%; background: #11111f; border: 1px solid #333; border-radius: 4px; cursor: crosshair; }\n"
+            ".chart { height: 260px; } .hist { height: 180px; }\n"
+            ".row { display: flex; gap: 32px; flex-wrap: wrap; align-items: flex-start; }\n"
+            ".good { color: #00e664; } .warn { color: #ffc800; } .bad { color: #ff4040; }\n"
+            "</style>\n", out);
+    }
+
+    static const char* FpsClass(double fps) {
+        return fps >= 60.0 ? "good" : fps >= 30.0 ? "warn" : "bad";
+    }
+
+    static void WriteSummaryRow(std::FILE* out, const Summary& s) {
+        std::fputs("<tr><td class=\"l\">", out);
+        WriteEscaped(out, s.name);
+        std::fputs("</td><td class=\"l\">", out);
+        WriteEscaped(out, s.exeName);
+        std::fprintf(out, "</td><td>%.1f s</td><td>%zu</td><td class=\"%s\">%.1f</td><td class=\"%s\">%.1f</td>"
+                          "<td>%.2f</td><td>%.2f</td><td>%zu</td></tr>\n",
+                     s.durationSeconds, s.frames, FpsClass(s.averageFps), s.averageFps, FpsClass(s.lowFps), s.lowFps,
+                     s.percentileMs[0], s.percentileMs[3], s.hitchCount);
+    }
+
+    static void WriteCaptureSection(std::FILE* out, const Summary& s, size_t index) {
+        std::fputs("<h2>", out);
+        WriteEscaped(out, s.name);
+        std::fputs("</h2>\n<div class=\"sub\">", out);
+        WriteEscaped(out, s.exeName);
+        std::fprintf(out, " &middot; pid %u &middot; %.1f s &middot; %zu frames &middot; drag to zoom, double-click to reset</div>\n",
+                     s.pid, s.durationSeconds, s.frames);
+        std::fprintf(out, "<h3>Frame time (ms)</h3><canvas class=\"chart\" id=\"chart%zu\"></canvas>\n", index);
+        std::fprintf(out, "<h3>Histogram</h3><canvas class=\"hist\" id=\"hist%zu\"></canvas>\n", index);
+
+        std::fputs("<div class=\"row\"><div><h3>Percentiles</h3><table><tr><th class=\"l\">percentile</th><th>ms</th><th>FPS</th></tr>\n", out);
+        for (size_t i = 0; i < sizeof(kPercentiles) / sizeof(kPercentiles[0]); i++) {
+            float ms = s.percentileMs[i];
+            std::fprintf(out, "<tr><td class=\"l\">p%g</td><td>%.2f</td><td>%.1f</td></tr>\n",
+                         kPercentiles[i] * 100.0, ms, ms > 0.0f ? 1000.0 / ms : 0.0);
+        }
+        std::fprintf(out, "<tr><td class=\"l\">max</td><td>%.2f</td><td>%.1f</td></tr>\n",
+                     s.maxMs, s.maxMs > 0.0f ? 1000.0 / s.maxMs : 0.0);
+        std::fprintf(out, "<tr><td class=\"l\">average</td><td>%.2f</td><td>%.1f</td></tr>\n",
+                     1000.0 / s.averageFps, s.averageFps);
+        std::fprintf(out, "<tr><td class=\"l\">1%% low</td><td>%.2f</td><td>%.1f</td></tr>\n",
+                     1000.0 / s.lowFps, s.lowFps);
+        std::fputs("</table></div>\n", out);
+
+        std::fputs("<div><h3>Segments</h3><div class=\"scroll\"><table><tr><th class=\"l\">start</th><th>frames</th>"
+                   "<th>avg FPS</th><th>p99 ms</th><th>max ms</th><th>hitches</th></tr>\n", out);
+        for (const Segment& seg : s.segments) {
+            if (seg.count == 0) {
+                std::fprintf(out, "<tr><td class=\"l\">%.0f s</td><td>0</td><td>-</td><td>-</td><td>-</td><td>0</td></tr>\n",
+                             seg.startSeconds);
+                continue;
+            }
+            double fps = seg.count * 1000.0 / seg.sumMs;
+            std::fprintf(out, "<tr><td class=\"l\">%.0f s</td><td>%zu</td><td class=\"%s\">%.1f</td><td>%.2f</td><td>%.2f</td><td>%zu</td></tr>\n",
+                         seg.startSeconds, seg.count, FpsClass(fps), fps, seg.p99Ms, seg.maxMs, seg.hitches);
+        }
+        std::fputs("</table></div></div>\n", out);
+
+        std::fprintf(out, "<div><h3>Hitches (%zu total, longest %zu listed)</h3><div class=\"scroll\"><table>"
+                          "<tr><th class=\"l\">time</th><th>ms</th></tr>\n", s.hitchCount, s.hitches.size());
+        for (const Hitch& h : s.hitches) {
+            std::fprintf(out, "<tr><td class=\"l\">%.3f s</td><td class=\"bad\">%.2f</td></tr>\n", h.seconds, h.ms);
+        }
+        std::fputs("</table></div></div></div>\n", out);
+    }
+
+    static void WriteData(std::FILE* out, const std::vector<Summary>& summaries) {
+        std::fputs("<script>\nconst REPORT = [\n", out);
+        for (const Summary& s : summaries) {
+            std::fprintf(out, "{duration:%.6f,p99:%.3f,levels:[", s.durationSeconds, s.percentileMs[3]);
+            for (size_t i = 0; i < s.levels.size(); i++) {
+                if (i) std::fputc(',', out);
+                std::fputs("{min:", out);
+                WriteFloatArray(out, s.levels[i].minMs);
+                std::fputs(",max:", out);
+                WriteFloatArray(out, s.levels[i].maxMs);
+                std::fputc('}', out);
+            }
+            std::fputs("],hist:[", out);
+            for (uint32_t b = 0; b < FrameHeatmap::kBuckets; b++) {
+                if (b) std::fputc(',', out);
+                std::fprintf(out, "%llu", static_cast<unsigned long long>(s.histogram[b]));
+            }
+            std::fputs("]},\n", out);
+        }
+        std::fprintf(out, "];\nconst HIST_PER_OCTAVE = %u, HIST_MIN_EXP = %d;\n</script>\n",
+                     FrameHeatmap::kBucketsPerOctave, FrameHeatmap::kMinExponent);
+    }
+
+    // Canvas rendering; every pixel column takes min/max over the data columns
+    // under it, from the coarsest level that still has >= 1 column per pixel
+    static void WriteScript(std::FILE* out) {
+        std::fputs(
+            "<script>\n"
+            "function color(ms) { return ms <= 1000 / 60 ? '#00e664' : ms <= 1000 / 30 ? '#ffc800' : '#ff4040'; }\n"
+            "function setup(c) { const r = window.devicePixelRatio || 1; c.width = c.clientWidth * r; c.height = c.clientHeight * r;"
+            " const g = c.getContext('2d'); g.setTransform(r, 0, 0, r, 0, 0); return g; }\n"
+            "function drawChart(i) {\n"
+            "  const d = REPORT[i], c = document.getElementById('chart' + i), g = setup(c);\n"
+            "  const w = c.clientWidth, h = c.clientHeight, pad = 40, pw = w - pad - 8, ph = h - 24;\n"
+            "  const v = d.view || [0, d.duration], span = v[1] - v[0];\n"
+            "  let lv = d.levels[d.levels.length - 1];\n"
+            "  for (const l of d.levels) { if (l.min.length * span / d.duration >= pw) { lv = l; break; } }\n"
+            "  const n = lv.min.length, c0 = Math.floor(v[0] / d.duration * n), c1 = Math.min(n, Math.ceil(v[1] / d.duration * n));\n"
+            "  const lo = new Float32Array(pw).fill(NaN), hi = new Float32Array(pw).fill(NaN);\n"
+            "  let top = 0;\n"
+            "  for (let k = c0; k < c1; k++) {\n"
+            "    if (lv.max[k] === null) continue;\n"
+            "    const x = Math.min(pw - 1, Math.floor(((k + 0.5) * d.duration / n - v[0]) / span * pw));\n"
+            "    if (x < 0) continue;\n"
+            "    if (!(lo[x] <= lv.min[k])) lo[x] = lv.min[k];\n"
+            "    if (!(hi[x] >= lv.max[k])) hi[x] = lv.max[k];\n"
+            "    if (lv.max[k] > top) top = lv.max[k];\n"
+            "  }\n"
+            "  top = Math.max(top * 1.05, 20);\n"
+            "  g.font = '11px Segoe UI, Arial'; g.fillStyle = '#888'; g.strokeStyle = '#333';\n"
+            "  for (const ms of [1000 / 60, 1000 / 30, top / 2, top]) {\n"
+            "    const y = 4 + ph - ms / top * ph; g.beginPath(); g.moveTo(pad, y); g.lineTo(pad + pw, y); g.stroke();\n"
+            "    g.fillText(ms.toFixed(1), 2, y + 4);\n"
+            "  }\n"
+            "  for (let x = 0; x < pw; x++) {\n"
+            "    if (isNaN(hi[x])) continue;\n"
+            "    const y0 = 4 + ph - hi[x] / top * ph, y1 = 4 + ph - lo[x] / top * ph;\n"
+            "    g.fillStyle = color(hi[x]); g.fillRect(pad + x, y0, 1, Math.max(1, y1 - y0));\n"
+            "  }\n"
+            "  g.fillStyle = '#888'; g.fillText(v[0].toFixed(1) + ' s', pad, h - 4);\n"
+            "  const end = v[1].toFixed(1) + ' s'; g.fillText(end, pad + pw - g.measureText(end).width, h - 4);\n"
+            "  if (d.drag) { g.fillStyle = 'rgba(255,255,255,0.15)'; g.fillRect(Math.min(d.drag[0], d.drag[1]), 0, Math.abs(d.drag[1] - d.drag[0]), h); }\n"
+            "  d.toTime = (px) => v[0] + Math.max(0, Math.min(pw, px - pad)) / pw * span;\n"
+            "}\n"
+            "function drawHist(i) {\n"
+            "  const d = REPORT[i], c = document.getElementById('hist' + i), g = setup(c);\n"
+            "  const w = c.clientWidth, h = c.clientHeight, ph = h - 20;\n"
+            "  let first = d.hist.findIndex(x => x > 0), last = d.hist.length - 1;\n"
+            "  while (last > first && d.hist[last] === 0) last--;\n"
+            "  first = Math.max(0, first - 2); last = Math.min(d.hist.length - 1, last + 2);\n"
+            "  const bw = w / (last - first + 1), peak = Math.max(...d.hist);\n"
+            "  g.font = '11px Segoe UI, Arial';\n"
+            "  for (let b = first; b <= last; b++) {\n"
+            "    const ms = Math.pow(2, HIST_MIN_EXP + Math.floor(b / HIST_PER_OCTAVE)) * (1 + (b % HIST_PER_OCTAVE) / HIST_PER_OCTAVE);\n"
+            "    const bh = d.hist[b] / peak * ph, x = (b - first) * bw;\n"
+            "    g.fillStyle = color(ms); g.fillRect(x + 1, ph - bh, Math.max(1, bw - 2), bh);\n"
+            "    if (b % HIST_PER_OCTAVE === 0) { g.fillStyle = '#888'; g.fillText(ms + ' ms', x, h - 4); }\n"
+            "  }\n"
+            "}\n"
+            "REPORT.forEach((d, i) => {\n"
+            "  const c = document.getElementById('chart' + i);\n"
+            "  c.addEventListener('mousedown', e => { d.drag = [e.offsetX, e.offsetX]; });\n"
+            "  c.addEventListener('mousemove', e => { if (d.drag) { d.drag[1] = e.offsetX; drawChart(i); } });\n"
+            "  c.addEventListener('mouseup', e => {\n"
+            "    const a = d.toTime(Math.min(d.drag[0], e.offsetX)), b = d.toTime(Math.max(d.drag[0], e.offsetX));\n"
+            "    d.drag = null; if (b - a > 1e-4) d.view = [a, b]; drawChart(i);\n"
+            "  });\n"
+            "  c.addEventListener('dblclick', () => { d.view = null; drawChart(i); });\n"
+            "  drawChart(i); drawHist(i);\n"
+            "});\n"
+            "window.addEventListener('resize', () => REPORT.forEach((d, i) => { drawChart(i); drawHist(i); }));\n"
+            "</script>\n", out);
+    }
+
+    bool Write(const std::vector<Input>& inputs, std::FILE* out, const Options& options) {
+        std::vector<Summary> summaries;
+        for (const Input& input : inputs) {
+            Summary s;
+            if (!Analyze(input, options, s)) {
+                std::fprintf(stderr, "[WARN] Skipping capture without frames: %s\n", input.path);
+                continue;
+            }
+            summaries.push_back(std::move(s));
+        }
+        if (summaries.empty()) return false;
+
+        std::fputs("<!DOCTYPE html>\n<html>\n<head>\n<meta charset=\"UTF-8\">\n<title>Frame time report</title>\n", out);
+        WriteStyle(out);
+        std::fputs("</head>\n<body>\n<h1>Frame time report</h1>\n", out);
+        std::fprintf(out, "<div class=\"sub\">%zu capture(s) &middot; hitch = frame &gt; 2&times; running average and &gt; 4 ms above it"
+                          " &middot; segments of %.0f s</div>\n", summaries.size(), options.segmentSeconds);
+
+        std::fputs("<h2>Summary</h2><table><tr><th class=\"l\">capture</th><th class=\"l\">game</th><th>duration</th><th>frames</th>"
+                   "<th>avg FPS</th><th>1% low FPS</th><th>p50 ms</th><th>p99 ms</th><th>hitches</th></tr>\n", out);
+        for (const Summary& s : summaries) WriteSummaryRow(out, s);
+        std::fputs("</table>\n", out);
+
+        for (size_t i = 0; i < summaries.size(); i++) WriteCaptureSection(out, summaries[i], i);
+
+        WriteData(out, summaries);
+        WriteScript(out);
+        std::fputs("</body>\n</html>\n", out);
+        return std::ferror(out) == 0;
+    }
+}
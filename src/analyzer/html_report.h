@@ -0,0 +1,26 @@
+#pragma once
+
+#include "capture.h"
+#include <cstdio>
+#include <vector>
+
+// Self-contained HTML performance report (inline CSS/JS, no external assets).
+//
+// For every capture: summary, frame-time chart, histogram, percentile table,
+// per-segment summary and hitch list. The chart data is pre-decimated into a
+// few min/max levels (1K, 8K, 64K columns over the whole capture) and the page
+// picks the level that matches the zoomed range, so a 10M-frame capture opens
+// as a few hundred KB of data and stays responsive.
+namespace HtmlReport {
+    struct Input {
+        const char* path;
+        const Capture::Reader* reader;
+    };
+
+    struct Options {
+        double segmentSeconds = 60.0;
+        size_t maxHitches = 100;    // Longest hitches listed per capture
+    };
+
+    bool Write(const std::vector<Input>& inputs, std::FILE* out, const Options& options = Options());
+}
@@ -0,0 +1,555 @@
+// frame_analyzer - offline analysis of fps_overlay capture files (*.fpsc)
+//
+// Portable: builds on Windows alongside the overlay and on Linux for
+// processing captures collected from test machines.
+
+#include "capture.h"
+#include "frame_heatmap.h"
+#include "html_report.h"
+#include "quantile_sketch.h"
+#include "spectral.h"
+#include "trace_export.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+static void PrintUsage() {
+    std::printf("Usage:\n");
+    std::printf("  frame_analyzer stutter <capture.fpsc> [--window <frames>]\n");
+    std::printf("      Detect periodic hitches (dominant period and strength).\n");
+    std::printf("  frame_analyzer heatmap <capture.fpsc> [--rows <n>] [--slice <seconds>]\n");
+    std::printf("      Time x frame-time heatmap; --slice rebuilds it from raw frames.\n");
+    std::printf("  frame_analyzer merge <file.fpsq|dir>... [--by exe|build|all] [--threads <n>] [--out <dir>]\n");
+    std::printf("      Merge session sketches into per-game (or per-build) frame-time percentiles.\n");
+    std::printf("  frame_analyzer trace <capture.fpsc> <out.json|out.pftrace> [--format json|perfetto] [--hitch-ratio <x>]\n");
+    std::printf("      Export frames as a Chrome trace-event JSON or Perfetto protobuf trace.\n");
+    std::printf("  frame_analyzer report <out.html> <capture.fpsc>... [--segment <seconds>]\n");
+    std::printf("      Self-contained HTML report: chart, histogram, percentiles, hitches, segments.\n");
+}
+
+// Frame times (ms) of the busiest swapchain, in presentation order
+static bool LoadFrameTimes(const Capture::Reader& reader, std::vector<float>& out) {
+    uint32_t primary = 0;
+    size_t frames = 0;
+    if (!reader.FindPrimarySwapChain(&primary, &frames)) return false;
+
+    const double msPerTick = 1000.0 / static_cast<double>(reader.Header().qpcFrequency);
+    uint64_t last = 0;
+    bool first = true;
+    out.clear();
+    out.reserve(frames);
+    reader.ForEachFrame([&](const Capture::FrameRecord& f) {
+        if (f.swapChainId != primary) return;
+        if (!first && f.presentQpc > last) {
+            out.push_back(static_cast<float>((f.presentQpc - last) * msPerTick));
+        }
+        last = f.presentQpc;
+        first = false;
+    });
+    return !out.empty();
+}
+
+static void PrintStutter(const char* label, const Spectral::PeriodicStutter& s) {
+    if (!s.detected) {
+        std::printf("%s: no periodic hitch\n", label);
+        return;
+    }
+    if (s.domain == Spectral::Domain::Frames) {
+        std::printf("%s: every %.1f frames (~%.1f ms), strength %.2f\n",
+                    label, s.periodFrames, s.periodMs, s.strength);
+    } else {
+        std::printf("%s: every %.3f s (~%.1f frames), strength %.2f\n",
+                    label, s.periodMs / 1000.0f, s.periodFrames, s.strength);
+    }
+}
+
+static int CmdStutter(int argc, char** argv) {
+    if (argc < 1) {
+        PrintUsage();
+        return 1;
+    }
+
+    const char* path = argv[0];
+    size_t window = 2048;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--window") == 0 && i + 1 < argc) {
+            window = static_cast<size_t>(std::strtoul(argv[++i], nullptr, 10));
+        }
+    }
+    if (window < 64) window = 64;
+
+    Capture::Reader reader;
+    if (!reader.Open(path)) {
+        std::fprintf(stderr, "[ERROR] Cannot open capture: %s\n", path);
+        return 1;
+    }
+
+    std::vector<float> frameTimes;
+    if (!LoadFrameTimes(reader, frameTimes)) {
+        std::fprintf(stderr, "[ERROR] Capture has no frames: %s\n", path);
+        return 1;
+    }
+
+    double totalMs = 0.0;
+    for (float t : frameTimes) totalMs += t;
+    std::printf("Capture : %s (%s, pid %u)\n", path, reader.Header().exeName, reader.Header().pid);
+    std::printf("Frames  : %zu over %.1f s, average %.1f FPS\n",
+                frameTimes.size(), totalMs / 1000.0, frameTimes.size() * 1000.0 / totalMs);
+    std::printf("\n");
+
+    Spectral::Analyzer analyzer;
+    Spectral::PeriodicStutter strongest;
+    double strongestAtMs = 0.0;
+    size_t windowsWithHitch = 0;
+    size_t windows = 0;
+
+    // Half-overlapping windows so a hitch pattern that starts mid-window is still seen twice
+    const size_t hop = window / 2;
+    double windowStartMs = 0.0;
+    for (size_t start = 0; start + window <= frameTimes.size() || start == 0; start += hop) {
+        size_t count = frameTimes.size() - start < window ? frameTimes.size() - start : window;
+        Spectral::PeriodicStutter s = analyzer.Analyze(frameTimes.data() + start, count);
+        windows++;
+
+        if (s.detected) {
+            windowsWithHitch++;
+            char label[64];
+            std::snprintf(label, sizeof(label), "  @ %8.1f s", windowStartMs / 1000.0);
+            PrintStutter(label, s);
+            if (s.strength > strongest.strength) {
+                strongest = s;
+                strongestAtMs = windowStartMs;
+            }
+        }
+
+        for (size_t i = start; i < start + hop && i < frameTimes.size(); i++) windowStartMs += frameTimes[i];
+        if (count < window) break;
+    }
+
+    std::printf("\n%zu of %zu windows (%zu frames each) show a periodic hitch\n", windowsWithHitch, windows, window);
+    if (strongest.detected) {
+        char label[64];
+        std::snprintf(label, sizeof(label), "Dominant (at %.1f s)", strongestAtMs / 1000.0);
+        PrintStutter(label, strongest);
+    }
+    return 0;
+}
+
+// Frame time (ms) below which the given fraction of a row's frames fall
+static float RowPercentile(const uint32_t* row, uint64_t total, double fraction) {
+    uint64_t target = static_cast<uint64_t>(total * fraction);
+    uint64_t seen = 0;
+    for (uint32_t b = 0; b < FrameHeatmap::kBuckets; b++) {
+        seen += row[b];
+        if (seen > target) {
+            // Geometric middle of the bucket
+            return FrameHeatmap::BucketLowerMs(b) * 1.0442737824f;
+        }
+    }
+    return FrameHeatmap::BucketLowerMs(FrameHeatmap::kBuckets - 1);
+}
+
+static int CmdHeatmap(int argc, char** argv) {
+    if (argc < 1) {
+        PrintUsage();
+        return 1;
+    }
+
+    const char* path = argv[0];
+    size_t maxRows = 60;
+    float sliceSeconds = 0.0f;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--rows") == 0 && i + 1 < argc) {
+            maxRows = static_cast<size_t>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (std::strcmp(argv[i], "--slice") == 0 && i + 1 < argc) {
+            sliceSeconds = static_cast<float>(std::atof(argv[++i]));
+        }
+    }
+    if (maxRows < 1) maxRows = 1;
+
+    Capture::Reader reader;
+    if (!reader.Open(path)) {
+        std::fprintf(stderr, "[ERROR] Cannot open capture: %s\n", path);
+        return 1;
+    }
+
+    // The recorded chunk is used as-is; raw frames are only walked when it is
+    // missing (capture cut short) or a different slice length is requested
+    FrameHeatmap heatmap;
+    const Capture::Chunk* chunk = reader.FindChunk(Capture::kChunkHeatmap);
+    bool fromChunk = sliceSeconds <= 0.0f && chunk &&
+                     heatmap.Deserialize(chunk->data, static_cast<size_t>(chunk->size));
+    if (!fromChunk) {
+        uint32_t primary = 0;
+        size_t frames = 0;
+        if (!reader.FindPrimarySwapChain(&primary, &frames)) {
+            std::fprintf(stderr, "[ERROR] Capture has no frames: %s\n", path);
+            return 1;
+        }
+
+        heatmap.Reset(sliceSeconds > 0.0f ? sliceSeconds : 10.0f);
+        const double secondsPerTick = 1.0 / static_cast<double>(reader.Header().qpcFrequency);
+        uint64_t last = 0;
+        reader.ForEachFrame([&](const Capture::FrameRecord& f) {
+            if (f.swapChainId != primary) return;
+            if (last != 0 && f.presentQpc > last) {
+                heatmap.AddFrame(f.presentQpc * secondsPerTick,
+                                 static_cast<float>((f.presentQpc - last) * secondsPerTick * 1000.0));
+            }
+            last = f.presentQpc;
+        });
+    }
+
+    if (heatmap.Rows() == 0) {
+        std::fprintf(stderr, "[ERROR] Capture has no frames: %s\n", path);
+        return 1;
+    }
+
+    // Fold rows so the printout stays readable for multi-hour sessions
+    const size_t group = (heatmap.Rows() + maxRows - 1) / maxRows;
+    const float rowSeconds = heatmap.SliceSeconds() * group;
+
+    // Two buckets per character: 4 characters per octave
+    const uint32_t perChar = 2;
+    const uint32_t chars = FrameHeatmap::kBuckets / perChar;
+    static const char kShades[] = " .:-=+*#%@";
+
+    std::printf("Capture : %s (%s, pid %u)\n", path, reader.Header().exeName, reader.Header().pid);
+    std::printf("Heatmap : %zu rows x %.0f s (%s)\n\n", (heatmap.Rows() + group - 1) / group, rowSeconds,
+                fromChunk ? "recorded" : "rebuilt from frames");
+
+    // Axis: mark each power-of-4 ms boundary
+    char axis[128] = {0};
+    std::memset(axis, ' ', chars);
+    for (uint32_t c = 0; c < chars; c++) {
+        uint32_t b = c * perChar;
+        if (b % (FrameHeatmap::kBucketsPerOctave * 2) == 0) axis[c] = '|';
+    }
+    std::printf("  %9s  %s   frames     p50      p99\n", "time", axis);
+    std::printf("  %9s  ", "ms");
+    for (uint32_t c = 0; c < chars; c += FrameHeatmap::kBucketsPerOctave) {
+        char label[16];
+        std::snprintf(label, sizeof(label), "%-8g", FrameHeatmap::BucketLowerMs(c * perChar));
+        std::printf("%s", label);
+    }
+    std::printf("\n");
+
+    std::vector<uint32_t> merged(FrameHeatmap::kBuckets);
+    for (size_t r = 0; r < heatmap.Rows(); r += group) {
+        std::fill(merged.begin(), merged.end(), 0u);
+        for (size_t g = r; g < r + group && g < heatmap.Rows(); g++) {
+            const uint32_t* row = heatmap.Row(g);
+            for (uint32_t b = 0; b < FrameHeatmap::kBuckets; b++) merged[b] += row[b];
+        }
+
+        uint64_t total = 0;
+        for (uint32_t count : merged) total += count;
+
+        char line[128] = {0};
+        for (uint32_t c = 0; c < chars; c++) {
+            uint64_t count = 0;
+            for (uint32_t k = 0; k < perChar; k++) count += merged[c * perChar + k];
+
+            // sqrt keeps rare slow frames visible next to the main mode
+            int shade = 0;
+            if (count > 0) shade = 1 + static_cast<int>(std::sqrt(static_cast<double>(count) / total) * 8.99);
+            line[c] = kShades[shade];
+        }
+
+        if (total == 0) {
+            std::printf("  %8.0fs  %s %8u\n", r * heatmap.SliceSeconds(), line, 0u);
+        } else {
+            std::printf("  %8.0fs  %s %8llu %7.2f  %7.2f\n", r * heatmap.SliceSeconds(), line,
+                        static_cast<unsigned long long>(total),
+                        RowPercentile(merged.data(), total, 0.50), RowPercentile(merged.data(), total, 0.99));
+        }
+    }
+    return 0;
+}
+
+struct SketchGroup {
+    QuantileSketch sketch;
+    std::string exeName;
+    std::string build;
+    size_t sessions = 0;
+    double seconds = 0.0;
+};
+
+enum class GroupBy { Exe, Build, All };
+
+static void CollectSketchFiles(const char* arg, std::vector<std::string>& out) {
+    namespace fs = std::filesystem;
+    std::error_code ec;
+    if (fs::is_directory(arg, ec)) {
+        for (fs::recursive_directory_iterator it(arg, ec), end; !ec && it != end; it.increment(ec)) {
+            if (it->is_regular_file(ec) && it->path().extension() == ".fpsq") {
+                out.push_back(it->path().string());
+            }
+        }
+    } else {
+        out.push_back(arg);
+    }
+}
+
+// Adds one sketch file into the group map; false if the file has no usable sketch
+static bool MergeSketchFile(const std::string& path, GroupBy by, std::map<std::string, SketchGroup>& groups) {
+    Capture::Reader reader;
+    if (!reader.Open(path.c_str())) return false;
+
+    const Capture::Chunk* chunk = reader.FindChunk(Capture::kChunkSketch);
+    QuantileSketch sketch;
+    if (!chunk || !sketch.Deserialize(chunk->data, static_cast<size_t>(chunk->size))) return false;
+
+    Capture::SessionInfo info = {};
+    const Capture::Chunk* session = reader.FindChunk(Capture::kChunkSession);
+    if (session && session->size >= sizeof(info)) {
+        std::memcpy(&info, session->data, sizeof(info));
+        info.build[sizeof(info.build) - 1] = '\0';
+    }
+
+    std::string exeName = reader.Header().exeName;
+    std::string build = info.build[0] ? info.build : "unknown";
+    std::string key;
+    if (by == GroupBy::Exe) key = exeName;
+    else if (by == GroupBy::Build) key = exeName + " " + build;
+
+    SketchGroup& group = groups[key];
+    if (group.sessions == 0) {
+        group.exeName = by == GroupBy::All ? "(all)" : exeName;
+        group.build = by == GroupBy::Build ? build : "";
+    }
+    if (!group.sketch.Merge(sketch)) return false;
+    group.sessions++;
+    group.seconds += info.durationSeconds;
+    return true;
+}
+
+static int CmdMerge(int argc, char** argv) {
+    std::vector<std::string> files;
+    GroupBy by = GroupBy::Exe;
+    unsigned threads = std::thread::hardware_concurrency();
+    const char* outDir = nullptr;
+    for (int i = 0; i < argc; i++) {
+        if (std::strcmp(argv[i], "--by") == 0 && i + 1 < argc) {
+            const char* v = argv[++i];
+            by = std::strcmp(v, "build") == 0 ? GroupBy::Build : std::strcmp(v, "all") == 0 ? GroupBy::All : GroupBy::Exe;
+        } else if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            threads = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (std::strcmp(argv[i], "--out") == 0 && i + 1 < argc) {
+            outDir = argv[++i];
+        } else {
+            CollectSketchFiles(argv[i], files);
+        }
+    }
+    if (files.empty()) {
+        PrintUsage();
+        return 1;
+    }
+    if (threads < 1) threads = 1;
+    if (threads > files.size()) threads = static_cast<unsigned>(files.size());
+
+    // Each worker merges into its own map; the maps are combined at the end.
+    // Sketch merge is exact, so the split does not change the result.
+    std::vector<std::map<std::string, SketchGroup>> partial(threads);
+    std::vector<size_t> failed(threads, 0);
+    std::atomic<size_t> next(0);
+    std::vector<std::thread> workers;
+    for (unsigned t = 0; t < threads; t++) {
+        workers.emplace_back([&, t]() {
+            for (size_t i = next++; i < files.size(); i = next++) {
+                if (!MergeSketchFile(files[i], by, partial[t])) failed[t]++;
+            }
+        });
+    }
+    for (std::thread& worker : workers) worker.join();
+
+    std::map<std::string, SketchGroup> groups;
+    size_t failedTotal = 0;
+    for (unsigned t = 0; t < threads; t++) {
+        failedTotal += failed[t];
+        for (auto& entry : partial[t]) {
+            SketchGroup& group = groups[entry.first];
+            if (group.sessions == 0) {
+                group.exeName = entry.second.exeName;
+                group.build = entry.second.build;
+            }
+            group.sketch.Merge(entry.second.sketch);
+            group.sessions += entry.second.sessions;
+            group.seconds += entry.second.seconds;
+        }
+    }
+
+    std::printf("Merged %zu sketch files (%zu skipped) with %u threads, relative error <= %.1f%%\n\n",
+                files.size() - failedTotal, failedTotal, threads, QuantileSketch::kDefaultAccuracy * 100.0);
+    std::printf("%-32s %-18s %8s %12s %8s %8s %8s %8s %8s\n",
+                "game", "build", "sessions", "frames", "hours", "p50", "p90", "p99", "p99.9");
+    for (const auto& entry : groups) {
+        const SketchGroup& g = entry.second;
+        std::printf("%-32s %-18s %8zu %12llu %8.1f %8.2f %8.2f %8.2f %8.2f\n",
+                    g.exeName.c_str(), g.build.c_str(), g.sessions,
+                    static_cast<unsigned long long>(g.sketch.Count()), g.seconds / 3600.0,
+                    g.sketch.Quantile(0.50), g.sketch.Quantile(0.90),
+                    g.sketch.Quantile(0.99), g.sketch.Quantile(0.999));
+    }
+
+    if (outDir) {
+        // Merged sketches are regular sketch files, so merges can be chained
+        std::error_code ec;
+        std::filesystem::create_directories(outDir, ec);
+        for (const auto& entry : groups) {
+            const SketchGroup& g = entry.second;
+
+            std::string name = entry.first.empty() ? "all" : entry.first;
+            for (char& c : name) {
+                if (c == ' ' || c == '/' || c == '\\' || c == ':') c = '_';
+            }
+            std::string path = (std::filesystem::path(outDir) / (name + ".fpsq")).string();
+
+            Capture::FileHeader header = {};
+            header.qpcFrequency = 1;
+            std::snprintf(header.exeName, sizeof(header.exeName), "%s", g.exeName.c_str());
+
+            Capture::SessionInfo info = {};
+            std::snprintf(info.build, sizeof(info.build), "%s", g.build.c_str());
+            info.durationSeconds = g.seconds;
+
+            std::vector<unsigned char> payload;
+            g.sketch.Serialize(payload);
+
+            Capture::Writer writer;
+            if (!writer.Open(path.c_str(), header)) {
+                std::fprintf(stderr, "[ERROR] Cannot write %s\n", path.c_str());
+                return 1;
+            }
+            writer.WriteChunk(Capture::kChunkSession, &info, sizeof(info));
+            writer.WriteChunk(Capture::kChunkSketch, payload.data(), payload.size());
+            writer.Close();
+        }
+    }
+    return 0;
+}
+
+static bool EndsWith(const char* s, const char* suffix) {
+    size_t n = std::strlen(s);
+    size_t m = std::strlen(suffix);
+    return n >= m && std::strcmp(s + n - m, suffix) == 0;
+}
+
+static int CmdTrace(int argc, char** argv) {
+    if (argc < 2) {
+        PrintUsage();
+        return 1;
+    }
+
+    const char* path = argv[0];
+    const char* outPath = argv[1];
+    TraceExport::Format format = EndsWith(outPath, ".json") ? TraceExport::Format::ChromeJson
+                                                            : TraceExport::Format::Perfetto;
+    TraceExport::Options options;
+    for (int i = 2; i < argc; i++) {
+        if (std::strcmp(argv[i], "--format") == 0 && i + 1 < argc) {
+            const char* v = argv[++i];
+            format = std::strcmp(v, "json") == 0 ? TraceExport::Format::ChromeJson : TraceExport::Format::Perfetto;
+        } else if (std::strcmp(argv[i], "--hitch-ratio") == 0 && i + 1 < argc) {
+            options.hitchRatio = static_cast<float>(std::atof(argv[++i]));
+        }
+    }
+
+    Capture::Reader reader;
+    if (!reader.Open(path)) {
+        std::fprintf(stderr, "[ERROR] Cannot open capture: %s\n", path);
+        return 1;
+    }
+
+    std::FILE* out = std::fopen(outPath, "wb");
+    if (!out) {
+        std::fprintf(stderr, "[ERROR] Cannot write %s\n", outPath);
+        return 1;
+    }
+    static char buffer[1 << 20];
+    std::setvbuf(out, buffer, _IOFBF, sizeof(buffer));
+
+    bool ok = TraceExport::Write(reader, out, format, options);
+    ok = std::fclose(out) == 0 && ok;
+    if (!ok) {
+        std::fprintf(stderr, "[ERROR] Write failed: %s\n", outPath);
+        return 1;
+    }
+
+    std::printf("Wrote %zu frames to %s (%s)\n", reader.FrameCount(), outPath,
+                format == TraceExport::Format::ChromeJson ? "Chrome JSON" : "Perfetto");
+    return 0;
+}
+
+static int CmdReport(int argc, char** argv) {
+    if (argc < 2) {
+        PrintUsage();
+        return 1;
+    }
+
+    const char* outPath = argv[0];
+    HtmlReport::Options options;
+    std::vector<const char*> paths;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--segment") == 0 && i + 1 < argc) {
+            options.segmentSeconds = std::atof(argv[++i]);
+        } else {
+            paths.push_back(argv[i]);
+        }
+    }
+    if (options.segmentSeconds < 1.0) options.segmentSeconds = 1.0;
+
+    // Readers stay mapped until the report is written
+    std::vector<std::unique_ptr<Capture::Reader>> readers;
+    std::vector<HtmlReport::Input> inputs;
+    for (const char* path : paths) {
+        readers.emplace_back(new Capture::Reader());
+        if (!readers.back()->Open(path)) {
+            std::fprintf(stderr, "[ERROR] Cannot open capture: %s\n", path);
+            return 1;
+        }
+        inputs.push_back(HtmlReport::Input{ path, readers.back().get() });
+    }
+
+    std::FILE* out = std::fopen(outPath, "wb");
+    if (!out) {
+        std::fprintf(stderr, "[ERROR] Cannot write %s\n", outPath);
+        return 1;
+    }
+    static char buffer[1 << 20];
+    std::setvbuf(out, buffer, _IOFBF, sizeof(buffer));
+
+    bool ok = HtmlReport::Write(inputs, out, options);
+    ok = std::fclose(out) == 0 && ok;
+    if (!ok) {
+        std::fprintf(stderr, "[ERROR] Report failed: %s\n", outPath);
+        return 1;
+    }
+    std::printf("Wrote report for %zu capture(s) to %s\n", inputs.size(), outPath);
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        PrintUsage();
+        return 1;
+    }
+
+    if (std::strcmp(argv[1], "stutter") == 0) return CmdStutter(argc - 2, argv + 2);
+    if (std::strcmp(argv[1], "heatmap") == 0) return CmdHeatmap(argc - 2, argv + 2);
+    if (std::strcmp(argv[1], "merge") == 0) return CmdMerge(argc - 2, argv + 2);
+    if (std::strcmp(argv[1], "trace") == 0) return CmdTrace(argc - 2, argv + 2);
+    if (std::strcmp(argv[1], "report") == 0) return CmdReport(argc - 2, argv + 2);
+
+    PrintUsage();
+    return 1;
+}
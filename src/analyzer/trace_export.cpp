@@ -0,0 +1,309 @@
+#include "trace_export.h"
+#include "hitch.h"
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace TraceExport {
+    // Receives the slice stream produced by WalkFrames, one track at a time
+    // in timestamp order per track.
+    class Sink {
+    public:
+        virtual ~Sink() = default;
+        virtual void Process(uint32_t pid, const char* name) = 0;
+        virtual void Track(uint32_t pid, uint32_t track, const char* name) = 0;
+        virtual void Begin(uint32_t track, const char* name, uint64_t ns) = 0;
+        virtual void End(uint32_t track, uint64_t ns) = 0;
+        virtual void Instant(uint32_t track, const char* name, uint64_t ns) = 0;
+        virtual void Finish() = 0;
+    };
+
+    // ------------------------------------------------------------------
+    // Chrome trace-event JSON
+    // ------------------------------------------------------------------
+
+    class JsonSink : public Sink {
+    public:
+        explicit JsonSink(std::FILE* out) : m_out(out) {
+            std::fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n", m_out);
+        }
+
+        void Process(uint32_t pid, const char* name) override {
+            m_pid = pid;
+            Separator();
+            std::fprintf(m_out, "{\"ph\":\"M\",\"pid\":%u,\"tid\":0,\"name\":\"process_name\",\"args\":{\"name\":\"", pid);
+            WriteEscaped(name);
+            std::fputs("\"}}", m_out);
+        }
+
+        void Track(uint32_t pid, uint32_t track, const char* name) override {
+            Separator();
+            std::fprintf(m_out, "{\"ph\":\"M\",\"pid\":%u,\"tid\":%u,\"name\":\"thread_name\",\"args\":{\"name\":\"", pid, track);
+            WriteEscaped(name);
+            std::fputs("\"}}", m_out);
+        }
+
+        // Slices are buffered only until they close and are then written as
+        // complete ("X") events; nesting depth per track is at most two
+        void Begin(uint32_t track, const char* name, uint64_t ns) override {
+            m_open[track].push_back(Open{name, ns});
+        }
+
+        void End(uint32_t track, uint64_t ns) override {
+            std::vector<Open>& stack = m_open[track];
+            if (stack.empty()) return;
+            Open slice = stack.back();
+            stack.pop_back();
+
+            Separator();
+            std::fprintf(m_out, "{\"ph\":\"X\",\"pid\":%u,\"tid\":%u,\"name\":\"%s\",\"ts\":%.3f,\"dur\":%.3f}",
+                         m_pid, track, slice.name, slice.ns / 1000.0, (ns - slice.ns) / 1000.0);
+        }
+
+        void Instant(uint32_t track, const char* name, uint64_t ns) override {
+            Separator();
+            std::fprintf(m_out, "{\"ph\":\"i\",\"s\":\"t\",\"pid\":%u,\"tid\":%u,\"name\":\"%s\",\"ts\":%.3f}",
+                         m_pid, track, name, ns / 1000.0);
+        }
+
+        void Finish() override {
+            std::fputs("\n]}\n", m_out);
+        }
+
+    private:
+        struct Open {
+            const char* name;   // Always a string literal
+            uint64_t ns;
+        };
+
+        void Separator() {
+            if (m_first) {
+                m_first = false;
+            } else {
+                std::fputs(",\n", m_out);
+            }
+        }
+
+        void WriteEscaped(const char* s) {
+            for (; *s; s++) {
+                unsigned char c = static_cast<unsigned char>(*s);
+                if (c == '"' || c == '\\') {
+                    std::fputc('\\', m_out);
+                    std::fputc(c, m_out);
+                } else if (c < 0x20) {
+                    std::fprintf(m_out, "\\u%04x", c);
+                } else {
+                    std::fputc(c, m_out);
+                }
+            }
+        }
+
+        std::FILE* m_out;
+        uint32_t m_pid = 0;
+        bool m_first = true;
+        std::map<uint32_t, std::vector<Open>> m_open;
+    };
+
+    // ------------------------------------------------------------------
+    // Perfetto protobuf (perfetto.protos.Trace), encoded by hand
+    // ------------------------------------------------------------------
+
+    class ProtoBuffer {
+    public:
+        void Varint(uint64_t v) {
+            while (v >= 0x80) {
+                m_data.push_back(static_cast<unsigned char>(v | 0x80));
+                v >>= 7;
+            }
+            m_data.push_back(static_cast<unsigned char>(v));
+        }
+
+        void Tag(uint32_t field, uint32_t wireType) { Varint((static_cast<uint64_t>(field) << 3) | wireType); }
+        void UInt(uint32_t field, uint64_t v) { Tag(field, 0); Varint(v); }
+
+        void Bytes(uint32_t field, const void* data, size_t size) {
+            Tag(field, 2);
+            Varint(size);
+            const unsigned char* p = static_cast<const unsigned char*>(data);
+            m_data.insert(m_data.end(), p, p + size);
+        }
+
+        void String(uint32_t field, const char* s) { Bytes(field, s, std::strlen(s)); }
+        void Message(uint32_t field, const ProtoBuffer& m) { Bytes(field, m.m_data.data(), m.m_data.size()); }
+
+        void Clear() { m_data.clear(); }
+        const std::vector<unsigned char>& Data() const { return m_data; }
+
+    private:
+        std::vector<unsigned char> m_data;
+    };
+
+    class PerfettoSink : public Sink {
+    public:
+        explicit PerfettoSink(std::FILE* out) : m_out(out) {}
+
+        void Process(uint32_t pid, const char* name) override {
+            m_pid = pid;
+
+            ProtoBuffer process;
+            process.UInt(1, pid);               // ProcessDescriptor.pid
+            process.String(6, name);            // ProcessDescriptor.process_name
+
+            ProtoBuffer track;
+            track.UInt(1, ProcessUuid());       // TrackDescriptor.uuid
+            track.Message(3, process);          // TrackDescriptor.process
+
+            m_packet.Clear();
+            m_packet.UInt(10, kSequenceId);     // trusted_packet_sequence_id
+            m_packet.UInt(13, 1);               // sequence_flags = SEQ_INCREMENTAL_STATE_CLEARED
+            m_packet.Message(60, track);        // track_descriptor
+            WritePacket();
+        }
+
+        void Track(uint32_t pid, uint32_t trackId, const char* name) override {
+            ProtoBuffer thread;
+            thread.UInt(1, pid);                // ThreadDescriptor.pid
+            thread.UInt(2, trackId);            // ThreadDescriptor.tid
+            thread.String(5, name);             // ThreadDescriptor.thread_name
+
+            ProtoBuffer track;
+            track.UInt(1, TrackUuid(trackId));
+            track.UInt(5, ProcessUuid());       // TrackDescriptor.parent_uuid
+            track.Message(4, thread);           // TrackDescriptor.thread
+
+            m_packet.Clear();
+            m_packet.UInt(10, kSequenceId);
+            m_packet.Message(60, track);
+            WritePacket();
+        }
+
+        void Begin(uint32_t track, const char* name, uint64_t ns) override { Event(track, 1, name, ns); }
+        void End(uint32_t track, uint64_t ns) override { Event(track, 2, nullptr, ns); }
+        void Instant(uint32_t track, const char* name, uint64_t ns) override { Event(track, 3, name, ns); }
+        void Finish() override {}
+
+    private:
+        static constexpr uint32_t kSequenceId = 0x46505343;   // 'FPSC'
+
+        uint64_t ProcessUuid() const { return (static_cast<uint64_t>(m_pid) << 32) | 0xFFFFFFFFull; }
+        uint64_t TrackUuid(uint32_t track) const { return (static_cast<uint64_t>(m_pid) << 32) | track; }
+
+        // type: TrackEvent.Type (1 = SLICE_BEGIN, 2 = SLICE_END, 3 = INSTANT)
+        void Event(uint32_t track, uint32_t type, const char* name, uint64_t ns) {
+            m_event.Clear();
+            m_event.UInt(9, type);              // TrackEvent.type
+            m_event.UInt(11, TrackUuid(track)); // TrackEvent.track_uuid
+            if (name) m_event.String(23, name); // TrackEvent.name
+
+            m_packet.Clear();
+            m_packet.UInt(8, ns);               // timestamp
+            m_packet.UInt(10, kSequenceId);
+            m_packet.Message(11, m_event);      // track_event
+            WritePacket();
+        }
+
+        // Trace.packet (field 1), appended as it is produced
+        void WritePacket() {
+            const std::vector<unsigned char>& data = m_packet.Data();
+            m_header.Clear();
+            m_header.Tag(1, 2);
+            m_header.Varint(data.size());
+            std::fwrite(m_header.Data().data(), 1, m_header.Data().size(), m_out);
+            std::fwrite(data.data(), 1, data.size(), m_out);
+        }
+
+        std::FILE* m_out;
+        uint32_t m_pid = 0;
+        ProtoBuffer m_header;
+        ProtoBuffer m_packet;
+        ProtoBuffer m_event;
+    };
+
+    // ------------------------------------------------------------------
+    // Frame walk
+    // ------------------------------------------------------------------
+
+    struct SwapChainState {
+        Capture::FrameRecord last;
+        bool hasLast = false;
+        HitchDetector hitches;
+    };
+
+    static void EmitFrame(Sink& sink, const Capture::FrameRecord& f, uint64_t startNs, uint64_t endNs,
+                          double ticksToNs, bool hitch) {
+        uint64_t overlayNs = static_cast<uint64_t>(f.overlayTicks * ticksToNs);
+        uint64_t presentNs = static_cast<uint64_t>(f.presentTicks * ticksToNs);
+
+        // A Present that blocks past the next frame's start is clipped to keep nesting valid
+        uint64_t overlayEnd = startNs + overlayNs < endNs ? startNs + overlayNs : endNs;
+        uint64_t presentEnd = overlayEnd + presentNs < endNs ? overlayEnd + presentNs : endNs;
+
+        sink.Begin(f.swapChainId, "Frame", startNs);
+        if (hitch) sink.Instant(f.swapChainId, "Hitch", startNs);
+        if (overlayNs) {
+            sink.Begin(f.swapChainId, "Overlay", startNs);
+            sink.End(f.swapChainId, overlayEnd);
+        }
+        if (presentNs) {
+            sink.Begin(f.swapChainId, "Present", overlayEnd);
+            sink.End(f.swapChainId, presentEnd);
+        }
+        sink.End(f.swapChainId, endNs);
+    }
+
+    static void WalkFrames(const Capture::Reader& reader, Sink& sink, const Options& options) {
+        const Capture::FileHeader& header = reader.Header();
+        const double ticksToNs = 1e9 / static_cast<double>(header.qpcFrequency);
+
+        char exeName[sizeof(header.exeName) + 1] = {0};
+        std::memcpy(exeName, header.exeName, sizeof(header.exeName));
+        sink.Process(header.pid, exeName);
+
+        // Only per-swapchain state is kept, so memory does not grow with frame count
+        std::map<uint32_t, SwapChainState> swapChains;
+        reader.ForEachFrame([&](const Capture::FrameRecord& f) {
+            auto it = swapChains.find(f.swapChainId);
+            if (it == swapChains.end()) {
+                char name[48];
+                std::snprintf(name, sizeof(name), "SwapChain %08X", f.swapChainId);
+                sink.Track(header.pid, f.swapChainId, name);
+                SwapChainState state;
+                state.hitches = HitchDetector(options.hitchRatio, options.hitchMinMs);
+                it = swapChains.emplace(f.swapChainId, state).first;
+            }
+
+            SwapChainState& state = it->second;
+            uint64_t nowNs = static_cast<uint64_t>(f.presentQpc * ticksToNs);
+            if (state.hasLast) {
+                uint64_t startNs = static_cast<uint64_t>(state.last.presentQpc * ticksToNs);
+                if (nowNs > startNs) {
+                    bool hitch = state.hitches.Add((nowNs - startNs) / 1e6);
+                    EmitFrame(sink, state.last, startNs, nowNs, ticksToNs, hitch);
+                }
+            }
+            state.last = f;
+            state.hasLast = true;
+        });
+
+        // Last frame of each swapchain has no successor; end it after its own work
+        for (auto& entry : swapChains) {
+            const Capture::FrameRecord& f = entry.second.last;
+            uint64_t startNs = static_cast<uint64_t>(f.presentQpc * ticksToNs);
+            uint64_t endNs = startNs + static_cast<uint64_t>((static_cast<uint64_t>(f.overlayTicks) + f.presentTicks) * ticksToNs);
+            EmitFrame(sink, f, startNs, endNs > startNs ? endNs : startNs + 1, ticksToNs, false);
+        }
+        sink.Finish();
+    }
+
+    bool Write(const Capture::Reader& reader, std::FILE* out, Format format, const Options& options) {
+        if (format == Format::Perfetto) {
+            PerfettoSink sink(out);
+            WalkFrames(reader, sink, options);
+        } else {
+            JsonSink sink(out);
+            WalkFrames(reader, sink, options);
+        }
+        return std::ferror(out) == 0;
+    }
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include "capture.h"
+#include <cstdio>
+
+// Converts a capture into a trace viewable in chrome://tracing or Perfetto.
+//
+// Each swapchain becomes a thread-like track under the game's process. Every
+// frame is a "Frame" slice from one Present call to the next, with nested
+// "Overlay" (our render cost) and "Present" (time blocked in the original
+// Present) slices, plus a "Hitch" instant on frames far above the running
+// average. Timestamps are QPC converted to ns (us for JSON), i.e. the same
+// clock engine traces recorded with QueryPerformanceCounter use.
+//
+// Output is streamed while walking the mapped frames; memory use does not
+// depend on capture length.
+namespace TraceExport {
+    enum class Format {
+        ChromeJson,
+        Perfetto,
+    };
+
+    struct Options {
+        float hitchRatio = 2.0f;    // Frame time vs. running average
+        float hitchMinMs = 4.0f;    // ... and at least this much above it
+    };
+
+    bool Write(const Capture::Reader& reader, std::FILE* out, Format format, const Options& options = Options());
+}
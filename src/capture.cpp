@@ -0,0 +1,336 @@
+#include "capture.h"
+#include "module_thread.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <thread>
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace Capture {
+    static constexpr size_t kFramesPerChunk = 4096;
+    static constexpr int kCloseWaitMs = 500;
+
+    // Chunks handed to the writer thread, oldest first. The thread shares
+    // ownership, so a Close that gives up waiting never frees this under it.
+    // The thread only takes a chunk while holding fileMutex; whoever else
+    // holds fileMutex (Close) therefore owns the file and the queue order.
+    struct Writer::Pending {
+        std::mutex mutex;                   // Guards chunks, spare and stop
+        std::condition_variable wake;
+        std::deque<std::vector<unsigned char>> chunks;
+        std::vector<std::vector<unsigned char>> spare;  // Written buffers, reused
+        bool stop = false;
+        std::mutex fileMutex;
+        std::FILE* file = nullptr;
+        std::atomic<bool> failed{false};
+    };
+
+    namespace {
+        // ChunkHeader + payload, padded to 8 bytes so records stay aligned in a mapped view
+        void BuildChunk(std::vector<unsigned char>& out, uint32_t tag, const void* data, size_t size) {
+            size_t padded = (size + 7) & ~static_cast<size_t>(7);
+            ChunkHeader ch = {};
+            ch.tag = tag;
+            ch.size = padded;
+            out.assign(sizeof(ch) + padded, 0);
+            std::memcpy(out.data(), &ch, sizeof(ch));
+            if (size) std::memcpy(out.data() + sizeof(ch), data, size);
+        }
+
+        bool WriteAll(std::FILE* file, const std::vector<unsigned char>& chunk) {
+            return std::fwrite(chunk.data(), 1, chunk.size(), file) == chunk.size();
+        }
+
+        void WriterThread(void* param) {
+            auto* ref = static_cast<std::shared_ptr<Writer::Pending>*>(param);
+            std::shared_ptr<Writer::Pending> pending = std::move(*ref);
+            delete ref;
+
+            std::vector<unsigned char> chunk;
+            for (;;) {
+                {
+                    std::unique_lock<std::mutex> lock(pending->mutex);
+                    pending->wake.wait(lock, [&] { return pending->stop || !pending->chunks.empty(); });
+                    if (pending->stop) return;
+                }
+
+                std::lock_guard<std::mutex> fileLock(pending->fileMutex);
+                {
+                    std::lock_guard<std::mutex> lock(pending->mutex);
+                    if (pending->stop) return;
+                    if (pending->chunks.empty()) continue;
+                    chunk.swap(pending->chunks.front());
+                    pending->chunks.pop_front();
+                }
+                if (!WriteAll(pending->file, chunk)) pending->failed.store(true, std::memory_order_relaxed);
+                std::lock_guard<std::mutex> lock(pending->mutex);
+                pending->spare.push_back(std::move(chunk));
+                chunk = std::vector<unsigned char>();
+            }
+        }
+    }
+
+    Writer::~Writer() {
+        Close();
+    }
+
+    bool Writer::Open(const char* path, const FileHeader& header) {
+        Close();
+
+#ifdef _WIN32
+        if (fopen_s(&m_file, path, "wb") != 0) m_file = nullptr;
+#else
+        m_file = std::fopen(path, "wb");
+#endif
+        if (!m_file) return false;
+
+        FileHeader h = header;
+        h.magic = kMagic;
+        h.version = kVersion;
+        h.exeName[sizeof(h.exeName) - 1] = '\0';
+        if (std::fwrite(&h, sizeof(h), 1, m_file) != 1) {
+            std::fclose(m_file);
+            m_file = nullptr;
+            return false;
+        }
+
+        m_frames.reserve(kFramesPerChunk);
+        return true;
+    }
+
+    void Writer::Append(const FrameRecord& frame) {
+        if (!m_file) return;
+        m_frames.push_back(frame);
+        if (m_frames.size() >= kFramesPerChunk) {
+            FlushFrames();
+        }
+    }
+
+    void Writer::FlushFrames() {
+        if (m_frames.empty()) return;
+        WriteChunk(kChunkFrames, m_frames.data(), m_frames.size() * sizeof(FrameRecord));
+        m_frames.clear();
+    }
+
+    void Writer::StartThread() {
+        auto pending = std::make_shared<Pending>();
+        pending->file = m_file;
+        auto* ref = new std::shared_ptr<Pending>(pending);
+        if (!ModuleThread::Start(WriterThread, ref)) {
+            delete ref;
+            return;
+        }
+        m_pending = std::move(pending);
+    }
+
+    bool Writer::WriteChunk(uint32_t tag, const void* data, size_t size) {
+        if (!m_file) return false;
+
+        // Keep frame order intact when a summary chunk is written mid-session
+        if (tag != kChunkFrames && !m_frames.empty()) {
+            FlushFrames();
+        }
+
+        // Frames start the writer thread; summary chunks before that (and
+        // files without frames) are small and written here
+        if (!m_pending && tag == kChunkFrames) StartThread();
+        if (!m_pending) {
+            std::vector<unsigned char> chunk;
+            BuildChunk(chunk, tag, data, size);
+            return WriteAll(m_file, chunk);
+        }
+
+        std::vector<unsigned char> chunk;
+        {
+            std::lock_guard<std::mutex> lock(m_pending->mutex);
+            if (!m_pending->spare.empty()) {
+                chunk.swap(m_pending->spare.back());
+                m_pending->spare.pop_back();
+            }
+        }
+        BuildChunk(chunk, tag, data, size);
+        {
+            std::lock_guard<std::mutex> lock(m_pending->mutex);
+            m_pending->chunks.push_back(std::move(chunk));
+        }
+        m_pending->wake.notify_one();
+        return !m_pending->failed.load(std::memory_order_relaxed);
+    }
+
+    void Writer::Close() {
+        if (!m_file) return;
+        FlushFrames();
+
+        if (m_pending) {
+            // Take the file over once the thread is between chunks and write
+            // what is left here. At process exit the thread has been
+            // terminated and may hold a lock: give up rather than hang.
+            std::shared_ptr<Pending> pending = std::move(m_pending);
+            bool owned = false;
+            for (int i = 0; i < kCloseWaitMs; i++) {
+                if (pending->fileMutex.try_lock()) {
+                    if (pending->mutex.try_lock()) {
+                        owned = true;
+                        break;
+                    }
+                    pending->fileMutex.unlock();
+                }
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+            if (!owned) {
+                m_file = nullptr;
+                m_frames.clear();
+                return;
+            }
+
+            pending->stop = true;
+            std::deque<std::vector<unsigned char>> chunks = std::move(pending->chunks);
+            pending->mutex.unlock();
+            pending->wake.notify_one();
+            for (const std::vector<unsigned char>& chunk : chunks) WriteAll(m_file, chunk);
+            pending->fileMutex.unlock();
+        }
+
+        std::fclose(m_file);
+        m_file = nullptr;
+    }
+
+    Reader::~Reader() {
+        Close();
+    }
+
+    bool Reader::Open(const char* path) {
+        Close();
+
+#ifdef _WIN32
+        HANDLE hFile = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr,
+                                   OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (hFile == INVALID_HANDLE_VALUE) return false;
+
+        LARGE_INTEGER size = {};
+        if (!GetFileSizeEx(hFile, &size) || size.QuadPart < static_cast<LONGLONG>(sizeof(FileHeader))) {
+            CloseHandle(hFile);
+            return false;
+        }
+
+        HANDLE hMap = CreateFileMappingW(hFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (!hMap) {
+            CloseHandle(hFile);
+            return false;
+        }
+
+        void* view = MapViewOfFile(hMap, FILE_MAP_READ, 0, 0, 0);
+        if (!view) {
+            CloseHandle(hMap);
+            CloseHandle(hFile);
+            return false;
+        }
+
+        m_fileHandle = hFile;
+        m_mapHandle = hMap;
+        m_base = static_cast<const unsigned char*>(view);
+        m_size = static_cast<size_t>(size.QuadPart);
+#else
+        int fd = ::open(path, O_RDONLY);
+        if (fd < 0) return false;
+
+        struct stat st;
+        if (fstat(fd, &st) != 0 || st.st_size < static_cast<off_t>(sizeof(FileHeader))) {
+            ::close(fd);
+            return false;
+        }
+
+        void* view = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        if (view == MAP_FAILED) {
+            ::close(fd);
+            return false;
+        }
+        madvise(view, static_cast<size_t>(st.st_size), MADV_SEQUENTIAL);
+
+        m_fd = fd;
+        m_base = static_cast<const unsigned char*>(view);
+        m_size = static_cast<size_t>(st.st_size);
+#endif
+
+        m_header = reinterpret_cast<const FileHeader*>(m_base);
+        if (m_header->magic != kMagic || m_header->version != kVersion || m_header->qpcFrequency == 0) {
+            Close();
+            return false;
+        }
+
+        // Index chunks. A truncated trailing chunk (crash mid-write) is ignored.
+        size_t offset = sizeof(FileHeader);
+        while (offset + sizeof(ChunkHeader) <= m_size) {
+            const ChunkHeader* ch = reinterpret_cast<const ChunkHeader*>(m_base + offset);
+            offset += sizeof(ChunkHeader);
+            if (ch->size > m_size - offset) break;
+
+            Chunk chunk = { ch->tag, m_base + offset, ch->size };
+            m_chunks.push_back(chunk);
+
+            if (ch->tag == kChunkFrames) {
+                FrameSpan span = { reinterpret_cast<const FrameRecord*>(m_base + offset),
+                                   static_cast<size_t>(ch->size / sizeof(FrameRecord)) };
+                m_frameSpans.push_back(span);
+                m_frameCount += span.count;
+            }
+            offset += static_cast<size_t>(ch->size);
+        }
+
+        return true;
+    }
+
+    void Reader::Close() {
+        m_frameSpans.clear();
+        m_chunks.clear();
+        m_frameCount = 0;
+        m_header = nullptr;
+
+#ifdef _WIN32
+        if (m_base) UnmapViewOfFile(m_base);
+        if (m_mapHandle) CloseHandle(static_cast<HANDLE>(m_mapHandle));
+        if (m_fileHandle) CloseHandle(static_cast<HANDLE>(m_fileHandle));
+        m_mapHandle = nullptr;
+        m_fileHandle = nullptr;
+#else
+        if (m_base) munmap(const_cast<unsigned char*>(m_base), m_size);
+        if (m_fd >= 0) ::close(m_fd);
+        m_fd = -1;
+#endif
+        m_base = nullptr;
+        m_size = 0;
+    }
+
+    const Chunk* Reader::FindChunk(uint32_t tag) const {
+        for (const Chunk& chunk : m_chunks) {
+            if (chunk.tag == tag) return &chunk;
+        }
+        return nullptr;
+    }
+
+    bool Reader::FindPrimarySwapChain(uint32_t* swapChainId, size_t* frames) const {
+        std::map<uint32_t, size_t> perSwapChain;
+        ForEachFrame([&](const FrameRecord& f) { perSwapChain[f.swapChainId]++; });
+        if (perSwapChain.empty()) return false;
+
+        auto primary = perSwapChain.begin();
+        for (auto it = perSwapChain.begin(); it != perSwapChain.end(); ++it) {
+            if (it->second > primary->second) primary = it;
+        }
+        *swapChainId = primary->first;
+        *frames = primary->second;
+        return true;
+    }
+}
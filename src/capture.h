@@ -0,0 +1,184 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <vector>
+
+// Frame capture files (*.fpsc) and session sketch files (*.fpsq).
+//
+// Layout: FileHeader, then a sequence of chunks (ChunkHeader + payload).
+// Frames are stored in FRMS chunks as packed FrameRecord arrays so a reader
+// can map the file and walk the records in place. Other chunk types carry
+// per-session summaries and are skipped by readers that don't know them.
+// A sketch file is the same container with only SESS and QSKT chunks.
+//
+// This file is shared by fps_overlay.dll (writer) and the offline tools
+// (reader), so it must stay free of Windows headers.
+namespace Capture {
+    constexpr uint32_t MakeTag(char a, char b, char c, char d) {
+        return static_cast<uint32_t>(static_cast<unsigned char>(a)) |
+               (static_cast<uint32_t>(static_cast<unsigned char>(b)) << 8) |
+               (static_cast<uint32_t>(static_cast<unsigned char>(c)) << 16) |
+               (static_cast<uint32_t>(static_cast<unsigned char>(d)) << 24);
+    }
+
+    constexpr uint32_t kMagic = MakeTag('F', 'P', 'S', 'C');
+    constexpr uint32_t kVersion = 1;
+
+    constexpr uint32_t kChunkFrames = MakeTag('F', 'R', 'M', 'S');
+    constexpr uint32_t kChunkHeatmap = MakeTag('H', 'M', 'A', 'P');
+    constexpr uint32_t kChunkSketch = MakeTag('Q', 'S', 'K', 'T');
+    constexpr uint32_t kChunkSession = MakeTag('S', 'E', 'S', 'S');
+
+    // Frame flags
+    constexpr uint32_t kFrameVsync = 1u << 0;   // SyncInterval > 0
+
+    struct FileHeader {
+        uint32_t magic;
+        uint32_t version;
+        uint64_t qpcFrequency;  // Ticks per second of every *Qpc / *Ticks field
+        uint64_t startQpc;
+        uint32_t pid;
+        uint32_t reserved;
+        char exeName[64];       // UTF-8, NUL terminated
+    };
+
+    struct ChunkHeader {
+        uint32_t tag;
+        uint32_t reserved;
+        uint64_t size;          // Payload bytes following this header
+    };
+
+    struct FrameRecord {
+        uint64_t presentQpc;    // Timestamp when Present was entered
+        uint32_t presentTicks;  // Time spent inside the original Present
+        uint32_t overlayTicks;  // Time spent rendering the overlay
+        uint32_t swapChainId;
+        uint32_t flags;
+    };
+
+    // HMAP payload: header followed by rows * buckets uint32 counts, row-major.
+    // Bucket b covers [2^(minExponent + b / bucketsPerOctave) * (1 + (b % bucketsPerOctave) / bucketsPerOctave), next) ms.
+    struct HeatmapHeader {
+        float sliceSeconds;     // Wall-clock length of one row
+        uint32_t rows;
+        uint32_t buckets;
+        uint32_t bucketsPerOctave;
+        int32_t minExponent;
+        uint32_t reserved;
+    };
+
+    // QSKT payload: header followed by binCount uint64 counts for bin indices
+    // offset, offset + 1, ...  Bin i covers (gamma^(i-1), gamma^i] ms with
+    // gamma = (1 + relativeAccuracy) / (1 - relativeAccuracy).
+    struct SketchHeader {
+        double relativeAccuracy;
+        int32_t offset;
+        uint32_t binCount;
+        uint64_t count;
+        uint64_t zeroCount;
+        double sum;
+        double min;
+        double max;
+    };
+
+    // SESS payload: identifies what the frames in this file came from
+    struct SessionInfo {
+        char build[64];         // Game build id (PE timestamp + image size), NUL terminated
+        uint64_t startUnixTime;
+        double durationSeconds;
+    };
+
+    static_assert(sizeof(FileHeader) == 96, "FileHeader layout changed");
+    static_assert(sizeof(ChunkHeader) == 16, "ChunkHeader layout changed");
+    static_assert(sizeof(FrameRecord) == 24, "FrameRecord layout changed");
+    static_assert(sizeof(HeatmapHeader) == 24, "HeatmapHeader layout changed");
+    static_assert(sizeof(SketchHeader) == 56, "SketchHeader layout changed");
+    static_assert(sizeof(SessionInfo) == 80, "SessionInfo layout changed");
+
+    // Buffered writer. Frames are flushed as one FRMS chunk per buffer fill,
+    // written by a background thread started with the first one so Append
+    // never waits on the disk; summary chunks are queued behind them. Close
+    // writes what is still queued before closing the file.
+    class Writer {
+    public:
+        Writer() = default;
+        ~Writer();
+        Writer(const Writer&) = delete;
+        Writer& operator=(const Writer&) = delete;
+
+        bool Open(const char* path, const FileHeader& header);
+        void Append(const FrameRecord& frame);
+        // False if the file is not open or a write (possibly an earlier,
+        // queued one) failed
+        bool WriteChunk(uint32_t tag, const void* data, size_t size);
+        void Close();
+        bool IsOpen() const { return m_file != nullptr; }
+
+        struct Pending;
+
+    private:
+        void FlushFrames();
+        void StartThread();
+
+        std::FILE* m_file = nullptr;
+        std::vector<FrameRecord> m_frames;
+        std::shared_ptr<Pending> m_pending;     // Writer thread, once started
+    };
+
+    struct FrameSpan {
+        const FrameRecord* data;
+        size_t count;
+    };
+
+    struct Chunk {
+        uint32_t tag;
+        const void* data;
+        uint64_t size;
+    };
+
+    // Read-only memory-mapped view of a capture file.
+    class Reader {
+    public:
+        Reader() = default;
+        ~Reader();
+        Reader(const Reader&) = delete;
+        Reader& operator=(const Reader&) = delete;
+
+        bool Open(const char* path);
+        void Close();
+
+        const FileHeader& Header() const { return *m_header; }
+        const std::vector<FrameSpan>& Frames() const { return m_frameSpans; }
+        const std::vector<Chunk>& Chunks() const { return m_chunks; }
+        size_t FrameCount() const { return m_frameCount; }
+
+        // Returns the first chunk with the given tag, or nullptr.
+        const Chunk* FindChunk(uint32_t tag) const;
+
+        // Swapchain with the most frames (the game's main window); false if no frames
+        bool FindPrimarySwapChain(uint32_t* swapChainId, size_t* frames) const;
+
+        template <typename Fn>
+        void ForEachFrame(Fn&& fn) const {
+            for (const FrameSpan& span : m_frameSpans) {
+                for (size_t i = 0; i < span.count; i++) {
+                    fn(span.data[i]);
+                }
+            }
+        }
+
+    private:
+        const unsigned char* m_base = nullptr;
+        size_t m_size = 0;
+        void* m_fileHandle = nullptr;
+        void* m_mapHandle = nullptr;
+        int m_fd = -1;
+        const FileHeader* m_header = nullptr;
+        std::vector<FrameSpan> m_frameSpans;
+        std::vector<Chunk> m_chunks;
+        size_t m_frameCount = 0;
+    };
+}
@@ -0,0 +1,231 @@
+#include "config_schema.h"
+#include "ini_file.h"
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace ConfigSchema {
+    namespace {
+        bool EqualNoCase(const char* a, const char* b) {
+            for (; *a && *b; a++, b++) {
+                char ca = (*a >= 'A' && *a <= 'Z') ? static_cast<char>(*a + 32) : *a;
+                char cb = (*b >= 'A' && *b <= 'Z') ? static_cast<char>(*b + 32) : *b;
+                if (ca != cb) return false;
+            }
+            return *a == *b;
+        }
+
+        // Whole string must be a number (trailing blanks allowed)
+        bool ParseLong(const char* text, int base, long long* out) {
+            char* end = nullptr;
+            long long v = std::strtoll(text, &end, base);
+            if (end == text) return false;
+            while (*end == ' ' || *end == '\t') end++;
+            if (*end) return false;
+            *out = v;
+            return true;
+        }
+
+        // Members may be unaligned (packed shared-memory structs)
+        template <typename T>
+        T Load(const char* member) {
+            T v;
+            std::memcpy(&v, member, sizeof(T));
+            return v;
+        }
+
+        template <typename T>
+        void Store(char* member, T v) {
+            std::memcpy(member, &v, sizeof(T));
+        }
+
+        bool HasRange(const Field& field) { return field.min < field.max; }
+
+        // false if out of range and the field rejects instead of clamping
+        bool FitRange(const Field& field, double* v) {
+            if (!HasRange(field)) return true;
+            if (*v >= field.min && *v <= field.max) return true;
+            if (!field.clamp) return false;
+            *v = *v < field.min ? field.min : field.max;
+            return true;
+        }
+
+        bool ParseInteger(const Field& field, const char* text, char* member) {
+            long long v;
+            if (!ParseLong(text, 0, &v)) return false;
+            double d = static_cast<double>(v);
+            if (!FitRange(field, &d)) return false;
+            Store(member, static_cast<int>(d));
+            return true;
+        }
+    }
+
+    bool ParseValue(const Field& field, const char* text, void* target) {
+        char* member = static_cast<char*>(target) + field.offset;
+        switch (field.kind) {
+        case Kind::Bool: {
+            bool v;
+            long long n;
+            if (EqualNoCase(text, "true") || EqualNoCase(text, "yes") || EqualNoCase(text, "on")) v = true;
+            else if (EqualNoCase(text, "false") || EqualNoCase(text, "no") || EqualNoCase(text, "off")) v = false;
+            else if (ParseLong(text, 0, &n)) v = n != 0;
+            else return false;
+            Store(member, v);
+            return true;
+        }
+        case Kind::Int:
+            return ParseInteger(field, text, member);
+        case Kind::Float: {
+            char* end = nullptr;
+            double v = std::strtod(text, &end);
+            if (end == text || !std::isfinite(v)) return false;
+            if (!FitRange(field, &v)) return false;
+            Store(member, static_cast<float>(v));
+            return true;
+        }
+        case Kind::Color: {
+            if (*text == '#') text++;
+            long long v;
+            if (!ParseLong(text, 16, &v) || v < 0 || v > 0xFFFFFFFFLL) return false;
+            Store(member, static_cast<uint32_t>(v));
+            return true;
+        }
+        case Kind::Enum: {
+            for (const EnumName* e = field.names; e && e->name; e++) {
+                if (EqualNoCase(text, e->name)) {
+                    Store(member, e->value);
+                    return true;
+                }
+            }
+            long long v;
+            if (!ParseLong(text, 10, &v)) return false;
+            for (const EnumName* e = field.names; e && e->name; e++) {
+                if (e->value == v) {
+                    Store(member, e->value);
+                    return true;
+                }
+            }
+            return false;
+        }
+        case Kind::Key: {
+            if ((text[0] == 'F' || text[0] == 'f') && text[1] >= '1' && text[1] <= '9') {
+                long long n;
+                if (ParseLong(text + 1, 10, &n) && n >= 1 && n <= 24) {
+                    Store(member, kVkF1 + static_cast<int>(n) - 1);
+                    return true;
+                }
+                return false;
+            }
+            return ParseInteger(field, text, member);
+        }
+        case Kind::String: {
+            size_t len = std::strlen(text);
+            if (len >= field.size) {
+                // Cut before the code point that does not fit, never inside it
+                len = field.size - 1u;
+                while (len > 0 && (static_cast<unsigned char>(text[len]) & 0xC0) == 0x80) len--;
+            }
+            std::memcpy(member, text, len);
+            member[len] = '\0';
+            return true;
+        }
+        }
+        return false;
+    }
+
+    void Apply(const Schema& schema, const IniFile& ini, void* target) {
+        for (size_t i = 0; i < schema.count; i++) {
+            const Field& field = schema.fields[i];
+            if (!field.key) continue;
+            const char* text = ini.Get(field.section, field.key);
+            if (text) ParseValue(field, text, target);
+        }
+    }
+
+    void FormatValue(const Field& field, const void* source, bool boolWords, std::string& out) {
+        const char* member = static_cast<const char*>(source) + field.offset;
+        char buf[32];
+        switch (field.kind) {
+        case Kind::Bool: {
+            bool v = Load<bool>(member);
+            out += boolWords ? (v ? "true" : "false") : (v ? "1" : "0");
+            return;
+        }
+        case Kind::Int:
+            std::snprintf(buf, sizeof(buf), "%d", Load<int>(member));
+            break;
+        case Kind::Float:
+            std::snprintf(buf, sizeof(buf), "%g", static_cast<double>(Load<float>(member)));
+            break;
+        case Kind::Color:
+            std::snprintf(buf, sizeof(buf), "%08X", static_cast<unsigned>(Load<uint32_t>(member)));
+            break;
+        case Kind::Enum: {
+            int v = Load<int>(member);
+            for (const EnumName* e = field.names; e && e->name; e++) {
+                if (e->value == v) {
+                    out += e->name;
+                    return;
+                }
+            }
+            std::snprintf(buf, sizeof(buf), "%d", v);
+            break;
+        }
+        case Kind::Key: {
+            int v = Load<int>(member);
+            if (v >= kVkF1 && v < kVkF1 + 24) std::snprintf(buf, sizeof(buf), "F%d", v - kVkF1 + 1);
+            else std::snprintf(buf, sizeof(buf), "%d", v);
+            break;
+        }
+        case Kind::String:
+            out += member;
+            return;
+        }
+        out += buf;
+    }
+
+    void Write(const Schema& schema, const void* source, std::string& out) {
+        for (const char* line = schema.header; line && *line;) {
+            const char* end = std::strchr(line, '\n');
+            size_t len = end ? static_cast<size_t>(end - line) : std::strlen(line);
+            out += "; ";
+            out.append(line, len);
+            out += '\n';
+            line += end ? len + 1 : len;
+        }
+
+        // Sections in order of first appearance, each written once
+        for (size_t i = 0; i < schema.count; i++) {
+            const Field& first = schema.fields[i];
+            if (!first.key) continue;
+            bool seen = false;
+            for (size_t j = 0; j < i && !seen; j++) {
+                seen = schema.fields[j].key && std::strcmp(schema.fields[j].section, first.section) == 0;
+            }
+            if (seen) continue;
+
+            if (!out.empty()) out += '\n';
+            out += '[';
+            out += first.section;
+            out += "]\n";
+
+            bool sectionEmpty = true;
+            for (size_t j = i; j < schema.count; j++) {
+                const Field& field = schema.fields[j];
+                if (!field.key || std::strcmp(field.section, first.section) != 0) continue;
+                if (field.comment) {
+                    if (!sectionEmpty) out += '\n';
+                    out += "; ";
+                    out += field.comment;
+                    out += '\n';
+                }
+                out += field.key;
+                out += '=';
+                FormatValue(field, source, schema.boolWords, out);
+                out += '\n';
+                sectionEmpty = false;
+            }
+        }
+    }
+}
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+class IniFile;
+
+// Typed INI schema, declared once per config file.
+//
+// A config file is described by one X-macro list; each entry is
+//
+//     X(kind, member, section, key, def, min, max, clamp, names, comment)
+//
+// and the same list expands into the struct (CONFIG_SCHEMA_MEMBER, with the
+// default as member initializer) and into a constexpr Field table
+// (CONFIG_SCHEMA_FIELD, offsetof + sizeof of each member). Parsing, range
+// checks and the default-file writer are loops over that table: adding a key
+// is one line in the list.
+//
+//   - min/max: inclusive range for Int/Float/Key, capacity for String;
+//     ignored when min >= max
+//   - clamp: kClamp pulls out-of-range values into the range, kReject keeps
+//     the previous value
+//   - names: EnumName table (nullptr-terminated) for Enum, else nullptr
+//   - key nullptr: runtime-only member (in the struct, not in the file)
+//   - comment: written above the key in default files (nullptr = none)
+namespace ConfigSchema {
+    enum class Kind : uint8_t {
+        Bool,       // true/yes/on and false/no/off, or a number (non-zero = true)
+        Int,
+        Float,
+        Color,      // AARRGGBB hex, optional '#' or 0x prefix
+        Enum,       // One of names (case-insensitive) or its number
+        Key,        // Virtual-key code: F1..F24 or a number
+        String,     // UTF-8, truncated to the member size
+    };
+
+    constexpr bool kClamp = true;
+    constexpr bool kReject = false;
+
+    constexpr int kVkF1 = 0x70;
+
+    struct EnumName {
+        const char* name;
+        int value;
+    };
+
+    struct Field {
+        const char* section;
+        const char* key;
+        Kind kind;
+        uint16_t size;
+        uint32_t offset;
+        double min;
+        double max;
+        bool clamp;
+        const EnumName* names;
+        const char* comment;
+    };
+
+    struct Schema {
+        const Field* fields;
+        size_t count;
+        const char* header;     // Leading comment block, lines separated by '\n'
+        bool boolWords;         // Write bools as true/false instead of 1/0
+    };
+
+    template <Kind K, size_t Capacity> struct Storage { using type = int; };
+    template <size_t Capacity> struct Storage<Kind::Bool, Capacity> { using type = bool; };
+    template <size_t Capacity> struct Storage<Kind::Float, Capacity> { using type = float; };
+    template <size_t Capacity> struct Storage<Kind::Color, Capacity> { using type = uint32_t; };
+    template <size_t Capacity> struct Storage<Kind::String, Capacity> { using type = char[Capacity]; };
+
+    constexpr size_t Capacity(double max) { return max > 0 ? static_cast<size_t>(max) : 1; }
+
+    template <size_t N>
+    constexpr Schema MakeSchema(const Field (&fields)[N], const char* header, bool boolWords) {
+        return Schema{ fields, N, header, boolWords };
+    }
+
+    // Overwrites the members whose key is present and valid; others keep
+    // their current value
+    void Apply(const Schema& schema, const IniFile& ini, void* target);
+
+    // Parses one value into the member; false (member untouched) if invalid
+    bool ParseValue(const Field& field, const char* text, void* target);
+
+    // Whole file: header, sections, comments, one key=value per member
+    void Write(const Schema& schema, const void* source, std::string& out);
+
+    void FormatValue(const Field& field, const void* source, bool boolWords, std::string& out);
+}
+
+#define CONFIG_SCHEMA_MEMBER(kind, member, section, key, def, min, max, clamp, names, comment) \
+    ConfigSchema::Storage<ConfigSchema::Kind::kind, ConfigSchema::Capacity(max)>::type member = def;
+
+#define CONFIG_SCHEMA_FIELD(Struct, kind, member, section, key, def, min, max, clamp, names, comment) \
+    ConfigSchema::Field{ section, key, ConfigSchema::Kind::kind, \
+                         static_cast<uint16_t>(sizeof(Struct::member)), \
+                         static_cast<uint32_t>(offsetof(Struct, member)), \
+                         min, max, clamp, names, comment },
@@ -0,0 +1,259 @@
+#include "entry_point_cache.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace EntryPointCache {
+    namespace {
+        // Slots never live in the first page (DOS and PE headers)
+        constexpr uint32_t kHeaderSize = 0x1000;
+        constexpr size_t kMaxFileSize = sizeof(FileHeader) + kMaxEntries * sizeof(Entry);
+
+        inline uint64_t Mix(uint64_t x) {
+            x ^= x >> 33;
+            x *= 0xFF51AFD7ED558CCDull;
+            x ^= x >> 33;
+            x *= 0xC4CEB9FE1A85EC53ull;
+            x ^= x >> 33;
+            return x;
+        }
+
+        uint32_t CurrentPid() {
+#ifdef _WIN32
+            return GetCurrentProcessId();
+#else
+            return static_cast<uint32_t>(getpid());
+#endif
+        }
+
+        bool ReplaceFile(const char* from, const char* to) {
+#ifdef _WIN32
+            return MoveFileExA(from, to, MOVEFILE_REPLACE_EXISTING) != FALSE;
+#else
+            return std::rename(from, to) == 0;
+#endif
+        }
+    }
+
+    uint64_t MakeKey(const char* path, size_t length, const ModuleIdentity& identity) {
+        uint64_t h = 14695981039346656037ull;
+        for (size_t i = 0; i < length; i++) {
+            unsigned char c = static_cast<unsigned char>(path[i]);
+            if (c >= 'A' && c <= 'Z') c = static_cast<unsigned char>(c + ('a' - 'A'));
+            else if (c == '/') c = '\\';
+            h = (h ^ c) * 1099511628211ull;
+        }
+        h = Mix(h ^ identity.fileSize);
+        h = Mix(h ^ identity.lastWrite);
+        h = Mix(h ^ ((uint64_t(identity.timeDateStamp) << 32) | identity.checkSum));
+        h = Mix(h ^ ((uint64_t(identity.sizeOfImage) << 8) | sizeof(void*)));
+        return h | (uint64_t(1) << 63);
+    }
+
+    uintptr_t SlotAddress(const Module& module, uint32_t rva) {
+        if (rva < kHeaderSize || rva % sizeof(void*) != 0) return 0;
+        if (rva > module.sizeOfImage || module.sizeOfImage - rva < sizeof(void*)) return 0;
+        return module.base + rva;
+    }
+
+    bool SlotRva(const Module& module, const void* slot, uint32_t* rva) {
+        uintptr_t address = reinterpret_cast<uintptr_t>(slot);
+        if (address < module.base || address - module.base > UINT32_MAX) return false;
+        uint32_t offset = static_cast<uint32_t>(address - module.base);
+        if (SlotAddress(module, offset) != address) return false;
+        *rva = offset;
+        return true;
+    }
+
+    bool Table::Load(const char* path) {
+        m_entries.clear();
+        m_nextStamp = 0;
+        std::FILE* f = std::fopen(path, "rb");
+        if (!f) return false;
+        std::vector<unsigned char> data(kMaxFileSize + 1);
+        size_t size = std::fread(data.data(), 1, data.size(), f);
+        bool ok = !std::ferror(f);
+        std::fclose(f);
+        if (ok) Parse(data.data(), size);
+        return ok;
+    }
+
+    bool Table::Save(const char* path) const {
+        std::vector<unsigned char> data;
+        Serialize(data);
+
+        char suffix[32];
+        std::snprintf(suffix, sizeof(suffix), ".%u.tmp", CurrentPid());
+        std::string temp = std::string(path) + suffix;
+        std::FILE* f = std::fopen(temp.c_str(), "wb");
+        if (!f) return false;
+        bool ok = std::fwrite(data.data(), 1, data.size(), f) == data.size();
+        ok = std::fclose(f) == 0 && ok;
+        if (ok) ok = ReplaceFile(temp.c_str(), path);
+        if (!ok) std::remove(temp.c_str());
+        return ok;
+    }
+
+    void Table::Parse(const void* data, size_t size) {
+        m_entries.clear();
+        m_nextStamp = 0;
+        if (size < sizeof(FileHeader) || size > kMaxFileSize) return;
+
+        FileHeader header;
+        std::memcpy(&header, data, sizeof(header));
+        if (header.magic != kMagic || header.version != kVersion || header.count > kMaxEntries) return;
+        if (size != sizeof(FileHeader) + header.count * sizeof(Entry)) return;
+
+        m_entries.resize(header.count);
+        std::memcpy(m_entries.data(), static_cast<const unsigned char*>(data) + sizeof(FileHeader),
+                    header.count * sizeof(Entry));
+
+        // Stamps are renumbered 0..n-1 in their order, so a damaged stamp
+        // near UINT32_MAX cannot wrap m_nextStamp and get new entries
+        // dropped first; of two entries for one slot the newer one is kept
+        std::stable_sort(m_entries.begin(), m_entries.end(),
+                         [](const Entry& a, const Entry& b) { return a.stamp < b.stamp; });
+        for (size_t i = m_entries.size(); i-- > 0;) {
+            for (size_t j = i + 1; j < m_entries.size(); j++) {
+                if (m_entries[j].moduleKey == m_entries[i].moduleKey && m_entries[j].id == m_entries[i].id) {
+                    m_entries.erase(m_entries.begin() + i);
+                    break;
+                }
+            }
+        }
+        for (Entry& entry : m_entries) entry.stamp = m_nextStamp++;
+    }
+
+    void Table::Serialize(std::vector<unsigned char>& out) const {
+        FileHeader header = {};
+        header.magic = kMagic;
+        header.version = kVersion;
+        header.count = static_cast<uint32_t>(m_entries.size());
+        out.resize(sizeof(header) + m_entries.size() * sizeof(Entry));
+        std::memcpy(out.data(), &header, sizeof(header));
+        if (!m_entries.empty()) {
+            std::memcpy(out.data() + sizeof(header), m_entries.data(), m_entries.size() * sizeof(Entry));
+        }
+    }
+
+    bool Table::Lookup(uint64_t moduleKey, uint32_t id, uint32_t* rva) const {
+        for (const Entry& entry : m_entries) {
+            if (entry.moduleKey == moduleKey && entry.id == id) {
+                *rva = entry.rva;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool Table::Store(uint64_t moduleKey, uint32_t id, uint32_t rva) {
+        for (Entry& entry : m_entries) {
+            if (entry.moduleKey != moduleKey || entry.id != id) continue;
+            if (entry.rva == rva) return false;
+            entry.rva = rva;
+            entry.stamp = m_nextStamp++;
+            return true;
+        }
+
+        // Full: drop the entry stored longest ago
+        if (m_entries.size() >= kMaxEntries) {
+            size_t oldest = 0;
+            for (size_t i = 1; i < m_entries.size(); i++) {
+                if (m_entries[i].stamp < m_entries[oldest].stamp) oldest = i;
+            }
+            m_entries.erase(m_entries.begin() + oldest);
+        }
+
+        Entry entry = {};
+        entry.moduleKey = moduleKey;
+        entry.id = id;
+        entry.rva = rva;
+        entry.stamp = m_nextStamp++;
+        m_entries.push_back(entry);
+        return true;
+    }
+
+    bool Table::Remove(uint64_t moduleKey, uint32_t id) {
+        for (size_t i = 0; i < m_entries.size(); i++) {
+            if (m_entries[i].moduleKey == moduleKey && m_entries[i].id == id) {
+                m_entries.erase(m_entries.begin() + i);
+                return true;
+            }
+        }
+        return false;
+    }
+
+#ifdef _WIN32
+
+    bool IdentifyModule(const wchar_t* name, Module* module) {
+        HMODULE handle = GetModuleHandleW(name);
+        if (!handle) return false;
+
+        const BYTE* base = reinterpret_cast<const BYTE*>(handle);
+        const IMAGE_DOS_HEADER* dos = reinterpret_cast<const IMAGE_DOS_HEADER*>(base);
+        if (dos->e_magic != IMAGE_DOS_SIGNATURE) return false;
+        const IMAGE_NT_HEADERS* nt = reinterpret_cast<const IMAGE_NT_HEADERS*>(base + dos->e_lfanew);
+        if (nt->Signature != IMAGE_NT_SIGNATURE) return false;
+
+        wchar_t widePath[MAX_PATH];
+        DWORD len = GetModuleFileNameW(handle, widePath, MAX_PATH);
+        if (len == 0 || len >= MAX_PATH) return false;
+        WIN32_FILE_ATTRIBUTE_DATA data;
+        if (!GetFileAttributesExW(widePath, GetFileExInfoStandard, &data)) return false;
+        char path[MAX_PATH * 3];
+        int bytes = WideCharToMultiByte(CP_UTF8, 0, widePath, (int)len, path, sizeof(path), NULL, NULL);
+        if (bytes <= 0) return false;
+
+        ModuleIdentity identity = {};
+        identity.fileSize = ((uint64_t)data.nFileSizeHigh << 32) | data.nFileSizeLow;
+        identity.lastWrite = ((uint64_t)data.ftLastWriteTime.dwHighDateTime << 32) | data.ftLastWriteTime.dwLowDateTime;
+        identity.timeDateStamp = nt->FileHeader.TimeDateStamp;
+        identity.checkSum = nt->OptionalHeader.CheckSum;
+        identity.sizeOfImage = nt->OptionalHeader.SizeOfImage;
+
+        module->base = reinterpret_cast<uintptr_t>(handle);
+        module->sizeOfImage = identity.sizeOfImage;
+        module->key = MakeKey(path, (size_t)bytes, identity);
+        return true;
+    }
+
+    void** FindSlot(const Table& table, const Module& module, uint32_t id) {
+        uint32_t rva;
+        if (!table.Lookup(module.key, id, &rva)) return nullptr;
+        uintptr_t address = SlotAddress(module, rva);
+        if (!address) return nullptr;
+
+        const DWORD readable = PAGE_READONLY | PAGE_READWRITE | PAGE_WRITECOPY | PAGE_EXECUTE_READ |
+                               PAGE_EXECUTE_READWRITE | PAGE_EXECUTE_WRITECOPY;
+        const DWORD executable = PAGE_EXECUTE | PAGE_EXECUTE_READ | PAGE_EXECUTE_READWRITE | PAGE_EXECUTE_WRITECOPY;
+        MEMORY_BASIC_INFORMATION info;
+        void** slot = reinterpret_cast<void**>(address);
+        if (!VirtualQuery(slot, &info, sizeof(info)) || info.State != MEM_COMMIT ||
+            !(info.Protect & readable) || (info.Protect & PAGE_GUARD)) {
+            return nullptr;
+        }
+        // The target may belong to another overlay that hooked the slot, so
+        // only require code, not code inside the module
+        void* target = *slot;
+        if (!target || !VirtualQuery(target, &info, sizeof(info)) || info.State != MEM_COMMIT ||
+            !(info.Protect & executable)) {
+            return nullptr;
+        }
+        return slot;
+    }
+
+    bool RememberSlot(Table& table, const Module& module, uint32_t id, void** slot) {
+        uint32_t rva;
+        if (!SlotRva(module, slot, &rva)) return false;
+        return table.Store(module.key, id, rva);
+    }
+
+#endif
+}
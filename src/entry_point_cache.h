@@ -0,0 +1,112 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Entry points resolved in system modules (vtable slots of the DXGI swap
+// chain and the D3D9 device), remembered across injections so that a later
+// process hooks without creating a window and a dummy device just to read
+// one pointer.
+//
+// Entries are keyed by the module's identity: path, file size and last
+// write, plus TimeDateStamp, CheckSum and SizeOfImage from the PE header.
+// An OS update replaces the file, so stale RVAs are simply never looked up.
+// A hit is still checked against the loaded image before use (FindSlot);
+// on a miss or a failed check the caller creates the dummy device as before
+// and records what it found.
+//
+// File: FileHeader followed by Entry records, rewritten whole through a
+// temporary file and a rename. Processes saving at the same time may lose
+// each other's new entries, which only costs one more dummy device later.
+// The table and its checks are portable so they are tested on Linux; the
+// module lookup at the bottom is Windows only.
+namespace EntryPointCache {
+    constexpr uint32_t kMagic = 0x43545045;     // "EPTC"
+    constexpr uint32_t kVersion = 1;
+    constexpr uint32_t kMaxEntries = 256;       // Oldest entries are dropped beyond this
+
+    enum EntryPoint : uint32_t {
+        kDxgiPresentSlot = 1,
+        kDxgiResizeBuffersSlot = 2,
+        kD3D9EndSceneSlot = 3,
+    };
+
+    struct ModuleIdentity {
+        uint64_t fileSize;
+        uint64_t lastWrite;
+        uint32_t timeDateStamp;
+        uint32_t checkSum;
+        uint32_t sizeOfImage;
+    };
+
+    struct FileHeader {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t count;
+        uint32_t reserved;
+    };
+
+    struct Entry {
+        uint64_t moduleKey;
+        uint32_t id;            // EntryPoint
+        uint32_t rva;
+        uint32_t stamp;         // Order of insertion, for eviction
+        uint32_t reserved;
+    };
+
+    // Loaded module as seen by the cache
+    struct Module {
+        uintptr_t base;
+        uint32_t sizeOfImage;
+        uint64_t key;
+    };
+
+    // Never 0; path bytes are folded (ASCII case, '/' = '\'). The pointer
+    // size is mixed in, so 32- and 64-bit processes never share entries.
+    uint64_t MakeKey(const char* path, size_t length, const ModuleIdentity& identity);
+
+    // Address of the pointer-sized slot at rva, or 0 if no slot can be there:
+    // misaligned, inside the PE headers or past the end of the image
+    uintptr_t SlotAddress(const Module& module, uint32_t rva);
+
+    // RVA of slot inside module; false if the slot is not in the image
+    bool SlotRva(const Module& module, const void* slot, uint32_t* rva);
+
+    class Table {
+    public:
+        // A missing or unreadable file leaves the table empty
+        bool Load(const char* path);
+        bool Save(const char* path) const;
+
+        // Malformed data (wrong magic, version or size) leaves the table
+        // empty; stamps are renumbered and duplicate slots dropped
+        void Parse(const void* data, size_t size);
+        void Serialize(std::vector<unsigned char>& out) const;
+
+        bool Lookup(uint64_t moduleKey, uint32_t id, uint32_t* rva) const;
+
+        // True if the table changed (and should be saved)
+        bool Store(uint64_t moduleKey, uint32_t id, uint32_t rva);
+        bool Remove(uint64_t moduleKey, uint32_t id);
+
+        size_t Size() const { return m_entries.size(); }
+
+    private:
+        std::vector<Entry> m_entries;
+        uint32_t m_nextStamp = 0;
+    };
+
+#ifdef _WIN32
+    // Identity of a loaded module (e.g. L"dxgi.dll"); false if not loaded
+    bool IdentifyModule(const wchar_t* name, Module* module);
+
+    // Cached slot of id in module, after checking that the slot is readable
+    // and points at executable code; nullptr otherwise
+    void** FindSlot(const Table& table, const Module& module, uint32_t id);
+
+    // Records a slot found through a dummy device; false if nothing changed
+    // or the slot is not inside the module
+    bool RememberSlot(Table& table, const Module& module, uint32_t id, void** slot);
+#endif
+}
@@ -0,0 +1,210 @@
+#include "file_watcher.h"
+#include "module_thread.h"
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <thread>
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+namespace {
+    enum class WaitResult {
+        Stop,
+        Changed,    // Event for the watched file (or an overflow)
+        Other,      // Event for another file in the directory
+        Timeout,
+    };
+
+    using Clock = std::chrono::steady_clock;
+}
+
+struct FileWatcher::State {
+    std::filesystem::path file;
+    std::function<bool()> onChange;
+    std::atomic<bool> exited{false};
+
+#ifdef _WIN32
+    HANDLE dir = INVALID_HANDLE_VALUE;
+    HANDLE stopEvent = nullptr;
+    OVERLAPPED overlapped = {};
+    bool issued = false;
+    DWORD buffer[4096];     // FILE_NOTIFY_INFORMATION needs DWORD alignment
+
+    ~State() {
+        if (dir != INVALID_HANDLE_VALUE) CloseHandle(dir);
+        if (overlapped.hEvent) CloseHandle(overlapped.hEvent);
+        if (stopEvent) CloseHandle(stopEvent);
+    }
+
+    bool Open() {
+        dir = CreateFileW(file.parent_path().c_str(), FILE_LIST_DIRECTORY,
+                          FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING,
+                          FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, nullptr);
+        if (dir == INVALID_HANDLE_VALUE) return false;
+        overlapped.hEvent = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+        stopEvent = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+        return overlapped.hEvent && stopEvent;
+    }
+
+    void SignalStop() { SetEvent(stopEvent); }
+
+    WaitResult Wait(DWORD timeoutMs) {
+        if (!issued) {
+            ResetEvent(overlapped.hEvent);
+            if (!ReadDirectoryChangesW(dir, buffer, sizeof(buffer), FALSE,
+                                       FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_SIZE,
+                                       nullptr, &overlapped, nullptr)) {
+                return WaitResult::Stop;
+            }
+            issued = true;
+        }
+
+        HANDLE handles[2] = { stopEvent, overlapped.hEvent };
+        DWORD result = WaitForMultipleObjects(2, handles, FALSE, timeoutMs);
+        if (result == WAIT_TIMEOUT) return WaitResult::Timeout;
+
+        DWORD bytes = 0;
+        if (result != WAIT_OBJECT_0 + 1) {
+            CancelIoEx(dir, &overlapped);
+            GetOverlappedResult(dir, &overlapped, &bytes, TRUE);
+            return WaitResult::Stop;
+        }
+
+        issued = false;
+        if (!GetOverlappedResult(dir, &overlapped, &bytes, FALSE) || bytes == 0) {
+            return WaitResult::Changed;     // Buffer overflow: assume the file changed
+        }
+
+        const std::wstring name = file.filename().wstring();
+        const unsigned char* p = reinterpret_cast<const unsigned char*>(buffer);
+        for (;;) {
+            const FILE_NOTIFY_INFORMATION* info = reinterpret_cast<const FILE_NOTIFY_INFORMATION*>(p);
+            int length = static_cast<int>(info->FileNameLength / sizeof(WCHAR));
+            if (CompareStringOrdinal(info->FileName, length, name.c_str(), static_cast<int>(name.size()), TRUE) == CSTR_EQUAL) {
+                return WaitResult::Changed;
+            }
+            if (!info->NextEntryOffset) break;
+            p += info->NextEntryOffset;
+        }
+        return WaitResult::Other;
+    }
+#else
+    int inotifyFd = -1;
+    int stopPipe[2] = { -1, -1 };
+
+    ~State() {
+        if (inotifyFd >= 0) close(inotifyFd);
+        if (stopPipe[0] >= 0) close(stopPipe[0]);
+        if (stopPipe[1] >= 0) close(stopPipe[1]);
+    }
+
+    bool Open() {
+        inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (inotifyFd < 0 || pipe(stopPipe) != 0) return false;
+        std::filesystem::path dir = file.parent_path();
+        if (dir.empty()) dir = ".";
+        return inotify_add_watch(inotifyFd, dir.c_str(), IN_CLOSE_WRITE | IN_MODIFY | IN_MOVED_TO | IN_CREATE | IN_DELETE) >= 0;
+    }
+
+    void SignalStop() {
+        char c = 1;
+        (void)!write(stopPipe[1], &c, 1);
+    }
+
+    WaitResult Wait(int timeoutMs) {
+        pollfd fds[2] = { { stopPipe[0], POLLIN, 0 }, { inotifyFd, POLLIN, 0 } };
+        int n = poll(fds, 2, timeoutMs);
+        if (n == 0) return WaitResult::Timeout;
+        if (n < 0 || fds[0].revents) return WaitResult::Stop;
+
+        const std::string name = file.filename().string();
+        alignas(inotify_event) char buf[4096];
+        WaitResult result = WaitResult::Other;
+        ssize_t len;
+        while ((len = read(inotifyFd, buf, sizeof(buf))) > 0) {
+            for (char* p = buf; p < buf + len;) {
+                const inotify_event* event = reinterpret_cast<const inotify_event*>(p);
+                if ((event->mask & IN_Q_OVERFLOW) || (event->len && name == event->name)) {
+                    result = WaitResult::Changed;
+                }
+                p += sizeof(inotify_event) + event->len;
+            }
+        }
+        return result;
+    }
+#endif
+};
+
+FileWatcher::~FileWatcher() {
+    Stop();
+}
+
+bool FileWatcher::Start(const std::filesystem::path& file, std::function<bool()> onChange) {
+    Stop();
+
+    auto state = std::make_shared<State>();
+    state->file = file;
+    state->onChange = std::move(onChange);
+    if (!state->Open()) return false;
+
+    auto* ref = new std::shared_ptr<State>(state);
+    if (!ModuleThread::Start([](void* param) {
+            auto* ref = static_cast<std::shared_ptr<State>*>(param);
+            Run(std::move(*ref));
+            delete ref;
+        }, ref)) {
+        delete ref;
+        return false;
+    }
+    m_state = std::move(state);
+    return true;
+}
+
+void FileWatcher::Stop(unsigned timeoutMs) {
+    if (!m_state) return;
+    m_state->SignalStop();
+    for (unsigned i = 0; i < timeoutMs && !m_state->exited.load(std::memory_order_acquire); i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    m_state.reset();    // The thread keeps its own reference until it returns
+}
+
+void FileWatcher::Run(std::shared_ptr<State> state) {
+    bool pending = false;
+    int retries = 0;
+    Clock::time_point deadline;
+
+    for (;;) {
+        int timeoutMs = -1;
+        if (pending) {
+            auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - Clock::now()).count();
+            timeoutMs = left > 0 ? static_cast<int>(left) : 0;
+        }
+#ifdef _WIN32
+        WaitResult result = state->Wait(timeoutMs < 0 ? INFINITE : static_cast<DWORD>(timeoutMs));
+#else
+        WaitResult result = state->Wait(timeoutMs);
+#endif
+        if (result == WaitResult::Stop) break;
+
+        if (result == WaitResult::Changed) {
+            pending = true;
+            retries = 0;
+            deadline = Clock::now() + std::chrono::milliseconds(FileWatcher::kDebounceMs);
+        } else if (result == WaitResult::Timeout && pending) {
+            if (state->onChange() || ++retries > FileWatcher::kMaxRetries) {
+                pending = false;
+            } else {
+                deadline = Clock::now() + std::chrono::milliseconds(FileWatcher::kRetryMs);
+            }
+        }
+    }
+    state->exited.store(true, std::memory_order_release);
+}
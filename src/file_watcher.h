@@ -0,0 +1,40 @@
+#pragma once
+
+#include <filesystem>
+#include <functional>
+#include <memory>
+
+// Watches one file from a background thread using OS change notifications
+// (ReadDirectoryChangesW on Windows, inotify on Linux) on its directory, so
+// editor save patterns (truncate + write, or write temp + rename) are seen.
+// Bursts of events are coalesced: onChange runs on the watcher thread once
+// the file has been quiet for kDebounceMs. If onChange returns false (e.g.
+// the file was still locked) it is retried a few times.
+class FileWatcher {
+public:
+    static constexpr unsigned kDebounceMs = 50;
+    static constexpr unsigned kRetryMs = 100;
+    static constexpr int kMaxRetries = 10;
+
+    FileWatcher() = default;
+    ~FileWatcher();
+    FileWatcher(const FileWatcher&) = delete;
+    FileWatcher& operator=(const FileWatcher&) = delete;
+
+    bool Start(const std::filesystem::path& file, std::function<bool()> onChange);
+
+    // Signals the thread and waits at most timeoutMs for it to leave. The
+    // thread is detached, never joined, so this is safe under the loader lock
+    // (at process exit the thread is already gone). On Windows the thread
+    // keeps the module loaded until it has exited, so returning before it
+    // does cannot unmap its code.
+    void Stop(unsigned timeoutMs = 100);
+
+    bool IsRunning() const { return m_state != nullptr; }
+
+private:
+    struct State;
+    static void Run(std::shared_ptr<State> state);
+
+    std::shared_ptr<State> m_state;
+};
@@ -1,7 +1,12 @@
 #include "fps_counter.h"
+#include "module_thread.h"
 #include <Windows.h>
+#include <atomic>
 #include <chrono>
+#include <condition_variable>
 #include <deque>
+#include <mutex>
+#include <vector>
 
 namespace FpsCounter {
     using Clock = std::chrono::high_resolution_clock;
@@ -19,6 +24,37 @@ namespace FpsCounter {
     static bool s_firstFrame = true;
     static bool s_firstDisplay = true;
 
+    static constexpr size_t kHistorySize = 2048;
+    static constexpr size_t kMinStutterFrames = 256;
+    static constexpr long long kStutterAnalysisMs = 2000;
+    static std::vector<float> s_history(kHistorySize, 0.0f);
+    static std::vector<float> s_historyScratch;
+    static size_t s_historyPos = 0;
+    static size_t s_historyCount = 0;
+    static bool s_stutterEnabled = true;
+    static TimePoint s_lastStutterAnalysis;
+    static Spectral::PeriodicStutter s_stutter;
+
+    // The FFT analysis runs on a worker thread on a snapshot of the history:
+    // Update only unrolls the ring into a buffer, swaps it in and later picks
+    // up the published result. A snapshot not yet taken is replaced by the
+    // newer one.
+    struct StutterWorker {
+        std::mutex mutex;
+        std::condition_variable wake;
+        std::vector<float> series;          // Pending snapshot, oldest first
+        bool queued = false;
+        bool started = false;
+        std::atomic<bool> stop{false};
+        Spectral::PeriodicStutter result;
+        std::atomic<bool> published{false};
+    };
+    static StutterWorker s_worker;
+
+    static TimePoint s_startTime;
+    static FrameTimeGraph s_graph;
+    static QuantileSketch s_sessionSketch;
+
     void SetSampleCount(size_t n) {
         if (n < 1) n = 1;
         if (n > 1000) n = 1000;
@@ -35,12 +71,83 @@ namespace FpsCounter {
         s_displayUpdateMs = ms;
     }
 
+    void SetGraphLayout(size_t columns, float windowSeconds) {
+        if (columns == s_graph.Columns() && windowSeconds == s_graph.WindowSeconds()) return;
+        s_graph.Configure(columns, windowSeconds);
+    }
+
+    void SetStutterAnalysis(bool enabled) {
+        s_stutterEnabled = enabled;
+        if (!enabled) s_stutter = Spectral::PeriodicStutter();
+    }
+
+    static void StutterThread(void*) {
+        Spectral::Analyzer analyzer;    // Keeps its FFT plans between runs
+        std::vector<float> series;
+        std::unique_lock<std::mutex> lock(s_worker.mutex);
+        for (;;) {
+            s_worker.wake.wait(lock, [] { return s_worker.queued || s_worker.stop.load(); });
+            if (s_worker.stop.load()) break;
+            series.swap(s_worker.series);
+            s_worker.queued = false;
+
+            lock.unlock();
+            Spectral::PeriodicStutter result = analyzer.Analyze(series.data(), series.size());
+            lock.lock();
+
+            s_worker.result = result;
+            s_worker.published.store(true, std::memory_order_release);
+        }
+    }
+
+    static void QueueStutterAnalysis() {
+        // Unroll the ring oldest-first
+        s_historyScratch.resize(s_historyCount);
+        size_t start = (s_historyPos + kHistorySize - s_historyCount) % kHistorySize;
+        for (size_t i = 0; i < s_historyCount; i++) {
+            s_historyScratch[i] = s_history[(start + i) % kHistorySize];
+        }
+
+        std::lock_guard<std::mutex> lock(s_worker.mutex);
+        if (s_worker.stop.load()) return;
+        if (!s_worker.started) {
+            s_worker.started = ModuleThread::Start(StutterThread, nullptr);
+            if (!s_worker.started) {
+                // No worker: stop analysing rather than stall the render thread
+                s_stutterEnabled = false;
+                return;
+            }
+        }
+        // The worker's previous buffer comes back, so no allocation once warm
+        s_worker.series.swap(s_historyScratch);
+        s_worker.queued = true;
+        s_worker.wake.notify_one();
+    }
+
+    // Takes a result the worker published since the last frame
+    static void AdoptStutterResult() {
+        if (!s_worker.published.load(std::memory_order_acquire)) return;
+        std::lock_guard<std::mutex> lock(s_worker.mutex);
+        s_stutter = s_worker.result;
+        s_worker.published.store(false, std::memory_order_relaxed);
+    }
+
+    void Shutdown() {
+        // Only signals: at process exit the worker may have died holding the
+        // lock, and it keeps the module loaded until it has returned
+        s_worker.stop.store(true);
+        if (s_worker.mutex.try_lock()) s_worker.mutex.unlock();
+        s_worker.wake.notify_all();
+    }
+
     void Update() {
         TimePoint now = Clock::now();
         
         if (s_firstFrame) {
             s_lastFrameTime = now;
             s_lastDisplayUpdate = now;
+            s_lastStutterAnalysis = now;
+            s_startTime = now;
             s_firstFrame = false;
             return;
         }
@@ -54,6 +161,23 @@ namespace FpsCounter {
             s_frameTimes.pop_front();
         }
 
+        s_history[s_historyPos] = deltaMs;
+        s_historyPos = (s_historyPos + 1) % kHistorySize;
+        if (s_historyCount < kHistorySize) s_historyCount++;
+
+        std::chrono::duration<double> sinceStart = now - s_startTime;
+        s_graph.AddFrame(sinceStart.count(), deltaMs);
+        s_sessionSketch.Add(deltaMs);
+
+        if (s_stutterEnabled) {
+            AdoptStutterResult();
+            auto sinceAnalysis = std::chrono::duration_cast<std::chrono::milliseconds>(now - s_lastStutterAnalysis);
+            if (s_historyCount >= kMinStutterFrames && sinceAnalysis.count() >= kStutterAnalysisMs) {
+                QueueStutterAnalysis();
+                s_lastStutterAnalysis = now;
+            }
+        }
+
         float totalTime = 0.0f;
         for (float t : s_frameTimes) {
             totalTime += t;
@@ -92,4 +216,16 @@ namespace FpsCounter {
     float GetDisplayFrameTime() {
         return s_displayFrameTime;
     }
+
+    Spectral::PeriodicStutter GetPeriodicStutter() {
+        return s_stutter;
+    }
+
+    const FrameTimeGraph& GetGraph() {
+        return s_graph;
+    }
+
+    const QuantileSketch& GetSessionSketch() {
+        return s_sessionSketch;
+    }
 }
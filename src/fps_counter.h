@@ -1,6 +1,9 @@
 #pragma once
 
 #include <cstddef>
+#include "spectral.h"
+#include "frame_graph.h"
+#include "quantile_sketch.h"
 
 namespace FpsCounter {
     void Update();
@@ -11,4 +14,19 @@ namespace FpsCounter {
 
     void SetSampleCount(std::size_t n);
     void SetDisplayUpdateMs(long long ms);
+
+    // Periodic stutter detection over the last few thousand frames, analysed
+    // on a worker thread and picked up by Update a few frames later
+    void SetStutterAnalysis(bool enabled);
+    Spectral::PeriodicStutter GetPeriodicStutter();
+
+    // Stops the analysis worker (signal only, never waits)
+    void Shutdown();
+
+    // Decimated frame-time history for the graph (render thread only)
+    void SetGraphLayout(std::size_t columns, float windowSeconds);
+    const FrameTimeGraph& GetGraph();
+
+    // Frame-time distribution of the whole session (render thread only)
+    const QuantileSketch& GetSessionSketch();
 }
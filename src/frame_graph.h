@@ -0,0 +1,122 @@
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+// Frame-time graph data provider (requirements E-004).
+//
+// Keeps a fixed ring of raw per-frame times plus a min/max decimation with
+// one time bucket per pixel column of the graph window. Every frame touches
+// one bucket, so drawing a 200-px graph of the last 10 s reads 200 buckets
+// instead of re-scanning thousands of samples.
+//
+// Header-only and free of platform headers: it is shared by fps_overlay.dll
+// (ImGui) and the lab global hook (custom D3D11 renderer).
+class FrameTimeGraph {
+public:
+    static constexpr size_t kMaxColumns = 512;
+    static constexpr size_t kRawCapacity = 4096;
+
+    struct Column {
+        float minMs;
+        float maxMs;
+    };
+
+    FrameTimeGraph() {
+        Configure(200, 10.0f);
+    }
+
+    // Changes graph width (pixel columns) and time span; clears the columns
+    void Configure(size_t columns, float windowSeconds) {
+        if (columns < 2) columns = 2;
+        if (columns > kMaxColumns) columns = kMaxColumns;
+        if (windowSeconds < 0.5f) windowSeconds = 0.5f;
+        if (windowSeconds > 600.0f) windowSeconds = 600.0f;
+
+        m_columns = columns;
+        m_windowSeconds = windowSeconds;
+        m_bucketSeconds = static_cast<double>(windowSeconds) / static_cast<double>(columns);
+        m_head = -1;
+        for (size_t i = 0; i < kMaxColumns; i++) {
+            m_bucketIds[i] = -1;
+        }
+    }
+
+    size_t Columns() const { return m_columns; }
+    float WindowSeconds() const { return m_windowSeconds; }
+
+    // timeSeconds must be monotonic and not negative (any epoch); frames
+    // with a negative, non-finite or absurdly large time are ignored
+    void AddFrame(double timeSeconds, float frameTimeMs) {
+        double position = timeSeconds / m_bucketSeconds;
+        if (!(position >= 0.0 && position < 4.0e18)) return;
+
+        m_raw[m_rawPos] = frameTimeMs;
+        m_rawPos = (m_rawPos + 1) % kRawCapacity;
+        if (m_rawCount < kRawCapacity) m_rawCount++;
+
+        int64_t id = static_cast<int64_t>(position);
+        size_t slot = static_cast<size_t>(id % static_cast<int64_t>(m_columns));
+        Column& col = m_buckets[slot];
+
+        if (m_bucketIds[slot] != id) {
+            // First frame of a new bucket; stale data in skipped slots is
+            // rejected at read time by the id check
+            m_bucketIds[slot] = id;
+            col.minMs = frameTimeMs;
+            col.maxMs = frameTimeMs;
+        } else {
+            if (frameTimeMs < col.minMs) col.minMs = frameTimeMs;
+            if (frameTimeMs > col.maxMs) col.maxMs = frameTimeMs;
+        }
+        if (id > m_head) m_head = id;
+    }
+
+    // Copies the visible columns, oldest first. Columns with no frames
+    // (before the first frame, or during a hang) get NaN min/max.
+    // Returns the number of columns written (Columns(), or 0 when empty).
+    size_t GetColumns(Column* out, size_t maxCount) const {
+        if (m_head < 0) return 0;
+
+        size_t count = m_columns < maxCount ? m_columns : maxCount;
+        int64_t first = m_head - static_cast<int64_t>(count) + 1;
+        for (size_t i = 0; i < count; i++) {
+            int64_t id = first + static_cast<int64_t>(i);
+            if (id < 0) {
+                out[i].minMs = out[i].maxMs = NAN;
+                continue;
+            }
+            size_t slot = static_cast<size_t>(id % static_cast<int64_t>(m_columns));
+            if (m_bucketIds[slot] == id) {
+                out[i] = m_buckets[slot];
+            } else {
+                out[i].minMs = out[i].maxMs = NAN;
+            }
+        }
+        return count;
+    }
+
+    // Copies up to maxCount of the most recent raw frame times, oldest first
+    size_t GetRecentFrames(float* out, size_t maxCount) const {
+        size_t count = m_rawCount < maxCount ? m_rawCount : maxCount;
+        size_t start = (m_rawPos + kRawCapacity - count) % kRawCapacity;
+        for (size_t i = 0; i < count; i++) {
+            out[i] = m_raw[(start + i) % kRawCapacity];
+        }
+        return count;
+    }
+
+private:
+    size_t m_columns = 0;
+    float m_windowSeconds = 0.0f;
+    double m_bucketSeconds = 0.0;
+
+    float m_raw[kRawCapacity] = {};
+    size_t m_rawPos = 0;
+    size_t m_rawCount = 0;
+
+    Column m_buckets[kMaxColumns] = {};
+    int64_t m_bucketIds[kMaxColumns] = {};
+    int64_t m_head = -1;
+};
@@ -0,0 +1,110 @@
+#include "frame_heatmap.h"
+#include "capture.h"
+#include <cmath>
+#include <cstring>
+
+FrameHeatmap::FrameHeatmap(float sliceSeconds) {
+    Reset(sliceSeconds);
+}
+
+void FrameHeatmap::Reset(float sliceSeconds) {
+    if (!(sliceSeconds >= 0.1f)) sliceSeconds = 0.1f;
+    m_sliceSeconds = sliceSeconds;
+    m_counts.clear();
+    m_rows = 0;
+    m_started = false;
+}
+
+uint32_t FrameHeatmap::BucketOf(float frameTimeMs) {
+    if (!(frameTimeMs > 0.0f)) return 0;
+
+    uint32_t bits;
+    std::memcpy(&bits, &frameTimeMs, sizeof(bits));
+    int32_t exponent = static_cast<int32_t>((bits >> 23) & 0xFF) - 127;
+    uint32_t sub = (bits >> 20) & (kBucketsPerOctave - 1);
+
+    if (exponent < kMinExponent) return 0;
+    if (exponent >= kMinExponent + static_cast<int32_t>(kOctaves)) return kBuckets - 1;
+    return static_cast<uint32_t>(exponent - kMinExponent) * kBucketsPerOctave + sub;
+}
+
+float FrameHeatmap::BucketLowerMs(uint32_t bucket) {
+    int32_t exponent = kMinExponent + static_cast<int32_t>(bucket / kBucketsPerOctave);
+    float sub = static_cast<float>(bucket % kBucketsPerOctave) / kBucketsPerOctave;
+    return std::ldexp(1.0f + sub, exponent);
+}
+
+void FrameHeatmap::AddFrame(double timeSeconds, float frameTimeMs) {
+    if (!m_started) {
+        m_origin = timeSeconds;
+        m_started = true;
+    }
+
+    double elapsed = timeSeconds - m_origin;
+    size_t row = elapsed > 0.0 ? static_cast<size_t>(elapsed / m_sliceSeconds) : 0;
+    while (row >= kMaxRows) {
+        Coarsen();
+        row = static_cast<size_t>(elapsed / m_sliceSeconds);
+    }
+
+    if (row >= m_rows) {
+        m_rows = row + 1;
+        m_counts.resize(m_rows * kBuckets, 0);
+    }
+    m_counts[row * kBuckets + BucketOf(frameTimeMs)]++;
+}
+
+void FrameHeatmap::Coarsen() {
+    // Merge rows (2i, 2i+1) into row i
+    size_t merged = (m_rows + 1) / 2;
+    for (size_t i = 0; i < merged; i++) {
+        uint32_t* dst = &m_counts[i * kBuckets];
+        const uint32_t* a = &m_counts[(2 * i) * kBuckets];
+        if (2 * i + 1 < m_rows) {
+            const uint32_t* b = &m_counts[(2 * i + 1) * kBuckets];
+            for (uint32_t k = 0; k < kBuckets; k++) dst[k] = a[k] + b[k];
+        } else if (dst != a) {
+            std::memcpy(dst, a, kBuckets * sizeof(uint32_t));
+        }
+    }
+    m_rows = merged;
+    m_counts.resize(m_rows * kBuckets);
+    m_sliceSeconds *= 2.0f;
+}
+
+void FrameHeatmap::Serialize(std::vector<unsigned char>& out) const {
+    Capture::HeatmapHeader header = {};
+    header.sliceSeconds = m_sliceSeconds;
+    header.rows = static_cast<uint32_t>(m_rows);
+    header.buckets = kBuckets;
+    header.bucketsPerOctave = kBucketsPerOctave;
+    header.minExponent = kMinExponent;
+
+    size_t countBytes = m_counts.size() * sizeof(uint32_t);
+    out.resize(sizeof(header) + countBytes);
+    std::memcpy(out.data(), &header, sizeof(header));
+    if (countBytes) std::memcpy(out.data() + sizeof(header), m_counts.data(), countBytes);
+}
+
+bool FrameHeatmap::Deserialize(const void* data, size_t size) {
+    if (size < sizeof(Capture::HeatmapHeader)) return false;
+
+    Capture::HeatmapHeader header;
+    std::memcpy(&header, data, sizeof(header));
+    if (header.buckets != kBuckets || header.bucketsPerOctave != kBucketsPerOctave ||
+        header.minExponent != kMinExponent || !(header.sliceSeconds > 0.0f)) {
+        return false;
+    }
+
+    size_t countBytes = static_cast<size_t>(header.rows) * kBuckets * sizeof(uint32_t);
+    if (size - sizeof(header) < countBytes) return false;
+
+    m_sliceSeconds = header.sliceSeconds;
+    m_rows = header.rows;
+    m_counts.resize(m_rows * kBuckets);
+    if (countBytes) {
+        std::memcpy(m_counts.data(), static_cast<const unsigned char*>(data) + sizeof(header), countBytes);
+    }
+    m_started = false;
+    return true;
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Session heatmap of time x frame time.
+//
+// Rows are fixed wall-clock slices (10 s by default), columns are log-spaced
+// frame-time buckets: 8 per octave from 0.25 ms to 2048 ms, taken straight
+// from the float exponent and top mantissa bits so binning a frame is a few
+// integer ops. Memory grows by one row per slice; past kMaxRows the slices are
+// merged pairwise (and the slice length doubled) so a runaway session stays
+// bounded.
+//
+// Portable (no Windows headers): written by fps_overlay.dll into the capture
+// file and read back by frame_analyzer.
+class FrameHeatmap {
+public:
+    static constexpr uint32_t kBucketsPerOctave = 8;
+    static constexpr int32_t kMinExponent = -2;     // First bucket starts at 2^-2 ms
+    static constexpr uint32_t kOctaves = 13;        // ... last one ends at 2^11 ms
+    static constexpr uint32_t kBuckets = kBucketsPerOctave * kOctaves;
+    static constexpr size_t kMaxRows = 4096;
+
+    explicit FrameHeatmap(float sliceSeconds = 10.0f);
+
+    // Clears all rows and restarts the time origin at the next frame
+    void Reset(float sliceSeconds);
+
+    // timeSeconds must be monotonic (any epoch)
+    void AddFrame(double timeSeconds, float frameTimeMs);
+
+    float SliceSeconds() const { return m_sliceSeconds; }
+    size_t Rows() const { return m_rows; }
+    const uint32_t* Row(size_t row) const { return &m_counts[row * kBuckets]; }
+
+    static uint32_t BucketOf(float frameTimeMs);
+    static float BucketLowerMs(uint32_t bucket);
+
+    // Capture chunk payload (Capture::HeatmapHeader + counts)
+    void Serialize(std::vector<unsigned char>& out) const;
+    bool Deserialize(const void* data, size_t size);
+
+private:
+    void Coarsen();
+
+    std::vector<uint32_t> m_counts;     // m_rows * kBuckets, row-major
+    size_t m_rows = 0;
+    float m_sliceSeconds = 10.0f;
+    double m_origin = 0.0;
+    bool m_started = false;
+};
@@ -2,9 +2,18 @@
 #include "fps_counter.h"
 #include "overlay.h"
 #include "logger.h"
+#include "capture.h"
+#include "frame_heatmap.h"
+#include "overlay_config.h"
+#include "vtable_hook.h"
+#include "entry_point_cache.h"
 #include <dxgi.h>
 #include <d3d11.h>
 #include <MinHook.h>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <vector>
 
 #pragma comment(lib, "d3d11.lib")
 #pragma comment(lib, "dxgi.lib")
@@ -24,6 +33,23 @@ namespace Hooks {
 
     bool g_initialized = false;
 
+    // HookMode=Vtable: swap chain vtable slots instead of MinHook detours
+    static VtableSlotHook s_presentSlot;
+    static VtableSlotHook s_resizeBuffersSlot;
+
+    static Capture::Writer s_capture;
+    static bool s_captureFailed = false;
+    static FrameHeatmap s_heatmap;
+    static LARGE_INTEGER s_heatmapLastQpc = {};
+    static double s_qpcToSeconds = 0.0;
+
+    // Session sketch: rewritten periodically so a crash loses at most one interval
+    static constexpr ULONGLONG kSketchWriteIntervalMs = 5 * 60 * 1000;
+    static SYSTEMTIME s_sessionStartLocal = {};
+    static time_t s_sessionStartUnix = 0;
+    static ULONGLONG s_sessionStartTick = 0;
+    static ULONGLONG s_lastSketchWriteTick = 0;
+
     void CreateRenderTarget() {
         ID3D11Texture2D* pBackBuffer = nullptr;
         g_pSwapChain->GetBuffer(0, IID_PPV_ARGS(&pBackBuffer));
@@ -40,7 +66,126 @@ namespace Hooks {
         }
     }
 
+    // <dll dir>\<subdir>\<exe>_<YYYYMMDD_HHMMSS><ext>; also returns the exe name
+    static bool MakeOutputPath(const char* subdir, const SYSTEMTIME& st, const char* ext,
+                               char* path, size_t pathSize, char* exeNameOut, size_t exeNameSize) {
+        char exePath[MAX_PATH] = {0};
+        GetModuleFileNameA(nullptr, exePath, MAX_PATH);
+        const char* exeName = strrchr(exePath, '\\');
+        exeName = exeName ? exeName + 1 : exePath;
+
+        char dir[MAX_PATH] = {0};
+        DWORD len = GetModuleFileNameA(g_hModule, dir, MAX_PATH);
+        if (len == 0 || len >= MAX_PATH) return false;
+        char* lastSlash = strrchr(dir, '\\');
+        if (!lastSlash) return false;
+        *(lastSlash + 1) = '\0';
+        strcat_s(dir, subdir);
+        CreateDirectoryA(dir, nullptr);
+
+        sprintf_s(path, pathSize, "%s\\%s_%04u%02u%02u_%02u%02u%02u%s", dir, exeName,
+                  st.wYear, st.wMonth, st.wDay, st.wHour, st.wMinute, st.wSecond, ext);
+        strncpy_s(exeNameOut, exeNameSize, exeName, _TRUNCATE);
+        return true;
+    }
+
+    // Identifies the game build without needing version resources
+    static void GetSessionInfo(Capture::SessionInfo& info) {
+        memset(&info, 0, sizeof(info));
+
+        const BYTE* base = reinterpret_cast<const BYTE*>(GetModuleHandleW(nullptr));
+        const IMAGE_DOS_HEADER* dos = reinterpret_cast<const IMAGE_DOS_HEADER*>(base);
+        if (base && dos->e_magic == IMAGE_DOS_SIGNATURE) {
+            const IMAGE_NT_HEADERS* nt = reinterpret_cast<const IMAGE_NT_HEADERS*>(base + dos->e_lfanew);
+            if (nt->Signature == IMAGE_NT_SIGNATURE) {
+                sprintf_s(info.build, "%08X-%08X", nt->FileHeader.TimeDateStamp, nt->OptionalHeader.SizeOfImage);
+            }
+        }
+        info.startUnixTime = static_cast<uint64_t>(s_sessionStartUnix);
+    }
+
+    static void WriteSessionSketch() {
+        const QuantileSketch& sketch = FpsCounter::GetSessionSketch();
+        if (sketch.Count() == 0) return;
+
+        char path[MAX_PATH];
+        char exeName[64];
+        if (!MakeOutputPath("sketches", s_sessionStartLocal, ".fpsq", path, sizeof(path), exeName, sizeof(exeName))) return;
+
+        LARGE_INTEGER frequency;
+        QueryPerformanceFrequency(&frequency);
+
+        Capture::FileHeader header = {};
+        header.qpcFrequency = static_cast<uint64_t>(frequency.QuadPart);
+        header.pid = GetCurrentProcessId();
+        strncpy_s(header.exeName, exeName, _TRUNCATE);
+
+        Capture::SessionInfo info;
+        GetSessionInfo(info);
+        info.durationSeconds = (GetTickCount64() - s_sessionStartTick) / 1000.0;
+
+        std::vector<unsigned char> payload;
+        sketch.Serialize(payload);
+
+        // Same path for the whole session: each write replaces the previous snapshot
+        Capture::Writer writer;
+        if (!writer.Open(path, header)) return;
+        writer.WriteChunk(Capture::kChunkSession, &info, sizeof(info));
+        writer.WriteChunk(Capture::kChunkSketch, payload.data(), payload.size());
+        writer.Close();
+    }
+
+    static void BeginCapture() {
+        SYSTEMTIME st;
+        GetLocalTime(&st);
+        char path[MAX_PATH];
+        char exeName[64];
+        if (!MakeOutputPath("captures", st, ".fpsc", path, sizeof(path), exeName, sizeof(exeName))) {
+            s_captureFailed = true;
+            return;
+        }
+
+        LARGE_INTEGER frequency;
+        LARGE_INTEGER now;
+        QueryPerformanceFrequency(&frequency);
+        QueryPerformanceCounter(&now);
+
+        Capture::FileHeader header = {};
+        header.qpcFrequency = static_cast<uint64_t>(frequency.QuadPart);
+        header.startQpc = static_cast<uint64_t>(now.QuadPart);
+        header.pid = GetCurrentProcessId();
+        strncpy_s(header.exeName, exeName, _TRUNCATE);
+
+        if (s_capture.Open(path, header)) {
+            Capture::SessionInfo info;
+            GetSessionInfo(info);
+            s_capture.WriteChunk(Capture::kChunkSession, &info, sizeof(info));
+
+            s_heatmap.Reset(10.0f);
+            s_heatmapLastQpc.QuadPart = 0;
+            s_qpcToSeconds = 1.0 / static_cast<double>(frequency.QuadPart);
+            LOG("Capture started: %s", path);
+        } else {
+            LOG_ERROR("Failed to open capture file: %s", path);
+            s_captureFailed = true;
+        }
+    }
+
+    static void EndCapture() {
+        if (!s_capture.IsOpen()) return;
+
+        std::vector<unsigned char> heatmap;
+        s_heatmap.Serialize(heatmap);
+        s_capture.WriteChunk(Capture::kChunkHeatmap, heatmap.data(), heatmap.size());
+
+        s_capture.Close();
+        LOG("Capture stopped");
+    }
+
     HRESULT __stdcall hkPresent(IDXGISwapChain* pSwapChain, UINT SyncInterval, UINT Flags) {
+        LARGE_INTEGER presentStart;
+        QueryPerformanceCounter(&presentStart);
+
         if (!g_initialized) {
             if (SUCCEEDED(pSwapChain->GetDevice(IID_PPV_ARGS(&g_pDevice)))) {
                 g_pDevice->GetImmediateContext(&g_pContext);
@@ -52,6 +197,11 @@ namespace Hooks {
                 Overlay::Initialize(desc.OutputWindow, g_pDevice, g_pContext);
                 CreateRenderTarget();
                 g_initialized = true;
+
+                GetLocalTime(&s_sessionStartLocal);
+                s_sessionStartUnix = time(nullptr);
+                s_sessionStartTick = GetTickCount64();
+                s_lastSketchWriteTick = s_sessionStartTick;
             }
         }
 
@@ -60,9 +210,50 @@ namespace Hooks {
             
             g_pContext->OMSetRenderTargets(1, &g_pRenderTargetView, nullptr);
             Overlay::Render();
+
+            ULONGLONG tick = GetTickCount64();
+            if (tick - s_lastSketchWriteTick >= kSketchWriteIntervalMs) {
+                if (Overlay::IsSessionSketchEnabled()) WriteSessionSketch();
+                s_lastSketchWriteTick = tick;
+            }
+        }
+
+        bool capturing = g_initialized && Overlay::IsCaptureEnabled();
+        if (!capturing) {
+            EndCapture();
+            s_captureFailed = false;
+        } else if (!s_capture.IsOpen() && !s_captureFailed) {
+            BeginCapture();
         }
 
-        return oPresent(pSwapChain, SyncInterval, Flags);
+        if (!s_capture.IsOpen()) {
+            return oPresent(pSwapChain, SyncInterval, Flags);
+        }
+
+        LARGE_INTEGER overlayEnd;
+        QueryPerformanceCounter(&overlayEnd);
+        HRESULT hr = oPresent(pSwapChain, SyncInterval, Flags);
+        LARGE_INTEGER presentEnd;
+        QueryPerformanceCounter(&presentEnd);
+
+        Capture::FrameRecord frame = {};
+        frame.presentQpc = static_cast<uint64_t>(presentStart.QuadPart);
+        frame.overlayTicks = static_cast<uint32_t>(overlayEnd.QuadPart - presentStart.QuadPart);
+        frame.presentTicks = static_cast<uint32_t>(presentEnd.QuadPart - overlayEnd.QuadPart);
+        frame.swapChainId = static_cast<uint32_t>(reinterpret_cast<uintptr_t>(pSwapChain) >> 4);
+        frame.flags = SyncInterval > 0 ? Capture::kFrameVsync : 0;
+        s_capture.Append(frame);
+
+        // Heatmap follows the swapchain the overlay is drawn on
+        if (pSwapChain == g_pSwapChain) {
+            if (s_heatmapLastQpc.QuadPart != 0) {
+                double frameMs = (presentStart.QuadPart - s_heatmapLastQpc.QuadPart) * s_qpcToSeconds * 1000.0;
+                s_heatmap.AddFrame(presentStart.QuadPart * s_qpcToSeconds, static_cast<float>(frameMs));
+            }
+            s_heatmapLastQpc = presentStart;
+        }
+
+        return hr;
     }
 
     HRESULT __stdcall hkResizeBuffers(IDXGISwapChain* pSwapChain, UINT BufferCount, 
@@ -78,10 +269,6 @@ namespace Hooks {
         return hr;
     }
 
-    void* GetVTableFunction(void* pInterface, UINT index) {
-        return (*static_cast<void***>(pInterface))[index];
-    }
-
     bool CreateDummySwapChain(IDXGISwapChain** ppSwapChain) {
         WNDCLASSEX wc = { sizeof(WNDCLASSEX), CS_CLASSDC, DefWindowProc, 0, 0, 
                           GetModuleHandle(nullptr), nullptr, nullptr, nullptr, 
@@ -118,22 +305,91 @@ namespace Hooks {
         return SUCCEEDED(hr);
     }
 
+    // <dll dir>\entry_points.bin
+    static bool GetEntryPointCachePath(char* path, size_t pathSize) {
+        DWORD len = GetModuleFileNameA(g_hModule, path, static_cast<DWORD>(pathSize));
+        if (len == 0 || len >= pathSize) return false;
+        char* lastSlash = strrchr(path, '\\');
+        if (!lastSlash) return false;
+        *(lastSlash + 1) = '\0';
+        return strcat_s(path, pathSize, "entry_points.bin") == 0;
+    }
+
+    // Present and ResizeBuffers slots of the swap chain vtable. Taken from the
+    // entry point cache while dxgi.dll is unchanged since an earlier
+    // injection; otherwise read from a dummy swap chain and recorded.
+    static bool ResolveSwapChainSlots(void*** ppPresentSlot, void*** ppResizeBuffersSlot) {
+        char path[MAX_PATH] = {0};
+        bool havePath = GetEntryPointCachePath(path, sizeof(path));
+        EntryPointCache::Table table;
+        EntryPointCache::Module dxgi;
+        bool identified = havePath && EntryPointCache::IdentifyModule(L"dxgi.dll", &dxgi);
+        if (identified) {
+            table.Load(path);
+            *ppPresentSlot = EntryPointCache::FindSlot(table, dxgi, EntryPointCache::kDxgiPresentSlot);
+            *ppResizeBuffersSlot = EntryPointCache::FindSlot(table, dxgi, EntryPointCache::kDxgiResizeBuffersSlot);
+            if (*ppPresentSlot && *ppResizeBuffersSlot) {
+                LOG("Swap chain slots taken from entry point cache");
+                return true;
+            }
+        }
+
+        IDXGISwapChain* pDummySwapChain = nullptr;
+        if (!CreateDummySwapChain(&pDummySwapChain)) return false;
+        LOG("Dummy swap chain created");
+
+        // The vtable lives in dxgi.dll and outlives the dummy swap chain
+        *ppPresentSlot = VtableSlotHook::SlotOf(pDummySwapChain, 8);         // Present is index 8
+        *ppResizeBuffersSlot = VtableSlotHook::SlotOf(pDummySwapChain, 13);  // ResizeBuffers is index 13
+        pDummySwapChain->Release();
+
+        // Creating the device loads dxgi.dll if it was not loaded before
+        if (havePath && !identified && EntryPointCache::IdentifyModule(L"dxgi.dll", &dxgi)) {
+            table.Load(path);
+            identified = true;
+        }
+        if (identified) {
+            bool changed = EntryPointCache::RememberSlot(table, dxgi, EntryPointCache::kDxgiPresentSlot, *ppPresentSlot);
+            changed |= EntryPointCache::RememberSlot(table, dxgi, EntryPointCache::kDxgiResizeBuffersSlot, *ppResizeBuffersSlot);
+            if (changed && !table.Save(path)) LOG_ERROR("Failed to save entry point cache: %s", path);
+        }
+        return true;
+    }
+
     bool Initialize(HMODULE hModule) {
         g_hModule = hModule;
         Logger::Initialize();
         LOG("Hooks::Initialize started");
 
-        IDXGISwapChain* pDummySwapChain = nullptr;
-        if (!CreateDummySwapChain(&pDummySwapChain)) {
+        void** pPresentSlot = nullptr;
+        void** pResizeBuffersSlot = nullptr;
+        if (!ResolveSwapChainSlots(&pPresentSlot, &pResizeBuffersSlot)) {
             LOG_ERROR("Failed to create dummy swap chain");
             return false;
         }
-        LOG("Dummy swap chain created");
-
-        void* pPresent = GetVTableFunction(pDummySwapChain, 8);       // Present is index 8
-        void* pResizeBuffers = GetVTableFunction(pDummySwapChain, 13); // ResizeBuffers is index 13
 
-        pDummySwapChain->Release();
+        void* pPresent = *pPresentSlot;
+        void* pResizeBuffers = *pResizeBuffersSlot;
+
+        if (Overlay::LoadHookMode() == kHookVtable) {
+            bool installed = s_resizeBuffersSlot.Install(pResizeBuffersSlot, reinterpret_cast<void*>(&hkResizeBuffers),
+                                                         reinterpret_cast<void**>(&oResizeBuffers)) &&
+                             s_presentSlot.Install(pPresentSlot, reinterpret_cast<void*>(&hkPresent),
+                                                   reinterpret_cast<void**>(&oPresent));
+            if (installed) {
+                // The detours live in this module, and another overlay may
+                // chain over them, after which they can never be removed.
+                // Pin now: at DLL_PROCESS_DETACH the unload is already
+                // under way and pinning no longer keeps the code mapped
+                HMODULE pinned = nullptr;
+                GetModuleHandleExW(GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS | GET_MODULE_HANDLE_EX_FLAG_PIN,
+                                   reinterpret_cast<LPCWSTR>(&hkPresent), &pinned);
+                LOG("Vtable hooks installed");
+                return true;
+            }
+            s_resizeBuffersSlot.Uninstall();
+            LOG_ERROR("Vtable hooks failed, falling back to inline hooks");
+        }
 
         if (MH_Initialize() != MH_OK) {
             return false;
@@ -157,13 +413,32 @@ namespace Hooks {
     }
 
     void Shutdown() {
-        MH_DisableHook(MH_ALL_HOOKS);
-        MH_Uninitialize();
+        if (s_presentSlot.IsInstalled() || s_resizeBuffersSlot.IsInstalled()) {
+            // Both slots are tried even if the first one stays hooked
+            bool presentRemoved = s_presentSlot.Uninstall();
+            bool resizeRemoved = s_resizeBuffersSlot.Uninstall();
+            if (!presentRemoved || !resizeRemoved) {
+                // Still reachable through the other overlay's chain; the
+                // module was pinned when the hooks went in
+                LOG_ERROR("Vtable hook chained over by another overlay, left in place");
+            }
+        } else {
+            MH_DisableHook(MH_ALL_HOOKS);
+            MH_Uninitialize();
+        }
+
+        FpsCounter::Shutdown();
+        EndCapture();
+        if (g_initialized && Overlay::IsSessionSketchEnabled()) {
+            WriteSessionSketch();
+        }
 
         Overlay::Shutdown();
         CleanupRenderTarget();
 
         if (g_pContext) g_pContext->Release();
         if (g_pDevice) g_pDevice->Release();
+
+        Logger::Shutdown();
     }
 }
@@ -0,0 +1,368 @@
+#include "ini_file.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#ifdef _WIN32
+#include <Windows.h>
+#endif
+
+namespace {
+    constexpr size_t kMaxFileSize = 16 * 1024 * 1024;
+    constexpr uint32_t kMaxDisplacement = 1u << 16;
+
+    char Lower(char c) {
+        return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+    }
+
+    bool EqualNoCase(const char* a, const char* b) {
+        while (*a && Lower(*a) == Lower(*b)) {
+            a++;
+            b++;
+        }
+        return *a == *b;
+    }
+
+    bool IsSpace(char c) {
+        return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+    }
+
+    uint64_t Mix(uint64_t x) {
+        x ^= x >> 30;
+        x *= 0xBF58476D1CE4E5B9ull;
+        x ^= x >> 27;
+        x *= 0x94D049BB133111EBull;
+        x ^= x >> 31;
+        return x;
+    }
+
+    void AppendUtf8(std::string& out, uint32_t cp) {
+        if (cp < 0x80) {
+            out.push_back(static_cast<char>(cp));
+        } else if (cp < 0x800) {
+            out.push_back(static_cast<char>(0xC0 | (cp >> 6)));
+            out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+        } else if (cp < 0x10000) {
+            out.push_back(static_cast<char>(0xE0 | (cp >> 12)));
+            out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+            out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+        } else {
+            out.push_back(static_cast<char>(0xF0 | (cp >> 18)));
+            out.push_back(static_cast<char>(0x80 | ((cp >> 12) & 0x3F)));
+            out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+            out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+        }
+    }
+
+    void AppendUtf16(std::string& out, const unsigned char* p, size_t size, bool bigEndian) {
+        size_t count = size / 2;
+        for (size_t i = 0; i < count; i++) {
+            auto unit = [&](size_t k) -> uint32_t {
+                return bigEndian ? (p[k * 2] << 8 | p[k * 2 + 1]) : (p[k * 2 + 1] << 8 | p[k * 2]);
+            };
+            uint32_t c = unit(i);
+            if (c >= 0xD800 && c <= 0xDBFF && i + 1 < count) {
+                uint32_t low = unit(i + 1);
+                if (low >= 0xDC00 && low <= 0xDFFF) {
+                    AppendUtf8(out, 0x10000 + ((c - 0xD800) << 10) + (low - 0xDC00));
+                    i++;
+                    continue;
+                }
+            }
+            AppendUtf8(out, (c >= 0xD800 && c <= 0xDFFF) ? 0xFFFD : c);
+        }
+    }
+
+    bool IsValidUtf8(const unsigned char* p, size_t size) {
+        size_t i = 0;
+        while (i < size) {
+            unsigned char c = p[i];
+            if (c < 0x80) {
+                i++;
+                continue;
+            }
+            size_t len = (c & 0xE0) == 0xC0 ? 2 : (c & 0xF0) == 0xE0 ? 3 : (c & 0xF8) == 0xF0 ? 4 : 0;
+            if (len == 0 || c == 0xC0 || c == 0xC1 || c > 0xF4 || i + len > size) return false;
+            for (size_t k = 1; k < len; k++) {
+                if ((p[i + k] & 0xC0) != 0x80) return false;
+            }
+            i += len;
+        }
+        return true;
+    }
+
+    // Legacy files written by WritePrivateProfileStringA are in the ANSI code page
+    void AppendAnsi(std::string& out, const unsigned char* p, size_t size) {
+#ifdef _WIN32
+        int wideLen = MultiByteToWideChar(CP_ACP, 0, reinterpret_cast<const char*>(p), static_cast<int>(size), nullptr, 0);
+        if (wideLen > 0) {
+            std::vector<wchar_t> wide(static_cast<size_t>(wideLen));
+            MultiByteToWideChar(CP_ACP, 0, reinterpret_cast<const char*>(p), static_cast<int>(size), wide.data(), wideLen);
+            AppendUtf16(out, reinterpret_cast<const unsigned char*>(wide.data()), wide.size() * 2, false);
+            return;
+        }
+#endif
+        for (size_t i = 0; i < size; i++) AppendUtf8(out, p[i]);   // Latin-1
+    }
+
+    bool ReadAll(std::FILE* f, std::vector<unsigned char>& out) {
+        unsigned char buf[16 * 1024];
+        size_t n;
+        while ((n = std::fread(buf, 1, sizeof(buf), f)) > 0) {
+            if (out.size() + n > kMaxFileSize) return false;
+            out.insert(out.end(), buf, buf + n);
+        }
+        return !std::ferror(f);
+    }
+}
+
+bool IniFile::LoadFile(const char* path) {
+    std::FILE* f = std::fopen(path, "rb");
+    if (!f) return false;
+    std::vector<unsigned char> data;
+    bool ok = ReadAll(f, data);
+    std::fclose(f);
+    if (ok) Parse(data.data(), data.size());
+    return ok;
+}
+
+#ifdef _WIN32
+bool IniFile::LoadFile(const wchar_t* path) {
+    std::FILE* f = _wfopen(path, L"rb");
+    if (!f) return false;
+    std::vector<unsigned char> data;
+    bool ok = ReadAll(f, data);
+    std::fclose(f);
+    if (ok) Parse(data.data(), data.size());
+    return ok;
+}
+#endif
+
+void IniFile::Parse(const void* data, size_t size) {
+    const unsigned char* p = static_cast<const unsigned char*>(data);
+    if (size > kMaxFileSize) size = kMaxFileSize;
+
+    // Offset 0 is an empty string: the section of keys before any [header]
+    m_text.assign(1, '\0');
+    m_text.reserve(size + 2);
+    if (size >= 3 && p[0] == 0xEF && p[1] == 0xBB && p[2] == 0xBF) {
+        m_text.append(reinterpret_cast<const char*>(p + 3), size - 3);
+    } else if (size >= 2 && p[0] == 0xFF && p[1] == 0xFE) {
+        AppendUtf16(m_text, p + 2, size - 2, false);
+    } else if (size >= 2 && p[0] == 0xFE && p[1] == 0xFF) {
+        AppendUtf16(m_text, p + 2, size - 2, true);
+    } else if (IsValidUtf8(p, size)) {
+        m_text.append(reinterpret_cast<const char*>(p), size);
+    } else {
+        AppendAnsi(m_text, p, size);
+    }
+    m_text.push_back('\n');
+
+    Split();
+    BuildIndex();
+}
+
+// Splits m_text into NUL-terminated names and values in place
+void IniFile::Split() {
+    m_entries.clear();
+    char* text = &m_text[0];
+    size_t size = m_text.size();
+    uint32_t section = 0;
+
+    size_t lineStart = 1;
+    while (lineStart < size) {
+        size_t lineEnd = lineStart;
+        while (lineEnd < size && text[lineEnd] != '\n' && text[lineEnd] != '\0') lineEnd++;
+        text[lineEnd] = '\0';
+        size_t next = lineEnd + 1;
+
+        size_t b = lineStart;
+        size_t e = lineEnd;
+        while (b < e && IsSpace(text[b])) b++;
+        while (e > b && IsSpace(text[e - 1])) e--;
+        lineStart = next;
+        // Only ';' starts a comment: GetPrivateProfileString reads "#key=value" as key "#key"
+        if (b == e || text[b] == ';') continue;
+
+        if (text[b] == '[') {
+            size_t close = b + 1;
+            while (close < e && text[close] != ']') close++;
+            size_t nb = b + 1;
+            size_t ne = close;
+            while (nb < ne && IsSpace(text[nb])) nb++;
+            while (ne > nb && IsSpace(text[ne - 1])) ne--;
+            text[ne] = '\0';
+            section = static_cast<uint32_t>(nb);
+            continue;
+        }
+
+        size_t eq = b;
+        while (eq < e && text[eq] != '=') eq++;
+        if (eq == e) continue;
+
+        size_t ke = eq;
+        while (ke > b && IsSpace(text[ke - 1])) ke--;
+        if (ke == b) continue;
+
+        size_t vb = eq + 1;
+        size_t ve = e;
+        while (vb < ve && IsSpace(text[vb])) vb++;
+        if (ve - vb >= 2 && (text[vb] == '"' || text[vb] == '\'') && text[ve - 1] == text[vb]) {
+            vb++;
+            ve--;
+        }
+        text[ke] = '\0';
+        text[ve] = '\0';
+        m_entries.push_back(Entry{ section, static_cast<uint32_t>(b), static_cast<uint32_t>(vb), 0 });
+    }
+}
+
+uint64_t IniFile::Hash(const char* section, const char* key) const {
+    uint64_t h = m_basis;
+    for (const char* s = section; *s; s++) h = (h ^ static_cast<unsigned char>(Lower(*s))) * 0x100000001B3ull;
+    h = (h ^ 0xFF) * 0x100000001B3ull;
+    for (const char* s = key; *s; s++) h = (h ^ static_cast<unsigned char>(Lower(*s))) * 0x100000001B3ull;
+    return Mix(h);
+}
+
+size_t IniFile::Slot(uint64_t hash) const {
+    uint32_t d = m_displace[static_cast<size_t>(hash >> 32) % m_displace.size()];
+    return static_cast<size_t>(Mix(hash + d * 0x9E3779B97F4A7C15ull)) & (m_slots.size() - 1);
+}
+
+// Hash-and-displace: keys are grouped into buckets of ~4, and each bucket
+// (largest first) gets the smallest displacement that lands all its keys on
+// free slots. Lookups then never probe.
+void IniFile::BuildIndex() {
+    m_slots.clear();
+    m_displace.clear();
+    if (m_entries.empty()) return;
+
+    size_t tableSize = 4;
+    while (tableSize < m_entries.size() * 2) tableSize *= 2;
+
+    for (uint32_t attempt = 0;; attempt++) {
+        m_basis = 0xCBF29CE484222325ull ^ Mix(attempt + 1ull);
+        if (attempt > 0 && attempt % 4 == 0) tableSize *= 2;
+
+        // Hash, then drop later duplicates (first occurrence wins)
+        std::vector<Entry> unique;
+        unique.reserve(m_entries.size());
+        std::vector<uint32_t> order(m_entries.size());
+        for (size_t i = 0; i < m_entries.size(); i++) {
+            Entry& e = m_entries[i];
+            e.hash = Hash(&m_text[e.section], &m_text[e.key]);
+            order[i] = static_cast<uint32_t>(i);
+        }
+        std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+            return m_entries[a].hash < m_entries[b].hash;
+        });
+        bool hashCollision = false;
+        std::vector<bool> keep(m_entries.size(), true);
+        for (size_t i = 1; i < order.size(); i++) {
+            const Entry& a = m_entries[order[i - 1]];
+            const Entry& b = m_entries[order[i]];
+            if (a.hash != b.hash) continue;
+            if (EqualNoCase(&m_text[a.section], &m_text[b.section]) && EqualNoCase(&m_text[a.key], &m_text[b.key])) {
+                keep[order[i]] = false;
+                order[i] = order[i - 1];    // Later runs compare against the survivor
+            } else {
+                hashCollision = true;       // Distinct keys, same 64-bit hash: reseed
+            }
+        }
+        if (hashCollision) continue;
+        for (size_t i = 0; i < m_entries.size(); i++) {
+            if (keep[i]) unique.push_back(m_entries[i]);
+        }
+
+        size_t bucketCount = unique.size() / 4 + 1;
+        std::vector<std::vector<uint32_t>> buckets(bucketCount);
+        for (size_t i = 0; i < unique.size(); i++) {
+            buckets[static_cast<size_t>(unique[i].hash >> 32) % bucketCount].push_back(static_cast<uint32_t>(i));
+        }
+        std::vector<uint32_t> bucketOrder(bucketCount);
+        for (size_t i = 0; i < bucketCount; i++) bucketOrder[i] = static_cast<uint32_t>(i);
+        std::stable_sort(bucketOrder.begin(), bucketOrder.end(), [&](uint32_t a, uint32_t b) {
+            return buckets[a].size() > buckets[b].size();
+        });
+
+        m_slots.assign(tableSize, 0);
+        m_displace.assign(bucketCount, 0);
+        std::vector<size_t> placed;
+        bool ok = true;
+        for (uint32_t b : bucketOrder) {
+            const std::vector<uint32_t>& members = buckets[b];
+            if (members.empty()) break;
+
+            bool found = false;
+            for (uint32_t d = 0; d < kMaxDisplacement && !found; d++) {
+                m_displace[b] = d;
+                placed.clear();
+                found = true;
+                for (uint32_t index : members) {
+                    size_t slot = Slot(unique[index].hash);
+                    if (m_slots[slot] || std::find(placed.begin(), placed.end(), slot) != placed.end()) {
+                        found = false;
+                        break;
+                    }
+                    placed.push_back(slot);
+                }
+            }
+            if (!found) {
+                ok = false;
+                break;
+            }
+            for (size_t k = 0; k < members.size(); k++) {
+                m_slots[placed[k]] = members[k] + 1;
+            }
+        }
+        if (!ok) continue;
+
+        m_entries.swap(unique);
+        return;
+    }
+}
+
+const char* IniFile::Get(const char* section, const char* key) const {
+    if (m_entries.empty() || !section || !key) return nullptr;
+    uint64_t hash = Hash(section, key);
+    uint32_t index = m_slots[Slot(hash)];
+    if (!index) return nullptr;
+
+    const Entry& e = m_entries[index - 1];
+    if (e.hash != hash || !EqualNoCase(&m_text[e.section], section) || !EqualNoCase(&m_text[e.key], key)) return nullptr;
+    return &m_text[e.value];
+}
+
+const char* IniFile::GetString(const char* section, const char* key, const char* def) const {
+    const char* value = Get(section, key);
+    return value ? value : def;
+}
+
+int IniFile::GetInt(const char* section, const char* key, int def) const {
+    const char* value = Get(section, key);
+    if (!value) return def;
+
+    bool hex = value[0] == '0' && (value[1] == 'x' || value[1] == 'X');
+    long v = std::strtol(hex ? value + 2 : value, nullptr, hex ? 16 : 10);
+    return static_cast<int>(v);
+}
+
+float IniFile::GetFloat(const char* section, const char* key, float def) const {
+    const char* value = Get(section, key);
+    if (!value) return def;
+
+    char* end = nullptr;
+    float v = std::strtof(value, &end);
+    return end == value ? def : v;
+}
+
+bool IniFile::GetBool(const char* section, const char* key, bool def) const {
+    const char* value = Get(section, key);
+    if (!value) return def;
+
+    if (EqualNoCase(value, "true") || EqualNoCase(value, "yes") || EqualNoCase(value, "on") || EqualNoCase(value, "1")) return true;
+    if (EqualNoCase(value, "false") || EqualNoCase(value, "no") || EqualNoCase(value, "off") || EqualNoCase(value, "0")) return false;
+    return def;
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Read-only INI file, parsed in one pass.
+//
+// The whole file is read once, converted to UTF-8 (UTF-8 BOM, UTF-16 LE/BE
+// BOM, or BOM-less UTF-8; anything else is taken as ANSI/Latin-1) and split in
+// place, so every section, key and value is a NUL-terminated string inside
+// one arena. Lookups go through a minimal-probe perfect hash built after
+// parsing: one hash, one displacement read, one slot, one compare.
+//
+// Semantics follow GetPrivateProfileString: section and key names are
+// case-insensitive (ASCII), surrounding whitespace is trimmed, a value
+// wrapped in matching quotes loses them, lines starting with ';' are comments
+// ('#' is not special), and the first occurrence of a duplicate key wins.
+//
+// Portable (no Windows headers): used by fps_overlay.dll and the lab monitor,
+// and built on Linux for fuzzing.
+class IniFile {
+public:
+    bool LoadFile(const char* path);
+#ifdef _WIN32
+    bool LoadFile(const wchar_t* path);
+#endif
+    // Replaces any previous content
+    void Parse(const void* data, size_t size);
+
+    // nullptr if the key does not exist
+    const char* Get(const char* section, const char* key) const;
+
+    const char* GetString(const char* section, const char* key, const char* def) const;
+    // Decimal (or 0x hex); a present but non-numeric value reads as 0 like GetPrivateProfileInt
+    int GetInt(const char* section, const char* key, int def) const;
+    // def if missing or not a number
+    float GetFloat(const char* section, const char* key, float def) const;
+    // true/yes/on/1 and false/no/off/0; def otherwise
+    bool GetBool(const char* section, const char* key, bool def) const;
+
+    size_t Size() const { return m_entries.size(); }
+
+private:
+    struct Entry {
+        uint32_t section;   // Offsets into m_text
+        uint32_t key;
+        uint32_t value;
+        uint64_t hash;
+    };
+
+    void Split();
+    void BuildIndex();
+    uint64_t Hash(const char* section, const char* key) const;
+    size_t Slot(uint64_t hash) const;
+
+    std::string m_text;                 // UTF-8 arena, NUL-separated
+    std::vector<Entry> m_entries;
+    std::vector<uint32_t> m_slots;      // Entry index + 1, 0 = empty
+    std::vector<uint32_t> m_displace;   // Per first-level bucket
+    uint64_t m_basis = 0;               // FNV basis, reseeded if the index cannot be built
+};
@@ -0,0 +1,60 @@
+#include "game_matcher.h"
+#include "process_enum.h"
+
+namespace {
+    inline unsigned char Fold(unsigned char c) {
+        return (c >= 'A' && c <= 'Z') ? static_cast<unsigned char>(c + ('a' - 'A')) : c;
+    }
+
+    uint64_t FoldedHash(std::string_view text) {
+        uint64_t h = 14695981039346656037ull;
+        for (unsigned char c : text) h = (h ^ Fold(c)) * 1099511628211ull;
+        return h ^ (h >> 29);
+    }
+
+    bool FoldedEquals(std::string_view folded, std::string_view text) {
+        if (folded.size() != text.size()) return false;
+        for (size_t i = 0; i < text.size(); i++) {
+            if (static_cast<unsigned char>(folded[i]) != Fold(static_cast<unsigned char>(text[i]))) return false;
+        }
+        return true;
+    }
+}
+
+void GameMatcher::Build(const std::vector<std::string>& games) {
+    m_games.assign(games.size(), std::string());
+    m_hashes.assign(games.size(), 0);
+    size_t size = 8;
+    while (size < games.size() * 2) size <<= 1;     // Load <= 1/2
+    m_slots.assign(size, -1);
+
+    for (size_t i = 0; i < games.size(); i++) {
+        std::string& folded = m_games[i];
+        for (unsigned char c : games[i]) folded.push_back(static_cast<char>(Fold(c)));
+        if (folded.empty() || Find(folded) >= 0) continue;     // Duplicates match the first entry
+
+        m_hashes[i] = FoldedHash(folded);
+        size_t slot = m_hashes[i] & (size - 1);
+        while (m_slots[slot] >= 0) slot = (slot + 1) & (size - 1);
+        m_slots[slot] = static_cast<int32_t>(i);
+    }
+}
+
+int GameMatcher::Find(std::string_view name) const {
+    if (m_slots.empty()) return -1;
+    uint64_t hash = FoldedHash(name);
+    size_t mask = m_slots.size() - 1;
+    for (size_t slot = hash & mask;; slot = (slot + 1) & mask) {
+        int32_t game = m_slots[slot];
+        if (game < 0) return -1;
+        if (m_hashes[game] == hash && FoldedEquals(m_games[game], name)) return game;
+    }
+}
+
+void GameMatcher::FindAll(const ProcessSnapshot& snapshot, std::vector<Match>& out) const {
+    out.clear();
+    for (size_t i = 0; i < snapshot.Count(); i++) {
+        int game = Find(snapshot.Name(i));
+        if (game >= 0) out.push_back({ snapshot.Pid(i), static_cast<size_t>(game) });
+    }
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+class ProcessSnapshot;
+
+// Configured game exe names in an open-addressing hash set, case-folded
+// (ASCII, like the old _wcsicmp on typical exe names). One probe sequence per
+// process instead of one comparison per configured game.
+class GameMatcher {
+public:
+    struct Match {
+        uint32_t pid;
+        size_t game;        // Index into the list given to Build
+    };
+
+    void Build(const std::vector<std::string>& games);
+    size_t GameCount() const { return m_games.size(); }
+
+    // Index of the game with this exe name, or -1
+    int Find(std::string_view name) const;
+
+    // Every process in the snapshot that is a configured game (all
+    // instances, not only the first)
+    void FindAll(const ProcessSnapshot& snapshot, std::vector<Match>& out) const;
+
+private:
+    std::vector<std::string> m_games;           // Folded, same order as Build input
+    std::vector<int32_t> m_slots;               // Game index or -1; power-of-two size
+    std::vector<uint64_t> m_hashes;             // Per game, to skip most string compares
+};
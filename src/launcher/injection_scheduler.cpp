@@ -0,0 +1,203 @@
+#include "injection_scheduler.h"
+
+InjectionScheduler::InjectionScheduler(Callbacks callbacks, Options options)
+    : m_callbacks(std::move(callbacks)), m_options(options) {
+    if (m_options.tickMs == 0) m_options.tickMs = 1;
+    if (m_options.workers == 0) m_options.workers = 1;
+    uint32_t slots = 1;
+    while (slots < m_options.wheelSlots) slots <<= 1;
+    m_options.wheelSlots = slots;
+    m_wheel.resize(slots);
+    m_start = std::chrono::steady_clock::now();
+}
+
+InjectionScheduler::~InjectionScheduler() {
+    Stop();
+}
+
+void InjectionScheduler::Start() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_running) return;
+    m_running = true;
+    m_timerThread = std::thread(&InjectionScheduler::TimerLoop, this);
+    for (uint32_t i = 0; i < m_options.workers; i++) {
+        m_workers.emplace_back(&InjectionScheduler::WorkerLoop, this);
+    }
+}
+
+void InjectionScheduler::Stop() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_running) return;
+        m_running = false;
+    }
+    m_timerWake.notify_all();
+    m_workReady.notify_all();
+    if (m_timerThread.joinable()) m_timerThread.join();
+    for (std::thread& worker : m_workers) worker.join();
+    m_workers.clear();
+    m_work.clear();
+}
+
+uint64_t InjectionScheduler::NowTick() const {
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - m_start);
+    return static_cast<uint64_t>(elapsed.count()) / m_options.tickMs;
+}
+
+void InjectionScheduler::Schedule(const Record& record, uint32_t delayMs) {
+    uint64_t now = NowTick();
+    // An idle timer thread stopped advancing: restart the wheel at now
+    if (m_pendingTimers == 0) m_processedTick = now;
+    uint64_t ticks = (delayMs + m_options.tickMs - 1) / m_options.tickMs;
+    uint64_t deadline = (now > m_processedTick ? now : m_processedTick) + (ticks ? ticks : 1);
+    m_wheel[deadline & (m_options.wheelSlots - 1)].push_back({ record.process.pid, record.generation, deadline });
+    if (m_pendingTimers++ == 0) m_timerWake.notify_one();
+}
+
+void InjectionScheduler::Fire(const Timer& timer) {
+    auto it = m_records.find(timer.pid);
+    if (it == m_records.end() || it->second.generation != timer.generation) return;     // Exited meanwhile
+
+    Record& record = it->second;
+    switch (record.state) {
+    case State::Settling:
+    case State::Backoff:
+        record.state = State::Injecting;
+        m_work.push_back({ timer.pid, timer.generation, Job::Inject });
+        m_workReady.notify_one();
+        break;
+    case State::Verifying:
+        m_work.push_back({ timer.pid, timer.generation, Job::Verify });
+        m_workReady.notify_one();
+        break;
+    default:
+        break;
+    }
+}
+
+void InjectionScheduler::Fail(Record& record) {
+    record.attempts++;
+    if (record.attempts >= m_options.maxAttempts) {
+        record.state = State::Failed;
+        return;
+    }
+    record.state = State::Backoff;
+    uint32_t shift = record.attempts - 1 < 16 ? record.attempts - 1 : 16;
+    Schedule(record, m_options.retryBaseMs << shift);
+}
+
+void InjectionScheduler::TimerLoop() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (m_running) {
+        if (m_pendingTimers == 0) {
+            m_timerWake.wait(lock, [this] { return !m_running || m_pendingTimers > 0; });
+            continue;
+        }
+
+        auto next = m_start + std::chrono::milliseconds((m_processedTick + 1) * m_options.tickMs);
+        m_timerWake.wait_until(lock, next, [this] { return !m_running; });
+        if (!m_running) break;
+
+        uint64_t now = NowTick();
+        while (m_processedTick < now && m_pendingTimers > 0) {
+            m_processedTick++;
+            std::vector<Timer>& slot = m_wheel[m_processedTick & (m_options.wheelSlots - 1)];
+            size_t keep = 0;
+            for (size_t i = 0; i < slot.size(); i++) {
+                if (slot[i].deadline > m_processedTick) {
+                    slot[keep++] = slot[i];         // A later lap of the wheel
+                    continue;
+                }
+                m_pendingTimers--;
+                Fire(slot[i]);
+            }
+            slot.resize(keep);
+        }
+    }
+}
+
+void InjectionScheduler::WorkerLoop() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    for (;;) {
+        m_workReady.wait(lock, [this] { return !m_running || !m_work.empty(); });
+        if (!m_running) return;
+        Work work = m_work.front();
+        m_work.pop_front();
+
+        auto it = m_records.find(work.pid);
+        if (it == m_records.end() || it->second.generation != work.generation) continue;
+        Candidate process = it->second.process;
+
+        // The blocking part runs without the lock
+        lock.unlock();
+        bool ok;
+        if (work.job == Job::Inject) {
+            ok = m_callbacks.inject ? m_callbacks.inject(work.pid) : false;
+        } else {
+            ok = m_callbacks.verify ? m_callbacks.verify(work.pid) : true;
+        }
+        lock.lock();
+
+        it = m_records.find(work.pid);
+        if (it == m_records.end() || it->second.generation != work.generation) continue;
+        Record& record = it->second;
+        if (ok && work.job == Job::Inject) {
+            record.state = State::Verifying;
+            if (m_callbacks.verify) {
+                Schedule(record, m_options.verifyDelayMs);
+                continue;
+            }
+            record.state = State::Injected;
+        } else if (ok) {
+            record.state = State::Injected;
+        } else {
+            Fail(record);
+        }
+
+        State state = record.state;
+        if ((state == State::Injected || state == State::Failed) && m_callbacks.finished) {
+            lock.unlock();
+            m_callbacks.finished(process, state == State::Injected);
+            lock.lock();
+        }
+    }
+}
+
+void InjectionScheduler::Update(const std::vector<Candidate>& running) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_scan++;
+    for (const Candidate& candidate : running) {
+        auto it = m_records.find(candidate.pid);
+        if (it != m_records.end() && it->second.process.name == candidate.name) {
+            it->second.scan = m_scan;
+            continue;
+        }
+        Record& record = m_records[candidate.pid];
+        record = Record();
+        record.process = candidate;
+        record.generation = m_nextGeneration++;
+        record.scan = m_scan;
+        Schedule(record, m_options.settleMs);
+    }
+
+    // Gone from the scan: drop now; pending timers and jobs see the
+    // generation mismatch
+    for (auto it = m_records.begin(); it != m_records.end();) {
+        it = it->second.scan == m_scan ? std::next(it) : m_records.erase(it);
+    }
+}
+
+InjectionScheduler::State InjectionScheduler::StateOf(uint32_t pid) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_records.find(pid);
+    return it == m_records.end() ? State::None : it->second.state;
+}
+
+size_t InjectionScheduler::Count(State state) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    size_t count = 0;
+    for (const auto& entry : m_records) {
+        if (entry.second.state == state) count++;
+    }
+    return count;
+}
@@ -0,0 +1,129 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// Per-process injection state machine for the launcher:
+//
+//   seen -> Settling --settle delay--> Injecting --ok--> Verifying --ok--> Injected
+//                                         |                  |
+//                                         +------fail--------+--> Backoff --delay--> Injecting
+//                                                                 (Failed after maxAttempts)
+//
+// Delays run on a hashed timer wheel (one thread); inject and verify calls,
+// which may block for seconds, run on a small worker pool. Update() only
+// edits the table, so the scan tick never waits for a game. A pid that
+// leaves the scan (exited, or reused by another exe) is dropped at once;
+// results of calls still in flight for it are discarded.
+//
+// Portable: the injector is a callback, so the scheduler runs on Linux with
+// a mock injector and the /proc process snapshot.
+class InjectionScheduler {
+public:
+    enum class State {
+        None,           // Not tracked
+        Settling,
+        Injecting,
+        Verifying,
+        Backoff,
+        Injected,
+        Failed,
+    };
+
+    struct Candidate {
+        uint32_t pid;
+        size_t game;
+        std::string name;   // Exe name; a different name for a known pid is a new process
+    };
+
+    struct Callbacks {
+        // Worker thread; true if the DLL was loaded
+        std::function<bool(uint32_t pid)> inject;
+        // Worker thread; true if the DLL is still present (optional)
+        std::function<bool(uint32_t pid)> verify;
+        // Worker thread; final outcome for one process (optional)
+        std::function<void(const Candidate& process, bool injected)> finished;
+    };
+
+    struct Options {
+        uint32_t settleMs = 2000;
+        uint32_t verifyDelayMs = 500;
+        uint32_t retryBaseMs = 1000;        // Doubles per failed attempt
+        uint32_t maxAttempts = 3;
+        uint32_t tickMs = 50;               // Wheel resolution
+        uint32_t wheelSlots = 256;          // Power of two
+        uint32_t workers = 2;
+    };
+
+    InjectionScheduler(Callbacks callbacks, Options options);
+    ~InjectionScheduler();
+    InjectionScheduler(const InjectionScheduler&) = delete;
+    InjectionScheduler& operator=(const InjectionScheduler&) = delete;
+
+    void Start();
+    void Stop();        // Waits for running inject/verify calls
+
+    // The matching processes of one scan; never blocks on injection
+    void Update(const std::vector<Candidate>& running);
+
+    State StateOf(uint32_t pid) const;
+    size_t Count(State state) const;
+
+private:
+    enum class Job { Inject, Verify };
+
+    struct Record {
+        Candidate process;
+        State state = State::Settling;
+        uint64_t generation = 0;
+        uint32_t attempts = 0;
+        uint64_t scan = 0;
+    };
+
+    struct Timer {
+        uint32_t pid;
+        uint64_t generation;
+        uint64_t deadline;      // Tick
+    };
+
+    struct Work {
+        uint32_t pid;
+        uint64_t generation;
+        Job job;
+    };
+
+    uint64_t NowTick() const;
+    void Schedule(const Record& record, uint32_t delayMs);      // Caller holds m_mutex
+    void Fire(const Timer& timer);                              // Caller holds m_mutex
+    void Fail(Record& record);                                  // Caller holds m_mutex
+    void TimerLoop();
+    void WorkerLoop();
+
+    Callbacks m_callbacks;
+    Options m_options;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_timerWake;
+    std::condition_variable m_workReady;
+    std::unordered_map<uint32_t, Record> m_records;
+    std::vector<std::vector<Timer>> m_wheel;
+    std::deque<Work> m_work;
+    uint64_t m_nextGeneration = 1;
+    uint64_t m_scan = 0;
+    uint64_t m_processedTick = 0;
+    size_t m_pendingTimers = 0;         // The timer thread sleeps while 0
+    bool m_running = false;
+
+    std::chrono::steady_clock::time_point m_start;
+    std::thread m_timerThread;
+    std::vector<std::thread> m_workers;
+};
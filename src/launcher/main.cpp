@@ -4,10 +4,17 @@
 #include <string>
 #include <fstream>
 #include <vector>
-#include <set>
+#include <unordered_set>
 #include "resource.h"
+#include "game_matcher.h"
+#include "injection_scheduler.h"
+#include "process_events.h"
+#include "overlay_config.h"
+#include "process_enum.h"
 
 #define WM_TRAYICON (WM_USER + 1)
+#define WM_TRAY_NOTIFY (WM_USER + 2)    // lParam: Notification*, deleted by the handler
+#define WM_TRAY_TIP (WM_USER + 3)
 #define ID_TRAY_EXIT 1001
 #define ID_TRAY_CONFIG 1002
 #define ID_TRAY_OVERLAY_CONFIG 1004
@@ -21,7 +28,7 @@ std::wstring g_dllPath;
 std::wstring g_configPath;
 std::wstring g_overlayConfigPath;
 std::vector<std::wstring> g_games;
-std::set<DWORD> g_injectedPids;
+ProcessEvents g_processEvents;
 FILETIME g_lastConfigTime = {0};
 CRITICAL_SECTION g_cs;
 
@@ -69,25 +76,18 @@ void ReloadConfig() {
     LeaveCriticalSection(&g_cs);
 }
 
-DWORD FindProcessByName(const wchar_t* processName) {
-    DWORD pid = 0;
-    HANDLE snapshot = CreateToolhelp32Snapshot(TH32CS_SNAPPROCESS, 0);
-    
-    if (snapshot != INVALID_HANDLE_VALUE) {
-        PROCESSENTRY32W pe32;
-        pe32.dwSize = sizeof(PROCESSENTRY32W);
-        
-        if (Process32FirstW(snapshot, &pe32)) {
-            do {
-                if (_wcsicmp(pe32.szExeFile, processName) == 0) {
-                    pid = pe32.th32ProcessID;
-                    break;
-                }
-            } while (Process32NextW(snapshot, &pe32));
-        }
-        CloseHandle(snapshot);
-    }
-    return pid;
+std::string ToUtf8(const std::wstring& text) {
+    int bytes = WideCharToMultiByte(CP_UTF8, 0, text.c_str(), (int)text.size(), nullptr, 0, nullptr, nullptr);
+    std::string out(bytes > 0 ? bytes : 0, '\0');
+    if (bytes > 0) WideCharToMultiByte(CP_UTF8, 0, text.c_str(), (int)text.size(), &out[0], bytes, nullptr, nullptr);
+    return out;
+}
+
+std::wstring FromUtf8(const std::string& text) {
+    int chars = MultiByteToWideChar(CP_UTF8, 0, text.c_str(), (int)text.size(), nullptr, 0);
+    std::wstring out(chars > 0 ? chars : 0, L'\0');
+    if (chars > 0) MultiByteToWideChar(CP_UTF8, 0, text.c_str(), (int)text.size(), &out[0], chars);
+    return out;
 }
 
 bool InjectToProcess(DWORD pid, const wchar_t* dllPath) {
@@ -125,6 +125,29 @@ bool InjectToProcess(DWORD pid, const wchar_t* dllPath) {
     return success;
 }
 
+// The overlay DLL is still loaded (it was not rejected by the game)
+bool IsDllLoaded(DWORD pid, const wchar_t* dllPath) {
+    const wchar_t* dllName = wcsrchr(dllPath, L'\\');
+    dllName = dllName ? dllName + 1 : dllPath;
+    
+    HANDLE snapshot = CreateToolhelp32Snapshot(TH32CS_SNAPMODULE | TH32CS_SNAPMODULE32, pid);
+    if (snapshot == INVALID_HANDLE_VALUE) return false;
+    
+    MODULEENTRY32W me32;
+    me32.dwSize = sizeof(MODULEENTRY32W);
+    bool found = false;
+    if (Module32FirstW(snapshot, &me32)) {
+        do {
+            if (_wcsicmp(me32.szModule, dllName) == 0) {
+                found = true;
+                break;
+            }
+        } while (Module32NextW(snapshot, &me32));
+    }
+    CloseHandle(snapshot);
+    return found;
+}
+
 void CreateDefaultConfig(const std::wstring& configPath) {
     std::wofstream file(configPath);
     file << L"# FPS Overlay - Game List\n";
@@ -137,55 +160,42 @@ void CreateDefaultConfig(const std::wstring& configPath) {
 }
 
 void CreateDefaultOverlayConfig(const std::wstring& configPath) {
-    std::wofstream file(configPath);
-    file << L"; FPS Overlay - Overlay Settings\n";
-    file << L"; This file is read by fps_overlay.dll (auto-reloads on change).\n";
-    file << L"\n";
-    file << L"[Overlay]\n";
-    file << L"; 0..1 (window background alpha)\n";
-    file << L"Alpha=0.25\n";
-    file << L"\n";
-    file << L"; 0/1\n";
-    file << L"ShowFps=1\n";
-    file << L"ShowFrameTime=1\n";
-    file << L"\n";
-    file << L"; Color thresholds\n";
-    file << L"GreenThreshold=60\n";
-    file << L"YellowThreshold=30\n";
-    file << L"\n";
-    file << L"; Font scale (default 1.0)\n";
-    file << L"FontScale=1.0\n";
-    file << L"\n";
-    file << L"; FPS smoothing\n";
-    file << L"SampleCount=60\n";
-    file << L"DisplayUpdateMs=80\n";
-    file << L"\n";
-    file << L"; Corner: TopLeft, TopRight, BottomLeft, BottomRight, Custom\n";
-    file << L"Corner=TopRight\n";
-    file << L"MarginX=8\n";
-    file << L"MarginY=8\n";
-    file << L"\n";
-    file << L"; Used when Corner=Custom\n";
-    file << L"X=10\n";
-    file << L"Y=10\n";
-    file << L"\n";
-    file << L"; ToggleKey: F1-F12 (or a VK code number)\n";
-    file << L"ToggleKey=F1\n";
-    file << L"\n";
-    file << L"; 0/1\n";
-    file << L"Visible=1\n";
-    file.close();
+    // Generated from the same schema fps_overlay.dll parses
+    OverlayConfig defaults;
+    std::string text;
+    ConfigSchema::Write(kOverlayConfigSchema, &defaults, text);
+
+    std::ofstream file(configPath.c_str());
+    file.write(text.data(), static_cast<std::streamsize>(text.size()));
 }
 
+// g_nid belongs to the UI thread. The monitor thread and the injection
+// scheduler's workers only post to g_hWnd; WndProc applies the change.
+struct Notification {
+    std::wstring title;
+    std::wstring msg;
+};
+
 void ShowNotification(const wchar_t* title, const wchar_t* msg) {
+    Notification* notification = new Notification{ title, msg };
+    if (!PostMessageW(g_hWnd, WM_TRAY_NOTIFY, 0, (LPARAM)notification)) delete notification;
+}
+
+void UpdateTrayTip() {
+    PostMessageW(g_hWnd, WM_TRAY_TIP, 0, 0);
+}
+
+// UI thread only
+void ApplyNotification(const Notification& notification) {
     g_nid.uFlags = NIF_INFO;
-    wcscpy_s(g_nid.szInfoTitle, title);
-    wcscpy_s(g_nid.szInfo, msg);
+    wcsncpy_s(g_nid.szInfoTitle, notification.title.c_str(), _TRUNCATE);
+    wcsncpy_s(g_nid.szInfo, notification.msg.c_str(), _TRUNCATE);
     g_nid.dwInfoFlags = NIIF_INFO;
     Shell_NotifyIconW(NIM_MODIFY, &g_nid);
 }
 
-void UpdateTrayTip() {
+// UI thread only
+void ApplyTrayTip() {
     EnterCriticalSection(&g_cs);
     size_t count = g_games.size();
     LeaveCriticalSection(&g_cs);
@@ -196,12 +206,40 @@ void UpdateTrayTip() {
 }
 
 DWORD WINAPI MonitorThread(LPVOID param) {
-    int checkCounter = 0;
+    ULONGLONG lastConfigCheck = GetTickCount64();
+    
+    // One process snapshot per rescan, matched against every configured game
+    ProcessSnapshot snapshot;
+    GameMatcher matcher;
+    std::vector<std::wstring> matchedGames;
+    std::vector<GameMatcher::Match> matches;
+    std::vector<InjectionScheduler::Candidate> candidates;
+    
+    // Settle, inject, verify and retry per process off this thread, so a slow
+    // injection never delays the scan of other games
+    InjectionScheduler::Callbacks callbacks;
+    callbacks.inject = [](uint32_t pid) { return InjectToProcess(pid, g_dllPath.c_str()); };
+    callbacks.verify = [](uint32_t pid) { return IsDllLoaded(pid, g_dllPath.c_str()); };
+    callbacks.finished = [](const InjectionScheduler::Candidate& process, bool injected) {
+        std::wstring game = FromUtf8(process.name);
+        ShowNotification(L"FPS Overlay", (game + (injected ? L" - Injected! Press F1 to toggle." : L" - Injection failed")).c_str());
+    };
+    InjectionScheduler scheduler(callbacks, InjectionScheduler::Options());
+    scheduler.Start();
+    
+    // Rescan when a game starts or a tracked one exits, instead of every
+    // second; without start events (not elevated) fall back to the 1 s poll
+    g_processEvents.Start();
+    std::vector<ProcessEvents::Event> events;
+    std::unordered_set<uint32_t> watched;
+    std::string startedName;
+    bool rescan = true;
     
     while (g_running) {
         // Check config file every 5 seconds
-        if (++checkCounter >= 5) {
-            checkCounter = 0;
+        ULONGLONG now = GetTickCount64();
+        if (now - lastConfigCheck >= 5000) {
+            lastConfigCheck = now;
             FILETIME currentTime = GetFileModTime(g_configPath);
             if (CompareFileTime(&currentTime, &g_lastConfigTime) != 0) {
                 ReloadConfig();
@@ -221,37 +259,55 @@ DWORD WINAPI MonitorThread(LPVOID param) {
         std::vector<std::wstring> games = g_games;
         LeaveCriticalSection(&g_cs);
         
-        for (const auto& game : games) {
-            DWORD pid = FindProcessByName(game.c_str());
+        if (games != matchedGames) {
+            std::vector<std::string> names;
+            for (const auto& game : games) names.push_back(ToUtf8(game));
+            matcher.Build(names);
+            matchedGames = games;
+            rescan = true;
+        }
+        
+        if (rescan && snapshot.Take()) {
+            rescan = false;
+            // Every instance of every game, not only the first; pids that
+            // left the scan (exited, or reused by another exe) are dropped
+            matcher.FindAll(snapshot, matches);
+            candidates.clear();
+            for (const auto& match : matches) {
+                size_t i = snapshot.IndexOf(match.pid);
+                candidates.push_back({ match.pid, match.game, std::string(snapshot.Name(i)) });
+            }
+            scheduler.Update(candidates);
             
-            if (pid != 0 && g_injectedPids.find(pid) == g_injectedPids.end()) {
-                Sleep(2000);
-                
-                if (FindProcessByName(game.c_str()) == pid) {
-                    if (InjectToProcess(pid, g_dllPath.c_str())) {
-                        g_injectedPids.insert(pid);
-                        ShowNotification(L"FPS Overlay", (game + L" - Injected! Press F1 to toggle.").c_str());
-                    }
+            // One exit wait per game process; one that cannot be watched is
+            // picked up by a later rescan
+            for (const auto& candidate : candidates) {
+                if (!watched.insert(candidate.pid).second) continue;
+                if (!g_processEvents.Watch(candidate.pid)) {
+                    watched.erase(candidate.pid);
+                    rescan = true;
                 }
             }
         }
         
-        // Clean up closed processes
-        std::set<DWORD> activePids;
-        for (DWORD pid : g_injectedPids) {
-            HANDLE h = OpenProcess(PROCESS_QUERY_LIMITED_INFORMATION, FALSE, pid);
-            if (h) {
-                DWORD exitCode;
-                if (GetExitCodeProcess(h, &exitCode) && exitCode == STILL_ACTIVE) {
-                    activePids.insert(pid);
-                }
-                CloseHandle(h);
+        bool eventDriven = g_processEvents.HasStartEvents();
+        ULONGLONG elapsed = GetTickCount64() - lastConfigCheck;
+        DWORD timeout = eventDriven ? (DWORD)(elapsed < 5000 ? 5000 - elapsed : 0) : 1000;
+        g_processEvents.Wait(timeout, events);
+        if (!eventDriven) rescan = true;
+        for (const auto& event : events) {
+            if (event.kind == ProcessEvents::Kind::Exited) {
+                watched.erase(event.pid);
+                rescan = true;
+            } else if (event.pid == 0) {
+                rescan = true;      // Events were dropped
+            } else if (!rescan && ProcessSnapshot::NameOf(event.pid, startedName) && matcher.Find(startedName) >= 0) {
+                rescan = true;
             }
         }
-        g_injectedPids = activePids;
-        
-        Sleep(1000);
     }
+    g_processEvents.Stop();
+    scheduler.Stop();
     return 0;
 }
 
@@ -279,6 +335,17 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam) {
         }
         return 0;
         
+    case WM_TRAY_NOTIFY: {
+        Notification* notification = (Notification*)lParam;
+        ApplyNotification(*notification);
+        delete notification;
+        return 0;
+    }
+        
+    case WM_TRAY_TIP:
+        ApplyTrayTip();
+        return 0;
+        
     case WM_COMMAND:
         switch (LOWORD(wParam)) {
         case ID_TRAY_EXIT:
@@ -295,6 +362,7 @@ LRESULT CALLBACK WndProc(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam) {
         case ID_TRAY_RELOAD:
             ReloadConfig();
             UpdateTrayTip();
+            g_processEvents.Wake();     // Rematch now, not at the next event
             {
                 EnterCriticalSection(&g_cs);
                 size_t count = g_games.size();
@@ -408,6 +476,7 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE, LPSTR, int) {
     }
     
     g_running = false;
+    g_processEvents.Wake();
     WaitForSingleObject(hThread, 2000);
     CloseHandle(hThread);
     CloseHandle(hMutex);
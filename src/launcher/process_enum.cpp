@@ -0,0 +1,145 @@
+#include "process_enum.h"
+#include <algorithm>
+#include <cstring>
+
+#ifdef _WIN32
+#include <Windows.h>
+#include <TlHelp32.h>
+#else
+#include <cstdio>
+#include <cstdlib>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+void ProcessSnapshot::Add(uint32_t pid, const char* name, size_t length) {
+    m_entries.push_back({ pid, static_cast<uint32_t>(m_names.size()), static_cast<uint32_t>(length) });
+    m_names.append(name, length);
+}
+
+size_t ProcessSnapshot::IndexOf(uint32_t pid) const {
+    auto it = std::lower_bound(m_entries.begin(), m_entries.end(), pid,
+                               [](const Entry& entry, uint32_t value) { return entry.pid < value; });
+    if (it == m_entries.end() || it->pid != pid) return npos;
+    return static_cast<size_t>(it - m_entries.begin());
+}
+
+bool ProcessSnapshot::Contains(uint32_t pid, std::string_view name) const {
+    size_t i = IndexOf(pid);
+    return i != npos && Name(i) == name;
+}
+
+#ifdef _WIN32
+
+bool ProcessSnapshot::Take() {
+    Clear();
+    HANDLE snapshot = CreateToolhelp32Snapshot(TH32CS_SNAPPROCESS, 0);
+    if (snapshot == INVALID_HANDLE_VALUE) return false;
+
+    PROCESSENTRY32W pe32;
+    pe32.dwSize = sizeof(PROCESSENTRY32W);
+    char name[MAX_PATH * 3];
+    if (Process32FirstW(snapshot, &pe32)) {
+        do {
+            int bytes = WideCharToMultiByte(CP_UTF8, 0, pe32.szExeFile, -1, name, sizeof(name), nullptr, nullptr);
+            if (bytes > 1) Add(pe32.th32ProcessID, name, static_cast<size_t>(bytes - 1));
+        } while (Process32NextW(snapshot, &pe32));
+    }
+    CloseHandle(snapshot);
+
+    std::sort(m_entries.begin(), m_entries.end(), [](const Entry& a, const Entry& b) { return a.pid < b.pid; });
+    return true;
+}
+
+bool ProcessSnapshot::NameOf(uint32_t pid, std::string& name) {
+    HANDLE process = OpenProcess(PROCESS_QUERY_LIMITED_INFORMATION, FALSE, pid);
+    if (!process) return false;
+    wchar_t path[MAX_PATH];
+    DWORD length = MAX_PATH;
+    BOOL ok = QueryFullProcessImageNameW(process, 0, path, &length);
+    CloseHandle(process);
+    if (!ok) return false;
+
+    const wchar_t* file = wcsrchr(path, L'\\');
+    file = file ? file + 1 : path;
+    char buffer[MAX_PATH * 3];
+    int bytes = WideCharToMultiByte(CP_UTF8, 0, file, -1, buffer, sizeof(buffer), nullptr, nullptr);
+    if (bytes <= 1) return false;
+    name.assign(buffer, static_cast<size_t>(bytes - 1));
+    return true;
+}
+
+#else
+
+namespace {
+    // Basename of /proc/<pid>/exe; falls back to comm (truncated to 15
+    // chars) for processes whose exe link is not readable
+    size_t ReadProcessName(const char* pidText, char* out, size_t size) {
+        char path[64];
+        std::snprintf(path, sizeof(path), "/proc/%s/exe", pidText);
+        char target[4096];
+        ssize_t length = readlink(path, target, sizeof(target) - 1);
+        if (length > 0) {
+            target[length] = '\0';
+            // Replaced binaries show up as "/path/name (deleted)"
+            const char* deleted = " (deleted)";
+            size_t deletedLength = std::strlen(deleted);
+            if (static_cast<size_t>(length) > deletedLength &&
+                std::memcmp(target + length - deletedLength, deleted, deletedLength) == 0) {
+                length -= static_cast<ssize_t>(deletedLength);
+                target[length] = '\0';
+            }
+            const char* slash = std::strrchr(target, '/');
+            const char* name = slash ? slash + 1 : target;
+            size_t nameLength = std::strlen(name);
+            if (nameLength > 0 && nameLength < size) {
+                std::memcpy(out, name, nameLength);
+                return nameLength;
+            }
+        }
+
+        std::snprintf(path, sizeof(path), "/proc/%s/comm", pidText);
+        int fd = open(path, O_RDONLY | O_CLOEXEC);
+        if (fd < 0) return 0;
+        ssize_t bytes = read(fd, out, size);
+        close(fd);
+        if (bytes <= 0) return 0;
+        size_t nameLength = static_cast<size_t>(bytes);
+        if (out[nameLength - 1] == '\n') nameLength--;
+        return nameLength;
+    }
+}
+
+bool ProcessSnapshot::Take() {
+    Clear();
+    DIR* dir = opendir("/proc");
+    if (!dir) return false;
+
+    char name[256];
+    while (dirent* entry = readdir(dir)) {
+        const char* text = entry->d_name;
+        if (*text < '0' || *text > '9') continue;
+        char* end = nullptr;
+        unsigned long pid = std::strtoul(text, &end, 10);
+        if (*end != '\0') continue;
+        size_t length = ReadProcessName(text, name, sizeof(name));
+        if (length > 0) Add(static_cast<uint32_t>(pid), name, length);
+    }
+    closedir(dir);
+
+    std::sort(m_entries.begin(), m_entries.end(), [](const Entry& a, const Entry& b) { return a.pid < b.pid; });
+    return true;
+}
+
+bool ProcessSnapshot::NameOf(uint32_t pid, std::string& name) {
+    char pidText[16];
+    std::snprintf(pidText, sizeof(pidText), "%u", pid);
+    char buffer[256];
+    size_t length = ReadProcessName(pidText, buffer, sizeof(buffer));
+    if (length == 0) return false;
+    name.assign(buffer, length);
+    return true;
+}
+
+#endif
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// One pass over the running processes: Toolhelp32 on Windows, /proc on
+// Linux (where the launcher logic is tested). Names are the exe file name in
+// UTF-8; buffers are reused across Take() calls, so a steady-state scan does
+// not allocate.
+class ProcessSnapshot {
+public:
+    bool Take();
+
+    size_t Count() const { return m_entries.size(); }
+    uint32_t Pid(size_t i) const { return m_entries[i].pid; }
+    std::string_view Name(size_t i) const {
+        return std::string_view(m_names.data() + m_entries[i].nameOffset, m_entries[i].nameLength);
+    }
+
+    static constexpr size_t npos = static_cast<size_t>(-1);
+
+    // Binary search; npos if the pid is not running
+    size_t IndexOf(uint32_t pid) const;
+
+    // Same pid with the same name in this snapshot
+    bool Contains(uint32_t pid, std::string_view name) const;
+
+    // Exe file name of one process without a full snapshot (for start
+    // events); false if it exited or cannot be queried
+    static bool NameOf(uint32_t pid, std::string& name);
+
+    // Used by the backends
+    void Clear() { m_entries.clear(); m_names.clear(); }
+    void Add(uint32_t pid, const char* name, size_t length);
+
+private:
+    struct Entry {
+        uint32_t pid;
+        uint32_t nameOffset;
+        uint32_t nameLength;
+    };
+    std::vector<Entry> m_entries;      // Sorted by pid after Take()
+    std::string m_names;
+};
@@ -0,0 +1,407 @@
+#include "process_events.h"
+#include <chrono>
+
+#ifdef _WIN32
+#include <Windows.h>
+#include <evntrace.h>
+#include <evntcons.h>
+#else
+#include <cerrno>
+#include <cstring>
+#include <linux/cn_proc.h>
+#include <linux/connector.h>
+#include <linux/netlink.h>
+#include <poll.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+void ProcessEvents::Push(const Event& event) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_queue.push_back(event);
+    }
+    m_ready.notify_one();
+}
+
+bool ProcessEvents::Wait(uint32_t timeoutMs, std::vector<Event>& out) {
+    out.clear();
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_ready.wait_for(lock, std::chrono::milliseconds(timeoutMs), [this] { return !m_queue.empty() || m_woken; });
+    m_woken = false;
+    out.swap(m_queue);
+    return !out.empty();
+}
+
+void ProcessEvents::Wake() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_woken = true;
+    }
+    m_ready.notify_all();
+}
+
+#ifdef _WIN32
+
+// Microsoft-Windows-Kernel-Process
+static const GUID KERNEL_PROCESS_PROVIDER =
+    { 0x22FB2CD6, 0x0E7B, 0x422B, { 0xA0, 0xC7, 0x2F, 0xAD, 0x1F, 0xD0, 0xE7, 0x16 } };
+static const ULONGLONG KERNEL_PROCESS_KEYWORD = 0x10;      // WINEVENT_KEYWORD_PROCESS
+static const USHORT PROCESS_START_EVENT = 1;                // Payload starts with the new ProcessID
+static const wchar_t* SESSION_NAME = L"FpsOverlayProcessEvents";
+
+struct ProcessEvents::WatchEntry {
+    ProcessEvents* owner;
+    uint32_t pid;
+    HANDLE process;
+    PTP_WAIT wait;
+};
+
+struct ProcessEvents::Native {
+    static VOID CALLBACK OnExit(PTP_CALLBACK_INSTANCE, PVOID context, PTP_WAIT wait, TP_WAIT_RESULT) {
+        WatchEntry* entry = (WatchEntry*)context;
+        ProcessEvents* self = entry->owner;
+        {
+            std::lock_guard<std::mutex> lock(self->m_mutex);
+            auto it = self->m_watches.find(entry->pid);
+            if (it == self->m_watches.end() || it->second != entry) return;    // Unwatch owns it
+            self->m_watches.erase(it);
+            self->m_queue.push_back({ Kind::Exited, entry->pid });
+        }
+        self->m_ready.notify_one();
+
+        // Allowed from the callback: the wait is freed once it returns
+        CloseThreadpoolWait(wait);
+        CloseHandle(entry->process);
+        delete entry;
+    }
+
+    static VOID WINAPI OnTraceEvent(PEVENT_RECORD record) {
+        if (!IsEqualGUID(record->EventHeader.ProviderId, KERNEL_PROCESS_PROVIDER)) return;
+        if (record->EventHeader.EventDescriptor.Id != PROCESS_START_EVENT) return;
+        if (record->UserDataLength < sizeof(ULONG)) return;
+
+        ULONG pid;
+        memcpy(&pid, record->UserData, sizeof(pid));
+        ((ProcessEvents*)record->UserContext)->Push({ Kind::Started, pid });
+    }
+};
+
+static std::vector<BYTE> MakeSessionProperties() {
+    std::vector<BYTE> buffer(sizeof(EVENT_TRACE_PROPERTIES) + (wcslen(SESSION_NAME) + 1) * sizeof(wchar_t));
+    EVENT_TRACE_PROPERTIES* props = (EVENT_TRACE_PROPERTIES*)buffer.data();
+    props->Wnode.BufferSize = (ULONG)buffer.size();
+    props->Wnode.Flags = WNODE_FLAG_TRACED_GUID;
+    props->Wnode.ClientContext = 1;
+    props->LogFileMode = EVENT_TRACE_REAL_TIME_MODE;
+    props->LoggerNameOffset = sizeof(EVENT_TRACE_PROPERTIES);
+    props->BufferSize = 4;          // KB; process starts are rare and small
+    props->FlushTimer = 1;          // Seconds; bounds the delivery delay
+    return buffer;
+}
+
+bool ProcessEvents::Start() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_running) return true;
+        m_running = true;
+        m_woken = false;
+    }
+
+    // A session left behind by a crashed launcher keeps the name taken
+    std::vector<BYTE> props = MakeSessionProperties();
+    ControlTraceW(0, SESSION_NAME, (EVENT_TRACE_PROPERTIES*)props.data(), EVENT_TRACE_CONTROL_STOP);
+
+    props = MakeSessionProperties();
+    TRACEHANDLE session = 0;
+    if (StartTraceW(&session, SESSION_NAME, (EVENT_TRACE_PROPERTIES*)props.data()) != ERROR_SUCCESS) {
+        return true;    // Not elevated: exit watches only
+    }
+    m_session = session;
+
+    ULONG status = EnableTraceEx2(session, &KERNEL_PROCESS_PROVIDER, EVENT_CONTROL_CODE_ENABLE_PROVIDER,
+                                  TRACE_LEVEL_INFORMATION, KERNEL_PROCESS_KEYWORD, 0, 0, nullptr);
+    if (status == ERROR_SUCCESS) {
+        EVENT_TRACE_LOGFILEW logfile = {0};
+        logfile.LoggerName = (LPWSTR)SESSION_NAME;
+        logfile.ProcessTraceMode = PROCESS_TRACE_MODE_REAL_TIME | PROCESS_TRACE_MODE_EVENT_RECORD;
+        logfile.EventRecordCallback = Native::OnTraceEvent;
+        logfile.Context = this;
+        TRACEHANDLE trace = OpenTraceW(&logfile);
+        if (trace != INVALID_PROCESSTRACE_HANDLE) {
+            m_trace = trace;
+            m_startEvents = true;
+            m_traceThread = std::thread(&ProcessEvents::TraceLoop, this);
+            return true;
+        }
+    }
+
+    ControlTraceW(session, nullptr, (EVENT_TRACE_PROPERTIES*)props.data(), EVENT_TRACE_CONTROL_STOP);
+    m_session = 0;
+    return true;
+}
+
+void ProcessEvents::TraceLoop() {
+    TRACEHANDLE trace = m_trace;
+    ProcessTrace(&trace, 1, nullptr, nullptr);      // Returns after CloseTrace
+}
+
+void ProcessEvents::Stop() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_running) return;
+        m_running = false;
+    }
+
+    if (m_trace != 0) {
+        CloseTrace(m_trace);
+        m_trace = 0;
+    }
+    if (m_session != 0) {
+        std::vector<BYTE> props = MakeSessionProperties();
+        ControlTraceW(m_session, nullptr, (EVENT_TRACE_PROPERTIES*)props.data(), EVENT_TRACE_CONTROL_STOP);
+        m_session = 0;
+    }
+    if (m_traceThread.joinable()) m_traceThread.join();
+    m_startEvents = false;
+
+    std::vector<uint32_t> pids;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (const auto& watch : m_watches) pids.push_back(watch.first);
+    }
+    for (uint32_t pid : pids) Unwatch(pid);
+    Wake();
+}
+
+bool ProcessEvents::Watch(uint32_t pid) {
+    HANDLE process = OpenProcess(SYNCHRONIZE, FALSE, pid);
+    if (!process) return false;
+    WatchEntry* entry = new WatchEntry{ this, pid, process, nullptr };
+    entry->wait = CreateThreadpoolWait(Native::OnExit, entry, nullptr);
+    if (!entry->wait) {
+        CloseHandle(process);
+        delete entry;
+        return false;
+    }
+
+    bool watched;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_running && m_watches.find(pid) == m_watches.end()) {
+            m_watches[pid] = entry;
+            // Fires at once if the process already exited
+            SetThreadpoolWait(entry->wait, process, nullptr);
+            return true;
+        }
+        watched = m_running;        // Already watched
+    }
+
+    CloseThreadpoolWait(entry->wait);
+    CloseHandle(process);
+    delete entry;
+    return watched;
+}
+
+void ProcessEvents::Unwatch(uint32_t pid) {
+    WatchEntry* entry = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_watches.find(pid);
+        if (it == m_watches.end()) return;
+        entry = it->second;
+        m_watches.erase(it);
+    }
+
+    SetThreadpoolWait(entry->wait, nullptr, nullptr);
+    WaitForThreadpoolWaitCallbacks(entry->wait, TRUE);
+    CloseThreadpoolWait(entry->wait);
+    CloseHandle(entry->process);
+    delete entry;
+}
+
+#else
+
+#ifndef SYS_pidfd_open
+#define SYS_pidfd_open 434
+#endif
+
+namespace {
+    const uint64_t kWakeTag = ~0ull;
+    const uint64_t kNetlinkTag = ~0ull - 1;
+
+    // Subscribes to the proc connector; -1 without CAP_NET_ADMIN
+    int OpenProcConnector() {
+        int fd = socket(AF_NETLINK, SOCK_DGRAM | SOCK_CLOEXEC | SOCK_NONBLOCK, NETLINK_CONNECTOR);
+        if (fd < 0) return -1;
+
+        sockaddr_nl address = {};
+        address.nl_family = AF_NETLINK;
+        address.nl_groups = CN_IDX_PROC;
+        if (bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+            close(fd);
+            return -1;
+        }
+
+        alignas(nlmsghdr) char buffer[NLMSG_SPACE(sizeof(cn_msg) + sizeof(proc_cn_mcast_op))] = {};
+        nlmsghdr* header = reinterpret_cast<nlmsghdr*>(buffer);
+        header->nlmsg_len = NLMSG_LENGTH(sizeof(cn_msg) + sizeof(proc_cn_mcast_op));
+        header->nlmsg_type = NLMSG_DONE;
+        cn_msg* message = static_cast<cn_msg*>(NLMSG_DATA(header));
+        message->id.idx = CN_IDX_PROC;
+        message->id.val = CN_VAL_PROC;
+        message->len = sizeof(proc_cn_mcast_op);
+        proc_cn_mcast_op op = PROC_CN_MCAST_LISTEN;
+        std::memcpy(message->data, &op, sizeof(op));
+        if (send(fd, buffer, header->nlmsg_len, 0) < 0) {
+            close(fd);
+            return -1;
+        }
+        return fd;
+    }
+}
+
+bool ProcessEvents::Start() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_running) return true;
+
+    m_epoll = epoll_create1(EPOLL_CLOEXEC);
+    m_wakeFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (m_epoll < 0 || m_wakeFd < 0) {
+        if (m_epoll >= 0) close(m_epoll);
+        if (m_wakeFd >= 0) close(m_wakeFd);
+        m_epoll = m_wakeFd = -1;
+        return false;
+    }
+    epoll_event event = {};
+    event.events = EPOLLIN;
+    event.data.u64 = kWakeTag;
+    epoll_ctl(m_epoll, EPOLL_CTL_ADD, m_wakeFd, &event);
+
+    m_netlink = OpenProcConnector();
+    if (m_netlink >= 0) {
+        event.data.u64 = kNetlinkTag;
+        epoll_ctl(m_epoll, EPOLL_CTL_ADD, m_netlink, &event);
+        m_startEvents = true;
+    }
+
+    m_running = true;
+    m_woken = false;
+    m_pollThread = std::thread(&ProcessEvents::PollLoop, this);
+    return true;
+}
+
+void ProcessEvents::PollLoop() {
+    alignas(nlmsghdr) char buffer[8192];
+    epoll_event events[32];
+    for (;;) {
+        int count = epoll_wait(m_epoll, events, 32, -1);
+        if (count < 0) {
+            if (errno == EINTR) continue;
+            return;
+        }
+
+        for (int i = 0; i < count; i++) {
+            uint64_t tag = events[i].data.u64;
+            if (tag == kWakeTag) {
+                uint64_t value;
+                if (read(m_wakeFd, &value, sizeof(value)) < 0) {}
+                std::lock_guard<std::mutex> lock(m_mutex);
+                if (!m_running) return;
+            } else if (tag == kNetlinkTag) {
+                for (;;) {
+                    ssize_t bytes = recv(m_netlink, buffer, sizeof(buffer), 0);
+                    if (bytes < 0) {
+                        // Queue overflow: some starts were lost, ask for a rescan
+                        if (errno != ENOBUFS) break;
+                        Push({ Kind::Started, 0 });
+                        continue;
+                    }
+                    int length = static_cast<int>(bytes);
+                    for (nlmsghdr* header = reinterpret_cast<nlmsghdr*>(buffer); NLMSG_OK(header, length);
+                         header = NLMSG_NEXT(header, length)) {
+                        if (header->nlmsg_type != NLMSG_DONE) continue;
+                        const cn_msg* message = static_cast<const cn_msg*>(NLMSG_DATA(header));
+                        if (message->id.idx != CN_IDX_PROC || message->len < sizeof(proc_event)) continue;
+                        // The payload is only 4-byte aligned in the message
+                        proc_event event;
+                        std::memcpy(&event, message->data, sizeof(event));
+                        // Exec, not fork: the exe name is known by then
+                        if (event.what == proc_event::PROC_EVENT_EXEC) {
+                            Push({ Kind::Started, static_cast<uint32_t>(event.event_data.exec.process_tgid) });
+                        }
+                    }
+                }
+            } else {
+                uint32_t pid = static_cast<uint32_t>(tag);
+                {
+                    std::lock_guard<std::mutex> lock(m_mutex);
+                    auto it = m_watches.find(pid);
+                    if (it == m_watches.end()) continue;
+                    // The fd may belong to a newer watch of a reused pid
+                    pollfd check = { it->second, POLLIN, 0 };
+                    if (poll(&check, 1, 0) <= 0) continue;
+                    epoll_ctl(m_epoll, EPOLL_CTL_DEL, it->second, nullptr);
+                    close(it->second);
+                    m_watches.erase(it);
+                    m_queue.push_back({ Kind::Exited, pid });
+                }
+                m_ready.notify_one();
+            }
+        }
+    }
+}
+
+void ProcessEvents::Stop() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_running) return;
+        m_running = false;
+    }
+    uint64_t one = 1;
+    if (write(m_wakeFd, &one, sizeof(one)) < 0) {}
+    if (m_pollThread.joinable()) m_pollThread.join();
+
+    for (const auto& watch : m_watches) close(watch.second);
+    m_watches.clear();
+    if (m_netlink >= 0) close(m_netlink);
+    close(m_epoll);
+    close(m_wakeFd);
+    m_netlink = m_epoll = m_wakeFd = -1;
+    m_startEvents = false;
+    Wake();
+}
+
+bool ProcessEvents::Watch(uint32_t pid) {
+    int fd = static_cast<int>(syscall(SYS_pidfd_open, static_cast<pid_t>(pid), 0));
+    if (fd < 0) return false;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_running || m_watches.find(pid) != m_watches.end()) {
+        close(fd);
+        return m_running;
+    }
+    epoll_event event = {};
+    event.events = EPOLLIN;
+    event.data.u64 = pid;
+    if (epoll_ctl(m_epoll, EPOLL_CTL_ADD, fd, &event) != 0) {
+        close(fd);
+        return false;
+    }
+    m_watches[pid] = fd;
+    return true;
+}
+
+void ProcessEvents::Unwatch(uint32_t pid) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto it = m_watches.find(pid);
+    if (it == m_watches.end()) return;
+    epoll_ctl(m_epoll, EPOLL_CTL_DEL, it->second, nullptr);
+    close(it->second);
+    m_watches.erase(it);
+}
+
+#endif
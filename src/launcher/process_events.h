@@ -0,0 +1,81 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// Process lifecycle events, so the launcher reacts when something happens
+// instead of rescanning on a fixed period:
+//
+//   Started  Windows: ETW Microsoft-Windows-Kernel-Process real-time session
+//            (needs admin; buffers are flushed at least once per second).
+//            Linux: netlink proc connector exec events (needs CAP_NET_ADMIN).
+//   Exited   Windows: one thread-pool wait per watched process handle, so
+//            there is no 64-handle limit and no thread per process.
+//            Linux: pidfd per watched process in one epoll set.
+//
+// Events from every source go into one queue drained by Wait(). When
+// start events are unavailable, HasStartEvents() is false and the caller
+// keeps polling; exit watches still work.
+class ProcessEvents {
+public:
+    enum class Kind { Started, Exited };
+
+    struct Event {
+        Kind kind;
+        uint32_t pid;       // Started with pid 0: events were dropped, rescan
+    };
+
+    ProcessEvents() = default;
+    ~ProcessEvents() { Stop(); }
+    ProcessEvents(const ProcessEvents&) = delete;
+    ProcessEvents& operator=(const ProcessEvents&) = delete;
+
+    // False if neither source could be set up
+    bool Start();
+    void Stop();
+    bool HasStartEvents() const { return m_startEvents; }
+
+    // Queues one Exited event when the process ends. False if it is already
+    // gone (or cannot be opened); the caller treats that as an exit.
+    bool Watch(uint32_t pid);
+    void Unwatch(uint32_t pid);
+
+    // Blocks until an event is queued, Wake() is called or the timeout
+    // passes, then moves every queued event into out (which is cleared).
+    // Returns false on timeout or wake without events.
+    bool Wait(uint32_t timeoutMs, std::vector<Event>& out);
+    void Wake();
+
+private:
+    void Push(const Event& event);
+
+    std::mutex m_mutex;
+    std::condition_variable m_ready;
+    std::vector<Event> m_queue;
+    bool m_woken = false;
+    bool m_running = false;
+    bool m_startEvents = false;
+
+#ifdef _WIN32
+    struct WatchEntry;
+    struct Native;      // Win32 callbacks, defined with the Windows types in the .cpp
+    void TraceLoop();
+
+    std::unordered_map<uint32_t, WatchEntry*> m_watches;    // Guarded by m_mutex
+    uint64_t m_session = 0;
+    uint64_t m_trace = 0;
+    std::thread m_traceThread;
+#else
+    void PollLoop();
+
+    std::unordered_map<uint32_t, int> m_watches;             // pid -> pidfd; guarded by m_mutex
+    int m_netlink = -1;
+    int m_epoll = -1;
+    int m_wakeFd = -1;
+    std::thread m_pollThread;
+#endif
+};
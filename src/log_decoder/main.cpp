@@ -0,0 +1,245 @@
+// log_decoder - turns binary logs (*.blog) written by Logger in binary mode
+// back into text
+//
+// Portable: builds on Windows alongside the overlay and on Linux for
+// reading logs collected from test machines.
+
+#include "log_format.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace {
+    struct SiteDef {
+        std::string format;
+        std::vector<uint8_t> types;
+    };
+
+    struct ClockSample {
+        uint64_t ticks;
+        int64_t unixNs;
+    };
+
+    struct Line {
+        uint64_t ticks;
+        std::string text;
+    };
+
+    class Decoder {
+    public:
+        Decoder(const unsigned char* data, size_t size) : m_begin(data), m_p(data), m_end(data + size) {}
+
+        // Parses the whole file; on a truncated tail keeps what was complete
+        bool Run(uint32_t* pid, std::string* error) {
+            LogFormat::FileHeader header;
+            if (static_cast<size_t>(m_end - m_p) < sizeof(header)) {
+                *error = "file too small";
+                return false;
+            }
+            std::memcpy(&header, m_p, sizeof(header));
+            if (header.magic != LogFormat::kMagic || header.version != LogFormat::kVersion) {
+                *error = "not a binary log (bad magic or version)";
+                return false;
+            }
+            *pid = header.pid;
+            m_p += sizeof(header);
+
+            while (m_p < m_end) {
+                const unsigned char* record = m_p;
+                if (!ReadRecord()) {
+                    char buf[64];
+                    std::snprintf(buf, sizeof(buf), "truncated or corrupt record at offset %zu",
+                                  static_cast<size_t>(record - m_begin));
+                    *error = buf;
+                    break;
+                }
+            }
+            return true;
+        }
+
+        // Linear interpolation between clock samples, extrapolating at the ends
+        int64_t TicksToUnixNs(uint64_t ticks) const {
+            if (m_clock.empty()) return 0;
+            if (m_clock.size() == 1) {
+                return m_clock[0].unixNs + static_cast<int64_t>(ticks - m_clock[0].ticks);
+            }
+            auto next = std::upper_bound(m_clock.begin() + 1, m_clock.end() - 1, ticks,
+                                         [](uint64_t t, const ClockSample& s) { return t < s.ticks; });
+            size_t i = static_cast<size_t>(next - m_clock.begin()) - 1;
+            const ClockSample& a = m_clock[i];
+            const ClockSample& b = m_clock[i + 1];
+            double rate = b.ticks != a.ticks ? static_cast<double>(b.unixNs - a.unixNs) / static_cast<double>(b.ticks - a.ticks) : 1.0;
+            return a.unixNs + static_cast<int64_t>(static_cast<double>(static_cast<int64_t>(ticks - a.ticks)) * rate);
+        }
+
+        std::vector<Line>& Lines() { return m_lines; }
+        size_t ClockSamples() const { return m_clock.size(); }
+
+    private:
+        bool Varint(uint64_t* v) { return LogFormat::GetVarint(m_p, m_end, v); }
+
+        bool ReadRecord() {
+            uint64_t tag;
+            if (!Varint(&tag)) return false;
+            if (!(tag & 1)) return ReadEntry(tag >> 1);
+
+            switch (tag >> 1) {
+            case LogFormat::kRecordSite: {
+                uint64_t id, len;
+                if (!Varint(&id) || m_p >= m_end) return false;
+                size_t count = *m_p++;
+                if (static_cast<size_t>(m_end - m_p) < count) return false;
+                SiteDef def;
+                def.types.assign(m_p, m_p + count);
+                m_p += count;
+                if (!Varint(&len) || static_cast<uint64_t>(m_end - m_p) < len) return false;
+                def.format.assign(reinterpret_cast<const char*>(m_p), static_cast<size_t>(len));
+                m_p += len;
+                if (id == 0 || id > (1u << 20)) return false;
+                if (m_sites.size() <= id) m_sites.resize(static_cast<size_t>(id) + 1);
+                m_sites[static_cast<size_t>(id)] = std::move(def);
+                return true;
+            }
+            case LogFormat::kRecordClock: {
+                uint64_t ticks, wall;
+                if (!Varint(&ticks) || !Varint(&wall)) return false;
+                m_clock.push_back(ClockSample{ ticks, LogFormat::UnZigZag(wall) });
+                // The first sample of a file is also the base for tick deltas
+                if (m_clock.size() == 1) m_lastTicks = ticks;
+                return true;
+            }
+            case LogFormat::kRecordDropped: {
+                uint64_t count;
+                if (!Varint(&count)) return false;
+                char buf[96];
+                std::snprintf(buf, sizeof(buf), "[FPS] Logger dropped %llu message(s)", static_cast<unsigned long long>(count));
+                m_lines.push_back(Line{ m_lastTicks, buf });
+                return true;
+            }
+            default:
+                return false;
+            }
+        }
+
+        bool ReadEntry(uint64_t id) {
+            if (id == 0 || id >= m_sites.size() || m_sites[static_cast<size_t>(id)].format.empty()) return false;
+            const SiteDef& site = m_sites[static_cast<size_t>(id)];
+
+            uint64_t delta;
+            if (!Varint(&delta)) return false;
+            uint64_t ticks = m_lastTicks + static_cast<uint64_t>(LogFormat::UnZigZag(delta));
+
+            std::vector<LogFormat::Arg> args(site.types.size());
+            for (size_t i = 0; i < site.types.size(); i++) {
+                LogFormat::Arg& arg = args[i];
+                arg = LogFormat::Arg{ site.types[i], 0, nullptr, 0 };
+                if (arg.type == LogFormat::kArgDouble) {
+                    if (m_end - m_p < 8) return false;
+                    std::memcpy(&arg.bits, m_p, sizeof(arg.bits));
+                    m_p += sizeof(arg.bits);
+                } else if (arg.type == LogFormat::kArgString) {
+                    uint64_t len;
+                    if (!Varint(&len) || static_cast<uint64_t>(m_end - m_p) < len) return false;
+                    arg.str = reinterpret_cast<const char*>(m_p);
+                    arg.len = static_cast<size_t>(len);
+                    m_p += len;
+                } else {
+                    uint64_t v;
+                    if (!Varint(&v)) return false;
+                    arg.bits = arg.type == LogFormat::kArgInt ? static_cast<uint64_t>(LogFormat::UnZigZag(v)) : v;
+                }
+            }
+
+            Line line{ ticks, std::string() };
+            LogFormat::Format(line.text, site.format.c_str(), args.data(), args.size());
+            m_lines.push_back(std::move(line));
+            m_lastTicks = ticks;
+            return true;
+        }
+
+        const unsigned char* m_begin;
+        const unsigned char* m_p;
+        const unsigned char* m_end;
+        std::vector<SiteDef> m_sites;
+        std::vector<ClockSample> m_clock;
+        std::vector<Line> m_lines;
+        uint64_t m_lastTicks = 0;
+    };
+
+    bool ReadFile(const char* path, std::vector<unsigned char>& out) {
+        std::FILE* f = std::fopen(path, "rb");
+        if (!f) return false;
+        unsigned char buf[64 * 1024];
+        size_t n;
+        while ((n = std::fread(buf, 1, sizeof(buf), f)) > 0) out.insert(out.end(), buf, buf + n);
+        std::fclose(f);
+        return true;
+    }
+
+    void PrintUsage() {
+        std::printf("Usage:\n");
+        std::printf("  log_decoder <file.blog>... [--sort]\n");
+        std::printf("      Print binary logs as text; --sort orders lines by time instead of\n");
+        std::printf("      by the order the writer drained them.\n");
+    }
+}
+
+int main(int argc, char** argv) {
+    std::vector<const char*> files;
+    bool sort = false;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--sort") == 0) {
+            sort = true;
+        } else if (argv[i][0] == '-') {
+            PrintUsage();
+            return 1;
+        } else {
+            files.push_back(argv[i]);
+        }
+    }
+    if (files.empty()) {
+        PrintUsage();
+        return 1;
+    }
+
+    int result = 0;
+    for (const char* path : files) {
+        std::vector<unsigned char> data;
+        if (!ReadFile(path, data)) {
+            std::fprintf(stderr, "%s: cannot open\n", path);
+            result = 1;
+            continue;
+        }
+
+        Decoder decoder(data.data(), data.size());
+        uint32_t pid = 0;
+        std::string error;
+        if (!decoder.Run(&pid, &error)) {
+            std::fprintf(stderr, "%s: %s\n", path, error.c_str());
+            result = 1;
+            continue;
+        }
+        if (!error.empty()) std::fprintf(stderr, "%s: %s, showing complete records\n", path, error.c_str());
+        if (decoder.ClockSamples() < 2) std::fprintf(stderr, "%s: single clock sample, timestamps are approximate\n", path);
+
+        std::vector<Line>& lines = decoder.Lines();
+        if (sort) {
+            std::stable_sort(lines.begin(), lines.end(), [](const Line& a, const Line& b) {
+                return static_cast<int64_t>(a.ticks - b.ticks) < 0;
+            });
+        }
+
+        if (files.size() > 1) std::printf("== %s (pid %u) ==\n", path, pid);
+        std::string out;
+        for (const Line& line : lines) {
+            out.clear();
+            LogFormat::FormatTimestamp(out, decoder.TicksToUnixNs(line.ticks));
+            out += line.text;
+            out.push_back('\n');
+            std::fwrite(out.data(), 1, out.size(), stdout);
+        }
+    }
+    return result;
+}
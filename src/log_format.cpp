@@ -0,0 +1,120 @@
+#include "log_format.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+
+namespace LogFormat {
+    void Format(std::string& out, const char* format, const Arg* args, size_t count) {
+        char spec[32];
+        char buf[128];
+        size_t next = 0;
+        const char* f = format;
+        while (*f) {
+            if (*f != '%') {
+                const char* start = f;
+                while (*f && *f != '%') f++;
+                out.append(start, static_cast<size_t>(f - start));
+                continue;
+            }
+            if (f[1] == '%') {
+                out.push_back('%');
+                f += 2;
+                continue;
+            }
+
+            // %[flags][width][.precision][length]conversion
+            size_t n = 0;
+            spec[n++] = *f++;
+            while (*f && std::strchr("-+ #0", *f) && n < 16) spec[n++] = *f++;
+            while (*f && ((*f >= '0' && *f <= '9') || *f == '.') && n < 24) spec[n++] = *f++;
+            while (*f && std::strchr("hlLqjzt", *f)) f++;
+            char conv = *f ? *f++ : 's';
+
+            if (next >= count) {
+                out.append("<?>");
+                continue;
+            }
+            const Arg& arg = args[next++];
+            uint64_t bits = arg.bits;
+
+            int written = 0;
+            if (arg.type == kArgString) {
+                // Packed strings are not NUL terminated: pass the length as precision
+                size_t len = arg.len;
+                spec[n] = '\0';
+                char* dot = std::strchr(spec, '.');
+                if (dot) {
+                    size_t precision = static_cast<size_t>(std::strtoul(dot + 1, nullptr, 10));
+                    if (precision < len) len = precision;
+                    n = static_cast<size_t>(dot - spec);
+                }
+                spec[n++] = '.';
+                spec[n++] = '*';
+                spec[n++] = 's';
+                spec[n] = '\0';
+                written = std::snprintf(buf, sizeof(buf), spec, static_cast<int>(len), arg.str);
+                if (written >= static_cast<int>(sizeof(buf))) {
+                    out.append(arg.str, len);   // Long strings bypass the scratch buffer
+                    continue;
+                }
+            } else if (conv == 's') {
+                written = std::snprintf(buf, sizeof(buf), "%llu", static_cast<unsigned long long>(bits));
+            } else if (std::strchr("fFeEgGaA", conv)) {
+                double d;
+                if (arg.type == kArgDouble) std::memcpy(&d, &bits, sizeof(d));
+                else if (arg.type == kArgInt) d = static_cast<double>(static_cast<int64_t>(bits));
+                else d = static_cast<double>(bits);
+                spec[n++] = conv;
+                spec[n] = '\0';
+                written = std::snprintf(buf, sizeof(buf), spec, d);
+            } else if (conv == 'p') {
+                spec[n++] = 'p';
+                spec[n] = '\0';
+                written = std::snprintf(buf, sizeof(buf), spec, reinterpret_cast<void*>(static_cast<uintptr_t>(bits)));
+            } else if (conv == 'c') {
+                spec[n++] = 'c';
+                spec[n] = '\0';
+                written = std::snprintf(buf, sizeof(buf), spec, static_cast<int>(bits));
+            } else {
+                if (arg.type == kArgDouble) {
+                    double d;
+                    std::memcpy(&d, &bits, sizeof(d));
+                    bits = static_cast<uint64_t>(static_cast<int64_t>(d));
+                } else if (arg.type == kArgInt && conv != 'd' && conv != 'i') {
+                    // Negative 32-bit values (HRESULTs) print as printf would print an int
+                    int64_t v = static_cast<int64_t>(bits);
+                    if (v < 0 && v >= INT32_MIN) bits = static_cast<uint32_t>(v);
+                }
+                spec[n++] = 'l';
+                spec[n++] = 'l';
+                spec[n++] = (conv == 'i') ? 'd' : conv;
+                spec[n] = '\0';
+                if (conv == 'd' || conv == 'i') {
+                    written = std::snprintf(buf, sizeof(buf), spec, static_cast<long long>(bits));
+                } else {
+                    written = std::snprintf(buf, sizeof(buf), spec, static_cast<unsigned long long>(bits));
+                }
+            }
+            if (written > 0) {
+                out.append(buf, static_cast<size_t>(written) < sizeof(buf) ? static_cast<size_t>(written) : sizeof(buf) - 1);
+            }
+        }
+    }
+
+    void FormatTimestamp(std::string& out, int64_t unixNs) {
+        int64_t ms = unixNs / 1000000;
+        std::time_t wall = static_cast<std::time_t>(ms / 1000);
+
+        std::tm tm = {};
+#ifdef _WIN32
+        localtime_s(&tm, &wall);
+#else
+        localtime_r(&wall, &tm);
+#endif
+        char buf[40];
+        size_t n = std::strftime(buf, sizeof(buf), "[%Y-%m-%d %H:%M:%S", &tm);
+        n += static_cast<size_t>(std::snprintf(buf + n, sizeof(buf) - n, ".%03d] ", static_cast<int>(ms % 1000)));
+        out.append(buf, n);
+    }
+}
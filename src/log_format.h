@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Shared by the logger (text output) and log_decoder (binary logs).
+//
+// Binary log (*.blog) layout: FileHeader, then a stream of records. Every
+// record starts with a varint v:
+//   v even -> log entry: site id = v >> 1, then zigzag varint tick delta from
+//             the previous entry, then the site's arguments
+//   v odd  -> control record of kind v >> 1 (site definition, clock sample,
+//             drop count)
+// Arguments: ints as zigzag/plain varints, doubles as 8 raw bytes, pointers
+// as varints, strings as varint length + bytes. A site is defined in the file
+// before its first entry, so every file decodes on its own.
+namespace LogFormat {
+    enum ArgType : uint8_t {
+        kArgInt = 1,        // int64_t
+        kArgUInt,           // uint64_t
+        kArgDouble,         // double
+        kArgPointer,        // uint64_t
+        kArgString,         // length + bytes
+    };
+
+    struct Arg {
+        uint8_t type;
+        uint64_t bits;      // Integer/pointer value, or double bit pattern
+        const char* str;    // kArgString: not NUL terminated
+        size_t len;
+    };
+
+    // printf-style formatting driven by the argument types; length modifiers
+    // in the format are ignored. Missing arguments print as "<?>".
+    void Format(std::string& out, const char* format, const Arg* args, size_t count);
+
+    // "[YYYY-mm-dd HH:MM:SS.mmm] " in local time
+    void FormatTimestamp(std::string& out, int64_t unixNs);
+
+    constexpr uint32_t kMagic = 0x474F4C46;    // "FLOG"
+    constexpr uint32_t kVersion = 1;
+
+    struct FileHeader {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t pid;
+        uint32_t reserved;
+    };
+
+    enum RecordKind : uint32_t {
+        kRecordSite = 1,    // varint id, u8 argCount, argCount types, varint len + format
+        kRecordClock,       // varint ticks, zigzag varint unix ns (a tick/wall-clock pair)
+        kRecordDropped,     // varint count of entries lost since the last one
+    };
+
+    inline void PutVarint(std::string& out, uint64_t v) {
+        while (v >= 0x80) {
+            out.push_back(static_cast<char>(v | 0x80));
+            v >>= 7;
+        }
+        out.push_back(static_cast<char>(v));
+    }
+
+    inline bool GetVarint(const unsigned char*& p, const unsigned char* end, uint64_t* v) {
+        uint64_t result = 0;
+        for (unsigned shift = 0; p < end && shift < 64; shift += 7) {
+            unsigned char c = *p++;
+            result |= static_cast<uint64_t>(c & 0x7F) << shift;
+            if (!(c & 0x80)) {
+                *v = result;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    inline uint64_t ZigZag(int64_t v) {
+        return (static_cast<uint64_t>(v) << 1) ^ static_cast<uint64_t>(v >> 63);
+    }
+
+    inline int64_t UnZigZag(uint64_t v) {
+        return static_cast<int64_t>(v >> 1) ^ -static_cast<int64_t>(v & 1);
+    }
+}
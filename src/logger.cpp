@@ -0,0 +1,582 @@
+#include "logger.h"
+#include "module_thread.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace Logger {
+    namespace {
+        constexpr size_t kRingSize = 64 * 1024;     // Per thread, power of two
+        constexpr size_t kMaxRings = 64;
+        constexpr size_t kMaxSites = 4096;
+        constexpr size_t kBatchSize = 64 * 1024;
+        constexpr int kIdleSleepMs = 20;
+        constexpr int64_t kClockIntervalNs = 1000000000;   // Binary mode clock samples while busy
+        constexpr int64_t kClockSettleNs = 10000000;       // ...and once a burst has settled
+
+        using SteadyClock = std::chrono::steady_clock;
+
+        // Ring entry: header + packed args, padded to 8 bytes
+        struct EntryHeader {
+            uint32_t size;          // Whole entry; kWrapMarker = skip to ring start
+            uint32_t site;
+            uint64_t ticks;         // Detail::Ticks()
+        };
+        constexpr uint32_t kWrapMarker = 0xFFFFFFFFu;
+
+        // Single-producer (owning thread) / single-consumer (writer thread)
+        struct Ring {
+            std::atomic<uint64_t> head{0};      // Written by producer
+            std::atomic<uint64_t> tail{0};      // Written by consumer
+            std::atomic<bool> owned{false};
+            uint64_t reserveHead = 0;           // Producer-local
+            uint32_t reserveSize = 0;
+            unsigned char data[kRingSize];
+        };
+
+        struct RingOwner {
+            Ring* ring = nullptr;
+            ~RingOwner() {
+                // Ring stays registered; the writer drains it and another thread may claim it
+                if (ring) ring->owned.store(false, std::memory_order_release);
+            }
+        };
+
+        struct SiteInfo {
+            const char* format;
+            const uint8_t* types;
+            size_t count;
+        };
+
+        Ring* s_rings[kMaxRings] = {};
+        std::atomic<size_t> s_ringCount{0};
+        SiteInfo s_sites[kMaxSites] = {};       // Index = site id - 1; written before the id is published
+        size_t s_siteCount = 0;
+        std::mutex s_registerMutex;             // Only taken on a thread's or a site's first log
+        std::atomic<uint64_t> s_dropped{0};
+        thread_local RingOwner t_owner;
+
+        std::mutex s_writerMutex;               // Writer thread vs. Shutdown drain
+        std::atomic<bool> s_running{false};
+        std::atomic<bool> s_stop{false};
+        std::atomic<bool> s_writerExited{true};
+        Mode s_mode = Mode::Text;
+        std::FILE* s_file = nullptr;
+        bool s_fileFailed = false;
+        std::string s_path;
+        size_t s_fileSize = 0;
+        size_t s_maxFileSize = 4 * 1024 * 1024;
+        uint64_t s_reportedDropped = 0;
+
+        // Binary mode per-file state
+        std::vector<bool> s_siteWritten;
+        uint64_t s_lastTicks = 0;
+        int64_t s_lastClockNs = 0;
+        bool s_clockPending = false;
+
+        // Tick -> wall clock conversion. The tick rate is measured against
+        // SteadyClock from Initialize onwards by the writer thread.
+        uint64_t s_anchorTicks = 0;
+        SteadyClock::time_point s_anchorSteady;
+        int64_t s_anchorWallNs = 0;
+        double s_ticksPerNs = 0.0;
+
+        size_t Align8(size_t n) {
+            return (n + 7) & ~static_cast<size_t>(7);
+        }
+
+        int64_t NowSteadyNs() {
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(SteadyClock::now() - s_anchorSteady).count();
+        }
+
+        // One code point from UTF-16 (Windows) or UTF-32 code units
+        uint32_t NextCodePoint(const wchar_t* s, size_t count, size_t& i) {
+            uint32_t c = static_cast<uint32_t>(s[i++]);
+            if (sizeof(wchar_t) == 2 && c >= 0xD800 && c <= 0xDBFF && i < count) {
+                uint32_t low = static_cast<uint32_t>(s[i]);
+                if (low >= 0xDC00 && low <= 0xDFFF) {
+                    i++;
+                    return 0x10000 + ((c - 0xD800) << 10) + (low - 0xDC00);
+                }
+            }
+            return (c >= 0xD800 && c <= 0xDFFF) || c > 0x10FFFF ? 0xFFFD : c;
+        }
+
+        size_t Utf8Size(uint32_t cp) {
+            return cp < 0x80 ? 1 : cp < 0x800 ? 2 : cp < 0x10000 ? 3 : 4;
+        }
+
+        Ring* AcquireRing() {
+            std::lock_guard<std::mutex> lock(s_registerMutex);
+
+            // Reuse a ring left behind by an exited thread once it has been drained
+            size_t count = s_ringCount.load(std::memory_order_acquire);
+            for (size_t i = 0; i < count; i++) {
+                Ring* ring = s_rings[i];
+                bool expected = false;
+                if (ring->head.load(std::memory_order_acquire) == ring->tail.load(std::memory_order_acquire) &&
+                    ring->owned.compare_exchange_strong(expected, true)) {
+                    ring->reserveHead = ring->head.load(std::memory_order_relaxed);
+                    return ring;
+                }
+            }
+            if (count >= kMaxRings) return nullptr;
+
+            Ring* ring = new Ring();
+            ring->owned.store(true, std::memory_order_relaxed);
+            s_rings[count] = ring;
+            s_ringCount.store(count + 1, std::memory_order_release);
+            return ring;
+        }
+    }
+
+    namespace Detail {
+        uint32_t RegisterSite(Site& site, const uint8_t* types, size_t count) {
+            std::lock_guard<std::mutex> lock(s_registerMutex);
+            uint32_t id = site.id.load(std::memory_order_relaxed);
+            if (id) return id;
+            if (s_siteCount >= kMaxSites) {
+                s_dropped.fetch_add(1, std::memory_order_relaxed);
+                return 0;
+            }
+
+            s_sites[s_siteCount] = SiteInfo{ site.format, types, count };
+            id = static_cast<uint32_t>(++s_siteCount);
+            site.id.store(id, std::memory_order_release);
+            return id;
+        }
+
+        size_t WideArgLength(const wchar_t* s, size_t count) {
+            size_t bytes = 0;
+            for (size_t i = 0; i < count;) {
+                size_t n = Utf8Size(NextCodePoint(s, count, i));
+                if (bytes + n > kMaxStringArg) break;
+                bytes += n;
+            }
+            return bytes;
+        }
+
+        unsigned char* PackWideArg(unsigned char* p, const wchar_t* s, size_t count, size_t bytes) {
+            uint16_t len = static_cast<uint16_t>(bytes);
+            std::memcpy(p, &len, sizeof(len));
+            p += sizeof(len);
+            unsigned char* end = p + bytes;
+            for (size_t i = 0; i < count && p < end;) {
+                uint32_t cp = NextCodePoint(s, count, i);
+                if (cp < 0x80) {
+                    *p++ = static_cast<unsigned char>(cp);
+                } else if (cp < 0x800) {
+                    *p++ = static_cast<unsigned char>(0xC0 | (cp >> 6));
+                    *p++ = static_cast<unsigned char>(0x80 | (cp & 0x3F));
+                } else if (cp < 0x10000) {
+                    *p++ = static_cast<unsigned char>(0xE0 | (cp >> 12));
+                    *p++ = static_cast<unsigned char>(0x80 | ((cp >> 6) & 0x3F));
+                    *p++ = static_cast<unsigned char>(0x80 | (cp & 0x3F));
+                } else {
+                    *p++ = static_cast<unsigned char>(0xF0 | (cp >> 18));
+                    *p++ = static_cast<unsigned char>(0x80 | ((cp >> 12) & 0x3F));
+                    *p++ = static_cast<unsigned char>(0x80 | ((cp >> 6) & 0x3F));
+                    *p++ = static_cast<unsigned char>(0x80 | (cp & 0x3F));
+                }
+            }
+            return end;
+        }
+
+        unsigned char* Reserve(size_t payloadSize) {
+            Ring* ring = t_owner.ring;
+            if (!ring) {
+                ring = AcquireRing();
+                if (!ring) {
+                    s_dropped.fetch_add(1, std::memory_order_relaxed);
+                    return nullptr;
+                }
+                t_owner.ring = ring;
+            }
+
+            size_t size = Align8(sizeof(EntryHeader) + payloadSize);
+            uint64_t head = ring->head.load(std::memory_order_relaxed);
+            uint64_t tail = ring->tail.load(std::memory_order_acquire);
+            size_t offset = static_cast<size_t>(head & (kRingSize - 1));
+
+            // Entries never straddle the end; the tail of the buffer is skipped instead
+            size_t skip = offset + size > kRingSize ? kRingSize - offset : 0;
+            if (size > kRingSize / 2 || head + skip + size - tail > kRingSize) {
+                s_dropped.fetch_add(1, std::memory_order_relaxed);
+                return nullptr;
+            }
+
+            if (skip) {
+                uint32_t marker = kWrapMarker;
+                std::memcpy(ring->data + offset, &marker, sizeof(marker));
+                head += skip;
+                offset = 0;
+            }
+            ring->reserveHead = head;
+            ring->reserveSize = static_cast<uint32_t>(size);
+            return ring->data + offset + sizeof(EntryHeader);
+        }
+
+        void Commit(uint32_t siteId, uint64_t ticks) {
+            Ring* ring = t_owner.ring;
+            uint64_t head = ring->reserveHead;
+
+            EntryHeader header;
+            header.size = ring->reserveSize;
+            header.site = siteId;
+            header.ticks = ticks;
+            std::memcpy(ring->data + (head & (kRingSize - 1)), &header, sizeof(header));
+
+            ring->head.store(head + header.size, std::memory_order_release);
+        }
+    }
+
+    namespace {
+        // Unpacks ring arguments using the site's registered types
+        size_t ReadArgs(const SiteInfo& site, const unsigned char* p, LogFormat::Arg* args) {
+            for (size_t i = 0; i < site.count; i++) {
+                LogFormat::Arg& arg = args[i];
+                arg.type = site.types[i];
+                if (arg.type == LogFormat::kArgString) {
+                    uint16_t n;
+                    std::memcpy(&n, p, sizeof(n));
+                    arg.str = reinterpret_cast<const char*>(p + sizeof(n));
+                    arg.len = n;
+                    p += sizeof(n) + n;
+                } else {
+                    std::memcpy(&arg.bits, p, sizeof(arg.bits));
+                    p += sizeof(arg.bits);
+                }
+            }
+            return site.count;
+        }
+
+        void UpdateTickRate() {
+            int64_t elapsedNs = NowSteadyNs();
+            uint64_t ticks = Detail::Ticks();
+            if (elapsedNs >= 1000000) {
+                s_ticksPerNs = static_cast<double>(ticks - s_anchorTicks) / static_cast<double>(elapsedNs);
+            }
+        }
+
+        int64_t TicksToUnixNs(uint64_t ticks) {
+            if (s_ticksPerNs <= 0.0) return s_anchorWallNs;
+            int64_t delta = static_cast<int64_t>(ticks - s_anchorTicks);
+            return s_anchorWallNs + static_cast<int64_t>(static_cast<double>(delta) / s_ticksPerNs);
+        }
+
+        void CreateParentDirectory(const std::string& path) {
+            size_t lastSlash = path.find_last_of("\\/");
+            if (lastSlash == std::string::npos || lastSlash == 0) return;
+            std::string dir = path.substr(0, lastSlash);
+#ifdef _WIN32
+            CreateDirectoryA(dir.c_str(), nullptr);
+#else
+            mkdir(dir.c_str(), 0755);
+#endif
+        }
+
+        void KeepPrevious() {
+            std::string previous = s_path + ".1";
+            std::remove(previous.c_str());
+            std::rename(s_path.c_str(), previous.c_str());
+        }
+
+        // Binary files restate the clock and every site they use, so each one
+        // (including a rotated .1) decodes on its own
+        void BeginBinaryFile(std::string& batch) {
+            LogFormat::FileHeader header = {};
+            header.magic = LogFormat::kMagic;
+            header.version = LogFormat::kVersion;
+#ifdef _WIN32
+            header.pid = GetCurrentProcessId();
+#else
+            header.pid = static_cast<uint32_t>(getpid());
+#endif
+            batch.append(reinterpret_cast<const char*>(&header), sizeof(header));
+
+            s_siteWritten.assign(kMaxSites + 1, false);
+            s_clockPending = false;
+            s_lastTicks = Detail::Ticks();
+            s_lastClockNs = NowSteadyNs();
+            LogFormat::PutVarint(batch, (LogFormat::kRecordClock << 1) | 1);
+            LogFormat::PutVarint(batch, s_lastTicks);
+            LogFormat::PutVarint(batch, LogFormat::ZigZag(s_anchorWallNs + s_lastClockNs));
+        }
+
+        bool OpenFile(std::string& batch) {
+            if (s_file) return true;
+            if (s_fileFailed || s_path.empty()) return false;
+
+            CreateParentDirectory(s_path);
+            if (s_mode == Mode::Binary) {
+                // One session per file: the previous run is kept as .1
+                KeepPrevious();
+                s_file = std::fopen(s_path.c_str(), "wb");
+                s_fileSize = 0;
+            } else {
+                s_file = std::fopen(s_path.c_str(), "ab");
+                if (s_file) {
+                    std::fseek(s_file, 0, SEEK_END);
+                    long size = std::ftell(s_file);
+                    s_fileSize = size > 0 ? static_cast<size_t>(size) : 0;
+                }
+            }
+            if (!s_file) {
+                s_fileFailed = true;
+                return false;
+            }
+
+            if (s_mode == Mode::Binary) {
+                std::string prologue;
+                BeginBinaryFile(prologue);
+                batch.insert(0, prologue);
+            }
+            return true;
+        }
+
+        void WriteBatch(const std::string& batch) {
+            if (batch.empty()) return;
+#ifdef _WIN32
+            if (s_mode == Mode::Text) OutputDebugStringA(batch.c_str());
+#endif
+            if (!s_file) return;
+            std::fwrite(batch.data(), 1, batch.size(), s_file);
+            std::fflush(s_file);
+            s_fileSize += batch.size();
+        }
+
+        void RotateIfFull(std::string& batch) {
+            if (!s_file || s_fileSize + batch.size() <= s_maxFileSize) return;
+
+            WriteBatch(batch);
+            batch.clear();
+            std::fclose(s_file);
+            KeepPrevious();
+            s_file = std::fopen(s_path.c_str(), s_mode == Mode::Binary ? "wb" : "ab");
+            s_fileSize = 0;
+            if (s_file && s_mode == Mode::Binary) BeginBinaryFile(batch);
+        }
+
+        void AppendText(std::string& batch, const SiteInfo& site, uint64_t ticks, const unsigned char* payload) {
+            LogFormat::Arg args[64];
+            size_t count = site.count < 64 ? ReadArgs(site, payload, args) : 0;
+            LogFormat::FormatTimestamp(batch, TicksToUnixNs(ticks));
+            LogFormat::Format(batch, site.format, args, count);
+            batch.push_back('\n');
+        }
+
+        void AppendBinary(std::string& batch, uint32_t id, const SiteInfo& site, uint64_t ticks, const unsigned char* p) {
+            if (!s_siteWritten[id]) {
+                LogFormat::PutVarint(batch, (LogFormat::kRecordSite << 1) | 1);
+                LogFormat::PutVarint(batch, id);
+                batch.push_back(static_cast<char>(site.count));
+                batch.append(reinterpret_cast<const char*>(site.types), site.count);
+                size_t len = std::strlen(site.format);
+                LogFormat::PutVarint(batch, len);
+                batch.append(site.format, len);
+                s_siteWritten[id] = true;
+            }
+
+            LogFormat::PutVarint(batch, static_cast<uint64_t>(id) << 1);
+            LogFormat::PutVarint(batch, LogFormat::ZigZag(static_cast<int64_t>(ticks - s_lastTicks)));
+            s_lastTicks = ticks;
+
+            for (size_t i = 0; i < site.count; i++) {
+                uint8_t type = site.types[i];
+                if (type == LogFormat::kArgString) {
+                    uint16_t n;
+                    std::memcpy(&n, p, sizeof(n));
+                    LogFormat::PutVarint(batch, n);
+                    batch.append(reinterpret_cast<const char*>(p + sizeof(n)), n);
+                    p += sizeof(n) + n;
+                    continue;
+                }
+
+                uint64_t bits;
+                std::memcpy(&bits, p, sizeof(bits));
+                p += sizeof(bits);
+                if (type == LogFormat::kArgDouble) {
+                    batch.append(reinterpret_cast<const char*>(&bits), sizeof(bits));
+                } else if (type == LogFormat::kArgInt) {
+                    LogFormat::PutVarint(batch, LogFormat::ZigZag(static_cast<int64_t>(bits)));
+                } else {
+                    LogFormat::PutVarint(batch, bits);
+                }
+            }
+        }
+
+        // Drains every ring once; caller holds s_writerMutex. Returns entries written.
+        size_t DrainRings(std::string& batch) {
+            UpdateTickRate();
+
+            size_t written = 0;
+            size_t count = s_ringCount.load(std::memory_order_acquire);
+            for (size_t i = 0; i < count; i++) {
+                Ring* ring = s_rings[i];
+                uint64_t tail = ring->tail.load(std::memory_order_relaxed);
+                uint64_t head = ring->head.load(std::memory_order_acquire);
+                if (tail != head && !OpenFile(batch) && s_mode == Mode::Binary) {
+                    // Nowhere to write: discard rather than let producers fill up
+                    ring->tail.store(head, std::memory_order_release);
+                    continue;
+                }
+
+                while (tail != head) {
+                    const unsigned char* entry = ring->data + (tail & (kRingSize - 1));
+                    uint32_t size;
+                    std::memcpy(&size, entry, sizeof(size));
+                    if (size == kWrapMarker) {
+                        tail += kRingSize - (tail & (kRingSize - 1));
+                        continue;
+                    }
+
+                    EntryHeader header;
+                    std::memcpy(&header, entry, sizeof(header));
+                    const SiteInfo& site = s_sites[header.site - 1];
+                    if (s_mode == Mode::Binary) {
+                        AppendBinary(batch, header.site, site, header.ticks, entry + sizeof(EntryHeader));
+                    } else {
+                        AppendText(batch, site, header.ticks, entry + sizeof(EntryHeader));
+                    }
+                    tail += size;
+                    written++;
+
+                    RotateIfFull(batch);
+                    if (batch.size() >= kBatchSize) {
+                        WriteBatch(batch);
+                        batch.clear();
+                    }
+                }
+                ring->tail.store(tail, std::memory_order_release);
+            }
+
+            uint64_t dropped = s_dropped.load(std::memory_order_relaxed);
+            if (dropped != s_reportedDropped && OpenFile(batch)) {
+                uint64_t lost = dropped - s_reportedDropped;
+                if (s_mode == Mode::Binary) {
+                    LogFormat::PutVarint(batch, (LogFormat::kRecordDropped << 1) | 1);
+                    LogFormat::PutVarint(batch, lost);
+                } else {
+                    char buf[96];
+                    int n = std::snprintf(buf, sizeof(buf), "[FPS] Logger dropped %llu message(s)\n",
+                                          static_cast<unsigned long long>(lost));
+                    batch.append(buf, static_cast<size_t>(n));
+                }
+                s_reportedDropped = dropped;
+            }
+
+            // The decoder interpolates between clock samples: one follows every
+            // burst of entries, and busy files get one per second for drift
+            if (s_mode == Mode::Binary && s_file) {
+                s_clockPending |= written > 0;
+                int64_t nowNs = NowSteadyNs();
+                if (s_clockPending && nowNs - s_lastClockNs >= (written > 0 ? kClockIntervalNs : kClockSettleNs)) {
+                    LogFormat::PutVarint(batch, (LogFormat::kRecordClock << 1) | 1);
+                    LogFormat::PutVarint(batch, Detail::Ticks());
+                    LogFormat::PutVarint(batch, LogFormat::ZigZag(s_anchorWallNs + nowNs));
+                    s_lastClockNs = nowNs;
+                    s_clockPending = false;
+                }
+            }
+
+            WriteBatch(batch);
+            batch.clear();
+            return written;
+        }
+
+        void WriterThread() {
+            std::string batch;
+            batch.reserve(kBatchSize + 1024);
+            while (!s_stop.load(std::memory_order_acquire)) {
+                size_t written;
+                {
+                    std::lock_guard<std::mutex> lock(s_writerMutex);
+                    if (s_stop.load(std::memory_order_acquire)) break;
+                    written = DrainRings(batch);
+                }
+                if (written == 0) {
+                    std::this_thread::sleep_for(std::chrono::milliseconds(kIdleSleepMs));
+                }
+            }
+            s_writerExited.store(true, std::memory_order_release);
+        }
+
+        std::string ModuleDirectory() {
+#ifdef _WIN32
+            char path[MAX_PATH] = {0};
+            GetModuleFileNameA(nullptr, path, MAX_PATH);
+            std::string dir(path);
+            size_t lastSlash = dir.find_last_of("\\/");
+            return lastSlash != std::string::npos ? dir.substr(0, lastSlash + 1) : std::string();
+#else
+            return std::string();
+#endif
+        }
+    }
+
+    void InitializePath(const char* path, Mode mode) {
+        if (s_running.exchange(true)) return;
+
+        s_anchorTicks = Detail::Ticks();
+        s_anchorSteady = SteadyClock::now();
+        s_anchorWallNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+        s_ticksPerNs = 0.0;
+
+        s_mode = mode;
+        s_path = path;
+        s_fileFailed = false;
+
+        s_stop.store(false, std::memory_order_release);
+        s_writerExited.store(false, std::memory_order_release);
+        if (!ModuleThread::Start([](void*) { WriterThread(); }, nullptr)) {
+            s_writerExited.store(true, std::memory_order_release);
+        }
+    }
+
+    void Initialize(const char* filename, Mode mode) {
+        InitializePath((ModuleDirectory() + filename).c_str(), mode);
+    }
+
+    void Shutdown() {
+        if (!s_running.exchange(false)) return;
+        s_stop.store(true, std::memory_order_release);
+
+        // Lets the writer finish its batch before the final drain. It keeps the
+        // module loaded until it has exited, and at process exit it has already
+        // been terminated, so the wait is bounded and only about ordering.
+        for (int i = 0; i < 100 && !s_writerExited.load(std::memory_order_acquire); i++) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+
+        // A terminated writer may have died holding the mutex: never block on it
+        if (s_writerMutex.try_lock()) {
+            std::string batch;
+            DrainRings(batch);
+            if (s_file) {
+                std::fclose(s_file);
+                s_file = nullptr;
+            }
+            s_writerMutex.unlock();
+        }
+    }
+
+    void SetMaxFileSize(size_t bytes) {
+        s_maxFileSize = bytes < 64 * 1024 ? 64 * 1024 : bytes;
+    }
+
+    uint64_t DroppedCount() {
+        return s_dropped.load(std::memory_order_relaxed);
+    }
+}
@@ -1,59 +1,189 @@
 #pragma once
-#include <Windows.h>
-#include <fstream>
-#include <cstdarg>
-#include <ctime>
+#include "log_format.h"
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <cwchar>
+#include <string>
+#include <type_traits>
 
+#if defined(_M_X64) || defined(_M_IX86)
+#include <intrin.h>
+#define LOGGER_HAS_RDTSC 1
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define LOGGER_HAS_RDTSC 1
+#endif
+
+// Asynchronous logger.
+//
+// Every LOG/LOG_ERROR call site owns a static Site. Its format string and
+// argument types are registered once, on first use; after that a call only
+// copies the site id, a raw timestamp and the arguments into a lock-free ring
+// owned by the calling thread. A background thread drains all rings and
+// either formats text (file + OutputDebugString) or, in binary mode, writes
+// compact records that log_decoder turns back into text. Both modes write in
+// batches with size-based rotation. A caller never takes a lock, never
+// formats and never waits on I/O; when its ring is full the entry is dropped
+// and counted instead.
 namespace Logger {
-    inline std::ofstream g_file;
-    inline bool g_initialized = false;
-
-    inline void Initialize(const char* filename = "fps_overlay.log") {
-        if (g_initialized) return;
-        
-        char path[MAX_PATH];
-        GetModuleFileNameA(nullptr, path, MAX_PATH);
-        
-        std::string fullPath(path);
-        size_t lastSlash = fullPath.find_last_of("\\/");
-        if (lastSlash != std::string::npos) {
-            fullPath = fullPath.substr(0, lastSlash + 1);
+    enum class Mode {
+        Text,       // Formatted lines
+        Binary,     // Deferred formatting, *.blog (see log_format.h)
+    };
+
+    constexpr size_t kMaxStringArg = 512;
+
+    struct Site {
+        const char* format;
+        std::atomic<uint32_t> id;   // 0 until registered
+
+        constexpr explicit Site(const char* f) : format(f), id(0) {}
+    };
+
+    // filename is relative to the host executable's directory
+    void Initialize(const char* filename = "fps_overlay.log", Mode mode = Mode::Text);
+    // Absolute path; the file (and its directory) is created on the first write
+    void InitializePath(const char* path, Mode mode);
+    void Shutdown();
+
+    // Rotation threshold; the previous file is kept as <name>.1
+    void SetMaxFileSize(size_t bytes);
+
+    // Number of entries dropped because a thread's ring was full
+    uint64_t DroppedCount();
+
+    namespace Detail {
+        uint32_t RegisterSite(Site& site, const uint8_t* types, size_t count);
+
+        // Reserves space for one entry in the calling thread's ring; nullptr if full
+        unsigned char* Reserve(size_t payloadSize);
+        void Commit(uint32_t siteId, uint64_t ticks);
+
+        inline uint64_t Ticks() {
+#ifdef LOGGER_HAS_RDTSC
+            return __rdtsc();
+#else
+            return static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
         }
-        fullPath += filename;
-        
-        g_file.open(fullPath, std::ios::app);
-        g_initialized = true;
-    }
 
-    inline void Log(const char* format, ...) {
-        time_t now = time(nullptr);
-        char timeStr[32];
-        strftime(timeStr, sizeof(timeStr), "[%Y-%m-%d %H:%M:%S]", localtime(&now));
-        
-        char buffer[1024];
-        va_list args;
-        va_start(args, format);
-        vsnprintf(buffer, sizeof(buffer), format, args);
-        va_end(args);
-        
-        OutputDebugStringA(timeStr);
-        OutputDebugStringA(" ");
-        OutputDebugStringA(buffer);
-        OutputDebugStringA("\n");
-        
-        if (g_file.is_open()) {
-            g_file << timeStr << " " << buffer << std::endl;
-            g_file.flush();
+        template <typename T>
+        struct ArgTraits {
+            using D = typename std::decay<T>::type;
+            static constexpr bool kString = std::is_same<D, const char*>::value || std::is_same<D, char*>::value;
+            static constexpr bool kStdString = std::is_same<D, std::string>::value;
+            static constexpr bool kWideString = std::is_same<D, const wchar_t*>::value || std::is_same<D, wchar_t*>::value;
+            static constexpr bool kStdWideString = std::is_same<D, std::wstring>::value;
+            static constexpr bool kPointer = std::is_pointer<D>::value && !kString && !kWideString;
+            static constexpr bool kFloat = std::is_floating_point<D>::value;
+            static constexpr bool kSigned = (std::is_integral<D>::value && std::is_signed<D>::value) || std::is_enum<D>::value;
+
+            static constexpr uint8_t kType = (kString || kStdString || kWideString || kStdWideString) ? LogFormat::kArgString
+                                           : kPointer ? LogFormat::kArgPointer
+                                           : kFloat ? LogFormat::kArgDouble
+                                           : kSigned ? LogFormat::kArgInt
+                                           : LogFormat::kArgUInt;
+        };
+
+        // Argument types of a call site, fixed at compile time (+1 keeps the array non-empty)
+        template <typename... Args>
+        struct Signature {
+            static constexpr uint8_t kTypes[sizeof...(Args) + 1] = { ArgTraits<Args>::kType..., 0 };
+        };
+
+        inline size_t StringArgLength(const char* s) {
+            if (!s) return 6;   // "(null)"
+            size_t n = std::strlen(s);
+            return n > kMaxStringArg ? kMaxStringArg : n;
+        }
+
+        // Wide strings are stored as UTF-8, cut to at most kMaxStringArg bytes
+        // on a code point boundary; unpaired surrogates become U+FFFD
+        size_t WideArgLength(const wchar_t* s, size_t count);
+        unsigned char* PackWideArg(unsigned char* p, const wchar_t* s, size_t count, size_t bytes);
+
+        template <typename T>
+        inline size_t ArgSize(const T& value) {
+            using Traits = ArgTraits<T>;
+            if constexpr (Traits::kString) {
+                return sizeof(uint16_t) + StringArgLength(static_cast<const char*>(value));
+            } else if constexpr (Traits::kStdString) {
+                return sizeof(uint16_t) + (value.size() > kMaxStringArg ? kMaxStringArg : value.size());
+            } else if constexpr (Traits::kWideString) {
+                const wchar_t* str = value;
+                return sizeof(uint16_t) + (str ? WideArgLength(str, std::wcslen(str)) : StringArgLength(nullptr));
+            } else if constexpr (Traits::kStdWideString) {
+                return sizeof(uint16_t) + WideArgLength(value.data(), value.size());
+            } else {
+                return sizeof(uint64_t);
+            }
+        }
+
+        // Ring layout per argument: 8-byte value, or uint16 length + bytes for strings
+        template <typename T>
+        inline unsigned char* PackArg(unsigned char* p, const T& value) {
+            using Traits = ArgTraits<T>;
+            if constexpr (Traits::kWideString) {
+                const wchar_t* str = value;
+                if (!str) return PackArg(p, static_cast<const char*>(nullptr));
+                size_t count = std::wcslen(str);
+                return PackWideArg(p, str, count, WideArgLength(str, count));
+            } else if constexpr (Traits::kStdWideString) {
+                return PackWideArg(p, value.data(), value.size(), WideArgLength(value.data(), value.size()));
+            } else if constexpr (Traits::kString || Traits::kStdString) {
+                const char* s;
+                size_t n;
+                if constexpr (Traits::kString) {
+                    const char* str = value;   // Also decays char arrays
+                    s = str ? str : "(null)";
+                    n = StringArgLength(str);
+                } else {
+                    s = value.data();
+                    n = value.size() > kMaxStringArg ? kMaxStringArg : value.size();
+                }
+                uint16_t len = static_cast<uint16_t>(n);
+                std::memcpy(p, &len, sizeof(len));
+                std::memcpy(p + sizeof(len), s, n);
+                return p + sizeof(len) + n;
+            } else {
+                uint64_t bits;
+                if constexpr (Traits::kPointer) {
+                    bits = static_cast<uint64_t>(reinterpret_cast<uintptr_t>(value));
+                } else if constexpr (Traits::kFloat) {
+                    double d = static_cast<double>(value);
+                    std::memcpy(&bits, &d, sizeof(bits));
+                } else if constexpr (Traits::kSigned) {
+                    bits = static_cast<uint64_t>(static_cast<int64_t>(value));
+                } else {
+                    bits = static_cast<uint64_t>(value);
+                }
+                std::memcpy(p, &bits, sizeof(bits));
+                return p + sizeof(bits);
+            }
         }
     }
 
-    inline void Shutdown() {
-        if (g_file.is_open()) {
-            g_file.close();
+    template <typename... Args>
+    inline void Log(Site& site, const Args&... args) {
+        static_assert(sizeof...(Args) <= 64, "too many log arguments");
+        uint64_t ticks = Detail::Ticks();
+        uint32_t id = site.id.load(std::memory_order_acquire);
+        if (!id) {
+            id = Detail::RegisterSite(site, Detail::Signature<Args...>::kTypes, sizeof...(Args));
+            if (!id) return;
         }
-        g_initialized = false;
+
+        size_t size = (size_t(0) + ... + Detail::ArgSize(args));
+        unsigned char* p = Detail::Reserve(size);
+        if (!p) return;
+        ((p = Detail::PackArg(p, args)), ...);
+        Detail::Commit(id, ticks);
     }
 }
 
-#define LOG(fmt, ...) Logger::Log("[FPS] " fmt, ##__VA_ARGS__)
-#define LOG_ERROR(fmt, ...) Logger::Log("[FPS ERROR] " fmt, ##__VA_ARGS__)
+// Format strings must be string literals
+#define LOG(fmt, ...) do { static Logger::Site s_logSite("[FPS] " fmt); Logger::Log(s_logSite, ##__VA_ARGS__); } while (0)
+#define LOG_ERROR(fmt, ...) do { static Logger::Site s_logSite("[FPS ERROR] " fmt); Logger::Log(s_logSite, ##__VA_ARGS__); } while (0)
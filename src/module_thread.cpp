@@ -0,0 +1,48 @@
+#include "module_thread.h"
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <thread>
+#endif
+
+namespace ModuleThread {
+#ifdef _WIN32
+    namespace {
+        struct StartInfo {
+            void (*proc)(void*);
+            void* param;
+            HMODULE module;
+        };
+
+        DWORD WINAPI ThreadMain(LPVOID p) {
+            StartInfo info = *static_cast<StartInfo*>(p);
+            delete static_cast<StartInfo*>(p);
+            info.proc(info.param);
+            FreeLibraryAndExitThread(info.module, 0);
+        }
+    }
+
+    bool Start(void (*proc)(void* param), void* param) {
+        HMODULE module = nullptr;
+        if (!GetModuleHandleExW(GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS, reinterpret_cast<LPCWSTR>(&ThreadMain),
+                                &module)) {
+            return false;
+        }
+        StartInfo* info = new StartInfo{ proc, param, module };
+        HANDLE thread = CreateThread(nullptr, 0, ThreadMain, info, 0, nullptr);
+        if (!thread) {
+            delete info;
+            FreeLibrary(module);
+            return false;
+        }
+        CloseHandle(thread);
+        return true;
+    }
+#else
+    bool Start(void (*proc)(void* param), void* param) {
+        std::thread(proc, param).detach();
+        return true;
+    }
+#endif
+}
@@ -0,0 +1,15 @@
+#pragma once
+
+// Detached background threads for code that may live in an injected DLL.
+//
+// On Windows the thread holds its own reference on the module containing
+// this code and leaves through FreeLibraryAndExitThread once proc returns,
+// so a FreeLibrary never unmaps code the thread is still running (its
+// destructors and return path included). Stopping such a thread therefore
+// only needs a signal, never a wait for it to exit, which also keeps it safe
+// under the loader lock. Elsewhere (offline tools, tests) it is a detached
+// std::thread.
+namespace ModuleThread {
+    // False if the thread could not be started; proc is then never called
+    bool Start(void (*proc)(void* param), void* param);
+}
@@ -1,44 +1,53 @@
 #include "overlay.h"
 #include "fps_counter.h"
+#include "file_watcher.h"
 #include "hooks.h"
+#include "ini_file.h"
+#include "overlay_config.h"
 #include "imgui.h"
 #include "imgui_impl_win32.h"
 #include "imgui_impl_dx11.h"
+#include <atomic>
 #include <cstdio>
 #include <cstddef>
-#include <cwctype>
 #include <cwchar>
+#include <cmath>
+#include <mutex>
 
 extern IMGUI_IMPL_API LRESULT ImGui_ImplWin32_WndProcHandler(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam);
 
 namespace Overlay {
-    enum class PositionMode {
-        Corner,
-        Custom,
-    };
+    // One parsed overlay.ini (see overlay_config.h). Immutable once published:
+    // the watcher thread builds a new one per change and the render thread
+    // swaps it in.
+    using Config = OverlayConfig;
 
     static HWND s_hWnd = nullptr;
     static WNDPROC s_originalWndProc = nullptr;
-    static bool s_showOverlay = true;
-    static PositionMode s_positionMode = PositionMode::Corner;
-    static int s_corner = 1;
-    static float s_marginX = 8.0f;
-    static float s_marginY = 8.0f;
-    static float s_posX = 0.0f;
-    static float s_posY = 0.0f;
-    static float s_alpha = 0.25f;
-    static int s_toggleKey = VK_F1;
-    static bool s_showFps = true;
-    static bool s_showFrameTime = true;
-    static float s_greenThreshold = 60.0f;
-    static float s_yellowThreshold = 30.0f;
-    static float s_fontScale = 1.0f;
+
+    // Render thread only: the snapshot in use
+    static const Config s_defaultConfig;
+    static const Config* s_config = &s_defaultConfig;
+
+    // Publisher -> render thread hand-off. Render checks it with one acquire
+    // load per frame and takes ownership with an exchange; a snapshot replaced
+    // before render picked it up is freed by the publisher.
+    static std::atomic<Config*> s_pendingConfig{nullptr};
+
+    // Newest published values: base for the next parse (missing keys keep
+    // their value) and for the runtime setters
+    static std::mutex s_publishMutex;
+    static Config s_latestConfig;
+
+    // Read outside Render (WndProc, Hooks::Shutdown)
+    static std::atomic<bool> s_showOverlay{true};
+    static std::atomic<int> s_toggleKey{VK_F1};
+    static std::atomic<bool> s_captureEnabled{false};
+    static std::atomic<bool> s_sessionSketchEnabled{true};
 
     static bool s_configPathReady = false;
     static wchar_t s_configPath[MAX_PATH] = {0};
-    static FILETIME s_configWriteTime = {0};
-    static ULONGLONG s_lastConfigCheckTick = 0;
-    static bool s_configLoaded = false;
+    static FileWatcher s_configWatcher;
 
     static float Clamp01(float value) {
         if (value < 0.0f) return 0.0f;
@@ -46,25 +55,6 @@ namespace Overlay {
         return value;
     }
 
-    static float ClampNonNegative(float value) {
-        return value < 0.0f ? 0.0f : value;
-    }
-
-    static float ClampRange(float value, float minValue, float maxValue) {
-        if (value < minValue) return minValue;
-        if (value > maxValue) return maxValue;
-        return value;
-    }
-
-    static bool TryGetFileWriteTime(const wchar_t* path, FILETIME* out) {
-        WIN32_FILE_ATTRIBUTE_DATA data;
-        if (!GetFileAttributesExW(path, GetFileExInfoStandard, &data)) {
-            return false;
-        }
-        *out = data.ftLastWriteTime;
-        return true;
-    }
-
     static void InitConfigPath() {
         if (s_configPathReady) return;
         if (!Hooks::g_hModule) return;
@@ -83,148 +73,102 @@ namespace Overlay {
         s_configPathReady = true;
     }
 
-    static bool TryParseFloat(const wchar_t* text, float* out) {
-        if (!text || !out) return false;
-        wchar_t* end = nullptr;
-        float v = wcstof(text, &end);
-        if (end == text) return false;
-        *out = v;
-        return true;
-    }
-
-    static float ReadIniFloat(const wchar_t* section, const wchar_t* key, float def) {
-        wchar_t defBuf[32];
-        swprintf_s(defBuf, L"%.3f", def);
-
-        wchar_t buf[64];
-        GetPrivateProfileStringW(section, key, defBuf, buf, static_cast<DWORD>(sizeof(buf) / sizeof(buf[0])), s_configPath);
+    static void ParseConfig(const IniFile& ini, Config& cfg) {
+        ConfigSchema::Apply(kOverlayConfigSchema, ini, &cfg);
 
-        float v = def;
-        if (TryParseFloat(buf, &v)) return v;
-        return def;
+        // Cross-field rule the schema cannot express
+        if (cfg.greenThreshold < cfg.yellowThreshold) {
+            float tmp = cfg.greenThreshold;
+            cfg.greenThreshold = cfg.yellowThreshold;
+            cfg.yellowThreshold = tmp;
+        }
     }
 
-    static int ParseCorner(const wchar_t* text) {
-        if (!text) return -1;
-        while (*text && iswspace(*text)) text++;
-        if (!*text) return -1;
-
-        if (_wcsicmp(text, L"Custom") == 0) return 4;
-        if (_wcsicmp(text, L"TopLeft") == 0) return 0;
-        if (_wcsicmp(text, L"TopRight") == 0) return 1;
-        if (_wcsicmp(text, L"BottomLeft") == 0) return 2;
-        if (_wcsicmp(text, L"BottomRight") == 0) return 3;
+    // Caller holds s_publishMutex
+    static void Publish(const Config& config) {
+        Config* snapshot = new Config(config);
+        delete s_pendingConfig.exchange(snapshot, std::memory_order_acq_rel);
+    }
 
-        if (_wcsicmp(text, L"TL") == 0) return 0;
-        if (_wcsicmp(text, L"TR") == 0) return 1;
-        if (_wcsicmp(text, L"BL") == 0) return 2;
-        if (_wcsicmp(text, L"BR") == 0) return 3;
+    // Runs on the watcher thread; false asks it to retry (file still locked)
+    static bool ReloadConfig() {
+        IniFile ini;
+        if (!ini.LoadFile(s_configPath)) return false;
 
-        return -1;
+        std::lock_guard<std::mutex> lock(s_publishMutex);
+        ParseConfig(ini, s_latestConfig);
+        Publish(s_latestConfig);
+        return true;
     }
 
-    static int ParseToggleKey(const wchar_t* text) {
-        if (!text) return VK_F1;
-        while (*text && iswspace(*text)) text++;
-        if (!*text) return VK_F1;
+    // Render thread, once per frame: never touches the file system
+    static void AdoptPendingConfig() {
+        if (!s_pendingConfig.load(std::memory_order_acquire)) return;
+        Config* config = s_pendingConfig.exchange(nullptr, std::memory_order_acq_rel);
+        if (!config) return;
 
-        wchar_t* end = nullptr;
-        long numeric = wcstol(text, &end, 10);
-        if (end != text && numeric > 0 && numeric < 256) {
-            return static_cast<int>(numeric);
+        // Visible only when the field itself was edited, so an unrelated
+        // edit does not undo the hotkey toggle
+        if (config->visible != s_config->visible) {
+            s_showOverlay.store(config->visible, std::memory_order_relaxed);
         }
+        if (s_config != &s_defaultConfig) delete s_config;
+        s_config = config;
 
-        if ((text[0] == L'F' || text[0] == L'f') && iswdigit(text[1])) {
-            int n = _wtoi(text + 1);
-            if (n >= 1 && n <= 12) return VK_F1 + (n - 1);
-        }
+        s_toggleKey.store(config->toggleKey, std::memory_order_relaxed);
+        s_captureEnabled.store(config->captureEnabled, std::memory_order_relaxed);
+        s_sessionSketchEnabled.store(config->sessionSketchEnabled, std::memory_order_relaxed);
 
-        return VK_F1;
+        FpsCounter::SetStutterAnalysis(config->showStutter);
+        FpsCounter::SetGraphLayout(static_cast<size_t>(config->graphWidth), config->graphSeconds);
+        FpsCounter::SetSampleCount(static_cast<size_t>(config->sampleCount));
+        FpsCounter::SetDisplayUpdateMs(static_cast<long long>(config->displayUpdateMs));
     }
 
-    static void LoadConfigFromIni() {
-        if (!s_configPathReady) return;
-
-        constexpr const wchar_t* SECTION = L"Overlay";
-
-        int visible = GetPrivateProfileIntW(SECTION, L"Visible", s_showOverlay ? 1 : 0, s_configPath);
-        s_showOverlay = (visible != 0);
-
-        float alpha = ReadIniFloat(SECTION, L"Alpha", s_alpha);
-        s_alpha = Clamp01(alpha);
-
-        int showFps = GetPrivateProfileIntW(SECTION, L"ShowFps", s_showFps ? 1 : 0, s_configPath);
-        int showFrameTime = GetPrivateProfileIntW(SECTION, L"ShowFrameTime", s_showFrameTime ? 1 : 0, s_configPath);
-        s_showFps = (showFps != 0);
-        s_showFrameTime = (showFrameTime != 0);
-
-        float greenThreshold = ReadIniFloat(SECTION, L"GreenThreshold", s_greenThreshold);
-        float yellowThreshold = ReadIniFloat(SECTION, L"YellowThreshold", s_yellowThreshold);
-        greenThreshold = ClampNonNegative(greenThreshold);
-        yellowThreshold = ClampNonNegative(yellowThreshold);
-        if (greenThreshold < yellowThreshold) {
-            float tmp = greenThreshold;
-            greenThreshold = yellowThreshold;
-            yellowThreshold = tmp;
-        }
-        s_greenThreshold = greenThreshold;
-        s_yellowThreshold = yellowThreshold;
-
-        float fontScale = ReadIniFloat(SECTION, L"FontScale", s_fontScale);
-        s_fontScale = ClampRange(fontScale, 0.5f, 5.0f);
-
-        int sampleCount = GetPrivateProfileIntW(SECTION, L"SampleCount", 60, s_configPath);
-        int displayUpdateMs = GetPrivateProfileIntW(SECTION, L"DisplayUpdateMs", 80, s_configPath);
-        FpsCounter::SetSampleCount(static_cast<size_t>(sampleCount));
-        FpsCounter::SetDisplayUpdateMs(static_cast<long long>(displayUpdateMs));
-
-        float marginX = ReadIniFloat(SECTION, L"MarginX", s_marginX);
-        float marginY = ReadIniFloat(SECTION, L"MarginY", s_marginY);
-        s_marginX = ClampNonNegative(marginX);
-        s_marginY = ClampNonNegative(marginY);
-
-        wchar_t cornerBuf[32] = {0};
-        GetPrivateProfileStringW(SECTION, L"Corner", L"", cornerBuf, static_cast<DWORD>(sizeof(cornerBuf) / sizeof(cornerBuf[0])), s_configPath);
-        int corner = ParseCorner(cornerBuf);
-        if (corner >= 0 && corner <= 3) {
-            s_corner = corner;
-            s_positionMode = PositionMode::Corner;
-        } else if (corner == 4) {
-            float x = ReadIniFloat(SECTION, L"X", s_posX);
-            float y = ReadIniFloat(SECTION, L"Y", s_posY);
-            s_posX = x;
-            s_posY = y;
-            s_positionMode = PositionMode::Custom;
+    // Min/max envelope of frame times, one pixel column per time bucket
+    static void DrawFrameGraph(const Config& cfg) {
+        static FrameTimeGraph::Column columns[FrameTimeGraph::kMaxColumns];
+        size_t count = FpsCounter::GetGraph().GetColumns(columns, FrameTimeGraph::kMaxColumns);
+
+        ImVec2 origin = ImGui::GetCursorScreenPos();
+        ImGui::Dummy(ImVec2(cfg.graphWidth, cfg.graphHeight));
+        ImDrawList* drawList = ImGui::GetWindowDrawList();
+        drawList->AddRectFilled(origin, ImVec2(origin.x + cfg.graphWidth, origin.y + cfg.graphHeight), IM_COL32(0, 0, 0, 64));
+        if (count == 0) return;
+
+        float greenMs = cfg.greenThreshold > 0.0f ? 1000.0f / cfg.greenThreshold : 16.7f;
+        float yellowMs = cfg.yellowThreshold > 0.0f ? 1000.0f / cfg.yellowThreshold : 33.3f;
+        float topMs = yellowMs * 1.5f;
+        for (size_t i = 0; i < count; i++) {
+            if (columns[i].maxMs > topMs) topMs = columns[i].maxMs;
         }
 
-        wchar_t keyBuf[32] = {0};
-        GetPrivateProfileStringW(SECTION, L"ToggleKey", L"F1", keyBuf, static_cast<DWORD>(sizeof(keyBuf) / sizeof(keyBuf[0])), s_configPath);
-        s_toggleKey = ParseToggleKey(keyBuf);
-    }
-
-    static void MaybeReloadConfig() {
-        if (!s_configPathReady) return;
-
-        ULONGLONG nowTick = GetTickCount64();
-        if (nowTick - s_lastConfigCheckTick < 1000) return;
-        s_lastConfigCheckTick = nowTick;
+        float columnWidth = cfg.graphWidth / static_cast<float>(count);
+        for (size_t i = 0; i < count; i++) {
+            if (std::isnan(columns[i].maxMs)) continue;
 
-        FILETIME ft = {0};
-        if (!TryGetFileWriteTime(s_configPath, &ft)) return;
+            float x0 = origin.x + columnWidth * static_cast<float>(i);
+            float yTop = origin.y + cfg.graphHeight * (1.0f - columns[i].maxMs / topMs);
+            float yBottom = origin.y + cfg.graphHeight * (1.0f - columns[i].minMs / topMs);
+            if (yBottom - yTop < 1.0f) yBottom = yTop + 1.0f;
 
-        if (!s_configLoaded || CompareFileTime(&ft, &s_configWriteTime) != 0) {
-            s_configWriteTime = ft;
-            LoadConfigFromIni();
-            s_configLoaded = true;
+            ImU32 color;
+            if (columns[i].maxMs <= greenMs) color = IM_COL32(50, 255, 50, 220);
+            else if (columns[i].maxMs <= yellowMs) color = IM_COL32(255, 255, 50, 220);
+            else color = IM_COL32(255, 50, 50, 220);
+            drawList->AddRectFilled(ImVec2(x0, yTop), ImVec2(x0 + columnWidth, yBottom), color);
         }
+
+        float targetY = origin.y + cfg.graphHeight * (1.0f - greenMs / topMs);
+        drawList->AddLine(ImVec2(origin.x, targetY), ImVec2(origin.x + cfg.graphWidth, targetY), IM_COL32(255, 255, 255, 80));
     }
 
     LRESULT CALLBACK WndProc(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam) {
         if (ImGui_ImplWin32_WndProcHandler(hWnd, msg, wParam, lParam))
             return true;
 
-        if (msg == WM_KEYDOWN && wParam == static_cast<WPARAM>(s_toggleKey) && ((lParam & (1LL << 30)) == 0)) {
-            s_showOverlay = !s_showOverlay;
+        if (msg == WM_KEYDOWN && wParam == static_cast<WPARAM>(s_toggleKey.load(std::memory_order_relaxed)) && ((lParam & (1LL << 30)) == 0)) {
+            s_showOverlay.store(!s_showOverlay.load(std::memory_order_relaxed), std::memory_order_relaxed);
         }
 
         return CallWindowProc(s_originalWndProc, hWnd, msg, wParam, lParam);
@@ -253,39 +197,38 @@ namespace Overlay {
 
         InitConfigPath();
         if (s_configPathReady) {
-            FILETIME ft = {0};
-            if (TryGetFileWriteTime(s_configPath, &ft)) {
-                s_configWriteTime = ft;
-                LoadConfigFromIni();
-                s_configLoaded = true;
-                s_lastConfigCheckTick = GetTickCount64();
-            }
+            // First load inline so the first frame already uses it; later
+            // edits are parsed on the watcher thread
+            ReloadConfig();
+            AdoptPendingConfig();
+            s_configWatcher.Start(s_configPath, ReloadConfig);
         }
 
         return true;
     }
 
     void Render() {
-        MaybeReloadConfig();
-        if (!s_showOverlay) return;
-        if (!s_showFps && !s_showFrameTime) return;
+        AdoptPendingConfig();
+        const Config& cfg = *s_config;
+        if (!s_showOverlay.load(std::memory_order_relaxed)) return;
+        if (!cfg.showFps && !cfg.showFrameTime && !cfg.showGraph && !cfg.showStutter) return;
 
         ImGui_ImplDX11_NewFrame();
         ImGui_ImplWin32_NewFrame();
         ImGui::NewFrame();
 
         ImGuiIO& io = ImGui::GetIO();
-        io.FontGlobalScale = s_fontScale;
-        if (s_positionMode == PositionMode::Custom) {
-            ImGui::SetNextWindowPos(ImVec2(s_posX, s_posY), ImGuiCond_Always, ImVec2(0.0f, 0.0f));
+        io.FontGlobalScale = cfg.fontScale;
+        if (cfg.corner == kCornerCustom) {
+            ImGui::SetNextWindowPos(ImVec2(cfg.posX, cfg.posY), ImGuiCond_Always, ImVec2(0.0f, 0.0f));
         } else {
-            float x = (s_corner == 0 || s_corner == 2) ? s_marginX : (io.DisplaySize.x - s_marginX);
-            float y = (s_corner == 0 || s_corner == 1) ? s_marginY : (io.DisplaySize.y - s_marginY);
-            float pivotX = (s_corner == 0 || s_corner == 2) ? 0.0f : 1.0f;
-            float pivotY = (s_corner == 0 || s_corner == 1) ? 0.0f : 1.0f;
+            float x = (cfg.corner == 0 || cfg.corner == 2) ? cfg.marginX : (io.DisplaySize.x - cfg.marginX);
+            float y = (cfg.corner == 0 || cfg.corner == 1) ? cfg.marginY : (io.DisplaySize.y - cfg.marginY);
+            float pivotX = (cfg.corner == 0 || cfg.corner == 2) ? 0.0f : 1.0f;
+            float pivotY = (cfg.corner == 0 || cfg.corner == 1) ? 0.0f : 1.0f;
             ImGui::SetNextWindowPos(ImVec2(x, y), ImGuiCond_Always, ImVec2(pivotX, pivotY));
         }
-        ImGui::SetNextWindowBgAlpha(s_alpha);
+        ImGui::SetNextWindowBgAlpha(cfg.alpha);
 
         ImGuiWindowFlags flags = ImGuiWindowFlags_NoTitleBar |
                                   ImGuiWindowFlags_NoResize |
@@ -302,20 +245,36 @@ namespace Overlay {
             float frameTimeMs = FpsCounter::GetDisplayFrameTime();
 
             ImVec4 textColor;
-            if (fps >= s_greenThreshold) {
+            if (fps >= cfg.greenThreshold) {
                 textColor = ImVec4(0.2f, 1.0f, 0.2f, 1.0f);
-            } else if (fps >= s_yellowThreshold) {
+            } else if (fps >= cfg.yellowThreshold) {
                 textColor = ImVec4(1.0f, 1.0f, 0.2f, 1.0f);
             } else {
                 textColor = ImVec4(1.0f, 0.2f, 0.2f, 1.0f);
             }
 
-            if (s_showFps) {
+            if (cfg.showFps) {
                 ImGui::TextColored(textColor, "FPS: %.1f", fps);
             }
-            if (s_showFrameTime) {
+            if (cfg.showFrameTime) {
                 ImGui::TextColored(textColor, "Frame: %.1f ms", frameTimeMs);
             }
+            if (cfg.showStutter) {
+                Spectral::PeriodicStutter stutter = FpsCounter::GetPeriodicStutter();
+                if (stutter.detected) {
+                    ImVec4 hitchColor(1.0f, 0.6f, 0.2f, 1.0f);
+                    if (stutter.domain == Spectral::Domain::Frames) {
+                        ImGui::TextColored(hitchColor, "Hitch: every %.0f frames (%.0f%%)",
+                                           stutter.periodFrames, stutter.strength * 100.0f);
+                    } else {
+                        ImGui::TextColored(hitchColor, "Hitch: every %.2f s (%.0f%%)",
+                                           stutter.periodMs / 1000.0f, stutter.strength * 100.0f);
+                    }
+                }
+            }
+            if (cfg.showGraph) {
+                DrawFrameGraph(cfg);
+            }
         }
         ImGui::End();
 
@@ -332,20 +291,45 @@ namespace Overlay {
     }
 
     void SetVisible(bool visible) {
-        s_showOverlay = visible;
+        s_showOverlay.store(visible, std::memory_order_relaxed);
     }
 
     void SetPosition(float x, float y) {
-        s_posX = x;
-        s_posY = y;
-        s_positionMode = PositionMode::Custom;
+        std::lock_guard<std::mutex> lock(s_publishMutex);
+        s_latestConfig.posX = x;
+        s_latestConfig.posY = y;
+        s_latestConfig.corner = kCornerCustom;
+        Publish(s_latestConfig);
     }
 
     void SetAlpha(float alpha) {
-        s_alpha = Clamp01(alpha);
+        std::lock_guard<std::mutex> lock(s_publishMutex);
+        s_latestConfig.alpha = Clamp01(alpha);
+        Publish(s_latestConfig);
+    }
+
+    bool IsCaptureEnabled() {
+        return s_captureEnabled.load(std::memory_order_relaxed);
+    }
+
+    bool IsSessionSketchEnabled() {
+        return s_sessionSketchEnabled.load(std::memory_order_relaxed);
+    }
+
+    int LoadHookMode() {
+        InitConfigPath();
+        Config config;
+        IniFile ini;
+        if (s_configPathReady && ini.LoadFile(s_configPath)) ParseConfig(ini, config);
+        return config.hookMode;
     }
 
     void Shutdown() {
+        s_configWatcher.Stop();
+        delete s_pendingConfig.exchange(nullptr, std::memory_order_acq_rel);
+        if (s_config != &s_defaultConfig) delete s_config;
+        s_config = &s_defaultConfig;
+
         if (s_originalWndProc && s_hWnd) {
             SetWindowLongPtr(s_hWnd, GWLP_WNDPROC, reinterpret_cast<LONG_PTR>(s_originalWndProc));
         }
@@ -11,4 +11,7 @@ namespace Overlay {
     void SetVisible(bool visible);
     void SetPosition(float x, float y);
     void SetAlpha(float alpha);
+    bool IsCaptureEnabled();
+    bool IsSessionSketchEnabled();
+    int LoadHookMode();     // HookMode from overlay.ini, before Initialize
 }
@@ -0,0 +1,83 @@
+#pragma once
+
+#include "config_schema.h"
+#include "frame_graph.h"
+
+// overlay.ini schema: read by fps_overlay.dll, written with defaults by the
+// launcher. Portable (no Windows headers).
+//
+// X(kind, member, section, key, def, min, max, clamp, names, comment)
+#define OVERLAY_CONFIG_FIELDS(X) \
+    X(Float,  alpha,                "Overlay", "Alpha",           0.25f,  0.0, 1.0,    ConfigSchema::kClamp,  nullptr, "0..1 (window background alpha)") \
+    X(Bool,   showFps,              "Overlay", "ShowFps",         true,   0.0, 0.0,    ConfigSchema::kClamp,  nullptr, "0/1") \
+    X(Bool,   showFrameTime,        "Overlay", "ShowFrameTime",   true,   0.0, 0.0,    ConfigSchema::kClamp,  nullptr, nullptr) \
+    X(Bool,   showStutter,          "Overlay", "ShowStutter",     true,   0.0, 0.0,    ConfigSchema::kClamp,  nullptr, "0/1 (show detected periodic hitches, e.g. a spike every 1.0 s)") \
+    X(Bool,   captureEnabled,       "Overlay", "Capture",         false,  0.0, 0.0,    ConfigSchema::kClamp,  nullptr, "0/1 (record frame timings to captures\\*.fpsc for frame_analyzer)") \
+    X(Bool,   sessionSketchEnabled, "Overlay", "SessionSketch",   true,   0.0, 0.0,    ConfigSchema::kClamp,  nullptr, "0/1 (write a small frame-time percentile sketch per session to sketches\\*.fpsq)") \
+    X(Bool,   showGraph,            "Overlay", "ShowGraph",       false,  0.0, 0.0,    ConfigSchema::kClamp,  nullptr, "0/1 (frame-time graph: min/max per pixel column over the last GraphSeconds)") \
+    X(Float,  graphSeconds,         "Overlay", "GraphSeconds",    10.0f,  1.0, 120.0,  ConfigSchema::kClamp,  nullptr, nullptr) \
+    X(Float,  graphWidth,           "Overlay", "GraphWidth",      200.0f, 50.0, static_cast<double>(FrameTimeGraph::kMaxColumns), ConfigSchema::kClamp, nullptr, nullptr) \
+    X(Float,  graphHeight,          "Overlay", "GraphHeight",     40.0f,  16.0, 400.0, ConfigSchema::kClamp,  nullptr, nullptr) \
+    X(Float,  greenThreshold,       "Overlay", "GreenThreshold",  60.0f,  0.0, 10000.0, ConfigSchema::kClamp, nullptr, "Color thresholds") \
+    X(Float,  yellowThreshold,      "Overlay", "YellowThreshold", 30.0f,  0.0, 10000.0, ConfigSchema::kClamp, nullptr, nullptr) \
+    X(Float,  fontScale,            "Overlay", "FontScale",       1.0f,   0.5, 5.0,    ConfigSchema::kClamp,  nullptr, "Font scale (default 1.0)") \
+    X(Int,    sampleCount,          "Overlay", "SampleCount",     60,     1.0, 1000.0, ConfigSchema::kClamp,  nullptr, "FPS smoothing") \
+    X(Int,    displayUpdateMs,      "Overlay", "DisplayUpdateMs", 80,     16.0, 5000.0, ConfigSchema::kClamp, nullptr, nullptr) \
+    X(Enum,   corner,               "Overlay", "Corner",          1,      0.0, 0.0,    ConfigSchema::kReject, kOverlayCornerNames, "Corner: TopLeft, TopRight, BottomLeft, BottomRight, Custom") \
+    X(Float,  marginX,              "Overlay", "MarginX",         8.0f,   0.0, 10000.0, ConfigSchema::kClamp, nullptr, nullptr) \
+    X(Float,  marginY,              "Overlay", "MarginY",         8.0f,   0.0, 10000.0, ConfigSchema::kClamp, nullptr, nullptr) \
+    X(Float,  posX,                 "Overlay", "X",               10.0f,  0.0, 0.0,    ConfigSchema::kClamp,  nullptr, "Used when Corner=Custom") \
+    X(Float,  posY,                 "Overlay", "Y",               10.0f,  0.0, 0.0,    ConfigSchema::kClamp,  nullptr, nullptr) \
+    X(Key,    toggleKey,            "Overlay", "ToggleKey",       ConfigSchema::kVkF1, 1.0, 254.0, ConfigSchema::kReject, nullptr, "ToggleKey: F1-F12 (or a VK code number)") \
+    X(Bool,   visible,              "Overlay", "Visible",         true,   0.0, 0.0,    ConfigSchema::kClamp,  nullptr, "0/1") \
+    X(Enum,   hookMode,             "Overlay", "HookMode",        0,      0.0, 0.0,    ConfigSchema::kReject, kHookModeNames, "HookMode: Inline (MinHook detour) or Vtable (swap chain vtable slot, no thread suspension); read once at injection")
+
+enum OverlayCorner {
+    kCornerTopLeft = 0,
+    kCornerTopRight = 1,
+    kCornerBottomLeft = 2,
+    kCornerBottomRight = 3,
+    kCornerCustom = 4,
+};
+
+// First name per value is the one written back
+inline constexpr ConfigSchema::EnumName kOverlayCornerNames[] = {
+    { "TopLeft", kCornerTopLeft },
+    { "TopRight", kCornerTopRight },
+    { "BottomLeft", kCornerBottomLeft },
+    { "BottomRight", kCornerBottomRight },
+    { "Custom", kCornerCustom },
+    { "TL", kCornerTopLeft },
+    { "TR", kCornerTopRight },
+    { "BL", kCornerBottomLeft },
+    { "BR", kCornerBottomRight },
+    { nullptr, 0 },
+};
+
+enum HookMode {
+    kHookInline = 0,
+    kHookVtable = 1,
+};
+
+inline constexpr ConfigSchema::EnumName kHookModeNames[] = {
+    { "Inline", kHookInline },
+    { "Vtable", kHookVtable },
+    { nullptr, 0 },
+};
+
+struct OverlayConfig {
+    OVERLAY_CONFIG_FIELDS(CONFIG_SCHEMA_MEMBER)
+};
+
+#define OVERLAY_CONFIG_FIELD(kind, member, section, key, def, min, max, clamp, names, comment) \
+    CONFIG_SCHEMA_FIELD(OverlayConfig, kind, member, section, key, def, min, max, clamp, names, comment)
+inline constexpr ConfigSchema::Field kOverlayConfigFields[] = {
+    OVERLAY_CONFIG_FIELDS(OVERLAY_CONFIG_FIELD)
+};
+#undef OVERLAY_CONFIG_FIELD
+
+inline constexpr ConfigSchema::Schema kOverlayConfigSchema = ConfigSchema::MakeSchema(
+    kOverlayConfigFields,
+    "FPS Overlay - Overlay Settings\n"
+    "This file is read by fps_overlay.dll (auto-reloads on change).",
+    false);
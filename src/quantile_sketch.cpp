@@ -0,0 +1,172 @@
+#include "quantile_sketch.h"
+#include "capture.h"
+#include <cmath>
+#include <cstring>
+
+QuantileSketch::QuantileSketch(double relativeAccuracy, uint32_t maxBins) {
+    if (!(relativeAccuracy > 0.0 && relativeAccuracy < 1.0)) relativeAccuracy = kDefaultAccuracy;
+    if (maxBins < 16) maxBins = 16;
+
+    m_accuracy = relativeAccuracy;
+    m_gamma = (1.0 + relativeAccuracy) / (1.0 - relativeAccuracy);
+    m_invLogGamma = 1.0 / std::log(m_gamma);
+    m_maxBins = maxBins;
+}
+
+void QuantileSketch::Clear() {
+    m_bins.clear();
+    m_offset = 0;
+    m_zeroCount = 0;
+    m_count = 0;
+    m_sum = 0.0;
+    m_min = 0.0;
+    m_max = 0.0;
+}
+
+int32_t QuantileSketch::IndexOf(double value) const {
+    return static_cast<int32_t>(std::ceil(std::log(value) * m_invLogGamma));
+}
+
+double QuantileSketch::ValueOf(int32_t index) const {
+    // Midpoint (in relative terms) of (gamma^(i-1), gamma^i]
+    return 2.0 * std::pow(m_gamma, index) / (m_gamma + 1.0);
+}
+
+void QuantileSketch::Reserve(int32_t index) {
+    if (m_bins.empty()) {
+        m_bins.assign(1, 0);
+        m_offset = index;
+        return;
+    }
+
+    int32_t last = m_offset + static_cast<int32_t>(m_bins.size()) - 1;
+    if (index < m_offset) {
+        m_bins.insert(m_bins.begin(), static_cast<size_t>(m_offset - index), 0);
+        m_offset = index;
+    } else if (index > last) {
+        m_bins.resize(m_bins.size() + static_cast<size_t>(index - last), 0);
+    }
+
+    if (m_bins.size() > m_maxBins) {
+        // Fold the lowest bins into the first one that is kept
+        size_t excess = m_bins.size() - m_maxBins;
+        uint64_t folded = 0;
+        for (size_t i = 0; i <= excess; i++) folded += m_bins[i];
+        m_bins.erase(m_bins.begin(), m_bins.begin() + static_cast<std::ptrdiff_t>(excess));
+        m_bins[0] = folded;
+        m_offset += static_cast<int32_t>(excess);
+    }
+}
+
+void QuantileSketch::Add(double value) {
+    if (!(value >= 0.0)) return;   // Negative or NaN
+
+    if (m_count == 0) {
+        m_min = m_max = value;
+    } else {
+        if (value < m_min) m_min = value;
+        if (value > m_max) m_max = value;
+    }
+    m_count++;
+    m_sum += value;
+
+    if (value < kMinValue) {
+        m_zeroCount++;
+        return;
+    }
+
+    int32_t index = IndexOf(value);
+    Reserve(index);
+    if (index < m_offset) index = m_offset;   // Collapsed range
+    m_bins[static_cast<size_t>(index - m_offset)]++;
+}
+
+bool QuantileSketch::Merge(const QuantileSketch& other) {
+    if (other.m_count == 0) return true;
+    if (std::fabs(other.m_accuracy - m_accuracy) > 1e-12) return false;
+
+    if (m_count == 0) {
+        m_min = other.m_min;
+        m_max = other.m_max;
+    } else {
+        if (other.m_min < m_min) m_min = other.m_min;
+        if (other.m_max > m_max) m_max = other.m_max;
+    }
+    m_count += other.m_count;
+    m_sum += other.m_sum;
+    m_zeroCount += other.m_zeroCount;
+
+    if (!other.m_bins.empty()) {
+        Reserve(other.m_offset);
+        Reserve(other.m_offset + static_cast<int32_t>(other.m_bins.size()) - 1);
+        for (size_t i = 0; i < other.m_bins.size(); i++) {
+            int32_t index = other.m_offset + static_cast<int32_t>(i);
+            if (index < m_offset) index = m_offset;
+            m_bins[static_cast<size_t>(index - m_offset)] += other.m_bins[i];
+        }
+    }
+    return true;
+}
+
+double QuantileSketch::Quantile(double q) const {
+    if (m_count == 0) return 0.0;
+    if (q <= 0.0) return m_min;
+    if (q >= 1.0) return m_max;
+
+    // Rank of the requested value, 0-based
+    uint64_t rank = static_cast<uint64_t>(q * static_cast<double>(m_count - 1));
+    if (rank < m_zeroCount) return 0.0;
+
+    uint64_t seen = m_zeroCount;
+    for (size_t i = 0; i < m_bins.size(); i++) {
+        seen += m_bins[i];
+        if (seen > rank) {
+            double value = ValueOf(m_offset + static_cast<int32_t>(i));
+            if (value < m_min) value = m_min;
+            if (value > m_max) value = m_max;
+            return value;
+        }
+    }
+    return m_max;
+}
+
+void QuantileSketch::Serialize(std::vector<unsigned char>& out) const {
+    Capture::SketchHeader header = {};
+    header.relativeAccuracy = m_accuracy;
+    header.offset = m_offset;
+    header.binCount = static_cast<uint32_t>(m_bins.size());
+    header.count = m_count;
+    header.zeroCount = m_zeroCount;
+    header.sum = m_sum;
+    header.min = m_min;
+    header.max = m_max;
+
+    size_t binBytes = m_bins.size() * sizeof(uint64_t);
+    out.resize(sizeof(header) + binBytes);
+    std::memcpy(out.data(), &header, sizeof(header));
+    if (binBytes) std::memcpy(out.data() + sizeof(header), m_bins.data(), binBytes);
+}
+
+bool QuantileSketch::Deserialize(const void* data, size_t size) {
+    if (size < sizeof(Capture::SketchHeader)) return false;
+
+    Capture::SketchHeader header;
+    std::memcpy(&header, data, sizeof(header));
+    if (!(header.relativeAccuracy > 0.0 && header.relativeAccuracy < 1.0)) return false;
+
+    size_t binBytes = static_cast<size_t>(header.binCount) * sizeof(uint64_t);
+    if (size - sizeof(header) < binBytes) return false;
+
+    *this = QuantileSketch(header.relativeAccuracy, header.binCount > m_maxBins ? header.binCount : m_maxBins);
+    m_offset = header.offset;
+    m_count = header.count;
+    m_zeroCount = header.zeroCount;
+    m_sum = header.sum;
+    m_min = header.min;
+    m_max = header.max;
+    m_bins.resize(header.binCount);
+    if (binBytes) {
+        std::memcpy(m_bins.data(), static_cast<const unsigned char*>(data) + sizeof(header), binBytes);
+    }
+    return true;
+}
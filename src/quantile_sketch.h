@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Mergeable quantile sketch (DDSketch).
+//
+// Values are counted in logarithmic bins of ratio gamma = (1 + a) / (1 - a),
+// so any quantile is returned within relative error a of the true value, and
+// two sketches with the same accuracy merge by adding bin counts. Percentiles
+// of many sessions therefore combine exactly as if all frames had been fed to
+// one sketch, which is what fleet-wide p99 needs.
+//
+// Bins are a dense array starting at m_offset. If it ever exceeds maxBins
+// (only for absurd value ranges) the lowest bins are folded together, which
+// keeps the high quantiles accurate.
+//
+// Portable (no Windows headers): fps_overlay.dll writes it, frame_analyzer
+// merges it.
+class QuantileSketch {
+public:
+    static constexpr double kDefaultAccuracy = 0.01;
+    static constexpr uint32_t kDefaultMaxBins = 2048;
+    static constexpr double kMinValue = 1e-3;   // Smaller values count as zero
+
+    explicit QuantileSketch(double relativeAccuracy = kDefaultAccuracy, uint32_t maxBins = kDefaultMaxBins);
+
+    void Clear();
+    void Add(double value);
+
+    // Fails (and leaves this sketch untouched) if the accuracies differ
+    bool Merge(const QuantileSketch& other);
+
+    // q in [0, 1]; returns 0 for an empty sketch
+    double Quantile(double q) const;
+
+    uint64_t Count() const { return m_count; }
+    double Sum() const { return m_sum; }
+    double Min() const { return m_min; }
+    double Max() const { return m_max; }
+    double RelativeAccuracy() const { return m_accuracy; }
+
+    // Capture chunk payload (Capture::SketchHeader + bin counts)
+    void Serialize(std::vector<unsigned char>& out) const;
+    bool Deserialize(const void* data, size_t size);
+
+private:
+    int32_t IndexOf(double value) const;
+    double ValueOf(int32_t index) const;
+    void Reserve(int32_t index);
+
+    double m_accuracy;
+    double m_gamma;
+    double m_invLogGamma;
+    uint32_t m_maxBins;
+
+    std::vector<uint64_t> m_bins;
+    int32_t m_offset = 0;       // Index of m_bins[0]
+    uint64_t m_zeroCount = 0;
+    uint64_t m_count = 0;
+    double m_sum = 0.0;
+    double m_min = 0.0;
+    double m_max = 0.0;
+};
@@ -0,0 +1,241 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Overlay render state per swap chain, for games that present to more than
+// one (menu and gameplay swap chains, several windows, a video layer), so
+// switching between them does not rebuild the expensive state.
+//
+// Two levels: Shared state per device (shaders, input layout, font atlas,
+// ...) and View state per target (a swap chain: its RTV and size). Only the
+// target last looked up holds a View: a switch releases the others', since
+// a view keeps the target's back buffer referenced and the game cannot
+// resize that swap chain while it is (recreating a view on the way back is
+// cheap). At most kTargets targets are remembered and the least recently
+// used one makes room for a new one; a target not looked up for maxIdle
+// calls is forgotten as well. Shared state outlives its targets: it is kept
+// until its device has had no target for maxIdle calls or its slot is needed,
+// so a swap chain that is resized (Erase, then Insert) or recreated on the
+// same device reuses it.
+//
+// Resources are created and released through Traits, which keeps the cache
+// header-only and free of platform headers (tested with mock resources):
+//
+//   struct Traits {
+//       using TargetKey = ...;     // Compared with ==
+//       using DeviceKey = ...;
+//       using Shared = ...;        // Default constructible
+//       using View = ...;
+//       bool CreateShared(DeviceKey device, Shared& shared);
+//       void ReleaseShared(Shared& shared);
+//       bool CreateView(TargetKey target, Shared& shared, View& view);
+//       void ReleaseView(View& view);
+//   };
+//
+// A failed Create* must leave nothing to release.
+template <typename Traits, size_t kTargets = 4>
+class RenderStateCache {
+public:
+    using TargetKey = typename Traits::TargetKey;
+    using DeviceKey = typename Traits::DeviceKey;
+    using Shared = typename Traits::Shared;
+    using View = typename Traits::View;
+
+    struct Binding {
+        Shared* shared = nullptr;
+        View* view = nullptr;
+        bool switched = false;      // Another target than the last Find/Insert
+        explicit operator bool() const { return view != nullptr; }
+    };
+
+    explicit RenderStateCache(Traits traits = Traits(), uint32_t maxIdle = 600)
+        : m_traits(traits), m_maxIdle(maxIdle) {}
+    ~RenderStateCache() { Clear(); }
+    RenderStateCache(const RenderStateCache&) = delete;
+    RenderStateCache& operator=(const RenderStateCache&) = delete;
+
+    // State of a known target (its view recreated if a switch released it);
+    // empty on a miss or if the view cannot be recreated. Also forgets idle
+    // targets and devices.
+    Binding Find(TargetKey target) {
+        m_clock++;
+        int found = -1;
+        for (size_t i = 0; i < kTargets; i++) {
+            if (!m_targets[i].used) continue;
+            if (m_targets[i].key == target) {
+                found = static_cast<int>(i);
+            } else if (m_clock - m_targets[i].lastUse > m_maxIdle) {
+                Drop(i);
+            }
+        }
+        for (size_t i = 0; i < kTargets; i++) {
+            if (m_devices[i].used && m_devices[i].targets == 0 && m_clock - m_devices[i].lastUse > m_maxIdle) {
+                ReleaseDevice(i);
+            }
+        }
+        return found < 0 ? Binding() : Bind(static_cast<size_t>(found));
+    }
+
+    // Creates state for a target that Find missed (a known one is rebuilt).
+    // Empty if the traits failed to create it.
+    Binding Insert(TargetKey target, DeviceKey device) {
+        m_clock++;
+        size_t slot = kTargets;
+        for (size_t i = 0; i < kTargets; i++) {
+            if (m_targets[i].used && m_targets[i].key == target) Drop(i);
+        }
+        for (size_t i = 0; i < kTargets && slot == kTargets; i++) {
+            if (!m_targets[i].used) slot = i;
+        }
+        if (slot == kTargets) {
+            slot = 0;
+            for (size_t i = 1; i < kTargets; i++) {
+                if (m_targets[i].lastUse < m_targets[slot].lastUse) slot = i;
+            }
+            Drop(slot);
+        }
+
+        // At most kTargets - 1 targets are left, so some device slot is free
+        // or has no target; the least recently used of those makes room
+        size_t deviceSlot = kTargets;
+        for (size_t i = 0; i < kTargets; i++) {
+            if (m_devices[i].used && m_devices[i].key == device) {
+                deviceSlot = i;
+                break;
+            }
+            if (m_devices[i].targets > 0) continue;
+            if (deviceSlot == kTargets || !m_devices[i].used ||
+                (m_devices[deviceSlot].used && m_devices[i].lastUse < m_devices[deviceSlot].lastUse)) {
+                deviceSlot = i;
+            }
+        }
+        DeviceEntry& deviceEntry = m_devices[deviceSlot];
+        if (deviceEntry.used && !(deviceEntry.key == device)) ReleaseDevice(deviceSlot);
+        if (!deviceEntry.used) {
+            deviceEntry.shared = Shared();
+            if (!m_traits.CreateShared(device, deviceEntry.shared)) return Binding();
+            deviceEntry.key = device;
+            deviceEntry.targets = 0;
+            deviceEntry.used = true;
+        }
+        deviceEntry.lastUse = m_clock;
+
+        TargetEntry& entry = m_targets[slot];
+        entry.key = target;
+        entry.device = static_cast<uint32_t>(deviceSlot);
+        entry.hasView = false;
+        entry.used = true;
+        deviceEntry.targets++;
+        return Bind(slot);
+    }
+
+    // Forgets a target and releases its view (before the target's buffers
+    // are resized or it is destroyed); the device's Shared state stays
+    void Erase(TargetKey target) {
+        for (size_t i = 0; i < kTargets; i++) {
+            if (m_targets[i].used && m_targets[i].key == target) Drop(i);
+        }
+    }
+
+    void Clear() {
+        for (size_t i = 0; i < kTargets; i++) {
+            if (m_targets[i].used) Drop(i);
+        }
+        for (size_t i = 0; i < kTargets; i++) {
+            if (m_devices[i].used) ReleaseDevice(i);
+        }
+    }
+
+    size_t TargetCount() const {
+        size_t count = 0;
+        for (const TargetEntry& entry : m_targets) count += entry.used ? 1 : 0;
+        return count;
+    }
+
+    size_t ViewCount() const {
+        size_t count = 0;
+        for (const TargetEntry& entry : m_targets) count += entry.used && entry.hasView ? 1 : 0;
+        return count;
+    }
+
+    size_t DeviceCount() const {
+        size_t count = 0;
+        for (const DeviceEntry& entry : m_devices) count += entry.used ? 1 : 0;
+        return count;
+    }
+
+    Traits& GetTraits() { return m_traits; }
+
+private:
+    struct TargetEntry {
+        TargetKey key{};
+        View view{};
+        uint32_t device = 0;
+        uint64_t lastUse = 0;
+        bool hasView = false;
+        bool used = false;
+    };
+
+    struct DeviceEntry {
+        DeviceKey key{};
+        Shared shared{};
+        uint32_t targets = 0;
+        uint64_t lastUse = 0;       // Last bind of one of its targets, or last drop
+        bool used = false;
+    };
+
+    Binding Bind(size_t slot) {
+        TargetEntry& entry = m_targets[slot];
+        DeviceEntry& deviceEntry = m_devices[entry.device];
+        if (!entry.hasView) {
+            entry.view = View();
+            if (!m_traits.CreateView(entry.key, deviceEntry.shared, entry.view)) {
+                Drop(slot);
+                return Binding();
+            }
+            entry.hasView = true;
+        }
+        entry.lastUse = m_clock;
+        deviceEntry.lastUse = m_clock;
+
+        Binding binding;
+        binding.shared = &deviceEntry.shared;
+        binding.view = &entry.view;
+        binding.switched = static_cast<int>(slot) != m_last;
+        m_last = static_cast<int>(slot);
+        if (binding.switched) {
+            for (size_t i = 0; i < kTargets; i++) {
+                if (i != slot && m_targets[i].used && m_targets[i].hasView) ReleaseView(i);
+            }
+        }
+        return binding;
+    }
+
+    void ReleaseView(size_t slot) {
+        m_traits.ReleaseView(m_targets[slot].view);
+        m_targets[slot].hasView = false;
+    }
+
+    void Drop(size_t slot) {
+        TargetEntry& entry = m_targets[slot];
+        if (entry.hasView) ReleaseView(slot);
+        entry.used = false;
+        DeviceEntry& deviceEntry = m_devices[entry.device];
+        deviceEntry.targets--;
+        deviceEntry.lastUse = m_clock;
+        if (m_last == static_cast<int>(slot)) m_last = -1;
+    }
+
+    void ReleaseDevice(size_t slot) {
+        m_traits.ReleaseShared(m_devices[slot].shared);
+        m_devices[slot].used = false;
+    }
+
+    Traits m_traits;
+    TargetEntry m_targets[kTargets];
+    DeviceEntry m_devices[kTargets];    // A device with no target is kept until idle
+    uint64_t m_clock = 0;
+    uint32_t m_maxIdle;
+    int m_last = -1;
+};
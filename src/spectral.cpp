@@ -0,0 +1,264 @@
+#include "spectral.h"
+#include <cmath>
+
+// SPECTRAL_NO_SSE2 forces the scalar butterflies (tests compare both)
+#if !defined(SPECTRAL_NO_SSE2) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#include <emmintrin.h>
+#define SPECTRAL_SSE2 1
+#endif
+
+namespace Spectral {
+    static constexpr double kPi = 3.14159265358979323846;
+    // Frame-domain peak this close to the time-domain one still wins
+    static constexpr float kDomainTolerance = 0.02f;
+
+    static size_t NextPow2(size_t v) {
+        size_t n = 1;
+        while (n < v) n <<= 1;
+        return n;
+    }
+
+    RealFft::RealFft(size_t n) {
+        if (n < 4) n = 4;
+        m_n = NextPow2(n);
+        m_half = m_n / 2;
+
+        unsigned bits = 0;
+        while ((static_cast<size_t>(1) << bits) < m_half) bits++;
+        m_bitrev.resize(m_half);
+        for (size_t i = 0; i < m_half; i++) {
+            unsigned r = 0;
+            for (unsigned b = 0; b < bits; b++) {
+                if (i & (static_cast<size_t>(1) << b)) r |= 1u << (bits - 1 - b);
+            }
+            m_bitrev[i] = r;
+        }
+
+        // Stage with butterfly span m uses twiddles [m - 1, 2m - 1)
+        m_twiddles.resize(m_half > 1 ? m_half - 1 : 1);
+        for (size_t m = 1; m < m_half; m <<= 1) {
+            for (size_t j = 0; j < m; j++) {
+                double angle = -kPi * static_cast<double>(j) / static_cast<double>(m);
+                m_twiddles[m - 1 + j] = std::complex<float>(static_cast<float>(std::cos(angle)),
+                                                            static_cast<float>(std::sin(angle)));
+            }
+        }
+
+        m_split.resize(m_half + 1);
+        for (size_t k = 0; k <= m_half; k++) {
+            double angle = -2.0 * kPi * static_cast<double>(k) / static_cast<double>(m_n);
+            m_split[k] = std::complex<float>(static_cast<float>(std::cos(angle)),
+                                             static_cast<float>(std::sin(angle)));
+        }
+
+        m_work.resize(m_half);
+    }
+
+    void RealFft::ComplexFft(std::complex<float>* data) {
+        const size_t n = m_half;
+
+        for (size_t i = 0; i < n; i++) {
+            size_t j = m_bitrev[i];
+            if (i < j) std::swap(data[i], data[j]);
+        }
+
+        for (size_t m = 1; m < n; m <<= 1) {
+            const std::complex<float>* tw = &m_twiddles[m - 1];
+            const size_t span = m << 1;
+
+#ifdef SPECTRAL_SSE2
+            if (m >= 2) {
+                // Two butterflies per iteration; complex<float> is {re, im} in memory
+                const __m128 signMask = _mm_castsi128_ps(_mm_set_epi32(0, static_cast<int>(0x80000000), 0, static_cast<int>(0x80000000)));
+                for (size_t i = 0; i < n; i += span) {
+                    float* lo = reinterpret_cast<float*>(data + i);
+                    float* hi = reinterpret_cast<float*>(data + i + m);
+                    const float* w = reinterpret_cast<const float*>(tw);
+                    for (size_t j = 0; j < m; j += 2) {
+                        __m128 a = _mm_loadu_ps(lo + 2 * j);
+                        __m128 b = _mm_loadu_ps(hi + 2 * j);
+                        __m128 wv = _mm_loadu_ps(w + 2 * j);
+
+                        __m128 wr = _mm_shuffle_ps(wv, wv, _MM_SHUFFLE(2, 2, 0, 0));
+                        __m128 wi = _mm_shuffle_ps(wv, wv, _MM_SHUFFLE(3, 3, 1, 1));
+                        __m128 bs = _mm_shuffle_ps(b, b, _MM_SHUFFLE(2, 3, 0, 1));
+
+                        // t = b * w  ->  {br*wr - bi*wi, bi*wr + br*wi}
+                        __m128 t = _mm_add_ps(_mm_mul_ps(b, wr), _mm_xor_ps(_mm_mul_ps(bs, wi), signMask));
+
+                        _mm_storeu_ps(lo + 2 * j, _mm_add_ps(a, t));
+                        _mm_storeu_ps(hi + 2 * j, _mm_sub_ps(a, t));
+                    }
+                }
+                continue;
+            }
+#endif
+            for (size_t i = 0; i < n; i += span) {
+                for (size_t j = 0; j < m; j++) {
+                    std::complex<float> u = data[i + j];
+                    std::complex<float> t = data[i + j + m] * tw[j];
+                    data[i + j] = u + t;
+                    data[i + j + m] = u - t;
+                }
+            }
+        }
+    }
+
+    void RealFft::Forward(const float* in, std::complex<float>* out) {
+        // Pack even/odd samples into one half-size complex transform
+        for (size_t k = 0; k < m_half; k++) {
+            m_work[k] = std::complex<float>(in[2 * k], in[2 * k + 1]);
+        }
+        ComplexFft(m_work.data());
+
+        const std::complex<float> minusHalfI(0.0f, -0.5f);
+        for (size_t k = 0; k <= m_half; k++) {
+            std::complex<float> zk = m_work[k % m_half];
+            std::complex<float> znk = std::conj(m_work[(m_half - k) % m_half]);
+            std::complex<float> even = (zk + znk) * 0.5f;
+            std::complex<float> odd = (zk - znk) * minusHalfI;
+            out[k] = even + m_split[k] * odd;
+        }
+    }
+
+    bool Analyzer::Autocorrelate(const float* series, size_t count) {
+        const size_t n = NextPow2(count * 2);
+
+        RealFft* plan = nullptr;
+        for (RealFft& p : m_plans) {
+            if (p.Size() == n) { plan = &p; break; }
+        }
+        if (!plan) {
+            m_plans.emplace_back(n);
+            plan = &m_plans.back();
+        }
+
+        double mean = 0.0;
+        for (size_t i = 0; i < count; i++) mean += series[i];
+        mean /= static_cast<double>(count);
+
+        // Zero padding to 2x keeps the circular correlation from wrapping
+        m_padded.assign(n, 0.0f);
+        for (size_t i = 0; i < count; i++) {
+            m_padded[i] = static_cast<float>(series[i] - mean);
+        }
+
+        m_spectrum.resize(n / 2 + 1);
+        plan->Forward(m_padded.data(), m_spectrum.data());
+
+        // Power spectrum is real and even, so its inverse FFT is a forward FFT / n
+        m_power.resize(n);
+        for (size_t k = 0; k <= n / 2; k++) {
+            float p = std::norm(m_spectrum[k]);
+            m_power[k] = p;
+            if (k > 0 && k < n / 2) m_power[n - k] = p;
+        }
+        plan->Forward(m_power.data(), m_spectrum.data());
+
+        float r0 = m_spectrum[0].real();
+        if (r0 <= 0.0f) return false;
+
+        // Unbiased, normalised autocorrelation
+        m_acf.resize(count);
+        for (size_t lag = 0; lag < count; lag++) {
+            float r = m_spectrum[lag].real();
+            m_acf[lag] = (r / static_cast<float>(count - lag)) / (r0 / static_cast<float>(count));
+        }
+        return true;
+    }
+
+    bool Analyzer::FindPeriod(size_t count, const Options& options, float* lag, float* strength) const {
+        // Need at least two full periods inside the window
+        size_t maxLag = count / 2;
+        size_t minLag = options.minLag < 1 ? 1 : options.minLag;
+        if (maxLag < minLag + 2) return false;
+
+        float best = 0.0f;
+        for (size_t k = minLag; k < maxLag; k++) {
+            if (m_acf[k] > m_acf[k - 1] && m_acf[k] >= m_acf[k + 1] && m_acf[k] > best) {
+                best = m_acf[k];
+            }
+        }
+        if (best < options.minStrength) return false;
+
+        // Harmonics of the true period peak nearly as high; take the shortest lag
+        for (size_t k = minLag; k < maxLag; k++) {
+            if (m_acf[k] > m_acf[k - 1] && m_acf[k] >= m_acf[k + 1] && m_acf[k] >= best * 0.85f) {
+                float y0 = m_acf[k - 1];
+                float y1 = m_acf[k];
+                float y2 = m_acf[k + 1];
+                float denom = y0 - 2.0f * y1 + y2;
+                float delta = (denom != 0.0f) ? 0.5f * (y0 - y2) / denom : 0.0f;
+                if (delta < -0.5f) delta = -0.5f;
+                if (delta > 0.5f) delta = 0.5f;
+
+                *lag = static_cast<float>(k) + delta;
+                *strength = y1 > 1.0f ? 1.0f : y1;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    PeriodicStutter Analyzer::Analyze(const float* frameTimesMs, size_t count, const Options& options) {
+        PeriodicStutter result;
+        if (!frameTimesMs || count < 16) return result;
+
+        double sum = 0.0;
+        double sumSq = 0.0;
+        for (size_t i = 0; i < count; i++) {
+            sum += frameTimesMs[i];
+            sumSq += static_cast<double>(frameTimesMs[i]) * frameTimesMs[i];
+        }
+        double mean = sum / static_cast<double>(count);
+        double variance = sumSq / static_cast<double>(count) - mean * mean;
+        if (mean <= 0.0 || variance < static_cast<double>(options.minStdDevMs) * options.minStdDevMs) {
+            return result;
+        }
+
+        // Frame domain
+        float frameLag = 0.0f;
+        float frameStrength = 0.0f;
+        bool frameFound = Autocorrelate(frameTimesMs, count) &&
+                          FindPeriod(count, options, &frameLag, &frameStrength);
+
+        // Time domain: sample the frame-time series on a uniform grid of one mean frame.
+        // Each grid point takes the duration of the frame that was in flight at that instant.
+        const double step = mean;
+        const size_t gridCount = static_cast<size_t>(sum / step);
+        m_resampled.resize(gridCount);
+        size_t frame = 0;
+        double frameEnd = frameTimesMs[0];
+        for (size_t i = 0; i < gridCount; i++) {
+            double t = (static_cast<double>(i) + 0.5) * step;
+            while (t >= frameEnd && frame + 1 < count) {
+                frame++;
+                frameEnd += frameTimesMs[frame];
+            }
+            m_resampled[i] = frameTimesMs[frame];
+        }
+
+        float timeLag = 0.0f;
+        float timeStrength = 0.0f;
+        bool timeFound = gridCount >= 16 &&
+                         Autocorrelate(m_resampled.data(), gridCount) &&
+                         FindPeriod(gridCount, options, &timeLag, &timeStrength);
+
+        // A steady frame rate makes both series (nearly) the same and their
+        // strengths tie up to rounding: that is a frame-domain pattern
+        if (frameFound && (!timeFound || frameStrength >= timeStrength - kDomainTolerance)) {
+            result.detected = true;
+            result.domain = Domain::Frames;
+            result.periodFrames = frameLag;
+            result.periodMs = static_cast<float>(frameLag * mean);
+            result.strength = frameStrength;
+        } else if (timeFound) {
+            result.detected = true;
+            result.domain = Domain::Time;
+            result.periodMs = static_cast<float>(timeLag * step);
+            result.periodFrames = static_cast<float>(timeLag);
+            result.strength = timeStrength;
+        }
+        return result;
+    }
+}
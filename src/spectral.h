@@ -0,0 +1,70 @@
+#pragma once
+
+#include <complex>
+#include <cstddef>
+#include <vector>
+
+// Periodic stutter detection over frame-time series.
+//
+// The autocorrelation of the (mean-removed) frame-time series is computed via
+// a real FFT and searched for its dominant lag. This is done twice: once with
+// frames as the time base (catches "a spike every 16 frames" from streaming or
+// job batching) and once on a uniform wall-clock grid (catches "a spike every
+// 1.0 s" from a background poller, independent of the frame rate).
+namespace Spectral {
+    // Real-input FFT of a fixed power-of-two size. Output holds bins 0..n/2.
+    class RealFft {
+    public:
+        explicit RealFft(size_t n);
+
+        size_t Size() const { return m_n; }
+        void Forward(const float* in, std::complex<float>* out);
+
+    private:
+        void ComplexFft(std::complex<float>* data);
+
+        size_t m_n = 0;
+        size_t m_half = 0;
+        std::vector<unsigned> m_bitrev;               // half-size bit reversal
+        std::vector<std::complex<float>> m_twiddles;  // per-stage, concatenated
+        std::vector<std::complex<float>> m_split;     // real-FFT split factors
+        std::vector<std::complex<float>> m_work;
+    };
+
+    enum class Domain {
+        None,
+        Frames,     // Period measured in frames
+        Time,       // Period measured in wall-clock time
+    };
+
+    struct PeriodicStutter {
+        bool detected = false;
+        Domain domain = Domain::None;
+        float periodFrames = 0.0f;  // Dominant period, in frames
+        float periodMs = 0.0f;      // Dominant period, in milliseconds
+        float strength = 0.0f;      // Normalised autocorrelation at the period (0..1)
+    };
+
+    struct Options {
+        size_t minLag = 2;          // Ignore frame-to-frame alternation below this
+        float minStrength = 0.3f;   // Autocorrelation needed to report a period
+        float minStdDevMs = 0.5f;   // Series flatter than this never reports
+    };
+
+    // Reusable analyzer; keeps FFT plans and scratch buffers between calls.
+    class Analyzer {
+    public:
+        PeriodicStutter Analyze(const float* frameTimesMs, size_t count, const Options& options = Options());
+
+    private:
+        bool Autocorrelate(const float* series, size_t count);
+        bool FindPeriod(size_t count, const Options& options, float* lag, float* strength) const;
+
+        std::vector<float> m_padded;
+        std::vector<float> m_power;
+        std::vector<float> m_resampled;
+        std::vector<float> m_acf;
+        std::vector<std::complex<float>> m_spectrum;
+        std::vector<RealFft> m_plans;
+    };
+}
@@ -0,0 +1,212 @@
+#include "vtable_hook.h"
+#include <cstdint>
+#include <mutex>
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <cstdio>
+#include <cstdlib>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace {
+    // Serializes protection changes: two hooks on one page must not restore
+    // read-only under each other's write
+    std::mutex g_protectMutex;
+
+    bool CompareExchangeSlot(void** slot, void*& expected, void* value) {
+#ifdef _MSC_VER
+        void* previous = InterlockedCompareExchangePointer(slot, value, expected);
+        bool exchanged = previous == expected;
+        expected = previous;
+        return exchanged;
+#else
+        return __atomic_compare_exchange_n(slot, &expected, value, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+#endif
+    }
+
+    void* LoadSlot(void** slot) {
+#ifdef _MSC_VER
+        return InterlockedCompareExchangePointer(slot, nullptr, nullptr);
+#else
+        return __atomic_load_n(slot, __ATOMIC_ACQUIRE);
+#endif
+    }
+
+    void StoreSlot(void** slot, void* value) {
+#ifdef _MSC_VER
+        InterlockedExchangePointer(slot, value);
+#else
+        __atomic_store_n(slot, value, __ATOMIC_RELEASE);
+#endif
+    }
+
+    // Makes the page holding one slot writable for its lifetime
+    class WritableSlot {
+    public:
+        explicit WritableSlot(void** slot);
+        ~WritableSlot();
+        bool IsWritable() const { return m_writable; }
+
+    private:
+        void* m_page = nullptr;
+        bool m_writable = false;
+        bool m_restore = false;
+#ifdef _WIN32
+        DWORD m_protect = 0;
+#else
+        int m_protect = 0;
+#endif
+    };
+
+#ifdef _WIN32
+
+    WritableSlot::WritableSlot(void** slot) : m_page(slot) {
+        MEMORY_BASIC_INFORMATION info;
+        if (!VirtualQuery(slot, &info, sizeof(info)) || info.State != MEM_COMMIT) return;
+
+        const DWORD writable = PAGE_READWRITE | PAGE_WRITECOPY | PAGE_EXECUTE_READWRITE | PAGE_EXECUTE_WRITECOPY;
+        if (info.Protect & writable) {
+            m_writable = true;
+            return;
+        }
+        // Keep execute when .rdata shares pages with code
+        const DWORD executable = PAGE_EXECUTE | PAGE_EXECUTE_READ;
+        DWORD protect = (info.Protect & executable) ? PAGE_EXECUTE_READWRITE : PAGE_READWRITE;
+        m_writable = m_restore = VirtualProtect(slot, sizeof(void*), protect, &m_protect) != FALSE;
+    }
+
+    WritableSlot::~WritableSlot() {
+        if (!m_restore) return;
+        DWORD unused;
+        VirtualProtect(m_page, sizeof(void*), m_protect, &unused);
+    }
+
+#else
+
+    // Protection of the mapping holding address, from /proc/self/maps
+    bool QueryProtection(uintptr_t address, int* protect) {
+        FILE* maps = std::fopen("/proc/self/maps", "r");
+        if (!maps) return false;
+        char line[512];
+        bool found = false;
+        while (std::fgets(line, sizeof(line), maps)) {
+            char* end = nullptr;
+            uintptr_t start = std::strtoull(line, &end, 16);
+            if (*end != '-') continue;
+            uintptr_t stop = std::strtoull(end + 1, &end, 16);
+            if (address < start || address >= stop) continue;
+            const char* perms = end + 1;
+            *protect = (perms[0] == 'r' ? PROT_READ : 0) | (perms[1] == 'w' ? PROT_WRITE : 0) |
+                       (perms[2] == 'x' ? PROT_EXEC : 0);
+            found = true;
+            break;
+        }
+        std::fclose(maps);
+        return found;
+    }
+
+    WritableSlot::WritableSlot(void** slot) {
+        uintptr_t pageSize = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+        uintptr_t address = reinterpret_cast<uintptr_t>(slot);
+        m_page = reinterpret_cast<void*>(address & ~(pageSize - 1));
+        if (!QueryProtection(address, &m_protect)) return;
+        if (m_protect & PROT_WRITE) {
+            m_writable = true;
+            return;
+        }
+        m_writable = m_restore = mprotect(m_page, pageSize, m_protect | PROT_WRITE) == 0;
+    }
+
+    WritableSlot::~WritableSlot() {
+        if (m_restore) mprotect(m_page, static_cast<size_t>(sysconf(_SC_PAGESIZE)), m_protect);
+    }
+
+#endif
+}
+
+bool VtableSlotHook::Install(void** slot, void* detour, void** original) {
+    if (m_slot || !slot || !detour || !original) return false;
+
+    std::lock_guard<std::mutex> lock(g_protectMutex);
+    WritableSlot writable(slot);
+    if (!writable.IsWritable()) return false;
+
+    void* current = LoadSlot(slot);
+    do {
+        if (current == detour) return false;    // Already hooked with this detour
+        *original = current;
+    } while (!CompareExchangeSlot(slot, current, detour));
+
+    m_slot = slot;
+    m_detour = detour;
+    m_original = current;
+    return true;
+}
+
+bool VtableSlotHook::Uninstall() {
+    if (!m_slot) return true;
+
+    std::lock_guard<std::mutex> lock(g_protectMutex);
+    WritableSlot writable(m_slot);
+    if (!writable.IsWritable()) return false;
+
+    void* expected = m_detour;
+    if (!CompareExchangeSlot(m_slot, expected, m_original)) return false;     // Chained over
+
+    m_slot = nullptr;
+    m_detour = nullptr;
+    m_original = nullptr;
+    return true;
+}
+
+VtableShadowHook::~VtableShadowHook() {
+    // Still reachable through a hook chained over ours: keep it
+    if (!Uninstall()) m_shadow.release();
+}
+
+bool VtableShadowHook::Install(void* object, size_t slotCount) {
+    if (m_object || !object || slotCount == 0) return false;
+    void** vptr = static_cast<void**>(object);
+    void** vtable = static_cast<void**>(LoadSlot(vptr));
+    if (!vtable) return false;
+
+    std::unique_ptr<void*[]> shadow(new void*[kPrefixEntries + slotCount]);
+    void** first = vtable - kPrefixEntries;
+    for (size_t i = 0; i < kPrefixEntries + slotCount; i++) shadow[i] = first[i];
+
+    // The copy is complete before the object can reach it
+    void* expected = vtable;
+    if (!CompareExchangeSlot(vptr, expected, shadow.get() + kPrefixEntries)) return false;
+
+    m_object = vptr;
+    m_vtable = vtable;
+    m_slotCount = slotCount;
+    m_shadow = std::move(shadow);
+    return true;
+}
+
+bool VtableShadowHook::Uninstall() {
+    if (!m_object) return true;
+    void* expected = m_shadow.get() + kPrefixEntries;
+    if (!CompareExchangeSlot(m_object, expected, m_vtable)) return false;     // Chained over
+    m_object = nullptr;
+    m_vtable = nullptr;
+    m_slotCount = 0;
+    return true;
+}
+
+bool VtableShadowHook::Hook(size_t index, void* detour, void** original) {
+    if (!m_object || index >= m_slotCount || !detour || !original) return false;
+    *original = m_vtable[index];
+    StoreSlot(Shadow() + index, detour);
+    return true;
+}
+
+bool VtableShadowHook::Unhook(size_t index) {
+    if (!m_object || index >= m_slotCount) return false;
+    StoreSlot(Shadow() + index, m_vtable[index]);
+    return true;
+}
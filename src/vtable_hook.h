@@ -0,0 +1,95 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+
+// Hooks a virtual function by replacing its slot in the class vtable instead
+// of patching the function's code (MinHook): no trampoline, no thread
+// suspension, and install/uninstall are one compare-exchange of a pointer,
+// so a thread calling through the slot sees either the old or the new
+// target. Every object of that class is affected (like an inline detour).
+//
+// Chaining: Install takes whatever the slot holds as the original, so an
+// overlay that hooked the slot (or the function body) earlier keeps running
+// behind us. Uninstall only restores the slot while it still points at our
+// detour; if another hook has since replaced it, ours stays in its chain
+// (and must keep forwarding to the original) and Uninstall returns false.
+//
+// Portable: VirtualProtect on Windows, mprotect on Linux (where it is tested
+// against plain C++ virtual classes). The previous page protection is
+// restored after each write.
+class VtableSlotHook {
+public:
+    VtableSlotHook() = default;
+    VtableSlotHook(const VtableSlotHook&) = delete;
+    VtableSlotHook& operator=(const VtableSlotHook&) = delete;
+
+    // Address of vtable[index] for an object with a single vtable pointer
+    static void** SlotOf(const void* object, size_t index) {
+        return *static_cast<void** const*>(object) + index;
+    }
+
+    // *original is written before the slot points at detour, so the detour
+    // can call it from the first invocation on
+    bool Install(void** slot, void* detour, void** original);
+    bool Install(const void* object, size_t index, void* detour, void** original) {
+        return object && Install(SlotOf(object, index), detour, original);
+    }
+
+    bool Uninstall();
+
+    bool IsInstalled() const { return m_slot != nullptr; }
+    void* Original() const { return m_original; }
+
+private:
+    void** m_slot = nullptr;
+    void* m_detour = nullptr;
+    void* m_original = nullptr;
+};
+
+// Per-instance variant: the object gets a private copy of its vtable (a
+// shadow) and is switched to it with one compare-exchange of its vtable
+// pointer. Slots replaced in the shadow affect that object only, and the
+// class vtable is never written, so no page protection changes. The copy
+// includes the entries before the address point (offset-to-top and RTTI on
+// Itanium, the complete object locator on MSVC), so typeid and dynamic_cast
+// keep working; classes with virtual bases are not supported.
+//
+// Chaining works like VtableSlotHook: Install copies whatever vtable the
+// object uses now (another overlay's shadow included), and Uninstall only
+// switches back while the object still uses our shadow. The object must be
+// alive for Install and Uninstall. The shadow stays allocated until the hook
+// is destroyed or installed again, so a call that loaded the vtable pointer
+// just before Uninstall still finds it; one still in use by a hook chained
+// over ours is never freed.
+class VtableShadowHook {
+public:
+#ifdef _MSC_VER
+    static constexpr size_t kPrefixEntries = 1;
+#else
+    static constexpr size_t kPrefixEntries = 2;
+#endif
+
+    VtableShadowHook() = default;
+    ~VtableShadowHook();
+    VtableShadowHook(const VtableShadowHook&) = delete;
+    VtableShadowHook& operator=(const VtableShadowHook&) = delete;
+
+    // slotCount: entries to copy, at least every index that will be hooked
+    bool Install(void* object, size_t slotCount);
+    bool Uninstall();
+
+    // Replaces one entry of the shadow; *original is the entry of the vtable
+    // the object used before Install
+    bool Hook(size_t index, void* detour, void** original);
+    bool Unhook(size_t index);
+
+    bool IsInstalled() const { return m_object != nullptr; }
+    void** Shadow() const { return m_shadow ? m_shadow.get() + kPrefixEntries : nullptr; }
+
+private:
+    void** m_object = nullptr;      // The object's vtable pointer
+    void** m_vtable = nullptr;      // What it pointed at before Install
+    size_t m_slotCount = 0;
+    std::unique_ptr<void*[]> m_shadow;
+};
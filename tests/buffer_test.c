@@ -0,0 +1,254 @@
+// buffer.c on Linux (buffer_os.c): slots near origins in libc, the test
+// binary and an anonymous mapping stay within reach of a rel32 jump, are
+// aligned and never overlap; the block index stays sorted and its use
+// counts match the live slots; freed blocks are unmapped, and so are blocks
+// still in use at UninitializeBuffer; and the last block / free hints spare
+// the address space scan for nearby origins.
+
+#include <sys/mman.h>
+
+#include "test_util.h"
+
+#include "buffer_os.h"
+
+// Counts the region queries made by buffer.c, which is compiled in here
+static long s_queries;
+
+static BOOL CountedQueryRegion(ULONG_PTR address, OS_REGION* pRegion) {
+    s_queries++;
+    return OsQueryRegion(address, pRegion);
+}
+
+#define OsQueryRegion CountedQueryRegion
+#include "buffer.c"
+#undef OsQueryRegion
+
+#define MAX_LIVE 6000
+#define MAX_ORIGINS 16
+#define MAX_BATCH 64
+
+static uint64_t s_rng = 0x2545F4914F6CDD1Dull;
+
+static uint32_t Rand(void) {
+    s_rng ^= s_rng << 13;
+    s_rng ^= s_rng >> 7;
+    s_rng ^= s_rng << 17;
+    return (uint32_t)s_rng;
+}
+
+static ULONG_PTR s_origins[MAX_ORIGINS];
+static int s_originCount;
+
+__attribute__((noinline)) static int LocalFunction(int x) {
+    return x + 1;
+}
+
+static void AddOrigin(const void* p) {
+    s_origins[s_originCount++] = (ULONG_PTR)p;
+}
+
+static long long Distance(const void* p, ULONG_PTR origin) {
+    long long d = (long long)((ULONG_PTR)p - origin);
+    return d < 0 ? -d : d;
+}
+
+// Executable anonymous mappings, i.e. blocks still committed
+static int CountRwxMappings(void) {
+    char line[512];
+    int count = 0;
+    FILE* maps = fopen("/proc/self/maps", "r");
+    CHECK(maps != NULL);
+    while (fgets(line, sizeof(line), maps)) {
+        char* perms = strchr(line, ' ');
+        if (perms && strncmp(perms + 1, "rwxp", 4) == 0) count++;
+    }
+    fclose(maps);
+    return count;
+}
+
+static void CheckIndex(int live) {
+    UINT used = 0;
+    for (UINT k = 0; k < g_blocks.size; k++) {
+        if (k > 0) CHECK(g_blocks.pItems[k - 1] < g_blocks.pItems[k]);
+        CHECK(((ULONG_PTR)g_blocks.pItems[k] & (MEMORY_BLOCK_SIZE - 1)) == 0);
+        used += g_blocks.pItems[k]->usedCount;
+    }
+    CHECK(used == (UINT)live);
+}
+
+static void CheckSlot(void* slot, ULONG_PTR origin) {
+    CHECK(slot != NULL);
+    CHECK(Distance(slot, origin) <= MAX_MEMORY_RANGE + MEMORY_BLOCK_SIZE);
+    CHECK(((ULONG_PTR)slot & (MEMORY_SLOT_SIZE - 1)) == 0);
+    // Not counted: only the allocator's own queries matter
+    long queries = s_queries;
+    CHECK(IsExecutableAddress(slot));
+    s_queries = queries;
+}
+
+// The scan runs once per new region; neighbouring origins reuse its block
+static void TestRegionCache(void) {
+    static void* slots[600];
+    const ULONG_PTR origin = (ULONG_PTR)LocalFunction;
+    const int baseRwx = CountRwxMappings();
+
+    s_queries = 0;
+    slots[0] = AllocateBuffer((LPVOID)origin);
+    CheckSlot(slots[0], origin);
+    CHECK(s_queries > 0);
+
+    // A block holds 1023 slots; the rest of the first page is ready, the
+    // next pages are committed without querying
+    s_queries = 0;
+    for (int i = 1; i < 600; i++) {
+        slots[i] = AllocateBuffer((LPVOID)(origin + (ULONG_PTR)i * 64));
+        CheckSlot(slots[i], origin);
+        CHECK((ULONG_PTR)slots[i] - (ULONG_PTR)slots[0] < MEMORY_BLOCK_SIZE);
+    }
+    CHECK(s_queries == 0);
+    CHECK(g_blocks.size == 1);
+    CheckIndex(600);
+
+    // Slots are handed out in address order from a fresh block
+    for (int i = 1; i < 600; i++) CHECK(slots[i] == (uint8_t*)slots[i - 1] + MEMORY_SLOT_SIZE);
+
+    // Freeing the whole block unmaps it and remembers the region
+    for (int i = 0; i < 600; i++) FreeBuffer(slots[i]);
+    CHECK(g_blocks.size == 0 && g_pLastBlock == NULL);
+    CHECK(CountRwxMappings() == baseRwx);
+
+    s_queries = 0;
+    slots[0] = AllocateBuffer((LPVOID)origin);
+    CheckSlot(slots[0], origin);
+    CHECK(s_queries == 0);
+    FreeBuffer(slots[0]);
+
+    // Not one of ours: ignored
+    FreeBuffer(&s_queries);
+    CHECK(!IsExecutableAddress(&s_queries));
+    CHECK(g_blocks.size == 0);
+}
+
+// A batch over one module needs a single scan
+static void TestBatch(void) {
+    LPVOID origins[MAX_BATCH];
+    LPVOID buffers[MAX_BATCH];
+    for (int i = 0; i < MAX_BATCH; i++) origins[i] = (LPVOID)((ULONG_PTR)printf + (ULONG_PTR)i * 0x1000);
+
+    s_queries = 0;
+    CHECK(AllocateBuffers(origins, buffers, MAX_BATCH) == MAX_BATCH);
+    CHECK(s_queries <= 64);
+    for (int i = 0; i < MAX_BATCH; i++) {
+        CheckSlot(buffers[i], (ULONG_PTR)origins[i]);
+        for (int j = 0; j < i; j++) CHECK(buffers[i] != buffers[j]);
+    }
+    CheckIndex(MAX_BATCH);
+    for (int i = 0; i < MAX_BATCH; i++) FreeBuffer(buffers[i]);
+    CHECK(g_blocks.size == 0);
+}
+
+// Random allocations, batches and frees over origins in several modules
+static void Fuzz(int steps) {
+    static void* live[MAX_LIVE];
+    static ULONG_PTR liveOrigin[MAX_LIVE];
+    int count = 0;
+    const int baseRwx = CountRwxMappings();
+
+    for (int step = 0; step < steps; step++) {
+        uint32_t op = Rand() % 100;
+        if (count < MAX_LIVE && (op < 55 || count == 0)) {
+            LPVOID origins[MAX_BATCH];
+            LPVOID buffers[MAX_BATCH];
+            int batch = (op % 7 == 0) ? 1 + (int)(Rand() % MAX_BATCH) : 1;
+            if (batch > MAX_LIVE - count) batch = MAX_LIVE - count;
+            for (int k = 0; k < batch; k++) {
+                origins[k] = (LPVOID)(s_origins[Rand() % s_originCount] + (Rand() % 0x10000));
+            }
+            CHECK(AllocateBuffers(origins, buffers, (UINT)batch) == (UINT)batch);
+            for (int k = 0; k < batch; k++) {
+                CheckSlot(buffers[k], (ULONG_PTR)origins[k]);
+                memset(buffers[k], 0xCC, MEMORY_SLOT_SIZE);
+                live[count] = buffers[k];
+                liveOrigin[count] = (ULONG_PTR)origins[k];
+                count++;
+            }
+        } else {
+            int i = (int)(Rand() % (uint32_t)count);
+            CHECK(*(uint8_t*)live[i] == 0xCC);
+            FreeBuffer(live[i]);
+            count--;
+            live[i] = live[count];
+            liveOrigin[i] = liveOrigin[count];
+        }
+        if (step % 997 == 0) CheckIndex(count);
+    }
+    CheckIndex(count);
+
+    // Every live slot is its own: tag them all, then read the tags back
+    for (int k = 0; k < count; k++) memset(live[k], 0, MEMORY_SLOT_SIZE);
+    for (int k = 0; k < count; k++) {
+        CHECK(*(int*)live[k] == 0);
+        *(int*)live[k] = k + 1;
+    }
+    for (int k = 0; k < count; k++) CHECK(*(int*)live[k] == k + 1);
+
+    for (int k = 0; k < count; k++) FreeBuffer(live[k]);
+    CHECK(g_blocks.size == 0);
+    CHECK(CountRwxMappings() == baseRwx);
+}
+
+// MH_Uninitialize releases blocks whose slots were never freed
+static void TestUninitializeLive(void) {
+    static void* slots[3 * MAX_BATCH];
+    const int baseRwx = CountRwxMappings();
+    int count = 0;
+    for (int k = 0; k < s_originCount && count < 3 * MAX_BATCH; k++) {
+        for (int i = 0; i < MAX_BATCH / 2; i++) {
+            slots[count] = AllocateBuffer((LPVOID)(s_origins[k] + (ULONG_PTR)i * 0x100));
+            CheckSlot(slots[count], s_origins[k] + (ULONG_PTR)i * 0x100);
+            count++;
+        }
+    }
+    CheckIndex(count);
+    CHECK(g_blocks.size > 1 && CountRwxMappings() > baseRwx);
+
+    UninitializeBuffer();
+    CHECK(g_blocks.pItems == NULL && g_blocks.size == 0 && g_pLastBlock == NULL);
+    CHECK(CountRwxMappings() == baseRwx);
+    for (int i = 0; i < count; i++) CHECK(!IsExecutableAddress(slots[i]));
+
+    // Starts over with an empty index and no hints, so it scans again
+    InitializeBuffer();
+    s_queries = 0;
+    slots[0] = AllocateBuffer((LPVOID)s_origins[0]);
+    CheckSlot(slots[0], s_origins[0]);
+    CHECK(s_queries > 0);
+    CheckIndex(1);
+    FreeBuffer(slots[0]);
+    CHECK(g_blocks.size == 0);
+}
+
+int main(void) {
+    void* anonymous = mmap(NULL, 0x100000, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    CHECK(anonymous != MAP_FAILED);
+
+    AddOrigin((const void*)printf);
+    AddOrigin((const void*)memcpy);
+    AddOrigin((const void*)qsort);
+    AddOrigin((const void*)fopen);
+    AddOrigin((const void*)LocalFunction);
+    AddOrigin((const void*)main);
+    AddOrigin(anonymous);
+
+    InitializeBuffer();
+    TestRegionCache();
+    TestBatch();
+    TestUninitializeLive();
+    for (int round = 0; round < 4; round++) Fuzz(40000);
+    UninitializeBuffer();
+    CHECK(g_blocks.pItems == NULL && g_blocks.size == 0);
+
+    munmap(anonymous, 0x100000);
+    printf("buffer: ok\n");
+    return 0;
+}
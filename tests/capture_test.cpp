@@ -0,0 +1,136 @@
+// Capture::Writer and Reader round trip: frames written through the writer
+// thread come back complete and in order, summary chunks written before,
+// between and after frame chunks keep their place, a truncated trailing
+// chunk or a foreign file is handled, and a Writer can be reopened.
+
+#include "capture.h"
+#include "test_util.h"
+
+#include <cstring>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+    std::string s_dir;
+
+    Capture::FrameRecord Frame(uint64_t i) {
+        Capture::FrameRecord frame = {};
+        frame.presentQpc = 1000 + i * 16;
+        frame.presentTicks = static_cast<uint32_t>(i * 7);
+        frame.overlayTicks = static_cast<uint32_t>(i % 13);
+        frame.swapChainId = i % 5 == 4 ? 2 : 1;
+        frame.flags = i % 2 ? Capture::kFrameVsync : 0;
+        return frame;
+    }
+
+    Capture::FileHeader Header() {
+        Capture::FileHeader header = {};
+        header.qpcFrequency = 10000000;
+        header.startQpc = 1000;
+        header.pid = 42;
+        std::strcpy(header.exeName, "game.exe");
+        return header;
+    }
+
+    // Frames, with SESS before them, HMAP in the middle and QSKT at the end
+    void TestRoundTrip(Capture::Writer& writer, const std::string& path, size_t count) {
+        const uint32_t session = 7;
+        const uint32_t heatmap = 8;
+        const uint64_t sketch = 9;
+        CHECK(writer.Open(path.c_str(), Header()) && writer.IsOpen());
+        CHECK(writer.WriteChunk(Capture::kChunkSession, &session, sizeof(session)));
+        for (size_t i = 0; i < count; i++) {
+            writer.Append(Frame(i));
+            if (i == count / 2) CHECK(writer.WriteChunk(Capture::kChunkHeatmap, &heatmap, sizeof(heatmap)));
+        }
+        if (count == 0) CHECK(writer.WriteChunk(Capture::kChunkHeatmap, &heatmap, sizeof(heatmap)));
+        CHECK(writer.WriteChunk(Capture::kChunkSketch, &sketch, sizeof(sketch)));
+        writer.Close();
+        CHECK(!writer.IsOpen());
+
+        Capture::Reader reader;
+        CHECK(reader.Open(path.c_str()));
+        CHECK(reader.Header().magic == Capture::kMagic && reader.Header().pid == 42);
+        CHECK(std::strcmp(reader.Header().exeName, "game.exe") == 0);
+        CHECK(reader.FrameCount() == count);
+
+        size_t next = 0;
+        bool inOrder = true;
+        reader.ForEachFrame([&](const Capture::FrameRecord& frame) {
+            const Capture::FrameRecord expected = Frame(next++);
+            inOrder &= std::memcmp(&frame, &expected, sizeof(frame)) == 0;
+        });
+        CHECK(inOrder && next == count);
+
+        // Chunk order: SESS, frames up to count / 2, HMAP, the rest, QSKT
+        const std::vector<Capture::Chunk>& chunks = reader.Chunks();
+        CHECK(chunks.front().tag == Capture::kChunkSession && chunks.back().tag == Capture::kChunkSketch);
+        size_t framesBeforeHeatmap = 0;
+        for (const Capture::Chunk& chunk : chunks) {
+            if (chunk.tag == Capture::kChunkHeatmap) break;
+            if (chunk.tag == Capture::kChunkFrames) framesBeforeHeatmap += chunk.size / sizeof(Capture::FrameRecord);
+        }
+        CHECK(framesBeforeHeatmap == (count ? count / 2 + 1 : 0));
+        const Capture::Chunk* found = reader.FindChunk(Capture::kChunkHeatmap);
+        CHECK(found && found->size == 8 && *static_cast<const uint32_t*>(found->data) == heatmap);
+        found = reader.FindChunk(Capture::kChunkSketch);
+        CHECK(found && *static_cast<const uint64_t*>(found->data) == sketch);
+
+        uint32_t swapChain = 0;
+        size_t frames = 0;
+        CHECK(reader.FindPrimarySwapChain(&swapChain, &frames) == (count > 0));
+        if (count > 0) CHECK(swapChain == 1 && frames == count - (count + 1) / 5);
+    }
+
+    void TestDamaged() {
+        const std::string path = s_dir + "/damaged.fpsc";
+        {
+            Capture::Writer writer;
+            CHECK(writer.Open(path.c_str(), Header()));
+            for (size_t i = 0; i < 10000; i++) writer.Append(Frame(i));
+        }   // Destructor closes
+
+        Capture::Reader reader;
+        CHECK(reader.Open(path.c_str()) && reader.FrameCount() == 10000);
+        const size_t lastChunk = reader.Chunks().back().size;
+        reader.Close();
+
+        // Crash mid-write: the last chunk is cut short and skipped
+        CHECK(truncate(path.c_str(), static_cast<off_t>(sizeof(Capture::FileHeader) + sizeof(Capture::ChunkHeader) * 3
+                                                         + 2 * 4096 * sizeof(Capture::FrameRecord) + lastChunk / 2)) == 0);
+        CHECK(reader.Open(path.c_str()) && reader.FrameCount() == 2 * 4096);
+
+        // Not a capture
+        std::FILE* f = std::fopen(path.c_str(), "wb");
+        std::vector<unsigned char> junk(4096, 0x5A);
+        CHECK(f && std::fwrite(junk.data(), 1, junk.size(), f) == junk.size());
+        std::fclose(f);
+        CHECK(!reader.Open(path.c_str()));
+        CHECK(truncate(path.c_str(), 10) == 0);
+        CHECK(!reader.Open(path.c_str()));
+        CHECK(!reader.Open((s_dir + "/missing.fpsc").c_str()));
+    }
+}
+
+int main() {
+    char dir[] = "/tmp/capture_test.XXXXXX";
+    CHECK(mkdtemp(dir) != nullptr);
+    s_dir = dir;
+
+    Capture::Writer writer;
+    CHECK(!writer.WriteChunk(Capture::kChunkSession, "x", 1));      // Not open
+    CHECK(!writer.Open((s_dir + "/missing/x.fpsc").c_str(), Header()) && !writer.IsOpen());
+
+    // One Writer reused: no frames, less than a chunk, exact chunks, many chunks
+    const size_t counts[] = { 0, 1, 4095, 4096, 8192, 50001, 200000 };
+    for (size_t count : counts) {
+        TestRoundTrip(writer, s_dir + "/round_trip.fpsc", count);
+    }
+    TestDamaged();
+
+    std::string cleanup = "rm -rf " + s_dir;
+    CHECK(std::system(cleanup.c_str()) == 0);
+    std::printf("capture: ok\n");
+    return 0;
+}
@@ -0,0 +1,347 @@
+// ConfigSchema: every kind parses what its comment promises and refuses the
+// rest with the member untouched (bool words and numbers, Int/Float clamped
+// or rejected by range, colors with or without '#', enum names, aliases and
+// numbers, F1..F24 and virtual-key numbers, strings cut at a UTF-8 code
+// point boundary), and Write followed by Apply gives back every stored
+// member of OverlayConfig and FpsConfig.
+
+#include "config_schema.h"
+#include "fps_config.h"
+#include "ini_file.h"
+#include "overlay_config.h"
+#include "test_util.h"
+
+#include <cstring>
+#include <string>
+
+// X(kind, member, section, key, def, min, max, clamp, names, comment)
+#define TEST_CONFIG_FIELDS(X) \
+    X(Bool,   flag,      "Main",  "Flag",      false, 0.0, 0.0,   ConfigSchema::kClamp,  nullptr, "0/1") \
+    X(Int,    clamped,   "Main",  "Clamped",   5,     1.0, 10.0,  ConfigSchema::kClamp,  nullptr, nullptr) \
+    X(Int,    rejected,  "Main",  "Rejected",  5,     1.0, 10.0,  ConfigSchema::kReject, nullptr, nullptr) \
+    X(Int,    anyInt,    "Main",  "AnyInt",    0,     0.0, 0.0,   ConfigSchema::kReject, nullptr, nullptr) \
+    X(Float,  fClamped,  "Main",  "FClamped",  0.5f,  0.0, 1.0,   ConfigSchema::kClamp,  nullptr, nullptr) \
+    X(Float,  fRejected, "Main",  "FRejected", 0.5f,  0.0, 1.0,   ConfigSchema::kReject, nullptr, nullptr) \
+    X(Color,  color,     "Main",  "Color",     0xFF000000u, 0.0, 0.0, ConfigSchema::kClamp, nullptr, nullptr) \
+    X(Enum,   corner,    "Main",  "Corner",    kCornerTopRight, 0.0, 0.0, ConfigSchema::kReject, kOverlayCornerNames, nullptr) \
+    X(Key,    key,       "Main",  "Key",       ConfigSchema::kVkF1, 1.0, 254.0, ConfigSchema::kReject, nullptr, nullptr) \
+    X(String, name,      "Main",  "Name",      "",    0.0, 8.0,   ConfigSchema::kClamp,  nullptr, nullptr)
+
+namespace {
+    struct TestConfig {
+        TEST_CONFIG_FIELDS(CONFIG_SCHEMA_MEMBER)
+    };
+
+#define TEST_CONFIG_FIELD(kind, member, section, key, def, min, max, clamp, names, comment) \
+    CONFIG_SCHEMA_FIELD(TestConfig, kind, member, section, key, def, min, max, clamp, names, comment)
+    constexpr ConfigSchema::Field kTestFields[] = {
+        TEST_CONFIG_FIELDS(TEST_CONFIG_FIELD)
+    };
+#undef TEST_CONFIG_FIELD
+
+    const ConfigSchema::Field& FieldOf(const char* key) {
+        for (const ConfigSchema::Field& field : kTestFields) {
+            if (std::strcmp(field.key, key) == 0) return field;
+        }
+        CHECK(false);
+        return kTestFields[0];
+    }
+
+    // Parses into a fresh default config
+    bool Parse(const char* key, const char* text, TestConfig* config) {
+        *config = TestConfig();
+        return ConfigSchema::ParseValue(FieldOf(key), text, config);
+    }
+
+    std::string Format(const char* key, const TestConfig& config, bool boolWords = false) {
+        std::string out;
+        ConfigSchema::FormatValue(FieldOf(key), &config, boolWords, out);
+        return out;
+    }
+
+    void TestBool() {
+        TestConfig c;
+        const char* yes[] = { "true", "TRUE", "Yes", "on", "1", "42", "-1", "0x10", "1 " };
+        for (const char* text : yes) CHECK(Parse("Flag", text, &c) && c.flag);
+        const char* no[] = { "false", "False", "NO", "off", "0", "0x0" };
+        for (const char* text : no) {
+            c = TestConfig();
+            c.flag = true;
+            CHECK(ConfigSchema::ParseValue(FieldOf("Flag"), text, &c) && !c.flag);
+        }
+        const char* bad[] = { "", "maybe", "2.5", "truee", "y", "1x" };
+        for (const char* text : bad) {
+            c = TestConfig();
+            c.flag = true;
+            CHECK(!ConfigSchema::ParseValue(FieldOf("Flag"), text, &c) && c.flag);
+        }
+        c.flag = true;
+        CHECK(Format("Flag", c) == "1" && Format("Flag", c, true) == "true");
+        c.flag = false;
+        CHECK(Format("Flag", c) == "0" && Format("Flag", c, true) == "false");
+    }
+
+    void TestInt() {
+        TestConfig c;
+        CHECK(Parse("Clamped", "7", &c) && c.clamped == 7);
+        CHECK(Parse("Clamped", "0x8", &c) && c.clamped == 8);
+        CHECK(Parse("Clamped", "1", &c) && c.clamped == 1);
+        CHECK(Parse("Clamped", "10", &c) && c.clamped == 10);
+        CHECK(Parse("Clamped", "0", &c) && c.clamped == 1);
+        CHECK(Parse("Clamped", "-5", &c) && c.clamped == 1);
+        CHECK(Parse("Clamped", "99", &c) && c.clamped == 10);
+        CHECK(Parse("Clamped", "99999999999999", &c) && c.clamped == 10);
+        CHECK(!Parse("Clamped", "abc", &c) && c.clamped == 5);
+        CHECK(!Parse("Clamped", "5x", &c) && c.clamped == 5);
+        CHECK(!Parse("Clamped", "", &c) && c.clamped == 5);
+
+        CHECK(Parse("Rejected", "10", &c) && c.rejected == 10);
+        CHECK(!Parse("Rejected", "0", &c) && c.rejected == 5);
+        CHECK(!Parse("Rejected", "11", &c) && c.rejected == 5);
+        CHECK(!Parse("Rejected", "-3", &c) && c.rejected == 5);
+
+        // No range: anything that fits
+        CHECK(Parse("AnyInt", "-2000000", &c) && c.anyInt == -2000000);
+        CHECK(Format("AnyInt", c) == "-2000000");
+    }
+
+    void TestFloat() {
+        TestConfig c;
+        CHECK(Parse("FClamped", "0.25", &c) && c.fClamped == 0.25f);
+        CHECK(Parse("FClamped", "1", &c) && c.fClamped == 1.0f);
+        CHECK(Parse("FClamped", "2.5", &c) && c.fClamped == 1.0f);
+        CHECK(Parse("FClamped", "-1e9", &c) && c.fClamped == 0.0f);
+        CHECK(!Parse("FClamped", "nan", &c) && c.fClamped == 0.5f);
+        CHECK(!Parse("FClamped", "inf", &c) && c.fClamped == 0.5f);
+        CHECK(!Parse("FClamped", "x", &c) && c.fClamped == 0.5f);
+
+        CHECK(Parse("FRejected", "0.75", &c) && c.fRejected == 0.75f);
+        CHECK(!Parse("FRejected", "1.5", &c) && c.fRejected == 0.5f);
+        CHECK(!Parse("FRejected", "-0.1", &c) && c.fRejected == 0.5f);
+        CHECK(Format("FRejected", c) == "0.5");
+    }
+
+    void TestColor() {
+        TestConfig c;
+        CHECK(Parse("Color", "#FF102030", &c) && c.color == 0xFF102030u);
+        CHECK(Parse("Color", "FF102030", &c) && c.color == 0xFF102030u);
+        CHECK(Parse("Color", "0xFF102030", &c) && c.color == 0xFF102030u);
+        CHECK(Parse("Color", "#80abcdef", &c) && c.color == 0x80ABCDEFu);
+        CHECK(Parse("Color", "102030", &c) && c.color == 0x00102030u);
+        CHECK(Parse("Color", "#FFFFFFFF", &c) && c.color == 0xFFFFFFFFu);
+        const char* bad[] = { "", "#", "##FF102030", "GG102030", "#1FFFFFFFF", "-1", "#FF 1020" };
+        for (const char* text : bad) CHECK(!Parse("Color", text, &c) && c.color == 0xFF000000u);
+        c.color = 0x0A0B0C0Du;
+        CHECK(Format("Color", c) == "0A0B0C0D");
+    }
+
+    void TestEnum() {
+        TestConfig c;
+        CHECK(Parse("Corner", "BottomLeft", &c) && c.corner == kCornerBottomLeft);
+        CHECK(Parse("Corner", "bottomleft", &c) && c.corner == kCornerBottomLeft);
+        CHECK(Parse("Corner", "CUSTOM", &c) && c.corner == kCornerCustom);
+
+        // Aliases map to the same value and write back as the first name
+        CHECK(Parse("Corner", "BR", &c) && c.corner == kCornerBottomRight);
+        CHECK(Format("Corner", c) == "BottomRight");
+        CHECK(Parse("Corner", "tl", &c) && c.corner == kCornerTopLeft);
+        CHECK(Format("Corner", c) == "TopLeft");
+
+        CHECK(Parse("Corner", "0", &c) && c.corner == kCornerTopLeft);
+        CHECK(Parse("Corner", "4", &c) && c.corner == kCornerCustom);
+        const char* bad[] = { "", "5", "-1", "0x1", "Middle", "Top", "TopLeftX" };
+        for (const char* text : bad) CHECK(!Parse("Corner", text, &c) && c.corner == kCornerTopRight);
+
+        // A value with no name (only reachable in memory) writes its number
+        c.corner = 9;
+        CHECK(Format("Corner", c) == "9");
+    }
+
+    void TestKey() {
+        TestConfig c;
+        for (int n = 1; n <= 24; n++) {
+            char text[8];
+            std::snprintf(text, sizeof(text), n % 2 ? "F%d" : "f%d", n);
+            CHECK(Parse("Key", text, &c) && c.key == ConfigSchema::kVkF1 + n - 1);
+            std::snprintf(text, sizeof(text), "F%d", n);
+            CHECK(Format("Key", c) == text);
+        }
+        CHECK(Parse("Key", "65", &c) && c.key == 65);
+        CHECK(Format("Key", c) == "65");
+        CHECK(Parse("Key", "0x41", &c) && c.key == 65);
+        CHECK(Parse("Key", "254", &c) && c.key == 254);
+        const char* bad[] = { "", "F", "F0", "F25", "F1x", "f99", "0", "255", "-1", "Space" };
+        for (const char* text : bad) CHECK(!Parse("Key", text, &c) && c.key == ConfigSchema::kVkF1);
+    }
+
+    bool ValidUtf8(const char* s) {
+        for (const unsigned char* p = reinterpret_cast<const unsigned char*>(s); *p;) {
+            int extra = *p < 0x80 ? 0 : (*p & 0xE0) == 0xC0 ? 1 : (*p & 0xF0) == 0xE0 ? 2 : (*p & 0xF8) == 0xF0 ? 3 : -1;
+            if (extra < 0) return false;
+            p++;
+            for (int i = 0; i < extra; i++, p++) {
+                if ((*p & 0xC0) != 0x80) return false;
+            }
+        }
+        return true;
+    }
+
+    // Capacity 8: at most 7 bytes, never part of a code point
+    void TestString() {
+        TestConfig c;
+        CHECK(Parse("Name", "abc", &c) && std::strcmp(c.name, "abc") == 0);
+        CHECK(Parse("Name", "", &c) && c.name[0] == '\0');
+        CHECK(Parse("Name", "abcdefg", &c) && std::strcmp(c.name, "abcdefg") == 0);
+        CHECK(Parse("Name", "abcdefghij", &c) && std::strcmp(c.name, "abcdefg") == 0);
+
+        CHECK(Parse("Name", "aaaaaa\xC3\xA9", &c) && std::strcmp(c.name, "aaaaaa") == 0);           // é cut at byte 2 of 2
+        CHECK(Parse("Name", "aaaaa\xE2\x82\xAC", &c) && std::strcmp(c.name, "aaaaa") == 0);         // € cut at byte 3 of 3
+        CHECK(Parse("Name", "aaaa\xE2\x82\xAC", &c) && std::strcmp(c.name, "aaaa\xE2\x82\xAC") == 0);   // € fits exactly
+        CHECK(Parse("Name", "a\xF0\x9F\x98\x80\xF0\x9F\x98\x80", &c) && std::strcmp(c.name, "a\xF0\x9F\x98\x80") == 0);
+        CHECK(Parse("Name", "\xE6\x97\xA5\xE6\x9C\xAC\xE8\xAA\x9E", &c) && std::strcmp(c.name, "\xE6\x97\xA5\xE6\x9C\xAC") == 0);
+
+        // Every prefix of a mixed string: the longest whole-code-point cut
+        const std::string mixed = "x\xC3\xA9\xE2\x82\xAC\xF0\x9F\x98\x80y\xE6\x97\xA5z";
+        for (size_t n = 0; n <= mixed.size(); n++) {
+            const std::string text = mixed.substr(0, n);
+            if (!ValidUtf8(text.c_str())) continue;
+            size_t fit = text.size() < 7 ? text.size() : 7;
+            while (!ValidUtf8(text.substr(0, fit).c_str())) fit--;
+            CHECK(Parse("Name", text.c_str(), &c) && text.substr(0, fit) == c.name);
+        }
+    }
+
+    void TestApply() {
+        const char text[] =
+            "[Main]\n"
+            "Flag=yes\n"
+            "Clamped=50\n"
+            "Rejected=50\n"
+            "FClamped=not a number\n"
+            "Color=#11223344\n"
+            "Corner=bl\n"
+            "Key=F9\n"
+            "Name=  ca\xC3\xA9\xC3\xA9\xC3\xA9  \n"
+            "Unknown=1\n"
+            "[Other]\n"
+            "AnyInt=7\n";
+        IniFile ini;
+        ini.Parse(text, sizeof(text) - 1);
+        TestConfig c;
+        ConfigSchema::Apply(ConfigSchema::MakeSchema(kTestFields, nullptr, false), ini, &c);
+        CHECK(c.flag && c.clamped == 10 && c.rejected == 5 && c.anyInt == 0);
+        CHECK(c.fClamped == 0.5f && c.fRejected == 0.5f);
+        CHECK(c.color == 0x11223344u && c.corner == kCornerBottomLeft && c.key == ConfigSchema::kVkF1 + 8);
+        CHECK(std::strcmp(c.name, "ca\xC3\xA9\xC3\xA9") == 0);
+    }
+
+    // Stored members compare equal; runtime-only ones are not in the file
+    void CheckSameStored(const ConfigSchema::Schema& schema, const void* a, const void* b) {
+        for (size_t i = 0; i < schema.count; i++) {
+            const ConfigSchema::Field& field = schema.fields[i];
+            if (!field.key) continue;
+            const char* ma = static_cast<const char*>(a) + field.offset;
+            const char* mb = static_cast<const char*>(b) + field.offset;
+            const bool same = field.kind == ConfigSchema::Kind::String ? std::strcmp(ma, mb) == 0
+                                                                       : std::memcmp(ma, mb, field.size) == 0;
+            if (!same) std::fprintf(stderr, "[%s] %s differs\n", field.section, field.key);
+            CHECK(same);
+        }
+    }
+
+    template <typename Config>
+    void RoundTrip(const ConfigSchema::Schema& schema, const Config& source, Config* target) {
+        std::string text;
+        ConfigSchema::Write(schema, &source, text);
+        IniFile ini;
+        ini.Parse(text.data(), text.size());
+        ConfigSchema::Apply(schema, ini, target);
+        CheckSameStored(schema, &source, target);
+    }
+
+    void TestOverlayRoundTrip() {
+        OverlayConfig source;
+        source.alpha = 0.75f;
+        source.showFps = false;
+        source.captureEnabled = true;
+        source.showGraph = true;
+        source.graphSeconds = 30.5f;
+        source.graphWidth = 320.0f;
+        source.fontScale = 1.25f;
+        source.sampleCount = 120;
+        source.displayUpdateMs = 250;
+        source.corner = kCornerCustom;
+        source.posX = 1234.5f;
+        source.posY = -20.0f;
+        source.toggleKey = ConfigSchema::kVkF1 + 19;
+        source.visible = false;
+        source.hookMode = kHookVtable;
+
+        OverlayConfig target;
+        RoundTrip(kOverlayConfigSchema, source, &target);
+        CHECK(target.corner == kCornerCustom && target.toggleKey == ConfigSchema::kVkF1 + 19 && target.posX == 1234.5f);
+
+        // Defaults written over a changed config restore every default
+        const OverlayConfig defaults;
+        RoundTrip(kOverlayConfigSchema, defaults, &target);
+
+        std::string text;
+        ConfigSchema::Write(kOverlayConfigSchema, &defaults, text);
+        CHECK(text.compare(0, 33, "; FPS Overlay - Overlay Settings\n") == 0);
+        CHECK(text.find("\n[Overlay]\n") != std::string::npos && text.find("ShowFps=1\n") != std::string::npos);
+        CHECK(text.find("Corner=TopRight\n") != std::string::npos && text.find("ToggleKey=F1\n") != std::string::npos);
+    }
+
+    void TestFpsRoundTrip() {
+        FpsConfig source;
+        source.position = POS_BOTTOM_RIGHT;
+        source.offsetX = -15;
+        source.offsetY = 300;
+        source.fontSize = 18;
+        source.colorHigh = 0x8000FF00u;
+        source.colorBackground = 0x00000000u;
+        source.toggleKey = 0x2D;
+        source.filterMode = FILTER_BLACKLIST;
+        source.showBackground = false;
+        source.showGraph = true;
+        source.customX = 99;        // Runtime only
+        source.enabled = false;
+        std::strcpy(source.gameList, "game.exe;C:\\Games\\\xE6\x97\xA5\xE6\x9C\xAC\\;other.exe");
+
+        FpsConfig target;
+        RoundTrip(kFpsConfigSchema, source, &target);
+        CHECK(target.customX == 10 && target.enabled);
+        CHECK(std::strcmp(target.gameList, source.gameList) == 0);
+
+        std::string text;
+        ConfigSchema::Write(kFpsConfigSchema, &source, text);
+        CHECK(text.find("ShowGraph=true\n") != std::string::npos && text.find("Mode=Blacklist\n") != std::string::npos);
+        CHECK(text.find("HighFPS=8000FF00\n") != std::string::npos && text.find("Toggle=45\n") != std::string::npos);
+
+        // Each section once, in order of first appearance
+        CHECK(text.find("[Display]") < text.find("[Colors]") && text.find("[Colors]") < text.find("[Hotkey]"));
+        CHECK(text.find("[Hotkey]") < text.find("[Filter]"));
+        const char* sections[] = { "[Display]", "[Colors]", "[Hotkey]", "[Filter]" };
+        for (const char* section : sections) {
+            CHECK(text.find(section) != std::string::npos && text.find(section) == text.rfind(section));
+        }
+
+        const FpsConfig defaults;
+        RoundTrip(kFpsConfigSchema, defaults, &target);
+    }
+}
+
+int main() {
+    TestBool();
+    TestInt();
+    TestFloat();
+    TestColor();
+    TestEnum();
+    TestKey();
+    TestString();
+    TestApply();
+    TestOverlayRoundTrip();
+    TestFpsRoundTrip();
+    std::printf("config_schema: ok\n");
+    return 0;
+}
@@ -0,0 +1,295 @@
+// EntryPointCache: key folding and identity changes, slot bounds, store /
+// update / remove and eviction order (also after a reload), the file round
+// trip, malformed and random input, and processes saving and loading the
+// same file at once, which must never see a torn table.
+
+#include "entry_point_cache.h"
+#include "test_util.h"
+
+#include <algorithm>
+#include <cstring>
+#include <random>
+#include <string>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+using namespace EntryPointCache;
+
+namespace {
+    constexpr int kSavers = 8;
+    constexpr int kSaves = 300;
+
+    std::string s_dir;
+
+    const char kDxgiPath[] = "C:\\Windows\\System32\\dxgi.dll";
+
+    uint64_t DxgiKey(const ModuleIdentity& identity) {
+        return MakeKey(kDxgiPath, std::strlen(kDxgiPath), identity);
+    }
+
+    void TestKeys() {
+        const ModuleIdentity identity = { 123456, 0x01D9000000000000ull, 0x5F000000, 0x12345, 0x100000 };
+        const uint64_t key = DxgiKey(identity);
+        CHECK(key != 0);
+        CHECK(key == MakeKey("c:/windows/system32/DXGI.DLL", std::strlen(kDxgiPath), identity));
+        CHECK(key != MakeKey("C:\\Windows\\System32\\d3d9.dll", std::strlen(kDxgiPath), identity));
+        CHECK(key != MakeKey(kDxgiPath, std::strlen(kDxgiPath) - 1, identity));
+
+        // Any part of the identity changes the key
+        ModuleIdentity changed = identity;
+        changed.fileSize++;
+        CHECK(DxgiKey(changed) != key);
+        changed = identity;
+        changed.lastWrite++;
+        CHECK(DxgiKey(changed) != key);
+        changed = identity;
+        changed.timeDateStamp++;
+        CHECK(DxgiKey(changed) != key);
+        changed = identity;
+        changed.checkSum++;
+        CHECK(DxgiKey(changed) != key);
+        changed = identity;
+        changed.sizeOfImage += 0x1000;
+        CHECK(DxgiKey(changed) != key);
+
+        const ModuleIdentity empty = {};
+        CHECK(MakeKey("", 0, empty) != 0);
+    }
+
+    void TestSlots() {
+        const Module module = { 0x7FF800000000ull, 0x100000, 1 };
+        CHECK(SlotAddress(module, 0x2000) == module.base + 0x2000);
+        CHECK(SlotAddress(module, 0x800) == 0);                 // PE headers
+        CHECK(SlotAddress(module, 0x2004) == 0);                // Misaligned
+        CHECK(SlotAddress(module, 0x100000 - 8) == module.base + 0x100000 - 8);
+        CHECK(SlotAddress(module, 0x100000 - 4) == 0);          // Runs past the end
+        CHECK(SlotAddress(module, 0x100000) == 0);
+        CHECK(SlotAddress(module, 0xFFFFFFF8u) == 0);
+
+        uint32_t rva = 0;
+        CHECK(SlotRva(module, reinterpret_cast<void*>(module.base + 0x3000), &rva) && rva == 0x3000);
+        CHECK(!SlotRva(module, reinterpret_cast<void*>(module.base - 8), &rva));
+        CHECK(!SlotRva(module, reinterpret_cast<void*>(module.base + 0x100000), &rva));
+        CHECK(!SlotRva(module, reinterpret_cast<void*>(module.base + 0x3001), &rva));
+        CHECK(!SlotRva(module, reinterpret_cast<void*>(module.base + 0x100000000ull + 0x3000), &rva));
+        CHECK(rva == 0x3000);       // Untouched on failure
+    }
+
+    void TestTable() {
+        Table table;
+        uint32_t rva = 0;
+        CHECK(!table.Lookup(7, kDxgiPresentSlot, &rva));
+        CHECK(table.Store(7, kDxgiPresentSlot, 0x3000));
+        CHECK(!table.Store(7, kDxgiPresentSlot, 0x3000));       // Unchanged: no save needed
+        CHECK(table.Store(7, kDxgiResizeBuffersSlot, 0x3028));
+        CHECK(table.Store(8, kDxgiPresentSlot, 0x5000));
+        CHECK(table.Lookup(7, kDxgiPresentSlot, &rva) && rva == 0x3000);
+        CHECK(table.Store(7, kDxgiPresentSlot, 0x4000));
+        CHECK(table.Lookup(7, kDxgiPresentSlot, &rva) && rva == 0x4000);
+        CHECK(table.Lookup(8, kDxgiPresentSlot, &rva) && rva == 0x5000);
+        CHECK(!table.Lookup(7, kD3D9EndSceneSlot, &rva));
+        CHECK(table.Size() == 3);
+
+        CHECK(table.Remove(7, kDxgiPresentSlot));
+        CHECK(!table.Remove(7, kDxgiPresentSlot));
+        CHECK(!table.Lookup(7, kDxgiPresentSlot, &rva));
+        CHECK(table.Lookup(7, kDxgiResizeBuffersSlot, &rva) && rva == 0x3028);
+        CHECK(table.Size() == 2);
+    }
+
+    void TestEviction() {
+        Table table;
+        uint32_t rva = 0;
+        for (uint32_t i = 0; i < kMaxEntries + 10; i++) table.Store(1000 + i, 1, 0x1000 + i * 8);
+        CHECK(table.Size() == kMaxEntries);
+        CHECK(!table.Lookup(1000, 1, &rva) && !table.Lookup(1009, 1, &rva));
+        CHECK(table.Lookup(1010, 1, &rva) && rva == 0x1000 + 10 * 8);
+
+        // An updated entry counts as new: 1011 goes first
+        CHECK(table.Store(1010, 1, 0x9000));
+        table.Store(5000, 1, 0x1000);
+        CHECK(table.Lookup(1010, 1, &rva) && rva == 0x9000);
+        CHECK(!table.Lookup(1011, 1, &rva));
+
+        // Stamps continue after a reload, so the oldest is still dropped first
+        std::vector<unsigned char> data = { 1, 2, 3 };
+        table.Serialize(data);
+        CHECK(data.size() == sizeof(FileHeader) + kMaxEntries * sizeof(Entry));
+        Table reloaded;
+        reloaded.Parse(data.data(), data.size());
+        CHECK(reloaded.Size() == kMaxEntries);
+        reloaded.Store(6000, 1, 0x1000);
+        CHECK(reloaded.Lookup(5000, 1, &rva) && reloaded.Lookup(1010, 1, &rva));
+        CHECK(reloaded.Lookup(1013, 1, &rva) && !reloaded.Lookup(1012, 1, &rva));
+    }
+
+    void TestFile() {
+        const std::string path = s_dir + "/entry_points.bin";
+        Table table;
+        CHECK(!table.Load(path.c_str()) && table.Size() == 0);
+
+        Table small;
+        small.Store(7, kDxgiPresentSlot, 0x3000);
+        small.Store(7, kD3D9EndSceneSlot, 0x3028);
+        CHECK(small.Save(path.c_str()));
+        uint32_t rva = 0;
+        CHECK(table.Load(path.c_str()) && table.Size() == 2);
+        CHECK(table.Lookup(7, kD3D9EndSceneSlot, &rva) && rva == 0x3028);
+
+        // Saving replaces the file and leaves no temporary behind
+        Table full;
+        for (uint32_t i = 0; i < kMaxEntries; i++) full.Store(i + 1, kDxgiPresentSlot, 0x2000 + i * 8);
+        CHECK(full.Save(path.c_str()));
+        CHECK(table.Load(path.c_str()) && table.Size() == kMaxEntries);
+        std::string leftovers = "test -z \"$(ls '" + s_dir + "' | grep -v '^entry_points.bin$')\"";
+        CHECK(std::system(leftovers.c_str()) == 0);
+
+        // Oversized file: read, but not taken
+        std::vector<unsigned char> big(64 * 1024, 0);
+        std::FILE* f = std::fopen(path.c_str(), "wb");
+        CHECK(f && std::fwrite(big.data(), 1, big.size(), f) == big.size());
+        std::fclose(f);
+        CHECK(table.Load(path.c_str()) && table.Size() == 0);
+
+        // Missing directory: nothing written
+        const std::string missing = s_dir + "/missing/entry_points.bin";
+        CHECK(!small.Save(missing.c_str()));
+    }
+
+    void TestMalformed() {
+        Table source;
+        for (uint32_t i = 0; i < 5; i++) source.Store(i + 1, kDxgiPresentSlot, 0x2000);
+        std::vector<unsigned char> data;
+        source.Serialize(data);
+
+        Table table;
+        table.Parse(data.data(), data.size());
+        CHECK(table.Size() == 5);
+        table.Parse(data.data(), data.size() - 1);
+        CHECK(table.Size() == 0);
+        table.Parse(data.data(), 3);
+        CHECK(table.Size() == 0);
+
+        std::vector<unsigned char> bad = data;
+        bad[0] ^= 1;        // Magic
+        table.Parse(bad.data(), bad.size());
+        CHECK(table.Size() == 0);
+        bad = data;
+        bad[4] = 2;         // Version
+        table.Parse(bad.data(), bad.size());
+        CHECK(table.Size() == 0);
+        bad = data;
+        bad[8] = 0xFF;      // Count
+        bad[9] = 0xFF;
+        table.Parse(bad.data(), bad.size());
+        CHECK(table.Size() == 0);
+
+        // Random bytes, half of them behind a plausible header: taken whole
+        // when the size matches the count, otherwise rejected
+        std::mt19937 rng(5);
+        for (int i = 0; i < 200000; i++) {
+            size_t size = rng() % 96;
+            bad.assign(size, 0);
+            for (unsigned char& b : bad) b = static_cast<unsigned char>(rng());
+            if (size >= sizeof(FileHeader) && (rng() & 1)) {
+                const uint32_t header[3] = { kMagic, kVersion, static_cast<uint32_t>((size - sizeof(FileHeader)) / sizeof(Entry)) };
+                std::memcpy(bad.data(), header, sizeof(header));
+            }
+            table.Parse(bad.data(), size);
+            CHECK(table.Size() == 0 || sizeof(FileHeader) + table.Size() * sizeof(Entry) == size);
+        }
+    }
+
+    // Stamps and slots as written by a damaged or foreign file
+    void TestStampsFromFile() {
+        Table source;
+        for (uint32_t i = 0; i < kMaxEntries; i++) source.Store(1000 + i, 1, 0x1000 + i * 8);
+        std::vector<unsigned char> data;
+        source.Serialize(data);
+        Entry* entries = reinterpret_cast<Entry*>(data.data() + sizeof(FileHeader));
+        entries[0].stamp = UINT32_MAX;      // 1000 looks newest
+        entries[1] = entries[2];            // 1002 twice: the older copy has the old RVA
+        entries[1].rva = 0x8000;
+        entries[1].stamp = 0;
+
+        // No wrap: once full, new entries evict the oldest real ones (1002,
+        // then 1003), not each other, and 1000 stays the newest of the old
+        Table table;
+        uint32_t rva = 0;
+        table.Parse(data.data(), data.size());
+        CHECK(table.Size() == kMaxEntries - 1);
+        CHECK(table.Lookup(1002, 1, &rva) && rva == 0x1000 + 2 * 8);
+        table.Store(7000, 1, 0x1000);
+        table.Store(7001, 1, 0x1000);
+        table.Store(7002, 1, 0x1000);
+        CHECK(table.Lookup(7000, 1, &rva) && table.Lookup(7001, 1, &rva) && table.Lookup(7002, 1, &rva));
+        CHECK(!table.Lookup(1002, 1, &rva) && !table.Lookup(1003, 1, &rva));
+        CHECK(table.Lookup(1000, 1, &rva) && table.Lookup(1004, 1, &rva));
+
+        // Reloaded compact: stamps 0..n-1 whatever the file held
+        table.Serialize(data);
+        Table reloaded;
+        reloaded.Parse(data.data(), data.size());
+        reloaded.Serialize(data);
+        entries = reinterpret_cast<Entry*>(data.data() + sizeof(FileHeader));
+        uint32_t maxStamp = 0;
+        for (size_t i = 0; i < reloaded.Size(); i++) maxStamp = std::max(maxStamp, entries[i].stamp);
+        CHECK(reloaded.Size() == kMaxEntries && maxStamp == kMaxEntries - 1);
+    }
+
+    // Each saver writes a table of its own size; every load sees one of them whole
+    void TestConcurrentSaves() {
+        const std::string path = s_dir + "/shared.bin";
+        std::vector<pid_t> children;
+        for (int i = 0; i < kSavers; i++) {
+            pid_t pid = fork();
+            CHECK(pid >= 0);
+            if (pid == 0) {
+                Table mine;
+                const uint32_t count = 1 + static_cast<uint32_t>(i) * 30;
+                for (uint32_t k = 0; k < count; k++) mine.Store(100 * (i + 1) + k, kDxgiPresentSlot, 0x2000 + k * 8);
+                for (int save = 0; save < kSaves; save++) {
+                    if (!mine.Save(path.c_str())) _exit(1);
+                    Table seen;
+                    if (!seen.Load(path.c_str())) continue;
+                    if (seen.Size() == 0 || (seen.Size() - 1) % 30 != 0) _exit(2);
+                    const size_t saver = (seen.Size() - 1) / 30;
+                    uint32_t rva = 0;
+                    if (saver >= kSavers) _exit(2);
+                    if (!seen.Lookup(100 * (saver + 1) + seen.Size() - 1, kDxgiPresentSlot, &rva)) _exit(3);
+                    if (rva != 0x2000 + (seen.Size() - 1) * 8) _exit(4);
+                }
+                _exit(0);
+            }
+            children.push_back(pid);
+        }
+        for (pid_t child : children) {
+            int status = 0;
+            CHECK(waitpid(child, &status, 0) == child);
+            CHECK(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+        }
+        Table last;
+        CHECK(last.Load(path.c_str()) && last.Size() > 0);
+    }
+}
+
+int main() {
+    char dir[] = "/tmp/entry_point_cache_test.XXXXXX";
+    CHECK(mkdtemp(dir) != nullptr);
+    s_dir = dir;
+
+    TestKeys();
+    TestSlots();
+    TestTable();
+    TestEviction();
+    TestStampsFromFile();
+    TestFile();
+    TestMalformed();
+    TestConcurrentSaves();
+
+    std::string cleanup = "rm -rf " + s_dir;
+    CHECK(std::system(cleanup.c_str()) == 0);
+    std::printf("entry_point_cache: ok\n");
+    return 0;
+}
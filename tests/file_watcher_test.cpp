@@ -0,0 +1,197 @@
+// FileWatcher on inotify: an in-place truncate + write, a write to a temp
+// file renamed over the watched one, and a delete followed by a recreate
+// each run onChange once with the new contents in place; a burst of writes
+// closer together than kDebounceMs runs it once; other files in the
+// directory never run it; a false return is retried; and Stop() returns
+// promptly with no onChange running after it has returned.
+
+#include "file_watcher.h"
+#include "test_util.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unistd.h>
+
+namespace {
+    using Clock = std::chrono::steady_clock;
+
+    std::string s_dir;
+    std::string s_path;
+
+    struct Observer {
+        std::atomic<int> calls{0};
+        std::atomic<int> failuresLeft{0};
+        std::atomic<bool> stopped{false};
+        std::atomic<bool> lateCall{false};
+        std::mutex mutex;
+        std::string seen;
+
+        bool OnChange() {
+            if (stopped.load()) lateCall.store(true);
+            std::string text;
+            if (std::FILE* f = std::fopen(s_path.c_str(), "rb")) {
+                char buffer[256];
+                size_t n;
+                while ((n = std::fread(buffer, 1, sizeof(buffer), f)) > 0) text.append(buffer, n);
+                std::fclose(f);
+            }
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                seen = text;
+            }
+            calls++;
+            if (failuresLeft.load() > 0) {
+                failuresLeft--;
+                return false;
+            }
+            return true;
+        }
+
+        std::string Seen() {
+            std::lock_guard<std::mutex> lock(mutex);
+            return seen;
+        }
+    };
+
+    void Sleep(unsigned ms) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+    }
+
+    // Waits for `count` calls, then long enough past the debounce that a
+    // second, unexpected call would have been made
+    bool WaitCalls(Observer& observer, int count) {
+        const Clock::time_point deadline = Clock::now() + std::chrono::seconds(5);
+        while (observer.calls.load() < count && Clock::now() < deadline) Sleep(5);
+        Sleep(FileWatcher::kDebounceMs * 4);
+        return observer.calls.load() == count;
+    }
+
+    void WriteFile(const std::string& path, const char* text) {
+        std::FILE* f = std::fopen(path.c_str(), "wb");
+        CHECK(f != nullptr);
+        CHECK(std::fwrite(text, 1, std::strlen(text), f) == std::strlen(text));
+        CHECK(std::fclose(f) == 0);
+    }
+
+    void TestSavePatterns() {
+        WriteFile(s_path, "initial");
+        Observer observer;
+        FileWatcher watcher;
+        CHECK(watcher.Start(s_path, [&] { return observer.OnChange(); }) && watcher.IsRunning());
+        Sleep(20);
+        CHECK(observer.calls.load() == 0);
+
+        // In place: fopen("wb") truncates, then write and close
+        WriteFile(s_path, "truncated and rewritten");
+        CHECK(WaitCalls(observer, 1));
+        CHECK(observer.Seen() == "truncated and rewritten");
+
+        // Write a temp file next to it, rename over
+        const std::string temp = s_dir + "/watched.ini.tmp";
+        WriteFile(temp, "renamed over");
+        CHECK(std::rename(temp.c_str(), s_path.c_str()) == 0);
+        CHECK(WaitCalls(observer, 2));
+        CHECK(observer.Seen() == "renamed over");
+
+        // Delete, then recreate shortly after: one call, the new file read
+        CHECK(unlink(s_path.c_str()) == 0);
+        Sleep(5);
+        WriteFile(s_path, "recreated");
+        CHECK(WaitCalls(observer, 3));
+        CHECK(observer.Seen() == "recreated");
+
+        // Another file in the same directory
+        WriteFile(s_dir + "/other.ini", "unrelated");
+        Sleep(FileWatcher::kDebounceMs * 4);
+        CHECK(observer.calls.load() == 3);
+
+        watcher.Stop();
+        CHECK(!watcher.IsRunning());
+    }
+
+    void TestDebounce() {
+        WriteFile(s_path, "0");
+        Observer observer;
+        FileWatcher watcher;
+        CHECK(watcher.Start(s_path, [&] { return observer.OnChange(); }));
+
+        // 40 saves 2 ms apart: well inside kDebounceMs of each other
+        char text[16];
+        for (int i = 1; i <= 40; i++) {
+            std::snprintf(text, sizeof(text), "%d", i);
+            WriteFile(s_path, text);
+            Sleep(2);
+        }
+        CHECK(WaitCalls(observer, 1));
+        CHECK(observer.Seen() == "40");
+    }
+
+    void TestRetry() {
+        WriteFile(s_path, "locked");
+        Observer observer;
+        observer.failuresLeft = 2;
+        FileWatcher watcher;
+        CHECK(watcher.Start(s_path, [&] { return observer.OnChange(); }));
+        WriteFile(s_path, "unlocked");
+
+        // Two failures, each retried after kRetryMs, then success
+        const Clock::time_point start = Clock::now();
+        CHECK(WaitCalls(observer, 3));
+        CHECK(Clock::now() - start >= std::chrono::milliseconds(FileWatcher::kDebounceMs + 2 * FileWatcher::kRetryMs));
+        CHECK(observer.Seen() == "unlocked");
+    }
+
+    void TestStop() {
+        WriteFile(s_path, "before");
+        Observer observer;
+        FileWatcher watcher;
+        CHECK(watcher.Start(s_path, [&] { return observer.OnChange(); }));
+
+        // Stop with a change pending inside the debounce window
+        WriteFile(s_path, "pending");
+        Sleep(FileWatcher::kDebounceMs / 5);
+        const Clock::time_point start = Clock::now();
+        watcher.Stop();
+        observer.stopped = true;
+        CHECK(Clock::now() - start < std::chrono::milliseconds(100));
+        CHECK(!watcher.IsRunning());
+
+        WriteFile(s_path, "after");
+        Sleep(FileWatcher::kDebounceMs * 6);
+        CHECK(!observer.lateCall.load());
+
+        // Idle watcher, and Stop on one never started or already stopped
+        CHECK(watcher.Start(s_path, [&] { return observer.OnChange(); }));
+        const Clock::time_point idle = Clock::now();
+        watcher.Stop();
+        CHECK(Clock::now() - idle < std::chrono::milliseconds(100));
+        watcher.Stop();
+        FileWatcher never;
+        never.Stop();
+
+        // A directory that does not exist
+        CHECK(!never.Start(s_dir + "/missing/watched.ini", [] { return true; }) && !never.IsRunning());
+    }
+}
+
+int main() {
+    char dir[] = "/tmp/file_watcher_test.XXXXXX";
+    CHECK(mkdtemp(dir) != nullptr);
+    s_dir = dir;
+    s_path = s_dir + "/watched.ini";
+
+    TestSavePatterns();
+    TestDebounce();
+    TestRetry();
+    TestStop();
+
+    std::string cleanup = "rm -rf " + s_dir;
+    CHECK(std::system(cleanup.c_str()) == 0);
+    std::printf("file_watcher: ok\n");
+    return 0;
+}
@@ -0,0 +1,151 @@
+// FrameTimeGraph against a brute-force scan of every frame: per-column
+// min/max, empty columns during hangs, wrap-around of the column ring over
+// many windows, reconfiguring, the raw ring, and frames with negative or
+// non-finite times being ignored.
+
+#include "frame_graph.h"
+#include "test_util.h"
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+namespace {
+    struct Frame {
+        double time;
+        float ms;
+    };
+
+    // Same bucketing as FrameTimeGraph
+    int64_t BucketOf(const FrameTimeGraph& graph, double time) {
+        const double bucketSeconds = static_cast<double>(graph.WindowSeconds()) / static_cast<double>(graph.Columns());
+        return static_cast<int64_t>(time / bucketSeconds);
+    }
+
+    void CheckColumns(const FrameTimeGraph& graph, const std::vector<Frame>& frames) {
+        static FrameTimeGraph::Column columns[FrameTimeGraph::kMaxColumns];
+        const size_t count = graph.GetColumns(columns, FrameTimeGraph::kMaxColumns);
+        if (frames.empty()) {
+            CHECK(count == 0);
+            return;
+        }
+        CHECK(count == graph.Columns());
+
+        const int64_t head = BucketOf(graph, frames.back().time);
+        for (size_t i = 0; i < count; i++) {
+            const int64_t id = head - static_cast<int64_t>(count) + 1 + static_cast<int64_t>(i);
+            float minMs = NAN;
+            float maxMs = NAN;
+            for (const Frame& frame : frames) {
+                if (BucketOf(graph, frame.time) != id) continue;
+                if (std::isnan(minMs) || frame.ms < minMs) minMs = frame.ms;
+                if (std::isnan(maxMs) || frame.ms > maxMs) maxMs = frame.ms;
+            }
+            if (std::isnan(minMs)) {
+                CHECK(std::isnan(columns[i].minMs) && std::isnan(columns[i].maxMs));
+            } else {
+                CHECK(columns[i].minMs == minMs && columns[i].maxMs == maxMs);
+            }
+        }
+
+        // Fewer columns asked for: the most recent ones
+        FrameTimeGraph::Column last[2];
+        CHECK(graph.GetColumns(last, 2) == 2);
+        for (size_t i = 0; i < 2; i++) {
+            const FrameTimeGraph::Column& expected = columns[count - 2 + i];
+            CHECK((std::isnan(expected.minMs) && std::isnan(last[i].minMs)) ||
+                  (last[i].minMs == expected.minMs && last[i].maxMs == expected.maxMs));
+        }
+    }
+
+    void TestRandom() {
+        std::mt19937 rng(27);
+        std::uniform_real_distribution<float> frameMs(4.0f, 40.0f);
+        const size_t widths[] = { 2, 7, 200, 512 };
+        const float windows[] = { 0.5f, 3.0f, 10.0f };
+        for (size_t width : widths) {
+            for (float window : windows) {
+                FrameTimeGraph graph;
+                graph.Configure(width, window);
+                CHECK(graph.Columns() == width && graph.WindowSeconds() == window);
+                std::vector<Frame> frames;
+                CheckColumns(graph, frames);
+
+                // Several windows' worth, so the ring wraps many times;
+                // occasional hangs leave whole columns empty
+                double now = 1234.5;
+                const size_t total = static_cast<size_t>(window * 60.0f * 5.0f);
+                for (size_t i = 0; i < total; i++) {
+                    float ms = frameMs(rng);
+                    if (rng() % 200 == 0) ms = window * 300.0f * static_cast<float>(rng() % 4);
+                    now += ms / 1000.0;
+                    graph.AddFrame(now, ms);
+                    frames.push_back({ now, ms });
+                    if (i % 97 == 0) CheckColumns(graph, frames);
+                }
+                CheckColumns(graph, frames);
+            }
+        }
+    }
+
+    void TestConfigure() {
+        FrameTimeGraph graph;
+        CHECK(graph.Columns() == 200 && graph.WindowSeconds() == 10.0f);     // Default
+        graph.AddFrame(1.0, 16.0f);
+        graph.Configure(1, 0.1f);        // Clamped, and cleared
+        CHECK(graph.Columns() == 2 && graph.WindowSeconds() == 0.5f);
+        FrameTimeGraph::Column columns[FrameTimeGraph::kMaxColumns];
+        CHECK(graph.GetColumns(columns, FrameTimeGraph::kMaxColumns) == 0);
+        graph.Configure(100000, 1000.0f);
+        CHECK(graph.Columns() == FrameTimeGraph::kMaxColumns && graph.WindowSeconds() == 600.0f);
+
+        // The first frame lands in the last column; the ones before it are empty
+        graph.Configure(10, 1.0f);
+        graph.AddFrame(0.0, 16.0f);
+        CHECK(graph.GetColumns(columns, FrameTimeGraph::kMaxColumns) == 10);
+        for (size_t i = 0; i < 9; i++) CHECK(std::isnan(columns[i].minMs));
+        CHECK(columns[9].minMs == 16.0f && columns[9].maxMs == 16.0f);
+    }
+
+    void TestInvalidTimes() {
+        FrameTimeGraph graph;
+        graph.Configure(10, 1.0f);
+        FrameTimeGraph::Column columns[FrameTimeGraph::kMaxColumns];
+        float raw[8];
+
+        graph.AddFrame(-0.05, 99.0f);
+        graph.AddFrame(-1e12, 99.0f);
+        graph.AddFrame(NAN, 99.0f);
+        graph.AddFrame(INFINITY, 99.0f);
+        graph.AddFrame(1e300, 99.0f);
+        CHECK(graph.GetColumns(columns, FrameTimeGraph::kMaxColumns) == 0);
+        CHECK(graph.GetRecentFrames(raw, 8) == 0);
+
+        graph.AddFrame(5.0, 16.0f);
+        graph.AddFrame(-3.0, 99.0f);
+        CHECK(graph.GetColumns(columns, FrameTimeGraph::kMaxColumns) == 10);
+        for (size_t i = 0; i < 10; i++) CHECK(std::isnan(columns[i].maxMs) || columns[i].maxMs == 16.0f);
+        CHECK(graph.GetRecentFrames(raw, 8) == 1 && raw[0] == 16.0f);
+    }
+
+    void TestRecentFrames() {
+        FrameTimeGraph graph;
+        std::vector<float> out(FrameTimeGraph::kRawCapacity + 10);
+        for (size_t i = 0; i < FrameTimeGraph::kRawCapacity + 100; i++) {
+            graph.AddFrame(static_cast<double>(i) * 0.016, static_cast<float>(i));
+        }
+        CHECK(graph.GetRecentFrames(out.data(), out.size()) == FrameTimeGraph::kRawCapacity);
+        CHECK(out[0] == 100.0f && out[FrameTimeGraph::kRawCapacity - 1] == static_cast<float>(FrameTimeGraph::kRawCapacity + 99));
+        CHECK(graph.GetRecentFrames(out.data(), 3) == 3);
+        CHECK(out[0] == static_cast<float>(FrameTimeGraph::kRawCapacity + 97) && out[2] == static_cast<float>(FrameTimeGraph::kRawCapacity + 99));
+    }
+}
+
+int main() {
+    TestRandom();
+    TestConfigure();
+    TestInvalidTimes();
+    TestRecentFrames();
+    std::printf("frame_graph: ok\n");
+    return 0;
+}
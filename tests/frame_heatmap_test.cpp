@@ -0,0 +1,195 @@
+// FrameHeatmap: every bucket starts at BucketLowerMs and ends just below the
+// next one, out-of-range and invalid frame times land in the edge buckets,
+// frames go to the row of their slice, coarsening past kMaxRows keeps every
+// frame in the row a brute-force count at the final slice length expects,
+// and the capture chunk round trips while damaged payloads are rejected.
+
+#include "frame_heatmap.h"
+#include "capture.h"
+#include "test_util.h"
+
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+namespace {
+    constexpr uint32_t kBuckets = FrameHeatmap::kBuckets;
+
+    uint64_t RowTotal(const FrameHeatmap& heatmap, size_t row) {
+        uint64_t total = 0;
+        for (uint32_t b = 0; b < kBuckets; b++) total += heatmap.Row(row)[b];
+        return total;
+    }
+
+    void TestBuckets() {
+        CHECK(FrameHeatmap::BucketLowerMs(0) == 0.25f);
+        CHECK(FrameHeatmap::BucketLowerMs(FrameHeatmap::kBucketsPerOctave) == 0.5f);
+        CHECK(FrameHeatmap::BucketLowerMs(kBuckets - 1) == 1920.0f);
+
+        for (uint32_t b = 0; b < kBuckets; b++) {
+            const float lower = FrameHeatmap::BucketLowerMs(b);
+            CHECK(FrameHeatmap::BucketOf(lower) == b);
+            if (b > 0) {
+                CHECK(FrameHeatmap::BucketLowerMs(b - 1) < lower);
+                CHECK(FrameHeatmap::BucketOf(std::nextafter(lower, 0.0f)) == b - 1);
+            }
+            if (b + 1 < kBuckets) {
+                // Each bucket is 1/8 of an octave wide: the midpoint stays inside
+                const float upper = FrameHeatmap::BucketLowerMs(b + 1);
+                CHECK(FrameHeatmap::BucketOf((lower + upper) * 0.5f) == b);
+                CHECK(std::fabs(upper / lower - 1.0f) <= 0.125f + 1e-6f);
+            }
+        }
+
+        // Common frame times
+        CHECK(FrameHeatmap::BucketOf(16.667f) == 6 * 8 + 0);    // [16, 18)
+        CHECK(FrameHeatmap::BucketOf(33.333f) == 7 * 8 + 0);    // [32, 36)
+        CHECK(FrameHeatmap::BucketOf(6.944f) == 4 * 8 + 5);     // [6.5, 7)
+
+        // Below the first bucket, invalid, or beyond the last: clamped
+        const float nan = std::numeric_limits<float>::quiet_NaN();
+        const float inf = std::numeric_limits<float>::infinity();
+        CHECK(FrameHeatmap::BucketOf(0.0f) == 0);
+        CHECK(FrameHeatmap::BucketOf(-5.0f) == 0);
+        CHECK(FrameHeatmap::BucketOf(nan) == 0);
+        CHECK(FrameHeatmap::BucketOf(-inf) == 0);
+        CHECK(FrameHeatmap::BucketOf(1e-30f) == 0);
+        CHECK(FrameHeatmap::BucketOf(0.2499f) == 0);
+        CHECK(FrameHeatmap::BucketOf(2047.9f) == kBuckets - 1);
+        CHECK(FrameHeatmap::BucketOf(2048.0f) == kBuckets - 1);
+        CHECK(FrameHeatmap::BucketOf(1e30f) == kBuckets - 1);
+        CHECK(FrameHeatmap::BucketOf(inf) == kBuckets - 1);
+    }
+
+    void TestRows() {
+        FrameHeatmap heatmap(10.0f);
+        CHECK(heatmap.Rows() == 0 && heatmap.SliceSeconds() == 10.0f);
+
+        // The first frame sets the origin, whatever the epoch
+        heatmap.AddFrame(1000.0, 16.7f);
+        heatmap.AddFrame(1009.99, 16.7f);
+        heatmap.AddFrame(1010.0, 33.4f);
+        heatmap.AddFrame(1055.0, 100.0f);
+        CHECK(heatmap.Rows() == 6);
+        CHECK(heatmap.Row(0)[FrameHeatmap::BucketOf(16.7f)] == 2);
+        CHECK(heatmap.Row(1)[FrameHeatmap::BucketOf(33.4f)] == 1);
+        CHECK(heatmap.Row(5)[FrameHeatmap::BucketOf(100.0f)] == 1);
+        CHECK(RowTotal(heatmap, 0) == 2 && RowTotal(heatmap, 1) == 1);
+        for (size_t row = 2; row < 5; row++) CHECK(RowTotal(heatmap, row) == 0);
+
+        // A clock step backwards lands in the first row
+        heatmap.AddFrame(990.0, 16.7f);
+        CHECK(heatmap.Row(0)[FrameHeatmap::BucketOf(16.7f)] == 3);
+
+        // Reset restarts the origin; slices are clamped to 0.1 s
+        heatmap.Reset(0.0f);
+        CHECK(heatmap.Rows() == 0 && heatmap.SliceSeconds() == 0.1f);
+        heatmap.Reset(std::numeric_limits<float>::quiet_NaN());
+        CHECK(heatmap.SliceSeconds() == 0.1f);
+        heatmap.Reset(1.0f);
+        heatmap.AddFrame(5.0, 8.0f);
+        heatmap.AddFrame(5.5, 8.0f);
+        CHECK(heatmap.Rows() == 1 && RowTotal(heatmap, 0) == 2);
+    }
+
+    // Rows are merged pairwise from the origin, so after any number of
+    // coarsenings each frame sits in row floor(elapsed / slice) of the
+    // final slice length
+    void TestCoarsen() {
+        FrameHeatmap heatmap(0.1f);
+        const double origin = 12345.0;
+        std::vector<double> times;
+        double t = origin;
+        uint32_t i = 0;
+        while (t - origin < 0.1 * FrameHeatmap::kMaxRows * 5.5) {
+            times.push_back(t);
+            heatmap.AddFrame(t, 1.0f + static_cast<float>(i % 50));
+            CHECK(heatmap.Rows() <= FrameHeatmap::kMaxRows);
+            t += 0.003 + (i % 17) * 0.001;
+            i++;
+        }
+        CHECK(heatmap.SliceSeconds() == 0.1f * 8.0f);
+        CHECK(heatmap.Rows() <= FrameHeatmap::kMaxRows && heatmap.Rows() > FrameHeatmap::kMaxRows / 2);
+
+        std::vector<uint64_t> expected(heatmap.Rows() * kBuckets, 0);
+        for (size_t k = 0; k < times.size(); k++) {
+            const size_t row = static_cast<size_t>((times[k] - origin) / heatmap.SliceSeconds());
+            CHECK(row < heatmap.Rows());
+            expected[row * kBuckets + FrameHeatmap::BucketOf(1.0f + static_cast<float>(k % 50))]++;
+        }
+        uint64_t total = 0;
+        for (size_t row = 0; row < heatmap.Rows(); row++) {
+            for (uint32_t b = 0; b < kBuckets; b++) CHECK(heatmap.Row(row)[b] == expected[row * kBuckets + b]);
+            total += RowTotal(heatmap, row);
+        }
+        CHECK(total == times.size());
+
+        // One frame far in the future coarsens several times in one call
+        FrameHeatmap jump(0.1f);
+        jump.AddFrame(0.0, 5.0f);
+        jump.AddFrame(0.1 * FrameHeatmap::kMaxRows * 100, 5.0f);
+        CHECK(jump.SliceSeconds() == 0.1f * 128.0f);
+        CHECK(jump.Rows() <= FrameHeatmap::kMaxRows);
+        CHECK(RowTotal(jump, 0) == 1 && RowTotal(jump, jump.Rows() - 1) == 1);
+    }
+
+    void TestSerialize() {
+        FrameHeatmap heatmap(2.0f);
+        for (int i = 0; i < 5000; i++) heatmap.AddFrame(i * 0.0167, 10.0f + (i % 40));
+
+        std::vector<unsigned char> data;
+        heatmap.Serialize(data);
+        CHECK(data.size() == sizeof(Capture::HeatmapHeader) + heatmap.Rows() * kBuckets * sizeof(uint32_t));
+
+        FrameHeatmap read(10.0f);
+        CHECK(read.Deserialize(data.data(), data.size()));
+        CHECK(read.Rows() == heatmap.Rows() && read.SliceSeconds() == 2.0f);
+        for (size_t row = 0; row < read.Rows(); row++) {
+            CHECK(std::memcmp(read.Row(row), heatmap.Row(row), kBuckets * sizeof(uint32_t)) == 0);
+        }
+
+        // Truncated counts or header, or a different bucket layout: rejected
+        // and left as it was
+        FrameHeatmap other(3.0f);
+        CHECK(!other.Deserialize(data.data(), data.size() - 1));
+        CHECK(!other.Deserialize(data.data(), sizeof(Capture::HeatmapHeader) - 1));
+        CHECK(other.Rows() == 0 && other.SliceSeconds() == 3.0f);
+
+        Capture::HeatmapHeader header;
+        std::memcpy(&header, data.data(), sizeof(header));
+        std::vector<unsigned char> bad = data;
+        Capture::HeatmapHeader changed = header;
+        changed.bucketsPerOctave = 4;
+        std::memcpy(bad.data(), &changed, sizeof(changed));
+        CHECK(!other.Deserialize(bad.data(), bad.size()));
+        changed = header;
+        changed.minExponent = -3;
+        std::memcpy(bad.data(), &changed, sizeof(changed));
+        CHECK(!other.Deserialize(bad.data(), bad.size()));
+        changed = header;
+        changed.sliceSeconds = 0.0f;
+        std::memcpy(bad.data(), &changed, sizeof(changed));
+        CHECK(!other.Deserialize(bad.data(), bad.size()));
+        changed = header;
+        changed.rows = 0xFFFFFFFFu;
+        std::memcpy(bad.data(), &changed, sizeof(changed));
+        CHECK(!other.Deserialize(bad.data(), bad.size()));
+        CHECK(other.Rows() == 0);
+
+        // An empty heatmap round trips too
+        FrameHeatmap empty(5.0f);
+        empty.Serialize(data);
+        CHECK(data.size() == sizeof(Capture::HeatmapHeader));
+        CHECK(read.Deserialize(data.data(), data.size()) && read.Rows() == 0 && read.SliceSeconds() == 5.0f);
+    }
+}
+
+int main() {
+    TestBuckets();
+    TestRows();
+    TestCoarsen();
+    TestSerialize();
+    std::printf("frame_heatmap: ok\n");
+    return 0;
+}
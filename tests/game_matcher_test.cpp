@@ -0,0 +1,94 @@
+// GameMatcher: ASCII case folding, duplicates and empty entries in the game
+// list, then random lists and process names against a linear scan with
+// the same folding, and FindAll over a snapshot with several instances.
+
+#include "game_matcher.h"
+#include "process_enum.h"
+#include "test_util.h"
+
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+    std::string Fold(std::string s) {
+        for (char& c : s) {
+            if (c >= 'A' && c <= 'Z') c = static_cast<char>(c - 'A' + 'a');
+        }
+        return s;
+    }
+
+    int LinearFind(const std::vector<std::string>& games, const std::string& name) {
+        for (size_t i = 0; i < games.size(); i++) {
+            if (!games[i].empty() && Fold(games[i]) == Fold(name)) return static_cast<int>(i);
+        }
+        return -1;
+    }
+
+    void TestSemantics() {
+        GameMatcher matcher;
+        CHECK(matcher.Find("game.exe") == -1);      // Never built
+
+        matcher.Build({ "Brawl Game.exe", "", "HollowKnight.exe", "BRAWL GAME.EXE", "\xC3\x89lan.exe" });
+        CHECK(matcher.GameCount() == 5);
+        CHECK(matcher.Find("brawl game.exe") == 0);             // First of the duplicates
+        CHECK(matcher.Find("hollowknight.EXE") == 2);
+        CHECK(matcher.Find("\xC3\x89lan.exe") == 4);
+        CHECK(matcher.Find("\xC3\xA9lan.exe") == -1);           // Only ASCII folds
+        CHECK(matcher.Find("") == -1);
+        CHECK(matcher.Find("HollowKnight") == -1);
+        CHECK(matcher.Find("HollowKnight.exe ") == -1);
+
+        ProcessSnapshot snapshot;
+        snapshot.Add(10, "explorer.exe", 12);
+        snapshot.Add(20, "Brawl Game.exe", 14);
+        snapshot.Add(30, "hollowknight.exe", 16);
+        snapshot.Add(40, "brawl game.exe", 14);
+        std::vector<GameMatcher::Match> matches = { { 1, 1 } };
+        matcher.FindAll(snapshot, matches);
+        CHECK(matches.size() == 3);
+        CHECK(matches[0].pid == 20 && matches[0].game == 0);
+        CHECK(matches[1].pid == 30 && matches[1].game == 2);
+        CHECK(matches[2].pid == 40 && matches[2].game == 0);
+
+        // Rebuilding replaces the list
+        matcher.Build({});
+        CHECK(matcher.GameCount() == 0 && matcher.Find("brawl game.exe") == -1);
+        matcher.FindAll(snapshot, matches);
+        CHECK(matches.empty());
+    }
+
+    void TestRandom() {
+        std::mt19937 rng(3);
+        const char alphabet[] = "abAB. _x1\xC3";
+        auto randomName = [&] {
+            std::string name;
+            int length = static_cast<int>(rng() % 6);
+            for (int i = 0; i < length; i++) name.push_back(alphabet[rng() % (sizeof(alphabet) - 1)]);
+            return name + (rng() % 4 ? ".exe" : "");
+        };
+        for (int list = 0; list < 2000; list++) {
+            std::vector<std::string> games;
+            int count = static_cast<int>(rng() % 200);
+            for (int i = 0; i < count; i++) games.push_back(randomName());
+            GameMatcher matcher;
+            matcher.Build(games);
+            for (int probe = 0; probe < 50; probe++) {
+                std::string name = (!games.empty() && rng() % 2) ? games[rng() % games.size()] : randomName();
+                if (rng() % 2) {
+                    for (char& c : name) {
+                        if (c >= 'a' && c <= 'z') c = static_cast<char>(c - 'a' + 'A');
+                    }
+                }
+                CHECK(matcher.Find(name) == LinearFind(games, name));
+            }
+        }
+    }
+}
+
+int main() {
+    TestSemantics();
+    TestRandom();
+    std::printf("game_matcher: ok\n");
+    return 0;
+}
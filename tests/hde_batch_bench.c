@@ -0,0 +1,97 @@
+// Instruction-length decoding: hde64_disasm against hde_batch.c, over a
+// linear sweep of real code and over one prologue instruction.
+//
+// usage: hde_batch_bench [--quick] [binary]   (default: this executable)
+
+#include "hde64.h"
+#include "hde_batch.h"
+#include "test_util.h"
+
+static uint8_t* ReadFile(const char* path, size_t* size) {
+    FILE* f = fopen(path, "rb");
+    if (!f) return NULL;
+    fseek(f, 0, SEEK_END);
+    long n = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    uint8_t* blob = (uint8_t*)malloc(n + 32);
+    memset(blob + n, 0xCC, 32);
+    size_t read = fread(blob, 1, n, f);
+    fclose(f);
+    if (read != (size_t)n) {
+        free(blob);
+        return NULL;
+    }
+    *size = (size_t)n;
+    return blob;
+}
+
+int main(int argc, char** argv) {
+    const int quick = HasArg(argc, argv, "--quick");
+    const char* path = argv[0];
+    for (int i = 1; i < argc; i++) {
+        if (argv[i][0] != '-') path = argv[i];
+    }
+
+    size_t size;
+    uint8_t* code = ReadFile(path, &size);
+    CHECK(code != NULL);
+    hde_insn* insns = (hde_insn*)malloc(sizeof(hde_insn) * size);
+
+    // Sweep: invalid bytes are stepped over one at a time by both
+    const int reps = quick ? 1 : 10;
+    double single = 0, batch = 0;
+    size_t singleCount = 0, batchCount = 0;
+    volatile unsigned sink = 0;
+    for (int rep = 0; rep < reps; rep++) {
+        double t0 = NowNs();
+        singleCount = 0;
+        for (size_t pos = 0; pos < size; singleCount++) {
+            hde64s hs;
+            unsigned len = hde64_disasm(code + pos, &hs);
+            sink += hs.flags;
+            pos += (hs.flags & F_ERROR) || !len ? 1 : len;
+        }
+        double t1 = NowNs();
+        batchCount = 0;
+        for (size_t pos = 0; pos < size;) {
+            size_t done;
+            unsigned count = hde_decode_range(code + pos, size - pos, insns + batchCount,
+                                              (unsigned)(size - batchCount), &done, NULL);
+            batchCount += count;
+            pos += done;
+            if (pos < size) {
+                pos++;
+                batchCount++;
+            }
+        }
+        double t2 = NowNs();
+        single += t1 - t0;
+        batch += t2 - t1;
+    }
+    CHECK(singleCount == batchCount);
+    printf("sweep %s: %.1f MB, %zu instructions\n", path, size / 1e6, singleCount);
+    printf("  hde64_disasm      %6.2f ns/insn %6.0f MB/s\n", single / reps / singleCount, size * reps / (single / 1e3));
+    printf("  hde_decode_range  %6.2f ns/insn %6.0f MB/s\n", batch / reps / batchCount, size * reps / (batch / 1e3));
+
+    // mov [rsp+8], rbx: the first instruction of most x64 functions
+    static uint8_t prologue[32] = { 0x48, 0x89, 0x5C, 0x24, 0x08 };
+    const int n = quick ? 100000 : 50000000;
+    double t0 = NowNs();
+    for (int i = 0; i < n; i++) {
+        hde64s hs;
+        prologue[5] = (uint8_t)i;
+        sink += hde64_disasm(prologue, &hs);
+    }
+    double t1 = NowNs();
+    for (int i = 0; i < n; i++) {
+        hde_insn insn;
+        prologue[5] = (uint8_t)i;
+        sink += hde_insn_decode(prologue, &insn, NULL);
+    }
+    double t2 = NowNs();
+    printf("prologue: hde64_disasm %.2f ns, hde_insn_decode %.2f ns\n", (t1 - t0) / n, (t2 - t1) / n);
+
+    free(insns);
+    free(code);
+    return 0;
+}
@@ -0,0 +1,208 @@
+#pragma once
+
+// Cross-check of hde_batch.c against the HDE decoder of the same mode.
+// Included by hde_batch_test.c (x64) and hde_batch_x86_test.c, which include
+// hde_batch.c first to reach fast_decode().
+//
+// usage: hde_batch_test [--long] [binary...]
+// The executable itself is always swept as real code; --long also walks
+// every SIB byte and runs ten times as many random instructions.
+
+#include "test_util.h"
+
+static uint64_t s_rng = 88172645463325252ull;
+
+static uint32_t Rand(void) {
+    s_rng ^= s_rng << 13;
+    s_rng ^= s_rng >> 7;
+    s_rng ^= s_rng << 17;
+    return (uint32_t)s_rng;
+}
+
+static long s_checked, s_fastHits;
+
+// What the trampoline code reads from HDE for the instruction at p
+static unsigned Expect(const uint8_t* p, hde_insn* e) {
+    hde_state hs;
+    HDE_DISASM(p, &hs);
+    if (hs.flags & F_ERROR) return 0;
+    e->len = hs.len;
+    e->flags = 0;
+    if (hs.flags & F_RELATIVE) e->flags |= HDE_INSN_RELATIVE;
+#if HDE_MODE64
+    if ((hs.modrm & 0xC7) == 0x05) e->flags |= HDE_INSN_RIPREL;
+#endif
+    if ((hs.opcode & 0xFE) == 0xC2) e->flags |= HDE_INSN_RET;
+
+    // Every instruction CreateTrampolineFunction rewrites must be flagged
+    if (hs.opcode == 0xE8 || (hs.opcode & 0xFD) == 0xE9 || (hs.opcode & 0xF0) == 0x70 ||
+        (hs.opcode & 0xFC) == 0xE0 || (hs.opcode2 & 0xF0) == 0x80) {
+        CHECK(e->flags & HDE_INSN_RELATIVE);
+    }
+    return e->len;
+}
+
+static void Check(const uint8_t* p, hde_cache* cache) {
+    hde_insn got, want, fast;
+    unsigned w = Expect(p, &want);
+    unsigned f = fast_decode(p, &fast);
+    unsigned g = hde_insn_decode(p, &got, cache);
+    s_checked++;
+    if (f) {
+        s_fastHits++;
+        if (!w || fast.len != want.len || fast.flags != want.flags) {
+            fprintf(stderr, "fast path mismatch:");
+            for (int i = 0; i < 16; i++) fprintf(stderr, " %02x", p[i]);
+            fprintf(stderr, " fast %u/%x hde %u/%x\n", fast.len, fast.flags, w ? want.len : 0, want.flags);
+            exit(1);
+        }
+    }
+    CHECK(g == w);
+    if (w) CHECK(got.len == want.len && got.flags == want.flags);
+}
+
+static uint8_t* ReadFile(const char* path, long* size) {
+    FILE* f = fopen(path, "rb");
+    if (!f) return NULL;
+    fseek(f, 0, SEEK_END);
+    long n = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    // Padding so a decode near the end never reads past the buffer
+    uint8_t* blob = (uint8_t*)malloc(n + 32);
+    memset(blob + n, 0xCC, 32);
+    size_t read = fread(blob, 1, n, f);
+    fclose(f);
+    if (read != (size_t)n) {
+        free(blob);
+        return NULL;
+    }
+    *size = n;
+    return blob;
+}
+
+// Byte offsets at random, then linear sweeps that must split the code at
+// the same boundaries as a plain HDE sweep
+static void CheckBinary(const char* path, hde_cache* cache) {
+    long n;
+    uint8_t* blob = ReadFile(path, &n);
+    if (!blob) {
+        fprintf(stderr, "cannot read %s\n", path);
+        exit(1);
+    }
+    for (long i = 0; i + 16 < n; i += 1 + Rand() % 7) Check(blob + i, cache);
+
+    hde_insn* insns = (hde_insn*)malloc(sizeof(hde_insn) * 4096);
+    for (long i = 0; i + 4112 <= n;) {
+        size_t done;
+        unsigned count = hde_decode_range(blob + i, 4096, insns, 4096, &done, cache);
+        long k = i;
+        for (unsigned j = 0; j < count; j++) {
+            hde_insn e;
+            CHECK(Expect(blob + k, &e) == insns[j].len);
+            CHECK(e.flags == insns[j].flags);
+            k += insns[j].len;
+        }
+        CHECK((size_t)(k - i) == done);
+        // Stopped early only on an invalid instruction
+        if (done < 4096 && count < 4096) {
+            hde_insn e;
+            CHECK(Expect(blob + k, &e) == 0);
+        }
+        i += done ? (long)done : 1;
+    }
+
+    // Prologue-sized ranges: stops once size is covered (the last
+    // instruction may run past it) or after max_insns, whichever is first
+    for (long t = 0; t < 200000 && n > 64; t++) {
+        long i = (long)(Rand() % (uint32_t)(n - 64));
+        size_t size = Rand() % 17;
+        unsigned max = Rand() % 9;
+        size_t done = (size_t)-1;
+        unsigned count = hde_decode_range(blob + i, size, insns, max, &done, cache);
+        CHECK(count <= max);
+        size_t covered = 0;
+        for (unsigned j = 0; j < count; j++) {
+            CHECK(covered < size);
+            covered += insns[j].len;
+        }
+        CHECK(covered == done);
+        if (count < max && done < size) {
+            hde_insn e;
+            CHECK(Expect(blob + i + done, &e) == 0);
+        }
+        CHECK(hde_decode_range(blob + i, size, insns, max, NULL, NULL) == count);
+    }
+    free(insns);
+    free(blob);
+}
+
+static int FuzzMain(const char* mode, int argc, char** argv) {
+    static uint8_t buf[64];
+    static const uint8_t rexes[] = { 0, 0x40, 0x48, 0x4D };
+    const int rexCount = HDE_MODE64 ? 4 : 1;
+    const int full = HasArg(argc, argv, "--long");
+    hde_cache* cache = (hde_cache*)calloc(1, sizeof(hde_cache));
+
+    // 1. [66] [REX] [0F] opcode x ModR/M (x SIB with --long), random tail
+    for (int v = 0; v < 4; v++) {
+        for (int r = 0; r < rexCount; r++) {
+            for (int op = 0; op < 256; op++) {
+                for (int modrm = 0; modrm < 256; modrm++) {
+                    for (int sib = 0; sib < (full ? 256 : 1); sib++) {
+                        uint8_t* q = buf;
+                        if (v & 1) *q++ = 0x66;
+                        if (rexes[r]) *q++ = rexes[r];
+                        if (v & 2) *q++ = 0x0F;
+                        *q++ = (uint8_t)op;
+                        *q++ = (uint8_t)modrm;
+                        *q++ = full ? (uint8_t)sib : (uint8_t)Rand();
+                        while (q < buf + 32) *q++ = (uint8_t)Rand();
+                        Check(buf, NULL);
+                    }
+                }
+            }
+        }
+    }
+    // ENDBR and the other F3 0F 1E forms compilers put at function entry
+    for (int t = 0; t < 100000; t++) {
+        buf[0] = 0xF3;
+        buf[1] = 0x0F;
+        buf[2] = 0x1E;
+        buf[3] = (uint8_t)(0xF8 | (t & 7));
+        for (int j = 4; j < 32; j++) buf[j] = (uint8_t)Rand();
+        Check(buf, NULL);
+    }
+
+    // 2. Random bytes, biased towards prefixes and the 0F escape
+    static const uint8_t prefixes[] = { 0x66, 0x67, 0xF2, 0xF3, 0xF0, 0x2E, 0x64, 0x0F, 0x0F, 0x0F, 0x48, 0x41 };
+    const long streams = full ? 20000000 : 2000000;
+    for (long i = 0; i < streams; i++) {
+        for (int j = 0; j < 32; j++) buf[j] = (uint8_t)Rand();
+        for (int j = 0, n = Rand() % 4; j < n; j++) buf[j] = prefixes[Rand() % sizeof(prefixes)];
+        Check(buf, NULL);
+    }
+
+    // 3. Real code
+    CheckBinary(argv[0], cache);
+    for (int a = 1; a < argc; a++) {
+        if (argv[a][0] != '-') CheckBinary(argv[a], cache);
+    }
+
+    // 4. Cache: decode, patch bytes under cached entries, decode again
+    uint8_t* code = (uint8_t*)malloc(4096 + 32);
+    const int rounds = full ? 20000 : 2000;
+    for (int round = 0; round < rounds; round++) {
+        for (int j = 0; j < 4096 + 32; j++) code[j] = (Rand() & 1) ? 0x0F : (uint8_t)Rand();
+        for (int pass = 0; pass < 3; pass++) {
+            for (int j = 0; j < 4096; j += 1 + Rand() % 3) Check(code + j, cache);
+            for (int j = 0; j < 64; j++) code[Rand() % 4096] = (uint8_t)Rand();
+        }
+    }
+    CHECK(cache->hits > 0 && cache->misses > 0);
+
+    printf("%s: %ld instructions checked, %ld on the fast path, cache hits %u misses %u\n",
+           mode, s_checked, s_fastHits, cache->hits, cache->misses);
+    free(code);
+    free(cache);
+    return 0;
+}
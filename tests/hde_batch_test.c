@@ -0,0 +1,7 @@
+// hde_batch.c against hde64_disasm; see hde_batch_fuzz.h
+#include "hde_batch.c"
+#include "hde_batch_fuzz.h"
+
+int main(int argc, char** argv) {
+    return FuzzMain("x64", argc, argv);
+}
@@ -0,0 +1,16 @@
+// hde_batch.c against hde32_disasm, built on an x86-64 host: system
+// headers first, then the 32-bit decoder is selected by pretending i386
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#undef __x86_64__
+#define __i386__ 1
+#include "hde32.c"
+#include "hde_batch.c"
+#include "hde_batch_fuzz.h"
+
+int main(int argc, char** argv) {
+    return FuzzMain("x86", argc, argv);
+}
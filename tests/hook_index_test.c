@@ -0,0 +1,94 @@
+// hook_index.c against a direct-mapped reference: random inserts, erases
+// and position updates over a small key space, so probe runs get long and
+// erasing has to repair them.
+
+#include "hook_index.h"
+#include "test_util.h"
+
+#define KEYS 3000
+
+static uint64_t s_rng = 0x9E3779B97F4A7C15ull;
+
+static uint32_t Rand(void) {
+    s_rng ^= s_rng << 13;
+    s_rng ^= s_rng >> 7;
+    s_rng ^= s_rng << 17;
+    return (uint32_t)s_rng;
+}
+
+// Key k: function-like addresses with either a small or a page stride,
+// in ranges that do not overlap
+static void* KeyAddress(uint32_t k) {
+    uintptr_t n = (uintptr_t)(k >> 1) + 1;
+    return (void*)((k & 1) ? 0x10000000 + n * 16 : n * 4096);
+}
+
+static void Grow(HOOK_INDEX* index) {
+    uint32_t capacity = HookIndexCapacityFor(index->size + 1);
+    if (capacity > index->capacity) {
+        HOOK_INDEX_SLOT* slots = (HOOK_INDEX_SLOT*)calloc(capacity, sizeof(HOOK_INDEX_SLOT));
+        free(HookIndexRehash(index, slots, capacity));
+    }
+}
+
+int main(void) {
+    static uint32_t expected[2 * KEYS];
+    static int present[2 * KEYS];
+    HOOK_INDEX index = { 0 };
+    uint32_t live = 0;
+
+    CHECK(HookIndexCapacityFor(8) == 16 && HookIndexCapacityFor(9) == 32);
+    CHECK(HookIndexFind(&index, KeyAddress(0)) == HOOK_INDEX_NONE);
+
+    for (long step = 0; step < 3000000; step++) {
+        uint32_t k = Rand() % (2 * KEYS);
+        void* key = KeyAddress(k);
+        switch (Rand() % 4) {
+            case 0:
+            case 1:
+                if (!present[k]) {
+                    Grow(&index);
+                    expected[k] = Rand() % 0x7FFFFFFF;
+                    present[k] = 1;
+                    live++;
+                    HookIndexInsert(&index, key, expected[k]);
+                }
+                break;
+            case 2:
+                if (present[k]) {
+                    HookIndexErase(&index, key);
+                    present[k] = 0;
+                    live--;
+                }
+                break;
+            default:
+                if (present[k]) {
+                    expected[k] = Rand() % 0x7FFFFFFF;
+                    HookIndexUpdate(&index, key, expected[k]);
+                }
+                break;
+        }
+
+        CHECK(HookIndexFind(&index, key) == (present[k] ? expected[k] : HOOK_INDEX_NONE));
+        CHECK(index.size == live);
+        CHECK(index.capacity == 0 || index.size * 2 <= index.capacity);
+
+        if (step % 100000 == 0) {
+            for (uint32_t i = 0; i < 2 * KEYS; i++) {
+                CHECK(HookIndexFind(&index, KeyAddress(i)) == (present[i] ? expected[i] : HOOK_INDEX_NONE));
+            }
+        }
+    }
+
+    // Emptying the table leaves every slot free
+    for (uint32_t i = 0; i < 2 * KEYS; i++) {
+        if (present[i]) HookIndexErase(&index, KeyAddress(i));
+    }
+    CHECK(index.size == 0);
+    for (uint32_t i = 0; i < index.capacity; i++) CHECK(index.pSlots[i].pTarget == NULL);
+    CHECK(HookIndexFind(&index, NULL) == HOOK_INDEX_NONE);
+
+    printf("hook_index: 3000000 operations, final capacity %u\n", index.capacity);
+    free(index.pSlots);
+    return 0;
+}
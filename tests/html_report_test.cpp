@@ -0,0 +1,217 @@
+// HtmlReport on synthetic captures: the page is self-contained (no src,
+// href, url(), @import or URL anywhere in its markup, scripts or styles,
+// and only the tags the report itself writes), capture and exe names that
+// carry markup come out escaped, every table, div and script is closed,
+// and the data and tables match the captures: one REPORT entry and summary
+// row per usable capture, frame counts, segments, hitches capped at
+// maxHitches. Captures without frames are skipped, none at all fails.
+
+#include "capture.h"
+#include "html_report.h"
+#include "test_util.h"
+
+#include <cctype>
+#include <cstring>
+#include <set>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+    constexpr uint64_t kFrequency = 10000000;
+
+    std::string s_dir;
+
+    // 16.6 ms frames with a 200 ms stall every `stallEvery` frames
+    std::string WriteCapture(const char* file, const char* exeName, size_t frames, size_t stallEvery) {
+        Capture::FileHeader header = {};
+        header.qpcFrequency = kFrequency;
+        header.startQpc = 1000;
+        header.pid = 77;
+        std::strncpy(header.exeName, exeName, sizeof(header.exeName) - 1);
+
+        const std::string path = s_dir + "/" + file;
+        Capture::Writer writer;
+        CHECK(writer.Open(path.c_str(), header));
+        uint64_t qpc = 1000;
+        for (size_t i = 0; i < frames; i++) {
+            Capture::FrameRecord f = {};
+            f.presentQpc = qpc;
+            f.swapChainId = 1;
+            writer.Append(f);
+            qpc += stallEvery && i % stallEvery == stallEvery - 1 ? 2000000 : 166000;
+        }
+        writer.Close();
+        return path;
+    }
+
+    std::string Report(const std::vector<HtmlReport::Input>& inputs, const HtmlReport::Options& options, bool* ok) {
+        const std::string path = s_dir + "/report.html";
+        std::FILE* f = std::fopen(path.c_str(), "wb");
+        CHECK(f != nullptr);
+        *ok = HtmlReport::Write(inputs, f, options);
+        CHECK(std::fclose(f) == 0);
+
+        f = std::fopen(path.c_str(), "rb");
+        CHECK(f != nullptr);
+        std::string text;
+        char buffer[4096];
+        size_t n;
+        while ((n = std::fread(buffer, 1, sizeof(buffer), f)) > 0) text.append(buffer, n);
+        std::fclose(f);
+        return text;
+    }
+
+    size_t Count(const std::string& text, const std::string& needle) {
+        size_t count = 0;
+        for (size_t at = text.find(needle); at != std::string::npos; at = text.find(needle, at + 1)) count++;
+        return count;
+    }
+
+    std::string Lower(std::string text) {
+        for (char& c : text) c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+        return text;
+    }
+
+    // Nothing the browser would fetch. Markup (tags with their attributes,
+    // and the bodies of <script> and <style>) must not hold an attribute or
+    // CSS that loads a resource, a URL with a scheme or a protocol-relative
+    // one, or any tag the report does not write itself. Text between tags
+    // is inert once it has no '<', which the tag scan guarantees.
+    void CheckSelfContained(const std::string& html) {
+        static const std::set<std::string> allowed = { "!doctype", "html", "head", "meta", "title", "style", "body",
+                                                       "h1", "h2", "h3", "div", "table", "tr", "th", "td", "canvas",
+                                                       "script" };
+        const std::string lower = Lower(html);
+        std::string markup;
+        size_t at = 0;
+        while ((at = lower.find('<', at)) != std::string::npos) {
+            const size_t nameStart = at + 1 + (lower[at + 1] == '/' ? 1 : 0);
+            size_t nameEnd = nameStart;
+            while (nameEnd < lower.size() && (std::isalnum(static_cast<unsigned char>(lower[nameEnd])) || lower[nameEnd] == '!')) {
+                nameEnd++;
+            }
+            const std::string name = lower.substr(nameStart, nameEnd - nameStart);
+            CHECK(allowed.count(name) == 1);
+            size_t close = lower.find('>', at);
+            CHECK(close != std::string::npos);
+            if (lower[at + 1] != '/' && (name == "script" || name == "style")) {
+                CHECK(close == nameEnd);        // No attributes
+                close = lower.find("</" + name + ">", close);
+                CHECK(close != std::string::npos);
+            }
+            markup.append(lower, at, close + 1 - at);
+            markup += '\n';
+            at = close + 1;
+        }
+
+        const char* forbidden[] = { "src", "href", "url(", "@import", "://", "//", "<link", "fetch(", "xmlhttprequest",
+                                    "import(", "new image", "websocket" };
+        for (const char* needle : forbidden) {
+            if (markup.find(needle) != std::string::npos) {
+                std::fprintf(stderr, "found \"%s\" in report markup\n", needle);
+                CHECK(false);
+            }
+        }
+    }
+
+    void CheckBalanced(const std::string& html) {
+        const char* tags[] = { "html", "head", "body", "style", "script", "table", "tr", "div", "h1", "h2", "h3", "title" };
+        for (const char* tag : tags) {
+            const std::string open = std::string("<") + tag;
+            const size_t opens = Count(html, open + ">") + Count(html, open + " ");
+            CHECK(opens > 0 && opens == Count(html, std::string("</") + tag + ">"));
+        }
+        CHECK(html.compare(0, 15, "<!DOCTYPE html>") == 0);
+        CHECK(html.size() > 8 && html.compare(html.size() - 8, 8, "</html>\n") == 0);
+    }
+
+    void TestReport() {
+        const char hostile[] = "<img src=\"http://example.com/x.png\">&\\.exe";
+        const std::string steady = WriteCapture("steady.fpsc", "game.exe", 3600, 0);
+        const std::string stalls = WriteCapture("stalls.fpsc", hostile, 20000, 100);
+        const std::string empty = WriteCapture("empty.fpsc", "menu.exe", 1, 0);
+
+        Capture::Reader readers[3];
+        CHECK(readers[0].Open(steady.c_str()) && readers[1].Open(stalls.c_str()) && readers[2].Open(empty.c_str()));
+        const std::string hostilePath = s_dir + "/<svg onload=alert(1)>.fpsc";
+        std::vector<HtmlReport::Input> inputs = {
+            { steady.c_str(), &readers[0] },
+            { empty.c_str(), &readers[2] },
+            { hostilePath.c_str(), &readers[1] },
+        };
+
+        HtmlReport::Options options;
+        options.segmentSeconds = 30.0;
+        options.maxHitches = 25;
+        bool ok = false;
+        const std::string html = Report(inputs, options, &ok);
+        CHECK(ok);
+
+        CheckSelfContained(html);
+        CheckBalanced(html);
+
+        // Markup in names is shown, not interpreted
+        CHECK(Count(html, "&lt;img src=&quot;http://example.com/x.png&quot;&gt;&amp;&#92;.exe") == 2);
+        CHECK(Count(html, "&lt;svg onload=alert(1)&gt;.fpsc") == 2);
+
+        // The empty capture is skipped: two sections, two rows, two REPORT entries
+        CHECK(Count(html, "steady.fpsc") == 2 && Count(html, "empty.fpsc") == 0);
+        CHECK(Count(html, "<canvas class=\"chart\"") == 2 && Count(html, "{duration:") == 2);
+        CHECK(Count(html, "2 capture(s)") == 1);
+        CHECK(Count(html, "3599 frames") == 1 && Count(html, "19999 frames") == 1);
+        CHECK(Count(html, "<td class=\"l\">p99</td>") == 2);
+
+        // 199 stalls, only the 25 longest listed; the steady capture has none
+        CHECK(Count(html, "Hitches (0 total, longest 0 listed)") == 1);
+        CHECK(Count(html, "Hitches (199 total, longest 25 listed)") == 1);
+        CHECK(Count(html, "<td class=\"bad\">200.00</td>") == 25);
+
+        // 30 s segments: 59.7 s of steady frames, 368.5 s with the stalls
+        CHECK(Count(html, "<tr><td class=\"l\">30 s</td>") == 2);
+        CHECK(Count(html, "<tr><td class=\"l\">60 s</td>") == 1);
+        CHECK(Count(html, "<tr><td class=\"l\">360 s</td>") == 1);
+        CHECK(Count(html, "<tr><td class=\"l\">390 s</td>") == 0);
+    }
+
+    void TestNames() {
+        // The capture and exe names themselves, escaped in the sections
+        const std::string path = WriteCapture("a&b.fpsc", "x<y>\"z\".exe", 100, 0);
+        Capture::Reader reader;
+        CHECK(reader.Open(path.c_str()));
+        const std::string windowsPath = "C:\\captures\\<b onclick=x>bold.fpsc";
+        bool ok = false;
+        const std::string html = Report({ { windowsPath.c_str(), &reader } }, HtmlReport::Options(), &ok);
+        CHECK(ok);
+        CheckSelfContained(html);
+        CheckBalanced(html);
+        CHECK(Count(html, "&lt;b onclick=x&gt;bold.fpsc") == 2);
+        CHECK(Count(html, "x&lt;y&gt;&quot;z&quot;.exe") == 2);
+        CHECK(Count(html, "C:") == 0);      // Only the file name is shown
+    }
+
+    void TestNothingUsable() {
+        const std::string path = WriteCapture("one.fpsc", "game.exe", 1, 0);
+        Capture::Reader reader;
+        CHECK(reader.Open(path.c_str()));
+        bool ok = true;
+        const std::string html = Report({ { path.c_str(), &reader } }, HtmlReport::Options(), &ok);
+        CHECK(!ok && html.empty());
+        CHECK(!HtmlReport::Write({}, stdout));
+    }
+}
+
+int main() {
+    char dir[] = "/tmp/html_report_test.XXXXXX";
+    CHECK(mkdtemp(dir) != nullptr);
+    s_dir = dir;
+
+    TestReport();
+    TestNames();
+    TestNothingUsable();
+
+    std::string cleanup = "rm -rf " + s_dir;
+    CHECK(std::system(cleanup.c_str()) == 0);
+    std::printf("html_report: ok\n");
+    return 0;
+}
@@ -0,0 +1,194 @@
+// Loading the overlay settings: IniFile::Parse plus one Get per key, against
+// re-scanning the text for every key (what GetPrivateProfileString does,
+// without the file I/O) and against parsing into a std::map. Then the cost
+// of a single lookup on a small and a large file.
+//
+// usage: ini_file_bench [--quick]
+
+#include "ini_file.h"
+#include "test_util.h"
+
+#include <algorithm>
+#include <cstring>
+#include <map>
+#include <string>
+#include <strings.h>
+#include <utility>
+#include <vector>
+
+namespace {
+    const char* const kOverlayKeys[] = {
+        "Visible", "Alpha", "ShowFps", "ShowFrameTime", "ShowStutter", "ShowGraph", "GraphSeconds",
+        "GraphWidth", "GraphHeight", "Capture", "SessionSketch", "GreenThreshold", "YellowThreshold",
+        "FontScale", "SampleCount", "DisplayUpdateMs", "MarginX", "MarginY", "Corner", "ToggleKey",
+    };
+    constexpr int kOverlayKeyCount = sizeof(kOverlayKeys) / sizeof(kOverlayKeys[0]);
+
+    std::string OverlayFile() {
+        std::string text = "; fps_overlay settings\r\n[Overlay]\r\n";
+        for (int i = 0; i < kOverlayKeyCount; i++) {
+            text += std::string(kOverlayKeys[i]) + " = " + std::to_string(i * 3 + 1) + "\r\n";
+        }
+        text += "\r\n[Hotkeys]\r\nToggle=F1\r\nScreenshot=F12\r\n";
+        return text;
+    }
+
+    size_t TrimEnd(const char* s, size_t n) {
+        while (n > 0 && (s[n - 1] == ' ' || s[n - 1] == '\t' || s[n - 1] == '\r')) n--;
+        return n;
+    }
+
+    const char* SkipSpace(const char* s, const char* end) {
+        while (s < end && (*s == ' ' || *s == '\t')) s++;
+        return s;
+    }
+
+    // One pass over the text per lookup, copying the value out
+    bool ScanGet(const std::string& text, const char* section, const char* key, char* out, size_t outSize) {
+        const size_t sectionLen = std::strlen(section), keyLen = std::strlen(key);
+        bool inSection = false;
+        const char* p = text.data();
+        const char* end = p + text.size();
+        while (p < end) {
+            const char* eol = static_cast<const char*>(std::memchr(p, '\n', static_cast<size_t>(end - p)));
+            if (!eol) eol = end;
+            const char* line = SkipSpace(p, eol);
+            size_t n = TrimEnd(line, static_cast<size_t>(eol - line));
+            p = eol + 1;
+            if (n == 0 || line[0] == ';') continue;
+            if (line[0] == '[') {
+                inSection = n >= sectionLen + 2 && line[sectionLen + 1] == ']' &&
+                            strncasecmp(line + 1, section, sectionLen) == 0;
+                continue;
+            }
+            if (!inSection) continue;
+            const char* eq = static_cast<const char*>(std::memchr(line, '=', n));
+            if (!eq || TrimEnd(line, static_cast<size_t>(eq - line)) != keyLen || strncasecmp(line, key, keyLen) != 0) {
+                continue;
+            }
+            const char* value = SkipSpace(eq + 1, line + n);
+            size_t valueLen = std::min(static_cast<size_t>(line + n - value), outSize - 1);
+            std::memcpy(out, value, valueLen);
+            out[valueLen] = '\0';
+            return true;
+        }
+        return false;
+    }
+
+    using Map = std::map<std::pair<std::string, std::string>, std::string>;
+
+    std::string Lower(const char* s, size_t n) {
+        std::string out(s, n);
+        for (char& c : out) {
+            if (c >= 'A' && c <= 'Z') c = static_cast<char>(c - 'A' + 'a');
+        }
+        return out;
+    }
+
+    void MapParse(const std::string& text, Map& map) {
+        map.clear();
+        std::string section;
+        const char* p = text.data();
+        const char* end = p + text.size();
+        while (p < end) {
+            const char* eol = static_cast<const char*>(std::memchr(p, '\n', static_cast<size_t>(end - p)));
+            if (!eol) eol = end;
+            const char* line = SkipSpace(p, eol);
+            size_t n = TrimEnd(line, static_cast<size_t>(eol - line));
+            p = eol + 1;
+            if (n == 0 || line[0] == ';') continue;
+            if (line[0] == '[') {
+                const char* close = static_cast<const char*>(std::memchr(line, ']', n));
+                section = Lower(line + 1, close ? static_cast<size_t>(close - line - 1) : n - 1);
+                continue;
+            }
+            const char* eq = static_cast<const char*>(std::memchr(line, '=', n));
+            if (!eq) continue;
+            const char* value = SkipSpace(eq + 1, line + n);
+            map.emplace(std::make_pair(section, Lower(line, TrimEnd(line, static_cast<size_t>(eq - line)))),
+                        std::string(value, static_cast<size_t>(line + n - value)));
+        }
+    }
+
+    const char* MapGet(const Map& map, const char* section, const char* key) {
+        auto it = map.find(std::make_pair(Lower(section, std::strlen(section)), Lower(key, std::strlen(key))));
+        return it == map.end() ? nullptr : it->second.c_str();
+    }
+
+    void BenchLoad(int reps) {
+        const std::string text = OverlayFile();
+        volatile size_t sink = 0;
+        char value[64];
+
+        double t0 = NowNs();
+        for (int r = 0; r < reps; r++) {
+            IniFile ini;
+            ini.Parse(text.data(), text.size());
+            for (const char* key : kOverlayKeys) sink += reinterpret_cast<uintptr_t>(ini.Get("Overlay", key));
+        }
+        double t1 = NowNs();
+        for (int r = 0; r < reps; r++) {
+            for (const char* key : kOverlayKeys) {
+                CHECK(ScanGet(text, "Overlay", key, value, sizeof(value)));
+                sink += static_cast<unsigned char>(value[0]);
+            }
+        }
+        double t2 = NowNs();
+        Map map;
+        for (int r = 0; r < reps; r++) {
+            MapParse(text, map);
+            for (const char* key : kOverlayKeys) sink += reinterpret_cast<uintptr_t>(MapGet(map, "Overlay", key));
+        }
+        double t3 = NowNs();
+
+        std::printf("overlay settings (%zu bytes, %d keys)\n", text.size(), kOverlayKeyCount);
+        std::printf("%-26s %10s\n", "load", "us");
+        std::printf("%-26s %10.2f\n", "IniFile parse + Get", (t1 - t0) / reps / 1e3);
+        std::printf("%-26s %10.2f\n", "scan per key", (t2 - t1) / reps / 1e3);
+        std::printf("%-26s %10.2f\n", "std::map parse + find", (t3 - t2) / reps / 1e3);
+    }
+
+    void BenchLookup(int reps) {
+        std::printf("\n%8s %26s %10s\n", "keys", "lookup", "ns");
+        for (int sections : { 1, 100 }) {
+            std::string text;
+            std::vector<std::pair<std::string, std::string>> names;
+            for (int s = 0; s < sections; s++) {
+                text += "[Section" + std::to_string(s) + "]\n";
+                for (int k = 0; k < kOverlayKeyCount; k++) {
+                    text += std::string(kOverlayKeys[k]) + "=" + std::to_string(k) + "\n";
+                    names.emplace_back("section" + std::to_string(s), kOverlayKeys[k]);
+                }
+            }
+            IniFile ini;
+            ini.Parse(text.data(), text.size());
+            Map map;
+            MapParse(text, map);
+            CHECK(ini.Size() == names.size() && map.size() == names.size());
+
+            const size_t count = names.size();
+            const int lookups = reps * kOverlayKeyCount;
+            volatile size_t sink = 0;
+            double t0 = NowNs();
+            for (int i = 0; i < lookups; i++) {
+                const auto& name = names[(static_cast<size_t>(i) * 7919u) % count];
+                sink += reinterpret_cast<uintptr_t>(ini.Get(name.first.c_str(), name.second.c_str()));
+            }
+            double t1 = NowNs();
+            for (int i = 0; i < lookups; i++) {
+                const auto& name = names[(static_cast<size_t>(i) * 7919u) % count];
+                sink += reinterpret_cast<uintptr_t>(MapGet(map, name.first.c_str(), name.second.c_str()));
+            }
+            double t2 = NowNs();
+            std::printf("%8zu %26s %10.1f\n", count, "IniFile::Get", (t1 - t0) / lookups);
+            std::printf("%8zu %26s %10.1f\n", count, "std::map find", (t2 - t1) / lookups);
+        }
+    }
+}
+
+int main(int argc, char** argv) {
+    const int reps = HasArg(argc, argv, "--quick") ? 200 : 20000;
+    BenchLoad(reps);
+    BenchLookup(reps);
+    return 0;
+}
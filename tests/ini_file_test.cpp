@@ -0,0 +1,221 @@
+// IniFile: GetPrivateProfileString semantics on hand-written files, then a
+// fuzz against a straightforward reference parser (random ASCII built from
+// INI syntax), random binary input (must not crash) and a large file that
+// forces a big perfect-hash index.
+
+#include "ini_file.h"
+#include "test_util.h"
+
+#include <cstring>
+#include <map>
+#include <random>
+#include <string>
+#include <utility>
+
+namespace {
+    using Map = std::map<std::pair<std::string, std::string>, std::string>;
+
+    std::string Lower(std::string s) {
+        for (char& c : s) {
+            if (c >= 'A' && c <= 'Z') c = static_cast<char>(c - 'A' + 'a');
+        }
+        return s;
+    }
+
+    std::string Trim(const std::string& s) {
+        auto space = [](char c) { return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f'; };
+        size_t b = 0, e = s.size();
+        while (b < e && space(s[b])) b++;
+        while (e > b && space(s[e - 1])) e--;
+        return s.substr(b, e - b);
+    }
+
+    // Line by line, the obvious way
+    Map Reference(const std::string& text) {
+        Map map;
+        std::string section;
+        for (size_t i = 0; i <= text.size();) {
+            size_t j = i;
+            while (j < text.size() && text[j] != '\n' && text[j] != '\0') j++;
+            std::string line = Trim(text.substr(i, j - i));
+            i = j + 1;
+            if (line.empty() || line[0] == ';') continue;
+            if (line[0] == '[') {
+                size_t close = line.find(']');
+                section = Trim(line.substr(1, (close == std::string::npos ? line.size() : close) - 1));
+                continue;
+            }
+            size_t eq = line.find('=');
+            if (eq == std::string::npos) continue;
+            std::string key = Trim(line.substr(0, eq));
+            if (key.empty()) continue;
+            std::string value = Trim(line.substr(eq + 1));
+            if (value.size() >= 2 && (value[0] == '"' || value[0] == '\'') && value.back() == value[0]) {
+                value = value.substr(1, value.size() - 2);
+            }
+            map.emplace(std::make_pair(Lower(section), Lower(key)), value);   // First one wins
+        }
+        return map;
+    }
+
+    void Parse(IniFile& ini, const std::string& text) {
+        ini.Parse(text.data(), text.size());
+    }
+
+    bool Is(const char* value, const char* expected) {
+        return value && std::strcmp(value, expected) == 0;
+    }
+
+    void TestSemantics() {
+        IniFile ini;
+        Parse(ini,
+              "top = before any section\r\n"
+              "[Overlay]\r\n"
+              "  Alpha = 0.25  \r\n"
+              "Name=\"  quoted  \"\r\n"
+              "Single='x'\r\n"
+              "Mismatched=\"x'\r\n"
+              "; Hidden=1\r\n"
+              "#Key=hash\r\n"
+              "Alpha=0.75\r\n"
+              "Empty=\r\n"
+              "NoEquals\r\n"
+              "=no key\r\n"
+              "Hex=0x1F\r\n"
+              "Bad=abc\r\n"
+              "On=Yes\r\n"
+              "Off=off\r\n"
+              "[ other section ]\n"
+              "alpha=other\n"
+              "[Unclosed\n"
+              "k=v");
+        CHECK(Is(ini.Get("", "top"), "before any section"));
+        CHECK(Is(ini.Get("overlay", "ALPHA"), "0.25"));     // Case-insensitive, first wins
+        CHECK(Is(ini.Get("Overlay", "Name"), "  quoted  "));
+        CHECK(Is(ini.Get("Overlay", "Single"), "x"));
+        CHECK(Is(ini.Get("Overlay", "Mismatched"), "\"x'"));
+        CHECK(ini.Get("Overlay", "Hidden") == nullptr);
+        CHECK(ini.Get("Overlay", "; Hidden") == nullptr);
+        // '#' is an ordinary character, as for GetPrivateProfileString
+        CHECK(Is(ini.Get("Overlay", "#Key"), "hash"));
+        CHECK(ini.Get("Overlay", "Key") == nullptr);
+        CHECK(Is(ini.Get("Overlay", "Empty"), ""));
+        CHECK(ini.Get("Overlay", "NoEquals") == nullptr);
+        CHECK(Is(ini.Get("other section", "alpha"), "other"));
+        CHECK(Is(ini.Get("unclosed", "k"), "v"));
+        CHECK(ini.Size() == 13);
+
+        CHECK(ini.GetInt("Overlay", "Hex", -1) == 31);
+        CHECK(ini.GetInt("Overlay", "Bad", -1) == 0);
+        CHECK(ini.GetInt("Overlay", "Missing", -1) == -1);
+        CHECK(ini.GetFloat("Overlay", "Alpha", 0.0f) == 0.25f);
+        CHECK(ini.GetFloat("Overlay", "Bad", 2.0f) == 2.0f);
+        CHECK(ini.GetBool("Overlay", "On", false));
+        CHECK(!ini.GetBool("Overlay", "Off", true));
+        CHECK(ini.GetBool("Overlay", "Bad", true));
+        CHECK(Is(ini.GetString("Overlay", "Missing", "def"), "def"));
+
+        // Parse replaces the previous content
+        Parse(ini, "[a]\nb=c\n");
+        CHECK(ini.Size() == 1 && ini.Get("Overlay", "Alpha") == nullptr && Is(ini.Get("A", "B"), "c"));
+        Parse(ini, "");
+        CHECK(ini.Size() == 0 && ini.Get("a", "b") == nullptr);
+    }
+
+    void TestEncodings() {
+        IniFile ini;
+        const std::u16string text = u"[Overlay]\r\nAlpha=0.5\r\nName=é中\U0001F600\r\n";
+        const char* expected = "\xC3\xA9\xE4\xB8\xAD\xF0\x9F\x98\x80";
+        for (int bigEndian = 0; bigEndian < 2; bigEndian++) {
+            std::string bytes = bigEndian ? "\xFE\xFF" : "\xFF\xFE";
+            for (char16_t c : text) {
+                char lo = static_cast<char>(c & 0xFF), hi = static_cast<char>(c >> 8);
+                bytes.push_back(bigEndian ? hi : lo);
+                bytes.push_back(bigEndian ? lo : hi);
+            }
+            Parse(ini, bytes);
+            CHECK(ini.GetFloat("overlay", "alpha", 0.0f) == 0.5f);
+            CHECK(Is(ini.Get("Overlay", "Name"), expected));
+        }
+
+        Parse(ini, std::string("\xEF\xBB\xBF[s]\nk=") + expected + "\n");
+        CHECK(Is(ini.Get("s", "k"), expected));
+        // Not UTF-8: read as Latin-1
+        Parse(ini, "[s]\nk=caf\xE9\n");
+        CHECK(Is(ini.Get("s", "k"), "caf\xC3\xA9"));
+    }
+
+    long FuzzAgainstReference() {
+        std::mt19937 rng(1);
+        const char* alphabet = "ab[]=;# \t\r\n\"'ABxyz";
+        const size_t alphabetSize = std::strlen(alphabet);
+        long checks = 0;
+        for (int it = 0; it < 200000; it++) {
+            std::string text;
+            int length = static_cast<int>(rng() % 200);
+            for (int k = 0; k < length; k++) text.push_back(alphabet[rng() % alphabetSize]);
+            if (rng() % 10 == 0) text.push_back(static_cast<char>(rng() % 0x80));
+
+            IniFile ini;
+            Parse(ini, text);
+            Map expected = Reference(text);
+            CHECK(ini.Size() == expected.size());
+            for (const auto& kv : expected) {
+                CHECK(Is(ini.Get(kv.first.first.c_str(), kv.first.second.c_str()), kv.second.c_str()));
+                std::string upper = kv.first.second;
+                for (char& c : upper) {
+                    if (c >= 'a' && c <= 'z') c = static_cast<char>(c - 'a' + 'A');
+                }
+                CHECK(ini.Get(kv.first.first.c_str(), upper.c_str()) != nullptr);
+                checks++;
+            }
+            CHECK(ini.Get("zz", "nokey") == nullptr);
+        }
+        return checks;
+    }
+
+    void FuzzBinary() {
+        std::mt19937 rng(2);
+        for (int it = 0; it < 100000; it++) {
+            std::string bytes;
+            int length = static_cast<int>(rng() % 300);
+            for (int k = 0; k < length; k++) bytes.push_back(static_cast<char>(rng()));
+            if (it % 3 == 0) bytes.insert(0, "\xFF\xFE");
+            if (it % 3 == 1) bytes.insert(0, "\xFE\xFF");
+            IniFile ini;
+            Parse(ini, bytes);
+            ini.Get("a", "b");
+            ini.GetInt("", "", 0);
+        }
+    }
+
+    void TestLargeFile() {
+        std::string text;
+        for (int s = 0; s < 50; s++) {
+            text += "[Sec" + std::to_string(s) + "]\r\n";
+            for (int k = 0; k < 40; k++) {
+                text += "Key" + std::to_string(k) + " = value" + std::to_string(s * 100 + k) + "\r\n";
+            }
+        }
+        IniFile ini;
+        Parse(ini, text);
+        CHECK(ini.Size() == 2000);
+        for (int s = 0; s < 50; s++) {
+            for (int k = 0; k < 40; k++) {
+                std::string value = "value" + std::to_string(s * 100 + k);
+                CHECK(Is(ini.Get(("sec" + std::to_string(s)).c_str(), ("KEY" + std::to_string(k)).c_str()), value.c_str()));
+            }
+        }
+        CHECK(ini.Get("sec50", "key0") == nullptr);
+    }
+}
+
+int main() {
+    TestSemantics();
+    TestEncodings();
+    long checks = FuzzAgainstReference();
+    FuzzBinary();
+    TestLargeFile();
+    std::printf("ini_file: ok, %ld fuzzed lookups\n", checks);
+    return 0;
+}
@@ -0,0 +1,211 @@
+// InjectionScheduler with a mock injector and short delays: settle, verify
+// and backoff timing, giving up after maxAttempts, processes that exit while
+// settling or while their inject call is running, pid reuse, delays longer
+// than one lap of the wheel, and Update never waiting for a blocked inject.
+
+#include "injection_scheduler.h"
+#include "test_util.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using State = InjectionScheduler::State;
+using Clock = std::chrono::steady_clock;
+
+namespace {
+    // What the callbacks saw, per pid
+    struct Log {
+        std::mutex mutex;
+        std::condition_variable changed;
+        std::map<uint32_t, std::vector<double>> injectMs;       // Since the pid was first seen
+        std::map<uint32_t, int> verifies;
+        std::map<uint32_t, std::vector<bool>> finished;
+        std::map<uint32_t, Clock::time_point> seen;
+    };
+
+    Log s_log;
+
+    double MsSince(Clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    }
+
+    void Seen(uint32_t pid) {
+        std::lock_guard<std::mutex> lock(s_log.mutex);
+        s_log.seen[pid] = Clock::now();
+    }
+
+    template <typename Pred>
+    bool WaitFor(Pred pred, int timeoutMs = 5000) {
+        std::unique_lock<std::mutex> lock(s_log.mutex);
+        return s_log.changed.wait_for(lock, std::chrono::milliseconds(timeoutMs), pred);
+    }
+
+    bool WaitForState(const InjectionScheduler& scheduler, uint32_t pid, State state) {
+        for (int i = 0; i < 5000; i++) {
+            if (scheduler.StateOf(pid) == state) return true;
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return false;
+    }
+
+    InjectionScheduler::Options FastOptions() {
+        InjectionScheduler::Options options;
+        options.settleMs = 40;
+        options.verifyDelayMs = 20;
+        options.retryBaseMs = 30;
+        options.maxAttempts = 3;
+        options.tickMs = 5;
+        options.wheelSlots = 8;     // 40 ms per lap: settle and backoff wrap around
+        options.workers = 2;
+        return options;
+    }
+
+    // inject succeeds for even pids and pids ending in 7, fails once for pids
+    // ending in 5 and always for other odd pids; verify fails once for pids
+    // ending in 7
+    InjectionScheduler::Callbacks MockCallbacks() {
+        InjectionScheduler::Callbacks callbacks;
+        callbacks.inject = [](uint32_t pid) {
+            std::lock_guard<std::mutex> lock(s_log.mutex);
+            std::vector<double>& calls = s_log.injectMs[pid];
+            calls.push_back(MsSince(s_log.seen[pid]));
+            s_log.changed.notify_all();
+            if (pid % 10 == 5) return calls.size() > 1;
+            return pid % 2 == 0 || pid % 10 == 7;
+        };
+        callbacks.verify = [](uint32_t pid) {
+            std::lock_guard<std::mutex> lock(s_log.mutex);
+            int count = ++s_log.verifies[pid];
+            s_log.changed.notify_all();
+            return pid % 10 != 7 || count > 1;
+        };
+        callbacks.finished = [](const InjectionScheduler::Candidate& process, bool injected) {
+            std::lock_guard<std::mutex> lock(s_log.mutex);
+            s_log.finished[process.pid].push_back(injected);
+            s_log.changed.notify_all();
+        };
+        return callbacks;
+    }
+
+    std::vector<InjectionScheduler::Candidate> Candidates(const std::vector<uint32_t>& pids) {
+        std::vector<InjectionScheduler::Candidate> out;
+        for (uint32_t pid : pids) out.push_back({ pid, 0, "game.exe" });
+        return out;
+    }
+
+    void TestStateMachine() {
+        const InjectionScheduler::Options options = FastOptions();
+        InjectionScheduler scheduler(MockCallbacks(), options);
+        scheduler.Start();
+
+        // 100: ok; 101: always fails; 105: fails once; 107: verify fails once
+        const std::vector<uint32_t> pids = { 100, 101, 105, 107 };
+        for (uint32_t pid : pids) Seen(pid);
+        scheduler.Update(Candidates(pids));
+        for (uint32_t pid : pids) CHECK(scheduler.StateOf(pid) == State::Settling);
+        CHECK(scheduler.Count(State::Settling) == 4);
+
+        CHECK(WaitFor([&] { return s_log.finished.size() == pids.size(); }));
+        // The scan keeps reporting them; nothing restarts
+        for (int i = 0; i < 5; i++) {
+            scheduler.Update(Candidates(pids));
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        }
+
+        std::lock_guard<std::mutex> lock(s_log.mutex);
+        for (uint32_t pid : pids) CHECK(s_log.finished[pid].size() == 1);
+        CHECK(s_log.finished[100][0] && s_log.injectMs[100].size() == 1 && s_log.verifies[100] == 1);
+        CHECK(s_log.injectMs[100][0] >= options.settleMs - options.tickMs);      // Wheel resolution
+
+        // Backoff doubles per attempt, then gives up
+        const std::vector<double>& failed = s_log.injectMs[101];
+        CHECK(!s_log.finished[101][0] && failed.size() == options.maxAttempts);
+        CHECK(failed[1] - failed[0] >= options.retryBaseMs - options.tickMs);
+        CHECK(failed[2] - failed[1] >= 2 * options.retryBaseMs - options.tickMs);
+        CHECK(s_log.verifies.count(101) == 0);
+
+        CHECK(s_log.finished[105][0] && s_log.injectMs[105].size() == 2);
+        CHECK(s_log.finished[107][0] && s_log.injectMs[107].size() == 2 && s_log.verifies[107] == 2);
+
+        CHECK(scheduler.StateOf(100) == State::Injected && scheduler.StateOf(101) == State::Failed);
+        CHECK(scheduler.Count(State::Injected) == 3 && scheduler.Count(State::Failed) == 1);
+        scheduler.Stop();
+    }
+
+    void TestExits() {
+        InjectionScheduler::Options options = FastOptions();
+        options.settleMs = 200;     // Five laps of the wheel
+        std::mutex gate;
+        std::condition_variable released;
+        bool open = false;
+        bool blocked = false;
+
+        InjectionScheduler::Callbacks callbacks = MockCallbacks();
+        auto inject = callbacks.inject;
+        callbacks.inject = [&, inject](uint32_t pid) {
+            bool ok = inject(pid);
+            if (pid == 302) {
+                // Held until the test lets it finish
+                std::unique_lock<std::mutex> lock(gate);
+                blocked = true;
+                released.notify_all();
+                released.wait(lock, [&] { return open; });
+            }
+            return ok;
+        };
+        InjectionScheduler scheduler(callbacks, options);
+        scheduler.Start();
+
+        for (uint32_t pid : { 300u, 302u, 304u }) Seen(pid);
+        Clock::time_point start = Clock::now();
+        scheduler.Update(Candidates({ 300, 302, 304 }));
+
+        // 300 exits while settling: never injected
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        scheduler.Update(Candidates({ 302, 304 }));
+        CHECK(scheduler.StateOf(300) == State::None);
+
+        // 302's inject blocks; the scan tick does not wait for it
+        {
+            std::unique_lock<std::mutex> lock(gate);
+            CHECK(released.wait_for(lock, std::chrono::seconds(5), [&] { return blocked; }));
+        }
+        CHECK(MsSince(start) >= options.settleMs - options.tickMs);
+        Clock::time_point update = Clock::now();
+        scheduler.Update(Candidates({ 304 }));         // 302 exits mid-inject
+        CHECK(MsSince(update) < 50);
+        CHECK(scheduler.StateOf(302) == State::None);
+
+        // pid 304 reused by another exe: a new process, settling again
+        CHECK(WaitForState(scheduler, 304, State::Injected));
+        Seen(304);
+        scheduler.Update({ { 304, 0, "other.exe" } });
+        CHECK(scheduler.StateOf(304) == State::Settling);
+        CHECK(WaitFor([&] { return s_log.finished[304].size() == 2; }));
+
+        {
+            std::lock_guard<std::mutex> lock(gate);
+            open = true;
+        }
+        released.notify_all();
+        scheduler.Stop();
+
+        std::lock_guard<std::mutex> lock(s_log.mutex);
+        CHECK(s_log.injectMs.count(300) == 0);
+        // 302's result arrived after it exited: discarded
+        CHECK(s_log.finished.count(302) == 0 && s_log.verifies.count(302) == 0);
+        CHECK(s_log.injectMs[304].size() == 2);
+    }
+}
+
+int main() {
+    TestStateMachine();
+    TestExits();
+    std::printf("injection_scheduler: ok\n");
+    return 0;
+}
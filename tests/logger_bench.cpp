@@ -0,0 +1,100 @@
+// Cost of a LOG call on the calling thread, text and binary mode, one and
+// four threads, against formatting with snprintf and writing under a mutex
+// (what a synchronous logger pays per line). The timestamp read every call
+// starts with is timed on its own, since its cost depends on the machine.
+//
+// usage: logger_bench [--quick]
+
+#include "logger.h"
+#include "test_util.h"
+
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+
+namespace {
+    // Bursts stay within a ring, with pauses for the writer, so the numbers
+    // are the call itself and not the drop path
+    constexpr int kBurst = 1000;
+
+    std::mutex s_syncMutex;
+    std::FILE* s_syncFile = nullptr;
+    volatile uint64_t s_ticksSink = 0;
+
+    void SyncLog(int i, double ms, const char* name) {
+        char line[256];
+        int n = std::snprintf(line, sizeof(line), "[FPS] frame %d took %.3f ms (%s)\n", i, ms, name);
+        std::lock_guard<std::mutex> lock(s_syncMutex);
+        std::fwrite(line, 1, static_cast<size_t>(n), s_syncFile);
+    }
+
+    template <typename Fn>
+    double TimeBursts(int bursts, Fn&& fn) {
+        double total = 0;
+        for (int b = 0; b < bursts; b++) {
+            double t0 = NowNs();
+            for (int i = 0; i < kBurst; i++) fn(i);
+            total += NowNs() - t0;
+            std::this_thread::sleep_for(std::chrono::milliseconds(25));
+        }
+        return total / (static_cast<double>(bursts) * kBurst);
+    }
+
+    template <typename Fn>
+    double TimeThreads(int threads, int bursts, Fn fn) {
+        std::vector<double> perCall(threads);
+        std::vector<std::thread> workers;
+        for (int t = 0; t < threads; t++) {
+            workers.emplace_back([&, t] { perCall[t] = TimeBursts(bursts, fn); });
+        }
+        for (std::thread& worker : workers) worker.join();
+        double sum = 0;
+        for (double ns : perCall) sum += ns;
+        return sum / threads;
+    }
+
+    void Row(const char* name, int threads, double ns) {
+        std::printf("%-26s %7d %10.1f\n", name, threads, ns);
+    }
+}
+
+int main(int argc, char** argv) {
+    const bool quick = HasArg(argc, argv, "--quick");
+    const int bursts = quick ? 2 : 20;
+    char dir[] = "/tmp/logger_bench.XXXXXX";
+    CHECK(mkdtemp(dir) != nullptr);
+    const std::string base = dir;
+
+    std::printf("%-26s %7s %10s\n", "call", "threads", "ns/call");
+    Row("timestamp (Ticks) alone", 1, TimeThreads(1, bursts, [](int) { s_ticksSink = s_ticksSink + Logger::Detail::Ticks(); }));
+    for (int threads : { 1, 4 }) {
+        s_syncFile = std::fopen((base + "/sync.log").c_str(), "wb");
+        CHECK(s_syncFile != nullptr);
+        Row("snprintf + fwrite (mutex)", threads,
+            TimeThreads(threads, bursts, [](int i) { SyncLog(i, i * 0.5, "present"); }));
+        std::fclose(s_syncFile);
+
+        for (int binary = 0; binary < 2; binary++) {
+            std::string path = base + (binary ? "/bench.blog" : "/bench.log");
+            Logger::InitializePath(path.c_str(), binary ? Logger::Mode::Binary : Logger::Mode::Text);
+            const char* mode = binary ? "binary" : "text";
+            std::string name;
+            name = std::string("LOG no args, ") + mode;
+            Row(name.c_str(), threads, TimeThreads(threads, bursts, [](int) { LOG("frame"); }));
+            name = std::string("LOG int + double, ") + mode;
+            Row(name.c_str(), threads, TimeThreads(threads, bursts, [](int i) { LOG("frame %d took %.3f ms", i, i * 0.5); }));
+            name = std::string("LOG + string, ") + mode;
+            Row(name.c_str(), threads, TimeThreads(threads, bursts, [](int i) {
+                LOG("frame %d took %.3f ms (%s)", i, i * 0.5, "present");
+            }));
+            Logger::Shutdown();
+        }
+    }
+    std::printf("dropped %llu\n", static_cast<unsigned long long>(Logger::DroppedCount()));
+
+    std::string cleanup = "rm -rf " + base;
+    CHECK(std::system(cleanup.c_str()) == 0);
+    return 0;
+}
@@ -0,0 +1,250 @@
+// Logger: what reaches the file in text mode (formatting, every entry of
+// every thread in per-thread order), size-based rotation, and binary logs
+// decoded by log_decoder giving the same lines as printf (ints, 64-bit,
+// doubles, narrow and wide strings, no arguments) and as text mode, across
+// Initialize/Shutdown cycles.
+
+#include "logger.h"
+#include "test_util.h"
+
+// The decoder's Decoder class is used directly
+#define main LogDecoderMain
+#include "log_decoder/main.cpp"
+#undef main
+
+#include <cmath>
+#include <cstdarg>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+
+namespace {
+    constexpr int kThreads = 4;
+    constexpr int kPerThread = 500;
+
+    std::string ReadAll(const std::string& path) {
+        std::ifstream in(path, std::ios::binary);
+        std::stringstream ss;
+        ss << in.rdbuf();
+        return ss.str();
+    }
+
+    // Paced well below what the writer drains, so nothing is dropped
+    void LogPaced(int thread) {
+        for (int i = 0; i < kPerThread; i++) {
+            LOG("thread %d entry %d", thread, i);
+            if (i % 25 == 24) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+
+    void TestText(const std::string& dir) {
+        std::string path = dir + "/text.log";
+        Logger::InitializePath(path.c_str(), Logger::Mode::Text);
+        LOG("values %d %u %s %.2f %p", -5, 42u, "str", 3.14159, reinterpret_cast<void*>(0x1234));
+        char array[16] = "array";
+        std::string str = "stdstr";
+        const char* null = nullptr;
+        LOG_ERROR("strings %s %s %s %%", array, str, null);
+
+        std::vector<std::thread> threads;
+        for (int t = 0; t < kThreads; t++) threads.emplace_back(LogPaced, t);
+        for (std::thread& thread : threads) thread.join();
+        Logger::Shutdown();
+        CHECK(Logger::DroppedCount() == 0);
+
+        std::string text = ReadAll(path);
+        CHECK(text.find("[FPS] values -5 42 str 3.14 0x") != std::string::npos);
+        CHECK(text.find("[FPS ERROR] strings array stdstr (null) %") != std::string::npos);
+
+        int next[kThreads] = {};
+        std::istringstream lines(text);
+        std::string line;
+        while (std::getline(lines, line)) {
+            CHECK(line.size() > 26 && line[0] == '[');
+            int thread, entry;
+            size_t at = line.find("[FPS] thread ");
+            if (at == std::string::npos) continue;
+            CHECK(std::sscanf(line.c_str() + at, "[FPS] thread %d entry %d", &thread, &entry) == 2);
+            CHECK(thread >= 0 && thread < kThreads);
+            CHECK(entry == next[thread]);
+            next[thread]++;
+        }
+        for (int t = 0; t < kThreads; t++) CHECK(next[t] == kPerThread);
+    }
+
+    void TestRotation(const std::string& dir) {
+        std::string path = dir + "/rotate.log";
+        Logger::SetMaxFileSize(64 * 1024);
+        Logger::InitializePath(path.c_str(), Logger::Mode::Text);
+        for (int i = 0; i < 4000; i++) {
+            LOG("rotation line %d with some padding to make it longer", i);
+            if (i % 25 == 24) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        Logger::Shutdown();
+
+        std::string current = ReadAll(path);
+        std::string previous = ReadAll(path + ".1");
+        CHECK(!previous.empty());
+        // The batch that crosses the threshold still goes to the old file
+        CHECK(previous.size() <= 2 * 64 * 1024);
+        CHECK(current.find("rotation line 3999 ") != std::string::npos);
+        CHECK(current.find("rotation line 0 ") == std::string::npos);
+        Logger::SetMaxFileSize(4 * 1024 * 1024);
+    }
+
+    std::vector<std::string> Decode(const std::string& data) {
+        Decoder decoder(reinterpret_cast<const unsigned char*>(data.data()), data.size());
+        uint32_t pid = 0;
+        std::string error;
+        CHECK(decoder.Run(&pid, &error) && error.empty());
+        CHECK(pid == static_cast<uint32_t>(getpid()) && decoder.ClockSamples() >= 1);
+        std::vector<std::string> lines;
+        for (const Line& line : decoder.Lines()) lines.push_back(line.text);
+        return lines;
+    }
+
+    // Text mode lines without the "[YYYY-mm-dd HH:MM:SS.mmm] " prefix
+    std::vector<std::string> TextLines(const std::string& text) {
+        std::vector<std::string> lines;
+        std::istringstream in(text);
+        std::string line;
+        while (std::getline(in, line)) {
+            CHECK(line.size() >= 26 && line[0] == '[' && line[24] == ']' && line[25] == ' ');
+            lines.push_back(line.substr(26));
+        }
+        return lines;
+    }
+
+    __attribute__((format(printf, 2, 3))) void Expect(std::vector<std::string>& expected, const char* format, ...) {
+        char buf[1024];
+        va_list args;
+        va_start(args, format);
+        std::vsnprintf(buf, sizeof(buf), format, args);
+        va_end(args);
+        expected.push_back(buf);
+    }
+
+    // Logs the call and records what printf makes of the same format and arguments
+#define CASE(fmt, ...)                                          \
+    do {                                                        \
+        LOG(fmt, ##__VA_ARGS__);                                \
+        Expect(expected, "[FPS] " fmt, ##__VA_ARGS__);          \
+    } while (0)
+
+    std::vector<std::string> LogCases() {
+        std::vector<std::string> expected;
+        CASE("no arguments");
+        CASE("percent 100%%");
+        CASE("ints %d %i %u %x %X %o", -7, 2147483647, 4000000000u, 255u, 0xABCu, 8u);
+        CASE("widths %5d|%-5d|%05d|%+d", 42, 42, -42, 7);
+        CASE("small %d %d %u %c", static_cast<short>(-3), static_cast<signed char>(-128),
+             static_cast<unsigned>(static_cast<unsigned char>(200)), 'x');
+        CASE("hresult 0x%08X", static_cast<unsigned>(0x80004005u));
+        LOG("hresult as int 0x%08X", static_cast<int32_t>(0x80004005u));
+        expected.push_back("[FPS] hresult as int 0x80004005");
+        CASE("64-bit %lld %lld %llu %llx", static_cast<long long>(INT64_MIN), static_cast<long long>(INT64_MAX),
+             static_cast<unsigned long long>(UINT64_MAX), 0x123456789ABCDEF0ull);
+        CASE("doubles %f %.3f %e %g %10.2f|%-8.1f|%+.2f", 3.14159, -2.5, 1e300, 0.0001, 12.345, 1.5, 2.0);
+        CASE("float %.2f, special %f %f", 1.25f, static_cast<double>(NAN), -static_cast<double>(INFINITY));
+        CASE("strings %s|%10s|%-6s|%.3s|%s|", "abc", "right", "left", "truncate", "");
+        CASE("pointer %p", reinterpret_cast<void*>(0x1234));
+        CASE("mixed %s=%d (%.1f%%) %s", "fps", 60, 99.5, "ok");
+
+        const char* null = nullptr;
+        LOG("null %s", null);
+        expected.push_back("[FPS] null (null)");
+        std::string str = "std string";
+        LOG("std %s", str);
+        expected.push_back("[FPS] std std string");
+        const std::string longString(600, 'L');
+        LOG("long %s", longString.c_str());
+        expected.push_back("[FPS] long " + longString.substr(0, Logger::kMaxStringArg));
+        LOG("missing %d %d", 1);
+        expected.push_back("[FPS] missing 1 <?>");
+
+        // Wide strings come out as UTF-8
+        const wchar_t* wideNull = nullptr;
+        LOG("wide %ls|%ls|%ls|%ls", L"plain", L"caf\u00e9 \u65e5\u672c \U0001F3AE", std::wstring(L"std"), wideNull);
+        expected.push_back("[FPS] wide plain|caf\u00e9 \u65e5\u672c \U0001F3AE|std|(null)");
+        wchar_t broken[] = { L'a', static_cast<wchar_t>(0xD800), L'b', 0 };
+        LOG("surrogate %ls", broken);
+        expected.push_back("[FPS] surrogate a\uFFFDb");
+
+        // 3-byte characters: cut at 510 bytes, never inside a character
+        const std::wstring longWide(300, L'\u65e5');
+        LOG("long wide %ls", longWide);
+        std::string cut;
+        for (int i = 0; i < 170; i++) cut += "\u65e5";
+        expected.push_back("[FPS] long wide " + cut);
+        return expected;
+    }
+
+#undef CASE
+
+    // The same call sites in both modes: the decoded binary log, the text
+    // log and printf agree line for line
+    void TestRoundTrip(const std::string& dir) {
+        std::string binaryPath = dir + "/cases.blog";
+        Logger::InitializePath(binaryPath.c_str(), Logger::Mode::Binary);
+        const std::vector<std::string> expected = LogCases();
+        Logger::Shutdown();
+
+        std::string textPath = dir + "/cases.log";
+        Logger::InitializePath(textPath.c_str(), Logger::Mode::Text);
+        CHECK(LogCases() == expected);
+        Logger::Shutdown();
+
+        const std::vector<std::string> decoded = Decode(ReadAll(binaryPath));
+        const std::vector<std::string> text = TextLines(ReadAll(textPath));
+        CHECK(decoded.size() == expected.size() && text.size() == expected.size());
+        for (size_t i = 0; i < expected.size(); i++) {
+            if (decoded[i] != expected[i] || text[i] != expected[i]) {
+                std::fprintf(stderr, "expected: %s\ndecoded:  %s\ntext:     %s\n",
+                             expected[i].c_str(), decoded[i].c_str(), text[i].c_str());
+                CHECK(false);
+            }
+        }
+    }
+
+    void TestBinary(const std::string& dir) {
+        std::string path = dir + "/binary.blog";
+        Logger::InitializePath(path.c_str(), Logger::Mode::Binary);
+        for (int t = 0; t < kThreads; t++) LogPaced(t);
+        Logger::Shutdown();
+
+        std::string data = ReadAll(path);
+        LogFormat::FileHeader header;
+        CHECK(data.size() > sizeof(header));
+        std::memcpy(&header, data.data(), sizeof(header));
+        CHECK(header.magic == LogFormat::kMagic && header.version == LogFormat::kVersion);
+        CHECK(header.pid == static_cast<uint32_t>(getpid()));
+        // Deferred formatting: far smaller than the text of the same entries
+        CHECK(data.size() < static_cast<size_t>(kThreads * kPerThread) * 16);
+
+        // Every entry decodes, in order
+        const std::vector<std::string> lines = Decode(data);
+        CHECK(lines.size() == static_cast<size_t>(kThreads * kPerThread));
+        for (size_t i = 0; i < lines.size(); i++) {
+            char line[64];
+            std::snprintf(line, sizeof(line), "[FPS] thread %d entry %d", static_cast<int>(i / kPerThread),
+                          static_cast<int>(i % kPerThread));
+            CHECK(lines[i] == line);
+        }
+    }
+}
+
+int main() {
+    char dir[] = "/tmp/logger_test.XXXXXX";
+    CHECK(mkdtemp(dir) != nullptr);
+    TestText(dir);
+    TestRotation(dir);
+    TestRoundTrip(dir);
+    TestBinary(dir);
+    std::string cleanup = std::string("rm -rf ") + dir;
+    CHECK(std::system(cleanup.c_str()) == 0);
+    std::printf("logger: ok\n");
+    return 0;
+}
@@ -0,0 +1,184 @@
+// MinHook registry and batch APIs.
+//
+// 1. Finding a hook by target: hook_index.c against the linear scan of the
+//    entry array it replaced, through create / find / remove.
+// 2. Hooking n functions one call at a time (MH_CreateHook + MH_EnableHook)
+//    against MH_CreateHooks(enable) and MH_DisableHooks. Idle threads make
+//    each freeze enumerate a game-sized thread list; see win32_shim.c for
+//    what a freeze costs here.
+//
+// usage: minhook_bench [--quick]
+
+#include <MinHook.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "hook_index.h"
+#include "minhook_targets.h"
+
+#define IDLE_THREADS 32
+
+typedef struct {
+    void* pTarget;
+    char rest[48];      // About sizeof(HOOK_ENTRY)
+} Entry;
+
+static Entry* s_entries;
+static uint32_t s_size;
+static HOOK_INDEX s_index;
+static int s_indexed;
+
+static uint32_t Find(void* target) {
+    if (s_indexed) return HookIndexFind(&s_index, target);
+    for (uint32_t i = 0; i < s_size; i++) {
+        if (s_entries[i].pTarget == target) return i;
+    }
+    return HOOK_INDEX_NONE;
+}
+
+static void Add(void* target) {
+    if (s_indexed) {
+        uint32_t capacity = HookIndexCapacityFor(s_size + 1);
+        if (capacity > s_index.capacity) {
+            free(HookIndexRehash(&s_index, (HOOK_INDEX_SLOT*)calloc(capacity, sizeof(HOOK_INDEX_SLOT)), capacity));
+        }
+        HookIndexInsert(&s_index, target, s_size);
+    }
+    s_entries[s_size++].pTarget = target;
+}
+
+// Same swap-with-last removal as hook.c
+static void Remove(uint32_t pos) {
+    if (s_indexed) HookIndexErase(&s_index, s_entries[pos].pTarget);
+    if (pos < s_size - 1) {
+        s_entries[pos] = s_entries[s_size - 1];
+        if (s_indexed) HookIndexUpdate(&s_index, s_entries[pos].pTarget, pos);
+    }
+    s_size--;
+}
+
+static void BenchRegistry(int quick) {
+    static const uint32_t sizes[] = { 16, 64, 256, 1024, 4096 };
+    printf("%6s %8s %12s %12s %12s\n", "hooks", "lookup", "create ns", "find ns", "remove ns");
+    for (int si = 0; si < 5; si++) {
+        for (s_indexed = 0; s_indexed < 2; s_indexed++) {
+            uint32_t n = sizes[si];
+            int reps = quick ? 1 : (int)(2000000 / n);
+            if (reps < 1) reps = 1;
+            void** targets = (void**)malloc(n * sizeof(void*));
+            // Function-like addresses: 16-byte aligned, spread over a few modules
+            for (uint32_t i = 0; i < n; i++) {
+                targets[i] = (void*)(uintptr_t)(0x7FF800000000ull + (i % 7) * 0x1000000 + (uint64_t)i * 0x1D0);
+            }
+            s_entries = (Entry*)malloc(n * sizeof(Entry));
+
+            double create = 0, find = 0, remove = 0;
+            volatile uint32_t sink = 0;
+            for (int r = 0; r < reps; r++) {
+                double t0 = NowNs();
+                for (uint32_t i = 0; i < n; i++) {
+                    if (Find(targets[i]) == HOOK_INDEX_NONE) Add(targets[i]);
+                }
+                double t1 = NowNs();
+                for (uint32_t i = 0; i < n; i++) sink += Find(targets[(i * 7919u) % n]);
+                double t2 = NowNs();
+                for (uint32_t i = 0; i < n; i++) {
+                    uint32_t pos = Find(targets[i]);
+                    CHECK(pos != HOOK_INDEX_NONE);
+                    Remove(pos);
+                }
+                double t3 = NowNs();
+                create += t1 - t0;
+                find += t2 - t1;
+                remove += t3 - t2;
+            }
+            CHECK(s_size == 0);
+            double ops = (double)reps * n;
+            printf("%6u %8s %12.1f %12.1f %12.1f\n", n, s_indexed ? "index" : "linear",
+                   create / ops, find / ops, remove / ops);
+            free(s_index.pSlots);
+            memset(&s_index, 0, sizeof(s_index));
+            free(s_entries);
+            free(targets);
+        }
+    }
+}
+
+static int Detour(int x) {
+    return -x;
+}
+
+static void* IdleThread(void* param) {
+    char c;
+    while (read(*(int*)param, &c, 1) < 0) {
+    }
+    return NULL;
+}
+
+static void BenchBatch(int quick) {
+    static int pipeFds[2];
+    pthread_t threads[IDLE_THREADS];
+    CHECK(pipe(pipeFds) == 0);
+    for (int i = 0; i < IDLE_THREADS; i++) CHECK(pthread_create(&threads[i], NULL, IdleThread, &pipeFds[0]) == 0);
+
+    static const uint32_t sizes[] = { 4, 16, 64, 256 };
+    const int sizeCount = quick ? 2 : 4;
+    printf("\n%6s %10s %18s %14s\n", "hooks", "api", "create+enable ns", "disable ns");
+    CHECK(MH_Initialize() == MH_OK);
+    for (int si = 0; si < sizeCount; si++) {
+        uint32_t n = sizes[si];
+        int reps = quick ? 1 : (int)(4096 / n);
+        uint8_t* code = MakeTargets(n);
+        MH_HOOK_DESC* hooks = (MH_HOOK_DESC*)calloc(n, sizeof(MH_HOOK_DESC));
+        LPVOID* targets = (LPVOID*)calloc(n, sizeof(LPVOID));
+        for (uint32_t i = 0; i < n; i++) {
+            targets[i] = (LPVOID)Target(code, i);
+            hooks[i].pTarget = targets[i];
+            hooks[i].pDetour = (LPVOID)Detour;
+        }
+
+        for (int batch = 0; batch < 2; batch++) {
+            double create = 0, disable = 0;
+            for (int r = 0; r < reps; r++) {
+                double t0 = NowNs();
+                if (batch) {
+                    CHECK(MH_CreateHooks(hooks, n, TRUE) == MH_OK);
+                } else {
+                    for (uint32_t i = 0; i < n; i++) {
+                        CHECK(MH_CreateHook(targets[i], (LPVOID)Detour, NULL) == MH_OK);
+                        CHECK(MH_EnableHook(targets[i]) == MH_OK);
+                    }
+                }
+                double t1 = NowNs();
+                CHECK(Target(code, n - 1)(1) == -1);
+                if (batch) {
+                    CHECK(MH_DisableHooks(targets, n) == MH_OK);
+                } else {
+                    for (uint32_t i = 0; i < n; i++) CHECK(MH_DisableHook(targets[i]) == MH_OK);
+                }
+                double t2 = NowNs();
+                CHECK(Target(code, n - 1)(1) == TargetResult(n - 1, 1));
+                for (uint32_t i = 0; i < n; i++) CHECK(MH_RemoveHook(targets[i]) == MH_OK);
+                create += t1 - t0;
+                disable += t2 - t1;
+            }
+            double ops = (double)reps * n;
+            printf("%6u %10s %18.0f %14.0f\n", n, batch ? "batch" : "per hook", create / ops, disable / ops);
+        }
+        free(targets);
+        free(hooks);
+        FreeTargets(code, n);
+    }
+    CHECK(MH_Uninitialize() == MH_OK);
+
+    close(pipeFds[1]);
+    for (int i = 0; i < IDLE_THREADS; i++) pthread_join(threads[i], NULL);
+    close(pipeFds[0]);
+}
+
+int main(int argc, char** argv) {
+    const int quick = HasArg(argc, argv, "--quick");
+    BenchRegistry(quick);
+    BenchBatch(quick);
+    return 0;
+}
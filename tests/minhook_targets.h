@@ -0,0 +1,43 @@
+#pragma once
+
+// Hook targets built at run time for the MinHook tests and benchmark, as
+// many as needed: target i is "mov eax, edi; add eax, i * 7 + 1; ret",
+// 32 bytes apart like compiled functions.
+
+#include <sys/mman.h>
+
+#include "test_util.h"
+
+typedef int (*TargetFunction)(int);
+
+#define TARGET_STRIDE 32
+
+static int TargetResult(size_t i, int x) {
+    return x + (int)(i * 7 + 1);
+}
+
+static uint8_t* MakeTargets(size_t count) {
+    size_t size = (count * TARGET_STRIDE + 4095) & ~(size_t)4095;
+    uint8_t* code = (uint8_t*)mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    CHECK(code != MAP_FAILED);
+    memset(code, 0xCC, size);
+    for (size_t i = 0; i < count; i++) {
+        uint8_t* p = code + i * TARGET_STRIDE;
+        int32_t imm = (int32_t)(i * 7 + 1);
+        p[0] = 0x89;    // mov eax, edi
+        p[1] = 0xF8;
+        p[2] = 0x05;    // add eax, imm32
+        memcpy(p + 3, &imm, sizeof(imm));
+        p[7] = 0xC3;    // ret
+    }
+    CHECK(mprotect(code, size, PROT_READ | PROT_EXEC) == 0);
+    return code;
+}
+
+static void FreeTargets(uint8_t* code, size_t count) {
+    munmap(code, (count * TARGET_STRIDE + 4095) & ~(size_t)4095);
+}
+
+static TargetFunction Target(uint8_t* code, size_t i) {
+    return (TargetFunction)(void*)(code + i * TARGET_STRIDE);
+}
@@ -0,0 +1,200 @@
+// MinHook on Linux through tests/win32: the batch create/enable/disable
+// APIs and single-hook calls on top of them, which all go through the
+// target index (hook_index.c), on generated targets and a compiled one.
+// Then threads hooking their own targets at once, which contend for the
+// adaptive spin lock and park on its event.
+
+#include <MinHook.h>
+#include <pthread.h>
+
+#include "minhook_targets.h"
+
+#define COUNT 200
+#define THREADS 4
+#define THREAD_TARGETS 16
+#define THREAD_ROUNDS 500
+
+static volatile int s_bias = 5;
+
+// Reads a global, so its trampoline has a RIP-relative operand to relocate
+__attribute__((noinline)) static int CompiledTarget(int x) {
+    return x * 3 + s_bias;
+}
+
+static int Detour(int x) {
+    return -x - 1000;
+}
+
+static int (*s_compiledOriginal)(int);
+
+static int CompiledDetour(int x) {
+    return s_compiledOriginal(x) + 1;
+}
+
+// Calls through a volatile pointer, so the compiler cannot inline or fold them
+static int Call(TargetFunction fn, int x) {
+    TargetFunction volatile target = fn;
+    return target(x);
+}
+
+static void TestCompiledFunction(void) {
+    CHECK(Call(CompiledTarget, 2) == 11);
+    CHECK(MH_CreateHook((LPVOID)CompiledTarget, (LPVOID)CompiledDetour, (LPVOID*)&s_compiledOriginal) == MH_OK);
+    CHECK(MH_CreateHook((LPVOID)CompiledTarget, (LPVOID)CompiledDetour, NULL) == MH_ERROR_ALREADY_CREATED);
+    CHECK(Call(CompiledTarget, 2) == 11);
+    CHECK(MH_EnableHook((LPVOID)CompiledTarget) == MH_OK);
+    CHECK(MH_EnableHook((LPVOID)CompiledTarget) == MH_ERROR_ENABLED);
+    CHECK(Call(CompiledTarget, 2) == 12);
+    CHECK(s_compiledOriginal(2) == 11);
+    CHECK(MH_RemoveHook((LPVOID)CompiledTarget) == MH_OK);
+    CHECK(Call(CompiledTarget, 2) == 11);
+    CHECK(MH_RemoveHook((LPVOID)CompiledTarget) == MH_ERROR_NOT_CREATED);
+}
+
+static void ExpectHooked(uint8_t* code, const int* hooked, TargetFunction* originals) {
+    for (size_t i = 0; i < COUNT; i++) {
+        int x = (int)i;
+        CHECK(Call(Target(code, i), x) == (hooked[i] ? Detour(x) : TargetResult(i, x)));
+        if (originals[i]) CHECK(originals[i](x) == TargetResult(i, x));
+    }
+}
+
+static void TestBatch(void) {
+    static MH_HOOK_DESC hooks[COUNT + 2];
+    static TargetFunction originals[COUNT];
+    static LPVOID targets[COUNT + 1];
+    static int hooked[COUNT];
+    static const uint8_t data[16];
+    uint8_t* code = MakeTargets(COUNT + 1);
+
+    // All of them, a duplicate and a target that is not code: the failures
+    // are reported per hook and do not stop the others
+    for (size_t i = 0; i < COUNT; i++) {
+        hooks[i].pTarget = targets[i] = (LPVOID)Target(code, i);
+        hooks[i].pDetour = (LPVOID)Detour;
+        hooks[i].ppOriginal = (LPVOID*)&originals[i];
+    }
+    hooks[COUNT] = hooks[7];
+    hooks[COUNT].ppOriginal = NULL;
+    hooks[COUNT + 1].pTarget = (LPVOID)data;
+    hooks[COUNT + 1].pDetour = (LPVOID)Detour;
+    CHECK(MH_CreateHooks(hooks, COUNT + 2, FALSE) == MH_ERROR_ALREADY_CREATED);
+    for (size_t i = 0; i < COUNT; i++) CHECK(hooks[i].status == MH_OK && originals[i] != NULL);
+    CHECK(hooks[COUNT].status == MH_ERROR_ALREADY_CREATED);
+    CHECK(hooks[COUNT + 1].status == MH_ERROR_NOT_EXECUTABLE);
+    ExpectHooked(code, hooked, originals);
+
+    CHECK(MH_EnableHooks(targets, COUNT) == MH_OK);
+    for (size_t i = 0; i < COUNT; i++) hooked[i] = 1;
+    ExpectHooked(code, hooked, originals);
+
+    // Disable the odd ones; a list with an unknown target changes nothing
+    static LPVOID odd[COUNT / 2 + 1];
+    for (size_t i = 0; i < COUNT / 2; i++) odd[i] = targets[2 * i + 1];
+    CHECK(MH_DisableHooks(odd, COUNT / 2) == MH_OK);
+    for (size_t i = 1; i < COUNT; i += 2) hooked[i] = 0;
+    ExpectHooked(code, hooked, originals);
+    odd[COUNT / 2] = (LPVOID)Target(code, COUNT);
+    CHECK(MH_EnableHooks(odd, COUNT / 2 + 1) == MH_ERROR_NOT_CREATED);
+    CHECK(MH_DisableHooks(targets, COUNT) == MH_OK);     // Already disabled ones are skipped
+    for (size_t i = 0; i < COUNT; i++) hooked[i] = 0;
+    ExpectHooked(code, hooked, originals);
+    CHECK(MH_EnableHooks(odd, COUNT / 2) == MH_OK);
+    for (size_t i = 1; i < COUNT; i += 2) hooked[i] = 1;
+    ExpectHooked(code, hooked, originals);
+
+    // Removing every third hook moves others around in the entry array;
+    // the single-hook calls must still find the rest
+    for (size_t i = 0; i < COUNT; i += 3) {
+        CHECK(MH_RemoveHook(targets[i]) == MH_OK);
+        CHECK(MH_RemoveHook(targets[i]) == MH_ERROR_NOT_CREATED);
+        CHECK(MH_EnableHook(targets[i]) == MH_ERROR_NOT_CREATED);
+        hooked[i] = 0;
+        originals[i] = NULL;
+    }
+    ExpectHooked(code, hooked, originals);
+    for (size_t i = 0; i < COUNT; i++) {
+        if (i % 3 == 0) continue;
+        CHECK(MH_EnableHook(targets[i]) == (hooked[i] ? MH_ERROR_ENABLED : MH_OK));
+        hooked[i] = 1;
+    }
+    ExpectHooked(code, hooked, originals);
+    CHECK(MH_DisableHook(MH_ALL_HOOKS) == MH_OK);
+    for (size_t i = 0; i < COUNT; i++) hooked[i] = 0;
+    ExpectHooked(code, hooked, originals);
+
+    // Create the removed ones again, enabled in the same call
+    size_t count = 0;
+    for (size_t i = 0; i < COUNT; i += 3) {
+        hooks[count].pTarget = targets[i];
+        hooks[count].pDetour = (LPVOID)Detour;
+        hooks[count].ppOriginal = (LPVOID*)&originals[i];
+        hooked[i] = 1;
+        count++;
+    }
+    CHECK(MH_CreateHooks(hooks, (UINT)count, TRUE) == MH_OK);
+    ExpectHooked(code, hooked, originals);
+    CHECK(MH_EnableHook(MH_ALL_HOOKS) == MH_OK);
+    for (size_t i = 0; i < COUNT; i++) hooked[i] = 1;
+    ExpectHooked(code, hooked, originals);
+
+    // Uninitialize removes everything
+    CHECK(MH_Uninitialize() == MH_OK);
+    for (size_t i = 0; i < COUNT; i++) {
+        hooked[i] = 0;
+        originals[i] = NULL;
+    }
+    ExpectHooked(code, hooked, originals);
+    FreeTargets(code, COUNT + 1);
+}
+
+static uint8_t* s_threadCode;
+
+// Every call takes the lock; each thread only patches and calls its own
+// targets, since the shim cannot suspend the others
+static void* HookLoop(void* arg) {
+    size_t first = (size_t)arg * THREAD_TARGETS;
+    TargetFunction original = NULL;
+    for (int round = 0; round < THREAD_ROUNDS; round++) {
+        for (size_t i = first; i < first + THREAD_TARGETS; i++) {
+            LPVOID target = (LPVOID)Target(s_threadCode, i);
+            int x = round;
+            CHECK(MH_CreateHook(target, (LPVOID)Detour, (LPVOID*)&original) == MH_OK);
+            CHECK(MH_EnableHook(target) == MH_OK);
+            CHECK(Call(Target(s_threadCode, i), x) == Detour(x));
+            CHECK(original(x) == TargetResult(i, x));
+            CHECK(MH_DisableHook(target) == MH_OK);
+            CHECK(Call(Target(s_threadCode, i), x) == TargetResult(i, x));
+            CHECK(MH_RemoveHook(target) == MH_OK);
+        }
+    }
+    return NULL;
+}
+
+static void TestContention(void) {
+    pthread_t threads[THREADS];
+    CHECK(MH_Initialize() == MH_OK);
+    s_threadCode = MakeTargets(THREADS * THREAD_TARGETS);
+    for (size_t t = 0; t < THREADS; t++) CHECK(pthread_create(&threads[t], NULL, HookLoop, (void*)t) == 0);
+    for (size_t t = 0; t < THREADS; t++) CHECK(pthread_join(threads[t], NULL) == 0);
+
+    // Nothing left behind: every target is unhooked and can be hooked again
+    for (size_t i = 0; i < THREADS * THREAD_TARGETS; i++) {
+        LPVOID target = (LPVOID)Target(s_threadCode, i);
+        CHECK(Call(Target(s_threadCode, i), 3) == TargetResult(i, 3));
+        CHECK(MH_RemoveHook(target) == MH_ERROR_NOT_CREATED);
+        CHECK(MH_CreateHook(target, (LPVOID)Detour, NULL) == MH_OK);
+    }
+    CHECK(MH_Uninitialize() == MH_OK);
+    FreeTargets(s_threadCode, THREADS * THREAD_TARGETS);
+}
+
+int main(void) {
+    CHECK(MH_CreateHooks(NULL, 0, FALSE) == MH_ERROR_NOT_INITIALIZED);
+    CHECK(MH_Initialize() == MH_OK);
+    TestCompiledFunction();
+    TestBatch();
+    TestContention();
+    printf("minhook: ok\n");
+    return 0;
+}
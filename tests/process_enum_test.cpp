@@ -0,0 +1,98 @@
+// ProcessSnapshot on /proc: child processes started from copies of sleep
+// under game-like names (spaces, a replaced binary) must show up with their
+// exe file name, sorted by pid, and be found by IndexOf / Contains / NameOf.
+
+#include "process_enum.h"
+#include "test_util.h"
+
+#include <algorithm>
+#include <signal.h>
+#include <string>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+    std::string s_dir;
+
+    std::string CopySleep(const char* name) {
+        std::string path = s_dir + "/" + name;
+        std::string command = "cp \"$(command -v sleep)\" '" + path + "'";
+        CHECK(std::system(command.c_str()) == 0);
+        return path;
+    }
+
+    pid_t Spawn(const std::string& path) {
+        pid_t pid = fork();
+        CHECK(pid >= 0);
+        if (pid == 0) {
+            execl(path.c_str(), path.c_str(), "30", static_cast<char*>(nullptr));
+            _exit(127);
+        }
+        return pid;
+    }
+
+    // exec has happened once /proc shows the new image
+    void WaitForExec(pid_t pid, const char* name) {
+        std::string current;
+        for (int i = 0; i < 500; i++) {
+            if (ProcessSnapshot::NameOf(static_cast<uint32_t>(pid), current) && current == name) return;
+            usleep(2000);
+        }
+        CHECK(!"child did not exec");
+    }
+}
+
+int main() {
+    char dir[] = "/tmp/process_enum_test.XXXXXX";
+    CHECK(mkdtemp(dir) != nullptr);
+    s_dir = dir;
+
+    const std::string game = CopySleep("Brawl Game.exe");
+    const std::string replaced = CopySleep("Old Game.exe");
+    std::vector<pid_t> children = { Spawn(game), Spawn(game), Spawn(replaced) };
+    WaitForExec(children[0], "Brawl Game.exe");
+    WaitForExec(children[1], "Brawl Game.exe");
+    WaitForExec(children[2], "Old Game.exe");
+    // The exe link now ends in " (deleted)"
+    CHECK(unlink(replaced.c_str()) == 0);
+
+    ProcessSnapshot snapshot;
+    for (int take = 0; take < 2; take++) {       // Buffers are reused
+        CHECK(snapshot.Take());
+        CHECK(snapshot.Count() >= children.size() + 1);
+        for (size_t i = 1; i < snapshot.Count(); i++) CHECK(snapshot.Pid(i - 1) < snapshot.Pid(i));
+
+        size_t self = snapshot.IndexOf(static_cast<uint32_t>(getpid()));
+        CHECK(self != ProcessSnapshot::npos && snapshot.Name(self) == "process_enum_test");
+        for (size_t c = 0; c < children.size(); c++) {
+            uint32_t pid = static_cast<uint32_t>(children[c]);
+            const char* name = c < 2 ? "Brawl Game.exe" : "Old Game.exe";
+            size_t i = snapshot.IndexOf(pid);
+            CHECK(i != ProcessSnapshot::npos && snapshot.Pid(i) == pid && snapshot.Name(i) == name);
+            CHECK(snapshot.Contains(pid, name));
+            CHECK(!snapshot.Contains(pid, "brawl game.exe"));     // Exact; folding is GameMatcher's job
+        }
+    }
+
+    std::string name;
+    CHECK(ProcessSnapshot::NameOf(static_cast<uint32_t>(children[2]), name) && name == "Old Game.exe");
+
+    // Exited (and reaped) processes disappear
+    for (pid_t child : children) {
+        kill(child, SIGKILL);
+        CHECK(waitpid(child, nullptr, 0) == child);
+    }
+    CHECK(snapshot.Take());
+    for (pid_t child : children) {
+        CHECK(snapshot.IndexOf(static_cast<uint32_t>(child)) == ProcessSnapshot::npos);
+        CHECK(!ProcessSnapshot::NameOf(static_cast<uint32_t>(child), name));
+    }
+    CHECK(snapshot.IndexOf(0) == ProcessSnapshot::npos);
+    CHECK(snapshot.IndexOf(0xFFFFFFFFu) == ProcessSnapshot::npos);
+
+    std::string cleanup = "rm -rf " + s_dir;
+    CHECK(std::system(cleanup.c_str()) == 0);
+    std::printf("process_enum: ok, %zu processes\n", snapshot.Count());
+    return 0;
+}
@@ -0,0 +1,143 @@
+// ProcessEvents on Linux: Wait timeout and Wake, exec events from the proc
+// connector (only when the process may open it: CAP_NET_ADMIN), exactly one
+// Exited event per watched child through pidfd/epoll, Watch on a process
+// that is already gone, Unwatch, and Stop with watches still active.
+
+#include "process_events.h"
+#include "test_util.h"
+
+#include <chrono>
+#include <map>
+#include <signal.h>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+using Kind = ProcessEvents::Kind;
+using Clock = std::chrono::steady_clock;
+
+namespace {
+    constexpr int kChildren = 50;
+
+    pid_t SpawnSleep() {
+        pid_t pid = fork();
+        CHECK(pid >= 0);
+        if (pid == 0) {
+            execlp("sleep", "sleep", "30", static_cast<char*>(nullptr));
+            _exit(127);
+        }
+        return pid;
+    }
+
+    void KillAndReap(pid_t pid) {
+        kill(pid, SIGKILL);
+        CHECK(waitpid(pid, nullptr, 0) == pid);
+    }
+
+    double MsSince(Clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    }
+
+    void TestWait(ProcessEvents& events) {
+        std::vector<ProcessEvents::Event> out = { { Kind::Started, 1 } };
+        Clock::time_point start = Clock::now();
+        // Drain whatever the system started meanwhile, then time an empty wait
+        while (events.Wait(0, out)) {
+        }
+        CHECK(out.empty());
+
+        std::thread waker([&] {
+            std::this_thread::sleep_for(std::chrono::milliseconds(30));
+            events.Wake();
+        });
+        start = Clock::now();
+        bool got = events.Wait(5000, out);
+        waker.join();
+        CHECK(MsSince(start) < 2000);
+        CHECK(got == !out.empty());
+    }
+
+    void TestStartEvents(ProcessEvents& events) {
+        if (!events.HasStartEvents()) {
+            std::printf("process_events: no proc connector access, start events not tested\n");
+            return;
+        }
+        pid_t child = SpawnSleep();
+        bool started = false;
+        std::vector<ProcessEvents::Event> out;
+        Clock::time_point start = Clock::now();
+        while (!started && MsSince(start) < 5000) {
+            events.Wait(500, out);
+            for (const ProcessEvents::Event& event : out) {
+                started |= event.kind == Kind::Started && (event.pid == static_cast<uint32_t>(child) || event.pid == 0);
+            }
+        }
+        CHECK(started);
+        KillAndReap(child);
+    }
+
+    void TestExitEvents(ProcessEvents& events) {
+        std::vector<pid_t> children;
+        for (int i = 0; i < kChildren; i++) {
+            children.push_back(SpawnSleep());
+            CHECK(events.Watch(static_cast<uint32_t>(children.back())));
+        }
+        // Unwatched before it exits: no event
+        const pid_t unwatched = SpawnSleep();
+        CHECK(events.Watch(static_cast<uint32_t>(unwatched)));
+        events.Unwatch(static_cast<uint32_t>(unwatched));
+
+        for (pid_t child : children) kill(child, SIGKILL);
+        kill(unwatched, SIGKILL);
+
+        std::map<uint32_t, int> exits;
+        std::vector<ProcessEvents::Event> out;
+        Clock::time_point start = Clock::now();
+        while (exits.size() < children.size() && MsSince(start) < 5000) {
+            events.Wait(500, out);
+            for (const ProcessEvents::Event& event : out) {
+                if (event.kind == Kind::Exited) exits[event.pid]++;
+            }
+        }
+        // Anything late would show up now
+        events.Wait(100, out);
+        for (const ProcessEvents::Event& event : out) {
+            if (event.kind == Kind::Exited) exits[event.pid]++;
+        }
+
+        CHECK(exits.size() == children.size());
+        for (pid_t child : children) CHECK(exits[static_cast<uint32_t>(child)] == 1);
+        CHECK(exits.count(static_cast<uint32_t>(unwatched)) == 0);
+
+        for (pid_t child : children) CHECK(waitpid(child, nullptr, 0) == child);
+        CHECK(waitpid(unwatched, nullptr, 0) == unwatched);
+
+        // Already gone: the caller treats false as an exit
+        CHECK(!events.Watch(static_cast<uint32_t>(children[0])));
+    }
+}
+
+int main() {
+    {
+        ProcessEvents events;
+        CHECK(events.Start());
+        TestWait(events);
+        TestStartEvents(events);
+        TestExitEvents(events);
+
+        // Stop with a live watch, then the destructor stops again
+        pid_t child = SpawnSleep();
+        CHECK(events.Watch(static_cast<uint32_t>(child)));
+        events.Stop();
+        KillAndReap(child);
+    }
+
+    // Restartable
+    ProcessEvents events;
+    CHECK(events.Start());
+    events.Stop();
+    CHECK(events.Start());
+    std::printf("process_events: ok\n");
+    return 0;
+}
@@ -0,0 +1,177 @@
+// Deciding whether to hook a process: ProcessFilter::Match on the compiled
+// blob against the IsGraphicsProcess logic it replaced (a _stricmp per
+// system name, then a lowercased copy and a strstr per path keyword), and
+// against a linear scan of the user's list as it grows. Both baselines must
+// agree with Match on every path. Then the shared-memory Reader::Decide and
+// the cost of building a blob.
+//
+// usage: process_filter_bench [--quick]
+
+#include "process_filter.h"
+#include "fps_config.h"
+#include "test_util.h"
+
+#include <cctype>
+#include <cstring>
+#include <string>
+#include <strings.h>
+#include <sys/mman.h>
+#include <vector>
+
+using namespace ProcessFilter;
+
+namespace {
+    const char* const kSystemNames[] = {
+        "fps_monitor.exe", "conhost.exe", "explorer.exe", "dwm.exe", "csrss.exe", "svchost.exe",
+        "SearchHost.exe", "ShellExperienceHost.exe", "StartMenuExperienceHost.exe", "RuntimeBroker.exe",
+        "TextInputHost.exe", "taskhostw.exe", "ctfmon.exe", "cleanmgr.exe", "taskmgr.exe", "cmd.exe",
+        "powershell.exe", "WindowsTerminal.exe", "OneDrive.exe", "OneDriveStandaloneUpdater.exe",
+        "browser.exe", "BackgroundDownload.exe", "ApplicationFrameHost.exe", "SystemSettings.exe",
+        "SettingsHelper.exe", "sihost.exe", "fontdrvhost.exe", "WmiPrvSE.exe", "dllhost.exe",
+        "CompPkgSrv.exe", "SearchIndexer.exe", "SecurityHealthService.exe", "MsMpEng.exe", "NisSrv.exe",
+        "smartscreen.exe", "spoolsv.exe", "services.exe", "lsass.exe", "wininit.exe", "winlogon.exe",
+    };
+    const char* const kSystemPaths[] = {
+        "\\windows\\", "\\microsoft\\", "\\onedrive\\", "\\system32\\", "\\syswow64\\",
+        "program files", "visual studio", "\\appdata\\",
+    };
+
+    const char* const kDirs[] = {
+        "C:\\Games\\", "D:\\SteamLibrary\\steamapps\\common\\Elden Ring\\Game\\",
+        "C:\\Program Files (x86)\\Steam\\", "C:\\WINDOWS\\System32\\", "C:\\Users\\me\\AppData\\Local\\",
+        "E:\\Games\\Foo\\", "C:\\Windows\\SysWOW64\\", "C:\\Program Files\\Microsoft Visual Studio\\",
+    };
+    const char* const kExes[] = {
+        "eldenring.exe", "EXPLORER.EXE", "dwm.exe", "Game.exe", "League of Legends.exe", "cmd.exe",
+        "svchost.exe", "MsMpEng.exe", "sihost.exe", "x.exe", "LeagueClient.exe", "winlogon.exe",
+    };
+
+    // The removed IsGraphicsProcess, minus GetModuleFileNameA
+    bool OldPasses(const char* path) {
+        const char* fileName = std::strrchr(path, '\\');
+        fileName = fileName ? fileName + 1 : path;
+        for (const char* name : kSystemNames) {
+            if (strcasecmp(fileName, name) == 0) return false;
+        }
+        char lowerPath[260];
+        std::snprintf(lowerPath, sizeof(lowerPath), "%s", path);
+        for (char* p = lowerPath; *p; p++) *p = static_cast<char>(std::tolower(static_cast<unsigned char>(*p)));
+        for (const char* keyword : kSystemPaths) {
+            if (std::strstr(lowerPath, keyword)) return false;
+        }
+        return true;
+    }
+
+    // Whitelist by scanning the list: names against the file name, fragments
+    // against the lowercased path
+    bool ListedLinear(const std::vector<std::string>& names, const std::vector<std::string>& fragments,
+                      const char* path) {
+        const char* fileName = std::strrchr(path, '\\');
+        fileName = fileName ? fileName + 1 : path;
+        for (const std::string& name : names) {
+            if (strcasecmp(fileName, name.c_str()) == 0) return true;
+        }
+        char lowerPath[260];
+        std::snprintf(lowerPath, sizeof(lowerPath), "%s", path);
+        for (char* p = lowerPath; *p; p++) *p = static_cast<char>(std::tolower(static_cast<unsigned char>(*p)));
+        for (const std::string& fragment : fragments) {
+            if (std::strstr(lowerPath, fragment.c_str())) return true;
+        }
+        return false;
+    }
+
+    std::vector<std::string> Paths() {
+        std::vector<std::string> paths;
+        for (const char* dir : kDirs) {
+            for (const char* exe : kExes) paths.push_back(std::string(dir) + exe);
+        }
+        // Listed games, found in the larger lists below
+        for (int i = 0; i < 400; i += 37) paths.push_back("C:\\Games\\game" + std::to_string(i) + ".exe");
+        paths.push_back("D:\\Library\\Studio7\\Title.exe");
+        return paths;
+    }
+
+    template <typename Fn>
+    double TimePaths(const std::vector<std::string>& paths, int reps, Fn&& fn) {
+        volatile int sink = 0;
+        double t0 = NowNs();
+        for (int r = 0; r < reps; r++) {
+            for (const std::string& path : paths) sink += fn(path);
+        }
+        return (NowNs() - t0) / (static_cast<double>(reps) * paths.size());
+    }
+
+    void BenchBuiltIn(const std::vector<std::string>& paths, int reps) {
+        static unsigned char blob[kCapacity];
+        size_t size = 0;
+        CHECK(Build(FILTER_ALL, "", blob, sizeof(blob), &size));
+        for (const std::string& path : paths) {
+            CHECK((Match(blob, size, path.c_str(), path.size()) == Verdict::Hook) == OldPasses(path.c_str()));
+        }
+        std::printf("%-34s %10s\n", "built-in rules", "ns/path");
+        std::printf("%-34s %10.1f\n", "IsGraphicsProcess (old)",
+                    TimePaths(paths, reps, [](const std::string& p) { return OldPasses(p.c_str()); }));
+        std::printf("%-34s %10.1f\n", "Match",
+                    TimePaths(paths, reps, [&](const std::string& p) {
+                        return Match(blob, size, p.c_str(), p.size()) == Verdict::Hook;
+                    }));
+    }
+
+    void BenchLists(const std::vector<std::string>& paths, int reps) {
+        static unsigned char blob[kCapacity];
+        std::printf("\n%6s %27s %10s %10s\n", "names", "whitelist", "ns/path", "build us");
+        for (int count : { 10, 100, 400 }) {
+            std::vector<std::string> names, fragments = { "\\studio7\\", "\\emulators\\" };
+            std::string list;
+            for (int i = 0; i < count; i++) {
+                names.push_back("game" + std::to_string(i) + ".exe");
+                list += names.back() + ";";
+            }
+            for (const std::string& fragment : fragments) list += fragment + ";";
+
+            size_t size = 0;
+            double t0 = NowNs();
+            const int builds = reps / 100 + 1;
+            for (int b = 0; b < builds; b++) CHECK(Build(FILTER_WHITELIST, list.c_str(), blob, sizeof(blob), &size));
+            double buildUs = (NowNs() - t0) / builds / 1e3;
+
+            for (const std::string& path : paths) {
+                bool listed = ListedLinear(names, fragments, path.c_str());
+                CHECK((Match(blob, size, path.c_str(), path.size()) == Verdict::Hook) == listed);
+            }
+            std::printf("%6d %27s %10.1f\n", count, "linear scan",
+                        TimePaths(paths, reps, [&](const std::string& p) {
+                            return ListedLinear(names, fragments, p.c_str());
+                        }));
+            std::printf("%6d %27s %10.1f %10.1f\n", count, "Match",
+                        TimePaths(paths, reps, [&](const std::string& p) {
+                            return Match(blob, size, p.c_str(), p.size()) == Verdict::Hook;
+                        }), buildUs);
+        }
+    }
+
+    void BenchReader(const std::vector<std::string>& paths, int reps) {
+        shm_unlink("/" PROCESS_FILTER_SHARED_NAME);
+        Writer writer;
+        CHECK(writer.Create());
+        CHECK(writer.Publish(FILTER_BLACKLIST, "game7.exe;\\emulators\\"));
+        Reader reader;
+        CHECK(reader.Open());
+        std::printf("\n%-34s %10.1f\n", "Reader::Decide (shared blob)",
+                    TimePaths(paths, reps, [&](const std::string& p) {
+                        return reader.Decide(p.c_str(), p.size()) == Verdict::Hook;
+                    }));
+        reader.Close();
+        writer.Close();
+    }
+}
+
+int main(int argc, char** argv) {
+    const int reps = HasArg(argc, argv, "--quick") ? 100 : 100000;
+    const std::vector<std::string> paths = Paths();
+    std::printf("%zu paths\n\n", paths.size());
+    BenchBuiltIn(paths, reps);
+    BenchLists(paths, reps);
+    BenchReader(paths, reps);
+    return 0;
+}
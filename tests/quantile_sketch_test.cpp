@@ -0,0 +1,265 @@
+// QuantileSketch: every quantile of several frame-time like distributions
+// is within the relative accuracy of the exact rank, sketches of any split
+// of the data merge into exactly the sketch of the whole, mismatched
+// accuracies refuse to merge, folding under a small maxBins keeps the high
+// quantiles, and the capture chunk round trips.
+
+#include "quantile_sketch.h"
+#include "capture.h"
+#include "test_util.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <vector>
+
+namespace {
+    const double kQuantiles[] = { 0.0, 0.001, 0.01, 0.1, 0.25, 0.5, 0.75, 0.9, 0.95, 0.99, 0.999, 1.0 };
+
+    // The exact value at the rank Quantile uses
+    double Exact(const std::vector<double>& sorted, double q) {
+        return sorted[static_cast<size_t>(q * static_cast<double>(sorted.size() - 1))];
+    }
+
+    void CheckAccuracy(const std::vector<double>& values, double accuracy) {
+        QuantileSketch sketch(accuracy);
+        for (double v : values) sketch.Add(v);
+        std::vector<double> sorted = values;
+        std::sort(sorted.begin(), sorted.end());
+
+        CHECK(sketch.Count() == values.size());
+        CHECK(sketch.Min() == sorted.front() && sketch.Max() == sorted.back());
+        for (double q : kQuantiles) {
+            const double exact = Exact(sorted, q);
+            const double estimate = sketch.Quantile(q);
+            if (exact < QuantileSketch::kMinValue) {
+                CHECK(estimate < QuantileSketch::kMinValue);
+            } else {
+                CHECK(std::fabs(estimate - exact) <= accuracy * exact * (1.0 + 1e-9));
+            }
+        }
+        for (int k = 0; k <= 1000; k++) {
+            const double exact = Exact(sorted, k / 1000.0);
+            if (exact >= QuantileSketch::kMinValue) {
+                CHECK(std::fabs(sketch.Quantile(k / 1000.0) - exact) <= accuracy * exact * (1.0 + 1e-9));
+            }
+        }
+    }
+
+    std::vector<double> Distribution(int kind, size_t n, std::mt19937_64& rng) {
+        std::vector<double> values(n);
+        std::uniform_real_distribution<double> uniform(1.0, 100.0);
+        std::lognormal_distribution<double> lognormal(2.8, 0.4);
+        std::exponential_distribution<double> exponential(0.05);
+        std::uniform_real_distribution<double> unit(0.0, 1.0);
+        for (double& v : values) {
+            switch (kind) {
+            case 0: v = uniform(rng); break;
+            case 1: v = lognormal(rng); break;
+            case 2: v = exponential(rng); break;
+            case 3:     // 60 fps with vsync misses and rare hitches
+                v = unit(rng) < 0.9 ? 16.6 + unit(rng) * 0.2 : (unit(rng) < 0.9 ? 33.3 : 250.0 + unit(rng) * 500.0);
+                break;
+            default:    // Heavy tail across eight decades, some exact zeros
+                v = unit(rng) < 0.01 ? 0.0 : 1e-2 * std::pow(1.0 - unit(rng), -1.5);
+                if (v > 1e6) v = 1e6;
+                break;
+            }
+        }
+        return values;
+    }
+
+    void TestAccuracy() {
+        std::mt19937_64 rng(11);
+        const double accuracies[] = { 0.01, 0.005, 0.05 };
+        for (double accuracy : accuracies) {
+            for (int kind = 0; kind < 5; kind++) CheckAccuracy(Distribution(kind, 100000, rng), accuracy);
+        }
+
+        std::vector<double> one(1, 16.7);
+        CheckAccuracy(one, 0.01);
+        std::vector<double> constant(1000, 8.0);
+        CheckAccuracy(constant, 0.01);
+    }
+
+    void CheckSame(const QuantileSketch& a, const QuantileSketch& b) {
+        std::vector<unsigned char> da;
+        std::vector<unsigned char> db;
+        a.Serialize(da);
+        b.Serialize(db);
+        Capture::SketchHeader ha;
+        Capture::SketchHeader hb;
+        std::memcpy(&ha, da.data(), sizeof(ha));
+        std::memcpy(&hb, db.data(), sizeof(hb));
+
+        // Everything but the sum, which is added in another order, is exact
+        CHECK(ha.count == hb.count && ha.zeroCount == hb.zeroCount);
+        CHECK(ha.offset == hb.offset && ha.binCount == hb.binCount);
+        CHECK(ha.min == hb.min && ha.max == hb.max);
+        CHECK(std::fabs(ha.sum - hb.sum) <= 1e-9 * std::fabs(hb.sum));
+        CHECK(da.size() == db.size() && std::memcmp(da.data() + sizeof(ha), db.data() + sizeof(hb), da.size() - sizeof(ha)) == 0);
+        for (int k = 0; k <= 1000; k++) CHECK(a.Quantile(k / 1000.0) == b.Quantile(k / 1000.0));
+    }
+
+    void TestMerge() {
+        std::mt19937_64 rng(12);
+        for (int kind = 0; kind < 5; kind++) {
+            const std::vector<double> values = Distribution(kind, 50000, rng);
+            QuantileSketch whole;
+            for (double v : values) whole.Add(v);
+
+            // Random split into up to 16 parts, merged in random order into
+            // an empty sketch
+            const size_t parts = 1 + rng() % 16;
+            std::vector<QuantileSketch> split(parts);
+            for (double v : values) split[rng() % parts].Add(v);
+            std::shuffle(split.begin(), split.end(), rng);
+            QuantileSketch merged;
+            for (const QuantileSketch& part : split) CHECK(merged.Merge(part));
+            CheckSame(merged, whole);
+
+            // Split by value: each part covers its own bin range
+            std::vector<double> sorted = values;
+            std::sort(sorted.begin(), sorted.end());
+            QuantileSketch high;
+            QuantileSketch low;
+            for (size_t i = 0; i < sorted.size(); i++) (i < sorted.size() / 3 ? low : high).Add(sorted[i]);
+            CHECK(high.Merge(low));
+            CheckSame(high, whole);
+        }
+
+        // Empty on either side
+        QuantileSketch a;
+        QuantileSketch empty;
+        a.Add(5.0);
+        CHECK(a.Merge(empty) && a.Count() == 1);
+        CHECK(empty.Merge(a) && empty.Count() == 1 && empty.Min() == 5.0 && empty.Max() == 5.0);
+
+        // Different accuracy: refused, and nothing changes
+        QuantileSketch coarse(0.02);
+        coarse.Add(1.0);
+        coarse.Add(100.0);
+        std::vector<unsigned char> before;
+        std::vector<unsigned char> after;
+        a.Serialize(before);
+        CHECK(!a.Merge(coarse));
+        a.Serialize(after);
+        CHECK(before == after);
+    }
+
+    void TestEdges() {
+        QuantileSketch sketch;
+        CHECK(sketch.Quantile(0.5) == 0.0 && sketch.Count() == 0);
+
+        // Negative and NaN are ignored, tiny values count as zero
+        sketch.Add(-1.0);
+        sketch.Add(std::numeric_limits<double>::quiet_NaN());
+        CHECK(sketch.Count() == 0);
+        sketch.Add(0.0);
+        sketch.Add(QuantileSketch::kMinValue / 2);
+        sketch.Add(10.0);
+        sketch.Add(20.0);
+        CHECK(sketch.Count() == 4 && sketch.Min() == 0.0 && sketch.Max() == 20.0);
+        CHECK(sketch.Quantile(0.0) == 0.0 && sketch.Quantile(0.3) == 0.0);
+        CHECK(std::fabs(sketch.Quantile(0.7) - 10.0) <= 0.1);
+        CHECK(sketch.Quantile(1.0) == 20.0);
+        CHECK(sketch.Quantile(-1.0) == 0.0 && sketch.Quantile(2.0) == 20.0);
+
+        // Out-of-range accuracy falls back to the default
+        QuantileSketch fallback(1.5);
+        CHECK(fallback.RelativeAccuracy() == QuantileSketch::kDefaultAccuracy);
+
+        sketch.Clear();
+        CHECK(sketch.Count() == 0 && sketch.Quantile(0.5) == 0.0 && sketch.Sum() == 0.0);
+    }
+
+    // 16 bins at 1% cover about 1.4x: values spanning six decades fold the
+    // low end, quantiles within the top bins stay accurate
+    void TestFolding() {
+        std::mt19937_64 rng(13);
+        const std::vector<double> values = Distribution(4, 100000, rng);
+        QuantileSketch sketch(0.01, 16);
+        for (double v : values) sketch.Add(v);
+        std::vector<unsigned char> data;
+        sketch.Serialize(data);
+        Capture::SketchHeader header;
+        std::memcpy(&header, data.data(), sizeof(header));
+        CHECK(header.binCount == 16);
+
+        uint64_t binned = 0;
+        for (uint32_t i = 0; i < header.binCount; i++) {
+            uint64_t count;
+            std::memcpy(&count, data.data() + sizeof(header) + i * sizeof(uint64_t), sizeof(count));
+            binned += count;
+        }
+        CHECK(sketch.Count() == values.size() && binned + header.zeroCount == values.size());
+
+        // Bins above the folded one: (gamma^offset, gamma^(offset + 15)]
+        std::vector<double> sorted = values;
+        std::sort(sorted.begin(), sorted.end());
+        const double gamma = 1.01 / 0.99;
+        const double kept = std::pow(gamma, header.offset);
+        int checked = 0;
+        for (int k = 0; k <= 100000; k++) {
+            const double exact = Exact(sorted, k / 100000.0);
+            if (exact > kept) {
+                CHECK(std::fabs(sketch.Quantile(k / 100000.0) - exact) <= 0.01 * exact * (1.0 + 1e-9));
+                checked++;
+            }
+        }
+        CHECK(checked > 0);
+        CHECK(sketch.Quantile(1.0) == sorted.back());
+
+        // Folded sketches still merge without losing counts
+        QuantileSketch other(0.01, 16);
+        for (double v : values) other.Add(v * 0.001);
+        CHECK(sketch.Merge(other) && sketch.Count() == 2 * values.size());
+    }
+
+    void TestSerialize() {
+        std::mt19937_64 rng(14);
+        QuantileSketch sketch(0.005);
+        for (double v : Distribution(3, 20000, rng)) sketch.Add(v);
+        sketch.Add(0.0);
+
+        std::vector<unsigned char> data;
+        sketch.Serialize(data);
+        QuantileSketch read;
+        CHECK(read.Deserialize(data.data(), data.size()));
+        CHECK(read.RelativeAccuracy() == 0.005 && read.Sum() == sketch.Sum());
+        CheckSame(read, sketch);
+
+        // A deserialized sketch keeps merging with live ones
+        QuantileSketch live(0.005);
+        live.Add(16.7);
+        CHECK(read.Merge(live) && read.Count() == sketch.Count() + 1);
+
+        // Truncated header or bins, or a bad accuracy: rejected, untouched
+        QuantileSketch other;
+        other.Add(3.0);
+        CHECK(!other.Deserialize(data.data(), data.size() - 1));
+        CHECK(!other.Deserialize(data.data(), sizeof(Capture::SketchHeader) - 1));
+        std::vector<unsigned char> bad = data;
+        const double accuracy = 1.0;
+        std::memcpy(bad.data(), &accuracy, sizeof(accuracy));
+        CHECK(!other.Deserialize(bad.data(), bad.size()));
+        CHECK(other.Count() == 1 && other.Quantile(0.5) == 3.0);
+
+        QuantileSketch empty;
+        empty.Serialize(data);
+        CHECK(data.size() == sizeof(Capture::SketchHeader));
+        CHECK(read.Deserialize(data.data(), data.size()) && read.Count() == 0);
+    }
+}
+
+int main() {
+    TestAccuracy();
+    TestMerge();
+    TestEdges();
+    TestFolding();
+    TestSerialize();
+    std::printf("quantile_sketch: ok\n");
+    return 0;
+}
@@ -0,0 +1,248 @@
+// RenderStateCache with mock resources that track what is alive: only the
+// target looked up last holds a view, Shared state is reused across
+// targets of one device and across Erase / Insert, least recently used and
+// idle targets and devices are forgotten, failed creates leave nothing
+// behind, and a long random sequence never leaks or double-releases.
+
+#include "render_state_cache.h"
+#include "test_util.h"
+
+#include <random>
+#include <set>
+
+namespace {
+    // Everything the mock created and has not released yet
+    struct Resources {
+        std::set<int> shared;
+        std::set<int> views;
+        int nextId = 0;
+        int sharedCreates = 0;
+        int viewCreates = 0;
+    };
+
+    struct MockTraits {
+        using TargetKey = int;
+        using DeviceKey = int;
+        struct Shared {
+            int device = 0;
+            int id = 0;
+        };
+        struct View {
+            int target = 0;
+            int device = 0;
+            int id = 0;
+        };
+
+        Resources* resources = nullptr;
+        int failDevice = -1;    // CreateShared fails for this device
+        int failTarget = -1;    // CreateView fails for this target
+
+        bool CreateShared(int device, Shared& shared) {
+            if (device == failDevice) return false;
+            shared.device = device;
+            shared.id = ++resources->nextId;
+            resources->shared.insert(shared.id);
+            resources->sharedCreates++;
+            return true;
+        }
+
+        void ReleaseShared(Shared& shared) {
+            CHECK(resources->shared.erase(shared.id) == 1);
+        }
+
+        bool CreateView(int target, Shared& shared, View& view) {
+            CHECK(resources->shared.count(shared.id) == 1);
+            if (target == failTarget) return false;
+            view.target = target;
+            view.device = shared.device;
+            view.id = ++resources->nextId;
+            resources->views.insert(view.id);
+            resources->viewCreates++;
+            return true;
+        }
+
+        void ReleaseView(View& view) {
+            CHECK(resources->views.erase(view.id) == 1);
+        }
+    };
+
+    using Cache = RenderStateCache<MockTraits, 4>;
+
+    MockTraits Traits(Resources& resources) {
+        MockTraits traits;
+        traits.resources = &resources;
+        return traits;
+    }
+
+    void CheckBinding(const Cache::Binding& binding, int target, int device) {
+        CHECK(binding);
+        CHECK(binding.view->target == target && binding.view->device == device);
+        CHECK(binding.shared->device == device);
+    }
+
+    void TestSwitching() {
+        Resources resources;
+        {
+            Cache cache(Traits(resources));
+            CHECK(!cache.Find(1));
+
+            Cache::Binding menu = cache.Insert(1, 100);
+            CheckBinding(menu, 1, 100);
+            CHECK(menu.switched);
+            Cache::Binding again = cache.Find(1);
+            CheckBinding(again, 1, 100);
+            CHECK(!again.switched && again.view == menu.view);
+            CHECK(resources.viewCreates == 1);
+
+            // Second swap chain on the same device: Shared reused, the
+            // menu's view released
+            Cache::Binding game = cache.Insert(2, 100);
+            CheckBinding(game, 2, 100);
+            CHECK(game.switched && game.shared == menu.shared);
+            CHECK(resources.sharedCreates == 1 && cache.ViewCount() == 1 && resources.views.size() == 1);
+            CHECK(cache.TargetCount() == 2 && cache.DeviceCount() == 1);
+
+            // Back to the menu: its view is recreated, and the game's released
+            Cache::Binding back = cache.Find(1);
+            CheckBinding(back, 1, 100);
+            CHECK(back.switched && resources.viewCreates == 3 && resources.views.size() == 1);
+
+            // Resize: Erase, then Insert keeps the device's Shared
+            cache.Erase(1);
+            CHECK(cache.TargetCount() == 1 && cache.ViewCount() == 0 && resources.views.empty());
+            CHECK(!cache.Find(1));
+            Cache::Binding resized = cache.Insert(1, 100);
+            CheckBinding(resized, 1, 100);
+            CHECK(resources.sharedCreates == 1);
+
+            // Another device gets its own Shared
+            Cache::Binding other = cache.Insert(3, 200);
+            CheckBinding(other, 3, 200);
+            CHECK(resources.sharedCreates == 2 && cache.DeviceCount() == 2);
+
+            cache.Clear();
+            CHECK(cache.TargetCount() == 0 && cache.DeviceCount() == 0);
+            CHECK(resources.shared.empty() && resources.views.empty());
+            CHECK(cache.Insert(1, 100));
+        }
+        // Destructor releases the rest
+        CHECK(resources.shared.empty() && resources.views.empty());
+    }
+
+    void TestEviction() {
+        Resources resources;
+        Cache cache(Traits(resources));
+        for (int target = 1; target <= 4; target++) CHECK(cache.Insert(target, 100 + target));
+        CHECK(cache.TargetCount() == 4 && cache.DeviceCount() == 4);
+
+        // Touching 1 leaves 2 as the least recently used: it goes, and its
+        // device, now without a target, makes room for 105
+        CHECK(cache.Find(1));
+        CHECK(cache.Insert(5, 105));
+        CHECK(cache.TargetCount() == 4 && cache.DeviceCount() == 4);
+        CHECK(resources.sharedCreates == 5 && resources.shared.size() == 4);
+        CHECK(!cache.Find(2));
+
+        // Now 1 is the oldest
+        CHECK(cache.Find(1) && cache.Find(3) && cache.Find(4) && cache.Find(5));
+        CHECK(cache.Insert(6, 106));
+        CHECK(!cache.Find(1) && cache.Find(3));
+        CHECK(cache.DeviceCount() == 4 && resources.shared.size() == 4);
+        CHECK(resources.views.size() == 1);
+    }
+
+    void TestIdle() {
+        Resources resources;
+        Cache cache(Traits(resources), 10);
+        CHECK(cache.Insert(1, 100));
+        CHECK(cache.Insert(2, 200));
+        for (int i = 0; i < 9; i++) CHECK(cache.Find(2));
+        CHECK(cache.TargetCount() == 2);
+
+        // One call past maxIdle: target 1 is forgotten, its device kept
+        // until it has been without a target for maxIdle calls as well
+        CHECK(cache.Find(2));
+        CHECK(cache.TargetCount() == 1 && cache.DeviceCount() == 2);
+        for (int i = 0; i < 10; i++) CHECK(cache.Find(2));
+        CHECK(cache.DeviceCount() == 2);
+        CHECK(cache.Find(2));
+        CHECK(cache.DeviceCount() == 1 && resources.shared.size() == 1);
+        CHECK(!cache.Find(1));
+
+        // Only Find forgets, and never the target it looks up or its device
+        CHECK(cache.Insert(3, 300));
+        for (int i = 0; i < 20; i++) CHECK(cache.Insert(2, 200));
+        CheckBinding(cache.Find(3), 3, 300);
+        CHECK(cache.TargetCount() == 2 && cache.DeviceCount() == 2);
+    }
+
+    void TestFailures() {
+        Resources resources;
+        Cache cache(Traits(resources));
+        CHECK(cache.Insert(1, 100));
+
+        cache.GetTraits().failDevice = 200;
+        CHECK(!cache.Insert(2, 200));
+        CHECK(cache.TargetCount() == 1 && cache.DeviceCount() == 1);
+        cache.GetTraits().failDevice = -1;
+
+        // The view fails: the target is not remembered, its device is
+        cache.GetTraits().failTarget = 3;
+        CHECK(!cache.Insert(3, 100));
+        CHECK(cache.TargetCount() == 1 && cache.DeviceCount() == 1);
+        CHECK(!cache.Find(3));
+
+        // A switch released target 1's view; recreating it fails: dropped
+        CHECK(cache.Insert(4, 100));
+        cache.GetTraits().failTarget = 1;
+        CHECK(!cache.Find(1));
+        CHECK(cache.TargetCount() == 1);
+        cache.GetTraits().failTarget = -1;
+        CHECK(!cache.Find(1));
+
+        CHECK(resources.views.size() == cache.ViewCount());
+        CHECK(resources.shared.size() == cache.DeviceCount());
+    }
+
+    void TestRandom() {
+        Resources resources;
+        std::mt19937 rng(3);
+        {
+            Cache cache(Traits(resources), 50);
+            for (int step = 0; step < 500000; step++) {
+                const int target = static_cast<int>(rng() % 8);
+                const int device = 100 + static_cast<int>(rng() % 6);
+                const uint32_t op = rng() % 10;
+                if (op < 7) {
+                    Cache::Binding binding = cache.Find(target);
+                    if (!binding) binding = cache.Insert(target, device);
+                    CHECK(binding && binding.view->target == target);
+                    CHECK(binding.view->device == binding.shared->device);
+                    CHECK(cache.ViewCount() == 1);
+                } else if (op < 8) {
+                    cache.Erase(target);
+                } else if (op < 9) {
+                    cache.GetTraits().failTarget = static_cast<int>(rng() % 16);
+                    cache.Insert(target, device);
+                    cache.GetTraits().failTarget = -1;
+                } else if (rng() % 1000 == 0) {
+                    cache.Clear();
+                }
+                CHECK(cache.TargetCount() <= 4 && cache.ViewCount() <= 1);
+                CHECK(resources.views.size() == cache.ViewCount());
+                CHECK(resources.shared.size() == cache.DeviceCount());
+            }
+        }
+        CHECK(resources.shared.empty() && resources.views.empty());
+    }
+}
+
+int main() {
+    TestSwitching();
+    TestEviction();
+    TestIdle();
+    TestFailures();
+    TestRandom();
+    std::printf("render_state_cache: ok\n");
+    return 0;
+}
@@ -0,0 +1,244 @@
+// SharedConfigWriter / SharedConfigReader over a real shm segment: attach
+// and poll semantics, the monitor lease (in process, then held by a monitor
+// in another process that is killed or releases it), and the seqlock under
+// load with the readers in other processes (as the hooked games are), where
+// a reader must never apply a hot line torn by a concurrent Publish.
+
+#include "shared_config.h"
+#include "test_util.h"
+
+#include <csignal>
+#include <cstring>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace {
+    constexpr int kReaders = 4;
+    constexpr int kPublishes = 1000000;
+
+    // Every hot field the test writes carries the same counter
+    void Stamp(FpsConfig& config, int value) {
+        config.offsetX = config.offsetY = config.customX = config.customY = value;
+        config.colorLow = config.colorBackground = static_cast<uint32_t>(value);
+    }
+
+    bool Consistent(const FpsConfig& config) {
+        int v = config.offsetX;
+        return config.offsetY == v && config.customX == v && config.customY == v &&
+               config.colorLow == static_cast<uint32_t>(v) && config.colorBackground == static_cast<uint32_t>(v);
+    }
+
+    void TestPoll() {
+        SharedConfigReader reader;
+        CHECK(!reader.Open());
+        CHECK(!reader.HoldsLease(0, 10));
+
+        FpsConfig config;
+        Stamp(config, 5);
+        std::strcpy(config.gameList, "game.exe");
+        SharedConfigWriter writer;
+        CHECK(writer.Create(config));
+
+        // The first poll picks up the initial config; after that only changes
+        FpsConfig local;
+        CHECK(reader.Open());
+        CHECK(reader.Poll(local) && Consistent(local) && local.offsetX == 5);
+        CHECK(!reader.Poll(local));
+        Stamp(config, 6);
+        writer.Publish(config);
+        writer.Publish(config);
+        CHECK(reader.Poll(local) && local.offsetX == 6);
+        CHECK(!reader.Poll(local));
+        // Only the hot line is copied
+        CHECK(local.gameList[0] == '\0');
+
+        // A write in progress (odd sequence) is never copied, even when the
+        // sequence has moved since the last poll
+        SharedMemory raw;
+        CHECK(raw.Open(CONFIG_SHARED_NAME, sizeof(SharedConfigBlock), true));
+        auto* block = static_cast<SharedConfigBlock*>(raw.Data());
+        block->sequence.fetch_add(1);
+        Stamp(block->config, 7);
+        CHECK(!reader.Poll(local) && local.offsetX == 6);
+        block->sequence.fetch_add(1);
+        CHECK(reader.Poll(local) && local.offsetX == 7);
+        raw.Close();
+
+        // A second monitor attaches and gets the values the hooks are using
+        FpsConfig attached;
+        SharedConfigWriter second;
+        CHECK(second.Create(attached));
+        CHECK(Consistent(attached) && attached.offsetX == 7);
+        CHECK(std::strcmp(attached.gameList, "game.exe") == 0);
+        second.Close();
+
+        writer.Close();
+        reader.Close();
+        CHECK(!reader.Open());
+    }
+
+    void TestLease() {
+        FpsConfig config;
+        SharedConfigWriter writer;
+        CHECK(writer.Create(config));
+        SharedConfigReader reader;
+        CHECK(reader.Open());
+
+        CHECK(reader.HoldsLease(100, 50));
+        CHECK(reader.HoldsLease(149, 50));
+        CHECK(!reader.HoldsLease(150, 50));      // Not renewed for the timeout
+        writer.RenewLease();
+        CHECK(reader.HoldsLease(150, 50));       // Renewed: the timeout restarts
+        CHECK(reader.HoldsLease(199, 50));
+        CHECK(!reader.HoldsLease(200, 50));
+        writer.RenewLease();
+        writer.ReleaseLease();
+        CHECK(!reader.HoldsLease(200, 50));      // Released: immediately gone
+        writer.RenewLease();
+        CHECK(reader.HoldsLease(300, 50));
+
+        writer.Close();
+        reader.Close();
+    }
+
+    uint64_t NowMs() {
+        return static_cast<uint64_t>(NowNs() / 1e6);
+    }
+
+    // Child process: attaches as the monitor and renews every renewMs until
+    // killed, or releases the lease after releaseAfterMs
+    [[noreturn]] void RunMonitor(uint64_t renewMs, uint64_t releaseAfterMs) {
+        FpsConfig config;
+        SharedConfigWriter writer;
+        if (!writer.Create(config)) _exit(2);
+        const uint64_t start = NowMs();
+        for (;;) {
+            writer.RenewLease();
+            if (releaseAfterMs > 0 && NowMs() - start >= releaseAfterMs) {
+                writer.ReleaseLease();
+                _exit(0);
+            }
+            usleep(static_cast<useconds_t>(renewMs * 1000));
+        }
+    }
+
+    // Polls like a 144 Hz game; returns when the lease is lost, in ms
+    uint64_t PollUntilLost(SharedConfigReader& reader, uint64_t timeoutMs, uint64_t limitMs) {
+        const uint64_t start = NowMs();
+        for (;;) {
+            const uint64_t now = NowMs();
+            if (!reader.HoldsLease(now, timeoutMs)) return now;
+            CHECK(now - start < limitMs);
+            usleep(7000);
+        }
+    }
+
+    // The monitor in another process, renewing every 20 ms against a
+    // 100 ms timeout: held while it runs, lost within one timeout of a
+    // SIGKILL, and right away after a clean release. Then the epoch
+    // wrapping past 0 (kLeaseReleased) still counts as a renewal.
+    void TestLeaseAcrossProcesses() {
+        FpsConfig config;
+        SharedConfigWriter owner;
+        CHECK(owner.Create(config));
+        owner.ReleaseLease();
+        SharedConfigReader reader;
+        CHECK(reader.Open());
+
+        pid_t monitor = fork();
+        CHECK(monitor >= 0);
+        if (monitor == 0) RunMonitor(20, 0);
+        usleep(30000);
+        const uint64_t start = NowMs();
+        while (NowMs() - start < 300) {
+            CHECK(reader.HoldsLease(NowMs(), 100));
+            usleep(7000);
+        }
+        CHECK(kill(monitor, SIGKILL) == 0);
+        const uint64_t killed = NowMs();
+        const uint64_t lost = PollUntilLost(reader, 100, 1000);
+        CHECK(lost - killed >= 50 && lost - killed <= 200);
+        int status;
+        CHECK(waitpid(monitor, &status, 0) == monitor && WIFSIGNALED(status));
+
+        monitor = fork();
+        CHECK(monitor >= 0);
+        if (monitor == 0) RunMonitor(20, 150);
+        CHECK(waitpid(monitor, &status, 0) == monitor && WIFEXITED(status) && WEXITSTATUS(status) == 0);
+        const uint64_t released = NowMs();
+        CHECK(PollUntilLost(reader, 100, 1000) - released < 20);
+
+        SharedMemory raw;
+        CHECK(raw.Open(CONFIG_SHARED_NAME, sizeof(SharedConfigBlock), true));
+        auto* block = static_cast<SharedConfigBlock*>(raw.Data());
+        block->leaseEpoch.store(0xFFFFFFFFu);
+        CHECK(reader.HoldsLease(0, 50) && !reader.HoldsLease(50, 50));
+        owner.RenewLease();
+        CHECK(block->leaseEpoch.load() == 1);
+        CHECK(reader.HoldsLease(50, 50));
+        raw.Close();
+
+        reader.Close();
+        owner.Close();
+    }
+
+    // Child process: polls until the final value. Exit code 1: torn or
+    // out-of-order copy, 2: could not open the block
+    int ReadUntilDone() {
+        SharedConfigReader reader;
+        if (!reader.Open()) return 2;
+        FpsConfig local;
+        Stamp(local, 0);
+        int last = 0;
+        while (local.offsetX != -1) {
+            if (!reader.Poll(local)) continue;
+            if (!Consistent(local)) return 1;
+            // Values only move forward
+            if (local.offsetX != -1 && local.offsetX < last) return 1;
+            last = local.offsetX;
+        }
+        return 0;
+    }
+
+    void TestSeqlock() {
+        FpsConfig config;
+        Stamp(config, 0);
+        SharedConfigWriter writer;
+        CHECK(writer.Create(config));
+
+        pid_t children[kReaders];
+        for (int r = 0; r < kReaders; r++) {
+            children[r] = fork();
+            CHECK(children[r] >= 0);
+            if (children[r] == 0) _exit(ReadUntilDone());
+        }
+        for (int i = 1; i < kPublishes; i++) {
+            Stamp(config, i);
+            writer.Publish(config);
+            // Lets the readers run on a machine with fewer cores than processes
+            if ((i & 1023) == 0) usleep(20);
+        }
+        Stamp(config, -1);
+        writer.Publish(config);
+
+        for (int r = 0; r < kReaders; r++) {
+            int status;
+            CHECK(waitpid(children[r], &status, 0) == children[r]);
+            CHECK(WIFEXITED(status));
+            CHECK(WEXITSTATUS(status) == 0);
+        }
+        writer.Close();
+    }
+}
+
+int main() {
+    // A segment left by a crashed run would make the first Open succeed
+    shm_unlink("/" CONFIG_SHARED_NAME);
+    TestPoll();
+    TestLease();
+    TestLeaseAcrossProcesses();
+    TestSeqlock();
+    std::printf("shared_config: ok\n");
+    return 0;
+}
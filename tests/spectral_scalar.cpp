@@ -0,0 +1,10 @@
+// spectral.cpp again with the scalar butterflies, renamed so that
+// spectral_test can run both builds of the FFT in one binary
+#define SPECTRAL_NO_SSE2
+#define Spectral SpectralScalar
+#include "spectral.cpp"
+
+void ScalarForward(size_t n, const float* in, std::complex<float>* out) {
+    SpectralScalar::RealFft fft(n);
+    fft.Forward(in, out);
+}
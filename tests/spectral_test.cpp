@@ -0,0 +1,133 @@
+// Spectral: the real FFT against a naive double-precision DFT at several
+// sizes, the SSE2 butterflies against the scalar ones, and the period
+// detector on synthetic series: a spike every 16 frames (frame domain), a
+// spike every 1.0 s at a varying frame rate (time domain), and series that
+// must not report anything.
+
+#include "spectral.h"
+#include "test_util.h"
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+// tests/spectral_scalar.cpp
+void ScalarForward(size_t n, const float* in, std::complex<float>* out);
+
+namespace {
+    std::vector<std::complex<double>> NaiveDft(const std::vector<float>& in) {
+        const size_t n = in.size();
+        std::vector<std::complex<double>> out(n / 2 + 1);
+        for (size_t k = 0; k <= n / 2; k++) {
+            std::complex<double> sum;
+            for (size_t t = 0; t < n; t++) {
+                double angle = -2.0 * 3.14159265358979323846 * static_cast<double>((k * t) % n) / static_cast<double>(n);
+                sum += static_cast<double>(in[t]) * std::complex<double>(std::cos(angle), std::sin(angle));
+            }
+            out[k] = sum;
+        }
+        return out;
+    }
+
+    void TestFft() {
+        std::mt19937 rng(11);
+        std::uniform_real_distribution<float> value(-10.0f, 10.0f);
+        for (size_t n : { 4, 8, 16, 64, 256, 1024, 4096 }) {
+            Spectral::RealFft fft(n);
+            CHECK(fft.Size() == n);
+            std::vector<float> in(n);
+            for (float& v : in) v = value(rng);
+            in[n / 3] += 100.0f;        // Not only noise
+
+            std::vector<std::complex<float>> simd(n / 2 + 1);
+            std::vector<std::complex<float>> scalar(n / 2 + 1);
+            fft.Forward(in.data(), simd.data());
+            ScalarForward(n, in.data(), scalar.data());
+            const std::vector<std::complex<double>> reference = NaiveDft(in);
+
+            // float rounding grows with log n and the signal's energy
+            double energy = 0.0;
+            for (float v : in) energy += static_cast<double>(v) * v;
+            const double tolerance = 1e-5 * std::sqrt(energy * static_cast<double>(n)) * std::log2(static_cast<double>(n));
+            for (size_t k = 0; k <= n / 2; k++) {
+                const std::complex<double> a(simd[k].real(), simd[k].imag());
+                const std::complex<double> b(scalar[k].real(), scalar[k].imag());
+                CHECK(std::abs(a - reference[k]) <= tolerance);
+                CHECK(std::abs(b - reference[k]) <= tolerance);
+                CHECK(std::abs(a - b) <= tolerance);
+            }
+        }
+        // Sizes round up to a power of two, at least 4
+        CHECK(Spectral::RealFft(1).Size() == 4 && Spectral::RealFft(1000).Size() == 1024);
+    }
+
+    void TestFramePeriod() {
+        Spectral::Analyzer analyzer;
+        for (size_t count : { 256, 512, 1024, 2048 }) {
+            std::vector<float> series(count, 16.6f);
+            for (size_t i = 0; i < count; i += 16) series[i] = 40.0f;
+            const Spectral::PeriodicStutter result = analyzer.Analyze(series.data(), count);
+            CHECK(result.detected && result.domain == Spectral::Domain::Frames);
+            CHECK(std::fabs(result.periodFrames - 16.0f) < 0.1f);
+            CHECK(result.strength > 0.9f);
+        }
+
+        // Frame domain wins at a jittery frame rate too
+        std::mt19937 rng(5);
+        std::uniform_real_distribution<float> jitter(-2.0f, 2.0f);
+        std::vector<float> series(2048);
+        for (size_t i = 0; i < series.size(); i++) series[i] = (i % 24 == 0 ? 45.0f : 16.6f) + jitter(rng);
+        const Spectral::PeriodicStutter result = analyzer.Analyze(series.data(), series.size());
+        CHECK(result.detected && result.domain == Spectral::Domain::Frames);
+        CHECK(std::fabs(result.periodFrames - 24.0f) < 0.5f);
+    }
+
+    void TestTimePeriod() {
+        // A 30 ms hitch once per second at 45..75 fps: no fixed frame count
+        std::mt19937 rng(1);
+        std::uniform_real_distribution<float> frame(13.3f, 22.2f);
+        std::vector<float> series;
+        double now = 0.0;
+        double nextHitch = 1000.0;
+        while (series.size() < 2048) {
+            float ms = frame(rng);
+            if (now + ms >= nextHitch) {
+                ms += 30.0f;
+                nextHitch += 1000.0;
+            }
+            now += ms;
+            series.push_back(ms);
+        }
+        Spectral::Analyzer analyzer;
+        const Spectral::PeriodicStutter result = analyzer.Analyze(series.data(), series.size());
+        CHECK(result.detected && result.domain == Spectral::Domain::Time);
+        CHECK(std::fabs(result.periodMs - 1000.0f) < 30.0f);
+    }
+
+    void TestNothing() {
+        Spectral::Analyzer analyzer;
+        std::vector<float> series(2048, 16.6f);
+        CHECK(!analyzer.Analyze(series.data(), series.size()).detected);     // Flat
+        CHECK(!analyzer.Analyze(series.data(), 15).detected);                // Too short
+        CHECK(!analyzer.Analyze(nullptr, 100).detected);
+
+        std::mt19937 rng(9);
+        std::normal_distribution<float> noise(16.6f, 3.0f);
+        for (float& v : series) v = noise(rng);
+        CHECK(!analyzer.Analyze(series.data(), series.size()).detected);
+
+        // One spike is not periodic
+        std::fill(series.begin(), series.end(), 16.6f);
+        series[700] = 80.0f;
+        CHECK(!analyzer.Analyze(series.data(), series.size()).detected);
+    }
+}
+
+int main() {
+    TestFft();
+    TestFramePeriod();
+    TestTimePeriod();
+    TestNothing();
+    std::printf("spectral: ok\n");
+    return 0;
+}
@@ -0,0 +1,211 @@
+// Telemetry producer/collector: registration, swapchain info, ring drain and
+// drop accounting in one process, a crashed game's pid registering again,
+// then many producer processes registering, pushing, exiting and crashing
+// (never releasing their slot) while the collector polls. Every frame must
+// be either collected or counted as dropped, and every slot must be free at
+// the end.
+
+#include "telemetry.h"
+#include "test_util.h"
+
+#include <chrono>
+#include <cstring>
+#include <map>
+#include <string>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+
+using namespace Telemetry;
+
+namespace {
+    constexpr int kProducers = 24;
+    constexpr uint64_t kFrames = 2000;
+
+    float FrameMs(uint32_t pid) {
+        return static_cast<float>(pid % 7 + 1);
+    }
+
+    uint32_t UsedSlots(const Registry* registry) {
+        uint32_t used = 0;
+        for (uint32_t i = 0; i < kMaxGames; i++) used += registry->pids[i].load() != 0;
+        return used;
+    }
+
+    void TestSingleProducer() {
+        const uint32_t pid = static_cast<uint32_t>(getpid());
+        Producer producer;
+        CHECK(!producer.Open(pid, "game.exe", 1000, 1));      // No monitor yet
+        CHECK(!producer.IsOpen());
+        producer.Push(0, 1.0f, 0);                              // Inactive: a no-op
+
+        Collector collector;
+        CHECK(collector.Create());
+        collector.Poll();
+        CHECK(collector.Games().empty());
+
+        CHECK(producer.Open(pid, "game.exe", 1000, 1));
+        producer.SetSwapchain({ Api::D3D11, 1920, 1080, 28 });
+        for (uint64_t i = 0; i < 10; i++) producer.Push(i, i < 9 ? 10.0f : 40.0f, 1);
+        collector.Poll();
+        CHECK(collector.Games().size() == 1);
+        const Collector::Game& game = *collector.Games()[0];
+        CHECK(game.pid == pid && game.sessionId == 1 && std::strcmp(game.exeName, "game.exe") == 0);
+        CHECK(game.info.api == Api::D3D11 && game.info.width == 1920 && game.info.height == 1080);
+        CHECK(game.frames == 10 && game.intervalFrames == 10 && game.dropped == 0);
+        CHECK(game.maxMs == 40.0 && game.p50Ms > 9.0 && game.p50Ms < 11.0);
+        CHECK(game.intervalFps == 10 * 1000.0 / 130.0);
+
+        // A full ring drops instead of overwriting
+        for (uint64_t i = 0; i < kRingSize + 5; i++) producer.Push(i, 5.0f, 1);
+        collector.Poll();
+        CHECK(collector.Games().size() == 1);
+        CHECK(game.frames == 10 + kRingSize && game.intervalFrames == kRingSize && game.dropped == 5);
+        CHECK(game.session.Count() == game.frames);
+        collector.Poll();
+        CHECK(game.intervalFrames == 0 && game.p99Ms == 0.0);
+
+        producer.SetSwapchain({ Api::D3D12, 2560, 1440, 24 });
+        collector.Poll();
+        CHECK(game.info.api == Api::D3D12 && game.info.width == 2560);
+
+        // Closing releases the slot; the collector notices on the next poll
+        producer.Close();
+        collector.Poll();
+        CHECK(collector.Games().empty());
+        collector.Close();
+    }
+
+    // A game crashes without releasing its slot and its pid comes back (this
+    // process) before the collector notices: the new game takes over, listed
+    // once, with its own session, and its Close leaves no slot behind
+    void TestPidReuse() {
+        const uint32_t pid = static_cast<uint32_t>(getpid());
+        Collector collector;
+        CHECK(collector.Create());
+
+        pid_t child = fork();
+        CHECK(child >= 0);
+        if (child == 0) {
+            Producer crashed;
+            if (!crashed.Open(pid, "old.exe", 1000, 7)) _exit(2);
+            for (uint64_t i = 0; i < 5; i++) crashed.Push(i, 20.0f, 1);
+            _exit(0);       // Crash: the slot stays claimed under a live pid
+        }
+        int status;
+        CHECK(waitpid(child, &status, 0) == child && WIFEXITED(status) && WEXITSTATUS(status) == 0);
+
+        SharedMemory registryMemory;
+        CHECK(registryMemory.Open(TELEMETRY_REGISTRY_NAME, sizeof(Registry), false));
+        const Registry* registry = static_cast<const Registry*>(registryMemory.Data());
+        collector.Poll();
+        CHECK(UsedSlots(registry) == 1 && collector.Games().size() == 1);
+        CHECK(collector.Games()[0]->sessionId == 7 && collector.Games()[0]->frames == 5);
+
+        Producer producer;
+        CHECK(producer.Open(pid, "new.exe", 1000, 8));
+        CHECK(UsedSlots(registry) == 1);
+        for (uint64_t i = 0; i < 3; i++) producer.Push(i, 10.0f, 1);
+        collector.Poll();
+        CHECK(collector.Games().size() == 1);
+        const Collector::Game& game = *collector.Games()[0];
+        CHECK(game.pid == pid && game.sessionId == 8 && std::strcmp(game.exeName, "new.exe") == 0);
+        CHECK(game.frames == 3 && game.maxMs == 10.0);
+
+        producer.Close();
+        collector.Poll();
+        CHECK(UsedSlots(registry) == 0 && collector.Games().empty());
+        registryMemory.Close();
+        collector.Close();
+    }
+
+    // Child process: registers, pushes frames (paced, or in one burst that
+    // overruns the ring), then exits with or without releasing its slot
+    int RunProducer(int index) {
+        const uint32_t pid = static_cast<uint32_t>(getpid());
+        Producer producer;
+        std::string name = "game" + std::to_string(index) + ".exe";
+        if (!producer.Open(pid, name.c_str(), 1000000000ull, 1000 + index)) return 2;
+        for (uint64_t i = 0; i < kFrames; i++) {
+            if (i % 500 == 0) producer.SetSwapchain({ Api::D3D11, 1920u + static_cast<uint32_t>(i), 1080, 28 });
+            producer.Push(i, FrameMs(pid), 1);
+            if (index % 3 != 0 && i % 16 == 15) std::this_thread::sleep_for(std::chrono::microseconds(500));
+        }
+        // Give the collector time to drain the tail
+        std::this_thread::sleep_for(std::chrono::milliseconds(300));
+        if (index % 4 == 3) _exit(0);       // Crash: the slot stays claimed
+        producer.Close();
+        return 0;
+    }
+
+    void TestManyProcesses() {
+        Collector collector;
+        CHECK(collector.Create());
+
+        std::map<uint32_t, int> children;
+        for (int p = 0; p < kProducers; p++) {
+            pid_t pid = fork();
+            CHECK(pid >= 0);
+            if (pid == 0) _exit(RunProducer(p));
+            children[static_cast<uint32_t>(pid)] = p;
+        }
+
+        // Last values seen per game: frames, dropped
+        std::map<uint32_t, std::pair<uint64_t, uint64_t>> last;
+        size_t running = children.size();
+        auto start = std::chrono::steady_clock::now();
+        for (;;) {
+            collector.Poll();
+            for (const auto& game : collector.Games()) {
+                CHECK(children.count(game->pid));
+                CHECK(game->sessionId == 1000u + static_cast<uint64_t>(children[game->pid]));
+                CHECK(game->session.Count() == game->frames);
+                CHECK(game->session.Sum() == static_cast<double>(game->frames) * FrameMs(game->pid));
+                // Never a half-written info block
+                CHECK(game->info.api == Api::Unknown || (game->info.width >= 1920 && game->info.height == 1080));
+                last[game->pid] = { game->frames, game->dropped };
+            }
+
+            int status;
+            pid_t exited;
+            while ((exited = waitpid(-1, &status, WNOHANG)) > 0) {
+                CHECK(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+                running--;
+            }
+            if (running == 0 && collector.Games().empty()) break;
+            CHECK(std::chrono::steady_clock::now() - start < std::chrono::seconds(60));
+            std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        }
+
+        CHECK(last.size() == children.size());
+        uint64_t dropped = 0;
+        for (const auto& kv : last) {
+            CHECK(kv.second.first + kv.second.second == kFrames);
+            dropped += kv.second.second;
+        }
+
+        // Crashed producers were reclaimed as well
+        SharedMemory registryMemory;
+        CHECK(registryMemory.Open(TELEMETRY_REGISTRY_NAME, sizeof(Registry), false));
+        CHECK(UsedSlots(static_cast<const Registry*>(registryMemory.Data())) == 0);
+        registryMemory.Close();
+        collector.Close();
+        // Nobody unlinks the segments of the crashed ones
+        for (const auto& kv : children) {
+            shm_unlink(("/" TELEMETRY_SEGMENT_PREFIX + std::to_string(kv.first)).c_str());
+        }
+        std::printf("telemetry: %d producers, %llu frames dropped\n", kProducers,
+                    static_cast<unsigned long long>(dropped));
+    }
+}
+
+int main() {
+    // Left by a crashed run: producers would find a registry without a collector
+    shm_unlink("/" TELEMETRY_REGISTRY_NAME);
+    TestSingleProducer();
+    TestPidReuse();
+    TestManyProcesses();
+    std::printf("telemetry: ok\n");
+    return 0;
+}
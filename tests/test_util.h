@@ -0,0 +1,31 @@
+#pragma once
+
+// Shared by the C and C++ tests: a CHECK that stays on in release builds,
+// a monotonic clock for the benchmarks and the --quick switch ctest passes
+// to them.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define CHECK(cond)                                                              \
+    do {                                                                         \
+        if (!(cond)) {                                                           \
+            fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #cond); \
+            exit(1);                                                             \
+        }                                                                        \
+    } while (0)
+
+static inline double NowNs(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static inline int HasArg(int argc, char** argv, const char* arg) {
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], arg) == 0) return 1;
+    }
+    return 0;
+}
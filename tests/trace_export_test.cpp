@@ -0,0 +1,563 @@
+// TraceExport on a small synthetic capture with two swap chains: the Chrome
+// output parses as JSON and carries the escaped process name, one Frame per
+// record with Overlay / Present nested inside it (clipped at the next frame)
+// and a single Hitch; the Perfetto output decodes packet by packet, every
+// event refers to a described track, slices balance per track, and both
+// formats hold exactly the same slices at the same nanosecond times.
+
+#include "capture.h"
+#include "trace_export.h"
+#include "test_util.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <map>
+#include <set>
+#include <string>
+#include <tuple>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+    constexpr uint64_t kFrequency = 10000000;       // 100 ns ticks
+    constexpr uint64_t kStart = 5000000;
+    constexpr uint32_t kPid = 4242;
+    const char kExeName[] = "ga\"me\\x.exe";
+
+    std::string s_dir;
+
+    // ------------------------------------------------------------------
+    // Synthetic capture
+    // ------------------------------------------------------------------
+
+    // Chain 1: 60 frames at 16.6 ms with a 100 ms stall after frame 30, frame
+    // 10 blocking in Present past the next frame, frame 20 without overlay.
+    // Chain 2: 20 frames at 50 ms, no Present time.
+    std::vector<Capture::FrameRecord> Frames() {
+        std::vector<Capture::FrameRecord> frames;
+        uint64_t qpc = kStart;
+        for (uint32_t i = 0; i < 60; i++) {
+            Capture::FrameRecord f = {};
+            f.presentQpc = qpc;
+            f.overlayTicks = i == 20 ? 0 : 5000;
+            f.presentTicks = i == 10 ? 400000 : 20000;
+            f.swapChainId = 1;
+            frames.push_back(f);
+            qpc += i == 30 ? 1000000 : 166000;
+        }
+        qpc = kStart + 1234;
+        for (uint32_t i = 0; i < 20; i++) {
+            Capture::FrameRecord f = {};
+            f.presentQpc = qpc;
+            f.overlayTicks = 3000;
+            f.swapChainId = 0xABCD;
+            frames.push_back(f);
+            qpc += 500000;
+        }
+        std::stable_sort(frames.begin(), frames.end(), [](const Capture::FrameRecord& a, const Capture::FrameRecord& b) {
+            return a.presentQpc < b.presentQpc;
+        });
+        return frames;
+    }
+
+    std::string WriteCapture() {
+        Capture::FileHeader header = {};
+        header.qpcFrequency = kFrequency;
+        header.startQpc = kStart;
+        header.pid = kPid;
+        std::strcpy(header.exeName, kExeName);
+
+        const std::string path = s_dir + "/synthetic.fpsc";
+        Capture::Writer writer;
+        CHECK(writer.Open(path.c_str(), header));
+        for (const Capture::FrameRecord& f : Frames()) writer.Append(f);
+        writer.Close();
+        return path;
+    }
+
+    std::vector<unsigned char> Export(const Capture::Reader& reader, TraceExport::Format format) {
+        const std::string path = s_dir + "/trace.out";
+        std::FILE* f = std::fopen(path.c_str(), "wb");
+        CHECK(f != nullptr);
+        CHECK(TraceExport::Write(reader, f, format));
+        CHECK(std::fclose(f) == 0);
+
+        f = std::fopen(path.c_str(), "rb");
+        CHECK(f != nullptr);
+        std::vector<unsigned char> data;
+        unsigned char buffer[4096];
+        size_t n;
+        while ((n = std::fread(buffer, 1, sizeof(buffer), f)) > 0) data.insert(data.end(), buffer, buffer + n);
+        std::fclose(f);
+        return data;
+    }
+
+    // (track, name, begin ns, end ns); instants have end == begin
+    using Slice = std::tuple<uint32_t, std::string, uint64_t, uint64_t>;
+
+    // Frame, Overlay, Present and Hitch counts per track, and that every
+    // Overlay / Present lies inside one Frame of its track
+    void CheckSlices(const std::vector<Slice>& slices) {
+        std::map<std::string, int> counts[2];
+        std::vector<Slice> frames;
+        for (const Slice& s : slices) {
+            CHECK(std::get<3>(s) >= std::get<2>(s));
+            CHECK(std::get<0>(s) == 1 || std::get<0>(s) == 0xABCD);
+            counts[std::get<0>(s) == 1 ? 0 : 1][std::get<1>(s)]++;
+            if (std::get<1>(s) == "Frame") frames.push_back(s);
+        }
+        CHECK(counts[0]["Frame"] == 60 && counts[0]["Overlay"] == 59 && counts[0]["Present"] == 60);
+        CHECK(counts[1]["Frame"] == 20 && counts[1]["Overlay"] == 20 && counts[1]["Present"] == 0);
+        CHECK(counts[0]["Hitch"] == 1 && counts[1]["Hitch"] == 0);
+        CHECK(slices.size() == 60 + 59 + 60 + 1 + 20 + 20);
+
+        for (const Slice& s : slices) {
+            if (std::get<1>(s) == "Frame") continue;
+            int parents = 0;
+            for (const Slice& frame : frames) {
+                if (std::get<0>(frame) == std::get<0>(s) && std::get<2>(frame) <= std::get<2>(s) &&
+                    std::get<3>(s) <= std::get<3>(frame)) {
+                    parents++;
+                }
+            }
+            CHECK(parents == 1 || (parents == 2 && std::get<2>(s) == std::get<3>(s)));
+        }
+
+        // Frame 30 of chain 1 is the stall; Hitch at its start
+        const uint64_t stall = (kStart + 30 * 166000) * 100;
+        CHECK(std::count(slices.begin(), slices.end(), Slice(1, "Frame", stall, stall + 100000000)) == 1);
+        CHECK(std::count(slices.begin(), slices.end(), Slice(1, "Hitch", stall, stall)) == 1);
+
+        // Frame 10's Present is clipped at frame 11
+        const uint64_t ten = (kStart + 10 * 166000) * 100;
+        CHECK(std::count(slices.begin(), slices.end(), Slice(1, "Present", ten + 500000, ten + 16600000)) == 1);
+
+        // The last frame ends after its own work
+        const uint64_t last = (kStart + 1234 + 19 * 500000) * 100;
+        CHECK(std::count(slices.begin(), slices.end(), Slice(0xABCD, "Frame", last, last + 300000)) == 1);
+    }
+
+    // ------------------------------------------------------------------
+    // Minimal JSON parser
+    // ------------------------------------------------------------------
+
+    struct Json {
+        enum Type { Null, Bool, Number, String, Array, Object } type = Null;
+        double number = 0.0;
+        std::string string;
+        std::vector<Json> items;
+        std::vector<std::pair<std::string, Json>> members;
+
+        const Json* Get(const char* key) const {
+            for (const auto& m : members) {
+                if (m.first == key) return &m.second;
+            }
+            return nullptr;
+        }
+    };
+
+    class JsonParser {
+    public:
+        JsonParser(const char* p, const char* end) : m_p(p), m_end(end) {}
+
+        bool ParseDocument(Json& out) {
+            if (!Parse(out)) return false;
+            SkipSpace();
+            return m_p == m_end;
+        }
+
+    private:
+        void SkipSpace() {
+            while (m_p < m_end && (*m_p == ' ' || *m_p == '\n' || *m_p == '\r' || *m_p == '\t')) m_p++;
+        }
+
+        bool Literal(const char* word) {
+            size_t n = std::strlen(word);
+            if (static_cast<size_t>(m_end - m_p) < n || std::memcmp(m_p, word, n) != 0) return false;
+            m_p += n;
+            return true;
+        }
+
+        bool ParseString(std::string& out) {
+            if (m_p == m_end || *m_p != '"') return false;
+            m_p++;
+            while (m_p < m_end && *m_p != '"') {
+                unsigned char c = static_cast<unsigned char>(*m_p++);
+                if (c < 0x20) return false;
+                if (c != '\\') {
+                    out += static_cast<char>(c);
+                    continue;
+                }
+                if (m_p == m_end) return false;
+                char e = *m_p++;
+                switch (e) {
+                case '"': case '\\': case '/': out += e; break;
+                case 'b': out += '\b'; break;
+                case 'f': out += '\f'; break;
+                case 'n': out += '\n'; break;
+                case 'r': out += '\r'; break;
+                case 't': out += '\t'; break;
+                case 'u': {
+                    if (m_end - m_p < 4) return false;
+                    unsigned code = 0;
+                    for (int i = 0; i < 4; i++) {
+                        char h = *m_p++;
+                        code <<= 4;
+                        if (h >= '0' && h <= '9') code |= h - '0';
+                        else if (h >= 'a' && h <= 'f') code |= h - 'a' + 10;
+                        else if (h >= 'A' && h <= 'F') code |= h - 'A' + 10;
+                        else return false;
+                    }
+                    if (code >= 0x80) return false;     // Only control characters are escaped
+                    out += static_cast<char>(code);
+                    break;
+                }
+                default:
+                    return false;
+                }
+            }
+            if (m_p == m_end) return false;
+            m_p++;
+            return true;
+        }
+
+        bool ParseNumber(double& out) {
+            const char* start = m_p;
+            if (m_p < m_end && *m_p == '-') m_p++;
+            if (m_p == m_end || *m_p < '0' || *m_p > '9') return false;
+            if (*m_p == '0' && m_p + 1 < m_end && m_p[1] >= '0' && m_p[1] <= '9') return false;
+            while (m_p < m_end && ((*m_p >= '0' && *m_p <= '9') || *m_p == '.' || *m_p == 'e' || *m_p == 'E' ||
+                                   *m_p == '+' || *m_p == '-')) {
+                m_p++;
+            }
+            std::string text(start, m_p);
+            char* parsed = nullptr;
+            out = std::strtod(text.c_str(), &parsed);
+            return *parsed == '\0' && text.back() != '.';
+        }
+
+        bool Parse(Json& out) {
+            SkipSpace();
+            if (m_p == m_end) return false;
+            switch (*m_p) {
+            case '{':
+                out.type = Json::Object;
+                m_p++;
+                SkipSpace();
+                if (m_p < m_end && *m_p == '}') { m_p++; return true; }
+                for (;;) {
+                    std::pair<std::string, Json> member;
+                    SkipSpace();
+                    if (!ParseString(member.first)) return false;
+                    SkipSpace();
+                    if (m_p == m_end || *m_p++ != ':') return false;
+                    if (!Parse(member.second)) return false;
+                    out.members.push_back(std::move(member));
+                    SkipSpace();
+                    if (m_p == m_end) return false;
+                    if (*m_p == '}') { m_p++; return true; }
+                    if (*m_p++ != ',') return false;
+                }
+            case '[':
+                out.type = Json::Array;
+                m_p++;
+                SkipSpace();
+                if (m_p < m_end && *m_p == ']') { m_p++; return true; }
+                for (;;) {
+                    out.items.emplace_back();
+                    if (!Parse(out.items.back())) return false;
+                    SkipSpace();
+                    if (m_p == m_end) return false;
+                    if (*m_p == ']') { m_p++; return true; }
+                    if (*m_p++ != ',') return false;
+                }
+            case '"':
+                out.type = Json::String;
+                return ParseString(out.string);
+            case 't':
+                out.type = Json::Bool;
+                return Literal("true");
+            case 'f':
+                out.type = Json::Bool;
+                return Literal("false");
+            case 'n':
+                return Literal("null");
+            default:
+                out.type = Json::Number;
+                return ParseNumber(out.number);
+            }
+        }
+
+        const char* m_p;
+        const char* m_end;
+    };
+
+    bool ParseJson(const std::string& text, Json& out) {
+        JsonParser parser(text.data(), text.data() + text.size());
+        return parser.ParseDocument(out);
+    }
+
+    uint64_t Microseconds(const Json* value) {
+        CHECK(value && value->type == Json::Number && value->number >= 0.0);
+        return static_cast<uint64_t>(std::llround(value->number * 1000.0));
+    }
+
+    std::vector<Slice> TestChromeJson(const Capture::Reader& reader) {
+        // The parser itself
+        Json probe;
+        CHECK(ParseJson("{\"a\":[1,-2.5e3,\"x\\u0001\\\"\",true,null,{}],\"b\":{}}", probe));
+        CHECK(probe.Get("a")->items.size() == 6 && probe.Get("a")->items[2].string == "x\x01\"");
+        CHECK(!ParseJson("{\"a\":1,}", probe));
+        CHECK(!ParseJson("[1 2]", probe));
+        CHECK(!ParseJson("{\"a\":\"x\"\"}", probe));
+        CHECK(!ParseJson("{\"a\":01}", probe));
+
+        const std::vector<unsigned char> data = Export(reader, TraceExport::Format::ChromeJson);
+        Json root;
+        CHECK(ParseJson(std::string(data.begin(), data.end()), root));
+        CHECK(root.type == Json::Object);
+        const Json* events = root.Get("traceEvents");
+        CHECK(events && events->type == Json::Array);
+        CHECK(root.Get("displayTimeUnit") && root.Get("displayTimeUnit")->string == "ms");
+
+        std::vector<Slice> slices;
+        std::set<uint32_t> named;
+        bool process = false;
+        for (const Json& e : events->items) {
+            CHECK(e.type == Json::Object);
+            const Json* ph = e.Get("ph");
+            const Json* pid = e.Get("pid");
+            const Json* tid = e.Get("tid");
+            const Json* name = e.Get("name");
+            CHECK(ph && ph->type == Json::String && pid && pid->number == kPid);
+            CHECK(tid && tid->type == Json::Number && name && name->type == Json::String);
+            const uint32_t track = static_cast<uint32_t>(tid->number);
+
+            if (ph->string == "M") {
+                const Json* args = e.Get("args");
+                CHECK(args && args->Get("name") && args->Get("name")->type == Json::String);
+                if (name->string == "process_name") {
+                    CHECK(args->Get("name")->string == kExeName && !process);
+                    process = true;
+                } else {
+                    CHECK(name->string == "thread_name");
+                    CHECK(named.insert(track).second);
+                }
+            } else if (ph->string == "X") {
+                CHECK(named.count(track) == 1);
+                const uint64_t ts = Microseconds(e.Get("ts"));
+                slices.emplace_back(track, name->string, ts, ts + Microseconds(e.Get("dur")));
+            } else {
+                CHECK(ph->string == "i" && e.Get("s") && e.Get("s")->string == "t");
+                CHECK(named.count(track) == 1);
+                const uint64_t ts = Microseconds(e.Get("ts"));
+                slices.emplace_back(track, name->string, ts, ts);
+            }
+        }
+        CHECK(process && named.size() == 2);
+        CheckSlices(slices);
+        return slices;
+    }
+
+    // ------------------------------------------------------------------
+    // Protobuf decoding
+    // ------------------------------------------------------------------
+
+    struct Field {
+        uint32_t number;
+        uint32_t wireType;
+        uint64_t value;                 // Varint
+        const unsigned char* data;      // Length-delimited
+        size_t size;
+    };
+
+    class ProtoReader {
+    public:
+        ProtoReader(const unsigned char* p, size_t size) : m_p(p), m_end(p + size) {}
+
+        bool Done() const { return m_p == m_end; }
+
+        // Only the wire types the exporter uses: varint and length-delimited
+        bool Next(Field& field) {
+            uint64_t key;
+            if (!Varint(key)) return false;
+            field.number = static_cast<uint32_t>(key >> 3);
+            field.wireType = static_cast<uint32_t>(key & 7);
+            field.data = nullptr;
+            field.size = 0;
+            field.value = 0;
+            if (field.number == 0) return false;
+            if (field.wireType == 0) return Varint(field.value);
+            if (field.wireType != 2) return false;
+            uint64_t size;
+            if (!Varint(size) || size > static_cast<uint64_t>(m_end - m_p)) return false;
+            field.data = m_p;
+            field.size = static_cast<size_t>(size);
+            m_p += size;
+            return true;
+        }
+
+    private:
+        bool Varint(uint64_t& out) {
+            out = 0;
+            for (int shift = 0; shift < 64; shift += 7) {
+                if (m_p == m_end) return false;
+                unsigned char b = *m_p++;
+                out |= static_cast<uint64_t>(b & 0x7F) << shift;
+                if (!(b & 0x80)) return true;
+            }
+            return false;
+        }
+
+        const unsigned char* m_p;
+        const unsigned char* m_end;
+    };
+
+    // Every field of a message, which must decode to the end
+    std::vector<Field> Fields(const unsigned char* p, size_t size) {
+        std::vector<Field> fields;
+        ProtoReader reader(p, size);
+        while (!reader.Done()) {
+            Field field;
+            CHECK(reader.Next(field));
+            fields.push_back(field);
+        }
+        return fields;
+    }
+
+    const Field* Find(const std::vector<Field>& fields, uint32_t number, uint32_t wireType) {
+        const Field* found = nullptr;
+        for (const Field& f : fields) {
+            if (f.number == number) {
+                CHECK(f.wireType == wireType && !found);    // Never repeated here
+                found = &f;
+            }
+        }
+        return found;
+    }
+
+    std::string Text(const Field* field) {
+        CHECK(field && field->wireType == 2);
+        return std::string(reinterpret_cast<const char*>(field->data), field->size);
+    }
+
+    std::vector<Slice> TestPerfetto(const Capture::Reader& reader) {
+        const std::vector<unsigned char> data = Export(reader, TraceExport::Format::Perfetto);
+        const uint64_t processUuid = (static_cast<uint64_t>(kPid) << 32) | 0xFFFFFFFFull;
+
+        std::map<uint64_t, uint32_t> tracks;   // uuid -> tid
+        std::map<uint64_t, std::vector<std::pair<std::string, uint64_t>>> open;
+        std::map<uint64_t, uint64_t> lastTs;
+        std::vector<Slice> slices;
+        bool process = false;
+        size_t packets = 0;
+
+        // Trace: nothing but repeated packet (field 1)
+        for (const Field& packetField : Fields(data.data(), data.size())) {
+            CHECK(packetField.number == 1 && packetField.wireType == 2);
+            const std::vector<Field> packet = Fields(packetField.data, packetField.size);
+            const Field* sequence = Find(packet, 10, 0);
+            CHECK(sequence && sequence->value == 0x46505343);
+            if (packets++ == 0) {
+                // First packet clears incremental state and describes the process
+                const Field* flags = Find(packet, 13, 0);
+                CHECK(flags && flags->value == 1);
+            }
+
+            if (const Field* descriptor = Find(packet, 60, 2)) {
+                const std::vector<Field> track = Fields(descriptor->data, descriptor->size);
+                const Field* uuid = Find(track, 1, 0);
+                CHECK(uuid && tracks.count(uuid->value) == 0);
+                if (const Field* p = Find(track, 3, 2)) {
+                    const std::vector<Field> desc = Fields(p->data, p->size);
+                    CHECK(uuid->value == processUuid && !process);
+                    CHECK(Find(desc, 1, 0) && Find(desc, 1, 0)->value == kPid);
+                    CHECK(Text(Find(desc, 6, 2)) == kExeName);
+                    process = true;
+                } else {
+                    const Field* t = Find(track, 4, 2);
+                    CHECK(t && process);
+                    CHECK(Find(track, 5, 0) && Find(track, 5, 0)->value == processUuid);
+                    const std::vector<Field> desc = Fields(t->data, t->size);
+                    CHECK(Find(desc, 1, 0) && Find(desc, 1, 0)->value == kPid);
+                    const Field* tid = Find(desc, 2, 0);
+                    CHECK(tid && uuid->value == ((static_cast<uint64_t>(kPid) << 32) | tid->value));
+                    char expected[48];
+                    std::snprintf(expected, sizeof(expected), "SwapChain %08X", static_cast<uint32_t>(tid->value));
+                    CHECK(Text(Find(desc, 5, 2)) == expected);
+                    tracks[uuid->value] = static_cast<uint32_t>(tid->value);
+                }
+                CHECK(!Find(packet, 11, 2));
+                continue;
+            }
+
+            const Field* eventField = Find(packet, 11, 2);
+            const Field* timestamp = Find(packet, 8, 0);
+            CHECK(eventField && timestamp);
+            const std::vector<Field> event = Fields(eventField->data, eventField->size);
+            const Field* type = Find(event, 9, 0);
+            const Field* uuid = Find(event, 11, 0);
+            const Field* name = Find(event, 23, 2);
+            CHECK(type && uuid && tracks.count(uuid->value) == 1);
+
+            // Timestamps never go backwards within a track
+            const uint64_t ts = timestamp->value;
+            CHECK(lastTs[uuid->value] <= ts);
+            lastTs[uuid->value] = ts;
+
+            const uint32_t tid = tracks[uuid->value];
+            std::vector<std::pair<std::string, uint64_t>>& stack = open[uuid->value];
+            if (type->value == 1) {             // SLICE_BEGIN
+                CHECK(name && stack.size() < 2);
+                stack.emplace_back(Text(name), ts);
+            } else if (type->value == 2) {      // SLICE_END
+                CHECK(!name && !stack.empty());
+                slices.emplace_back(tid, stack.back().first, stack.back().second, ts);
+                stack.pop_back();
+            } else {                            // INSTANT
+                CHECK(type->value == 3 && name && stack.size() == 1);
+                slices.emplace_back(tid, Text(name), ts, ts);
+            }
+        }
+        CHECK(process && tracks.size() == 2);
+        for (const auto& entry : open) CHECK(entry.second.empty());
+        CheckSlices(slices);
+        return slices;
+    }
+}
+
+int main() {
+    char dir[] = "/tmp/trace_export_test.XXXXXX";
+    CHECK(mkdtemp(dir) != nullptr);
+    s_dir = dir;
+
+    Capture::Reader reader;
+    CHECK(reader.Open(WriteCapture().c_str()) && reader.FrameCount() == 80);
+
+    std::vector<Slice> json = TestChromeJson(reader);
+    std::vector<Slice> perfetto = TestPerfetto(reader);
+    std::sort(json.begin(), json.end());
+    std::sort(perfetto.begin(), perfetto.end());
+    CHECK(json == perfetto);
+
+    // An empty capture is still a valid, empty trace
+    Capture::FileHeader header = {};
+    header.qpcFrequency = kFrequency;
+    header.pid = kPid;
+    const std::string emptyPath = s_dir + "/empty.fpsc";
+    Capture::Writer writer;
+    CHECK(writer.Open(emptyPath.c_str(), header));
+    writer.Close();
+    Capture::Reader empty;
+    CHECK(empty.Open(emptyPath.c_str()));
+    const std::vector<unsigned char> data = Export(empty, TraceExport::Format::ChromeJson);
+    Json root;
+    CHECK(ParseJson(std::string(data.begin(), data.end()), root));
+    CHECK(root.Get("traceEvents")->items.size() == 1);     // process_name only
+
+    std::string cleanup = "rm -rf " + s_dir;
+    CHECK(std::system(cleanup.c_str()) == 0);
+    std::printf("trace_export: ok\n");
+    return 0;
+}
@@ -0,0 +1,182 @@
+// VerdictCache: key folding, the miss/never-game/game transitions and rule
+// stamps, then many processes recording verdicts for the same exes at once.
+// Afterwards every key must sit in exactly one slot with its final verdict.
+// Also: clears racing with writers, and a table filled past capacity.
+
+#include "verdict_cache.h"
+#include "test_util.h"
+
+#include <cstring>
+#include <random>
+#include <set>
+#include <string>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+
+using namespace VerdictCache;
+
+namespace {
+    constexpr int kKeys = 3000;
+    constexpr int kProcesses = 16;
+    constexpr int kOpsPerProcess = 40000;
+
+    uint64_t KeyOf(int i) {
+        FileIdentity identity = { 1, static_cast<uint64_t>(i), 100, 7 };
+        // Few distinct paths: keys differ by file identity as well
+        std::string path = "C:\\Games\\G" + std::to_string(i % 97) + "\\Game.exe";
+        return MakeKey(path.c_str(), path.size(), identity);
+    }
+
+    bool IsGame(int i) { return i % 5 == 0; }
+    bool IsFiltered(int i) { return i % 7 == 3; }
+
+    // What a hooked process records for key i; returns the number of
+    // verdicts that contradict the rules
+    int Worker(Table& table, unsigned seed, int ops) {
+        std::mt19937 rng(seed);
+        int errors = 0;
+        for (int n = 0; n < ops; n++) {
+            int i = static_cast<int>(rng() % kKeys);
+            uint64_t key = KeyOf(i);
+            Verdict before = table.Lookup(key);
+            if (IsGame(i)) {
+                errors += before == kNeverGame;
+                errors += table.RecordGame(key) != kGame;
+            } else if (IsFiltered(i)) {
+                errors += before == kGame;
+                errors += table.RecordNeverGame(key) != kNeverGame;
+            } else {
+                Verdict verdict = table.RecordMiss(key);
+                errors += verdict == kGame || verdict == kUnknown;
+            }
+        }
+        return errors;
+    }
+
+    void TestSemantics() {
+        Table hook;
+        CHECK(!hook.Open());
+        CHECK(hook.Lookup(1) == kUnknown && hook.RecordGame(1) == kUnknown);
+
+        const FileIdentity identity = { 1, 2, 3, 4 };
+        const char* path = "C:\\Games\\Foo\\Game.exe";
+        const uint64_t key = MakeKey(path, std::strlen(path), identity);
+        CHECK(key != 0);
+        CHECK(MakeKey("c:/games/foo/GAME.EXE", 21, identity) == key);
+        FileIdentity patched = identity;
+        patched.lastWrite++;
+        CHECK(MakeKey(path, std::strlen(path), patched) != key);
+
+        Table monitor;
+        CHECK(monitor.Create());
+        monitor.SetRules(1);
+        CHECK(hook.Open());
+        CHECK(hook.Lookup(key) == kUnknown);
+
+        // kMaxMisses launches without D3D make a never-game
+        for (uint32_t miss = 1; miss < kMaxMisses; miss++) {
+            CHECK(hook.RecordMiss(key) == kUndecided);
+            CHECK(hook.Lookup(key) == kUndecided);
+        }
+        CHECK(hook.RecordMiss(key) == kNeverGame);
+        CHECK(monitor.Lookup(key) == kNeverGame);
+
+        // Seen rendering: promoted, and never demoted by misses
+        CHECK(hook.RecordGame(key) == kGame);
+        for (uint32_t miss = 0; miss < 2 * kMaxMisses; miss++) CHECK(hook.RecordMiss(key) == kGame);
+        CHECK(hook.Lookup(key) == kGame);
+
+        const uint64_t other = MakeKey(path, std::strlen(path), patched);
+        CHECK(hook.RecordNeverGame(other) == kNeverGame);
+        CHECK(hook.RecordMiss(other) == kNeverGame);
+
+        // Same rules keep the verdicts, new rules clear them
+        monitor.SetRules(1);
+        CHECK(hook.Lookup(key) == kGame && hook.Lookup(other) == kNeverGame);
+        monitor.SetRules(2);
+        CHECK(hook.Lookup(key) == kUnknown && hook.Lookup(other) == kUnknown);
+
+        hook.Close();
+        monitor.Close();
+    }
+
+    void TestManyProcesses() {
+        Table monitor;
+        CHECK(monitor.Create());
+        monitor.SetRules(1);
+
+        pid_t children[kProcesses];
+        for (int p = 0; p < kProcesses; p++) {
+            children[p] = fork();
+            CHECK(children[p] >= 0);
+            if (children[p] == 0) {
+                Table table;
+                if (!table.Open()) _exit(2);
+                _exit(Worker(table, static_cast<unsigned>(p + 1), kOpsPerProcess) ? 1 : 0);
+            }
+        }
+        for (int p = 0; p < kProcesses; p++) {
+            int status;
+            CHECK(waitpid(children[p], &status, 0) == children[p]);
+            CHECK(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+        }
+
+        // Every key once, with its final verdict (each key saw far more than
+        // kMaxMisses records)
+        SharedMemory raw;
+        CHECK(raw.Open(VERDICT_CACHE_SHARED_NAME, sizeof(Block), false));
+        const Block* block = static_cast<const Block*>(raw.Data());
+        std::set<uint64_t> keys;
+        for (uint32_t s = 0; s < kSlots; s++) {
+            uint64_t word = block->slots[s].load();
+            if (word) CHECK(keys.insert(word & ~uint64_t(0xF)).second);
+        }
+        CHECK(keys.size() == kKeys);
+        for (int i = 0; i < kKeys; i++) CHECK(monitor.Lookup(KeyOf(i)) == (IsGame(i) ? kGame : kNeverGame));
+        raw.Close();
+        monitor.Close();
+    }
+
+    void TestRacingClears() {
+        Table monitor;
+        CHECK(monitor.Create());
+        monitor.SetRules(1);
+        Table hook;
+        CHECK(hook.Open());
+
+        // Records may be lost to a clear, but never turn into a wrong verdict
+        std::thread clears([&] {
+            for (uint64_t i = 0; i < 200; i++) monitor.SetRules(100 + i);
+        });
+        int errors = Worker(hook, 999, 200000);
+        clears.join();
+        CHECK(errors == 0);
+
+        // Past capacity: records fail with kUnknown, earlier keys stay readable
+        monitor.SetRules(7);
+        int rejected = 0;
+        for (int i = 0; i < 20000; i++) {
+            FileIdentity identity = { 9, static_cast<uint64_t>(i), 1, 1 };
+            Verdict verdict = hook.RecordMiss(MakeKey("x.exe", 5, identity));
+            CHECK(verdict == kUndecided || verdict == kUnknown);
+            rejected += verdict == kUnknown;
+            if (i == 0) CHECK(hook.RecordGame(KeyOf(0)) == kGame);
+        }
+        CHECK(rejected >= 20000 - static_cast<int>(kSlots));
+        CHECK(hook.Lookup(KeyOf(0)) == kGame);
+        hook.Close();
+        monitor.Close();
+    }
+}
+
+int main() {
+    // A table left by a crashed run would make the first Open succeed
+    shm_unlink("/" VERDICT_CACHE_SHARED_NAME);
+    TestSemantics();
+    TestManyProcesses();
+    TestRacingClears();
+    std::printf("verdict_cache: ok\n");
+    return 0;
+}
@@ -0,0 +1,112 @@
+// Calling through a hooked vtable slot against a plain virtual call: the
+// direct call, a VtableSlotHook detour forwarding to the original, and the
+// same detour reached through a per-object VtableShadowHook. Then what a
+// hook costs to put in and take out: VtableSlotHook on the read-only class
+// vtable (reads /proc/self/maps and mprotects twice per call) and on a
+// writable table, and VtableShadowHook (one allocation, copy and
+// compare-exchange).
+//
+// usage: vtable_hook_bench [--quick]
+
+#include "vtable_hook.h"
+#include "test_util.h"
+
+#include <cstdio>
+
+namespace {
+    struct Base {
+        virtual int Value(int x) const = 0;
+        virtual ~Base() = default;
+    };
+
+    struct Impl : Base {
+        int bias = 1;
+        int Value(int x) const override { return x + bias; }
+    };
+
+    using ValueFn = int (*)(const Base*, int);
+
+    // Keeps the compiler from devirtualizing the call on a local object
+    template <typename T>
+    T Opaque(T pointer) {
+        asm volatile("" : "+r"(pointer));
+        return pointer;
+    }
+
+    __attribute__((noinline)) int CallValue(const Base* object, int x) { return Opaque(object)->Value(x); }
+
+    void* s_original = nullptr;
+
+    // What a Present detour does at minimum: forward and return
+    int Detour(const Base* self, int x) {
+        return reinterpret_cast<ValueFn>(s_original)(self, x);
+    }
+
+    double CallNs(const Base* object, long calls) {
+        volatile int sink = 0;
+        double t0 = NowNs();
+        for (long i = 0; i < calls; i++) sink = sink + CallValue(object, static_cast<int>(i));
+        return (NowNs() - t0) / calls;
+    }
+
+    void BenchCalls(long calls) {
+        Impl object;
+        const double direct = CallNs(&object, calls);
+
+        VtableSlotHook slot;
+        CHECK(slot.Install(&object, 0, reinterpret_cast<void*>(Detour), &s_original));
+        CHECK(*Opaque(VtableSlotHook::SlotOf(&object, 0)) == reinterpret_cast<void*>(Detour));
+        CHECK(CallValue(&object, 1) == 2);
+        const double patched = CallNs(&object, calls);
+        CHECK(slot.Uninstall());
+
+        VtableShadowHook shadow;
+        CHECK(shadow.Install(&object, 1) && shadow.Hook(0, reinterpret_cast<void*>(Detour), &s_original));
+        CHECK(*Opaque(static_cast<void***>(static_cast<void*>(&object))) == shadow.Shadow());
+        CHECK(CallValue(&object, 1) == 2);
+        const double shadowed = CallNs(&object, calls);
+        CHECK(shadow.Uninstall());
+
+        std::printf("%-34s %10s\n", "call", "ns");
+        std::printf("%-34s %10.2f\n", "virtual call", direct);
+        std::printf("%-34s %10.2f\n", "patched slot -> original", patched);
+        std::printf("%-34s %10.2f\n", "shadow vtable -> original", shadowed);
+    }
+
+    void BenchInstall(int reps) {
+        Impl object;
+        void* table[1] = { *Opaque(VtableSlotHook::SlotOf(&object, 0)) };
+
+        double t0 = NowNs();
+        for (int i = 0; i < reps; i++) {
+            VtableSlotHook hook;
+            CHECK(hook.Install(&object, 0, reinterpret_cast<void*>(Detour), &s_original));
+            CHECK(hook.Uninstall());
+        }
+        double t1 = NowNs();
+        for (int i = 0; i < reps; i++) {
+            VtableSlotHook hook;
+            CHECK(hook.Install(&table[0], reinterpret_cast<void*>(Detour), &s_original));
+            CHECK(hook.Uninstall());
+        }
+        double t2 = NowNs();
+        for (int i = 0; i < reps; i++) {
+            VtableShadowHook hook;
+            CHECK(hook.Install(&object, 1) && hook.Hook(0, reinterpret_cast<void*>(Detour), &s_original));
+            CHECK(hook.Uninstall());
+        }
+        double t3 = NowNs();
+
+        std::printf("\n%-34s %10s\n", "install + uninstall", "us");
+        std::printf("%-34s %10.2f\n", "slot, read-only vtable", (t1 - t0) / reps / 1e3);
+        std::printf("%-34s %10.2f\n", "slot, writable table", (t2 - t1) / reps / 1e3);
+        std::printf("%-34s %10.2f\n", "shadow vtable", (t3 - t2) / reps / 1e3);
+    }
+}
+
+int main(int argc, char** argv) {
+    const bool quick = HasArg(argc, argv, "--quick");
+    BenchCalls(quick ? 200000 : 50000000);
+    BenchInstall(quick ? 50 : 5000);
+    return 0;
+}
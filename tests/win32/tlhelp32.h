@@ -0,0 +1,29 @@
+#pragma once
+
+// Thread snapshot for hook.c's Freeze(); see windows.h
+
+#include <windows.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define TH32CS_SNAPTHREAD 0x00000004
+
+typedef struct {
+    DWORD dwSize;
+    DWORD cntUsage;
+    DWORD th32ThreadID;
+    DWORD th32OwnerProcessID;
+    LONG tpBasePri;
+    LONG tpDeltaPri;
+    DWORD dwFlags;
+} THREADENTRY32;
+
+HANDLE CreateToolhelp32Snapshot(DWORD flags, DWORD processId);
+BOOL Thread32First(HANDLE snapshot, THREADENTRY32* entry);
+BOOL Thread32Next(HANDLE snapshot, THREADENTRY32* entry);
+
+#ifdef __cplusplus
+}
+#endif
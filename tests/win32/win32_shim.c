@@ -0,0 +1,261 @@
+// POSIX implementation of the Win32 subset declared in windows.h and
+// tlhelp32.h. The thread snapshot lists the process's real threads, so
+// MinHook pays for enumerating them as it does on Windows, but OpenThread
+// fails: Linux cannot suspend another thread, and tests only hook functions
+// that no other thread is executing.
+
+#define _GNU_SOURCE
+#include <windows.h>
+#include <tlhelp32.h>
+
+#include <dirent.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+static __thread DWORD t_lastError;
+
+LONG InterlockedCompareExchange(volatile LONG* target, LONG exchange, LONG comparand) {
+    __atomic_compare_exchange_n(target, &comparand, exchange, 0, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+    return comparand;
+}
+
+LONG InterlockedExchange(volatile LONG* target, LONG value) {
+    return __atomic_exchange_n(target, value, __ATOMIC_SEQ_CST);
+}
+
+LONG InterlockedIncrement(volatile LONG* target) {
+    return __atomic_add_fetch(target, 1, __ATOMIC_SEQ_CST);
+}
+
+LONG InterlockedDecrement(volatile LONG* target) {
+    return __atomic_sub_fetch(target, 1, __ATOMIC_SEQ_CST);
+}
+
+PVOID InterlockedCompareExchangePointer(PVOID volatile* target, PVOID exchange, PVOID comparand) {
+    __atomic_compare_exchange_n(target, &comparand, exchange, 0, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+    return comparand;
+}
+
+void YieldProcessor(void) {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#endif
+}
+
+void Sleep(DWORD milliseconds) {
+    usleep(milliseconds * 1000u);
+}
+
+// Handles start with their kind, so CloseHandle can free either
+enum { kEventHandle = 1, kSnapshotHandle = 2 };
+
+// Auto-reset events only, which is all hook.c creates
+typedef struct {
+    int kind;
+    pthread_mutex_t mutex;
+    pthread_cond_t cond;
+    int signaled;
+} Event;
+
+HANDLE CreateEventW(void* attributes, BOOL manualReset, BOOL initialState, LPCWSTR name) {
+    (void)attributes;
+    (void)manualReset;
+    (void)name;
+    Event* event = (Event*)calloc(1, sizeof(Event));
+    if (!event) return NULL;
+    event->kind = kEventHandle;
+    pthread_mutex_init(&event->mutex, NULL);
+    pthread_cond_init(&event->cond, NULL);
+    event->signaled = initialState;
+    return event;
+}
+
+BOOL SetEvent(HANDLE handle) {
+    Event* event = (Event*)handle;
+    pthread_mutex_lock(&event->mutex);
+    event->signaled = 1;
+    pthread_cond_signal(&event->cond);
+    pthread_mutex_unlock(&event->mutex);
+    return TRUE;
+}
+
+DWORD WaitForSingleObject(HANDLE handle, DWORD milliseconds) {
+    Event* event = (Event*)handle;
+    (void)milliseconds;
+    pthread_mutex_lock(&event->mutex);
+    while (!event->signaled) pthread_cond_wait(&event->cond, &event->mutex);
+    event->signaled = 0;
+    pthread_mutex_unlock(&event->mutex);
+    return 0;
+}
+
+// Thread snapshot: thread ids read from /proc/self/task
+typedef struct {
+    int kind;
+    DWORD* ids;
+    size_t count;
+    size_t next;
+} Snapshot;
+
+HANDLE CreateToolhelp32Snapshot(DWORD flags, DWORD processId) {
+    (void)flags;
+    (void)processId;
+    DIR* dir = opendir("/proc/self/task");
+    if (!dir) return INVALID_HANDLE_VALUE;
+    Snapshot* snapshot = (Snapshot*)calloc(1, sizeof(Snapshot));
+    if (snapshot) snapshot->kind = kSnapshotHandle;
+    size_t capacity = 0;
+    struct dirent* entry;
+    while (snapshot && (entry = readdir(dir)) != NULL) {
+        if (entry->d_name[0] < '0' || entry->d_name[0] > '9') continue;
+        if (snapshot->count == capacity) {
+            capacity = capacity ? capacity * 2 : 16;
+            DWORD* ids = (DWORD*)realloc(snapshot->ids, capacity * sizeof(DWORD));
+            if (!ids) break;
+            snapshot->ids = ids;
+        }
+        snapshot->ids[snapshot->count++] = (DWORD)strtoul(entry->d_name, NULL, 10);
+    }
+    closedir(dir);
+    return snapshot ? (HANDLE)snapshot : INVALID_HANDLE_VALUE;
+}
+
+BOOL Thread32Next(HANDLE handle, THREADENTRY32* entry) {
+    Snapshot* snapshot = (Snapshot*)handle;
+    if (snapshot->next >= snapshot->count) {
+        t_lastError = ERROR_NO_MORE_FILES;
+        return FALSE;
+    }
+    entry->th32ThreadID = snapshot->ids[snapshot->next++];
+    entry->th32OwnerProcessID = GetCurrentProcessId();
+    return TRUE;
+}
+
+BOOL Thread32First(HANDLE handle, THREADENTRY32* entry) {
+    ((Snapshot*)handle)->next = 0;
+    return Thread32Next(handle, entry);
+}
+
+BOOL CloseHandle(HANDLE handle) {
+    if (*(int*)handle == kEventHandle) {
+        Event* event = (Event*)handle;
+        pthread_cond_destroy(&event->cond);
+        pthread_mutex_destroy(&event->mutex);
+        free(event);
+    } else {
+        free(((Snapshot*)handle)->ids);
+        free(handle);
+    }
+    return TRUE;
+}
+
+// Heaps: the process heap, the handle is only a token
+HANDLE HeapCreate(DWORD options, SIZE_T initialSize, SIZE_T maximumSize) {
+    (void)options;
+    (void)initialSize;
+    (void)maximumSize;
+    static char heap;
+    return &heap;
+}
+
+BOOL HeapDestroy(HANDLE heap) {
+    (void)heap;
+    return TRUE;
+}
+
+LPVOID HeapAlloc(HANDLE heap, DWORD flags, SIZE_T bytes) {
+    (void)heap;
+    return (flags & HEAP_ZERO_MEMORY) ? calloc(1, bytes) : malloc(bytes);
+}
+
+LPVOID HeapReAlloc(HANDLE heap, DWORD flags, LPVOID memory, SIZE_T bytes) {
+    (void)heap;
+    (void)flags;
+    return realloc(memory, bytes);
+}
+
+BOOL HeapFree(HANDLE heap, DWORD flags, LPVOID memory) {
+    (void)heap;
+    (void)flags;
+    free(memory);
+    return TRUE;
+}
+
+HANDLE OpenThread(DWORD access, BOOL inherit, DWORD threadId) {
+    (void)access;
+    (void)inherit;
+    (void)threadId;
+    return NULL;
+}
+
+DWORD SuspendThread(HANDLE thread) {
+    (void)thread;
+    return 0xFFFFFFFF;
+}
+
+DWORD ResumeThread(HANDLE thread) {
+    (void)thread;
+    return 0xFFFFFFFF;
+}
+
+BOOL GetThreadContext(HANDLE thread, CONTEXT* context) {
+    (void)thread;
+    (void)context;
+    return FALSE;
+}
+
+BOOL SetThreadContext(HANDLE thread, const CONTEXT* context) {
+    (void)thread;
+    (void)context;
+    return FALSE;
+}
+
+HANDLE GetCurrentProcess(void) {
+    return (HANDLE)(intptr_t)-1;
+}
+
+DWORD GetCurrentProcessId(void) {
+    return (DWORD)getpid();
+}
+
+DWORD GetCurrentThreadId(void) {
+    return (DWORD)syscall(SYS_gettid);
+}
+
+DWORD GetLastError(void) {
+    return t_lastError;
+}
+
+// Hooked code is always code: report it as execute-read and restore that
+BOOL VirtualProtect(LPVOID address, SIZE_T size, DWORD newProtect, LPDWORD oldProtect) {
+    const uintptr_t page = (uintptr_t)sysconf(_SC_PAGESIZE);
+    uintptr_t start = (uintptr_t)address & ~(page - 1);
+    uintptr_t end = ((uintptr_t)address + size + page - 1) & ~(page - 1);
+    int prot = PROT_READ | PROT_EXEC;
+    if (newProtect == PAGE_EXECUTE_READWRITE || newProtect == PAGE_EXECUTE_WRITECOPY) prot |= PROT_WRITE;
+    if (mprotect((void*)start, end - start, prot) != 0) return FALSE;
+    *oldProtect = PAGE_EXECUTE_READ;
+    return TRUE;
+}
+
+BOOL FlushInstructionCache(HANDLE process, LPCVOID address, SIZE_T size) {
+    // x86 keeps instruction fetch coherent with stores
+    (void)process;
+    (void)address;
+    (void)size;
+    return TRUE;
+}
+
+HMODULE GetModuleHandleW(LPCWSTR name) {
+    (void)name;
+    return NULL;
+}
+
+void* GetProcAddress(HMODULE module, LPCSTR name) {
+    (void)module;
+    (void)name;
+    return NULL;
+}
@@ -0,0 +1,103 @@
+#pragma once
+
+// The few Win32 types and functions MinHook and HDE use, so hook.c,
+// trampoline.c and the HDE decoders build and run on Linux x86-64 for the
+// tests. Implemented in win32_shim.c on top of POSIX: heaps are malloc,
+// VirtualProtect is mprotect and threads are listed but never suspended
+// (tests hook functions no other thread is running). Test builds only.
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define WINAPI
+#define VOID void
+#define TRUE 1
+#define FALSE 0
+
+typedef int8_t INT8;
+typedef int16_t INT16;
+typedef int32_t INT32;
+typedef int64_t INT64;
+typedef uint8_t UINT8, BYTE, *LPBYTE;
+typedef uint16_t UINT16;
+typedef uint32_t UINT32, *PUINT32;
+typedef uint64_t UINT64, DWORD64;
+typedef unsigned int UINT;
+typedef uint32_t DWORD, *LPDWORD;
+typedef int32_t LONG;
+typedef int BOOL;
+typedef uintptr_t DWORD_PTR, ULONG_PTR, SIZE_T;
+typedef void *LPVOID, *PVOID, *HANDLE, *HMODULE;
+typedef const void* LPCVOID;
+typedef const wchar_t* LPCWSTR;
+typedef const char* LPCSTR;
+
+#define INFINITE 0xFFFFFFFF
+#define INVALID_HANDLE_VALUE ((HANDLE)(intptr_t)-1)
+#define ERROR_NO_MORE_FILES 18
+#define FIELD_OFFSET(type, field) offsetof(type, field)
+#define UNREFERENCED_PARAMETER(p) (void)(p)
+
+#define HEAP_ZERO_MEMORY 0x08
+
+#define PAGE_EXECUTE 0x10
+#define PAGE_EXECUTE_READ 0x20
+#define PAGE_EXECUTE_READWRITE 0x40
+#define PAGE_EXECUTE_WRITECOPY 0x80
+
+#define THREAD_SUSPEND_RESUME 0x0002
+#define THREAD_GET_CONTEXT 0x0008
+#define THREAD_SET_CONTEXT 0x0010
+#define THREAD_QUERY_INFORMATION 0x0040
+
+#define CONTEXT_CONTROL 0x1
+
+typedef struct {
+    DWORD ContextFlags;
+    DWORD64 Rip;
+} CONTEXT;
+
+LONG InterlockedCompareExchange(volatile LONG* target, LONG exchange, LONG comparand);
+LONG InterlockedExchange(volatile LONG* target, LONG value);
+LONG InterlockedIncrement(volatile LONG* target);
+LONG InterlockedDecrement(volatile LONG* target);
+PVOID InterlockedCompareExchangePointer(PVOID volatile* target, PVOID exchange, PVOID comparand);
+void YieldProcessor(void);
+void Sleep(DWORD milliseconds);
+
+HANDLE CreateEventW(void* attributes, BOOL manualReset, BOOL initialState, LPCWSTR name);
+BOOL SetEvent(HANDLE event);
+DWORD WaitForSingleObject(HANDLE handle, DWORD milliseconds);
+BOOL CloseHandle(HANDLE handle);
+
+HANDLE HeapCreate(DWORD options, SIZE_T initialSize, SIZE_T maximumSize);
+BOOL HeapDestroy(HANDLE heap);
+LPVOID HeapAlloc(HANDLE heap, DWORD flags, SIZE_T bytes);
+LPVOID HeapReAlloc(HANDLE heap, DWORD flags, LPVOID memory, SIZE_T bytes);
+BOOL HeapFree(HANDLE heap, DWORD flags, LPVOID memory);
+
+HANDLE OpenThread(DWORD access, BOOL inherit, DWORD threadId);
+DWORD SuspendThread(HANDLE thread);
+DWORD ResumeThread(HANDLE thread);
+BOOL GetThreadContext(HANDLE thread, CONTEXT* context);
+BOOL SetThreadContext(HANDLE thread, const CONTEXT* context);
+
+HANDLE GetCurrentProcess(void);
+DWORD GetCurrentProcessId(void);
+DWORD GetCurrentThreadId(void);
+DWORD GetLastError(void);
+
+BOOL VirtualProtect(LPVOID address, SIZE_T size, DWORD newProtect, LPDWORD oldProtect);
+BOOL FlushInstructionCache(HANDLE process, LPCVOID address, SIZE_T size);
+
+HMODULE GetModuleHandleW(LPCWSTR name);
+void* GetProcAddress(HMODULE module, LPCSTR name);
+
+#ifdef __cplusplus
+}
+#endif